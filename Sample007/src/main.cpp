@@ -15,9 +15,12 @@
 #include <sl12/mesh.h>
 #include <sl12/root_signature.h>
 #include <sl12/pipeline_state.h>
+#include <sl12/pipeline_state_cache.h>
+#include <sl12/pipeline_compiler.h>
 #include <sl12/file.h>
 #include <sl12/root_signature_manager.h>
 #include <sl12/render_resource_manager.h>
+#include <sl12/shader_reloader.h>
 
 #include <DirectXTex.h>
 #include <windowsx.h>
@@ -83,6 +86,8 @@ namespace
 	static const DXGI_FORMAT	kDepthViewFormat = DXGI_FORMAT_D32_FLOAT;
 	static const int kMaxFrameCount = sl12::Swapchain::kMaxBuffer;
 	static const int kMaxComputeCmdList = 10;
+	static const char* kRootSigCacheFile = "rootsig.cache";
+	static const char* kPipelineCacheFile = "pipeline.cache";
 
 	HWND	g_hWnd_;
 
@@ -98,6 +103,7 @@ namespace
 	ConstantSet				g_MeshCB_;
 	ConstantSet				g_BlurCB_;
 
+	sl12::StaticSamplerRegistry	g_staticSamplers_;
 	sl12::Sampler			g_sampler_;
 	sl12::Sampler			g_samLinearClamp_;
 
@@ -112,15 +118,19 @@ namespace
 	sl12::RootSignatureHandle	g_blurXPassSig_;
 	sl12::RootSignatureHandle	g_blurYPassSig_;
 
-	sl12::GraphicsPipelineState	g_basePassPso_;
-	sl12::GraphicsPipelineState	g_linearDepthPso_;
-	sl12::GraphicsPipelineState	g_lightingPso_;
-	sl12::GraphicsPipelineState	g_blurXPassPso_;
-	sl12::GraphicsPipelineState	g_blurYPassPso_;
+	sl12::PipelineStateCache	g_psoCache_;
+	sl12::PipelineCompiler		g_psoCompiler_;
+	sl12::PipelineStateHandle	g_basePassPso_;
+	sl12::PipelineStateHandle	g_linearDepthPso_;
+	sl12::PipelineStateHandle	g_lightingPso_;
+	sl12::PipelineStateHandle	g_blurXPassPso_;
+	sl12::PipelineStateHandle	g_blurYPassPso_;
 
 	sl12::RootSignature			g_rootSigMesh_;
 	sl12::GraphicsPipelineState	g_psoMesh_;
 
+	sl12::ShaderReloader		g_shaderReloader_;
+
 	sl12::File			g_meshFile_;
 	sl12::MeshInstance	g_mesh_;
 
@@ -217,6 +227,16 @@ void InitWindow(HINSTANCE hInstance, int nCmdShow)
 	ShowWindow(g_hWnd_, nCmdShow);
 }
 
+// シェーダをロードしてホットリロードの対象に登録する
+bool LoadShader(sl12::Shader& shader, sl12::ShaderType::Type type, const char* filename)
+{
+	if (!shader.Initialize(&g_Device_, type, filename))
+	{
+		return false;
+	}
+	return g_shaderReloader_.RegisterShader(&shader, filename);
+}
+
 bool InitializeAssets()
 {
 	ID3D12Device* pDev = g_Device_.GetDeviceDep();
@@ -304,14 +324,16 @@ bool InitializeAssets()
 		g_BlurCB_.cb_.Unmap();
 	}
 
-	// サンプラ作成
+	// サンプラ作成と登録
+	// ルートシグネチャ生成時に同名のサンプラは静的サンプラになる
+	// 静的サンプラにできずテーブルに残った場合のためにデスクリプタも作成しておく
 	{
 		D3D12_SAMPLER_DESC desc{};
 		desc.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
 		desc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
 		desc.AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
 		desc.AddressW = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-		if (!g_sampler_.Initialize(&g_Device_, desc))
+		if (!g_staticSamplers_.Register("samLinear", desc) || !g_sampler_.Initialize(&g_Device_, desc))
 		{
 			return false;
 		}
@@ -320,46 +342,51 @@ bool InitializeAssets()
 		desc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
 		desc.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
 		desc.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-		if (!g_samLinearClamp_.Initialize(&g_Device_, desc))
+		if (!g_staticSamplers_.Register("samLinearClamp", desc) || !g_samLinearClamp_.Initialize(&g_Device_, desc))
 		{
 			return false;
 		}
 	}
 
 	// シェーダロード
-	if (!g_VShader_.Initialize(&g_Device_, sl12::ShaderType::Vertex, "data/VSMesh.cso"))
+	// 変更を監視して再構築できるようにリローダに登録する
+	if (!g_shaderReloader_.Initialize(&g_Device_, &g_rootSigMan_, "data"))
 	{
 		return false;
 	}
-	if (!g_PShader_.Initialize(&g_Device_, sl12::ShaderType::Pixel, "data/PSMesh.cso"))
+	if (!LoadShader(g_VShader_, sl12::ShaderType::Vertex, "data/VSMesh.cso"))
 	{
 		return false;
 	}
-	if (!g_Shaders_[ShaderKind::BasePassV].Initialize(&g_Device_, sl12::ShaderType::Vertex, "data/base_pass.vv.cso"))
+	if (!LoadShader(g_PShader_, sl12::ShaderType::Pixel, "data/PSMesh.cso"))
 	{
 		return false;
 	}
-	if (!g_Shaders_[ShaderKind::BasePassP].Initialize(&g_Device_, sl12::ShaderType::Pixel, "data/base_pass.p.cso"))
+	if (!LoadShader(g_Shaders_[ShaderKind::BasePassV], sl12::ShaderType::Vertex, "data/base_pass.vv.cso"))
 	{
 		return false;
 	}
-	if (!g_Shaders_[ShaderKind::PostProcessV].Initialize(&g_Device_, sl12::ShaderType::Vertex, "data/post_process.vv.cso"))
+	if (!LoadShader(g_Shaders_[ShaderKind::BasePassP], sl12::ShaderType::Pixel, "data/base_pass.p.cso"))
 	{
 		return false;
 	}
-	if (!g_Shaders_[ShaderKind::LinearDepthP].Initialize(&g_Device_, sl12::ShaderType::Pixel, "data/linear_depth.p.cso"))
+	if (!LoadShader(g_Shaders_[ShaderKind::PostProcessV], sl12::ShaderType::Vertex, "data/post_process.vv.cso"))
 	{
 		return false;
 	}
-	if (!g_Shaders_[ShaderKind::LightingP].Initialize(&g_Device_, sl12::ShaderType::Pixel, "data/lighting.p.cso"))
+	if (!LoadShader(g_Shaders_[ShaderKind::LinearDepthP], sl12::ShaderType::Pixel, "data/linear_depth.p.cso"))
 	{
 		return false;
 	}
-	if (!g_Shaders_[ShaderKind::BlurXP].Initialize(&g_Device_, sl12::ShaderType::Pixel, "data/blur_x.p.cso"))
+	if (!LoadShader(g_Shaders_[ShaderKind::LightingP], sl12::ShaderType::Pixel, "data/lighting.p.cso"))
 	{
 		return false;
 	}
-	if (!g_Shaders_[ShaderKind::BlurYP].Initialize(&g_Device_, sl12::ShaderType::Pixel, "data/blur_y.p.cso"))
+	if (!LoadShader(g_Shaders_[ShaderKind::BlurXP], sl12::ShaderType::Pixel, "data/blur_x.p.cso"))
+	{
+		return false;
+	}
+	if (!LoadShader(g_Shaders_[ShaderKind::BlurYP], sl12::ShaderType::Pixel, "data/blur_y.p.cso"))
 	{
 		return false;
 	}
@@ -370,29 +397,71 @@ bool InitializeAssets()
 		return false;
 	}
 
+	// PSOキャッシュの初期化
+	if (!g_psoCache_.Initialize(&g_Device_))
+	{
+		return false;
+	}
+	if (!g_psoCompiler_.Initialize(&g_Device_, &g_psoCache_))
+	{
+		return false;
+	}
+
+	// 前回実行時のリフレクション結果を読み込む(読み込めない場合はリフレクションから生成する)
+	g_rootSigMan_.LoadCache(kRootSigCacheFile);
+	LARGE_INTEGER rsBegin, rsEnd, rsFreq;
+	QueryPerformanceCounter(&rsBegin);
+
 	// ルートシグネチャを生成
 	{
 		sl12::RootSignatureCreateDesc desc;
+		desc.pStaticSamplers = &g_staticSamplers_;
 
+		// メッシュ単位で更新する定数バッファはルートCBVとしてアドレスで設定する
 		desc.pVS = &g_Shaders_[ShaderKind::BasePassV];
 		desc.pPS = &g_Shaders_[ShaderKind::BasePassP];
+		desc.useRootCbv = true;
 		g_basePassSig_ = g_rootSigMan_.CreateRootSignature(desc);
+		g_shaderReloader_.RegisterRootSignature(&g_basePassSig_, desc);
+		desc.useRootCbv = false;
 
 		desc.pVS = &g_Shaders_[ShaderKind::PostProcessV];
 		desc.pPS = &g_Shaders_[ShaderKind::LinearDepthP];
 		g_linearDepthSig_ = g_rootSigMan_.CreateRootSignature(desc);
+		g_shaderReloader_.RegisterRootSignature(&g_linearDepthSig_, desc);
 
 		desc.pPS = &g_Shaders_[ShaderKind::LightingP];
 		g_lightingSig_ = g_rootSigMan_.CreateRootSignature(desc);
+		g_shaderReloader_.RegisterRootSignature(&g_lightingSig_, desc);
 
 		desc.pPS = &g_Shaders_[ShaderKind::BlurXP];
 		g_blurXPassSig_ = g_rootSigMan_.CreateRootSignature(desc);
+		g_shaderReloader_.RegisterRootSignature(&g_blurXPassSig_, desc);
 
 		desc.pPS = &g_Shaders_[ShaderKind::BlurYP];
 		g_blurYPassSig_ = g_rootSigMan_.CreateRootSignature(desc);
+		g_shaderReloader_.RegisterRootSignature(&g_blurYPassSig_, desc);
 	}
 
-	// PSOを生成
+	// 生成時間を出力してキャッシュを保存する
+	QueryPerformanceCounter(&rsEnd);
+	QueryPerformanceFrequency(&rsFreq);
+	{
+		auto&& cache = g_rootSigMan_.GetCache();
+		char text[256];
+		sprintf_s(text, "[Sample007] root signature creation : %.3f ms (cache hit %u, miss %u)\n",
+			(double)(rsEnd.QuadPart - rsBegin.QuadPart) * 1000.0 / (double)rsFreq.QuadPart, cache.GetHitCount(), cache.GetMissCount());
+		OutputDebugStringA(text);
+	}
+	g_rootSigMan_.SaveCache(kRootSigCacheFile);
+
+	// 前回実行時にコンパイルしたPSOを読み込む(アダプタやドライバが異なる場合は使用しない)
+	g_psoCache_.LoadCache(kPipelineCacheFile);
+	LARGE_INTEGER psoBegin, psoEnd;
+	QueryPerformanceCounter(&psoBegin);
+
+	// PSOをワーカースレッドでコンパイルする
+	std::shared_future<sl12::PipelineStateHandle> basePassPso, linearDepthPso, lightingPso, blurXPassPso, blurYPassPso;
 	{
 		sl12::GraphicsPipelineStateDesc desc;
 		desc.pRootSignature = g_basePassSig_.GetRootSignature();
@@ -428,10 +497,8 @@ bool InitializeAssets()
 		desc.dsvFormat = DXGI_FORMAT_D32_FLOAT;
 		desc.multisampleCount = 1;
 
-		if (!g_basePassPso_.Initialize(&g_Device_, desc))
-		{
-			return false;
-		}
+		basePassPso = g_psoCompiler_.CompileGraphics(desc);
+		g_shaderReloader_.RegisterPipelineState(&g_basePassPso_, &g_psoCache_, desc, &g_basePassSig_);
 	}
 	{
 		sl12::GraphicsPipelineStateDesc desc;
@@ -460,10 +527,8 @@ bool InitializeAssets()
 		desc.dsvFormat = DXGI_FORMAT_UNKNOWN;
 		desc.multisampleCount = 1;
 
-		if (!g_linearDepthPso_.Initialize(&g_Device_, desc))
-		{
-			return false;
-		}
+		linearDepthPso = g_psoCompiler_.CompileGraphics(desc);
+		g_shaderReloader_.RegisterPipelineState(&g_linearDepthPso_, &g_psoCache_, desc, &g_linearDepthSig_);
 	}
 	{
 		sl12::GraphicsPipelineStateDesc desc;
@@ -492,10 +557,8 @@ bool InitializeAssets()
 		desc.dsvFormat = DXGI_FORMAT_UNKNOWN;
 		desc.multisampleCount = 1;
 
-		if (!g_lightingPso_.Initialize(&g_Device_, desc))
-		{
-			return false;
-		}
+		lightingPso = g_psoCompiler_.CompileGraphics(desc);
+		g_shaderReloader_.RegisterPipelineState(&g_lightingPso_, &g_psoCache_, desc, &g_lightingSig_);
 	}
 	{
 		sl12::GraphicsPipelineStateDesc desc;
@@ -524,20 +587,39 @@ bool InitializeAssets()
 		desc.dsvFormat = DXGI_FORMAT_UNKNOWN;
 		desc.multisampleCount = 1;
 
-		if (!g_blurXPassPso_.Initialize(&g_Device_, desc))
-		{
-			return false;
-		}
+		blurXPassPso = g_psoCompiler_.CompileGraphics(desc);
+		g_shaderReloader_.RegisterPipelineState(&g_blurXPassPso_, &g_psoCache_, desc, &g_blurXPassSig_);
 
 		desc.pRootSignature = g_blurYPassSig_.GetRootSignature();
 		desc.pPS = &g_Shaders_[ShaderKind::BlurYP];
 		desc.rtvFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
-		if (!g_blurYPassPso_.Initialize(&g_Device_, desc))
-		{
-			return false;
-		}
+		blurYPassPso = g_psoCompiler_.CompileGraphics(desc);
+		g_shaderReloader_.RegisterPipelineState(&g_blurYPassPso_, &g_psoCache_, desc, &g_blurYPassSig_);
+	}
+
+	// 全てのPSOのコンパイル完了を待つ
+	g_psoCompiler_.WaitAll();
+	g_basePassPso_ = basePassPso.get();
+	g_linearDepthPso_ = linearDepthPso.get();
+	g_lightingPso_ = lightingPso.get();
+	g_blurXPassPso_ = blurXPassPso.get();
+	g_blurYPassPso_ = blurYPassPso.get();
+	if (g_psoCompiler_.GetFailedCount() > 0)
+	{
+		return false;
 	}
 
+	// 生成時間を出力してキャッシュを保存する
+	QueryPerformanceCounter(&psoEnd);
+	{
+		auto&& cache = g_psoCache_.GetBlobCache();
+		char text[256];
+		sprintf_s(text, "[Sample007] PSO creation : %.3f ms (pipeline cache hit %u, miss %u)\n",
+			(double)(psoEnd.QuadPart - psoBegin.QuadPart) * 1000.0 / (double)rsFreq.QuadPart, cache.GetHitCount(), cache.GetMissCount());
+		OutputDebugStringA(text);
+	}
+	g_psoCache_.SaveCache(kPipelineCacheFile);
+
 	// ルートシグネチャを作成
 	{
 		sl12::RootParameter params[] = {
@@ -592,6 +674,7 @@ bool InitializeAssets()
 		{
 			return false;
 		}
+		g_shaderReloader_.RegisterPipelineState(&g_psoMesh_, desc);
 	}
 
 	// メッシュロード
@@ -624,14 +707,19 @@ void DestroyAssets()
 	g_mesh_.Destroy();
 	g_meshFile_.Destroy();
 
+	// 差し替え待ちのオブジェクトを先に解放する
+	g_shaderReloader_.Destroy();
+
 	g_psoMesh_.Destroy();
 	g_rootSigMesh_.Destroy();
 
-	g_basePassPso_.Destroy();
-	g_linearDepthPso_.Destroy();
-	g_lightingPso_.Destroy();
-	g_blurXPassPso_.Destroy();
-	g_blurYPassPso_.Destroy();
+	g_basePassPso_.Invalid();
+	g_linearDepthPso_.Invalid();
+	g_lightingPso_.Invalid();
+	g_blurXPassPso_.Invalid();
+	g_blurYPassPso_.Invalid();
+	g_psoCompiler_.Destroy();
+	g_psoCache_.Destroy();
 
 	g_basePassSig_.Invalid();
 	g_linearDepthSig_.Invalid();
@@ -645,6 +733,7 @@ void DestroyAssets()
 
 	g_samLinearClamp_.Destroy();
 	g_sampler_.Destroy();
+	g_staticSamplers_.Clear();
 
 	g_BlurCB_.Destroy();
 	g_MeshCB_.Destroy();
@@ -719,8 +808,20 @@ void RenderScene()
 
 	g_Gui_.BeginNewFrame(&mainCmdList, kWindowWidth, kWindowHeight, g_InputData_);
 
+	// GUI
+	{
+		// 前回このコマンドリストに積んだステート設定の発行数と省略数
+		auto&& stats = mainCmdList.GetStateCacheStats();
+		ImGui::Text("State Issued : %d", stats.issued);
+		ImGui::Text("State Filtered : %d", stats.filtered);
+
+		// 同じ記述子のPSOは共有される
+		ImGui::Text("PSO : %u (hit %u, miss %u)", g_psoCache_.GetInstanceCount(), g_psoCache_.GetHitCount(), g_psoCache_.GetMissCount());
+	}
+
 	// グラフィクスコマンドロードの開始
 	mainCmdList.Reset();
+	mainCmdList.ResetStateCacheStats();
 
 	auto scTex = g_Device_.GetSwapchain().GetCurrentTexture(1);
 	D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = g_Device_.GetSwapchain().GetDescHandle(nextFrameIndex);
@@ -737,8 +838,8 @@ void RenderScene()
 	// Viewport + Scissor設定
 	D3D12_VIEWPORT viewport{ 0.0f, 0.0f, (float)kWindowWidth, (float)kWindowHeight, 0.0f, 1.0f };
 	D3D12_RECT scissor{ 0, 0, kWindowWidth, kWindowHeight };
-	pCmdList->RSSetViewports(1, &viewport);
-	pCmdList->RSSetScissorRects(1, &scissor);
+	mainCmdList.RSSetViewports(1, &viewport);
+	mainCmdList.RSSetScissorRects(1, &scissor);
 
 	// Scene定数バッファを更新
 	auto&& curCB = g_SceneCBs_[frameIndex];
@@ -805,22 +906,23 @@ void RenderScene()
 		pCmdList->ClearDepthStencilView(dsv, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
 
 		// レンダーターゲット設定
-		pCmdList->OMSetRenderTargets(_countof(rtvs), rtvs, false, &dsv);
+		mainCmdList.OMSetRenderTargets(_countof(rtvs), rtvs, false, &dsv);
 
 		// DescriptorHeapを設定
 		ID3D12DescriptorHeap* pDescHeaps[] = {
 			g_Device_.GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).GetHeap(),
 			g_Device_.GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER).GetHeap()
 		};
-		pCmdList->SetDescriptorHeaps(_countof(pDescHeaps), pDescHeaps);
+		mainCmdList.SetDescriptorHeaps(_countof(pDescHeaps), pDescHeaps);
 
 		// PSOとルートシグネチャを設定
-		pCmdList->SetPipelineState(g_basePassPso_.GetPSO());
-		pCmdList->SetGraphicsRootSignature(g_basePassSig_.GetRootSignature()->GetRootSignature());
+		mainCmdList.SetPipelineState(g_basePassPso_.GetPSO());
+		mainCmdList.SetGraphicsRootSignature(g_basePassSig_.GetRootSignature()->GetRootSignature());
 
 		// デスクリプタテーブル設定
 		g_basePassSig_.SetDescriptor(mainCmdList, "CbScene", curCB.cbv_);
 		g_basePassSig_.SetDescriptor(mainCmdList, "CbMesh", g_MeshCB_.cbv_);
+		g_basePassSig_.ApplyDescriptors(mainCmdList);
 
 		// DrawCall
 		auto submeshCount = g_mesh_.GetSubmeshCount();
@@ -833,9 +935,9 @@ void RenderScene()
 				info.pShape->GetNormalView()->GetView(),
 				info.pShape->GetTexcoordView()->GetView(),
 			};
-			pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-			pCmdList->IASetVertexBuffers(0, _countof(views), views);
-			pCmdList->IASetIndexBuffer(&info.pSubmesh->GetIndexBufferView()->GetView());
+			mainCmdList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+			mainCmdList.IASetVertexBuffers(0, _countof(views), views);
+			mainCmdList.IASetIndexBuffer(&info.pSubmesh->GetIndexBufferView()->GetView());
 			pCmdList->DrawIndexedInstanced(info.numIndices, 1, 0, 0, 0);
 		}
 	}
@@ -853,20 +955,21 @@ void RenderScene()
 		mainCmdList.TransitionBarrier(pOutput->GetTexture(), *thisProd->GetOutputPrevStates(), D3D12_RESOURCE_STATE_RENDER_TARGET);
 
 		// レンダーターゲット設定
-		pCmdList->OMSetRenderTargets(1, &rtv, false, nullptr);
+		mainCmdList.OMSetRenderTargets(1, &rtv, false, nullptr);
 
 		// PSOとルートシグネチャを設定
-		pCmdList->SetPipelineState(g_linearDepthPso_.GetPSO());
-		pCmdList->SetGraphicsRootSignature(g_linearDepthSig_.GetRootSignature()->GetRootSignature());
+		mainCmdList.SetPipelineState(g_linearDepthPso_.GetPSO());
+		mainCmdList.SetGraphicsRootSignature(g_linearDepthSig_.GetRootSignature()->GetRootSignature());
 
 		// デスクリプタテーブル設定
 		g_linearDepthSig_.SetDescriptor(mainCmdList, "CbScene", curCB.cbv_);
 		g_linearDepthSig_.SetDescriptor(mainCmdList, "texDepth", *pInput->GetSrv());
+		g_linearDepthSig_.ApplyDescriptors(mainCmdList);
 
 		// DrawCall
-		pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		pCmdList->IASetVertexBuffers(0, 0, nullptr);
-		pCmdList->IASetIndexBuffer(nullptr);
+		mainCmdList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		mainCmdList.IASetVertexBuffers(0, 0, nullptr);
+		mainCmdList.IASetIndexBuffer(nullptr);
 		pCmdList->DrawInstanced(3, 1, 0, 0);
 	}
 
@@ -893,11 +996,11 @@ void RenderScene()
 		mainCmdList.TransitionBarrier(pOutput->GetTexture(), outputPrevStates[0], D3D12_RESOURCE_STATE_RENDER_TARGET);
 
 		// レンダーターゲット設定
-		pCmdList->OMSetRenderTargets(1, &rtv, false, nullptr);
+		mainCmdList.OMSetRenderTargets(1, &rtv, false, nullptr);
 
 		// PSOとルートシグネチャを設定
-		pCmdList->SetPipelineState(g_lightingPso_.GetPSO());
-		pCmdList->SetGraphicsRootSignature(g_lightingSig_.GetRootSignature()->GetRootSignature());
+		mainCmdList.SetPipelineState(g_lightingPso_.GetPSO());
+		mainCmdList.SetGraphicsRootSignature(g_lightingSig_.GetRootSignature()->GetRootSignature());
 
 		// デスクリプタテーブル設定
 		g_lightingSig_.SetDescriptor(mainCmdList, "CbScene", curCB.cbv_);
@@ -905,11 +1008,12 @@ void RenderScene()
 		g_lightingSig_.SetDescriptor(mainCmdList, "texGBuffer1", *pInputs[1]->GetSrv());
 		g_lightingSig_.SetDescriptor(mainCmdList, "texGBuffer2", *pInputs[2]->GetSrv());
 		g_lightingSig_.SetDescriptor(mainCmdList, "texLinearDepth", *pInputs[3]->GetSrv());
+		g_lightingSig_.ApplyDescriptors(mainCmdList);
 
 		// DrawCall
-		pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		pCmdList->IASetVertexBuffers(0, 0, nullptr);
-		pCmdList->IASetIndexBuffer(nullptr);
+		mainCmdList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		mainCmdList.IASetVertexBuffers(0, 0, nullptr);
+		mainCmdList.IASetIndexBuffer(nullptr);
 		pCmdList->DrawInstanced(3, 1, 0, 0);
 	}
 
@@ -933,22 +1037,24 @@ void RenderScene()
 
 		//// X軸方向
 		// レンダーターゲット設定
-		pCmdList->OMSetRenderTargets(1, &tempRtv, false, nullptr);
+		mainCmdList.OMSetRenderTargets(1, &tempRtv, false, nullptr);
 
 		// PSOとルートシグネチャを設定
-		pCmdList->SetPipelineState(g_blurXPassPso_.GetPSO());
-		pCmdList->SetGraphicsRootSignature(g_blurXPassSig_.GetRootSignature()->GetRootSignature());
+		mainCmdList.SetPipelineState(g_blurXPassPso_.GetPSO());
+		mainCmdList.SetGraphicsRootSignature(g_blurXPassSig_.GetRootSignature()->GetRootSignature());
 
 		// デスクリプタテーブル設定
 		g_blurXPassSig_.SetDescriptor(mainCmdList, "CbGaussBlur", g_BlurCB_.cbv_);
 		g_blurXPassSig_.SetDescriptor(mainCmdList, "texSource", *pInputs[0]->GetSrv());
 		g_blurXPassSig_.SetDescriptor(mainCmdList, "texLinearDepth", *pInputs[1]->GetSrv());
+		// 静的サンプラになった場合は何もしない
 		g_blurXPassSig_.SetDescriptor(mainCmdList, "samLinearClamp", g_samLinearClamp_);
+		g_blurXPassSig_.ApplyDescriptors(mainCmdList);
 
 		// DrawCall
-		pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		pCmdList->IASetVertexBuffers(0, 0, nullptr);
-		pCmdList->IASetIndexBuffer(nullptr);
+		mainCmdList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		mainCmdList.IASetVertexBuffers(0, 0, nullptr);
+		mainCmdList.IASetIndexBuffer(nullptr);
 		pCmdList->DrawInstanced(3, 1, 0, 0);
 
 
@@ -957,22 +1063,24 @@ void RenderScene()
 		mainCmdList.TransitionBarrier(pTemp->GetTexture(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 
 		// レンダーターゲット設定
-		pCmdList->OMSetRenderTargets(1, &rtvHandle, false, nullptr);
+		mainCmdList.OMSetRenderTargets(1, &rtvHandle, false, nullptr);
 
 		// PSOとルートシグネチャを設定
-		pCmdList->SetPipelineState(g_blurYPassPso_.GetPSO());
-		pCmdList->SetGraphicsRootSignature(g_blurYPassSig_.GetRootSignature()->GetRootSignature());
+		mainCmdList.SetPipelineState(g_blurYPassPso_.GetPSO());
+		mainCmdList.SetGraphicsRootSignature(g_blurYPassSig_.GetRootSignature()->GetRootSignature());
 
 		// デスクリプタテーブル設定
 		g_blurYPassSig_.SetDescriptor(mainCmdList, "CbGaussBlur", g_BlurCB_.cbv_);
 		g_blurYPassSig_.SetDescriptor(mainCmdList, "texSource", *pTemp->GetSrv());
 		g_blurYPassSig_.SetDescriptor(mainCmdList, "texLinearDepth", *pInputs[1]->GetSrv());
+		// 静的サンプラになった場合は何もしない
 		g_blurYPassSig_.SetDescriptor(mainCmdList, "samLinearClamp", g_samLinearClamp_);
+		g_blurYPassSig_.ApplyDescriptors(mainCmdList);
 
 		// DrawCall
-		pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		pCmdList->IASetVertexBuffers(0, 0, nullptr);
-		pCmdList->IASetIndexBuffer(nullptr);
+		mainCmdList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		mainCmdList.IASetVertexBuffers(0, 0, nullptr);
+		mainCmdList.IASetIndexBuffer(nullptr);
 		pCmdList->DrawInstanced(3, 1, 0, 0);
 	}
 
@@ -988,13 +1096,20 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
 	InitWindow(hInstance, nCmdShow);
 
 	std::array<uint32_t, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> kDescNums
-	{ 100, 100, 20, 10 };
-	auto ret = g_Device_.Initialize(g_hWnd_, kWindowWidth, kWindowHeight, kDescNums);
+	{ 1124, 228, 20, 10 };
+	// ビューはステージング用ヒープに作成し、描画時にリングへテーブル単位でコピーする
+	std::array<sl12::DescriptorHeapLayout, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> kDescLayouts;
+	kDescLayouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].numTransients = 1024;
+	kDescLayouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].stageViews = true;
+	kDescLayouts[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER].numTransients = 128;
+	kDescLayouts[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER].stageViews = true;
+	auto ret = g_Device_.Initialize(g_hWnd_, kWindowWidth, kWindowHeight, kDescNums, kDescLayouts);
 	assert(ret);
 	for (auto& v : g_mainCmdLists_)
 	{
 		ret = v.Initialize(&g_Device_, &g_Device_.GetGraphicsQueue());
 		assert(ret);
+		v.EnableStateCache(true);
 	}
 	for (auto& v : g_computeCmdLists_)
 	{
@@ -1025,6 +1140,14 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
 
 		g_Device_.WaitPresent();
 
+		// 変更されたシェーダに依存するオブジェクトを差し替える
+		// 旧オブジェクトを参照するコマンドの完了を待ってから差し替える
+		if (g_shaderReloader_.Update())
+		{
+			g_Device_.WaitDrawDone();
+			g_shaderReloader_.Commit();
+		}
+
 		RenderScene();
 
 		// GPUによる描画待ち
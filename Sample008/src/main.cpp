@@ -11,6 +11,7 @@
 #include <sl12/buffer.h>
 #include <sl12/buffer_view.h>
 #include <sl12/shader.h>
+#include <sl12/shader_package.h>
 #include <sl12/gui.h>
 #include <sl12/mesh.h>
 #include <sl12/root_signature.h>
@@ -106,6 +107,31 @@ namespace
 		};
 	};	// struct ShaderKind
 
+	struct ShaderFile
+	{
+		int						kind;
+		sl12::ShaderType::Type	type;
+		const char*				filename;
+	};	// struct ShaderFile
+	static const ShaderFile kShaderFiles[] = {
+		{ ShaderKind::BasePassV, sl12::ShaderType::Vertex, "data/base_pass.vv.cso" },
+		{ ShaderKind::BasePassP, sl12::ShaderType::Pixel, "data/base_pass.p.cso" },
+		{ ShaderKind::PostProcessV, sl12::ShaderType::Vertex, "data/post_process.vv.cso" },
+		{ ShaderKind::LinearDepthP, sl12::ShaderType::Pixel, "data/linear_depth.p.cso" },
+		{ ShaderKind::LightingP, sl12::ShaderType::Pixel, "data/lighting.p.cso" },
+		{ ShaderKind::BlurXP, sl12::ShaderType::Pixel, "data/blur_x.p.cso" },
+		{ ShaderKind::BlurYP, sl12::ShaderType::Pixel, "data/blur_y.p.cso" },
+		{ ShaderKind::TiledLightC, sl12::ShaderType::Compute, "data/tile_lighting.c.cso" },
+		{ ShaderKind::ClearHashC, sl12::ShaderType::Compute, "data/clear_hash.c.cso" },
+		{ ShaderKind::ProjectHashC, sl12::ShaderType::Compute, "data/project_hash.c.cso" },
+		{ ShaderKind::ResolveHashP, sl12::ShaderType::Pixel, "data/resolve_hash.p.cso" },
+		{ ShaderKind::WaterV, sl12::ShaderType::Vertex, "data/water.vv.cso" },
+		{ ShaderKind::WaterP, sl12::ShaderType::Pixel, "data/water.p.cso" },
+		{ ShaderKind::ReprojectReflectionV, sl12::ShaderType::Vertex, "data/reproject_reflection.vv.cso" },
+		{ ShaderKind::ReprojectReflectionP, sl12::ShaderType::Pixel, "data/reproject_reflection.p.cso" },
+	};
+	static_assert(ARRAYSIZE(kShaderFiles) == ShaderKind::Max, "kShaderFiles must cover all ShaderKind.");
+
 	static const wchar_t* kWindowTitle = L"D3D12Sample";
 	static const int kWindowWidth = 1920;
 	static const int kWindowHeight = 1080;
@@ -114,6 +140,8 @@ namespace
 	static const DXGI_FORMAT	kDepthBufferFormat = DXGI_FORMAT_R32_TYPELESS;
 	static const DXGI_FORMAT	kDepthViewFormat = DXGI_FORMAT_D32_FLOAT;
 	static const int kMaxFrameCount = sl12::Swapchain::kMaxBuffer;
+	static const char* kRootSigCacheFile = "rootsig.cache";
+	static const char* kShaderPackageFile = "shaders.pack";
 	static const int kTileWidth = 16;
 	static const int kLightMax = 128;
 
@@ -132,6 +160,7 @@ namespace
 	ConstantSet				g_WaterCBs_[kMaxFrameCount];
 	TextureSet				g_WaveNormalTex_;
 
+	sl12::StaticSamplerRegistry	g_staticSamplers_;
 	sl12::Sampler			g_sampler_;
 	sl12::Sampler			g_samLinearClamp_;
 
@@ -221,6 +250,67 @@ bool LoadTexture(TextureSet* pTexSet, const char* filename)
 	return true;
 }
 
+// シェーダを読み込む
+// パッケージがあればパッケージから、なければ個別のファイルから読み込んで次回のためにパッケージを作成する
+// シェーダを更新した場合はパッケージを削除すること
+bool LoadShaders()
+{
+	LARGE_INTEGER begin, end, freq;
+	QueryPerformanceCounter(&begin);
+
+	bool isFromPackage = false;
+	{
+		sl12::ShaderPackage package;
+		if (package.Open(kShaderPackageFile))
+		{
+			// .csoがパッケージより新しい場合はパッケージを作り直す
+			isFromPackage = true;
+			for (auto&& f : kShaderFiles)
+			{
+				sl12::u32 index = package.Find(f.filename);
+				if (index == sl12::ShaderPackage::kInvalidIndex
+					|| !package.IsSourceUpToDate(index, f.filename)
+					|| !package.CreateShader(&g_Device_, index, g_Shaders_[f.kind]))
+				{
+					isFromPackage = false;
+					break;
+				}
+			}
+		}
+		// 生成したシェーダがマップしたメモリを保持するので、パッケージはここで閉じてよい
+	}
+
+	if (!isFromPackage)
+	{
+		sl12::ShaderPackageBuilder builder;
+		for (auto&& f : kShaderFiles)
+		{
+			// 読み込み中の更新を見逃さないよう、識別情報は読み込む前に取得する
+			sl12::ShaderSourceStamp stamp;
+			sl12::GetShaderSourceStamp(f.filename, stamp);
+
+			auto&& shader = g_Shaders_[f.kind];
+			if (!shader.Initialize(&g_Device_, f.type, f.filename))
+			{
+				return false;
+			}
+			builder.AddShader(f.filename, f.type, shader.GetData(), shader.GetSize());
+			builder.SetSourceStamp(f.filename, stamp);
+		}
+		builder.Save(kShaderPackageFile);
+	}
+
+	QueryPerformanceCounter(&end);
+	QueryPerformanceFrequency(&freq);
+	{
+		char text[256];
+		sprintf_s(text, "[Sample008] shader loading : %.3f ms (%s)\n",
+			(double)(end.QuadPart - begin.QuadPart) * 1000.0 / (double)freq.QuadPart, isFromPackage ? "package" : "loose files");
+		OutputDebugStringA(text);
+	}
+	return true;
+}
+
 // Window Proc
 LRESULT CALLBACK WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 {
@@ -458,14 +548,16 @@ bool InitializeAssets()
 		}
 	}
 
-	// サンプラ作成
+	// サンプラ作成と登録
+	// ルートシグネチャ生成時に同名のサンプラは静的サンプラになる
+	// 静的サンプラにできずテーブルに残った場合のためにデスクリプタも作成しておく
 	{
 		D3D12_SAMPLER_DESC desc{};
 		desc.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
 		desc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
 		desc.AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
 		desc.AddressW = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-		if (!g_sampler_.Initialize(&g_Device_, desc))
+		if (!g_staticSamplers_.Register("samLinear", desc) || !g_sampler_.Initialize(&g_Device_, desc))
 		{
 			return false;
 		}
@@ -474,7 +566,7 @@ bool InitializeAssets()
 		desc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
 		desc.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
 		desc.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-		if (!g_samLinearClamp_.Initialize(&g_Device_, desc))
+		if (!g_staticSamplers_.Register("samLinearClamp", desc) || !g_samLinearClamp_.Initialize(&g_Device_, desc))
 		{
 			return false;
 		}
@@ -487,63 +579,7 @@ bool InitializeAssets()
 	}
 
 	// シェーダロード
-	if (!g_Shaders_[ShaderKind::BasePassV].Initialize(&g_Device_, sl12::ShaderType::Vertex, "data/base_pass.vv.cso"))
-	{
-		return false;
-	}
-	if (!g_Shaders_[ShaderKind::BasePassP].Initialize(&g_Device_, sl12::ShaderType::Pixel, "data/base_pass.p.cso"))
-	{
-		return false;
-	}
-	if (!g_Shaders_[ShaderKind::PostProcessV].Initialize(&g_Device_, sl12::ShaderType::Vertex, "data/post_process.vv.cso"))
-	{
-		return false;
-	}
-	if (!g_Shaders_[ShaderKind::LinearDepthP].Initialize(&g_Device_, sl12::ShaderType::Pixel, "data/linear_depth.p.cso"))
-	{
-		return false;
-	}
-	if (!g_Shaders_[ShaderKind::LightingP].Initialize(&g_Device_, sl12::ShaderType::Pixel, "data/lighting.p.cso"))
-	{
-		return false;
-	}
-	if (!g_Shaders_[ShaderKind::BlurXP].Initialize(&g_Device_, sl12::ShaderType::Pixel, "data/blur_x.p.cso"))
-	{
-		return false;
-	}
-	if (!g_Shaders_[ShaderKind::BlurYP].Initialize(&g_Device_, sl12::ShaderType::Pixel, "data/blur_y.p.cso"))
-	{
-		return false;
-	}
-	if (!g_Shaders_[ShaderKind::TiledLightC].Initialize(&g_Device_, sl12::ShaderType::Compute, "data/tile_lighting.c.cso"))
-	{
-		return false;
-	}
-	if (!g_Shaders_[ShaderKind::ClearHashC].Initialize(&g_Device_, sl12::ShaderType::Compute, "data/clear_hash.c.cso"))
-	{
-		return false;
-	}
-	if (!g_Shaders_[ShaderKind::ProjectHashC].Initialize(&g_Device_, sl12::ShaderType::Compute, "data/project_hash.c.cso"))
-	{
-		return false;
-	}
-	if (!g_Shaders_[ShaderKind::ResolveHashP].Initialize(&g_Device_, sl12::ShaderType::Pixel, "data/resolve_hash.p.cso"))
-	{
-		return false;
-	}
-	if (!g_Shaders_[ShaderKind::WaterV].Initialize(&g_Device_, sl12::ShaderType::Vertex, "data/water.vv.cso"))
-	{
-		return false;
-	}
-	if (!g_Shaders_[ShaderKind::WaterP].Initialize(&g_Device_, sl12::ShaderType::Pixel, "data/water.p.cso"))
-	{
-		return false;
-	}
-	if (!g_Shaders_[ShaderKind::ReprojectReflectionV].Initialize(&g_Device_, sl12::ShaderType::Vertex, "data/reproject_reflection.vv.cso"))
-	{
-		return false;
-	}
-	if (!g_Shaders_[ShaderKind::ReprojectReflectionP].Initialize(&g_Device_, sl12::ShaderType::Pixel, "data/reproject_reflection.p.cso"))
+	if (!LoadShaders())
 	{
 		return false;
 	}
@@ -554,9 +590,15 @@ bool InitializeAssets()
 		return false;
 	}
 
+	// 前回実行時のリフレクション結果を読み込む(読み込めない場合はリフレクションから生成する)
+	g_rootSigMan_.LoadCache(kRootSigCacheFile);
+	LARGE_INTEGER rsBegin, rsEnd, rsFreq;
+	QueryPerformanceCounter(&rsBegin);
+
 	// ルートシグネチャを生成
 	{
 		sl12::RootSignatureCreateDesc desc;
+		desc.pStaticSamplers = &g_staticSamplers_;
 
 		desc.pVS = &g_Shaders_[ShaderKind::BasePassV];
 		desc.pPS = &g_Shaders_[ShaderKind::BasePassP];
@@ -588,6 +630,7 @@ bool InitializeAssets()
 	}
 	{
 		sl12::RootSignatureCreateDesc desc;
+		desc.pStaticSamplers = &g_staticSamplers_;
 
 		desc.pCS = &g_Shaders_[ShaderKind::TiledLightC];
 		g_tiledLightSig_ = g_rootSigMan_.CreateRootSignature(desc);
@@ -599,6 +642,18 @@ bool InitializeAssets()
 		g_projectHashSig_ = g_rootSigMan_.CreateRootSignature(desc);
 	}
 
+	// 生成時間を出力してキャッシュを保存する
+	QueryPerformanceCounter(&rsEnd);
+	QueryPerformanceFrequency(&rsFreq);
+	{
+		auto&& cache = g_rootSigMan_.GetCache();
+		char text[256];
+		sprintf_s(text, "[Sample008] root signature creation : %.3f ms (cache hit %u, miss %u)\n",
+			(double)(rsEnd.QuadPart - rsBegin.QuadPart) * 1000.0 / (double)rsFreq.QuadPart, cache.GetHitCount(), cache.GetMissCount());
+		OutputDebugStringA(text);
+	}
+	g_rootSigMan_.SaveCache(kRootSigCacheFile);
+
 	// PSOを生成
 	{
 		sl12::GraphicsPipelineStateDesc desc;
@@ -952,6 +1007,7 @@ void DestroyAssets()
 
 	g_samLinearClamp_.Destroy();
 	g_sampler_.Destroy();
+	g_staticSamplers_.Clear();
 
 	for (auto&& v : g_Shaders_) v.Destroy();
 	g_WaveNormalTex_.Destroy();
@@ -1209,6 +1265,7 @@ void RenderScene()
 		// デスクリプタテーブル設定
 		g_basePassSig_.SetDescriptor(mainCmdList, "CbScene", curCB.cbv_);
 		g_basePassSig_.SetDescriptor(mainCmdList, "CbMesh", g_MeshCB_.cbv_);
+		g_basePassSig_.ApplyDescriptors(mainCmdList);
 
 		// DrawCall
 		auto submeshCount = g_mesh_.GetSubmeshCount();
@@ -1249,6 +1306,7 @@ void RenderScene()
 		// デスクリプタテーブル設定
 		g_linearDepthSig_.SetDescriptor(mainCmdList, "CbScene", curCB.cbv_);
 		g_linearDepthSig_.SetDescriptor(mainCmdList, "texDepth", *pInput->GetSrv());
+		g_linearDepthSig_.ApplyDescriptors(mainCmdList);
 
 		// DrawCall
 		pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -1285,6 +1343,7 @@ void RenderScene()
 		g_tiledLightSig_.SetDescriptor(mainCmdList, "rLightPosBuffer", curLightPosBV);
 		g_tiledLightSig_.SetDescriptor(mainCmdList, "rLightColorBuffer", g_LightColorBV_);
 		g_tiledLightSig_.SetDescriptor(mainCmdList, "rwFinal", *pOutput->GetUav(0));
+		g_tiledLightSig_.ApplyDescriptors(mainCmdList);
 
 		// DrawCall
 		pCmdList->Dispatch(kWindowWidth / kTileWidth, kWindowHeight / kTileWidth, 1);
@@ -1308,6 +1367,7 @@ void RenderScene()
 			// デスクリプタテーブル設定
 			g_clearHashSig_.SetDescriptor(mainCmdList, "CbScene", curCB.cbv_);
 			g_clearHashSig_.SetDescriptor(mainCmdList, "rwProjectHash", *pOutput->GetUav());
+			g_clearHashSig_.ApplyDescriptors(mainCmdList);
 
 			// DrawCall
 			pCmdList->Dispatch(kWindowWidth / kTileWidth, kWindowHeight / kTileWidth, 1);
@@ -1324,6 +1384,7 @@ void RenderScene()
 			g_projectHashSig_.SetDescriptor(mainCmdList, "CbWaterInfo", curWaterCB.cbv_);
 			g_projectHashSig_.SetDescriptor(mainCmdList, "texLinearDepth", *pInput->GetSrv());
 			g_projectHashSig_.SetDescriptor(mainCmdList, "rwProjectHash", *pOutput->GetUav());
+			g_projectHashSig_.ApplyDescriptors(mainCmdList);
 
 			// DrawCall
 			pCmdList->Dispatch(kWindowWidth / kTileWidth, kWindowHeight / kTileWidth, 1);
@@ -1359,6 +1420,7 @@ void RenderScene()
 		g_resolveHashSig_.SetDescriptor(mainCmdList, "CbWaterInfo", curWaterCB.cbv_);
 		g_resolveHashSig_.SetDescriptor(mainCmdList, "texSceneColor", *pInputs[0]->GetSrv());
 		g_resolveHashSig_.SetDescriptor(mainCmdList, "texProjectHash", *pInputs[1]->GetSrv());
+		g_resolveHashSig_.ApplyDescriptors(mainCmdList);
 
 		// DrawCall
 		pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -1393,6 +1455,7 @@ void RenderScene()
 		g_reprojectSig_.SetDescriptor(mainCmdList, "CbWaterInfo", curWaterCB.cbv_);
 		g_reprojectSig_.SetDescriptor(mainCmdList, "texPrevReflection", *pInputs[0]->GetSrv());
 		g_reprojectSig_.SetDescriptor(mainCmdList, "texProjectHash", *pInputs[1]->GetSrv());
+		g_reprojectSig_.ApplyDescriptors(mainCmdList);
 
 		// DrawCall
 		auto vb = g_WaterVBV_.GetView();
@@ -1430,7 +1493,9 @@ void RenderScene()
 		g_waterSig_.SetDescriptor(mainCmdList, "CbWaterInfo", curWaterCB.cbv_);
 		g_waterSig_.SetDescriptor(mainCmdList, "texSSPR", *pInput->GetSrv());
 		g_waterSig_.SetDescriptor(mainCmdList, "texNormal", g_WaveNormalTex_.srv_);
+		// 静的サンプラになった場合は何もしない
 		g_waterSig_.SetDescriptor(mainCmdList, "samLinear", g_sampler_);
+		g_waterSig_.ApplyDescriptors(mainCmdList);
 
 		// DrawCall
 		auto vb = g_WaterVBV_.GetView();
@@ -1469,7 +1534,9 @@ void RenderScene()
 		g_blurXPassSig_.SetDescriptor(mainCmdList, "CbGaussBlur", g_BlurCB_.cbv_);
 		g_blurXPassSig_.SetDescriptor(mainCmdList, "texSource", *pInputs[0]->GetSrv());
 		g_blurXPassSig_.SetDescriptor(mainCmdList, "texLinearDepth", *pInputs[1]->GetSrv());
+		// 静的サンプラになった場合は何もしない
 		g_blurXPassSig_.SetDescriptor(mainCmdList, "samLinearClamp", g_samLinearClamp_);
+		g_blurXPassSig_.ApplyDescriptors(mainCmdList);
 
 		// DrawCall
 		pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -1497,7 +1564,9 @@ void RenderScene()
 		g_blurYPassSig_.SetDescriptor(mainCmdList, "CbGaussBlur", g_BlurCB_.cbv_);
 		g_blurYPassSig_.SetDescriptor(mainCmdList, "texSource", *pTemp->GetSrv());
 		g_blurYPassSig_.SetDescriptor(mainCmdList, "texLinearDepth", *pInputs[1]->GetSrv());
+		// 静的サンプラになった場合は何もしない
 		g_blurYPassSig_.SetDescriptor(mainCmdList, "samLinearClamp", g_samLinearClamp_);
+		g_blurYPassSig_.ApplyDescriptors(mainCmdList);
 
 		// DrawCall
 		pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -1518,8 +1587,14 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
 	InitWindow(hInstance, nCmdShow);
 
 	std::array<uint32_t, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> kDescNums
-	{ 100, 100, 20, 10 };
-	auto ret = g_Device_.Initialize(g_hWnd_, kWindowWidth, kWindowHeight, kDescNums);
+	{ 1124, 228, 20, 10 };
+	// ビューはステージング用ヒープに作成し、描画時にリングへテーブル単位でコピーする
+	std::array<sl12::DescriptorHeapLayout, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> kDescLayouts;
+	kDescLayouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].numTransients = 1024;
+	kDescLayouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].stageViews = true;
+	kDescLayouts[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER].numTransients = 128;
+	kDescLayouts[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER].stageViews = true;
+	auto ret = g_Device_.Initialize(g_hWnd_, kWindowWidth, kWindowHeight, kDescNums, kDescLayouts);
 	assert(ret);
 	for (auto& v : g_mainCmdLists_)
 	{
@@ -13,6 +13,7 @@
 #include "sl12/swapchain.h"
 #include "sl12/pipeline_state.h"
 #include "sl12/acceleration_structure.h"
+#include "sl12/shader_table.h"
 #include "sl12/file.h"
 
 #include "CompiledShaders/test.lib.hlsl.h"
@@ -225,14 +226,7 @@ public:
 
 		// Cg[Xs
 		D3D12_DISPATCH_RAYS_DESC desc{};
-		desc.HitGroupTable.StartAddress = hitGroupTable_.GetResourceDep()->GetGPUVirtualAddress();
-		desc.HitGroupTable.SizeInBytes = hitGroupTable_.GetSize();
-		desc.HitGroupTable.StrideInBytes = desc.HitGroupTable.SizeInBytes;
-		desc.MissShaderTable.StartAddress = missTable_.GetResourceDep()->GetGPUVirtualAddress();
-		desc.MissShaderTable.SizeInBytes = missTable_.GetSize();
-		desc.MissShaderTable.StrideInBytes = desc.MissShaderTable.SizeInBytes;
-		desc.RayGenerationShaderRecord.StartAddress = rayGenTable_.GetResourceDep()->GetGPUVirtualAddress();
-		desc.RayGenerationShaderRecord.SizeInBytes = rayGenTable_.GetSize();
+		shaderTable_.FillDispatchRaysDesc(shaderTableBuffer_.GetResourceDep()->GetGPUVirtualAddress(), desc);
 		desc.Width = kScreenWidth;
 		desc.Height = kScreenHeight;
 		desc.Depth = 1;
@@ -263,9 +257,8 @@ public:
 
 	void Finalize() override
 	{
-		rayGenTable_.Destroy();
-		missTable_.Destroy();
-		hitGroupTable_.Destroy();
+		shaderTableBuffer_.Destroy();
+		shaderTable_.Destroy();
 
 		for (auto&& v : sceneCBVs_) v.Destroy();
 		for (auto&& v : sceneCBs_) v.Destroy();
@@ -618,54 +611,34 @@ private:
 			prop->Release();
 		}
 
-		UINT shaderIdentifierSize = D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES;
-
-		auto Align = [](UINT size, UINT align)
+		// VF[_R[h̓VF[_IDƃ[J[gVOl`ɐݒ肳ϐ̑gݍ킹ō\Ă܂.
+		// R[hTCYACgShaderTablevZASẴVF[_e[u1̃obt@ɂ܂Ƃ߂܂.
+		// {Tvłׂ͂ẴVF[_R[hɃfBXNv^nh4ݒ肵܂.
+		const sl12::u32 kLocalArgSize = sizeof(D3D12_GPU_DESCRIPTOR_HANDLE) * 4;
+		shaderTable_.AddRecord(sl12::ShaderTableKind::RayGeneration, kLocalArgSize);
+		shaderTable_.AddRecord(sl12::ShaderTableKind::Miss, kLocalArgSize);
+		shaderTable_.AddRecord(sl12::ShaderTableKind::HitGroup, kLocalArgSize);
+		if (!shaderTable_.Build())
 		{
-			return ((size + align - 1) / align) * align;
-		};
-
-		// VF[_R[hTCY
-		// VF[_R[h̓VF[_e[u̗vf1ł.
-		// ̓VF[_IDƃ[J[gVOl`ɐݒ肳ϐ̑gݍ킹ō\Ă܂.
-		// VF[_R[h̃TCY̓VF[_e[uœłȂ΂ȂȂ߁AVF[_e[uōő̃R[hTCYw肷ׂł.
-		// {Tvłׂ͂ẴVF[_R[hɂăTCYƂȂ܂.
-		UINT descHandleOffset = Align(shaderIdentifierSize, sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
-		UINT shaderRecordSize = Align(descHandleOffset + sizeof(D3D12_GPU_DESCRIPTOR_HANDLE) * 4, D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT);
+			return false;
+		}
 
-		auto GenShaderTable = [&](void* shaderId, sl12::Buffer& buffer)
+		D3D12_GPU_DESCRIPTOR_HANDLE handles[] = {
+			imageTextureView_.GetDesc()->GetGpuHandle(),
+			geometryUVBV_.GetDesc()->GetGpuHandle(),
+			geometryIBV_.GetDesc()->GetGpuHandle(),
+			imageSampler_.GetDesc()->GetGpuHandle(),
+		};
+		auto SetRecord = [&](sl12::ShaderTableKind::Type kind, void* shaderId)
 		{
-			if (!buffer.Initialize(&device_, shaderRecordSize, 0, sl12::BufferUsage::ShaderResource, D3D12_RESOURCE_STATE_GENERIC_READ, true, false))
-			{
-				return false;
-			}
-
-			auto p = reinterpret_cast<char*>(buffer.Map(nullptr));
-			memcpy(p, shaderId, shaderIdentifierSize);
-			p += descHandleOffset;
-
-			auto texHandle = imageTextureView_.GetDesc()->GetGpuHandle();
-			auto uvHandle = geometryUVBV_.GetDesc()->GetGpuHandle();
-			auto indexHandle = geometryIBV_.GetDesc()->GetGpuHandle();
-			auto samHandle = imageSampler_.GetDesc()->GetGpuHandle();
-			memcpy(p, &texHandle, sizeof(texHandle)); p += sizeof(texHandle);
-			memcpy(p, &uvHandle, sizeof(uvHandle)); p += sizeof(uvHandle);
-			memcpy(p, &indexHandle, sizeof(indexHandle)); p += sizeof(indexHandle);
-			memcpy(p, &samHandle, sizeof(samHandle)); p += sizeof(samHandle);
-			buffer.Unmap();
-
-			return true;
+			shaderTable_.SetShaderIdentifier(kind, 0, shaderId);
+			shaderTable_.SetLocalArguments(kind, 0, handles, sizeof(handles));
 		};
+		SetRecord(sl12::ShaderTableKind::RayGeneration, rayGenShaderIdentifier);
+		SetRecord(sl12::ShaderTableKind::Miss, missShaderIdentifier);
+		SetRecord(sl12::ShaderTableKind::HitGroup, hitGroupShaderIdentifier);
 
-		if (!GenShaderTable(rayGenShaderIdentifier, rayGenTable_))
-		{
-			return false;
-		}
-		if (!GenShaderTable(missShaderIdentifier, missTable_))
-		{
-			return false;
-		}
-		if (!GenShaderTable(hitGroupShaderIdentifier, hitGroupTable_))
+		if (!shaderTable_.CreateBuffer(&device_, shaderTableBuffer_))
 		{
 			return false;
 		}
@@ -724,7 +697,8 @@ private:
 	sl12::Buffer				sceneCBs_[kBufferCount];
 	sl12::ConstantBufferView	sceneCBVs_[kBufferCount];
 
-	sl12::Buffer			rayGenTable_, missTable_, hitGroupTable_;
+	sl12::ShaderTable		shaderTable_;
+	sl12::Buffer			shaderTableBuffer_;
 
 	DirectX::XMFLOAT4		camPos_ = { 5.0f, 5.0f, -5.0f, 1.0f };
 	DirectX::XMFLOAT4		tgtPos_ = { 0.0f, 0.0f, 0.0f, 1.0f };
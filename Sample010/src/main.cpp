@@ -14,6 +14,7 @@
 #include "sl12/swapchain.h"
 #include "sl12/pipeline_state.h"
 #include "sl12/acceleration_structure.h"
+#include "sl12/shader_table.h"
 #include "sl12/file.h"
 #include "sl12/shader.h"
 #include "sl12/gui.h"
@@ -166,11 +167,11 @@ public:
 			return false;
 		}
 		{
-			if (!copyVS_.Initialize(&device_, sl12::ShaderType::Vertex, g_pCopyVS, sizeof(g_pCopyVS)))
+			if (!copyVS_.InitializeReference(&device_, sl12::ShaderType::Vertex, g_pCopyVS, sizeof(g_pCopyVS)))
 			{
 				return false;
 			}
-			if (!copyPS_.Initialize(&device_, sl12::ShaderType::Pixel, g_pCopyPS, sizeof(g_pCopyPS)))
+			if (!copyPS_.InitializeReference(&device_, sl12::ShaderType::Pixel, g_pCopyPS, sizeof(g_pCopyPS)))
 			{
 				return false;
 			}
@@ -375,14 +376,7 @@ public:
 
 			// Cg[Xs
 			D3D12_DISPATCH_RAYS_DESC desc{};
-			desc.HitGroupTable.StartAddress = hitGroupTable_.GetResourceDep()->GetGPUVirtualAddress();
-			desc.HitGroupTable.SizeInBytes = hitGroupTable_.GetSize();
-			desc.HitGroupTable.StrideInBytes = desc.HitGroupTable.SizeInBytes;
-			desc.MissShaderTable.StartAddress = missTable_.GetResourceDep()->GetGPUVirtualAddress();
-			desc.MissShaderTable.SizeInBytes = missTable_.GetSize();
-			desc.MissShaderTable.StrideInBytes = desc.MissShaderTable.SizeInBytes;
-			desc.RayGenerationShaderRecord.StartAddress = rayGenTable_.GetResourceDep()->GetGPUVirtualAddress();
-			desc.RayGenerationShaderRecord.SizeInBytes = rayGenTable_.GetSize();
+			shaderTable_.FillDispatchRaysDesc(shaderTableBuffer_.GetResourceDep()->GetGPUVirtualAddress(), desc);
 			desc.Width = kScreenWidth;
 			desc.Height = kScreenHeight;
 			desc.Depth = 1;
@@ -447,9 +441,8 @@ public:
 
 	void Finalize() override
 	{
-		rayGenTable_.Destroy();
-		missTable_.Destroy();
-		hitGroupTable_.Destroy();
+		shaderTableBuffer_.Destroy();
+		shaderTable_.Destroy();
 
 		for (auto&& v : sceneCBVs_) v.Destroy();
 		for (auto&& v : sceneCBs_) v.Destroy();
@@ -818,43 +811,22 @@ private:
 			prop->Release();
 		}
 
-		UINT shaderIdentifierSize = D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES;
-
-		auto Align = [](UINT size, UINT align)
-		{
-			return ((size + align - 1) / align) * align;
-		};
-
-		// VF[_R[hTCY
-		// VF[_R[h̓VF[_e[u̗vf1ł.
-		// ̓VF[_IDƃ[J[gVOl`ɐݒ肳ϐ̑gݍ킹ō\Ă܂.
-		// VF[_R[h̃TCY̓VF[_e[uœłȂ΂ȂȂ߁AVF[_e[uōő̃R[hTCYw肷ׂł.
-		// {Tvłׂ͂ẴVF[_R[hɂăTCYƂȂ܂.
-		UINT shaderRecordSize = Align(shaderIdentifierSize, D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT);
-
-		auto GenShaderTable = [&](void* shaderId, sl12::Buffer& buffer)
-		{
-			if (!buffer.Initialize(&device_, shaderRecordSize, 0, sl12::BufferUsage::ShaderResource, D3D12_RESOURCE_STATE_GENERIC_READ, true, false))
-			{
-				return false;
-			}
-
-			auto p = reinterpret_cast<char*>(buffer.Map(nullptr));
-			memcpy(p, shaderId, shaderIdentifierSize);
-			buffer.Unmap();
-
-			return true;
-		};
-
-		if (!GenShaderTable(rayGenShaderIdentifier, rayGenTable_))
+		// VF[_R[h̓VF[_IDƃ[J[gVOl`ɐݒ肳ϐ̑gݍ킹ō\Ă܂.
+		// R[hTCYACgShaderTablevZASẴVF[_e[u1̃obt@ɂ܂Ƃ߂܂.
+		// {Tvł̓[J[gVOl`gpȂ߁AVF[_R[h̓VF[_ID݂̂ƂȂ܂.
+		shaderTable_.AddRecord(sl12::ShaderTableKind::RayGeneration);
+		shaderTable_.AddRecord(sl12::ShaderTableKind::Miss);
+		shaderTable_.AddRecord(sl12::ShaderTableKind::HitGroup);
+		if (!shaderTable_.Build())
 		{
 			return false;
 		}
-		if (!GenShaderTable(missShaderIdentifier, missTable_))
-		{
-			return false;
-		}
-		if (!GenShaderTable(hitGroupShaderIdentifier, hitGroupTable_))
+
+		shaderTable_.SetShaderIdentifier(sl12::ShaderTableKind::RayGeneration, 0, rayGenShaderIdentifier);
+		shaderTable_.SetShaderIdentifier(sl12::ShaderTableKind::Miss, 0, missShaderIdentifier);
+		shaderTable_.SetShaderIdentifier(sl12::ShaderTableKind::HitGroup, 0, hitGroupShaderIdentifier);
+
+		if (!shaderTable_.CreateBuffer(&device_, shaderTableBuffer_))
 		{
 			return false;
 		}
@@ -913,7 +885,8 @@ private:
 	sl12::Buffer				sceneCBs_[kBufferCount];
 	sl12::ConstantBufferView	sceneCBVs_[kBufferCount];
 
-	sl12::Buffer			rayGenTable_, missTable_, hitGroupTable_;
+	sl12::ShaderTable		shaderTable_;
+	sl12::Buffer			shaderTableBuffer_;
 
 	std::vector<Sphere>		spheres_;
 	sl12::Buffer			spheresAABB_;
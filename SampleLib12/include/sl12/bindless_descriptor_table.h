@@ -0,0 +1,92 @@
+﻿#pragma once
+
+#include <sl12/util.h>
+#include <sl12/descriptor_heap.h>
+#include <sl12/deferred_index_allocator.h>
+#include <functional>
+#include <mutex>
+
+
+namespace sl12
+{
+	class Device;
+	class CommandList;
+
+	/*************************************************//**
+	 * @brief バインドレス用のグローバルデスクリプタテーブル
+	 *
+	 * シェーダから参照するCBV_SRV_UAVヒープの連続領域を1つの大きなテーブルとして使用する.
+	 * 登録したビューは固定のu32インデックスを持ち、シェーダからは非有界配列として参照する.
+	 *   Texture2D   gTextures[] : register(t0, space1);
+	 *   RWTexture2D gRWTextures[] : register(u0, space2);
+	 * 解放したインデックスはGPUの使用完了後に再利用される.
+	*****************************************************/
+	class BindlessDescriptorTable
+	{
+	public:
+		static const u32 kInvalidIndex = DeferredIndexAllocator::kInvalidIndex;
+		static const u32 kSrvSpace = 1;		// SRVとして参照する場合のレジスタスペース
+		static const u32 kUavSpace = 2;		// UAVとして参照する場合のレジスタスペース
+
+	public:
+		BindlessDescriptorTable()
+		{}
+		~BindlessDescriptorTable()
+		{
+			Destroy();
+		}
+
+		bool Initialize(Device* pDev, u32 capacity);
+		void Destroy();
+
+		/**
+		 * @brief ビューを登録する
+		 *
+		 * createFuncで確保したスロットにビューを作成し、そのインデックスを返す.
+		 * 空きがない場合は kInvalidIndex を返す.
+		*/
+		u32 Register(const std::function<void(D3D12_CPU_DESCRIPTOR_HANDLE)>& createFunc);
+
+		/**
+		 * @brief インデックスを解放する
+		 *
+		 * GPUが使用を完了するまでインデックスは再利用されない.
+		*/
+		void Release(u32 index);
+
+		/**
+		 * @brief フレーム終了処理
+		 *
+		 * 完了したフレームで解放されたインデックスを回収し、現在のフレームで解放したインデックスをタグ付けする.
+		*/
+		void EndFrame(u64 completedFenceValue, u64 nextFenceValue);
+
+		/**
+		 * @brief ルートシグネチャ作成用にテーブルの記述を取得する
+		 *
+		 * SRVとUAVの2つのルートパラメータ(いずれも同じテーブル先頭を指す)を作成する.
+		 * 非有界配列を使用するため、Resource Binding Tier 2以上が必要.
+		*/
+		static void GetRootParameters(D3D12_DESCRIPTOR_RANGE* pRanges, D3D12_ROOT_PARAMETER* pParams);
+
+		/**
+		 * @brief テーブルをコマンドリストに設定する
+		*/
+		void SetGraphicsRootTables(CommandList& cmdList, u32 rootIndex);
+		void SetComputeRootTables(CommandList& cmdList, u32 rootIndex);
+
+		// getter
+		D3D12_GPU_DESCRIPTOR_HANDLE GetGpuHandle() const { return range_.gpuHandle; }
+		u32 GetCapacity() const { return range_.count; }
+		u32 GetRegisteredCount() const { return indexAllocator_.GetAllocatedCount(); }
+
+	private:
+		Device*					pDevice_{ nullptr };
+		DescriptorRange			range_;
+		DeferredIndexAllocator	indexAllocator_;
+		std::mutex				mutex_;
+	};	// class BindlessDescriptorTable
+
+}	// namespace sl12
+
+//	EOF
@@ -0,0 +1,58 @@
+﻿#pragma once
+
+#include <sl12/types.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+namespace sl12
+{
+	/**
+	 * @brief 最下位の立っているビット位置を返す(0の場合は-1)
+	*/
+	inline s32 FindFirstBit32(u32 v)
+	{
+		if (v == 0) return -1;
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, v);
+		return static_cast<s32>(index);
+#else
+		return __builtin_ctz(v);
+#endif
+	}
+
+	/**
+	 * @brief 最上位の立っているビット位置を返す(0の場合は-1)
+	*/
+	inline s32 FindLastBit32(u32 v)
+	{
+		if (v == 0) return -1;
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse(&index, v);
+		return static_cast<s32>(index);
+#else
+		return 31 - __builtin_clz(v);
+#endif
+	}
+
+	/**
+	 * @brief 最下位の立っているビット位置を返す(0の場合は-1)
+	*/
+	inline s32 FindFirstBit64(u64 v)
+	{
+		if (v == 0) return -1;
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward64(&index, v);
+		return static_cast<s32>(index);
+#else
+		return __builtin_ctzll(v);
+#endif
+	}
+
+}	// namespace sl12
+
+//	EOF
@@ -7,6 +7,7 @@ namespace sl12
 {
 	class Device;
 	class CommandList;
+	class UploadRing;
 
 	struct BufferUsage
 	{
@@ -37,13 +38,27 @@ namespace sl12
 		bool Initialize(Device* pDev, size_t size, size_t stride, BufferUsage::Type type, D3D12_RESOURCE_STATES initialState, bool isDynamic, bool isUAV);
 		void Destroy();
 
+		/**
+		 * @brief バッファを更新する
+		 *
+		 * pCmdListをリセットしてコピー命令を実行し、完了まで待機する.
+		*/
 		void UpdateBuffer(Device* pDev, CommandList* pCmdList, const void* pData, size_t size, size_t offset = 0);
 
+		/**
+		 * @brief バッファを更新するコピー命令を積む
+		 *
+		 * 実行と待機は行わないので、pCmdListを実行した後にring.Submit()を呼び出すこと.
+		 * アップロードヒープのバッファは直接書き込む.
+		*/
+		bool RecordUpdate(UploadRing& ring, CommandList* pCmdList, const void* pData, size_t size, size_t offset = 0);
+
 		void* Map(CommandList*);
 		void Unmap();
 
 		// getter
 		ID3D12Resource* GetResourceDep() { return pResource_; }
+		u64 GetResourceId() const { return resourceId_; }		// ビューキャッシュ用の一意なID
 		const D3D12_RESOURCE_DESC& GetResourceDesc() const { return resourceDesc_; }
 		size_t GetSize() const { return size_; }
 		size_t GetStride() const { return stride_; }
@@ -52,6 +67,7 @@ namespace sl12
 
 	private:
 		ID3D12Resource*			pResource_{ nullptr };
+		u64						resourceId_{ 0 };
 		D3D12_HEAP_PROPERTIES	heapProp_{};
 		D3D12_RESOURCE_DESC		resourceDesc_{};
 		size_t					size_{ 0 };
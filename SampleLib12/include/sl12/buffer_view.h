@@ -8,6 +8,7 @@ namespace sl12
 	class Device;
 	class Buffer;
 	class Descriptor;
+	class BindlessDescriptorTable;
 
 	//-------------------------------------------------------------------------
 	class ConstantBufferView
@@ -25,9 +26,11 @@ namespace sl12
 
 		// getter
 		Descriptor* GetDesc() { return pDesc_; }
+		D3D12_GPU_VIRTUAL_ADDRESS GetBufferLocation() const { return bufferLocation_; }
 
 	private:
-		Descriptor*	pDesc_{ nullptr };
+		Descriptor*					pDesc_{ nullptr };
+		D3D12_GPU_VIRTUAL_ADDRESS	bufferLocation_{ 0 };
 	};	// class ConstantBufferView
 
 
@@ -91,9 +94,12 @@ namespace sl12
 
 		// getter
 		Descriptor* GetDesc() { return pDesc_; }
+		u32 GetBindlessIndex() const { return bindlessIndex_; }		// バインドレステーブルのインデックス(無効時は~0)
 
 	private:
-		Descriptor*	pDesc_{ nullptr };
+		Descriptor*					pDesc_{ nullptr };
+		BindlessDescriptorTable*	pBindlessTable_{ nullptr };
+		u32							bindlessIndex_{ ~0u };
 	};	// class BufferView
 
 }	// namespace sl12
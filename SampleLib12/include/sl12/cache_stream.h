@@ -0,0 +1,95 @@
+﻿#pragma once
+
+#include <sl12/types.h>
+#include <cstring>
+#include <vector>
+
+
+namespace sl12
+{
+	/*************************************************//**
+	 * @brief キャッシュファイルの書き出し
+	 *
+	 * 値はリトルエンディアンのu32/u64として書き出すので、プラットフォームに依存しない.
+	*****************************************************/
+	class CacheWriter
+	{
+	public:
+		void Write32(u32 v)
+		{
+			for (int i = 0; i < 4; i++)
+				data_.push_back(static_cast<u8>(v >> (i * 8)));
+		}
+		void Write64(u64 v)
+		{
+			Write32(static_cast<u32>(v));
+			Write32(static_cast<u32>(v >> 32));
+		}
+		void WriteBytes(const void* p, size_t size)
+		{
+			const u8* b = reinterpret_cast<const u8*>(p);
+			data_.insert(data_.end(), b, b + size);
+		}
+
+		const std::vector<u8>& GetData() const { return data_; }
+
+	private:
+		std::vector<u8>		data_;
+	};	// class CacheWriter
+
+	/*************************************************//**
+	 * @brief キャッシュファイルの読み込み
+	 *
+	 * 範囲外の読み込みはfalseを返す.
+	*****************************************************/
+	class CacheReader
+	{
+	public:
+		CacheReader(const u8* p, u64 size)
+			: pData_(p), size_(size)
+		{}
+
+		bool Read32(u32& v)
+		{
+			if (size_ - offset_ < 4)
+				return false;
+			v = 0;
+			for (int i = 0; i < 4; i++)
+				v |= static_cast<u32>(pData_[offset_ + i]) << (i * 8);
+			offset_ += 4;
+			return true;
+		}
+		bool Read64(u64& v)
+		{
+			u32 lo, hi;
+			if (!Read32(lo) || !Read32(hi))
+				return false;
+			v = (static_cast<u64>(hi) << 32) | lo;
+			return true;
+		}
+		bool ReadBytes(void* p, u64 size)
+		{
+			if (size_ - offset_ < size)
+				return false;
+			memcpy(p, pData_ + offset_, static_cast<size_t>(size));
+			offset_ += size;
+			return true;
+		}
+		// 要素数が残りサイズを超えないかチェックする
+		bool CheckCount(u32 count, u32 elementSize) const
+		{
+			return static_cast<u64>(count) * elementSize <= size_ - offset_;
+		}
+
+		bool IsEnd() const { return offset_ == size_; }
+		u64 GetOffset() const { return offset_; }
+
+	private:
+		const u8*	pData_;
+		u64			size_;
+		u64			offset_ = 0;
+	};	// class CacheReader
+
+}	// namespace sl12
+
+//	EOF
@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include <sl12/util.h>
+#include <sl12/command_state_cache.h>
 
 
 namespace sl12
@@ -38,17 +39,57 @@ namespace sl12
 		void UAVBarrier(Texture* p);
 		void UAVBarrier(Buffer* p);
 
+		/**
+		 * @brief ステートキャッシュの有効/無効を切り替える
+		 *
+		 * 有効時は以下のステート設定関数で同一ステートの再設定を省略する.
+		 * キャッシュはReset()で破棄される.
+		 * ネイティブのコマンドリストで直接ステートを変更した場合はInvalidateStateCache()を呼び出すこと.
+		*/
+		void EnableStateCache(bool enable)
+		{
+			stateCache_.SetEnable(enable);
+		}
+		void InvalidateStateCache()
+		{
+			stateCache_.Invalidate();
+		}
+		void ResetStateCacheStats()
+		{
+			stateCache_.ResetStats();
+		}
+
+		void SetPipelineState(ID3D12PipelineState* pPso);
+		void SetGraphicsRootSignature(ID3D12RootSignature* pRootSig);
+		void SetComputeRootSignature(ID3D12RootSignature* pRootSig);
+		void SetGraphicsRootDescriptorTable(u32 rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE handle);
+		void SetComputeRootDescriptorTable(u32 rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE handle);
+		void SetGraphicsRootConstantBufferView(u32 rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address);
+		void SetComputeRootConstantBufferView(u32 rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address);
+		void SetGraphicsRoot32BitConstants(u32 rootIndex, u32 num32BitValues, const void* pData, u32 offset);
+		void SetComputeRoot32BitConstants(u32 rootIndex, u32 num32BitValues, const void* pData, u32 offset);
+		void SetDescriptorHeaps(u32 numHeaps, ID3D12DescriptorHeap* const* ppHeaps);
+		void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology);
+		void IASetVertexBuffers(u32 startSlot, u32 numViews, const D3D12_VERTEX_BUFFER_VIEW* pViews);
+		void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* pView);
+		void RSSetViewports(u32 numViewports, const D3D12_VIEWPORT* pViewports);
+		void RSSetScissorRects(u32 numRects, const D3D12_RECT* pRects);
+		void OMSetRenderTargets(u32 numRtvs, const D3D12_CPU_DESCRIPTOR_HANDLE* pRtvs, BOOL singleHandle, const D3D12_CPU_DESCRIPTOR_HANDLE* pDsv);
+
 		// getter
 		CommandQueue* GetParentQueue() { return pParentQueue_; }
 		ID3D12CommandAllocator* GetCommandAllocator() { return pCmdAllocator_; }
 		ID3D12GraphicsCommandList* GetCommandList() { return pCmdList_; };
 		ID3D12GraphicsCommandList4* GetDxrCommandList() { return pDxrCmdList_; };
+		bool IsStateCacheEnabled() const { return stateCache_.IsEnabled(); }
+		const CommandStateCache::Stats& GetStateCacheStats() const { return stateCache_.GetStats(); }
 
 	private:
 		CommandQueue*				pParentQueue_{ nullptr };
 		ID3D12CommandAllocator*		pCmdAllocator_{ nullptr };
 		ID3D12GraphicsCommandList*	pCmdList_{ nullptr };
 		ID3D12GraphicsCommandList4*	pDxrCmdList_{ nullptr };
+		CommandStateCache			stateCache_;
 	};	// class CommandList
 
 }	// namespace sl12
@@ -0,0 +1,137 @@
+﻿#pragma once
+
+#include <sl12/util.h>
+
+
+namespace sl12
+{
+	/*************************************************//**
+	 * @brief コマンドリストのステートキャッシュ
+	 *
+	 * 現在バインドされているPSO、ルートシグネチャ、ルート引数、IAバッファ、
+	 * ビューポート、シザー矩形、レンダーターゲットを記録し、
+	 * 同じステートの再設定を検出する.
+	 * 各Set関数はネイティブのコマンドを発行すべき場合に true を返す.
+	 * ルート定数は値を記録せず、常に発行する.
+	 * コマンドの発行は行わないので、コマンドリストなしで動作を確認できる.
+	*****************************************************/
+	class CommandStateCache
+	{
+	public:
+		static const u32 kMaxRootParameters = 64;
+		static const u32 kMaxVertexBuffers = D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT;
+		static const u32 kMaxViewports = D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+		static const u32 kMaxRenderTargets = D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT;
+		static const u32 kMaxDescriptorHeaps = 2;
+		static const u32 kInvalidCount = ~0u;
+
+		struct Stats
+		{
+			u32		issued = 0;			// 発行されたコマンド数
+			u32		filtered = 0;		// 冗長として除外されたコマンド数
+		};	// struct Stats
+
+	public:
+		CommandStateCache()
+		{
+			Invalidate();
+		}
+		~CommandStateCache()
+		{}
+
+		/**
+		 * @brief 記録済みのステートを全て不明状態にする
+		 *
+		 * コマンドリストのリセット時や、キャッシュを経由せずにステートを設定した場合に呼び出す.
+		*/
+		void Invalidate();
+
+		bool SetPipelineState(ID3D12PipelineState* pPso);
+		bool SetGraphicsRootSignature(ID3D12RootSignature* pRootSig);
+		bool SetComputeRootSignature(ID3D12RootSignature* pRootSig);
+		bool SetGraphicsRootArgument(u32 rootIndex, u64 value);
+		bool SetComputeRootArgument(u32 rootIndex, u64 value);
+		bool SetGraphicsRootConstants(u32 rootIndex);
+		bool SetComputeRootConstants(u32 rootIndex);
+		bool SetDescriptorHeaps(u32 numHeaps, ID3D12DescriptorHeap* const* ppHeaps);
+		bool IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology);
+		bool IASetVertexBuffers(u32 startSlot, u32 numViews, const D3D12_VERTEX_BUFFER_VIEW* pViews);
+		bool IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* pView);
+		bool RSSetViewports(u32 numViewports, const D3D12_VIEWPORT* pViewports);
+		bool RSSetScissorRects(u32 numRects, const D3D12_RECT* pRects);
+		bool OMSetRenderTargets(u32 numRtvs, const D3D12_CPU_DESCRIPTOR_HANDLE* pRtvs, BOOL singleHandle, const D3D12_CPU_DESCRIPTOR_HANDLE* pDsv);
+
+		/**
+		 * @brief キャッシュの有効/無効を切り替える
+		 *
+		 * 無効時は全てのSet関数が true を返す. 切り替え時には記録を破棄する.
+		*/
+		void SetEnable(bool enable)
+		{
+			enabled_ = enable;
+			Invalidate();
+		}
+
+		void ResetStats()
+		{
+			stats_ = Stats();
+		}
+
+		// getter
+		bool IsEnabled() const { return enabled_; }
+		const Stats& GetStats() const { return stats_; }
+
+	private:
+		struct RootArguments
+		{
+			ID3D12RootSignature*	pRootSig;
+			u64						validMask;
+			u64						values[kMaxRootParameters];
+		};	// struct RootArguments
+
+		bool SetRootSignature(RootArguments& args, ID3D12RootSignature* pRootSig);
+		bool SetRootArgument(RootArguments& args, u32 rootIndex, u64 value);
+		bool SetRootConstants(RootArguments& args, u32 rootIndex);
+		bool Result(bool changed)
+		{
+			if (changed)
+				stats_.issued++;
+			else
+				stats_.filtered++;
+			return changed;
+		}
+
+	private:
+		bool						enabled_ = false;
+		Stats						stats_;
+
+		ID3D12PipelineState*		pPso_;
+		bool						psoValid_;
+		RootArguments				graphicsArgs_;
+		RootArguments				computeArgs_;
+		ID3D12DescriptorHeap*		pHeaps_[kMaxDescriptorHeaps];
+		u32							numHeaps_;
+
+		bool						topologyValid_;
+		D3D12_PRIMITIVE_TOPOLOGY	topology_;
+		u32							vbValidMask_;
+		D3D12_VERTEX_BUFFER_VIEW	vbViews_[kMaxVertexBuffers];
+		bool						ibValid_;
+		D3D12_INDEX_BUFFER_VIEW		ibView_;
+
+		u32							numViewports_;		// kInvalidCount の場合は不明
+		D3D12_VIEWPORT				viewports_[kMaxViewports];
+		u32							numScissors_;
+		D3D12_RECT					scissors_[kMaxViewports];
+
+		bool						rtValid_;
+		u32							numRtvs_;
+		BOOL						rtvSingleHandle_;
+		D3D12_CPU_DESCRIPTOR_HANDLE	rtvs_[kMaxRenderTargets];
+		bool						hasDsv_;
+		D3D12_CPU_DESCRIPTOR_HANDLE	dsv_;
+	};	// class CommandStateCache
+
+}	// namespace sl12
+
+//	EOF
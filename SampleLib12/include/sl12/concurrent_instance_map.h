@@ -0,0 +1,197 @@
+﻿#pragma once
+
+#include <sl12/types.h>
+#include <atomic>
+#include <exception>
+#include <future>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+
+
+namespace sl12
+{
+	/*************************************************//**
+	 * @brief 参照カウント付きインスタンスの並行マップ
+	 *
+	 * キーごとに1つのインスタンスを共有する.
+	 * 検索はリーダーライターロックの共有ロックで行うので、生成済みのインスタンスは並列に取得できる.
+	 * 同じキーの生成が複数スレッドから同時に要求された場合、生成は1回だけ行い、他のスレッドは完了を待つ.
+	 * 生成処理自体はロックの外で行うので、異なるキーの生成は並列に実行される.
+	 *
+	 * Tは std::atomic<int> referenceCounter_ を持ち、このクラスをfriendにすること.
+	 * 参照カウントの増加(ハンドルのコピー)はロックを必要としない.
+	 * GPUリソースには依存しない.
+	*****************************************************/
+	template <typename Key, typename T>
+	class ConcurrentInstanceMap
+	{
+	public:
+		ConcurrentInstanceMap()
+		{}
+		~ConcurrentInstanceMap()
+		{
+			Clear();
+		}
+
+		/**
+		 * @brief インスタンスを取得する
+		 *
+		 * 生成済みの場合は参照カウントを増やして返す.
+		 * 未生成の場合はcreateFunc()で生成し、参照カウント1で登録する.
+		 * createFunc()がnullptrを返した場合はnullptrを返す. 生成を待っていたスレッドにもnullptrを返す.
+		 * createFunc()が例外を送出した場合は生成中の登録を取り消し、生成を待っていたスレッドにも同じ例外を送出する.
+		 * 返したインスタンスはRelease()で解放すること.
+		*/
+		template <typename CreateFunc>
+		T* Acquire(const Key& key, CreateFunc createFunc)
+		{
+			for (;;)
+			{
+				{
+					std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+					auto it = instances_.find(key);
+					if (it != instances_.end())
+					{
+						// 共有ロック中は削除されないので参照カウントを増やせる
+						it->second->referenceCounter_++;
+						hitCount_++;
+						return it->second;
+					}
+				}
+
+				std::promise<T*> promise;
+				std::shared_future<T*> future;
+				bool isOwner = false;
+				{
+					std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+					auto it = instances_.find(key);
+					if (it != instances_.end())
+					{
+						it->second->referenceCounter_++;
+						hitCount_++;
+						return it->second;
+					}
+
+					auto pendingIt = pending_.find(key);
+					if (pendingIt != pending_.end())
+					{
+						future = pendingIt->second;
+					}
+					else
+					{
+						isOwner = true;
+						future = promise.get_future().share();
+						pending_[key] = future;
+					}
+				}
+
+				if (!isOwner)
+				{
+					// 他スレッドの生成完了を待ち、登録されたインスタンスを取得し直す
+					// 待っている間に解放された場合は再度生成する
+					waitCount_++;
+					if (!future.get())
+					{
+						return nullptr;
+					}
+					continue;
+				}
+
+				T* pInstance = nullptr;
+				try
+				{
+					pInstance = createFunc();
+				}
+				catch (...)
+				{
+					// 登録を取り消してから待機中のスレッドに例外を渡す
+					{
+						std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+						pending_.erase(key);
+					}
+					promise.set_exception(std::current_exception());
+					throw;
+				}
+				{
+					std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+					if (pInstance)
+					{
+						pInstance->referenceCounter_ = 1;
+						instances_[key] = pInstance;
+					}
+					pending_.erase(key);
+				}
+				missCount_++;
+				promise.set_value(pInstance);
+				return pInstance;
+			}
+		}
+
+		/**
+		 * @brief 参照カウントを増やす
+		 *
+		 * 参照を保持しているインスタンスに対してのみ呼び出せる.
+		*/
+		void AddRef(T* pInstance)
+		{
+			pInstance->referenceCounter_++;
+		}
+
+		/**
+		 * @brief 参照を解放する
+		 *
+		 * 参照カウントが0になった場合はマップから取り除いて削除する.
+		*/
+		void Release(const Key& key, T* pInstance)
+		{
+			if (--pInstance->referenceCounter_ > 0)
+			{
+				return;
+			}
+
+			// ロックを取るまでに他スレッドが取得した場合は削除しない
+			std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+			auto it = instances_.find(key);
+			if (it != instances_.end() && it->second == pInstance && pInstance->referenceCounter_ == 0)
+			{
+				instances_.erase(it);
+				lock.unlock();
+				delete pInstance;
+			}
+		}
+
+		/**
+		 * @brief 全てのインスタンスを削除する
+		 *
+		 * 参照が残っていても削除するので、生成中のスレッドがない状態で呼び出すこと.
+		*/
+		void Clear()
+		{
+			std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+			for (auto&& v : instances_) delete v.second;
+			instances_.clear();
+		}
+
+		// getter
+		u32 GetCount() const
+		{
+			std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+			return static_cast<u32>(instances_.size());
+		}
+		u32 GetHitCount() const { return hitCount_; }
+		u32 GetMissCount() const { return missCount_; }
+		u32 GetWaitCount() const { return waitCount_; }
+
+	private:
+		mutable std::shared_timed_mutex			mutex_;
+		std::map<Key, T*>						instances_;
+		std::map<Key, std::shared_future<T*>>	pending_;		// 生成中のキー
+		std::atomic<u32>						hitCount_{ 0 };
+		std::atomic<u32>						missCount_{ 0 };	// 生成を行った回数
+		std::atomic<u32>						waitCount_{ 0 };	// 他スレッドの生成を待った回数
+	};	// class ConcurrentInstanceMap
+
+}	// namespace sl12
+
+//	EOF
@@ -39,7 +39,7 @@ namespace sl12
 		0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94, 0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d,
 	};
 
-	u32 CalcCrc32(const void* data, size_t dataSize, u32 crcBaseValue = 0xffffffff)
+	inline u32 CalcCrc32(const void* data, size_t dataSize, u32 crcBaseValue = 0xffffffff)
 	{
 		const u8* dataPtr = reinterpret_cast<const u8*>(data);
 		u32 crcValue = crcBaseValue;
@@ -49,6 +49,31 @@ namespace sl12
 
 		return ~crcValue;
 	}
+
+	/**
+	 * @brief 文字列のFNV-1aハッシュ(32bit)を計算する
+	 *
+	 * constexprなので文字列リテラルからはコンパイル時に計算できる.
+	*/
+	constexpr u32 CalcFnv1a32(const char* str, u32 hash = 0x811c9dc5)
+	{
+		return (*str == '\0') ? hash : CalcFnv1a32(str + 1, static_cast<u32>((static_cast<u64>(hash ^ static_cast<u8>(*str)) * 0x01000193ull) & 0xffffffffull));
+	}
+
+	/**
+	 * @brief データのFNV-1aハッシュ(64bit)を計算する
+	 *
+	 * hashに前回の結果を渡すと続きから計算する.
+	*/
+	inline u64 CalcFnv1a64(const void* data, size_t dataSize, u64 hash = 0xcbf29ce484222325ull)
+	{
+		const u8* dataPtr = reinterpret_cast<const u8*>(data);
+		for (size_t i = 0; i < dataSize; ++i) {
+			hash = (hash ^ *dataPtr++) * 0x00000100000001b3ull;
+		}
+
+		return hash;
+	}
 }	// namespace sl12
 
 	
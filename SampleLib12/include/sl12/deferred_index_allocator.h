@@ -0,0 +1,82 @@
+﻿#pragma once
+
+#include <sl12/types.h>
+#include <vector>
+#include <deque>
+
+
+namespace sl12
+{
+	/*************************************************//**
+	 * @brief GPU使用完了を待って再利用するインデックスアロケータ
+	 *
+	 * [0, capacity) のインデックスを確保・解放する.
+	 * 解放したインデックスはフレーム終了時にフェンス値でタグ付けされ、
+	 * GPUがそのフェンス値に到達するまで再利用されない.
+	 * 確保・解放はO(1). GPUリソースには依存しない.
+	 * スレッドセーフではないので、必要に応じて呼び出し側で排他すること.
+	*****************************************************/
+	class DeferredIndexAllocator
+	{
+	public:
+		static const u32 kInvalidIndex = ~0u;
+
+	public:
+		DeferredIndexAllocator()
+		{}
+		~DeferredIndexAllocator()
+		{
+			Destroy();
+		}
+
+		void Initialize(u32 capacity);
+		void Destroy();
+
+		/**
+		 * @brief インデックスを確保する
+		 *
+		 * 空きがない場合は kInvalidIndex を返す.
+		*/
+		u32 Allocate();
+
+		/**
+		 * @brief インデックスを解放する
+		 *
+		 * 実際に再利用可能になるのは、EndFrame()でタグ付けされたフェンス値にGPUが到達した後.
+		*/
+		void Free(u32 index);
+
+		/**
+		 * @brief 現在のフレームで解放したインデックスをフェンス値でタグ付けする
+		*/
+		void EndFrame(u64 fenceValue);
+
+		/**
+		 * @brief GPUが完了したフレームで解放されたインデックスを再利用可能にする
+		*/
+		void Reclaim(u64 completedFenceValue);
+
+		// getter
+		u32 GetCapacity() const { return capacity_; }
+		u32 GetAllocatedCount() const { return allocatedCount_; }
+		u32 GetPendingCount() const { return static_cast<u32>(pendingIndices_.size() + frameFreeIndices_.size()); }
+
+	private:
+		struct PendingFrame
+		{
+			u64		fenceValue;
+			u32		count;			// pendingIndices_ の先頭からの個数
+		};	// struct PendingFrame
+
+		u32						capacity_ = 0;
+		u32						nextUnused_ = 0;		// 一度も使用していないインデックスの先頭
+		u32						allocatedCount_ = 0;
+		std::vector<u32>		freeIndices_;			// 再利用可能なインデックス
+		std::vector<u32>		frameFreeIndices_;		// 現在のフレームで解放されたインデックス
+		std::deque<u32>			pendingIndices_;		// GPU完了待ちのインデックス
+		std::deque<PendingFrame>	pendingFrames_;
+	};	// class DeferredIndexAllocator
+
+}	// namespace sl12
+
+//	EOF
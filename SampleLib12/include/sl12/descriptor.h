@@ -1,12 +1,19 @@
 ﻿#pragma once
 
 #include <sl12/util.h>
+#include <sl12/descriptor_heap.h>
 
 
 namespace sl12
 {
 	class Device;
+	class DescriptorHeap;
 
+	/*************************************************//**
+	 * @brief ヒープ内の1つのデスクリプタ
+	 *
+	 * ハンドルは保持せず、必要時にヒープの先頭ハンドルとインデックスから計算する.
+	*****************************************************/
 	class Descriptor
 	{
 		friend class DescriptorHeap;
@@ -24,19 +31,34 @@ namespace sl12
 		void Release();
 
 		// getter
-		D3D12_CPU_DESCRIPTOR_HANDLE	GetCpuHandle() { return cpuHandle_; }
-		D3D12_GPU_DESCRIPTOR_HANDLE	GetGpuHandle() { return gpuHandle_; }
+		D3D12_CPU_DESCRIPTOR_HANDLE	GetCpuHandle() { return pParentHeap_->GetCpuHandle(index_); }
+		D3D12_GPU_DESCRIPTOR_HANDLE	GetGpuHandle() { return pParentHeap_->GetGpuHandle(index_); }
 		u32 GetIndex() const { return index_; }
+		DescriptorHeap* GetParentHeap() { return pParentHeap_; }
+
+		/**
+		 * @brief デスクリプタテーブルとして設定するためのGPUハンドルを取得する
+		 *
+		 * ステージング用ヒープのデスクリプタの場合は、シェーダから参照するヒープのリングにコピーしたハンドルを返す.
+		 * リングが溢れた場合はptrが0のハンドルを返す.
+		*/
+		D3D12_GPU_DESCRIPTOR_HANDLE GetTableGpuHandle();
 
 	private:
 		DescriptorHeap*				pParentHeap_{ nullptr };
-		Descriptor*					pPrev_{ nullptr };
-		Descriptor*					pNext_{ nullptr };
-		D3D12_CPU_DESCRIPTOR_HANDLE	cpuHandle_{ 0 };
-		D3D12_GPU_DESCRIPTOR_HANDLE	gpuHandle_{ 0 };
 		u32							index_{ 0 };
+		bool						isCached_{ false };		// ビューキャッシュで共有されている
 	};	// class Descriptor
 
+	/**
+	 * @brief 複数のデスクリプタを連続したデスクリプタテーブルとしてリングにコピーする
+	 *
+	 * ppDescsは同一種別のステージング用ヒープ上のデスクリプタであること.
+	 * コピーは1回のCopyDescriptorsで行い、テーブル先頭のGPUハンドルを返す.
+	 * 失敗した場合はptrが0のハンドルを返す.
+	*/
+	D3D12_GPU_DESCRIPTOR_HANDLE CreateDescriptorTable(Descriptor* const* ppDescs, u32 count);
+
 }	// namespace sl12
 
 //	EOF
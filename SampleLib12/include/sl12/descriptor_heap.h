@@ -1,15 +1,71 @@
 ﻿#pragma once
 
 #include <sl12/util.h>
+#include <sl12/range_allocator.h>
+#include <sl12/hierarchical_bitset.h>
+#include <atomic>
+#include <mutex>
+#include <functional>
 
 
 namespace sl12
 {
 	class Device;
 	class Descriptor;
+	class DescriptorRing;
+	class DescriptorViewCache;
+	struct DescriptorViewKey;
+
+	/*************************************************//**
+	 * @brief デスクリプタヒープの領域分割設定
+	*****************************************************/
+	struct DescriptorHeapLayout
+	{
+		u32		numRanges = 0;			// 連続領域として確保するデスクリプタ数
+		u32		numTransients = 0;		// ヒープ末尾に確保するフレーム単位のリング領域のデスクリプタ数
+		bool	enableViewCache = false;	// 同一ビューのデスクリプタを共有する
+		u32		numBindless = 0;			// バインドレステーブルのデスクリプタ数(連続領域から確保する. CBV_SRV_UAVのみ)
+		bool	stageViews = false;			// ビューをステージング用ヒープに作成し、描画時にリングへコピーする(シェーダから参照するヒープのみ. numTransientsが必要)
+	};	// struct DescriptorHeapLayout
+
+	/*************************************************//**
+	 * @brief ヒープ内の連続したデスクリプタ領域
+	*****************************************************/
+	struct DescriptorRange
+	{
+		D3D12_CPU_DESCRIPTOR_HANDLE	cpuHandle{ 0 };
+		D3D12_GPU_DESCRIPTOR_HANDLE	gpuHandle{ 0 };
+		u32							index = 0;
+		u32							count = 0;
+		u32							descSize = 0;
+
+		bool IsValid() const { return count > 0; }
+
+		D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(u32 offset) const
+		{
+			D3D12_CPU_DESCRIPTOR_HANDLE ret = cpuHandle;
+			ret.ptr += static_cast<SIZE_T>(offset) * descSize;
+			return ret;
+		}
+		D3D12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(u32 offset) const
+		{
+			D3D12_GPU_DESCRIPTOR_HANDLE ret = gpuHandle;
+			ret.ptr += static_cast<UINT64>(offset) * descSize;
+			return ret;
+		}
+	};	// struct DescriptorRange
 
 	class DescriptorHeap
 	{
+	public:
+		// スレッドローカルキャッシュ(マガジン)の設定
+		static const u32	kMagazineCount = 16;		// キャッシュスロット数
+		static const u32	kMagazineSize = 64;			// 1スロットあたりの最大保持数
+		static const u32	kMagazineBatch = 32;		// グローバルプールとの一括受け渡し数
+
+		// シェーダから参照しないヒープは枯渇時にページを追加して拡張する
+		static const u32	kMaxPages = 16;
+
 	public:
 		DescriptorHeap()
 		{}
@@ -18,23 +74,155 @@ namespace sl12
 			Destroy();
 		}
 
-		bool Initialize(Device* pDev, const D3D12_DESCRIPTOR_HEAP_DESC& desc);
+		bool Initialize(Device* pDev, const D3D12_DESCRIPTOR_HEAP_DESC& desc, const DescriptorHeapLayout& layout = DescriptorHeapLayout());
 		void Destroy();
 
 		Descriptor* CreateDescriptor();
 		void ReleaseDescriptor(Descriptor* p);
 
+		/**
+		 * @brief ビュー用のデスクリプタを取得する
+		 *
+		 * ビューキャッシュが有効な場合、同一キーのビューがあればそのデスクリプタを共有する.
+		 * 新規に確保した場合のみcreateFuncでビューを作成する.
+		*/
+		Descriptor* CreateViewDescriptor(const DescriptorViewKey& key, const std::function<void(D3D12_CPU_DESCRIPTOR_HANDLE)>& createFunc);
+
+		/**
+		 * @brief ビュー用のデスクリプタにデバイスのバインドレステーブルのインデックスを割り当てる
+		 *
+		 * 共有中のデスクリプタは最初の1回のみcreateFuncでテーブルに登録し、以降は同じインデックスを返す.
+		 * 共有中のインデックスはデスクリプタの最後の参照が解放された時点でテーブルに返される.
+		*/
+		u32 RegisterBindlessView(Descriptor* pDesc, const std::function<void(D3D12_CPU_DESCRIPTOR_HANDLE)>& createFunc);
+
+		/**
+		 * @brief RegisterBindlessView()で割り当てたインデックスを解放する
+		 *
+		 * 共有中のデスクリプタの場合はデスクリプタの解放時に返却するため何もしない.
+		 * デスクリプタを解放する前に呼び出すこと.
+		*/
+		void ReleaseBindlessView(Descriptor* pDesc, u32 index);
+
+		/**
+		 * @brief 連続したデスクリプタ領域を確保する
+		 *
+		 * 容量不足の場合は無効な領域を返す.
+		*/
+		DescriptorRange AllocateRange(u32 count);
+
+		/**
+		 * @brief AllocateRange()で確保した領域を解放する
+		*/
+		void FreeRange(const DescriptorRange& range);
+
+		/**
+		 * @brief 連続領域の断片化率を取得する
+		*/
+		float GetRangeFragmentation();
+
+		/**
+		 * @brief 指定インデックスからの連続領域を取得する
+		*/
+		DescriptorRange GetRange(u32 index, u32 count) const;
+
+		/**
+		 * @brief インデックスからハンドルを計算する
+		*/
+		D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(u32 index) const
+		{
+			// 追加ページのインデックスは NumDescriptors * ページ番号 から始まる
+			D3D12_CPU_DESCRIPTOR_HANDLE ret = cpuHandleStart_;
+			if (index >= heapDesc_.NumDescriptors)
+			{
+				u32 page = index / heapDesc_.NumDescriptors;
+				ret = pages_[page].cpuHandleStart;
+				index -= page * heapDesc_.NumDescriptors;
+			}
+			ret.ptr += static_cast<SIZE_T>(index) * descSize_;
+			return ret;
+		}
+		D3D12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(u32 index) const
+		{
+			// 追加ページはシェーダから参照しないヒープにのみ存在するので、GPUハンドルは持たない
+			D3D12_GPU_DESCRIPTOR_HANDLE ret = gpuHandleStart_;
+			ret.ptr += static_cast<UINT64>(index) * descSize_;
+			return ret;
+		}
+
 		// getter
+		Device* GetDevice() { return pDevice_; }
 		ID3D12DescriptorHeap* GetHeap() { return pHeap_; }
+		const D3D12_DESCRIPTOR_HEAP_DESC& GetHeapDesc() const { return heapDesc_; }
+		u32 GetDescSize() const { return descSize_; }
+		u32 GetTakeNum() const { return take_num_; }
+		u32 GetHighWaterMark() const { return highWaterMark_; }
+		u32 GetPageCount() const { return pageCount_; }
+		u32 GetCapacity() const { return numPersistents_ + (pageCount_ - 1) * heapDesc_.NumDescriptors; }
+		bool IsGrowable() const { return isGrowable_; }
+		bool IsShaderVisible() const { return (heapDesc_.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE) != 0; }
+		bool IsViewStaged() const { return isViewStaged_; }
+		u32 GetRangeBaseIndex() const { return rangeBase_; }
+		u32 GetRangeCapacity() const { return rangeAllocator_.GetCapacity(); }
+		u32 GetRangeUsedCount() const { return rangeAllocator_.GetUsedSize(); }
+		u32 GetRangeHighWaterMark() const { return rangeHighWaterMark_; }
+		DescriptorRing* GetTransientRing() { return pTransientRing_; }
+		DescriptorViewCache* GetViewCache() { return pViewCache_; }
+
+	private:
+		// スレッド毎のデスクリプタキャッシュ
+		struct Magazine
+		{
+			std::mutex		mutex;
+			Descriptor*		pItems[kMagazineSize];
+			u32				count = 0;
+		};	// struct Magazine
+
+		// 単体確保用のページ
+		struct Page
+		{
+			ID3D12DescriptorHeap*		pHeap = nullptr;		// 先頭ページはpHeap_を使用するのでnullptr
+			Descriptor*					pDescriptors = nullptr;
+			HierarchicalBitset			unusedBits;				// 未使用スロット
+			D3D12_CPU_DESCRIPTOR_HANDLE	cpuHandleStart{ 0 };
+		};	// struct Page
+
+		static u32 GetThreadSlot();
+
+		bool InitializePage(u32 pageIndex, u32 numSlots);
+		bool AddPage();
+
+		u32 AllocFromGlobal(Descriptor** ppOut, u32 count);
+		void ReleaseToGlobal(Descriptor* const* ppIn, u32 count);
+		Descriptor* StealFromMagazines();
 
 	private:
+		Device*						pDevice_{ nullptr };
 		ID3D12DescriptorHeap*		pHeap_{ nullptr };
-		Descriptor*					pDescriptors_{ nullptr };
-		//Descriptor*					pUsedList_{ nullptr };
-		Descriptor*					pUnusedList_{ nullptr };
+		Page						pages_[kMaxPages];
+		std::atomic<u32>			pageCount_{ 0 };
+		u32							numPersistents_{ 0 };		// 先頭ページの単体確保スロット数
+		bool						isGrowable_{ false };
+		bool						isViewStaged_{ false };
 		D3D12_DESCRIPTOR_HEAP_DESC	heapDesc_{};
 		uint32_t					descSize_{ 0 };
-		uint32_t					take_num_{ 0 };
+		std::atomic<u32>			take_num_{ 0 };
+		std::atomic<u32>			highWaterMark_{ 0 };
+		D3D12_CPU_DESCRIPTOR_HANDLE	cpuHandleStart_{ 0 };
+		D3D12_GPU_DESCRIPTOR_HANDLE	gpuHandleStart_{ 0 };
+
+		RangeAllocator				rangeAllocator_;
+		u32							rangeBase_{ 0 };
+		u32							rangeHighWaterMark_{ 0 };
+		std::mutex					rangeMutex_;
+
+		DescriptorRing*				pTransientRing_{ nullptr };
+
+		DescriptorViewCache*		pViewCache_{ nullptr };
+		std::mutex					viewCacheMutex_;
+
+		std::mutex					globalMutex_;
+		Magazine					magazines_[kMagazineCount];
 	};	// class DescriptorHeap
 
 }	// namespace sl12
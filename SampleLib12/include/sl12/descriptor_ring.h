@@ -0,0 +1,105 @@
+﻿#pragma once
+
+#include <sl12/util.h>
+#include <sl12/types.h>
+#include <sl12/ring_allocator.h>
+#include <sl12/descriptor_heap.h>
+#include <sl12/descriptor_table_cache.h>
+
+
+namespace sl12
+{
+	/*************************************************//**
+	 * @brief フレーム単位の一時デスクリプタを確保するリング
+	 *
+	 * シェーダから参照可能なヒープの一部をリングとして使用する.
+	 * 確保はO(1)で、個別の解放は行わない.
+	 * EndFrame()でフレームの確保範囲をフェンス値でタグ付けし、
+	 * Reclaim()でGPUが完了したフレームの範囲をまとめて再利用可能にする.
+	 * 描画スレッドからのみ使用すること.
+	*****************************************************/
+	class DescriptorRing
+	{
+	public:
+		static const u32 kMaxCachedTableSize = 64;		// テーブルキャッシュの対象とする最大デスクリプタ数
+
+	public:
+		DescriptorRing()
+		{}
+		~DescriptorRing()
+		{
+			Destroy();
+		}
+
+		bool Initialize(DescriptorHeap* pHeap, u32 baseIndex, u32 count);
+		void Destroy();
+
+		/**
+		 * @brief 連続したデスクリプタ領域を確保する
+		 *
+		 * 容量不足の場合は無効な領域を返し、オーバーフロー回数を加算する.
+		*/
+		DescriptorRange Allocate(u32 count);
+
+		/**
+		 * @brief ステージング用ヒープのデスクリプタをリングにコピーする
+		 *
+		 * pSrcHandlesの各デスクリプタを連続領域に並べてコピーする.
+		*/
+		DescriptorRange CopyFrom(const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcHandles, u32 count);
+
+		/**
+		 * @brief ステージング用ヒープのデスクリプタからテーブルを作成する
+		 *
+		 * 同一フレーム内で同じ並びのテーブルが作成済みの場合はコピーせずにそれを返す.
+		 * コピーはテーブルごとに1回のCopyDescriptorsで行う.
+		 * kMaxCachedTableSizeを超えるテーブルはキャッシュせずに毎回コピーする.
+		*/
+		DescriptorRange CopyTable(const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcHandles, u32 count);
+
+		/**
+		 * @brief 現在のフレームで確保した領域をフェンス値でタグ付けする
+		*/
+		void EndFrame(u64 fenceValue);
+
+		/**
+		 * @brief GPUが完了したフレームの領域を再利用可能にする
+		*/
+		void Reclaim(u64 completedFenceValue);
+
+		// getter
+		u32 GetBaseIndex() const { return baseIndex_; }
+		u32 GetCount() const { return static_cast<u32>(ring_.GetSize()); }
+		u32 GetUsedCount() const { return static_cast<u32>(ring_.GetUsedSize()); }
+		u32 GetFrameUsedCount() const { return static_cast<u32>(ring_.GetFrameUsedSize()); }
+		u32 GetOverflowCount() const { return overflowCount_; }
+		u32 GetHighWaterMark() const { return highWaterMark_; }
+
+		// コピー統計
+		struct CopyStats
+		{
+			u32		copyCalls = 0;			// CopyDescriptorsの呼び出し回数
+			u32		copiedDescriptors = 0;	// コピーしたデスクリプタ数
+			u32		tableRequests = 0;		// CopyTable()の呼び出し回数
+			u32		tableCacheHits = 0;		// キャッシュによりコピーを省略した回数
+			u32		tableCacheBypasses = 0;	// 大きさの上限を超えてキャッシュしなかった回数
+		};	// struct CopyStats
+
+		const CopyStats& GetFrameCopyStats() const { return frameStats_; }		// 現在のフレーム
+		const CopyStats& GetLastFrameCopyStats() const { return lastFrameStats_; }	// 直前に終了したフレーム
+
+	private:
+		DescriptorHeap*		pParentHeap_{ nullptr };
+		RingAllocator		ring_;
+		u32					baseIndex_{ 0 };
+		u32					overflowCount_{ 0 };
+		u32					highWaterMark_{ 0 };
+
+		DescriptorTableCache	tableCache_;
+		CopyStats				frameStats_;
+		CopyStats				lastFrameStats_;
+	};	// class DescriptorRing
+
+}	// namespace sl12
+
+//	EOF
@@ -0,0 +1,75 @@
+﻿#pragma once
+
+#include <sl12/types.h>
+#include <vector>
+#include <unordered_map>
+
+
+namespace sl12
+{
+	/*************************************************//**
+	 * @brief フレーム内のデスクリプタテーブルキャッシュ
+	 *
+	 * コピー元デスクリプタハンドルの並びをキーとして、コピー先のインデックスを保持する.
+	 * 同一フレーム内で同じ並びのテーブルが要求された場合はコピーを省略できる.
+	 * コピー元のデスクリプタはフレーム中に書き換えないこと.
+	 * GPUリソースには依存しない.
+	*****************************************************/
+	class DescriptorTableCache
+	{
+	public:
+		static const u32 kInvalidIndex = ~0u;
+
+	public:
+		DescriptorTableCache()
+		{}
+		~DescriptorTableCache()
+		{
+			Clear();
+		}
+
+		/**
+		 * @brief テーブルを検索する
+		 *
+		 * 見つからなかった場合は kInvalidIndex を返す.
+		*/
+		u32 Find(const u64* pSrcHandles, u32 count);
+
+		/**
+		 * @brief テーブルを登録する
+		*/
+		void Insert(const u64* pSrcHandles, u32 count, u32 destIndex);
+
+		/**
+		 * @brief 登録を全て破棄する
+		 *
+		 * フレーム終了時に呼び出す. 確保済みのメモリは再利用する.
+		*/
+		void Clear();
+
+		// getter
+		u32 GetEntryCount() const { return static_cast<u32>(entries_.size()); }
+		u32 GetLookupCount() const { return lookupCount_; }
+		u32 GetHitCount() const { return hitCount_; }
+
+	private:
+		struct Entry
+		{
+			u32		srcOffset;
+			u32		count;
+			u32		destIndex;
+		};	// struct Entry
+
+		static u64 CalcHash(const u64* pSrcHandles, u32 count);
+
+	private:
+		std::vector<u64>					srcHandles_;
+		std::vector<Entry>					entries_;
+		std::unordered_multimap<u64, u32>	lookup_;
+		u32									lookupCount_ = 0;
+		u32									hitCount_ = 0;
+	};	// class DescriptorTableCache
+
+}	// namespace sl12
+
+//	EOF
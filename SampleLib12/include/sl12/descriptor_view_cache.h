@@ -0,0 +1,145 @@
+﻿#pragma once
+
+#include <sl12/util.h>
+#include <unordered_map>
+#include <cstring>
+
+
+namespace sl12
+{
+	class Descriptor;
+
+	/*************************************************//**
+	 * @brief ビューキャッシュのキー
+	 *
+	 * リソースIDとビューの種類、ビュー記述子のバイト列で同一ビューを判定する.
+	 * 解放したリソースと同じアドレスに別のリソースが作成されることがあるため、ポインタではなくIssueResourceId()で発行したIDを使用する.
+	*****************************************************/
+	struct DescriptorViewKey
+	{
+		enum Type
+		{
+			SRV,
+			UAV,
+			CBV,
+			RTV,
+			DSV,
+		};	// enum Type
+
+		static const u32 kMaxDescSize = 64;
+
+		u64			resourceId = 0;
+		u32			type = 0;
+		u32			descSize = 0;
+		u32			hash = 0;
+		u8			desc[kMaxDescSize];
+
+		template <typename T>
+		DescriptorViewKey(Type t, u64 resId, const T& viewDesc)
+			: resourceId(resId), type(t), descSize(sizeof(T))
+		{
+			static_assert(sizeof(T) <= kMaxDescSize, "view desc is too large.");
+			memset(desc, 0, sizeof(desc));
+			memcpy(desc, &viewDesc, sizeof(T));
+			hash = CalcHash();
+		}
+
+		bool operator==(const DescriptorViewKey& rhs) const
+		{
+			return (resourceId == rhs.resourceId)
+				&& (type == rhs.type)
+				&& (descSize == rhs.descSize)
+				&& (memcmp(desc, rhs.desc, descSize) == 0);
+		}
+
+	private:
+		u32 CalcHash() const;
+	};	// struct DescriptorViewKey
+
+	/**
+	 * @brief ビューキャッシュのキーに使用するリソースIDを発行する
+	 *
+	 * プロセス内で一意な0以外の値を返す.
+	*/
+	u64 IssueResourceId();
+
+	/*************************************************//**
+	 * @brief 同一ビューのデスクリプタを共有するキャッシュ
+	 *
+	 * 参照カウントで管理し、最後の参照が解放された時点でデスクリプタをヒープに返す.
+	 * スレッドセーフではないので、DescriptorHeap側で排他すること.
+	*****************************************************/
+	class DescriptorViewCache
+	{
+	public:
+		DescriptorViewCache()
+		{}
+		~DescriptorViewCache()
+		{
+			Destroy();
+		}
+
+		void Destroy();
+
+		/**
+		 * @brief キャッシュを検索する
+		 *
+		 * 見つかった場合は参照カウントを加算して返す.
+		*/
+		Descriptor* Find(const DescriptorViewKey& key);
+
+		/**
+		 * @brief 新しく作成したデスクリプタを登録する
+		*/
+		void Insert(const DescriptorViewKey& key, Descriptor* pDesc);
+
+		/**
+		 * @brief 参照カウントを減算する
+		 *
+		 * 最後の参照が解放された場合、割り当てられていたバインドレスインデックスをpBindlessIndexに返す.
+		 * @return 最後の参照が解放され、デスクリプタをヒープに返すべき場合はtrue
+		*/
+		bool Release(Descriptor* pDesc, u32* pBindlessIndex = nullptr);
+
+		/**
+		 * @brief 共有中のデスクリプタのバインドレスインデックスを取得/設定する
+		 *
+		 * インデックスはデスクリプタと同じ参照カウントで管理する. 未設定の場合は~0を返す.
+		*/
+		u32 GetBindlessIndex(Descriptor* pDesc) const;
+		void SetBindlessIndex(Descriptor* pDesc, u32 index);
+
+		// getter
+		u64 GetHitCount() const { return hitCount_; }
+		u64 GetMissCount() const { return missCount_; }
+		float GetHitRate() const
+		{
+			u64 total = hitCount_ + missCount_;
+			return (total > 0) ? static_cast<float>(hitCount_) / static_cast<float>(total) : 0.0f;
+		}
+		u32 GetDescriptorCount() const { return static_cast<u32>(entries_.size()); }
+		u32 GetReferenceCount() const { return totalRefCount_; }
+
+	private:
+		struct Entry
+		{
+			Descriptor*		pDesc;
+			u32				refCount;
+			u32				bindlessIndex;
+		};	// struct Entry
+
+		struct KeyHasher
+		{
+			size_t operator()(const DescriptorViewKey& key) const { return key.hash; }
+		};	// struct KeyHasher
+
+		std::unordered_map<DescriptorViewKey, Entry, KeyHasher>	entries_;
+		std::unordered_map<Descriptor*, DescriptorViewKey>		keys_;
+		u64		hitCount_ = 0;
+		u64		missCount_ = 0;
+		u32		totalRefCount_ = 0;
+	};	// class DescriptorViewCache
+
+}	// namespace sl12
+
+//	EOF
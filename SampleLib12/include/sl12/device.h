@@ -1,15 +1,16 @@
 ﻿#pragma once
 
 #include <sl12/util.h>
+#include <sl12/descriptor_heap.h>
 #include <array>
 
 
 namespace sl12
 {
 	class CommandQueue;
+	class BindlessDescriptorTable;
+	class UploadRing;
 	class Swapchain;
-	class DescriptorHeap;
-
 	class Device
 	{
 	public:
@@ -20,7 +21,7 @@ namespace sl12
 			Destroy();
 		}
 
-		bool Initialize(HWND hWnd, u32 screenWidth, u32 screenHeight, const std::array<u32, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES>& numDescs);
+		bool Initialize(HWND hWnd, u32 screenWidth, u32 screenHeight, const std::array<u32, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES>& numDescs, const std::array<DescriptorHeapLayout, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES>& layouts = std::array<DescriptorHeapLayout, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES>());
 		void Destroy();
 
 		void Present(int syncInterval = 1);
@@ -28,11 +29,22 @@ namespace sl12
 		void WaitDrawDone();
 		void WaitPresent();
 
+		/**
+		 * @brief 各DescriptorHeapの最大使用数をデバッグ出力する
+		 *
+		 * 製品向けのヒープサイズ決定に使用する.
+		*/
+		void ReportDescriptorHeapUsage();
+
 		// getter
 		IDXGIFactory4*	GetFactoryDep()
 		{
 			return pFactory_;
 		}
+		IDXGIAdapter3*	GetAdapterDep()
+		{
+			return pAdapter_;
+		}
 		ID3D12Device*	GetDeviceDep()
 		{
 			return pDevice_;
@@ -58,10 +70,20 @@ namespace sl12
 			return *pCopyQueue_;
 		}
 		DescriptorHeap&	GetDescriptorHeap(u32 no);
+		DescriptorHeap&	GetStagingDescriptorHeap(u32 no);
+		DescriptorHeap&	GetViewDescriptorHeap(u32 no);
+		BindlessDescriptorTable*	GetBindlessTable()
+		{
+			return pBindlessTable_;
+		}
 		Swapchain&		GetSwapchain()
 		{
 			return *pSwapchain_;
 		}
+		UploadRing&		GetUploadRing()
+		{
+			return *pUploadRing_;
+		}
 
 	private:
 		IDXGIFactory4*	pFactory_{ nullptr };
@@ -77,9 +99,13 @@ namespace sl12
 		CommandQueue*	pCopyQueue_{ nullptr };
 
 		DescriptorHeap*	pDescHeaps_{ nullptr };
+		DescriptorHeap*	pStagingDescHeaps_{ nullptr };		// シェーダから参照するヒープへのコピー元(CPUのみ, 拡張可能)
+		BindlessDescriptorTable*	pBindlessTable_{ nullptr };
 
 		Swapchain*		pSwapchain_{ nullptr };
 
+		UploadRing*		pUploadRing_{ nullptr };		// リソース更新用のアップロードバッファ
+
 		ID3D12Fence*	pFence_{ nullptr };
 		u32				fenceValue_{ 0 };
 		HANDLE			fenceEvent_{ nullptr };
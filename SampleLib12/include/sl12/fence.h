@@ -30,6 +30,10 @@ namespace sl12
 
 		bool CheckSignal();
 
+		// getter
+		u32 GetSignaledValue() const { return waitValue_; }		// 最後にSignal(pQueue)で発行した値
+		u64 GetCompletedValue() const;
+
 	private:
 		ID3D12Fence*	pFence_{ nullptr };
 		HANDLE			hEvent_{ nullptr };
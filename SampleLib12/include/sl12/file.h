@@ -48,6 +48,13 @@ namespace sl12
 			size_ = 0;
 		}
 
+		// ǂݍ񂾃̏L
+		std::unique_ptr<uint8_t[]> DetachData()
+		{
+			size_ = 0;
+			return std::move(data_);
+		}
+
 		// getter
 		void* GetData() { return data_.get(); }
 		uint64_t GetSize() { return size_; }
@@ -0,0 +1,62 @@
+﻿#pragma once
+
+#include <sl12/types.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace sl12
+{
+	/*************************************************//**
+	 * @brief ディレクトリ内のファイルの変更監視
+	 *
+	 * WindowsではReadDirectoryChangesW、Linuxではinotifyを使用する.
+	 * Poll()はブロックせず、前回の呼び出し以降に書き込まれたファイルと削除されたファイルを返す.
+	 * 通知が溢れて変更を取りこぼした場合はHasOverflowed()がtrueになるので、監視対象を全て更新すること.
+	 * スレッドセーフではない.
+	*****************************************************/
+	class FileWatcher
+	{
+	public:
+		FileWatcher();
+		~FileWatcher();
+
+		FileWatcher(const FileWatcher&) = delete;
+		FileWatcher& operator=(const FileWatcher&) = delete;
+
+		/**
+		 * @brief 監視を開始する
+		 *
+		 * isRecursiveがtrueの場合はサブディレクトリも監視する.
+		*/
+		bool Initialize(const char* directory, bool isRecursive = true);
+		void Destroy();
+
+		/**
+		 * @brief 変更されたファイルを取得する
+		 *
+		 * パスは監視ディレクトリからの相対パスで、区切り文字は'/'に統一する.
+		 * 同じファイルの複数回の変更は1つにまとめる.
+		 * pOutRemovedを指定した場合は削除、または名前を変更されたファイルを追加する.
+		 * 削除後に作り直されたファイルは両方に含まれるので、呼び出し側でファイルの有無を確認すること.
+		 * @return outFilesに追加したファイル数
+		*/
+		u32 Poll(std::vector<std::string>& outFiles, std::vector<std::string>* pOutRemoved = nullptr);
+
+		// getter
+		bool IsValid() const { return impl_ != nullptr; }
+		const std::string& GetDirectory() const { return directory_; }
+		bool HasOverflowed() const { return hasOverflowed_; }
+
+	private:
+		struct Impl;
+
+		std::unique_ptr<Impl>	impl_;
+		std::string				directory_;
+		bool					hasOverflowed_ = false;
+	};	// class FileWatcher
+
+}	// namespace sl12
+
+//	EOF
@@ -0,0 +1,57 @@
+﻿#pragma once
+
+#include <sl12/types.h>
+#include <cstddef>
+#include <vector>
+
+
+namespace sl12
+{
+	/*************************************************//**
+	 * @brief 階層化ビットセット
+	 *
+	 * 最下層の64bitワードごとに、上位層のビットで「立っているビットがあるか」を保持する.
+	 * 立っているビットの検索は各層で1回のビットスキャンで済むため、
+	 * 65536要素でも3回のビットスキャンで見つけることができる.
+	*****************************************************/
+	class HierarchicalBitset
+	{
+	public:
+		static const u32 kInvalidIndex = ~0u;
+
+	public:
+		HierarchicalBitset()
+		{}
+		~HierarchicalBitset()
+		{
+			Destroy();
+		}
+
+		void Initialize(u32 count, bool initialValue);
+		void Destroy();
+
+		void Set(u32 index);
+		void Reset(u32 index);
+		bool Test(u32 index) const;
+
+		/**
+		 * @brief 最初に立っているビットのインデックスを取得する
+		 *
+		 * 立っているビットがない場合は kInvalidIndex を返す.
+		*/
+		u32 FindFirstSet() const;
+
+		// getter
+		u32 GetCount() const { return count_; }
+		u32 GetSetCount() const { return setCount_; }
+		size_t GetMemorySize() const;
+
+	private:
+		std::vector<std::vector<u64>>	levels_;		// [0]が最下層
+		u32								count_ = 0;
+		u32								setCount_ = 0;
+	};	// class HierarchicalBitset
+
+}	// namespace sl12
+
+//	EOF
@@ -0,0 +1,122 @@
+﻿#pragma once
+
+#include <sl12/types.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+namespace sl12
+{
+	/*************************************************//**
+	 * @brief バンプアロケータ
+	 *
+	 * チャンクの先頭から線形に切り出すだけのアロケータ.
+	 * チャンクが足りなくなった場合は新しいチャンクを追加するので、確保済みのアドレスは移動しない.
+	 * 個別の解放はなく、Reset()で全てを解放してチャンクを再利用する.
+	 * 確保したメモリのデストラクタは呼ばれないので、トリビアルな型のみに使用すること.
+	 * スレッドセーフではない.
+	*****************************************************/
+	class LinearArena
+	{
+	public:
+		static const size_t kDefaultChunkSize = 16 * 1024;
+
+	public:
+		explicit LinearArena(size_t chunkSize = kDefaultChunkSize)
+			: chunkSize_(chunkSize)
+		{}
+		~LinearArena()
+		{
+			Destroy();
+		}
+
+		LinearArena(const LinearArena&) = delete;
+		LinearArena& operator=(const LinearArena&) = delete;
+
+		/**
+		 * @brief メモリを確保する
+		 *
+		 * 現在のチャンクに収まらない場合は次のチャンクに移る.
+		 * チャンクサイズより大きい要求はその要求専用のチャンクを確保する.
+		*/
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+		{
+			for (;;)
+			{
+				if (current_ < chunks_.size())
+				{
+					Chunk& chunk = chunks_[current_];
+					uintptr_t base = reinterpret_cast<uintptr_t>(chunk.data.get());
+					uintptr_t aligned = (base + offset_ + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+					size_t newOffset = static_cast<size_t>(aligned - base) + size;
+					if (newOffset <= chunk.size)
+					{
+						offset_ = newOffset;
+						usedSize_ += size;
+						return reinterpret_cast<void*>(aligned);
+					}
+
+					// 次のチャンクへ
+					current_++;
+					offset_ = 0;
+					continue;
+				}
+
+				// 全てのチャンクを使い切ったので追加する
+				Chunk chunk;
+				chunk.size = (size + alignment > chunkSize_) ? (size + alignment) : chunkSize_;
+				chunk.data.reset(new u8[chunk.size]);
+				chunks_.push_back(std::move(chunk));
+			}
+		}
+
+		template <typename T>
+		T* Allocate(size_t count = 1)
+		{
+			return reinterpret_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+		}
+
+		/**
+		 * @brief 全ての確保を解放する
+		 *
+		 * チャンクは解放せず、次の確保で再利用する.
+		*/
+		void Reset()
+		{
+			current_ = 0;
+			offset_ = 0;
+			usedSize_ = 0;
+		}
+
+		/**
+		 * @brief チャンクを全て解放する
+		*/
+		void Destroy()
+		{
+			chunks_.clear();
+			Reset();
+		}
+
+		// getter
+		size_t GetUsedSize() const { return usedSize_; }
+		u32 GetChunkCount() const { return static_cast<u32>(chunks_.size()); }
+
+	private:
+		struct Chunk
+		{
+			std::unique_ptr<u8[]>	data;
+			size_t					size = 0;
+		};	// struct Chunk
+
+		size_t					chunkSize_;
+		std::vector<Chunk>		chunks_;
+		size_t					current_ = 0;		// 確保中のチャンク
+		size_t					offset_ = 0;		// 確保中のチャンク内の位置
+		size_t					usedSize_ = 0;
+	};	// class LinearArena
+
+}	// namespace sl12
+
+//	EOF
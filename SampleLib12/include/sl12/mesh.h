@@ -35,6 +35,8 @@ namespace sl12
 
 		/**
 		 * @brief 初期化する
+		 *
+		 * バッファのコピー命令をpCmdListに積むだけなので、実行は呼び出し側で行う.
 		*/
 		bool Initialize(sl12::Device* pDev, sl12::CommandList* pCmdList, const MeshShape* shape, const void* p_vertex_head);
 
@@ -99,6 +101,8 @@ namespace sl12
 
 		/**
 		 * @brief 初期化する
+		 *
+		 * バッファのコピー命令をpCmdListに積むだけなので、実行は呼び出し側で行う.
 		*/
 		bool Initialize(sl12::Device* pDev, sl12::CommandList* pCmdList, const MeshSubmesh* shape, const void* p_vertex_head);
 
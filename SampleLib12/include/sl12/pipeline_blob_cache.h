@@ -0,0 +1,131 @@
+﻿#pragma once
+
+#include <sl12/types.h>
+#include <cstddef>
+#include <map>
+#include <vector>
+
+
+namespace sl12
+{
+	/*************************************************//**
+	 * @brief パイプラインキャッシュを生成したアダプタとドライバの識別情報
+	 *
+	 * コンパイル済みPSOはアダプタとドライバが一致する場合のみ再利用できる.
+	*****************************************************/
+	struct PipelineCacheIdentity
+	{
+		u32		vendorId = 0;
+		u32		deviceId = 0;
+		u32		subSysId = 0;
+		u32		revision = 0;
+		u64		driverVersion = 0;
+
+		bool operator==(const PipelineCacheIdentity& rhs) const
+		{
+			return (vendorId == rhs.vendorId) && (deviceId == rhs.deviceId) && (subSysId == rhs.subSysId)
+				&& (revision == rhs.revision) && (driverVersion == rhs.driverVersion);
+		}
+		bool operator!=(const PipelineCacheIdentity& rhs) const
+		{
+			return !(*this == rhs);
+		}
+	};	// struct PipelineCacheIdentity
+
+	/*************************************************//**
+	 * @brief コンパイル済みPSOのファイルキャッシュ
+	 *
+	 * PSO記述子のハッシュ値をキーとして、ID3D12PipelineState::GetCachedBlob()の結果を保存する.
+	 * GPUリソースには依存しない.
+	 *
+	 * ファイルはリトルエンディアンで、ヘッダ、キー順にソートしたインデックス、データ領域の順に並ぶ.
+	 * 識別情報が一致しないファイルは全体を破棄する.
+	 * CRCが一致しないエントリはそのエントリのみを破棄する.
+	 * フォーマットを変更した場合はkVersionを更新すること.
+	*****************************************************/
+	class PipelineBlobCache
+	{
+	public:
+		static const u32 kMagic = 0x43504c53;		// 'SLPC'
+		static const u32 kVersion = 1;
+
+	public:
+		PipelineBlobCache()
+		{}
+		~PipelineBlobCache()
+		{
+			Clear();
+		}
+
+		/**
+		 * @brief 現在のアダプタとドライバの識別情報を設定する
+		 *
+		 * Load()の前に設定すること.
+		*/
+		void SetIdentity(const PipelineCacheIdentity& identity)
+		{
+			identity_ = identity;
+		}
+
+		/**
+		 * @brief ファイルから読み込む
+		 *
+		 * ファイルがない、バージョンや識別情報が異なる、内容が壊れている場合は空のキャッシュになりfalseを返す.
+		*/
+		bool Load(const char* filename);
+		bool LoadFromMemory(const void* pData, u64 size);
+
+		/**
+		 * @brief ファイルに保存する
+		 *
+		 * 今回の実行で参照または登録されたエントリのみを保存する.
+		*/
+		bool Save(const char* filename) const;
+		void SaveToMemory(std::vector<u8>& outData) const;
+
+		/**
+		 * @brief エントリを検索する
+		 *
+		 * 見つかった場合はoutBlobにコピーしてtrueを返す.
+		*/
+		bool Find(u64 key, std::vector<u8>& outBlob);
+
+		/**
+		 * @brief エントリを登録する
+		*/
+		void Store(u64 key, const void* pData, size_t size);
+
+		/**
+		 * @brief エントリを削除する
+		 *
+		 * キャッシュからPSOを生成できなかった場合に呼び出す.
+		*/
+		void Remove(u64 key);
+
+		void Clear();
+
+		// getter
+		const PipelineCacheIdentity& GetIdentity() const { return identity_; }
+		u32 GetEntryCount() const { return static_cast<u32>(entries_.size()); }
+		u32 GetHitCount() const { return hitCount_; }
+		u32 GetMissCount() const { return missCount_; }
+		u32 GetDiscardCount() const { return discardCount_; }
+
+	private:
+		struct Item
+		{
+			std::vector<u8>		blob;
+			bool				isUsed = false;
+		};	// struct Item
+
+	private:
+		PipelineCacheIdentity		identity_;
+		std::map<u64, Item>			entries_;
+		u32							hitCount_ = 0;
+		u32							missCount_ = 0;
+		u32							discardCount_ = 0;	// 読み込み時に破棄したエントリ数
+	};	// class PipelineBlobCache
+
+}	// namespace sl12
+
+//	EOF
@@ -0,0 +1,129 @@
+﻿#pragma once
+
+#include <sl12/util.h>
+#include <sl12/pipeline_state.h>
+#include <sl12/pipeline_state_cache.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace sl12
+{
+	class Device;
+
+	/*************************************************//**
+	 * @brief パイプラインステートの非同期コンパイラ
+	 *
+	 * ワーカースレッドでPSOとDXRステートオブジェクトを生成する.
+	 * 同時にコンパイルするのはワーカー数までで、それ以上の要求はキューで待つ.
+	 * 結果はstd::shared_futureで受け取り、WaitAll()で全ての完了を待つことができる.
+	 *
+	 * 入力レイアウトは要求時にコピーするので、要求後に破棄してよい.
+	 * シェーダ、ルートシグネチャ、DXRの記述子とその参照先は完了まで保持すること.
+	*****************************************************/
+	class PipelineCompiler
+	{
+	public:
+		PipelineCompiler()
+		{}
+		~PipelineCompiler()
+		{
+			Destroy();
+		}
+
+		/**
+		 * @brief 初期化
+		 *
+		 * maxConcurrentが0の場合はハードウェアスレッド数のワーカーを生成する.
+		*/
+		bool Initialize(Device* pDev, PipelineStateCache* pCache, u32 maxConcurrent = 0);
+
+		/**
+		 * @brief 破棄
+		 *
+		 * キューに残っている要求を全て完了してからワーカーを終了する.
+		*/
+		void Destroy();
+
+		/**
+		 * @brief PSOのコンパイルを要求する
+		 *
+		 * PipelineStateCacheを経由するので、同じ記述子の要求は1回だけコンパイルされる.
+		 * 失敗した場合、または初期化前に要求した場合は無効なハンドルが返る.
+		*/
+		std::shared_future<PipelineStateHandle> CompileGraphics(const GraphicsPipelineStateDesc& desc);
+		std::shared_future<PipelineStateHandle> CompileCompute(const ComputePipelineStateDesc& desc);
+
+		/**
+		 * @brief DXRステートオブジェクトの生成を要求する
+		 *
+		 * pStateとpDescは完了まで保持すること.
+		 * 初期化前に要求した場合はfalseが返る.
+		*/
+		std::shared_future<bool> CompileDxr(DxrPipelineState* pState, DxrPipelineStateDesc* pDesc);
+
+		/**
+		 * @brief 要求済みの全てのコンパイルが完了するまで待つ
+		*/
+		void WaitAll();
+
+		// getter
+		bool IsAllReady() const { return GetPendingCount() == 0; }
+		u32 GetPendingCount() const
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return pendingCount_;
+		}
+		u32 GetWorkerCount() const { return static_cast<u32>(workers_.size()); }
+		u32 GetFailedCount() const { return failedCount_; }
+
+	private:
+		template <typename R, typename Func>
+		std::shared_future<R> Enqueue(Func func)
+		{
+			if (workers_.empty())
+			{
+				// 初期化されていない場合はデバイスとキャッシュがないので、失敗した結果をすぐに返す
+				OutputDebugStringA("[sl12] PipelineCompiler : compile requested before Initialize().\n");
+				failedCount_++;
+				std::promise<R> promise;
+				promise.set_value(R());
+				return promise.get_future().share();
+			}
+
+			auto task = std::make_shared<std::packaged_task<R()>>(func);
+			auto future = task->get_future().share();
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				tasks_.push_back([task]() { (*task)(); });
+				pendingCount_++;
+			}
+			taskCv_.notify_one();
+			return future;
+		}
+
+		void WorkerMain();
+
+	private:
+		Device*									pDevice_ = nullptr;
+		PipelineStateCache*						pCache_ = nullptr;
+		std::vector<std::thread>				workers_;
+		std::deque<std::function<void()>>		tasks_;
+		mutable std::mutex						mutex_;
+		std::condition_variable					taskCv_;		// 要求の追加、終了の通知
+		std::condition_variable					idleCv_;		// 全ての要求の完了の通知
+		u32										pendingCount_ = 0;	// キュー内と実行中の要求数
+		std::atomic<u32>						failedCount_{ 0 };
+		bool									isExit_ = false;
+	};	// class PipelineCompiler
+
+}	// namespace sl12
+
+//	EOF
@@ -1,7 +1,9 @@
 ﻿#pragma once
 
+#include <utility>
 #include <vector>
 #include <sl12/util.h>
+#include <sl12/linear_arena.h>
 #include <sl12/root_signature.h>
 
 
@@ -84,12 +86,14 @@ namespace sl12
 		DXGI_FORMAT				rtvFormats[8]{ DXGI_FORMAT_UNKNOWN };
 		DXGI_FORMAT				dsvFormat = DXGI_FORMAT_UNKNOWN;
 		u32						multisampleCount = 1;
+		D3D12_CACHED_PIPELINE_STATE	cachedPSO{};	// コンパイル済みのPSO(ない場合は空)
 	};	// struct GraphicsPipelineStateDesc
 
 	struct ComputePipelineStateDesc
 	{
 		RootSignature*			pRootSignature = nullptr;
 		Shader*					pCS = nullptr;
+		D3D12_CACHED_PIPELINE_STATE	cachedPSO{};	// コンパイル済みのPSO(ない場合は空)
 	};	// struct ComputePipelineStateDesc
 
 	class GraphicsPipelineState
@@ -105,6 +109,15 @@ namespace sl12
 		bool Initialize(Device* pDev, const GraphicsPipelineStateDesc& desc);
 		void Destroy();
 
+		// プリミティブトポロジからトポロジタイプを求める
+		static D3D12_PRIMITIVE_TOPOLOGY_TYPE ToTopologyType(D3D_PRIMITIVE_TOPOLOGY topology);
+
+		// 保持しているPSOを入れ替える
+		void Swap(GraphicsPipelineState& other)
+		{
+			std::swap(pPipelineState_, other.pPipelineState_);
+		}
+
 		// getter
 		ID3D12PipelineState* GetPSO() { return pPipelineState_; }
 
@@ -125,6 +138,12 @@ namespace sl12
 		bool Initialize(Device* pDev, const ComputePipelineStateDesc& desc);
 		void Destroy();
 
+		// 保持しているPSOを入れ替える
+		void Swap(ComputePipelineState& other)
+		{
+			std::swap(pPipelineState_, other.pPipelineState_);
+		}
+
 		// getter
 		ID3D12PipelineState* GetPSO() { return pPipelineState_; }
 
@@ -133,18 +152,41 @@ namespace sl12
 	};	// class ComputePipelineState
 
 
+	/*************************************************//**
+	 * @brief DXRステートオブジェクトの記述子
+	 *
+	 * サブオブジェクトの記述はLinearArenaから確保するので、サブオブジェクトごとのmallocは発生しない.
+	 * アリーナのアドレスは移動しないので、追加を続けても確保済みの記述へのポインタは有効なまま.
+	 * 配列の引数(エクスポート、関連付けるエクスポート名)はアリーナにコピーするので、呼び出し後に破棄してよい.
+	 * 文字列とシェーダバイナリはコピーしないので、ステートオブジェクトの生成まで保持すること.
+	 * Reset()で記述を破棄して、確保済みのメモリを次の構築に再利用できる.
+	*****************************************************/
 	class DxrPipelineStateDesc
 	{
 	public:
 		DxrPipelineStateDesc()
 		{}
 		~DxrPipelineStateDesc()
+		{}
+
+		/**
+		 * @brief サブオブジェクト数を予約する
+		*/
+		void Reserve(u32 numSubobjects)
 		{
-			for (auto&& v : descBinaries_)
-			{
-				free(v);
-			}
-			descBinaries_.clear();
+			subobjects_.reserve(numSubobjects);
+		}
+
+		/**
+		 * @brief 記述を破棄する
+		 *
+		 * アリーナのメモリは解放せずに再利用する.
+		*/
+		void Reset()
+		{
+			subobjects_.clear();
+			exportAssociationIndices_.clear();
+			arena_.Reset();
 		}
 
 		void AddSubobject(D3D12_STATE_SUBOBJECT_TYPE type, const void* desc)
@@ -167,7 +209,7 @@ namespace sl12
 			dxilDesc->DXILLibrary.pShaderBytecode = shaderBin;
 			dxilDesc->DXILLibrary.BytecodeLength = shaderBinSize;
 			dxilDesc->NumExports = exportDescsCount;
-			dxilDesc->pExports = exportDescs;
+			dxilDesc->pExports = CopyArray(exportDescs, exportDescsCount);
 			AddSubobject(D3D12_STATE_SUBOBJECT_TYPE_DXIL_LIBRARY, dxilDesc);
 		}
 
@@ -202,7 +244,7 @@ namespace sl12
 			auto assDesc = AllocBinary< D3D12_SUBOBJECT_TO_EXPORTS_ASSOCIATION>();
 			assDesc->pSubobjectToAssociate = nullptr;
 			assDesc->NumExports = exportsCount;
-			assDesc->pExports = exportsArray;
+			assDesc->pExports = CopyArray(exportsArray, exportsCount);
 			AddSubobject(D3D12_STATE_SUBOBJECT_TYPE_SUBOBJECT_TO_EXPORTS_ASSOCIATION, assDesc);
 
 		}
@@ -223,6 +265,13 @@ namespace sl12
 			AddSubobject(D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_PIPELINE_CONFIG, rtConfigDesc);
 		}
 
+		/**
+		 * @brief エクスポートの関連付けを検証する
+		 *
+		 * 関連付けの直前のサブオブジェクトが関連付け可能な種類(ローカルルートシグネチャ等)であることを確認する.
+		*/
+		bool Validate() const;
+
 		D3D12_STATE_OBJECT_DESC GetStateObjectDesc()
 		{
 			ResolveExportAssosiation();
@@ -234,22 +283,40 @@ namespace sl12
 			return psoDesc;
 		}
 
+		// getter
+		u32 GetSubobjectCount() const { return static_cast<u32>(subobjects_.size()); }
+		const LinearArena& GetArena() const { return arena_; }
+
 	private:
 		template <typename T>
 		T* AllocBinary()
 		{
-			auto p = malloc(sizeof(T));
-			descBinaries_.push_back(p);
-			return reinterpret_cast<T*>(p);
+			auto p = arena_.Allocate<T>();
+			*p = T{};
+			return p;
+		}
+
+		template <typename T>
+		T* CopyArray(const T* src, UINT count)
+		{
+			if (!src || count == 0)
+			{
+				return nullptr;
+			}
+			auto p = arena_.Allocate<T>(count);
+			memcpy(p, src, sizeof(T) * count);
+			return p;
 		}
 
 		void ResolveExportAssosiation()
 		{
+			// 関連付け先はサブオブジェクト配列上のアドレスなので、配列の伸長が終わった後に解決する
 			auto subDesc = subobjects_.data();
 			for (auto&& v : exportAssociationIndices_)
 			{
 				auto e = v;
 				auto l = e - 1;
+				assert(l >= 0 && e < (int)subobjects_.size());
 
 				auto eDesc = (D3D12_SUBOBJECT_TO_EXPORTS_ASSOCIATION*)subobjects_[e].pDesc;
 				eDesc->pSubobjectToAssociate = subDesc + l;
@@ -259,7 +326,7 @@ namespace sl12
 	private:
 		std::vector<D3D12_STATE_SUBOBJECT>	subobjects_;
 		std::vector<int>					exportAssociationIndices_;
-		std::vector<void*>					descBinaries_;
+		LinearArena							arena_;
 	};	// class DxrPipelineStateDesc
 
 	class DxrPipelineState
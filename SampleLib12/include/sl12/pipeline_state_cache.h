@@ -0,0 +1,192 @@
+﻿#pragma once
+
+#include <sl12/util.h>
+#include <sl12/pipeline_state.h>
+#include <sl12/concurrent_instance_map.h>
+#include <sl12/pipeline_blob_cache.h>
+#include <atomic>
+#include <mutex>
+
+
+namespace sl12
+{
+	class Device;
+	class PipelineStateCache;
+
+	/*************************************************//**
+	 * @brief キャッシュされたパイプラインステート
+	*****************************************************/
+	class PipelineStateInstance
+	{
+		friend class PipelineStateCache;
+		friend class PipelineStateHandle;
+		template <typename, typename> friend class ConcurrentInstanceMap;
+
+	private:
+		~PipelineStateInstance()
+		{
+			graphics_.Destroy();
+			compute_.Destroy();
+		}
+
+	private:
+		GraphicsPipelineState		graphics_;
+		ComputePipelineState		compute_;
+		std::atomic<int>			referenceCounter_{ 0 };
+		bool						isGraphics_ = true;
+	};	// class PipelineStateInstance
+
+	/*************************************************//**
+	 * @brief パイプラインステートハンドル
+	 *
+	 * コピーすると参照カウントが増え、全てのハンドルが破棄された時点でPSOが解放される.
+	*****************************************************/
+	class PipelineStateHandle
+	{
+		friend class PipelineStateCache;
+
+	public:
+		PipelineStateHandle()
+		{}
+		PipelineStateHandle(const PipelineStateHandle& h)
+			: pCache_(h.pCache_), key_(h.key_), pInstance_(h.pInstance_)
+		{
+			if (pInstance_)
+			{
+				pInstance_->referenceCounter_++;
+			}
+		}
+		~PipelineStateHandle()
+		{
+			Invalid();
+		}
+
+		PipelineStateHandle& operator=(const PipelineStateHandle& h)
+		{
+			if (this != &h)
+			{
+				Invalid();
+				pCache_ = h.pCache_;
+				key_ = h.key_;
+				pInstance_ = h.pInstance_;
+				if (pInstance_)
+				{
+					pInstance_->referenceCounter_++;
+				}
+			}
+			return *this;
+		}
+
+		bool IsValid() const
+		{
+			return pInstance_ != nullptr;
+		}
+
+		void Invalid();
+
+		// getter
+		ID3D12PipelineState* GetPSO()
+		{
+			if (!pInstance_)
+			{
+				return nullptr;
+			}
+			return pInstance_->isGraphics_ ? pInstance_->graphics_.GetPSO() : pInstance_->compute_.GetPSO();
+		}
+		u64 GetKey() const { return key_; }
+
+	private:
+		// キャッシュから取得した参照をそのまま引き継ぐ(参照カウントは増やさない)
+		PipelineStateHandle(PipelineStateCache* cache, u64 key, PipelineStateInstance* ins)
+			: pCache_(cache), key_(key), pInstance_(ins)
+		{}
+
+	private:
+		PipelineStateCache*			pCache_ = nullptr;
+		u64							key_ = 0;
+		PipelineStateInstance*		pInstance_ = nullptr;
+	};	// class PipelineStateHandle
+
+	/*************************************************//**
+	 * @brief パイプラインステートキャッシュ
+	 *
+	 * 記述子全体のハッシュ値をキーにPSOを共有する.
+	 * シェーダはバイトコード、ルートシグネチャはシリアライズ結果のハッシュ値で識別するので、キーは実行ごとに変わらない.
+	 * 実際にPSOに反映されない値(独立ブレンド無効時の1番以降のブレンド設定、使用しないRTフォーマット等)はキーに含めない.
+	 * 生成、解放は複数スレッドから呼び出せる.
+	 * LoadCache()を呼び出した場合はコンパイル済みPSOをファイルにキャッシュする.
+	 * LoadCache(), SaveCache(), Destroy()は生成中のスレッドがない状態で呼び出すこと.
+	*****************************************************/
+	class PipelineStateCache
+	{
+	public:
+		PipelineStateCache()
+		{}
+		~PipelineStateCache()
+		{
+			Destroy();
+		}
+
+		bool Initialize(Device* pDev);
+		void Destroy();
+
+		/**
+		 * @brief パイプラインステートを取得する
+		 *
+		 * 同じ記述子のPSOが生成済みの場合はそれを共有する.
+		 * 生成に失敗した場合は無効なハンドルを返す.
+		*/
+		PipelineStateHandle CreateGraphics(const GraphicsPipelineStateDesc& desc);
+		PipelineStateHandle CreateCompute(const ComputePipelineStateDesc& desc);
+
+		/**
+		 * @brief パイプラインステートを解放する
+		*/
+		void ReleasePipelineState(u64 key, PipelineStateInstance* pInst);
+
+		/**
+		 * @brief コンパイル済みPSOのファイルキャッシュを読み込む
+		 *
+		 * PSOの生成前に呼び出す.
+		 * ファイルがない場合やアダプタ、ドライバが異なる場合も、以降に生成したPSOはキャッシュに登録される.
+		 * キャッシュからPSOを生成できなかった場合はキャッシュを破棄して通常通り生成する.
+		*/
+		bool LoadCache(const char* filename);
+
+		/**
+		 * @brief コンパイル済みPSOのファイルキャッシュを保存する
+		 *
+		 * 今回の実行で使用したPSOのみを保存する.
+		*/
+		bool SaveCache(const char* filename) const;
+
+		/**
+		 * @brief 記述子からキャッシュのキーを計算する
+		 *
+		 * デバイスを必要としない.
+		*/
+		static u64 CalcGraphicsKey(const GraphicsPipelineStateDesc& desc);
+		static u64 CalcComputeKey(const ComputePipelineStateDesc& desc);
+
+		// getter
+		u32 GetInstanceCount() const { return instances_.GetCount(); }
+		u32 GetHitCount() const { return instances_.GetHitCount(); }
+		u32 GetMissCount() const { return instances_.GetMissCount(); }
+		const PipelineBlobCache& GetBlobCache() const { return blobCache_; }
+
+	private:
+		bool FindBlob(u64 key, std::vector<u8>& outBlob);
+		void StoreBlob(u64 key, ID3D12PipelineState* pPSO);
+		void DiscardBlob(u64 key);
+
+	private:
+		Device*												pDevice_ = nullptr;
+		ConcurrentInstanceMap<u64, PipelineStateInstance>	instances_;
+		PipelineBlobCache									blobCache_;
+		mutable std::mutex									blobMutex_;
+		bool												isBlobCacheEnabled_ = false;
+	};	// class PipelineStateCache
+
+}	// namespace sl12
+
+//	EOF
@@ -0,0 +1,110 @@
+﻿#pragma once
+
+#include <sl12/types.h>
+#include <vector>
+
+
+namespace sl12
+{
+	/*************************************************//**
+	 * @brief TLSFによる連続領域アロケータ
+	 *
+	 * [0, capacity) の整数領域から連続した範囲を切り出す.
+	 * 確保・解放はO(1)で、解放時には隣接する空き領域と結合する.
+	 * GPUリソースには依存しないので、デスクリプタのスロット管理などに使用できる.
+	 * スレッドセーフではないので、必要に応じて呼び出し側で排他すること.
+	*****************************************************/
+	class RangeAllocator
+	{
+	public:
+		static const u32 kInvalidOffset = ~0u;
+
+	public:
+		RangeAllocator()
+		{}
+		~RangeAllocator()
+		{
+			Destroy();
+		}
+
+		bool Initialize(u32 capacity);
+		void Destroy();
+
+		/**
+		 * @brief 連続領域を確保する
+		 *
+		 * 空きがない場合は kInvalidOffset を返す.
+		*/
+		u32 Allocate(u32 size);
+
+		/**
+		 * @brief Allocate()で確保した領域を解放する
+		*/
+		void Free(u32 offset);
+
+		/**
+		 * @brief 確保済み領域のサイズを取得する
+		*/
+		u32 GetAllocationSize(u32 offset) const;
+
+		/**
+		 * @brief 最大の空き領域サイズを取得する
+		*/
+		u32 GetLargestFreeSize() const;
+
+		/**
+		 * @brief 断片化率を取得する
+		 *
+		 * 1 - 最大空き領域 / 総空き領域. 空き領域がひとつにまとまっていれば0となる.
+		*/
+		float GetFragmentation() const;
+
+		// getter
+		u32 GetCapacity() const { return capacity_; }
+		u32 GetUsedSize() const { return usedSize_; }
+		u32 GetFreeSize() const { return capacity_ - usedSize_; }
+		u32 GetAllocationCount() const { return allocCount_; }
+		u32 GetFreeBlockCount() const { return freeBlockCount_; }
+
+	private:
+		static const u32 kNull = ~0u;
+		static const u32 kSLCountLog2 = 4;
+		static const u32 kSLCount = 1 << kSLCountLog2;
+		static const u32 kFLCount = 32 - kSLCountLog2 + 1;
+
+		struct Block
+		{
+			u32		offset;
+			u32		size;
+			u32		prevPhys;
+			u32		nextPhys;
+			u32		prevFree;
+			u32		nextFree;
+			bool	isFree;
+		};	// struct Block
+
+		static void Mapping(u32 size, u32& fl, u32& sl);
+		static bool MappingSearch(u32 size, u32& fl, u32& sl);
+
+		u32 NewBlock();
+		void DeleteBlock(u32 block);
+		void InsertFreeBlock(u32 block);
+		void RemoveFreeBlock(u32 block);
+		u32 FindFreeBlock(u32 size);
+
+	private:
+		std::vector<Block>	blocks_;
+		std::vector<u32>	unusedBlocks_;
+		std::vector<u32>	offsetToBlock_;
+		u32					flBitmap_ = 0;
+		u32					slBitmap_[kFLCount] = {};
+		u32					freeHeads_[kFLCount][kSLCount];
+		u32					capacity_ = 0;
+		u32					usedSize_ = 0;
+		u32					allocCount_ = 0;
+		u32					freeBlockCount_ = 0;
+	};	// class RangeAllocator
+
+}	// namespace sl12
+
+//	EOF
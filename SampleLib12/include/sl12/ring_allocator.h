@@ -0,0 +1,130 @@
+﻿#pragma once
+
+#include <sl12/types.h>
+#include <deque>
+
+
+namespace sl12
+{
+	/*************************************************//**
+	 * @brief フェンス値でタグ付けされたリングアロケータ
+	 *
+	 * [0, size) の領域をリングバッファとして先頭から線形に切り出す.
+	 * フレーム終了時に現在の割り当て範囲をフェンス値でタグ付けし、
+	 * GPUがそのフェンス値に到達した時点で領域を再利用可能にする.
+	 * GPUリソースには依存しないので、デスクリプタのインデックス管理にも
+	 * アップロードバッファのバイトオフセット管理にも使用できる.
+	*****************************************************/
+	class RingAllocator
+	{
+	public:
+		static const u64 kInvalidOffset = ~0ull;
+
+	public:
+		RingAllocator()
+		{}
+		~RingAllocator()
+		{
+			Destroy();
+		}
+
+		void Initialize(u64 size)
+		{
+			size_ = size;
+			head_ = tail_ = frameStart_ = 0;
+			frames_.clear();
+		}
+
+		void Destroy()
+		{
+			size_ = 0;
+			head_ = tail_ = frameStart_ = 0;
+			frames_.clear();
+		}
+
+		/**
+		 * @brief 連続領域を確保する
+		 *
+		 * 終端をまたぐ場合は終端までを詰め物として捨てて先頭から確保する.
+		 * 空きがない場合は kInvalidOffset を返す.
+		*/
+		u64 Allocate(u64 size, u64 alignment = 1)
+		{
+			if (size == 0 || size > size_)
+			{
+				return kInvalidOffset;
+			}
+
+			u64 pos = head_ % size_;
+			u64 alignedPos = (alignment > 1) ? ((pos + alignment - 1) / alignment * alignment) : pos;
+			u64 newHead = head_ + (alignedPos - pos);
+			if (alignedPos + size > size_)
+			{
+				// 終端をまたぐので先頭に戻す
+				newHead = head_ + (size_ - pos);
+				alignedPos = 0;
+			}
+			if (head_ == tail_)
+			{
+				// 空の場合は詰め物を使用中として扱わない
+				tail_ = frameStart_ = newHead;
+			}
+			if (newHead + size - tail_ > size_)
+			{
+				return kInvalidOffset;
+			}
+
+			head_ = newHead + size;
+			return alignedPos;
+		}
+
+		/**
+		 * @brief 現在のフレームで確保した領域をフェンス値でタグ付けする
+		*/
+		void EndFrame(u64 fenceValue)
+		{
+			if (head_ != frameStart_)
+			{
+				FrameRegion region;
+				region.end = head_;
+				region.fenceValue = fenceValue;
+				frames_.push_back(region);
+				frameStart_ = head_;
+			}
+		}
+
+		/**
+		 * @brief GPUが完了したフレームの領域を解放する
+		*/
+		void Reclaim(u64 completedFenceValue)
+		{
+			while (!frames_.empty() && frames_.front().fenceValue <= completedFenceValue)
+			{
+				tail_ = frames_.front().end;
+				frames_.pop_front();
+			}
+		}
+
+		// getter
+		u64 GetSize() const { return size_; }
+		u64 GetUsedSize() const { return head_ - tail_; }
+		u64 GetFrameUsedSize() const { return head_ - frameStart_; }
+		u32 GetPendingFrameCount() const { return static_cast<u32>(frames_.size()); }
+
+	private:
+		struct FrameRegion
+		{
+			u64		end;
+			u64		fenceValue;
+		};	// struct FrameRegion
+
+		u64							size_ = 0;
+		u64							head_ = 0;			// 次の確保位置(単調増加)
+		u64							tail_ = 0;			// 使用中領域の先頭(単調増加)
+		u64							frameStart_ = 0;	// 現在フレームの開始位置
+		std::deque<FrameRegion>		frames_;
+	};	// class RingAllocator
+
+}	// namespace sl12
+
+//	EOF
@@ -31,6 +31,9 @@ namespace sl12
 			UnorderedAccess,
 			Sampler,
 
+			RootConstants,			// 32bitルート定数(テーブルを使用しない)
+			RootConstantBuffer,		// ルートCBV(GPU仮想アドレスで設定する)
+
 			Max
 		};
 	};	// struct RootParameterType
@@ -40,9 +43,10 @@ namespace sl12
 		RootParameterType::Type		type;
 		u32							shaderVisibility;
 		u32							registerIndex;
+		u32							num32BitValues;		// RootConstantsの場合の定数のDWORD数
 
-		RootParameter(RootParameterType::Type t = RootParameterType::ConstantBuffer, u32 shaderVis = ShaderVisibility::All, u32 regIndex = 0)
-			: type(t), shaderVisibility(shaderVis), registerIndex(regIndex)
+		RootParameter(RootParameterType::Type t = RootParameterType::ConstantBuffer, u32 shaderVis = ShaderVisibility::All, u32 regIndex = 0, u32 numValues = 0)
+			: type(t), shaderVisibility(shaderVis), registerIndex(regIndex), num32BitValues(numValues)
 		{}
 	};	// struct RootParameter
 
@@ -51,10 +55,27 @@ namespace sl12
 		u32							numParameters = 0;
 		const RootParameter*		pParameters = nullptr;
 		D3D12_ROOT_SIGNATURE_FLAGS	flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+		bool						useBindless = false;	// pParametersの後ろにバインドレステーブル(SRV, UAVの2パラメータ)を追加する
+		bool						coalesceTables = false;	// 可視性とヒープ種別が同じパラメータを1つのデスクリプタテーブルにまとめる
+		u32									numStaticSamplers = 0;
+		const D3D12_STATIC_SAMPLER_DESC*	pStaticSamplers = nullptr;	// 静的サンプラ(ルートシグネチャのサイズは消費しない)
 	};	// struct RootSignatureDesc
 
+	/*************************************************//**
+	 * @brief パラメータのルートシグネチャ上の配置
+	*****************************************************/
+	struct RootParameterSlot
+	{
+		u32		rootIndex = 0;		// ルートパラメータのインデックス
+		u32		tableOffset = 0;	// テーブル先頭からのデスクリプタオフセット
+	};	// struct RootParameterSlot
+
 	class RootSignature
 	{
+	public:
+		static const u32 kMaxParameters = 64;		// ルートシグネチャのDWORD上限(64)を超えないパラメータ数
+		static const u32 kMaxDWords = 64;			// ルートシグネチャのサイズ上限(DWORD)
+
 	public:
 		RootSignature()
 		{}
@@ -67,11 +88,54 @@ namespace sl12
 		bool Initialize(Device* pDev, const D3D12_ROOT_SIGNATURE_DESC& desc);
 		void Destroy();
 
+		/**
+		 * @brief シリアライズ済みのルートシグネチャから生成する
+		 *
+		 * pSerializedはdescをSerialize()したものであること. シリアライズを省略できる.
+		*/
+		bool Initialize(Device* pDev, const RootSignatureDesc& desc, const void* pSerialized, size_t serializedSize);
+
+		/**
+		 * @brief ルートシグネチャをシリアライズする
+		 *
+		 * 成功した場合は*ppOutBlobにシリアライズ結果を格納する. 呼び出し側で解放すること.
+		*/
+		static bool Serialize(const RootSignatureDesc& desc, ID3DBlob** ppOutBlob);
+
+		/**
+		 * @brief 各パラメータのルートシグネチャ上の配置を計算する
+		 *
+		 * ルート定数、ルートCBVはテーブルを使用せず、先頭から1パラメータずつ配置する.
+		 * coalesceTablesが有効な場合、可視性とヒープ種別(CBV_SRV_UAV, SAMPLER)が同じパラメータを1つのテーブルにまとめる.
+		 * テーブル内は種別、レジスタ番号の順に並べ、連続するレジスタは1つのレンジになる.
+		 * pOutSlotsにはdesc.numParameters個, pOutTableSizesにはルートパラメータ数分の値(テーブル以外は0)が書き込まれる.
+		 * @return ルートパラメータ数(バインドレステーブルは含まない)
+		*/
+		static u32 CalcParameterSlots(const RootSignatureDesc& desc, RootParameterSlot* pOutSlots, u32* pOutTableSizes = nullptr);
+
+		/**
+		 * @brief ルートシグネチャのサイズをDWORD単位で計算する
+		 *
+		 * テーブルは1, ルートCBVは2, ルート定数は定数の数だけ消費する.
+		*/
+		static u32 CalcDWordCount(const RootSignatureDesc& desc);
+
+		/**
+		 * @brief ShaderVisibilityのビットをD3D12の可視性に変換する
+		 *
+		 * 複数のステージが含まれる場合はD3D12_SHADER_VISIBILITY_ALLになる.
+		*/
+		static D3D12_SHADER_VISIBILITY ToD3DShaderVisibility(u32 shaderVisibility);
+
 		// getter
 		ID3D12RootSignature* GetRootSignature() { return pRootSignature_; }
+		u32 GetDWordCount() const { return dwordCount_; }
+		u64 GetHash() const { return hash_; }		// シリアライズ結果のハッシュ値
 
 	private:
 		ID3D12RootSignature*		pRootSignature_{ nullptr };
+		u32							dwordCount_{ 0 };
+		u64							hash_{ 0 };
 	};	// class RootSignature
 
 }	// namespace sl12
@@ -0,0 +1,110 @@
+﻿#pragma once
+
+#include <sl12/root_signature.h>
+#include <map>
+#include <vector>
+
+
+namespace sl12
+{
+	/*************************************************//**
+	 * @brief ルートシグネチャキャッシュのエントリ
+	 *
+	 * シェーダリフレクションの結果とシリアライズ済みのルートシグネチャを保持する.
+	*****************************************************/
+	struct RootSignatureCacheEntry
+	{
+		struct Binding
+		{
+			u32		nameHash;		// バインド名のハッシュ値
+			u32		first;			// paramIndices上の先頭
+			u32		count;			// パラメータ数
+		};	// struct Binding
+
+		u64							contentHash = 0;	// シェーダバイトコードと生成オプションのハッシュ値
+		bool						isGraphics = true;
+		std::vector<RootParameter>	params;				// 昇格、降格済みのパラメータ
+		std::vector<Binding>		bindings;
+		std::vector<u32>			paramIndices;		// バインド名ごとのparamsのインデックス
+		std::vector<D3D12_STATIC_SAMPLER_DESC>	staticSamplers;	// 静的サンプラに昇格したサンプラ
+		std::vector<u8>				serialized;			// シリアライズ済みのルートシグネチャ
+	};	// struct RootSignatureCacheEntry
+
+	/*************************************************//**
+	 * @brief ルートシグネチャのファイルキャッシュ
+	 *
+	 * シェーダバイトコードのハッシュ値をキーとして、リフレクション結果とシリアライズ結果を保存する.
+	 * キャッシュにヒットした場合はD3DReflectとD3D12SerializeRootSignatureを省略できる.
+	 * バイトコードが変わった場合はハッシュ値が一致しないので再生成される.
+	 * フォーマットやルートシグネチャの生成規則を変更した場合はkVersionを更新すること.
+	*****************************************************/
+	class RootSignatureCache
+	{
+	public:
+		static const u32 kMagic = 0x43524c53;		// 'SLRC'
+		static const u32 kVersion = 2;
+
+	public:
+		RootSignatureCache()
+		{}
+		~RootSignatureCache()
+		{
+			Clear();
+		}
+
+		/**
+		 * @brief ファイルから読み込む
+		 *
+		 * ファイルがない、バージョンが異なる、内容が壊れている場合は空のキャッシュになりfalseを返す.
+		*/
+		bool Load(const char* filename);
+
+		/**
+		 * @brief ファイルに保存する
+		 *
+		 * 今回の実行で参照または登録されたエントリのみを保存する.
+		*/
+		bool Save(const char* filename) const;
+
+		/**
+		 * @brief エントリを検索する
+		 *
+		 * キーとハッシュ値の両方が一致した場合のみ返す.
+		*/
+		const RootSignatureCacheEntry* Find(u32 key, u64 contentHash);
+
+		/**
+		 * @brief エントリを登録する
+		*/
+		void Store(u32 key, const RootSignatureCacheEntry& entry);
+
+		/**
+		 * @brief エントリを削除する
+		 *
+		 * キャッシュの内容からルートシグネチャを生成できなかった場合に呼び出す.
+		*/
+		void Remove(u32 key);
+
+		void Clear();
+
+		// getter
+		u32 GetEntryCount() const { return static_cast<u32>(entries_.size()); }
+		u32 GetHitCount() const { return hitCount_; }
+		u32 GetMissCount() const { return missCount_; }
+
+	private:
+		struct Item
+		{
+			RootSignatureCacheEntry		entry;
+			bool						isUsed = false;
+		};	// struct Item
+
+	private:
+		std::map<u32, Item>		entries_;
+		u32						hitCount_ = 0;
+		u32						missCount_ = 0;
+	};	// class RootSignatureCache
+
+}	// namespace sl12
+
+//	EOF
@@ -3,12 +3,18 @@
 #include <sl12/util.h>
 #include <sl12/command_list.h>
 #include <sl12/root_signature.h>
+#include <sl12/root_signature_cache.h>
 #include <sl12/shader.h>
 #include <sl12/buffer_view.h>
 #include <sl12/texture_view.h>
 #include <sl12/sampler.h>
+#include <sl12/static_sampler_registry.h>
+#include <sl12/bindless_descriptor_table.h>
+#include <sl12/crc.h>
+#include <sl12/concurrent_instance_map.h>
 #include <atomic>
 #include <map>
+#include <mutex>
 #include <vector>
 
 
@@ -25,8 +31,46 @@ namespace sl12
 		Shader*		pDS = nullptr;
 		Shader*		pHS = nullptr;
 		Shader*		pCS = nullptr;
+		bool		useBindless = false;	// バインドレステーブルを使用する(スペース1, 2のリソースはテーブルから参照する)
+		u32			maxRootConstants = 0;	// このDWORD数以下の定数バッファはルート定数にする(0の場合はルート定数を使用しない)
+		bool		useRootCbv = false;		// ルート定数にしない定数バッファをルートCBVにする
+		const StaticSamplerRegistry*	pStaticSamplers = nullptr;	// 登録済みの名前のサンプラを静的サンプラにする
 	};	// struct RootSignatureCreateDesc
 
+	class RootSignatureInstance;
+	class RootSignatureManager;
+
+	/*************************************************//**
+	 * @brief バインド名
+	 *
+	 * 名前のハッシュ値のみを保持する.
+	 * constexprで生成すればハッシュ値はコンパイル時に計算される.
+	 * 例: static constexpr BindingName kCbScene("CbScene");
+	*****************************************************/
+	struct BindingName
+	{
+		u32		hash;
+
+		constexpr BindingName(const char* name)
+			: hash(CalcFnv1a32(name))
+		{}
+	};	// struct BindingName
+
+	/*************************************************//**
+	 * @brief 解決済みのバインドスロット
+	 *
+	 * RootSignatureHandle::GetBindingSlot()で事前に解決しておくことで、設定時の検索を省略できる.
+	 * 取得元と同じルートシグネチャでのみ有効.
+	*****************************************************/
+	struct BindingSlot
+	{
+		const RootSignatureInstance*	pOwner = nullptr;
+		u32								first = 0;		// スロット配列上の先頭
+		u32								count = 0;		// スロット数(ステージごとにレジスタが異なる場合は複数)
+
+		bool IsValid() const { return count > 0; }
+	};	// struct BindingSlot
+
 	/*************************************************//**
 	 * @brief ルートシグネチャインスタンス
 	*****************************************************/
@@ -34,6 +78,7 @@ namespace sl12
 	{
 		friend class RootSignatureManager;
 		friend class RootSignatureHandle;
+		template <typename, typename> friend class ConcurrentInstanceMap;
 
 	private:
 		~RootSignatureInstance()
@@ -41,11 +86,31 @@ namespace sl12
 			rootSig_.Destroy();
 		}
 
+		struct NameEntry
+		{
+			u32		hash;			// 名前のハッシュ値
+			u32		first;			// スロット配列上の先頭
+			u32		count;			// スロット数
+		};	// struct NameEntry
+
+		struct ParamInfo
+		{
+			RootParameterType::Type		type;		// パラメータ種別(テーブルの場合は含まれるパラメータの種別のいずれか)
+			u32							start;		// ハンドル配列上の先頭
+			u32							count;		// テーブルのデスクリプタ数(テーブル以外は0)
+		};	// struct ParamInfo
+
+		BindingSlot FindSlot(u32 hash) const;
+
 	private:
-		RootSignature								rootSig_;
-		std::map<std::string, std::vector<int>>		slotMap_;
-		std::atomic<int>							referenceCounter_ = 0;
-		bool										isGraphics_ = true;
+		RootSignature											rootSig_;
+		std::vector<NameEntry>									names_;			// ハッシュ値でソート済み
+		std::vector<RootParameterSlot>							slots_;
+		std::vector<ParamInfo>									params_;
+		u32														numTableDescriptors_ = 0;
+		std::atomic<int>										referenceCounter_{ 0 };
+		bool													isGraphics_ = true;
+		int														bindlessRootIndex_ = -1;
 	};	// struct RootSignatureInstance
 
 	/*************************************************//**
@@ -59,8 +124,8 @@ namespace sl12
 		RootSignatureHandle()
 			: pManager_(nullptr), crc_(0), pInstance_(nullptr)
 		{}
-		RootSignatureHandle(RootSignatureHandle& h)
-			: pManager_(h.pManager_), crc_(h.crc_), pInstance_(h.pInstance_)
+		RootSignatureHandle(const RootSignatureHandle& h)
+			: pManager_(h.pManager_), crc_(h.crc_), pInstance_(h.pInstance_), tableHandles_(h.tableHandles_)
 		{
 			if (pInstance_)
 			{
@@ -72,14 +137,20 @@ namespace sl12
 			Invalid();
 		}
 
-		RootSignatureHandle& operator=(RootSignatureHandle& h)
+		RootSignatureHandle& operator=(const RootSignatureHandle& h)
 		{
-			pManager_ = h.pManager_;
-			crc_ = h.crc_;
-			pInstance_ = h.pInstance_;
-			if (pInstance_)
+			if (this != &h)
 			{
-				pInstance_->referenceCounter_++;
+				// 保持している参照を解放してから差し替える
+				Invalid();
+				pManager_ = h.pManager_;
+				crc_ = h.crc_;
+				pInstance_ = h.pInstance_;
+				tableHandles_ = h.tableHandles_;
+				if (pInstance_)
+				{
+					pInstance_->referenceCounter_++;
+				}
 			}
 			return *this;
 		}
@@ -91,11 +162,61 @@ namespace sl12
 
 		void Invalid();
 
-		bool SetDescriptor(CommandList& cmdList, const char* name, ConstantBufferView& cbv);
-		bool SetDescriptor(CommandList& cmdList, const char* name, TextureView& srv);
-		bool SetDescriptor(CommandList& cmdList, const char* name, BufferView& srv);
-		bool SetDescriptor(CommandList& cmdList, const char* name, Sampler& sam);
-		bool SetDescriptor(CommandList& cmdList, const char* name, UnorderedAccessView& uav);
+		/**
+		 * @brief 名前からバインドスロットを取得する
+		 *
+		 * 名前はハッシュ値でソートした配列から二分探索する.
+		 * 存在しない場合は無効なスロットを返す.
+		*/
+		BindingSlot GetBindingSlot(BindingName name) const;
+
+		bool SetDescriptor(CommandList& cmdList, const BindingSlot& slot, ConstantBufferView& cbv);
+		bool SetDescriptor(CommandList& cmdList, const BindingSlot& slot, TextureView& srv);
+		bool SetDescriptor(CommandList& cmdList, const BindingSlot& slot, BufferView& srv);
+		bool SetDescriptor(CommandList& cmdList, const BindingSlot& slot, Sampler& sam);
+		bool SetDescriptor(CommandList& cmdList, const BindingSlot& slot, UnorderedAccessView& uav);
+
+		// 名前で設定する(文字列の場合は呼び出しごとにハッシュ値を計算する)
+		bool SetDescriptor(CommandList& cmdList, BindingName name, ConstantBufferView& cbv) { return SetDescriptor(cmdList, GetBindingSlot(name), cbv); }
+		bool SetDescriptor(CommandList& cmdList, BindingName name, TextureView& srv) { return SetDescriptor(cmdList, GetBindingSlot(name), srv); }
+		bool SetDescriptor(CommandList& cmdList, BindingName name, BufferView& srv) { return SetDescriptor(cmdList, GetBindingSlot(name), srv); }
+		bool SetDescriptor(CommandList& cmdList, BindingName name, Sampler& sam) { return SetDescriptor(cmdList, GetBindingSlot(name), sam); }
+		bool SetDescriptor(CommandList& cmdList, BindingName name, UnorderedAccessView& uav) { return SetDescriptor(cmdList, GetBindingSlot(name), uav); }
+
+		bool SetBindlessTable(CommandList& cmdList, BindlessDescriptorTable& table);
+
+		/**
+		 * @brief ルート定数を設定する
+		 *
+		 * ルート定数に昇格された定数バッファのみ設定できる.
+		*/
+		bool SetConstants(CommandList& cmdList, const BindingSlot& slot, const void* pData, u32 num32BitValues, u32 offset = 0);
+		bool SetConstants(CommandList& cmdList, BindingName name, const void* pData, u32 num32BitValues, u32 offset = 0)
+		{
+			return SetConstants(cmdList, GetBindingSlot(name), pData, num32BitValues, offset);
+		}
+
+		/**
+		 * @brief ルートCBVをGPU仮想アドレスで設定する
+		 *
+		 * ルートCBVに昇格された定数バッファのみ設定できる.
+		 * ConstantBufferViewを渡す場合はSetDescriptor()でも設定可能.
+		*/
+		bool SetConstantBuffer(CommandList& cmdList, const BindingSlot& slot, D3D12_GPU_VIRTUAL_ADDRESS address);
+		bool SetConstantBuffer(CommandList& cmdList, BindingName name, D3D12_GPU_VIRTUAL_ADDRESS address)
+		{
+			return SetConstantBuffer(cmdList, GetBindingSlot(name), address);
+		}
+
+		/**
+		 * @brief 複数デスクリプタをまとめたテーブルをコマンドリストに設定する
+		 *
+		 * 1デスクリプタのテーブルはSetDescriptor()で即座に設定される.
+		 * まとめたテーブルはSetDescriptor()ではハンドルを記録するのみなので、ルートシグネチャを設定した後、描画前に毎回呼び出すこと.
+		 * テーブルごとに1回のCopyDescriptorsでリングにコピーする.
+		 * フレーム内で同じ並びのテーブルはリングのテーブルキャッシュにより再コピーされない.
+		*/
+		void ApplyDescriptors(CommandList& cmdList);
 
 		RootSignature* GetRootSignature()
 		{
@@ -104,23 +225,32 @@ namespace sl12
 		}
 
 	private:
+		// マネージャから取得した参照をそのまま引き継ぐ(参照カウントは増やさない)
 		RootSignatureHandle(RootSignatureManager* man, u32 crc, RootSignatureInstance* ins)
 			: pManager_(man), crc_(crc), pInstance_(ins)
 		{
 			if (pInstance_)
 			{
-				pInstance_->referenceCounter_++;
+				tableHandles_.resize(pInstance_->numTableDescriptors_);
 			}
 		}
 
+		bool SetTableDescriptor(CommandList& cmdList, const BindingSlot& slot, Descriptor* pDesc, D3D12_GPU_VIRTUAL_ADDRESS address = 0);
+
 	private:
-		RootSignatureManager*		pManager_;
-		u32							crc_;
-		RootSignatureInstance*		pInstance_;
+		RootSignatureManager*						pManager_;
+		u32											crc_;
+		RootSignatureInstance*						pInstance_;
+		std::vector<D3D12_CPU_DESCRIPTOR_HANDLE>	tableHandles_;		// まとめたテーブルに設定するデスクリプタ
 	};	// class RootSignatureHandle
 
 	/*************************************************//**
 	 * @brief ルートシグネチャマネージャ
+	 *
+	 * ルートシグネチャの生成、解放は複数スレッドから呼び出せる.
+	 * 同じシェーダの組み合わせを同時に要求した場合、生成は1回だけ行われる.
+	 * ハンドルのコピーはロックを必要としない.
+	 * LoadCache(), SaveCache(), Destroy()は生成中のスレッドがない状態で呼び出すこと.
 	*****************************************************/
 	class RootSignatureManager
 	{
@@ -140,6 +270,7 @@ namespace sl12
 		 * @brief ルートシグネチャを生成する
 		 *
 		 * 既に生成済みの場合は参照カウントをアップしてハンドルを渡す
+		 * 生成は共有ロックの外で行うので、異なるルートシグネチャは並列に生成される.
 		*/
 		RootSignatureHandle CreateRootSignature(const RootSignatureCreateDesc& desc);
 
@@ -148,9 +279,49 @@ namespace sl12
 		*/
 		void ReleaseRootSignature(u32 crc, RootSignatureInstance* pInst);
 
+		/**
+		 * @brief ファイルキャッシュを読み込む
+		 *
+		 * ルートシグネチャの生成前に呼び出す.
+		 * キャッシュにヒットしたルートシグネチャはリフレクションとシリアライズを省略する.
+		 * 読み込めなかった場合は通常通り生成する.
+		*/
+		bool LoadCache(const char* filename);
+
+		/**
+		 * @brief ファイルキャッシュを保存する
+		 *
+		 * 今回の実行で生成したルートシグネチャのみを保存する.
+		*/
+		bool SaveCache(const char* filename) const;
+
+		/**
+		 * @brief ルートシグネチャのサイズが上限に収まるようにパラメータを降格する
+		 *
+		 * 大きいルート定数から順に降格する. ルートCBV(2DWORD)より大きいルート定数はuseRootCbvの場合ルートCBVに、それ以外はテーブルに戻す.
+		 * ルート定数がなくなった後はルートCBVをテーブルに戻す.
+		 * rsDesc.pParametersはparamsを指すように設定される.
+		 * @return 上限に収まった場合はtrue
+		*/
+		static bool DemoteRootParameters(std::vector<RootParameter>& params, RootSignatureDesc& rsDesc, bool useRootCbv);
+
+		// getter
+		Device* GetDevice() { return pDevice_; }
+		const RootSignatureCache& GetCache() const { return cache_; }
+		u32 GetInstanceCount() const { return instances_.GetCount(); }
+
+	private:
+		RootSignatureInstance* CreateInstanceWithCache(const RootSignatureCreateDesc& desc, u32 crc);
+		bool ReflectShaders(const RootSignatureCreateDesc& desc, RootSignatureCacheEntry& outEntry);
+		RootSignatureInstance* CreateInstance(const RootSignatureCreateDesc& desc, const RootSignatureCacheEntry& entry, std::vector<u8>* pOutSerialized);
+		u64 CalcContentHash(const RootSignatureCreateDesc& desc);
+		bool IsTableCoalesced();
+
 	private:
-		Device*									pDevice_ = nullptr;
-		std::map<u32, RootSignatureInstance*>	instanceMap_;
+		Device*													pDevice_ = nullptr;
+		ConcurrentInstanceMap<u32, RootSignatureInstance>		instances_;
+		RootSignatureCache										cache_;
+		mutable std::mutex										cacheMutex_;
 	};
 }	// namespace sl12
 
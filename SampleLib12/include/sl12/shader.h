@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include <sl12/util.h>
+#include <memory>
 
 
 namespace sl12
@@ -22,6 +23,14 @@ namespace sl12
 		};
 	};	// struct ShaderType
 
+	/*************************************************//**
+	 * @brief シェーダ
+	 *
+	 * バイトコードの保持方法は3通り.
+	 * 通常のInitialize()はバイトコードをコピーして所有する(ファイルから読み込む場合は読み込んだメモリをそのまま所有する).
+	 * InitializeReference()はコピーせずに外部のバイトコードを参照する.
+	 * InitializeShared()は外部のストレージの所有権を共有して参照する.
+	*****************************************************/
 	class Shader
 	{
 	public:
@@ -34,17 +43,41 @@ namespace sl12
 
 		bool Initialize(Device* pDev, ShaderType::Type type, const char* filename);
 		bool Initialize(Device* pDev, ShaderType::Type type, const void* pData, size_t size);
+
+		/**
+		 * @brief 外部のバイトコードを参照して初期化する
+		 *
+		 * コピーしないので、pDataはShaderより長く生存すること.
+		 * 実行ファイルに埋め込まれたバイトコード等に使用する.
+		*/
+		bool InitializeReference(Device* pDev, ShaderType::Type type, const void* pData, size_t size);
+
+		/**
+		 * @brief 外部のストレージの所有権を共有して初期化する
+		 *
+		 * storageはpDataを含むメモリ(メモリマップしたファイル等)を保持するオブジェクト.
+		 * Shaderが破棄されるまでstorageは解放されない.
+		*/
+		bool InitializeShared(Device* pDev, ShaderType::Type type, std::shared_ptr<const void> storage, const void* pData, size_t size);
+
 		void Destroy();
 
 		// getter
 		const void* GetData() const { return pData_; }
 		size_t GetSize() const { return size_; }
 		ShaderType::Type GetShaderType() const { return shaderType_; }
+		u64 GetHash() const { return hash_; }		// バイトコードのハッシュ値
+		bool IsReference() const { return pData_ && !storage_; }	// 外部のバイトコードを所有せずに参照している
+
+	private:
+		bool InitializeCommon(ShaderType::Type type, std::shared_ptr<const void> storage, const void* pData, size_t size);
 
 	private:
-		u8*					pData_{ nullptr };
-		size_t				size_{ 0 };
-		ShaderType::Type	shaderType_{ ShaderType::Max };
+		const u8*					pData_{ nullptr };
+		std::shared_ptr<const void>	storage_{};		// バイトコードを所有、または共有するストレージ
+		size_t						size_{ 0 };
+		ShaderType::Type			shaderType_{ ShaderType::Max };
+		u64							hash_{ 0 };
 	};	// class Shader
 
 }	// namespace sl12
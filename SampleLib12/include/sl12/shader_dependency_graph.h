@@ -0,0 +1,135 @@
+﻿#pragma once
+
+#include <sl12/types.h>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace sl12
+{
+	struct RebuildResult
+	{
+		enum Type
+		{
+			Unchanged,		// 再構築したが結果は変わらなかった(依存するノードは再構築しない)
+			Changed,		// 再構築して結果が変わった
+			Failed,			// 再構築に失敗した
+
+			Max
+		};
+	};	// struct RebuildResult
+
+	/*************************************************//**
+	 * @brief シェーダファイルからルートシグネチャ、PSOへの依存関係
+	 *
+	 * ノードは依存先より後に追加するので、ノードIDの順に処理すれば依存先が先に処理される.
+	 * ファイルノードはシェーダファイルやインクルードファイルに対応し、それ以外のノードは依存するノードのみを持つ.
+	 * インクルードファイルは、それをインクルードするファイルノードの依存先として追加する.
+	 * デバイスを必要としない.
+	*****************************************************/
+	class ShaderDependencyGraph
+	{
+	public:
+		typedef u32 NodeId;
+		static const NodeId kInvalidNode = 0xffffffff;
+
+		typedef std::function<RebuildResult::Type(NodeId)> RebuildFunc;
+
+	public:
+		ShaderDependencyGraph()
+		{}
+		~ShaderDependencyGraph()
+		{}
+
+		/**
+		 * @brief ファイルノードを追加する
+		 *
+		 * 同じファイルのノードが追加済みの場合は失敗する.
+		 * pIncludesにはこのファイルがインクルードするファイルのノードを指定する. 追加済みであること.
+		*/
+		NodeId AddFileNode(const char* filename, const NodeId* pIncludes = nullptr, u32 numIncludes = 0);
+		NodeId AddFileNode(const char* filename, const std::vector<NodeId>& includes)
+		{
+			return AddFileNode(filename, includes.data(), static_cast<u32>(includes.size()));
+		}
+
+		/**
+		 * @brief 依存するノードを指定してノードを追加する
+		 *
+		 * 依存するノードは追加済みであること.
+		*/
+		NodeId AddNode(const NodeId* pDependencies, u32 numDependencies);
+		NodeId AddNode(const std::vector<NodeId>& dependencies)
+		{
+			return AddNode(dependencies.data(), static_cast<u32>(dependencies.size()));
+		}
+
+		/**
+		 * @brief ファイルノードを取り除く
+		 *
+		 * ファイルが削除された場合や、インクルードされなくなった場合に呼び出す.
+		 * 他のノードのIDを変えないよう、ノードは残して依存関係のみを切り離す.
+		 * 取り除いたノードは検索できず、Propagate()で指定しても再構築されない.
+		 * 同じファイルは再度追加できる.
+		*/
+		bool RemoveFile(const char* filename);
+
+		void Clear();
+
+		/**
+		 * @brief ファイル名からファイルノードを検索する
+		*/
+		NodeId FindFile(const char* filename) const;
+
+		/**
+		 * @brief 指定したノードと、それに依存する全てのノードをID順に列挙する
+		*/
+		void CollectAffected(const std::vector<NodeId>& roots, std::vector<NodeId>& outNodes) const;
+
+		/**
+		 * @brief 変更されたノードから依存関係を辿って再構築する
+		 *
+		 * 依存先から順にrebuildを呼び出す.
+		 * 依存するノードがいずれもChangedにならなかったノードは再構築しない.
+		 * Failedが返された時点で中断する.
+		 * @return 全ての再構築に成功した場合はtrue
+		*/
+		bool Propagate(const std::vector<NodeId>& roots, const RebuildFunc& rebuild, std::vector<NodeId>* pRebuiltNodes = nullptr) const;
+
+		/**
+		 * @brief ファイル名を正規化する
+		 *
+		 * 区切り文字を'/'に統一し、英字を小文字にする.
+		*/
+		static std::string NormalizePath(const char* filename);
+
+		// getter
+		u32 GetNodeCount() const { return static_cast<u32>(nodes_.size()); }
+		bool IsFileNode(NodeId id) const { return !nodes_[id].filename.empty() && !nodes_[id].isRemoved; }
+		bool IsRemoved(NodeId id) const { return nodes_[id].isRemoved; }
+		const std::string& GetFilename(NodeId id) const { return nodes_[id].filename; }
+		const std::vector<NodeId>& GetDependencies(NodeId id) const { return nodes_[id].dependencies; }
+		const std::vector<NodeId>& GetDependents(NodeId id) const { return nodes_[id].dependents; }
+
+	private:
+		struct Node
+		{
+			std::string				filename;		// ファイルノードの場合のみ
+			std::vector<NodeId>		dependencies;	// このノードが依存するノード
+			std::vector<NodeId>		dependents;		// このノードに依存するノード
+			bool					isRemoved = false;
+		};	// struct Node
+
+	private:
+		NodeId AddNodeCommon(const std::string& filename, const NodeId* pDependencies, u32 numDependencies);
+
+	private:
+		std::vector<Node>						nodes_;
+		std::unordered_map<std::string, NodeId>	fileMap_;
+	};	// class ShaderDependencyGraph
+
+}	// namespace sl12
+
+//	EOF
@@ -0,0 +1,281 @@
+﻿#pragma once
+
+#include <sl12/util.h>
+#include <sl12/shader.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace sl12
+{
+	class Device;
+
+	/*************************************************//**
+	 * @brief シェーダパッケージに格納するリソースバインディング
+	 *
+	 * D3D12_SHADER_INPUT_BIND_DESCのうち、ルートシグネチャの生成に必要な値のみを保持する.
+	*****************************************************/
+	struct ShaderPackageBinding
+	{
+		const char*		name = nullptr;
+		u32				inputType = 0;		// D3D_SHADER_INPUT_TYPE
+		u32				bindPoint = 0;
+		u32				bindCount = 0;
+		u32				space = 0;
+		u32				dimension = 0;		// D3D_SRV_DIMENSION
+	};	// struct ShaderPackageBinding
+
+	/*************************************************//**
+	 * @brief パッケージに格納したシェーダのソースファイル(.cso)の識別情報
+	 *
+	 * パッケージの作成時に記録し、起動時に現在のファイルと比較してパッケージが古くなっていないか判定する.
+	 * ファイルの内容は読まないので、比較はファイルの属性の取得のみで済む.
+	*****************************************************/
+	struct ShaderSourceStamp
+	{
+		u64		lastWriteTime = 0;		// 最終更新時刻(Windowsは100ns単位のFILETIME、それ以外はナノ秒)
+		u64		size = 0;				// ファイルサイズ. 0の場合は記録なし
+
+		bool IsValid() const { return size != 0; }
+		bool operator==(const ShaderSourceStamp& rhs) const
+		{
+			return (lastWriteTime == rhs.lastWriteTime) && (size == rhs.size);
+		}
+		bool operator!=(const ShaderSourceStamp& rhs) const
+		{
+			return !(*this == rhs);
+		}
+	};	// struct ShaderSourceStamp
+
+	/**
+	 * @brief ファイルの識別情報を取得する
+	 *
+	 * ファイルがない場合はfalseを返す.
+	*/
+	bool GetShaderSourceStamp(const char* filename, ShaderSourceStamp& outStamp);
+
+	/*************************************************//**
+	 * @brief シェーダパッケージのファイルフォーマット
+	 *
+	 * ファイルはリトルエンディアンで、ヘッダ、インデックス、文字列、バインディング、バイトコードの順に並ぶ.
+	 * インデックスは名前のハッシュ値順にソートされ、二分探索で検索する.
+	 * バイトコードはkDataAlignmentに揃えて配置する.
+	 * フォーマットを変更した場合はkVersionを更新すること.
+	*****************************************************/
+	struct ShaderPackageFormat
+	{
+		static const u32 kMagic = 0x50534c53;		// 'SLSP'
+		static const u32 kVersion = 3;
+		static const u32 kDataAlignment = 16;
+
+		enum Flag
+		{
+			HasReflection = 0x01 << 0,
+		};
+
+		struct Header
+		{
+			u32		magic;
+			u32		version;
+			u32		count;
+			u32		dataAlignment;
+		};	// struct Header
+
+		struct Entry
+		{
+			u64		nameHash;
+			u64		bytecodeHash;
+			u64		dataOffset;
+			u32		dataSize;
+			u32		nameOffset;
+			u32		nameLength;
+			u32		shaderType;
+			u32		bindingOffset;
+			u32		bindingCount;
+			u32		flags;
+			u32		reserved;
+			u64		sourceWriteTime;	// ソースファイルの識別情報(ShaderSourceStamp). 記録しない場合は0
+			u64		sourceSize;
+		};	// struct Entry
+
+		struct Binding
+		{
+			u32		nameOffset;
+			u32		inputType;
+			u32		bindPoint;
+			u32		bindCount;
+			u32		space;
+			u32		dimension;
+		};	// struct Binding
+	};	// struct ShaderPackageFormat
+
+	/*************************************************//**
+	 * @brief シェーダパッケージの作成
+	 *
+	 * 追加したシェーダのバイトコード、リフレクション結果、バイトコードのハッシュ値を1つのファイルにまとめる.
+	 * リフレクションに失敗したシェーダはバインディングなしで格納する.
+	 * SetSourceStamp()でソースファイルの識別情報を記録すると、ShaderPackage::IsSourceUpToDate()で更新を検出できる.
+	*****************************************************/
+	class ShaderPackageBuilder
+	{
+	public:
+		ShaderPackageBuilder()
+		{}
+		~ShaderPackageBuilder()
+		{}
+
+		/**
+		 * @brief シェーダを追加する
+		 *
+		 * バイトコードはコピーする.
+		 * 同じ名前のシェーダは追加できない.
+		*/
+		bool AddShader(const char* name, ShaderType::Type type, const void* pData, size_t size);
+
+		/**
+		 * @brief バインディングを指定してシェーダを追加する
+		 *
+		 * リフレクションを行わずに指定したバインディングを格納する.
+		*/
+		bool AddShader(const char* name, ShaderType::Type type, const void* pData, size_t size, const ShaderPackageBinding* pBindings, u32 numBindings);
+
+		/**
+		 * @brief 追加済みのシェーダにソースファイルの識別情報を記録する
+		 *
+		 * バイトコードを読み込む前に取得した識別情報を渡すこと.
+		 * 読み込み中に更新された場合でも、次回の起動時に古いと判定される.
+		*/
+		bool SetSourceStamp(const char* name, const ShaderSourceStamp& stamp);
+
+		void Clear();
+
+		bool Save(const char* filename) const;
+		bool SaveToMemory(std::vector<u8>& outData) const;
+
+		// getter
+		u32 GetCount() const { return static_cast<u32>(entries_.size()); }
+
+	private:
+		struct BindingSource
+		{
+			std::string		name;
+			u32				inputType;
+			u32				bindPoint;
+			u32				bindCount;
+			u32				space;
+			u32				dimension;
+		};	// struct BindingSource
+
+		struct EntrySource
+		{
+			std::string					name;
+			u64							nameHash;
+			ShaderType::Type			type;
+			std::vector<u8>				data;
+			std::vector<BindingSource>	bindings;
+			ShaderSourceStamp			stamp;
+			bool						hasReflection;
+		};	// struct EntrySource
+
+		bool AddEntry(const char* name, ShaderType::Type type, const void* pData, size_t size);
+
+	private:
+		std::vector<EntrySource>	entries_;
+	};	// class ShaderPackageBuilder
+
+	/*************************************************//**
+	 * @brief シェーダパッケージ
+	 *
+	 * パッケージファイルをメモリマップし、バイトコードをコピーせずにShaderを生成する.
+	 * 生成したShaderはマップしたメモリの所有権を共有するので、パッケージを閉じた後も使用できる.
+	 * バイトコードのハッシュ値はShaderの生成時に検証する.
+	*****************************************************/
+	class ShaderPackage
+	{
+	public:
+		static const u32 kInvalidIndex = 0xffffffff;
+
+	public:
+		ShaderPackage()
+		{}
+		~ShaderPackage()
+		{
+			Close();
+		}
+
+		/**
+		 * @brief パッケージファイルを開く
+		 *
+		 * ファイルはメモリマップされ、インデックスのみを検証する.
+		*/
+		bool Open(const char* filename);
+
+		/**
+		 * @brief メモリ上のパッケージを開く
+		 *
+		 * storageはpDataを含むメモリを保持するオブジェクト.
+		*/
+		bool OpenFromMemory(std::shared_ptr<const void> storage, const void* pData, u64 size);
+
+		void Close();
+
+		/**
+		 * @brief 名前からシェーダを検索する
+		 *
+		 * @return インデックス. 見つからない場合はkInvalidIndex
+		*/
+		u32 Find(const char* name) const;
+
+		/**
+		 * @brief パッケージ内のバイトコードを参照するShaderを生成する
+		*/
+		bool CreateShader(Device* pDev, const char* name, Shader& outShader) const;
+		bool CreateShader(Device* pDev, u32 index, Shader& outShader) const;
+
+		/**
+		 * @brief リソースバインディングを取得する
+		*/
+		bool GetBinding(u32 index, u32 bindingIndex, ShaderPackageBinding& outBinding) const;
+
+		/**
+		 * @brief ソースファイルがパッケージの作成後に変更されていないか調べる
+		 *
+		 * ソースファイルがない場合(パッケージのみを配布する場合)はtrueを返す.
+		 * ソースファイルがあり、識別情報が記録されていないか一致しない場合はfalseを返すので、ソースから作り直すこと.
+		*/
+		bool IsSourceUpToDate(u32 index, const char* sourceFile) const;
+
+		// getter
+		bool IsOpened() const { return pEntries_ != nullptr; }
+		u32 GetCount() const { return count_; }
+		const char* GetName(u32 index) const { return GetString(pEntries_[index].nameOffset); }
+		ShaderType::Type GetShaderType(u32 index) const { return static_cast<ShaderType::Type>(pEntries_[index].shaderType); }
+		u64 GetBytecodeHash(u32 index) const { return pEntries_[index].bytecodeHash; }
+		const void* GetBytecode(u32 index) const { return pData_ + pEntries_[index].dataOffset; }
+		size_t GetBytecodeSize(u32 index) const { return pEntries_[index].dataSize; }
+		bool HasReflection(u32 index) const { return (pEntries_[index].flags & ShaderPackageFormat::HasReflection) != 0; }
+		u32 GetBindingCount(u32 index) const { return pEntries_[index].bindingCount; }
+		ShaderSourceStamp GetSourceStamp(u32 index) const
+		{
+			ShaderSourceStamp ret;
+			ret.lastWriteTime = pEntries_[index].sourceWriteTime;
+			ret.size = pEntries_[index].sourceSize;
+			return ret;
+		}
+
+	private:
+		bool Validate();
+		const char* GetString(u32 offset) const { return reinterpret_cast<const char*>(pData_ + offset); }
+
+	private:
+		std::shared_ptr<const void>			storage_{};
+		const u8*							pData_ = nullptr;
+		u64									size_ = 0;
+		const ShaderPackageFormat::Entry*	pEntries_ = nullptr;
+		u32									count_ = 0;
+	};	// class ShaderPackage
+
+}	// namespace sl12
+
+//	EOF
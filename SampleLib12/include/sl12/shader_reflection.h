@@ -0,0 +1,113 @@
+﻿#pragma once
+
+#include <sl12/types.h>
+#include <string>
+#include <vector>
+
+
+namespace sl12
+{
+	/*************************************************//**
+	 * @brief シェーダのリソースバインド
+	 *
+	 * D3D12_SHADER_INPUT_BIND_DESCのうち、ルートシグネチャの生成に必要な値のみを持つ.
+	*****************************************************/
+	struct ShaderBindingDesc
+	{
+		std::string		name;
+		u32				inputType = 0;			// D3D_SHADER_INPUT_TYPE
+		u32				bindPoint = 0;
+		u32				bindCount = 0;			// 上限のない配列は0
+		u32				space = 0;
+		u32				dimension = 0;			// D3D_SRV_DIMENSION
+		u32				constantBufferSize = 0;	// 定数バッファのサイズ(バイト). 定数バッファ以外は0
+	};	// struct ShaderBindingDesc
+
+	/*************************************************//**
+	 * @brief DXBC/DXILコンテナ
+	 *
+	 * fxc, dxcが出力するバイトコードのチャンクテーブルを解析する.
+	 * D3DReflectを使用しないので、Windows以外でも動作する.
+	 * データはコピーしないので、破棄するまでバイトコードを保持すること.
+	 *
+	 * リソースバインドはRDEFチャンク(fxc)またはPSV0チャンク(dxc)から取得する.
+	 * PSV0にはリソース名が含まれないので、名前が必要な場合はD3DReflectを使用すること.
+	*****************************************************/
+	class DxbcContainer
+	{
+	public:
+		static const u32 kFourCCContainer = 0x43425844;		// 'DXBC'
+		static const u32 kFourCCResourceDef = 0x46454452;	// 'RDEF'
+		static const u32 kFourCCPipelineState = 0x30565350;	// 'PSV0'
+		static const u32 kFourCCDxil = 0x4c495844;			// 'DXIL'
+
+	public:
+		DxbcContainer()
+		{}
+		~DxbcContainer()
+		{}
+
+		/**
+		 * @brief コンテナを解析する
+		 *
+		 * ヘッダとチャンクテーブルを検証する. チャンクの内容は取得時に検証する.
+		*/
+		bool Initialize(const void* pData, size_t size);
+		void Destroy();
+
+		/**
+		 * @brief チャンクを検索する
+		 *
+		 * @return チャンクの先頭(ヘッダを除く). 存在しない場合はnullptr
+		*/
+		const u8* FindChunk(u32 fourCC, u32* pSize = nullptr) const;
+		bool HasChunk(u32 fourCC) const { return FindChunk(fourCC) != nullptr; }
+
+		/**
+		 * @brief RDEFチャンクからリソースバインドを取得する
+		 *
+		 * 並び順はD3DReflectのGetResourceBindingDesc()と同じ.
+		 * @return RDEFチャンクが存在しないか、内容が壊れている場合はfalse
+		*/
+		bool GetBindingsFromResourceDef(std::vector<ShaderBindingDesc>& outBindings) const;
+
+		/**
+		 * @brief PSV0チャンクからリソースバインドを取得する
+		 *
+		 * 名前、次元、定数バッファのサイズは取得できない.
+		 * @return PSV0チャンクが存在しないか、内容が壊れている場合はfalse
+		*/
+		bool GetBindingsFromPipelineState(std::vector<ShaderBindingDesc>& outBindings) const;
+
+		// getter
+		bool IsValid() const { return pData_ != nullptr; }
+		bool IsDxil() const { return HasChunk(kFourCCDxil); }
+		u32 GetChunkCount() const { return static_cast<u32>(chunks_.size()); }
+		u32 GetChunkFourCC(u32 index) const { return chunks_[index].fourCC; }
+
+	private:
+		struct Chunk
+		{
+			u32		fourCC;
+			u32		offset;		// データの先頭(ヘッダを除く)
+			u32		size;
+		};	// struct Chunk
+
+	private:
+		const u8*			pData_ = nullptr;
+		size_t				size_ = 0;
+		std::vector<Chunk>	chunks_;
+	};	// class DxbcContainer
+
+	/**
+	 * @brief バイトコードからリソースバインドを取得する
+	 *
+	 * RDEFチャンクがあればDxbcContainerで解析し、なければD3DReflectを使用する.
+	 * D3DReflectはWindowsでのみ使用するので、それ以外ではRDEFチャンクがなければfalseを返す.
+	 * pIsNativeにはD3DReflectを使用しなかった場合にtrueが返る.
+	*/
+	bool ReflectShaderBindings(const void* pData, size_t size, std::vector<ShaderBindingDesc>& outBindings, bool* pIsNative = nullptr);
+
+}	// namespace sl12
+
+//	EOF
@@ -0,0 +1,173 @@
+﻿#pragma once
+
+#include <sl12/util.h>
+#include <sl12/file_watcher.h>
+#include <sl12/shader_dependency_graph.h>
+#include <sl12/shader.h>
+#include <sl12/pipeline_state.h>
+#include <sl12/pipeline_state_cache.h>
+#include <sl12/root_signature_manager.h>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace sl12
+{
+	class Device;
+
+	/*************************************************//**
+	 * @brief シェーダのホットリロード
+	 *
+	 * シェーダファイルの変更を監視し、変更されたシェーダに依存するルートシグネチャとPSOのみを再構築する.
+	 * シェーダがインクルードするファイルを登録した場合は、インクルードファイルの変更でもシェーダを再読み込みする.
+	 * 削除されたファイルは、待ち時間の経過後も存在しなければ監視対象から外す. 読み込み済みのオブジェクトはそのまま使い続ける.
+	 * 再構築は新しいオブジェクトとして行い、全ての再構築に成功した場合のみCommit()で差し替える.
+	 * 失敗した場合は差し替えずに旧オブジェクトを使い続ける.
+	 *
+	 * 登録は依存先から順に行うこと(シェーダ → ルートシグネチャ → PSO).
+	 * 登録したオブジェクトのアドレスは保持するので、破棄するまで移動しないこと.
+	 * PSOの記述子は登録時にコピーする. 入力レイアウトもコピーするので、登録後に破棄してよい.
+	 *
+	 * 使い方:
+	 *   Update()をフレームの先頭で呼び出し、trueが返った場合はGPUの処理完了を待ってからCommit()を呼び出す.
+	 *   Commit()で旧オブジェクトは破棄されるので、旧オブジェクトを参照するコマンドが実行中であってはならない.
+	*****************************************************/
+	class ShaderReloader
+	{
+	public:
+		static const u32 kDefaultSettleTimeMs = 200;
+
+	public:
+		ShaderReloader()
+		{}
+		~ShaderReloader()
+		{
+			Destroy();
+		}
+
+		/**
+		 * @brief 初期化
+		 *
+		 * watchDirectoryを監視し、変更されたファイルをwatchDirectory/相対パスとして扱う.
+		 * 書き込み中のファイルを読み込まないよう、最後の変更からsettleTimeMsが経過したファイルのみを処理する.
+		*/
+		bool Initialize(Device* pDev, RootSignatureManager* pRootSigMan, const char* watchDirectory, u32 settleTimeMs = kDefaultSettleTimeMs);
+		void Destroy();
+
+		/**
+		 * @brief 監視対象を登録する
+		 *
+		 * filenameはシェーダを読み込んだパス.
+		 * includesにはfilenameのソースがインクルードするファイルを指定する. 複数のシェーダが同じファイルをインクルードしてもよい.
+		 * 記述子が参照するシェーダやルートシグネチャのうち、登録済みのものに依存関係を設定する.
+		*/
+		bool RegisterShader(Shader* pShader, const char* filename, const std::vector<std::string>& includes = std::vector<std::string>());
+		bool RegisterRootSignature(RootSignatureHandle* pHandle, const RootSignatureCreateDesc& desc);
+		bool RegisterPipelineState(GraphicsPipelineState* pPSO, const GraphicsPipelineStateDesc& desc, RootSignatureHandle* pRootSig = nullptr);
+		bool RegisterPipelineState(ComputePipelineState* pPSO, const ComputePipelineStateDesc& desc, RootSignatureHandle* pRootSig = nullptr);
+		bool RegisterPipelineState(PipelineStateHandle* pHandle, PipelineStateCache* pCache, const GraphicsPipelineStateDesc& desc, RootSignatureHandle* pRootSig = nullptr);
+		bool RegisterPipelineState(PipelineStateHandle* pHandle, PipelineStateCache* pCache, const ComputePipelineStateDesc& desc, RootSignatureHandle* pRootSig = nullptr);
+
+		/**
+		 * @brief ファイルを変更されたものとして扱う
+		*/
+		void RequestReload(const char* filename);
+
+		/**
+		 * @brief 変更を監視し、依存するオブジェクトを再構築する
+		 *
+		 * @return 差し替え待ちのオブジェクトがある場合はtrue
+		*/
+		bool Update();
+
+		/**
+		 * @brief 再構築したオブジェクトに差し替える
+		 *
+		 * GPUが旧オブジェクトを使用していない状態で呼び出すこと.
+		*/
+		void Commit();
+
+		/**
+		 * @brief 再構築したオブジェクトを破棄する
+		*/
+		void Discard();
+
+		// getter
+		bool HasPendingCommit() const { return !staged_.empty(); }
+		u32 GetCommitCount() const { return commitCount_; }		// 差し替えた回数. BindingSlotを保持している場合はこの値の変化で再取得する
+		u32 GetFailedCount() const { return failedCount_; }
+		const ShaderDependencyGraph& GetGraph() const { return graph_; }
+
+	private:
+		struct TargetType
+		{
+			enum Type
+			{
+				Shader,
+				Include,
+				RootSignature,
+				GraphicsPipeline,
+				ComputePipeline,
+				GraphicsPipelineHandle,
+				ComputePipelineHandle,
+
+				Max
+			};
+		};	// struct TargetType
+
+		struct Target
+		{
+			TargetType::Type						type = TargetType::Max;
+			void*									pLive = nullptr;		// 差し替え対象
+			std::string								filename;				// シェーダとインクルードファイルの場合のみ
+			PipelineStateCache*						pCache = nullptr;
+			RootSignatureHandle*					pRootSig = nullptr;		// PSOが参照するルートシグネチャ
+			RootSignatureCreateDesc					rootSigDesc;
+			GraphicsPipelineStateDesc				graphicsDesc;
+			ComputePipelineStateDesc				computeDesc;
+			std::vector<D3D12_INPUT_ELEMENT_DESC>	elements;
+			std::vector<std::string>				semantics;
+
+			// 再構築したオブジェクト
+			std::unique_ptr<sl12::Shader>			stagedShader;
+			RootSignatureHandle						stagedRootSig;
+			std::unique_ptr<GraphicsPipelineState>	stagedGraphics;
+			std::unique_ptr<ComputePipelineState>	stagedCompute;
+			PipelineStateHandle						stagedHandle;
+		};	// struct Target
+
+		typedef ShaderDependencyGraph::NodeId NodeId;
+
+		bool RegisterGraphics(TargetType::Type type, void* pLive, PipelineStateCache* pCache, const GraphicsPipelineStateDesc& desc, RootSignatureHandle* pRootSig);
+		bool RegisterCompute(TargetType::Type type, void* pLive, PipelineStateCache* pCache, const ComputePipelineStateDesc& desc, RootSignatureHandle* pRootSig);
+		NodeId AddTarget(std::unique_ptr<Target>&& target, const std::vector<NodeId>& dependencies);
+		NodeId AddInclude(const std::string& filename);
+		void AddDependency(std::vector<NodeId>& deps, const void* pLive) const;
+		RebuildResult::Type Rebuild(NodeId id);
+		sl12::Shader* ResolveShader(sl12::Shader* pShader) const;
+		RootSignature* ResolveRootSignature(const Target& target, RootSignature* pDefault);
+		void ClearStaged(Target& target);
+
+	private:
+		typedef std::chrono::steady_clock Clock;
+
+		Device*									pDevice_ = nullptr;
+		RootSignatureManager*					pRootSigMan_ = nullptr;
+		FileWatcher								watcher_;
+		std::string								watchDirectory_;
+		Clock::duration							settleTime_{};
+		ShaderDependencyGraph					graph_;
+		std::vector<std::unique_ptr<Target>>	targets_;		// ノードIDと同じ順
+		std::map<const void*, NodeId>			liveMap_;		// 差し替え対象のアドレスからノードIDを引く
+		std::map<std::string, Clock::time_point>	pendingFiles_;	// 変更されたファイルと最後に変更された時刻
+		std::vector<NodeId>						staged_;		// 差し替え待ちのノード
+		u32										commitCount_ = 0;
+		u32										failedCount_ = 0;
+	};	// class ShaderReloader
+
+}	// namespace sl12
+
+//	EOF
@@ -0,0 +1,167 @@
+﻿#pragma once
+
+#include <sl12/util.h>
+#include <vector>
+
+
+namespace sl12
+{
+	class Device;
+	class Buffer;
+
+	struct ShaderTableKind
+	{
+		enum Type
+		{
+			RayGeneration,
+			Miss,
+			HitGroup,
+			Callable,
+
+			Max
+		};
+	};	// struct ShaderTableKind
+
+	/*************************************************//**
+	 * @brief シェーダテーブルビルダー
+	 *
+	 * レイ生成、ミス、ヒットグループ、コーラブルのシェーダレコードをCPU上でレイアウトし、1つのバッファにまとめる.
+	 * レコードはシェーダIDとローカルルート引数で構成される.
+	 * テーブル内のレコードサイズは最大のレコードに合わせ、D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENTに揃える.
+	 * 各テーブルの先頭はD3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENTに揃える.
+	 * レイ生成シェーダのレコードは1つずつDispatchRaysに渡すため、各レコードの先頭をテーブルアラインメントに揃える.
+	 *
+	 * 使い方は AddRecord() でレコードを登録 → Build() でレイアウトを確定 → Set*() で内容を設定 → Write*() で書き込み.
+	 * Set*() で変更したレコードはダーティになり、WriteDirty() で変更されたレコードのみを書き込める.
+	 * ダーティでないレコードは書き込み先に残っている内容をそのまま使うので、WriteDirty() の書き込み先は
+	 * 直前に WriteAll() で全体を書き込んだのと同じ永続的なメモリ(CreateBuffer() で生成したバッファ等)に限られる.
+	 * UploadRing などから毎回新しく確保した領域には WriteAll() を使用すること.
+	 * デバイスを必要とするのは CreateBuffer() と UploadDirty() のみで、それ以外はCPU上で完結する.
+	*****************************************************/
+	class ShaderTable
+	{
+	public:
+		static const u32 kInvalidIndex = 0xffffffff;
+
+	public:
+		ShaderTable()
+		{}
+		~ShaderTable()
+		{
+			Destroy();
+		}
+
+		/**
+		 * @brief レコードを追加する
+		 *
+		 * Build()の前に呼び出す.
+		 * localArgSizeはローカルルート引数のバイト数.
+		 * @return テーブル内のレコード番号
+		*/
+		u32 AddRecord(ShaderTableKind::Type kind, u32 localArgSize = 0);
+
+		/**
+		 * @brief レイアウトを確定する
+		 *
+		 * レコードの内容はゼロクリアされ、全てのレコードがダーティになる.
+		*/
+		bool Build();
+
+		/**
+		 * @brief 破棄
+		*/
+		void Destroy();
+
+		/**
+		 * @brief レコードの内容を設定する
+		 *
+		 * 内容が変化した場合のみレコードをダーティにする.
+		 * ローカルルート引数はレコードに登録したサイズを超えて書き込めない.
+		*/
+		bool SetShaderIdentifier(ShaderTableKind::Type kind, u32 index, const void* pIdentifier);
+		bool SetLocalArguments(ShaderTableKind::Type kind, u32 index, const void* pData, u32 size, u32 offset = 0);
+		bool SetDescriptorHandle(ShaderTableKind::Type kind, u32 index, u32 slot, D3D12_GPU_DESCRIPTOR_HANDLE handle)
+		{
+			return SetLocalArguments(kind, index, &handle, sizeof(handle), slot * sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
+		}
+
+		/**
+		 * @brief レコードを強制的にダーティにする
+		*/
+		void MarkDirty(ShaderTableKind::Type kind, u32 index);
+		void MarkAllDirty();
+
+		/**
+		 * @brief マップ済みのメモリに書き込む
+		 *
+		 * pDstはGetSize()以上のサイズが必要.
+		 * WriteAll()は全体を、WriteDirty()はダーティなレコードのみを書き込み、ダーティフラグをクリアする.
+		 * WriteAll()は任意の書き込み先に使用できる. リングバッファから確保した領域には常にこちらを使用する.
+		 * WriteDirty()のpDstは、最後にWriteAll()で書き込んだpDstと同じでなければならない(assertで確認する).
+		 * 異なる書き込み先を渡した場合は全体を書き込む.
+		 * @return WriteDirty()は書き込んだレコード数
+		*/
+		void WriteAll(void* pDst);
+		u32 WriteDirty(void* pDst);
+
+		/**
+		 * @brief アップロードバッファを生成して全体を書き込む
+		*/
+		bool CreateBuffer(Device* pDev, Buffer& buffer);
+
+		/**
+		 * @brief ダーティなレコードのみをバッファに書き込む
+		 *
+		 * バッファは直前にCreateBuffer()で生成したものを使用すること(assertで確認する).
+		 * 別のバッファを渡した場合は全体を書き込む.
+		 * GPUが参照中のレコードを書き換えないよう、呼び出し側でフレームの同期を取ること.
+		*/
+		u32 UploadDirty(Buffer& buffer);
+
+		/**
+		 * @brief DispatchRaysの記述子にテーブルを設定する
+		 *
+		 * baseAddressはテーブル全体を書き込んだバッファの先頭アドレス.
+		 * レイ生成シェーダはrayGenIndex番目のレコードを使用する.
+		 * 幅、高さ、深度は変更しない.
+		*/
+		void FillDispatchRaysDesc(D3D12_GPU_VIRTUAL_ADDRESS baseAddress, D3D12_DISPATCH_RAYS_DESC& desc, u32 rayGenIndex = 0) const;
+
+		// getter
+		bool IsBuilt() const { return isBuilt_; }
+		u64 GetSize() const { return image_.size(); }
+		const u8* GetImage() const { return image_.data(); }
+		u32 GetRecordCount(ShaderTableKind::Type kind) const { return static_cast<u32>(tables_[kind].localArgSizes.size()); }
+		u32 GetRecordStride(ShaderTableKind::Type kind) const { return tables_[kind].stride; }
+		u64 GetTableOffset(ShaderTableKind::Type kind) const { return tables_[kind].offset; }
+		u64 GetTableSize(ShaderTableKind::Type kind) const { return tables_[kind].size; }
+		u64 GetRecordOffset(ShaderTableKind::Type kind, u32 index) const { return tables_[kind].offset + static_cast<u64>(tables_[kind].stride) * index; }
+		bool IsDirty(ShaderTableKind::Type kind, u32 index) const { return tables_[kind].dirty[index] != 0; }
+		u32 GetDirtyCount() const { return dirtyCount_; }
+
+	private:
+		struct Table
+		{
+			std::vector<u32>	localArgSizes;
+			std::vector<u8>		dirty;
+			u64					offset = 0;
+			u64					size = 0;
+			u32					stride = 0;
+		};	// struct Table
+
+		bool IsValidRecord(ShaderTableKind::Type kind, u32 index) const;
+		void SetDirty(Table& table, u32 index);
+		void CopyAll(u8* pDst);
+		u32 CopyDirty(u8* pDst, const void* pDstKey);
+
+	private:
+		Table				tables_[ShaderTableKind::Max];
+		std::vector<u8>		image_;
+		u32					dirtyCount_ = 0;
+		const void*			pWrittenDst_ = nullptr;		// 最後に全体を書き込んだ書き込み先(WriteAll()はpDst、CreateBuffer()はバッファ)
+		bool				isBuilt_ = false;
+	};	// class ShaderTable
+
+}	// namespace sl12
+
+//	EOF
@@ -0,0 +1,72 @@
+﻿#pragma once
+
+#include <sl12/util.h>
+#include <vector>
+
+
+namespace sl12
+{
+	/*************************************************//**
+	 * @brief 静的サンプラの登録テーブル
+	 *
+	 * シェーダのサンプラ名と静的サンプラの設定を対応付ける.
+	 * RootSignatureManagerはリフレクションで登録済みの名前のサンプラを見つけると、
+	 * デスクリプタテーブルではなく静的サンプラとしてルートシグネチャに埋め込む.
+	 * 静的サンプラはサンプラヒープを使用せず、描画時の設定も不要になる.
+	 * ルートシグネチャの生成中は登録内容を変更しないこと.
+	*****************************************************/
+	class StaticSamplerRegistry
+	{
+	public:
+		StaticSamplerRegistry()
+		{}
+		~StaticSamplerRegistry()
+		{}
+
+		/**
+		 * @brief サンプラを登録する
+		 *
+		 * 同名の登録は上書きする.
+		 * 境界色は透明な黒、不透明な黒、不透明な白のみ指定できる. それ以外の場合は登録せずにfalseを返す.
+		*/
+		bool Register(const char* name, const D3D12_SAMPLER_DESC& desc);
+
+		/**
+		 * @brief Applicationが生成する4種のサンプラと同じ設定を登録する
+		 *
+		 * samPointWrap, samLinearWrap, samPointClamp, samLinearClamp
+		*/
+		void RegisterDefaults();
+
+		/**
+		 * @brief 名前のハッシュ値から静的サンプラの設定を検索する
+		 *
+		 * レジスタ、スペース、可視性は設定されていない. 見つからない場合はnullptrを返す.
+		*/
+		const D3D12_STATIC_SAMPLER_DESC* Find(u32 nameHash) const;
+
+		void Clear()
+		{
+			entries_.clear();
+			hash_ = 0;
+		}
+
+		// getter
+		u32 GetCount() const { return static_cast<u32>(entries_.size()); }
+		u32 GetHash() const { return hash_; }		// 登録内容のハッシュ値(ルートシグネチャの識別に使用する)
+
+	private:
+		struct Entry
+		{
+			u32							nameHash;
+			D3D12_STATIC_SAMPLER_DESC	desc;
+		};	// struct Entry
+
+	private:
+		std::vector<Entry>		entries_;		// ハッシュ値でソート済み
+		u32						hash_ = 0;
+	};	// class StaticSamplerRegistry
+
+}	// namespace sl12
+
+//	EOF
@@ -9,6 +9,7 @@ namespace sl12
 	class Device;
 	class CommandList;
 	class Swapchain;
+	class UploadRing;
 
 	// テクスチャの次元
 	struct TextureDimension
@@ -58,18 +59,26 @@ namespace sl12
 		bool InitializeFromImageBin(Device* pDev, CommandList* pCmdList, const TextureDesc& desc, const void* pImageBin);
 		bool InitializeFromSwapchain(Device* pDev, Swapchain* pSwapchain, int bufferIndex);
 
-		bool UpdateImage(Device* pDev, CommandList* pCmdList, const DirectX::ScratchImage& image, ID3D12Resource** ppSrcImage);
-		bool UpdateImage(Device* pDev, CommandList* pCmdList, const void* pImageBin, ID3D12Resource** ppSrcImage);
+		/**
+		 * @brief イメージを更新するコピー命令を積む
+		 *
+		 * 実行と待機は行わないので、pCmdListを実行した後にring.Submit()を呼び出すこと.
+		 * pImageBinは先頭のサブリソースのみで、行ピッチはGetCopyableFootprints()の値に合わせること.
+		*/
+		bool UpdateImage(UploadRing& ring, CommandList* pCmdList, const DirectX::ScratchImage& image);
+		bool UpdateImage(UploadRing& ring, CommandList* pCmdList, const void* pImageBin);
 
 		void Destroy();
 
 		// getter
 		ID3D12Resource* GetResourceDep() { return pResource_; }
+		u64 GetResourceId() const { return resourceId_; }		// ビューキャッシュ用の一意なID
 		const TextureDesc& GetTextureDesc() const { return textureDesc_; }
 		const D3D12_RESOURCE_DESC& GetResourceDesc() const { return resourceDesc_; }
 
 	private:
 		ID3D12Resource*			pResource_{ nullptr };
+		u64						resourceId_{ 0 };
 		TextureDesc				textureDesc_{};
 		D3D12_RESOURCE_DESC		resourceDesc_{};
 		D3D12_RESOURCE_STATES	currentState_{ D3D12_RESOURCE_STATE_COMMON };
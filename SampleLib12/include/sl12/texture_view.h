@@ -8,6 +8,7 @@ namespace sl12
 {
 	class Device;
 	class Descriptor;
+	class BindlessDescriptorTable;
 	class Texture;
 	class Buffer;
 
@@ -27,9 +28,12 @@ namespace sl12
 
 		// getter
 		Descriptor* GetDesc() { return pDesc_; }
+		u32 GetBindlessIndex() const { return bindlessIndex_; }		// バインドレステーブルのインデックス(無効時は~0)
 
 	private:
-		Descriptor*	pDesc_{ nullptr };
+		Descriptor*					pDesc_{ nullptr };
+		BindlessDescriptorTable*	pBindlessTable_{ nullptr };
+		u32							bindlessIndex_{ ~0u };
 	};	// class TextureView
 
 
@@ -98,9 +102,12 @@ namespace sl12
 
 		// getter
 		Descriptor* GetDesc() { return pDesc_; }
+		u32 GetBindlessIndex() const { return bindlessIndex_; }		// バインドレステーブルのインデックス(無効時は~0)
 
 	private:
-		Descriptor*	pDesc_{ nullptr };
+		Descriptor*					pDesc_{ nullptr };
+		BindlessDescriptorTable*	pBindlessTable_{ nullptr };
+		u32							bindlessIndex_{ ~0u };
 	};	// class UnorderdAccessView
 
 }	// namespace sl12
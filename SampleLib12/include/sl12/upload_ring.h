@@ -0,0 +1,132 @@
+﻿#pragma once
+
+#include <sl12/util.h>
+#include <sl12/ring_allocator.h>
+#include <sl12/fence.h>
+#include <deque>
+#include <vector>
+
+
+namespace sl12
+{
+	class Device;
+	class CommandList;
+	class CommandQueue;
+
+	/*************************************************//**
+	 * @brief アップロードバッファの確保結果
+	*****************************************************/
+	struct UploadAllocation
+	{
+		ID3D12Resource*	pResource = nullptr;	// コピー元に指定するリソース
+		u64				offset = 0;				// pResource内のオフセット
+		u8*				pCpuAddress = nullptr;	// 書き込み先(マップ済み)
+		u64				size = 0;
+
+		bool IsValid() const { return pResource != nullptr; }
+	};	// struct UploadAllocation
+
+	/*************************************************//**
+	 * @brief リングバッファ方式のアップロードアロケータ
+	 *
+	 * 永続的にマップしたアップロードバッファをRingAllocatorで切り出して、
+	 * CPUからGPUリソースへのコピー元として使用する.
+	 * コピー命令は呼び出し側のコマンドリストに積むだけなので、複数のコピーをまとめて実行できる.
+	 *
+	 * 使い方:
+	 *   Copy系の関数でコマンドを積み、コマンドリストを実行した後にSubmit()を呼び出す.
+	 *   Submit()までに確保した領域はそのフェンス値でタグ付けされ、GPUが到達した後のReclaim()で再利用される.
+	 *   リングに空きがない場合は専用のアップロードバッファを作成し、同様にフェンス到達後に解放する.
+	 *
+	 * スレッドセーフではないので、描画スレッドからのみ使用すること.
+	 * フェンス値は呼び出し順に到達する必要があるので、Submit()には同じキューを指定すること.
+	*****************************************************/
+	class UploadRing
+	{
+	public:
+		static const u64 kDefaultSize = 32 * 1024 * 1024;
+		static const u64 kDefaultAlignment = 16;
+
+	public:
+		UploadRing()
+		{}
+		~UploadRing()
+		{
+			Destroy();
+		}
+
+		bool Initialize(Device* pDev, u64 size = kDefaultSize);
+		void Destroy();
+
+		/**
+		 * @brief アップロード領域を確保する
+		 *
+		 * alignmentは2の累乗であること. 確保した領域はSubmit()を呼び出すまで再利用されない.
+		*/
+		UploadAllocation Allocate(u64 size, u64 alignment = kDefaultAlignment);
+
+		/**
+		 * @brief バッファへのコピー命令を積む
+		 *
+		 * pDstはCOPY_DEST状態であること.
+		*/
+		bool CopyToBuffer(CommandList* pCmdList, ID3D12Resource* pDst, u64 dstOffset, const void* pData, u64 size);
+
+		/**
+		 * @brief テクスチャへのコピー命令を積む
+		 *
+		 * pSrcDataはサブリソースごとの元データ. 行ピッチはフットプリントに合わせて詰め直す.
+		*/
+		bool CopyToTexture(CommandList* pCmdList, ID3D12Resource* pDst, u32 firstSubresource, u32 numSubresources, const D3D12_SUBRESOURCE_DATA* pSrcData);
+
+		/**
+		 * @brief 確保済みの領域をフェンス値でタグ付けする
+		 *
+		 * 確保した領域を参照するコマンドリストをpQueueで実行した後に呼び出すこと.
+		 * @return シグナルしたフェンス値
+		*/
+		u32 Submit(CommandQueue* pQueue);
+
+		/**
+		 * @brief GPUが完了した領域を回収する
+		 *
+		 * 待機はしない.
+		*/
+		void Reclaim();
+
+		/**
+		 * @brief Submit()した全ての領域の完了を待って回収する
+		*/
+		void WaitIdle();
+
+		// getter
+		Device* GetDevice() { return pDevice_; }
+		u64 GetSize() const { return ring_.GetSize(); }
+		u64 GetUsedSize() const { return ring_.GetUsedSize(); }
+		u64 GetHighWaterMark() const { return highWaterMark_; }
+		u32 GetOverflowCount() const { return overflowCount_; }		// リングに収まらず専用バッファを作成した回数
+
+	private:
+		struct DedicatedBuffer
+		{
+			ID3D12Resource*	pResource;
+			u64				fenceValue;
+		};	// struct DedicatedBuffer
+
+		ID3D12Resource* CreateUploadBuffer(u64 size);
+
+	private:
+		Device*							pDevice_ = nullptr;
+		ID3D12Resource*					pResource_ = nullptr;
+		u8*								pMappedData_ = nullptr;
+		RingAllocator					ring_;
+		Fence							fence_;
+		std::vector<ID3D12Resource*>	unsubmittedBuffers_;	// Submit()前の専用バッファ
+		std::deque<DedicatedBuffer>		dedicatedBuffers_;		// GPUの完了待ちの専用バッファ
+		u64								highWaterMark_ = 0;
+		u32								overflowCount_ = 0;
+	};	// class UploadRing
+
+}	// namespace sl12
+
+//	EOF
@@ -81,7 +81,13 @@ namespace sl12
 		// D3D12foCX̏
 		std::array<uint32_t, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> kDescNums
 		{ 65535, 128, 256, 64 };
-		auto isInitDevice = device_.Initialize(hWnd_, screenWidth, screenHeight, kDescNums);
+		std::array<DescriptorHeapLayout, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> kDescLayouts;
+		kDescLayouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].numRanges = 16384;		// fXNv^e[up̘Ä
+		kDescLayouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].numTransients = 8192;		// t[Pʂ̈ꎞfXNv^
+		kDescLayouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].enableViewCache = true;
+		kDescLayouts[D3D12_DESCRIPTOR_HEAP_TYPE_RTV].enableViewCache = true;
+		kDescLayouts[D3D12_DESCRIPTOR_HEAP_TYPE_DSV].enableViewCache = true;
+		auto isInitDevice = device_.Initialize(hWnd_, screenWidth, screenHeight, kDescNums, kDescLayouts);
 		assert(isInitDevice);
 
 		// 悭gTv[Ă
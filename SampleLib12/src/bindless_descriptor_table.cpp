@@ -0,0 +1,122 @@
+﻿#include <sl12/bindless_descriptor_table.h>
+
+#include <sl12/device.h>
+#include <sl12/command_list.h>
+#include <climits>
+
+
+namespace sl12
+{
+	const u32 BindlessDescriptorTable::kInvalidIndex;
+
+	//----
+	bool BindlessDescriptorTable::Initialize(Device* pDev, u32 capacity)
+	{
+		if (!pDev || (capacity == 0))
+		{
+			return false;
+		}
+
+		// 連続領域から確保する
+		range_ = pDev->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).AllocateRange(capacity);
+		if (!range_.IsValid())
+		{
+			return false;
+		}
+
+		pDevice_ = pDev;
+		indexAllocator_.Initialize(capacity);
+
+		return true;
+	}
+
+	//----
+	void BindlessDescriptorTable::Destroy()
+	{
+		if (pDevice_)
+		{
+			pDevice_->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).FreeRange(range_);
+			range_ = DescriptorRange();
+			indexAllocator_.Destroy();
+			pDevice_ = nullptr;
+		}
+	}
+
+	//----
+	u32 BindlessDescriptorTable::Register(const std::function<void(D3D12_CPU_DESCRIPTOR_HANDLE)>& createFunc)
+	{
+		u32 index;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			index = indexAllocator_.Allocate();
+		}
+		if (index == kInvalidIndex)
+		{
+			return kInvalidIndex;
+		}
+
+		createFunc(range_.GetCpuHandle(index));
+		return index;
+	}
+
+	//----
+	void BindlessDescriptorTable::Release(u32 index)
+	{
+		if (index == kInvalidIndex)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		indexAllocator_.Free(index);
+	}
+
+	//----
+	void BindlessDescriptorTable::EndFrame(u64 completedFenceValue, u64 nextFenceValue)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		indexAllocator_.Reclaim(completedFenceValue);
+		indexAllocator_.EndFrame(nextFenceValue);
+	}
+
+	//----
+	void BindlessDescriptorTable::GetRootParameters(D3D12_DESCRIPTOR_RANGE* pRanges, D3D12_ROOT_PARAMETER* pParams)
+	{
+		static const D3D12_DESCRIPTOR_RANGE_TYPE kTypes[] = {
+			D3D12_DESCRIPTOR_RANGE_TYPE_SRV,
+			D3D12_DESCRIPTOR_RANGE_TYPE_UAV,
+		};
+		static const u32 kSpaces[] = { kSrvSpace, kUavSpace };
+
+		for (u32 i = 0; i < 2; i++)
+		{
+			pRanges[i].RangeType = kTypes[i];
+			pRanges[i].NumDescriptors = UINT_MAX;
+			pRanges[i].BaseShaderRegister = 0;
+			pRanges[i].RegisterSpace = kSpaces[i];
+			pRanges[i].OffsetInDescriptorsFromTableStart = 0;
+
+			pParams[i].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+			pParams[i].DescriptorTable.NumDescriptorRanges = 1;
+			pParams[i].DescriptorTable.pDescriptorRanges = &pRanges[i];
+			pParams[i].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		}
+	}
+
+	//----
+	void BindlessDescriptorTable::SetGraphicsRootTables(CommandList& cmdList, u32 rootIndex)
+	{
+		cmdList.SetGraphicsRootDescriptorTable(rootIndex + 0, range_.gpuHandle);
+		cmdList.SetGraphicsRootDescriptorTable(rootIndex + 1, range_.gpuHandle);
+	}
+
+	//----
+	void BindlessDescriptorTable::SetComputeRootTables(CommandList& cmdList, u32 rootIndex)
+	{
+		cmdList.SetComputeRootDescriptorTable(rootIndex + 0, range_.gpuHandle);
+		cmdList.SetComputeRootDescriptorTable(rootIndex + 1, range_.gpuHandle);
+	}
+
+}	// namespace sl12
+
+//	EOF
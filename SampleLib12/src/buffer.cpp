@@ -2,7 +2,8 @@
 
 #include <sl12/device.h>
 #include <sl12/command_list.h>
-#include <sl12/fence.h>
+#include <sl12/upload_ring.h>
+#include <sl12/descriptor_view_cache.h>
 
 
 namespace sl12
@@ -71,6 +72,7 @@ namespace sl12
 			return false;
 		}
 
+		resourceId_ = IssueResourceId();
 		resourceDesc_ = desc;
 		heapProp_ = prop;
 		size_ = size;
@@ -84,6 +86,7 @@ namespace sl12
 	void Buffer::Destroy()
 	{
 		SafeRelease(pResource_);
+		resourceId_ = 0;
 	}
 
 	//----
@@ -110,30 +113,52 @@ namespace sl12
 		}
 		else
 		{
-			Buffer src;
-			if (!src.Initialize(pDev, size, stride_, bufferUsage_, true, false))
-			{
-				return;
-			}
-			src.UpdateBuffer(pDev, pCmdList, pData, size, 0);
+			UploadRing& ring = pDev->GetUploadRing();
 
 			pCmdList->Reset();
-			pCmdList->GetCommandList()->CopyBufferRegion(pResource_, offset, src.pResource_, 0, size);
+			bool isRecorded = RecordUpdate(ring, pCmdList, pData, size, offset);
 			pCmdList->Close();
-			pCmdList->Execute();
-
-			Fence fence;
-			if (!fence.Initialize(pDev))
+			if (!isRecorded)
 			{
 				return;
 			}
-			fence.Signal(pCmdList->GetParentQueue(), 1);
-			fence.WaitSignal(1);
+			pCmdList->Execute();
+
+			ring.Submit(pCmdList->GetParentQueue());
+			ring.WaitIdle();
+		}
 
-			fence.Destroy();
-			src.Destroy();
+	}
+
+	//----
+	bool Buffer::RecordUpdate(UploadRing& ring, CommandList* pCmdList, const void* pData, size_t size, size_t offset)
+	{
+		if (!pCmdList)
+		{
+			return false;
+		}
+		if (!pData || !size)
+		{
+			return false;
+		}
+		if (offset + size > size_)
+		{
+			return false;
+		}
+
+		if (heapProp_.Type == D3D12_HEAP_TYPE_UPLOAD)
+		{
+			u8* p = reinterpret_cast<u8*>(Map(pCmdList));
+			if (!p)
+			{
+				return false;
+			}
+			memcpy(p + offset, pData, size);
+			Unmap();
+			return true;
 		}
 
+		return ring.CopyToBuffer(pCmdList, pResource_, offset, pData, size);
 	}
 
 	//----
@@ -3,6 +3,8 @@
 #include <sl12/device.h>
 #include <sl12/descriptor.h>
 #include <sl12/descriptor_heap.h>
+#include <sl12/descriptor_view_cache.h>
+#include <sl12/bindless_descriptor_table.h>
 #include <sl12/buffer.h>
 
 
@@ -24,16 +26,20 @@ namespace sl12
 			return false;
 		}
 
-		pDesc_ = pDev->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).CreateDescriptor();
+		D3D12_CONSTANT_BUFFER_VIEW_DESC viewDesc{};
+		viewDesc.BufferLocation = pBuffer->GetResourceDep()->GetGPUVirtualAddress();
+		viewDesc.SizeInBytes = static_cast<u32>(pBuffer->GetResourceDesc().Width);
+
+		DescriptorViewKey key(DescriptorViewKey::CBV, pBuffer->GetResourceId(), viewDesc);
+		pDesc_ = pDev->GetViewDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).CreateViewDescriptor(key, [&](D3D12_CPU_DESCRIPTOR_HANDLE handle)
+		{
+			pDev->GetDeviceDep()->CreateConstantBufferView(&viewDesc, handle);
+		});
 		if (!pDesc_)
 		{
 			return false;
 		}
-
-		D3D12_CONSTANT_BUFFER_VIEW_DESC viewDesc{};
-		viewDesc.BufferLocation = pBuffer->GetResourceDep()->GetGPUVirtualAddress();
-		viewDesc.SizeInBytes = static_cast<u32>(pBuffer->GetResourceDesc().Width);
-		pDev->GetDeviceDep()->CreateConstantBufferView(&viewDesc, pDesc_->GetCpuHandle());
+		bufferLocation_ = viewDesc.BufferLocation;
 
 		return true;
 	}
@@ -42,6 +48,7 @@ namespace sl12
 	void ConstantBufferView::Destroy()
 	{
 		SafeRelease(pDesc_);
+		bufferLocation_ = 0;
 	}
 
 
@@ -117,13 +124,23 @@ namespace sl12
 			viewDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
 		}
 
-		pDesc_ = pDev->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).CreateDescriptor();
+		auto createFunc = [&](D3D12_CPU_DESCRIPTOR_HANDLE handle)
+		{
+			pDev->GetDeviceDep()->CreateShaderResourceView(pBuffer->GetResourceDep(), &viewDesc, handle);
+		};
+		DescriptorViewKey key(DescriptorViewKey::SRV, pBuffer->GetResourceId(), viewDesc);
+		pDesc_ = pDev->GetViewDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).CreateViewDescriptor(key, createFunc);
 		if (!pDesc_)
 		{
 			return false;
 		}
 
-		pDev->GetDeviceDep()->CreateShaderResourceView(pBuffer->GetResourceDep(), &viewDesc, pDesc_->GetCpuHandle());
+		// バインドレステーブルが有効なら固定インデックスを割り当てる
+		pBindlessTable_ = pDev->GetBindlessTable();
+		if (pBindlessTable_)
+		{
+			bindlessIndex_ = pDesc_->GetParentHeap()->RegisterBindlessView(pDesc_, createFunc);
+		}
 
 		return true;
 	}
@@ -131,6 +148,12 @@ namespace sl12
 	//----
 	void BufferView::Destroy()
 	{
+		if (pBindlessTable_)
+		{
+			pDesc_->GetParentHeap()->ReleaseBindlessView(pDesc_, bindlessIndex_);
+			pBindlessTable_ = nullptr;
+			bindlessIndex_ = BindlessDescriptorTable::kInvalidIndex;
+		}
 		SafeRelease(pDesc_);
 	}
 
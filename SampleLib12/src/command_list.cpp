@@ -54,6 +54,8 @@ namespace sl12
 
 		hr = pCmdList_->Reset(pCmdAllocator_, nullptr);
 		assert(SUCCEEDED(hr));
+
+		stateCache_.Invalidate();
 	}
 
 	//----
@@ -180,6 +182,118 @@ namespace sl12
 		}
 	}
 
+	//----
+	void CommandList::SetPipelineState(ID3D12PipelineState* pPso)
+	{
+		if (stateCache_.SetPipelineState(pPso))
+			pCmdList_->SetPipelineState(pPso);
+	}
+
+	//----
+	void CommandList::SetGraphicsRootSignature(ID3D12RootSignature* pRootSig)
+	{
+		if (stateCache_.SetGraphicsRootSignature(pRootSig))
+			pCmdList_->SetGraphicsRootSignature(pRootSig);
+	}
+
+	//----
+	void CommandList::SetComputeRootSignature(ID3D12RootSignature* pRootSig)
+	{
+		if (stateCache_.SetComputeRootSignature(pRootSig))
+			pCmdList_->SetComputeRootSignature(pRootSig);
+	}
+
+	//----
+	void CommandList::SetGraphicsRootDescriptorTable(u32 rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE handle)
+	{
+		if (stateCache_.SetGraphicsRootArgument(rootIndex, handle.ptr))
+			pCmdList_->SetGraphicsRootDescriptorTable(rootIndex, handle);
+	}
+
+	//----
+	void CommandList::SetComputeRootDescriptorTable(u32 rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE handle)
+	{
+		if (stateCache_.SetComputeRootArgument(rootIndex, handle.ptr))
+			pCmdList_->SetComputeRootDescriptorTable(rootIndex, handle);
+	}
+
+	//----
+	void CommandList::SetGraphicsRootConstantBufferView(u32 rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address)
+	{
+		if (stateCache_.SetGraphicsRootArgument(rootIndex, address))
+			pCmdList_->SetGraphicsRootConstantBufferView(rootIndex, address);
+	}
+
+	//----
+	void CommandList::SetComputeRootConstantBufferView(u32 rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address)
+	{
+		if (stateCache_.SetComputeRootArgument(rootIndex, address))
+			pCmdList_->SetComputeRootConstantBufferView(rootIndex, address);
+	}
+
+	//----
+	void CommandList::SetGraphicsRoot32BitConstants(u32 rootIndex, u32 num32BitValues, const void* pData, u32 offset)
+	{
+		if (stateCache_.SetGraphicsRootConstants(rootIndex))
+			pCmdList_->SetGraphicsRoot32BitConstants(rootIndex, num32BitValues, pData, offset);
+	}
+
+	//----
+	void CommandList::SetComputeRoot32BitConstants(u32 rootIndex, u32 num32BitValues, const void* pData, u32 offset)
+	{
+		if (stateCache_.SetComputeRootConstants(rootIndex))
+			pCmdList_->SetComputeRoot32BitConstants(rootIndex, num32BitValues, pData, offset);
+	}
+
+	//----
+	void CommandList::SetDescriptorHeaps(u32 numHeaps, ID3D12DescriptorHeap* const* ppHeaps)
+	{
+		if (stateCache_.SetDescriptorHeaps(numHeaps, ppHeaps))
+			pCmdList_->SetDescriptorHeaps(numHeaps, ppHeaps);
+	}
+
+	//----
+	void CommandList::IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology)
+	{
+		if (stateCache_.IASetPrimitiveTopology(topology))
+			pCmdList_->IASetPrimitiveTopology(topology);
+	}
+
+	//----
+	void CommandList::IASetVertexBuffers(u32 startSlot, u32 numViews, const D3D12_VERTEX_BUFFER_VIEW* pViews)
+	{
+		if (stateCache_.IASetVertexBuffers(startSlot, numViews, pViews))
+			pCmdList_->IASetVertexBuffers(startSlot, numViews, pViews);
+	}
+
+	//----
+	void CommandList::IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* pView)
+	{
+		if (stateCache_.IASetIndexBuffer(pView))
+			pCmdList_->IASetIndexBuffer(pView);
+	}
+
+	//----
+	void CommandList::RSSetViewports(u32 numViewports, const D3D12_VIEWPORT* pViewports)
+	{
+		if (stateCache_.RSSetViewports(numViewports, pViewports))
+			pCmdList_->RSSetViewports(numViewports, pViewports);
+	}
+
+	//----
+	void CommandList::RSSetScissorRects(u32 numRects, const D3D12_RECT* pRects)
+	{
+		if (stateCache_.RSSetScissorRects(numRects, pRects))
+			pCmdList_->RSSetScissorRects(numRects, pRects);
+	}
+
+	//----
+	void CommandList::OMSetRenderTargets(u32 numRtvs, const D3D12_CPU_DESCRIPTOR_HANDLE* pRtvs, BOOL singleHandle, const D3D12_CPU_DESCRIPTOR_HANDLE* pDsv)
+	{
+		if (stateCache_.OMSetRenderTargets(numRtvs, pRtvs, singleHandle, pDsv))
+			pCmdList_->OMSetRenderTargets(numRtvs, pRtvs, singleHandle, pDsv);
+	}
+
 }	// namespace sl12
 
 //	EOF
@@ -0,0 +1,273 @@
+﻿#include <sl12/command_state_cache.h>
+
+#include <cstring>
+
+
+namespace sl12
+{
+	namespace
+	{
+		template <typename T>
+		bool IsSameArray(const T* a, const T* b, u32 count)
+		{
+			return memcmp(a, b, sizeof(T) * count) == 0;
+		}
+	}
+
+	const u32 CommandStateCache::kMaxRootParameters;
+	const u32 CommandStateCache::kMaxVertexBuffers;
+	const u32 CommandStateCache::kMaxViewports;
+	const u32 CommandStateCache::kMaxRenderTargets;
+	const u32 CommandStateCache::kMaxDescriptorHeaps;
+	const u32 CommandStateCache::kInvalidCount;
+
+	//----
+	void CommandStateCache::Invalidate()
+	{
+		pPso_ = nullptr;
+		psoValid_ = false;
+		graphicsArgs_.pRootSig = nullptr;
+		graphicsArgs_.validMask = 0;
+		computeArgs_.pRootSig = nullptr;
+		computeArgs_.validMask = 0;
+		numHeaps_ = kInvalidCount;
+
+		topologyValid_ = false;
+		vbValidMask_ = 0;
+		ibValid_ = false;
+
+		numViewports_ = kInvalidCount;
+		numScissors_ = kInvalidCount;
+
+		rtValid_ = false;
+	}
+
+	//----
+	bool CommandStateCache::SetPipelineState(ID3D12PipelineState* pPso)
+	{
+		if (!enabled_)
+			return Result(true);
+
+		if (psoValid_ && pPso_ == pPso)
+			return Result(false);
+
+		pPso_ = pPso;
+		psoValid_ = true;
+		return Result(true);
+	}
+
+	//----
+	bool CommandStateCache::SetRootSignature(RootArguments& args, ID3D12RootSignature* pRootSig)
+	{
+		if (!enabled_)
+			return Result(true);
+
+		if (args.pRootSig == pRootSig && pRootSig != nullptr)
+			return Result(false);
+
+		// ルートシグネチャが変わるとルート引数は全て無効になる
+		args.pRootSig = pRootSig;
+		args.validMask = 0;
+		return Result(true);
+	}
+
+	//----
+	bool CommandStateCache::SetGraphicsRootSignature(ID3D12RootSignature* pRootSig)
+	{
+		return SetRootSignature(graphicsArgs_, pRootSig);
+	}
+
+	//----
+	bool CommandStateCache::SetComputeRootSignature(ID3D12RootSignature* pRootSig)
+	{
+		return SetRootSignature(computeArgs_, pRootSig);
+	}
+
+	//----
+	bool CommandStateCache::SetRootArgument(RootArguments& args, u32 rootIndex, u64 value)
+	{
+		if (!enabled_ || rootIndex >= kMaxRootParameters)
+			return Result(true);
+
+		u64 bit = 0x01ull << rootIndex;
+		if ((args.validMask & bit) && args.values[rootIndex] == value)
+			return Result(false);
+
+		args.values[rootIndex] = value;
+		args.validMask |= bit;
+		return Result(true);
+	}
+
+	//----
+	bool CommandStateCache::SetGraphicsRootArgument(u32 rootIndex, u64 value)
+	{
+		return SetRootArgument(graphicsArgs_, rootIndex, value);
+	}
+
+	//----
+	bool CommandStateCache::SetComputeRootArgument(u32 rootIndex, u64 value)
+	{
+		return SetRootArgument(computeArgs_, rootIndex, value);
+	}
+
+	//----
+	bool CommandStateCache::SetRootConstants(RootArguments& args, u32 rootIndex)
+	{
+		// 定数の内容は比較しないので、このルート引数は不明状態にする
+		if (rootIndex < kMaxRootParameters)
+			args.validMask &= ~(0x01ull << rootIndex);
+		return Result(true);
+	}
+
+	//----
+	bool CommandStateCache::SetGraphicsRootConstants(u32 rootIndex)
+	{
+		return SetRootConstants(graphicsArgs_, rootIndex);
+	}
+
+	//----
+	bool CommandStateCache::SetComputeRootConstants(u32 rootIndex)
+	{
+		return SetRootConstants(computeArgs_, rootIndex);
+	}
+
+	//----
+	bool CommandStateCache::SetDescriptorHeaps(u32 numHeaps, ID3D12DescriptorHeap* const* ppHeaps)
+	{
+		if (!enabled_ || numHeaps > kMaxDescriptorHeaps)
+		{
+			Invalidate();
+			return Result(true);
+		}
+
+		if (numHeaps_ == numHeaps && IsSameArray(pHeaps_, ppHeaps, numHeaps))
+			return Result(false);
+
+		// ヒープが変わるとデスクリプタテーブルの内容は保証されない
+		numHeaps_ = numHeaps;
+		memcpy(pHeaps_, ppHeaps, sizeof(ID3D12DescriptorHeap*) * numHeaps);
+		graphicsArgs_.validMask = 0;
+		computeArgs_.validMask = 0;
+		return Result(true);
+	}
+
+	//----
+	bool CommandStateCache::IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology)
+	{
+		if (!enabled_)
+			return Result(true);
+
+		if (topologyValid_ && topology_ == topology)
+			return Result(false);
+
+		topology_ = topology;
+		topologyValid_ = true;
+		return Result(true);
+	}
+
+	//----
+	bool CommandStateCache::IASetVertexBuffers(u32 startSlot, u32 numViews, const D3D12_VERTEX_BUFFER_VIEW* pViews)
+	{
+		if (!enabled_ || startSlot + numViews > kMaxVertexBuffers)
+			return Result(true);
+
+		// nullptrの場合は指定スロットを解除する
+		D3D12_VERTEX_BUFFER_VIEW nullViews[kMaxVertexBuffers]{};
+		if (!pViews)
+			pViews = nullViews;
+
+		u32 mask = (numViews >= 32) ? ~0u : (((0x01u << numViews) - 1) << startSlot);
+		if ((vbValidMask_ & mask) == mask && IsSameArray(vbViews_ + startSlot, pViews, numViews))
+			return Result(false);
+
+		memcpy(vbViews_ + startSlot, pViews, sizeof(D3D12_VERTEX_BUFFER_VIEW) * numViews);
+		vbValidMask_ |= mask;
+		return Result(true);
+	}
+
+	//----
+	bool CommandStateCache::IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* pView)
+	{
+		if (!enabled_)
+			return Result(true);
+
+		D3D12_INDEX_BUFFER_VIEW view{};
+		if (pView)
+			view = *pView;
+
+		if (ibValid_ && IsSameArray(&ibView_, &view, 1))
+			return Result(false);
+
+		ibView_ = view;
+		ibValid_ = true;
+		return Result(true);
+	}
+
+	//----
+	bool CommandStateCache::RSSetViewports(u32 numViewports, const D3D12_VIEWPORT* pViewports)
+	{
+		if (!enabled_ || numViewports > kMaxViewports)
+		{
+			numViewports_ = kInvalidCount;
+			return Result(true);
+		}
+
+		if (numViewports_ == numViewports && IsSameArray(viewports_, pViewports, numViewports))
+			return Result(false);
+
+		numViewports_ = numViewports;
+		memcpy(viewports_, pViewports, sizeof(D3D12_VIEWPORT) * numViewports);
+		return Result(true);
+	}
+
+	//----
+	bool CommandStateCache::RSSetScissorRects(u32 numRects, const D3D12_RECT* pRects)
+	{
+		if (!enabled_ || numRects > kMaxViewports)
+		{
+			numScissors_ = kInvalidCount;
+			return Result(true);
+		}
+
+		if (numScissors_ == numRects && IsSameArray(scissors_, pRects, numRects))
+			return Result(false);
+
+		numScissors_ = numRects;
+		memcpy(scissors_, pRects, sizeof(D3D12_RECT) * numRects);
+		return Result(true);
+	}
+
+	//----
+	bool CommandStateCache::OMSetRenderTargets(u32 numRtvs, const D3D12_CPU_DESCRIPTOR_HANDLE* pRtvs, BOOL singleHandle, const D3D12_CPU_DESCRIPTOR_HANDLE* pDsv)
+	{
+		if (!enabled_ || numRtvs > kMaxRenderTargets)
+		{
+			rtValid_ = false;
+			return Result(true);
+		}
+
+		// 単一ハンドル指定の場合は先頭ハンドルのみが意味を持つ
+		u32 numHandles = (singleHandle && numRtvs > 0) ? 1 : numRtvs;
+		bool hasDsv = pDsv != nullptr;
+		if (rtValid_
+			&& numRtvs_ == numRtvs
+			&& !rtvSingleHandle_ == !singleHandle
+			&& hasDsv_ == hasDsv
+			&& (!hasDsv || dsv_.ptr == pDsv->ptr)
+			&& IsSameArray(rtvs_, pRtvs, numHandles))
+		{
+			return Result(false);
+		}
+
+		rtValid_ = true;
+		numRtvs_ = numRtvs;
+		rtvSingleHandle_ = singleHandle;
+		memcpy(rtvs_, pRtvs, sizeof(D3D12_CPU_DESCRIPTOR_HANDLE) * numHandles);
+		hasDsv_ = hasDsv;
+		dsv_.ptr = hasDsv ? pDsv->ptr : 0;
+		return Result(true);
+	}
+
+}	// namespace sl12
+
+//	EOF
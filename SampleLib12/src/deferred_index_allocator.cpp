@@ -0,0 +1,91 @@
+﻿#include <sl12/deferred_index_allocator.h>
+
+#include <cassert>
+
+
+namespace sl12
+{
+	const u32 DeferredIndexAllocator::kInvalidIndex;
+
+	//----
+	void DeferredIndexAllocator::Initialize(u32 capacity)
+	{
+		Destroy();
+		capacity_ = capacity;
+	}
+
+	//----
+	void DeferredIndexAllocator::Destroy()
+	{
+		capacity_ = nextUnused_ = allocatedCount_ = 0;
+		freeIndices_.clear();
+		frameFreeIndices_.clear();
+		pendingIndices_.clear();
+		pendingFrames_.clear();
+	}
+
+	//----
+	u32 DeferredIndexAllocator::Allocate()
+	{
+		u32 ret = kInvalidIndex;
+		if (!freeIndices_.empty())
+		{
+			ret = freeIndices_.back();
+			freeIndices_.pop_back();
+		}
+		else if (nextUnused_ < capacity_)
+		{
+			ret = nextUnused_++;
+		}
+		else
+		{
+			return kInvalidIndex;
+		}
+
+		allocatedCount_++;
+		return ret;
+	}
+
+	//----
+	void DeferredIndexAllocator::Free(u32 index)
+	{
+		assert(index < nextUnused_);
+		assert(allocatedCount_ > 0);
+
+		frameFreeIndices_.push_back(index);
+		allocatedCount_--;
+	}
+
+	//----
+	void DeferredIndexAllocator::EndFrame(u64 fenceValue)
+	{
+		if (frameFreeIndices_.empty())
+		{
+			return;
+		}
+
+		PendingFrame frame;
+		frame.fenceValue = fenceValue;
+		frame.count = static_cast<u32>(frameFreeIndices_.size());
+		pendingFrames_.push_back(frame);
+		pendingIndices_.insert(pendingIndices_.end(), frameFreeIndices_.begin(), frameFreeIndices_.end());
+		frameFreeIndices_.clear();
+	}
+
+	//----
+	void DeferredIndexAllocator::Reclaim(u64 completedFenceValue)
+	{
+		while (!pendingFrames_.empty() && pendingFrames_.front().fenceValue <= completedFenceValue)
+		{
+			for (u32 i = 0; i < pendingFrames_.front().count; i++)
+			{
+				freeIndices_.push_back(pendingIndices_.front());
+				pendingIndices_.pop_front();
+			}
+			pendingFrames_.pop_front();
+		}
+	}
+
+}	// namespace sl12
+
+//	EOF
@@ -1,6 +1,8 @@
 ﻿#include <sl12/descriptor.h>
 
 #include <sl12/descriptor_heap.h>
+#include <sl12/descriptor_ring.h>
+#include <sl12/device.h>
 
 
 namespace sl12
@@ -19,6 +21,70 @@ namespace sl12
 		}
 	}
 
+	//----
+	D3D12_GPU_DESCRIPTOR_HANDLE Descriptor::GetTableGpuHandle()
+	{
+		if (pParentHeap_->IsShaderVisible())
+		{
+			return GetGpuHandle();
+		}
+
+		DescriptorHeap& dstHeap = pParentHeap_->GetDevice()->GetDescriptorHeap(pParentHeap_->GetHeapDesc().Type);
+		DescriptorRing* pRing = dstHeap.GetTransientRing();
+		if (!pRing)
+		{
+			OutputDebugStringA("[sl12] Descriptor::GetTableGpuHandle : shader visible heap has no transient ring.\n");
+			return D3D12_GPU_DESCRIPTOR_HANDLE{ 0 };
+		}
+
+		// リングが溢れた場合は無効な領域が返るので、ptrが0のハンドルを返す
+		D3D12_CPU_DESCRIPTOR_HANDLE src = GetCpuHandle();
+		DescriptorRange range = pRing->CopyTable(&src, 1);
+		if (!range.IsValid())
+		{
+			return D3D12_GPU_DESCRIPTOR_HANDLE{ 0 };
+		}
+		return range.gpuHandle;
+	}
+
+	//----
+	D3D12_GPU_DESCRIPTOR_HANDLE CreateDescriptorTable(Descriptor* const* ppDescs, u32 count)
+	{
+		static const u32 kMaxTableSize = DescriptorRing::kMaxCachedTableSize;
+		D3D12_GPU_DESCRIPTOR_HANDLE ret{ 0 };
+		if (!ppDescs || count == 0 || count > kMaxTableSize)
+		{
+			return ret;
+		}
+
+		DescriptorHeap* pSrcHeap = ppDescs[0]->GetParentHeap();
+		if (pSrcHeap->IsShaderVisible())
+		{
+			// シェーダから参照するヒープからはコピーできない
+			OutputDebugStringA("[sl12] CreateDescriptorTable : source descriptors must be in a staging heap.\n");
+			return ret;
+		}
+
+		DescriptorHeap& dstHeap = pSrcHeap->GetDevice()->GetDescriptorHeap(pSrcHeap->GetHeapDesc().Type);
+		DescriptorRing* pRing = dstHeap.GetTransientRing();
+		if (!pRing)
+		{
+			return ret;
+		}
+
+		D3D12_CPU_DESCRIPTOR_HANDLE srcHandles[kMaxTableSize];
+		for (u32 i = 0; i < count; i++)
+		{
+			srcHandles[i] = ppDescs[i]->GetCpuHandle();
+		}
+		DescriptorRange range = pRing->CopyTable(srcHandles, count);
+		if (range.IsValid())
+		{
+			ret = range.gpuHandle;
+		}
+		return ret;
+	}
+
 }	// namespace sl12
 
 //	EOF
@@ -2,46 +2,81 @@
 
 #include <sl12/device.h>
 #include <sl12/descriptor.h>
+#include <sl12/descriptor_ring.h>
+#include <sl12/descriptor_view_cache.h>
+#include <sl12/bindless_descriptor_table.h>
 
 
 namespace sl12
 {
 	//----
-	bool DescriptorHeap::Initialize(Device* pDev, const D3D12_DESCRIPTOR_HEAP_DESC& desc)
+	bool DescriptorHeap::Initialize(Device* pDev, const D3D12_DESCRIPTOR_HEAP_DESC& desc, const DescriptorHeapLayout& layout)
 	{
+		if (static_cast<u64>(layout.numRanges) + layout.numTransients > desc.NumDescriptors)
+		{
+			return false;
+		}
+		if (layout.stageViews && (desc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE) && (layout.numTransients == 0))
+		{
+			// ステージングしたビューはリングにコピーして使用するため、リングが必要
+			OutputDebugStringA("[sl12] DescriptorHeap::Initialize : stageViews requires numTransients.\n");
+			return false;
+		}
+
 		auto hr = pDev->GetDeviceDep()->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&pHeap_));
 		if (FAILED(hr))
 		{
 			return false;
 		}
 
-		pDescriptors_ = new Descriptor[desc.NumDescriptors + 2];
-		//pUsedList_ = pDescriptors_;
-		//pUsedList_->pPrev_ = pUsedList_->pNext_ = pUsedList_;
-		pUnusedList_ = pDescriptors_ + 1;
-		pUnusedList_->pPrev_ = pUnusedList_->pNext_ = pUnusedList_;
-
+		pDevice_ = pDev;
 		heapDesc_ = desc;
 		descSize_ = pDev->GetDeviceDep()->GetDescriptorHandleIncrementSize(desc.Type);
 
-		// すべてUnusedListに接続
-		Descriptor* p = pUnusedList_ + 1;
-		D3D12_CPU_DESCRIPTOR_HANDLE hCpu = pHeap_->GetCPUDescriptorHandleForHeapStart();
-		D3D12_GPU_DESCRIPTOR_HANDLE hGpu = pHeap_->GetGPUDescriptorHandleForHeapStart();
-		for (u32 i = 0; i < desc.NumDescriptors; i++, p++, hCpu.ptr += descSize_, hGpu.ptr += descSize_)
-		{
-			p->pParentHeap_ = this;
-			p->cpuHandle_ = hCpu;
-			p->gpuHandle_ = hGpu;
-			p->index_ = i;
+		cpuHandleStart_ = pHeap_->GetCPUDescriptorHandleForHeapStart();
+		gpuHandleStart_ = pHeap_->GetGPUDescriptorHandleForHeapStart();
 
-			Descriptor* next = pUnusedList_->pNext_;
-			pUnusedList_->pNext_ = next->pPrev_ = p;
-			p->pPrev_ = pUnusedList_;
-			p->pNext_ = next;
+		// ヒープは先頭から [単体確保 | 連続領域 | リング] の順に分割する
+		// 単体確保の領域のみDescriptorを生成し、空き状態はビットセットで管理する
+		numPersistents_ = desc.NumDescriptors - layout.numRanges - layout.numTransients;
+		if (!InitializePage(0, numPersistents_))
+		{
+			return false;
 		}
+		pageCount_ = 1;
+
+		// シェーダから参照しないヒープのみ拡張可能
+		// シェーダから参照するヒープは描画中に切り替えられないため、ステージング用ヒープからコピーして使用する
+		isGrowable_ = (desc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE) == 0;
+		isViewStaged_ = layout.stageViews && !isGrowable_;
 
 		take_num_ = 0;
+		highWaterMark_ = 0;
+
+		// 連続領域
+		rangeBase_ = numPersistents_;
+		if (layout.numRanges > 0)
+		{
+			if (!rangeAllocator_.Initialize(layout.numRanges))
+			{
+				return false;
+			}
+		}
+
+		// フレーム単位のリング領域はヒープ末尾に配置する
+		if (layout.numTransients > 0)
+		{
+			pTransientRing_ = new DescriptorRing();
+			if (!pTransientRing_->Initialize(this, numPersistents_ + layout.numRanges, layout.numTransients))
+			{
+				return false;
+			}
+		}
+
+		if (layout.enableViewCache)
+		{
+			pViewCache_ = new DescriptorViewCache();
+		}
 
 		return true;
 	}
@@ -49,24 +84,60 @@ namespace sl12
 	//----
 	void DescriptorHeap::Destroy()
 	{
-		//assert(pUsedList_->pNext_ == pUsedList_);
-		delete[] pDescriptors_;
+		for (auto&& mag : magazines_)
+		{
+			mag.count = 0;
+		}
+		SafeDelete(pViewCache_);
+		SafeDelete(pTransientRing_);
+		rangeAllocator_.Destroy();
+		for (auto&& page : pages_)
+		{
+			page.unusedBits.Destroy();
+			SafeDeleteArray(page.pDescriptors);
+			SafeRelease(page.pHeap);
+		}
+		pageCount_ = 0;
+		numPersistents_ = 0;
+		rangeHighWaterMark_ = 0;
 		SafeRelease(pHeap_);
+		pDevice_ = nullptr;
 	}
 
 	//----
 	Descriptor* DescriptorHeap::CreateDescriptor()
 	{
-		if (pUnusedList_->pNext_ == pUnusedList_)
+		Descriptor* ret = nullptr;
 		{
-			return nullptr;
+			Magazine& mag = magazines_[GetThreadSlot()];
+			std::lock_guard<std::mutex> lock(mag.mutex);
+
+			// キャッシュが空ならグローバルプールからまとめて補充する
+			if (mag.count == 0)
+			{
+				mag.count = AllocFromGlobal(mag.pItems, kMagazineBatch);
+			}
+			if (mag.count > 0)
+			{
+				ret = mag.pItems[--mag.count];
+			}
+		}
+
+		// グローバルプールも空の場合は他スレッドのキャッシュから取得する
+		if (!ret)
+		{
+			ret = StealFromMagazines();
+			if (!ret)
+			{
+				return nullptr;
+			}
 		}
 
-		Descriptor* ret = pUnusedList_->pNext_;
-		ret->pPrev_->pNext_ = ret->pNext_;
-		ret->pNext_->pPrev_ = ret->pPrev_;
-		ret->pNext_ = ret->pPrev_ = ret;
-		take_num_++;
+		// 最大使用数を記録する
+		u32 num = ++take_num_;
+		u32 high = highWaterMark_;
+		while ((num > high) && !highWaterMark_.compare_exchange_weak(high, num))
+		{}
 
 		return ret;
 	}
@@ -74,15 +145,281 @@ namespace sl12
 	//----
 	void DescriptorHeap::ReleaseDescriptor(Descriptor* p)
 	{
-		assert((pDescriptors_ <= p) && (p <= pDescriptors_ + heapDesc_.NumDescriptors + 2));
+		assert(p && (p->pParentHeap_ == this));
 
-		Descriptor* next = pUnusedList_->pNext_;
-		pUnusedList_->pNext_ = next->pPrev_ = p;
-		p->pPrev_ = pUnusedList_;
-		p->pNext_ = next;
+		// 共有中のデスクリプタは最後の参照が解放されるまで返却しない
+		if (p->isCached_)
+		{
+			u32 bindlessIndex;
+			{
+				std::lock_guard<std::mutex> lock(viewCacheMutex_);
+				if (!pViewCache_->Release(p, &bindlessIndex))
+				{
+					return;
+				}
+			}
+			p->isCached_ = false;
+
+			// 共有していたバインドレスインデックスも返却する
+			auto pBindless = pDevice_->GetBindlessTable();
+			if (pBindless)
+			{
+				pBindless->Release(bindlessIndex);
+			}
+		}
+
+		Magazine& mag = magazines_[GetThreadSlot()];
+		std::lock_guard<std::mutex> lock(mag.mutex);
+
+		// キャッシュが一杯なら半分をグローバルプールに返却する
+		if (mag.count == kMagazineSize)
+		{
+			mag.count -= kMagazineBatch;
+			ReleaseToGlobal(mag.pItems + mag.count, kMagazineBatch);
+		}
+		mag.pItems[mag.count++] = p;
 		take_num_--;
 	}
 
+	//----
+	Descriptor* DescriptorHeap::CreateViewDescriptor(const DescriptorViewKey& key, const std::function<void(D3D12_CPU_DESCRIPTOR_HANDLE)>& createFunc)
+	{
+		if (!pViewCache_)
+		{
+			Descriptor* ret = CreateDescriptor();
+			if (ret)
+			{
+				createFunc(ret->GetCpuHandle());
+			}
+			return ret;
+		}
+
+		// 作成中に同一ビューが重複登録されないよう、作成までロックしておく
+		std::lock_guard<std::mutex> lock(viewCacheMutex_);
+		Descriptor* ret = pViewCache_->Find(key);
+		if (ret)
+		{
+			return ret;
+		}
+
+		ret = CreateDescriptor();
+		if (!ret)
+		{
+			return nullptr;
+		}
+		createFunc(ret->GetCpuHandle());
+		pViewCache_->Insert(key, ret);
+		ret->isCached_ = true;
+		return ret;
+	}
+
+	//----
+	u32 DescriptorHeap::RegisterBindlessView(Descriptor* pDesc, const std::function<void(D3D12_CPU_DESCRIPTOR_HANDLE)>& createFunc)
+	{
+		assert(pDesc && (pDesc->pParentHeap_ == this));
+
+		auto pBindless = pDevice_->GetBindlessTable();
+		if (!pBindless)
+		{
+			return BindlessDescriptorTable::kInvalidIndex;
+		}
+		if (!pDesc->isCached_)
+		{
+			return pBindless->Register(createFunc);
+		}
+
+		// 共有中のデスクリプタは同じインデックスを共有する
+		std::lock_guard<std::mutex> lock(viewCacheMutex_);
+		u32 index = pViewCache_->GetBindlessIndex(pDesc);
+		if (index == BindlessDescriptorTable::kInvalidIndex)
+		{
+			index = pBindless->Register(createFunc);
+			pViewCache_->SetBindlessIndex(pDesc, index);
+		}
+		return index;
+	}
+
+	//----
+	void DescriptorHeap::ReleaseBindlessView(Descriptor* pDesc, u32 index)
+	{
+		assert(pDesc && (pDesc->pParentHeap_ == this));
+
+		auto pBindless = pDevice_->GetBindlessTable();
+		if (pBindless && !pDesc->isCached_)
+		{
+			pBindless->Release(index);
+		}
+	}
+
+	//----
+	DescriptorRange DescriptorHeap::AllocateRange(u32 count)
+	{
+		u32 offset;
+		{
+			std::lock_guard<std::mutex> lock(rangeMutex_);
+			offset = rangeAllocator_.Allocate(count);
+			u32 used = rangeAllocator_.GetUsedSize();
+			rangeHighWaterMark_ = (used > rangeHighWaterMark_) ? used : rangeHighWaterMark_;
+		}
+		if (offset == RangeAllocator::kInvalidOffset)
+		{
+			return DescriptorRange();
+		}
+		return GetRange(rangeBase_ + offset, count);
+	}
+
+	//----
+	void DescriptorHeap::FreeRange(const DescriptorRange& range)
+	{
+		if (!range.IsValid())
+		{
+			return;
+		}
+
+		assert(range.index >= rangeBase_ && range.index < rangeBase_ + rangeAllocator_.GetCapacity());
+		std::lock_guard<std::mutex> lock(rangeMutex_);
+		assert(rangeAllocator_.GetAllocationSize(range.index - rangeBase_) == range.count);
+		rangeAllocator_.Free(range.index - rangeBase_);
+	}
+
+	//----
+	float DescriptorHeap::GetRangeFragmentation()
+	{
+		std::lock_guard<std::mutex> lock(rangeMutex_);
+		return rangeAllocator_.GetFragmentation();
+	}
+
+	//----
+	DescriptorRange DescriptorHeap::GetRange(u32 index, u32 count) const
+	{
+		assert(index + count <= heapDesc_.NumDescriptors);
+
+		DescriptorRange ret;
+		ret.cpuHandle = GetCpuHandle(index);
+		ret.gpuHandle = GetGpuHandle(index);
+		ret.index = index;
+		ret.count = count;
+		ret.descSize = descSize_;
+		return ret;
+	}
+
+	//----
+	u32 DescriptorHeap::GetThreadSlot()
+	{
+		// スレッド毎に初回アクセス時にスロットを割り当てる
+		static std::atomic<u32> sNextSlot{ 0 };
+		thread_local u32 tSlot = sNextSlot++ % kMagazineCount;
+		return tSlot;
+	}
+
+	//----
+	u32 DescriptorHeap::AllocFromGlobal(Descriptor** ppOut, u32 count)
+	{
+		std::lock_guard<std::mutex> lock(globalMutex_);
+
+		u32 num = 0;
+		u32 page = 0;
+		while (num < count)
+		{
+			u32 index = pages_[page].unusedBits.FindFirstSet();
+			if (index == HierarchicalBitset::kInvalidIndex)
+			{
+				// 次のページへ. 全ページが埋まっていれば拡張を試みる
+				if (++page < pageCount_)
+				{
+					continue;
+				}
+				if ((num > 0) || !AddPage())
+				{
+					break;
+				}
+				continue;
+			}
+
+			pages_[page].unusedBits.Reset(index);
+			ppOut[num++] = pages_[page].pDescriptors + index;
+		}
+		return num;
+	}
+
+	//----
+	void DescriptorHeap::ReleaseToGlobal(Descriptor* const* ppIn, u32 count)
+	{
+		std::lock_guard<std::mutex> lock(globalMutex_);
+
+		for (u32 i = 0; i < count; i++)
+		{
+			u32 page = ppIn[i]->index_ / heapDesc_.NumDescriptors;
+			pages_[page].unusedBits.Set(ppIn[i]->index_ - page * heapDesc_.NumDescriptors);
+		}
+	}
+
+	//----
+	bool DescriptorHeap::InitializePage(u32 pageIndex, u32 numSlots)
+	{
+		Page& page = pages_[pageIndex];
+		if (pageIndex == 0)
+		{
+			page.cpuHandleStart = cpuHandleStart_;
+		}
+		else
+		{
+			D3D12_DESCRIPTOR_HEAP_DESC desc = heapDesc_;
+			desc.NumDescriptors = numSlots;
+			auto hr = pDevice_->GetDeviceDep()->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&page.pHeap));
+			if (FAILED(hr))
+			{
+				return false;
+			}
+			page.cpuHandleStart = page.pHeap->GetCPUDescriptorHandleForHeapStart();
+		}
+
+		u32 baseIndex = pageIndex * heapDesc_.NumDescriptors;
+		page.pDescriptors = new Descriptor[numSlots];
+		for (u32 i = 0; i < numSlots; i++)
+		{
+			page.pDescriptors[i].pParentHeap_ = this;
+			page.pDescriptors[i].index_ = baseIndex + i;
+		}
+		page.unusedBits.Initialize(numSlots, true);
+
+		return true;
+	}
+
+	//----
+	bool DescriptorHeap::AddPage()
+	{
+		// globalMutex_ をロックした状態で呼び出すこと
+		u32 pageIndex = pageCount_;
+		if (!isGrowable_ || (pageIndex >= kMaxPages))
+		{
+			return false;
+		}
+		if (!InitializePage(pageIndex, heapDesc_.NumDescriptors))
+		{
+			return false;
+		}
+
+		// ページの初期化が終わってから公開する
+		pageCount_ = pageIndex + 1;
+		return true;
+	}
+
+	//----
+	Descriptor* DescriptorHeap::StealFromMagazines()
+	{
+		// ロックは1つずつ取得するので、マガジン同士でデッドロックすることはない
+		for (auto&& mag : magazines_)
+		{
+			std::lock_guard<std::mutex> lock(mag.mutex);
+			if (mag.count > 0)
+			{
+				return mag.pItems[--mag.count];
+			}
+		}
+		return nullptr;
+	}
+
 }	// namespace sl12
 
 //	EOF
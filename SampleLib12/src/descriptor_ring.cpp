@@ -0,0 +1,128 @@
+﻿#include <sl12/descriptor_ring.h>
+
+#include <sl12/descriptor_heap.h>
+#include <sl12/device.h>
+#include <cstdio>
+
+
+namespace sl12
+{
+	//----
+	bool DescriptorRing::Initialize(DescriptorHeap* pHeap, u32 baseIndex, u32 count)
+	{
+		if (!pHeap || (count == 0) || (baseIndex + count > pHeap->GetHeapDesc().NumDescriptors))
+		{
+			return false;
+		}
+
+		pParentHeap_ = pHeap;
+		baseIndex_ = baseIndex;
+		overflowCount_ = 0;
+		highWaterMark_ = 0;
+		ring_.Initialize(count);
+
+		return true;
+	}
+
+	//----
+	void DescriptorRing::Destroy()
+	{
+		ring_.Destroy();
+		tableCache_.Clear();
+		frameStats_ = lastFrameStats_ = CopyStats();
+		pParentHeap_ = nullptr;
+	}
+
+	//----
+	DescriptorRange DescriptorRing::Allocate(u32 count)
+	{
+		u64 offset = ring_.Allocate(count);
+		if (offset == RingAllocator::kInvalidOffset)
+		{
+			overflowCount_++;
+
+			char text[256];
+			sprintf_s(text, "[sl12] DescriptorRing overflow. (request: %u, used: %u / %u)\n", count, GetUsedCount(), GetCount());
+			OutputDebugStringA(text);
+			return DescriptorRange();
+		}
+
+		highWaterMark_ = (GetUsedCount() > highWaterMark_) ? GetUsedCount() : highWaterMark_;
+		return pParentHeap_->GetRange(baseIndex_ + static_cast<u32>(offset), count);
+	}
+
+	//----
+	DescriptorRange DescriptorRing::CopyFrom(const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcHandles, u32 count)
+	{
+		DescriptorRange ret = Allocate(count);
+		if (!ret.IsValid())
+		{
+			return ret;
+		}
+
+		// コピー元は1つずつ、コピー先は連続領域としてまとめてコピーする
+		pParentHeap_->GetDevice()->GetDeviceDep()->CopyDescriptors(
+			1, &ret.cpuHandle, &count,
+			count, pSrcHandles, nullptr,
+			pParentHeap_->GetHeapDesc().Type);
+		frameStats_.copyCalls++;
+		frameStats_.copiedDescriptors += count;
+
+		return ret;
+	}
+
+	//----
+	DescriptorRange DescriptorRing::CopyTable(const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcHandles, u32 count)
+	{
+		static_assert(sizeof(D3D12_CPU_DESCRIPTOR_HANDLE) <= sizeof(u64), "unexpected handle size.");
+
+		frameStats_.tableRequests++;
+
+		// キーを作成できない大きさのテーブルはキャッシュせずにコピーする
+		if (count > kMaxCachedTableSize)
+		{
+			frameStats_.tableCacheBypasses++;
+			return CopyFrom(pSrcHandles, count);
+		}
+
+		u64 keys[kMaxCachedTableSize];
+		for (u32 i = 0; i < count; i++)
+		{
+			keys[i] = static_cast<u64>(pSrcHandles[i].ptr);
+		}
+
+		u32 index = tableCache_.Find(keys, count);
+		if (index != DescriptorTableCache::kInvalidIndex)
+		{
+			frameStats_.tableCacheHits++;
+			return pParentHeap_->GetRange(index, count);
+		}
+
+		DescriptorRange ret = CopyFrom(pSrcHandles, count);
+		if (ret.IsValid())
+		{
+			tableCache_.Insert(keys, count, ret.index);
+		}
+		return ret;
+	}
+
+	//----
+	void DescriptorRing::EndFrame(u64 fenceValue)
+	{
+		ring_.EndFrame(fenceValue);
+
+		// テーブルキャッシュはフレーム内でのみ有効
+		tableCache_.Clear();
+		lastFrameStats_ = frameStats_;
+		frameStats_ = CopyStats();
+	}
+
+	//----
+	void DescriptorRing::Reclaim(u64 completedFenceValue)
+	{
+		ring_.Reclaim(completedFenceValue);
+	}
+
+}	// namespace sl12
+
+//	EOF
@@ -0,0 +1,65 @@
+﻿#include <sl12/descriptor_table_cache.h>
+
+#include <cstring>
+
+
+namespace sl12
+{
+	const u32 DescriptorTableCache::kInvalidIndex;
+
+	//----
+	u32 DescriptorTableCache::Find(const u64* pSrcHandles, u32 count)
+	{
+		lookupCount_++;
+
+		auto range = lookup_.equal_range(CalcHash(pSrcHandles, count));
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			const Entry& e = entries_[it->second];
+			if ((e.count == count) && (memcmp(srcHandles_.data() + e.srcOffset, pSrcHandles, sizeof(u64) * count) == 0))
+			{
+				hitCount_++;
+				return e.destIndex;
+			}
+		}
+		return kInvalidIndex;
+	}
+
+	//----
+	void DescriptorTableCache::Insert(const u64* pSrcHandles, u32 count, u32 destIndex)
+	{
+		Entry e;
+		e.srcOffset = static_cast<u32>(srcHandles_.size());
+		e.count = count;
+		e.destIndex = destIndex;
+		srcHandles_.insert(srcHandles_.end(), pSrcHandles, pSrcHandles + count);
+
+		lookup_.insert(std::make_pair(CalcHash(pSrcHandles, count), static_cast<u32>(entries_.size())));
+		entries_.push_back(e);
+	}
+
+	//----
+	void DescriptorTableCache::Clear()
+	{
+		srcHandles_.clear();
+		entries_.clear();
+		lookup_.clear();
+		lookupCount_ = hitCount_ = 0;
+	}
+
+	//----
+	u64 DescriptorTableCache::CalcHash(const u64* pSrcHandles, u32 count)
+	{
+		// FNV-1a
+		u64 hash = 0xcbf29ce484222325ull;
+		for (u32 i = 0; i < count; i++)
+		{
+			hash ^= pSrcHandles[i];
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+}	// namespace sl12
+
+//	EOF
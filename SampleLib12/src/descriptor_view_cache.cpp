@@ -0,0 +1,122 @@
+﻿#include <sl12/descriptor_view_cache.h>
+
+#include <sl12/crc.h>
+#include <atomic>
+#include <cassert>
+
+
+namespace sl12
+{
+	//----
+	u64 IssueResourceId()
+	{
+		static std::atomic<u64> s_nextId(1);
+		return s_nextId.fetch_add(1);
+	}
+
+	//----
+	u32 DescriptorViewKey::CalcHash() const
+	{
+		u32 ret = CalcCrc32(&resourceId, sizeof(resourceId));
+		ret = CalcCrc32(&type, sizeof(type), ret);
+		return CalcCrc32(desc, descSize, ret);
+	}
+
+
+	//----
+	void DescriptorViewCache::Destroy()
+	{
+		entries_.clear();
+		keys_.clear();
+		hitCount_ = missCount_ = 0;
+		totalRefCount_ = 0;
+	}
+
+	//----
+	Descriptor* DescriptorViewCache::Find(const DescriptorViewKey& key)
+	{
+		auto it = entries_.find(key);
+		if (it == entries_.end())
+		{
+			missCount_++;
+			return nullptr;
+		}
+
+		hitCount_++;
+		totalRefCount_++;
+		it->second.refCount++;
+		return it->second.pDesc;
+	}
+
+	//----
+	void DescriptorViewCache::Insert(const DescriptorViewKey& key, Descriptor* pDesc)
+	{
+		assert(entries_.find(key) == entries_.end());
+
+		Entry entry;
+		entry.pDesc = pDesc;
+		entry.refCount = 1;
+		entry.bindlessIndex = ~0u;
+		entries_.insert(std::make_pair(key, entry));
+		keys_.insert(std::make_pair(pDesc, key));
+		totalRefCount_++;
+	}
+
+	//----
+	bool DescriptorViewCache::Release(Descriptor* pDesc, u32* pBindlessIndex)
+	{
+		if (pBindlessIndex)
+		{
+			*pBindlessIndex = ~0u;
+		}
+
+		auto kit = keys_.find(pDesc);
+		if (kit == keys_.end())
+		{
+			// キャッシュ対象外
+			return true;
+		}
+
+		auto eit = entries_.find(kit->second);
+		assert(eit != entries_.end());
+		totalRefCount_--;
+		if (--eit->second.refCount > 0)
+		{
+			return false;
+		}
+
+		if (pBindlessIndex)
+		{
+			*pBindlessIndex = eit->second.bindlessIndex;
+		}
+		entries_.erase(eit);
+		keys_.erase(kit);
+		return true;
+	}
+
+	//----
+	u32 DescriptorViewCache::GetBindlessIndex(Descriptor* pDesc) const
+	{
+		auto kit = keys_.find(pDesc);
+		if (kit == keys_.end())
+		{
+			return ~0u;
+		}
+		auto eit = entries_.find(kit->second);
+		assert(eit != entries_.end());
+		return eit->second.bindlessIndex;
+	}
+
+	//----
+	void DescriptorViewCache::SetBindlessIndex(Descriptor* pDesc, u32 index)
+	{
+		auto kit = keys_.find(pDesc);
+		assert(kit != keys_.end());
+		auto eit = entries_.find(kit->second);
+		assert(eit != entries_.end());
+		eit->second.bindlessIndex = index;
+	}
+
+}	// namespace sl12
+
+//	EOF
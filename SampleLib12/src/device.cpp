@@ -3,12 +3,16 @@
 #include <sl12/swapchain.h>
 #include <sl12/command_queue.h>
 #include <sl12/descriptor_heap.h>
+#include <sl12/descriptor_ring.h>
+#include <sl12/bindless_descriptor_table.h>
+#include <sl12/upload_ring.h>
+#include <cstdio>
 
 
 namespace sl12
 {
 	//----
-	bool Device::Initialize(HWND hWnd, u32 screenWidth, u32 screenHeight, const std::array<u32, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES>& numDescs)
+	bool Device::Initialize(HWND hWnd, u32 screenWidth, u32 screenHeight, const std::array<u32, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES>& numDescs, const std::array<DescriptorHeapLayout, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES>& layouts)
 	{
 		uint32_t factoryFlags = 0;
 #ifdef _DEBUG
@@ -123,7 +127,41 @@ namespace sl12
 				(i == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV) || (i == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER) ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE,
 				1
 			};
-			if (!pDescHeaps_[i].Initialize(this, desc))
+			if (!pDescHeaps_[i].Initialize(this, desc, layouts[i]))
+			{
+				return false;
+			}
+		}
+
+		// ステージング用DescriptorHeapの作成
+		// シェーダから参照するヒープは拡張できないので、CPUのみのヒープで作成したデスクリプタをコピーして使用する
+		pStagingDescHeaps_ = new DescriptorHeap[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+		for (u32 i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; i++)
+		{
+			if ((i != D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV) && (i != D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER))
+			{
+				continue;
+			}
+
+			D3D12_DESCRIPTOR_HEAP_DESC desc{
+				(D3D12_DESCRIPTOR_HEAP_TYPE)i,
+				numDescs[i],
+				D3D12_DESCRIPTOR_HEAP_FLAG_NONE,
+				1
+			};
+			DescriptorHeapLayout layout;
+			layout.enableViewCache = layouts[i].enableViewCache;
+			if (!pStagingDescHeaps_[i].Initialize(this, desc, layout))
+			{
+				return false;
+			}
+		}
+
+		// バインドレステーブルの作成
+		if (layouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].numBindless > 0)
+		{
+			pBindlessTable_ = new BindlessDescriptorTable();
+			if (!pBindlessTable_->Initialize(this, layouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].numBindless))
 			{
 				return false;
 			}
@@ -154,6 +192,13 @@ namespace sl12
 			return false;
 		}
 
+		// アップロードリングの作成
+		pUploadRing_ = new UploadRing();
+		if (!pUploadRing_->Initialize(this))
+		{
+			return false;
+		}
+
 		return true;
 	}
 
@@ -163,8 +208,14 @@ namespace sl12
 		//CloseHandle(fenceEvent_);
 		SafeRelease(pFence_);
 
+		ReportDescriptorHeapUsage();
+
+		SafeDelete(pUploadRing_);
+
 		SafeDelete(pSwapchain_);
 
+		SafeDelete(pBindlessTable_);
+		SafeDeleteArray(pStagingDescHeaps_);
 		SafeDeleteArray(pDescHeaps_);
 
 		SafeDelete(pGraphicsQueue_);
@@ -207,6 +258,31 @@ namespace sl12
 				// イベントが発火するまで待つ
 				WaitForSingleObject(fenceEvent_, INFINITE);
 			}
+
+			// 一時デスクリプタのリングを更新する
+			// 完了したフレームの領域を回収し、未実行のコマンドで使用する領域は次に発行されるFence値でタグ付けする
+			if (pDescHeaps_)
+			{
+				for (u32 i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; i++)
+				{
+					DescriptorRing* pRing = pDescHeaps_[i].GetTransientRing();
+					if (pRing)
+					{
+						pRing->Reclaim(fvalue);
+						pRing->EndFrame(fenceValue_);
+					}
+				}
+			}
+			if (pBindlessTable_)
+			{
+				pBindlessTable_->EndFrame(fvalue, fenceValue_);
+			}
+
+			// 完了したアップロード領域を回収する
+			if (pUploadRing_)
+			{
+				pUploadRing_->Reclaim();
+			}
 		}
 	}
 
@@ -219,12 +295,65 @@ namespace sl12
 		}
 	}
 
+	//----
+	void Device::ReportDescriptorHeapUsage()
+	{
+		if (!pDescHeaps_)
+		{
+			return;
+		}
+
+		static const char* kTypeNames[] = { "CBV_SRV_UAV", "SAMPLER", "RTV", "DSV" };
+		char text[256];
+		for (u32 i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; i++)
+		{
+			DescriptorHeap& heap = pDescHeaps_[i];
+			DescriptorRing* pRing = heap.GetTransientRing();
+			sprintf_s(text, "[sl12] DescriptorHeap %s : single %u / %u (%u pages), range %u / %u, transient %u / %u\n",
+				kTypeNames[i],
+				heap.GetHighWaterMark(), heap.GetCapacity(), heap.GetPageCount(),
+				heap.GetRangeHighWaterMark(), heap.GetRangeCapacity(),
+				pRing ? pRing->GetHighWaterMark() : 0, pRing ? pRing->GetCount() : 0);
+			OutputDebugStringA(text);
+
+			if (pStagingDescHeaps_ && pStagingDescHeaps_[i].GetHeap())
+			{
+				DescriptorHeap& staging = pStagingDescHeaps_[i];
+				sprintf_s(text, "[sl12] DescriptorHeap %s (staging) : single %u / %u (%u pages)\n",
+					kTypeNames[i], staging.GetHighWaterMark(), staging.GetCapacity(), staging.GetPageCount());
+				OutputDebugStringA(text);
+			}
+		}
+	}
+
 	//----
 	DescriptorHeap& Device::GetDescriptorHeap(u32 no)
 	{
 		return pDescHeaps_[no];
 	}
 
+	//----
+	DescriptorHeap& Device::GetStagingDescriptorHeap(u32 no)
+	{
+		// RTV, DSVは元々CPUのみのヒープなのでそのまま返す
+		if (!pStagingDescHeaps_[no].GetHeap())
+		{
+			return pDescHeaps_[no];
+		}
+		return pStagingDescHeaps_[no];
+	}
+
+	//----
+	DescriptorHeap& Device::GetViewDescriptorHeap(u32 no)
+	{
+		// ビューをステージングする設定の場合はステージング用ヒープに作成する
+		if (pDescHeaps_[no].IsViewStaged())
+		{
+			return GetStagingDescriptorHeap(no);
+		}
+		return pDescHeaps_[no];
+	}
+
 }	// namespace sl12
 
 //	EOF
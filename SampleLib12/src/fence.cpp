@@ -80,6 +80,12 @@ namespace sl12
 		return !(completedValue < waitValue_);
 	}
 
+	//----
+	u64 Fence::GetCompletedValue() const
+	{
+		return pFence_ ? pFence_->GetCompletedValue() : 0;
+	}
+
 }	// namespace sl12
 
 //	EOF
@@ -0,0 +1,311 @@
+﻿#include <sl12/file_watcher.h>
+
+#include <algorithm>
+#include <cstdio>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <map>
+#endif
+
+
+namespace sl12
+{
+	namespace
+	{
+		void AddUnique(std::vector<std::string>& files, size_t first, std::string path)
+		{
+			std::replace(path.begin(), path.end(), '\\', '/');
+			if (std::find(files.begin() + first, files.end(), path) == files.end())
+			{
+				files.push_back(path);
+			}
+		}
+	}
+
+#if defined(_WIN32)
+	//-------------------------------------------------
+	// Windows : ReadDirectoryChangesW
+	//-------------------------------------------------
+	struct FileWatcher::Impl
+	{
+		static const DWORD kBufferSize = 64 * 1024;
+		static const DWORD kNotifyFilter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE;
+
+		HANDLE				hDirectory = INVALID_HANDLE_VALUE;
+		OVERLAPPED			overlapped{};
+		std::vector<DWORD>	buffer;			// FILE_NOTIFY_INFORMATIONはDWORD境界に揃える必要がある
+		BOOL				isRecursive = TRUE;
+		bool				isPending = false;
+
+		~Impl()
+		{
+			if (hDirectory != INVALID_HANDLE_VALUE)
+			{
+				// 発行中の要求を取り消してから閉じる
+				if (isPending)
+				{
+					CancelIo(hDirectory);
+					DWORD bytes;
+					GetOverlappedResult(hDirectory, &overlapped, &bytes, TRUE);
+				}
+				CloseHandle(hDirectory);
+			}
+			if (overlapped.hEvent)
+			{
+				CloseHandle(overlapped.hEvent);
+			}
+		}
+
+		bool Issue()
+		{
+			isPending = ReadDirectoryChangesW(hDirectory, buffer.data(), kBufferSize, isRecursive, kNotifyFilter, nullptr, &overlapped, nullptr) != FALSE;
+			return isPending;
+		}
+	};	// struct FileWatcher::Impl
+
+	bool FileWatcher::Initialize(const char* directory, bool isRecursive)
+	{
+		Destroy();
+
+		std::unique_ptr<Impl> impl(new Impl());
+		impl->hDirectory = CreateFileA(directory, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+		if (impl->hDirectory == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		impl->overlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+		impl->buffer.resize(Impl::kBufferSize / sizeof(DWORD));
+		impl->isRecursive = isRecursive ? TRUE : FALSE;
+		if (!impl->overlapped.hEvent || !impl->Issue())
+		{
+			return false;
+		}
+
+		impl_ = std::move(impl);
+		directory_ = directory;
+		return true;
+	}
+
+	u32 FileWatcher::Poll(std::vector<std::string>& outFiles, std::vector<std::string>* pOutRemoved)
+	{
+		hasOverflowed_ = false;
+		if (!impl_)
+		{
+			return 0;
+		}
+
+		size_t first = outFiles.size();
+		size_t firstRemoved = pOutRemoved ? pOutRemoved->size() : 0;
+		for (;;)
+		{
+			DWORD bytes = 0;
+			if (!GetOverlappedResult(impl_->hDirectory, &impl_->overlapped, &bytes, FALSE))
+			{
+				if (GetLastError() != ERROR_IO_INCOMPLETE)
+				{
+					// 監視ディレクトリが削除された等
+					impl_->isPending = false;
+					impl_->Issue();
+				}
+				break;
+			}
+			impl_->isPending = false;
+
+			if (bytes == 0)
+			{
+				// バッファが溢れた
+				hasOverflowed_ = true;
+			}
+			else
+			{
+				auto p = reinterpret_cast<const u8*>(impl_->buffer.data());
+				for (;;)
+				{
+					auto info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(p);
+					int wlen = static_cast<int>(info->FileNameLength / sizeof(WCHAR));
+					int len = WideCharToMultiByte(CP_ACP, 0, info->FileName, wlen, nullptr, 0, nullptr, nullptr);
+					std::string path(len, '\0');
+					WideCharToMultiByte(CP_ACP, 0, info->FileName, wlen, &path[0], len, nullptr, nullptr);
+					if (info->Action != FILE_ACTION_REMOVED && info->Action != FILE_ACTION_RENAMED_OLD_NAME)
+					{
+						AddUnique(outFiles, first, path);
+					}
+					else if (pOutRemoved)
+					{
+						AddUnique(*pOutRemoved, firstRemoved, path);
+					}
+					if (info->NextEntryOffset == 0)
+					{
+						break;
+					}
+					p += info->NextEntryOffset;
+				}
+			}
+
+			// 次の通知を要求する
+			ResetEvent(impl_->overlapped.hEvent);
+			if (!impl_->Issue())
+			{
+				break;
+			}
+		}
+		return static_cast<u32>(outFiles.size() - first);
+	}
+
+#else
+	//-------------------------------------------------
+	// Linux : inotify
+	//-------------------------------------------------
+	struct FileWatcher::Impl
+	{
+		static const uint32_t kMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_MOVED_FROM;
+
+		int							fd = -1;
+		std::map<int, std::string>	watches;		// ウォッチ記述子と監視ディレクトリからの相対パス
+		bool						isRecursive = true;
+
+		~Impl()
+		{
+			if (fd >= 0)
+			{
+				close(fd);
+			}
+		}
+
+		bool AddWatch(const std::string& root, const std::string& relative)
+		{
+			std::string path = relative.empty() ? root : root + "/" + relative;
+			int wd = inotify_add_watch(fd, path.c_str(), kMask);
+			if (wd < 0)
+			{
+				return false;
+			}
+			watches[wd] = relative;
+			if (!isRecursive)
+			{
+				return true;
+			}
+
+			DIR* dir = opendir(path.c_str());
+			if (!dir)
+			{
+				return true;
+			}
+			while (auto entry = readdir(dir))
+			{
+				std::string name = entry->d_name;
+				if (entry->d_type == DT_DIR && name != "." && name != "..")
+				{
+					AddWatch(root, relative.empty() ? name : relative + "/" + name);
+				}
+			}
+			closedir(dir);
+			return true;
+		}
+	};	// struct FileWatcher::Impl
+
+	bool FileWatcher::Initialize(const char* directory, bool isRecursive)
+	{
+		Destroy();
+
+		std::unique_ptr<Impl> impl(new Impl());
+		impl->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		impl->isRecursive = isRecursive;
+		if (impl->fd < 0 || !impl->AddWatch(directory, ""))
+		{
+			return false;
+		}
+
+		impl_ = std::move(impl);
+		directory_ = directory;
+		return true;
+	}
+
+	u32 FileWatcher::Poll(std::vector<std::string>& outFiles, std::vector<std::string>* pOutRemoved)
+	{
+		hasOverflowed_ = false;
+		if (!impl_)
+		{
+			return 0;
+		}
+
+		size_t first = outFiles.size();
+		size_t firstRemoved = pOutRemoved ? pOutRemoved->size() : 0;
+		alignas(inotify_event) char buffer[16 * 1024];
+		for (;;)
+		{
+			ssize_t len = read(impl_->fd, buffer, sizeof(buffer));
+			if (len <= 0)
+			{
+				break;
+			}
+
+			for (char* p = buffer; p < buffer + len; )
+			{
+				auto ev = reinterpret_cast<const inotify_event*>(p);
+				p += sizeof(inotify_event) + ev->len;
+
+				if (ev->mask & IN_Q_OVERFLOW)
+				{
+					hasOverflowed_ = true;
+					continue;
+				}
+				auto it = impl_->watches.find(ev->wd);
+				if (it == impl_->watches.end() || ev->len == 0)
+				{
+					continue;
+				}
+				std::string path = it->second.empty() ? std::string(ev->name) : it->second + "/" + ev->name;
+				if (ev->mask & IN_ISDIR)
+				{
+					// 新しく作られたサブディレクトリも監視する
+					if ((ev->mask & IN_CREATE) && impl_->isRecursive)
+					{
+						impl_->AddWatch(directory_, path);
+					}
+					continue;
+				}
+				if (ev->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+				{
+					AddUnique(outFiles, first, path);
+				}
+				else if ((ev->mask & (IN_DELETE | IN_MOVED_FROM)) && pOutRemoved)
+				{
+					AddUnique(*pOutRemoved, firstRemoved, path);
+				}
+			}
+		}
+		return static_cast<u32>(outFiles.size() - first);
+	}
+#endif
+
+	//-------------------------------------------------
+	// コンストラクタ、デストラクタ
+	//-------------------------------------------------
+	FileWatcher::FileWatcher()
+	{}
+	FileWatcher::~FileWatcher()
+	{
+		Destroy();
+	}
+
+	//-------------------------------------------------
+	// 破棄
+	//-------------------------------------------------
+	void FileWatcher::Destroy()
+	{
+		impl_.reset();
+		directory_.clear();
+		hasOverflowed_ = false;
+	}
+
+}	// namespace sl12
+
+//	EOF
@@ -65,11 +65,11 @@ namespace sl12
 		{
 			return false;
 		}
-		if (!pVShader_->Initialize(pDevice, ShaderType::Vertex, kVSGui, sizeof(kVSGui)))
+		if (!pVShader_->InitializeReference(pDevice, ShaderType::Vertex, kVSGui, sizeof(kVSGui)))
 		{
 			return false;
 		}
-		if (!pPShader_->Initialize(pDevice, ShaderType::Pixel, kPSGui, sizeof(kPSGui)))
+		if (!pPShader_->InitializeReference(pDevice, ShaderType::Pixel, kPSGui, sizeof(kPSGui)))
 		{
 			return false;
 		}
@@ -392,11 +392,10 @@ namespace sl12
 		// NOTE: レンダーターゲットは設定済みとする
 
 		// パイプラインステート設定
-		ID3D12GraphicsCommandList* pNativeCmdList = pCmdList->GetCommandList();
-		pNativeCmdList->SetPipelineState(pThis->pPipelineState_);
+		pCmdList->SetPipelineState(pThis->pPipelineState_);
 
 		// ルートシグネチャを設定
-		pNativeCmdList->SetGraphicsRootSignature(pThis->pRootSig_);
+		pCmdList->SetGraphicsRootSignature(pThis->pRootSig_);
 
 		// DescriptorHeapを設定
 		ConstantBufferView& cbView = pThis->pConstantBufferViews_[frameIndex];
@@ -404,16 +403,16 @@ namespace sl12
 			pDevice->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).GetHeap(),
 			pDevice->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER).GetHeap()
 		};
-		pNativeCmdList->SetDescriptorHeaps(_countof(pDescHeaps), pDescHeaps);
-		pNativeCmdList->SetGraphicsRootDescriptorTable(0, cbView.GetDesc()->GetGpuHandle());
-		pNativeCmdList->SetGraphicsRootDescriptorTable(1, pThis->pFontTextureView_->GetDesc()->GetGpuHandle());
-		pNativeCmdList->SetGraphicsRootDescriptorTable(2, pThis->pFontSampler_->GetDesc()->GetGpuHandle());
+		pCmdList->SetDescriptorHeaps(_countof(pDescHeaps), pDescHeaps);
+		pCmdList->SetGraphicsRootDescriptorTable(0, cbView.GetDesc()->GetTableGpuHandle());
+		pCmdList->SetGraphicsRootDescriptorTable(1, pThis->pFontTextureView_->GetDesc()->GetTableGpuHandle());
+		pCmdList->SetGraphicsRootDescriptorTable(2, pThis->pFontSampler_->GetDesc()->GetTableGpuHandle());
 
 		// DrawCall
 		D3D12_VERTEX_BUFFER_VIEW views[] = { vbView.GetView() };
-		pNativeCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		pNativeCmdList->IASetVertexBuffers(0, _countof(views), views);
-		pNativeCmdList->IASetIndexBuffer(&ibView.GetView());
+		pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		pCmdList->IASetVertexBuffers(0, _countof(views), views);
+		pCmdList->IASetIndexBuffer(&ibView.GetView());
 
 		// DrawCall
 		int vtx_offset = 0;
@@ -435,9 +434,10 @@ namespace sl12
 					rect.top = static_cast<s32>(pcmd->ClipRect.y);
 					rect.right = static_cast<s32>(pcmd->ClipRect.z);
 					rect.bottom = static_cast<s32>(pcmd->ClipRect.w);
-					pNativeCmdList->RSSetScissorRects(1, &rect);
+					// NOTE: ステートキャッシュ有効時は同じ矩形の再設定が省略される
+					pCmdList->RSSetScissorRects(1, &rect);
 
-					pNativeCmdList->DrawIndexedInstanced(pcmd->ElemCount, 1, idx_offset, vtx_offset, 0);
+					pCmdList->GetCommandList()->DrawIndexedInstanced(pcmd->ElemCount, 1, idx_offset, vtx_offset, 0);
 				}
 				idx_offset += pcmd->ElemCount;
 			}
@@ -0,0 +1,143 @@
+﻿#include <sl12/hierarchical_bitset.h>
+
+#include <sl12/bit_ops.h>
+#include <cassert>
+
+
+namespace sl12
+{
+	const u32 HierarchicalBitset::kInvalidIndex;
+
+	//----
+	void HierarchicalBitset::Initialize(u32 count, bool initialValue)
+	{
+		Destroy();
+
+		count_ = count;
+		if (count == 0)
+		{
+			return;
+		}
+
+		// 最上層が1ワードになるまで階層を作る
+		u32 num = count;
+		do
+		{
+			u32 words = (num + 63) / 64;
+			levels_.push_back(std::vector<u64>(words, 0));
+			num = words;
+		} while (num > 1);
+
+		if (initialValue)
+		{
+			u32 bits = count;
+			for (auto&& level : levels_)
+			{
+				for (u32 i = 0; i < bits / 64; i++)
+				{
+					level[i] = ~0ull;
+				}
+				if (bits % 64)
+				{
+					level[bits / 64] = (1ull << (bits % 64)) - 1;
+				}
+				bits = static_cast<u32>(level.size());
+			}
+			setCount_ = count;
+		}
+	}
+
+	//----
+	void HierarchicalBitset::Destroy()
+	{
+		levels_.clear();
+		count_ = setCount_ = 0;
+	}
+
+	//----
+	void HierarchicalBitset::Set(u32 index)
+	{
+		assert(index < count_);
+		if (Test(index))
+		{
+			return;
+		}
+
+		// 上位層のビットは下位のワードが0から変化したときのみ立てる
+		for (auto&& level : levels_)
+		{
+			u64& word = level[index / 64];
+			bool wasEmpty = (word == 0);
+			word |= (1ull << (index % 64));
+			if (!wasEmpty)
+			{
+				break;
+			}
+			index /= 64;
+		}
+		setCount_++;
+	}
+
+	//----
+	void HierarchicalBitset::Reset(u32 index)
+	{
+		assert(index < count_);
+		if (!Test(index))
+		{
+			return;
+		}
+
+		// 上位層のビットは下位のワードが0になったときのみ落とす
+		for (auto&& level : levels_)
+		{
+			u64& word = level[index / 64];
+			word &= ~(1ull << (index % 64));
+			if (word != 0)
+			{
+				break;
+			}
+			index /= 64;
+		}
+		setCount_--;
+	}
+
+	//----
+	bool HierarchicalBitset::Test(u32 index) const
+	{
+		assert(index < count_);
+		return (levels_[0][index / 64] & (1ull << (index % 64))) != 0;
+	}
+
+	//----
+	u32 HierarchicalBitset::FindFirstSet() const
+	{
+		if (setCount_ == 0)
+		{
+			return kInvalidIndex;
+		}
+
+		// 最上層から順に下る
+		u32 index = 0;
+		for (size_t i = levels_.size(); i > 0; i--)
+		{
+			u64 word = levels_[i - 1][index];
+			assert(word != 0);
+			index = index * 64 + static_cast<u32>(FindFirstBit64(word));
+		}
+		return index;
+	}
+
+	//----
+	size_t HierarchicalBitset::GetMemorySize() const
+	{
+		size_t ret = 0;
+		for (auto&& level : levels_)
+		{
+			ret += level.size() * sizeof(u64);
+		}
+		return ret;
+	}
+
+}	// namespace sl12
+
+//	EOF
@@ -1,5 +1,9 @@
 ﻿#include "sl12/mesh.h"
 
+#include "sl12/device.h"
+#include "sl12/command_list.h"
+#include "sl12/upload_ring.h"
+
 
 namespace sl12
 {
@@ -24,9 +28,7 @@ namespace sl12
 				return false;
 			}
 		
-			vb.buffer_.UpdateBuffer(pDev, pCmdList, reinterpret_cast<const u8*>(p_vertex_head) + offset, stride * shape->numVertices);
-			
-			return true;
+			return vb.buffer_.RecordUpdate(pDev->GetUploadRing(), pCmdList, reinterpret_cast<const u8*>(p_vertex_head) + offset, stride * shape->numVertices);
 		};
 
 		// 座標
@@ -80,9 +82,7 @@ namespace sl12
 			return false;
 		}
 
-		indexBuffer_.buffer_.UpdateBuffer(pDev, pCmdList, reinterpret_cast<const u8*>(p_vertex_head) + submesh->indexBufferOffset, sizeof(u32) * submesh->numSubmeshIndices);
-
-		return true;
+		return indexBuffer_.buffer_.RecordUpdate(pDev->GetUploadRing(), pCmdList, reinterpret_cast<const u8*>(p_vertex_head) + submesh->indexBufferOffset, sizeof(u32) * submesh->numSubmeshIndices);
 	}
 
 	//---------------------------------------
@@ -121,11 +121,15 @@ namespace sl12
 		assert(pShapes_ != nullptr);
 		assert(pSubmeshes_ != nullptr);
 
+		// バッファのコピー命令はまとめて実行する
+		pCmdList->Reset();
+
 		// シェイプの初期化
 		for (s32 i = 0; i < pHead_->numShapes; ++i)
 		{
 			if (!pShapes_[i].Initialize(pDev, pCmdList, &pSrcShapes[i], pVertexHead))
 			{
+				pCmdList->Close();
 				return false;
 			}
 		}
@@ -135,10 +139,18 @@ namespace sl12
 		{
 			if (!pSubmeshes_[i].Initialize(pDev, pCmdList, &pSrcSubmeshes[i], pVertexHead))
 			{
+				pCmdList->Close();
 				return false;
 			}
 		}
 
+		pCmdList->Close();
+		pCmdList->Execute();
+
+		UploadRing& ring = pDev->GetUploadRing();
+		ring.Submit(pCmdList->GetParentQueue());
+		ring.WaitIdle();
+
 		return true;
 	}
 
@@ -0,0 +1,219 @@
+﻿#include <sl12/pipeline_blob_cache.h>
+
+#include <sl12/cache_stream.h>
+#include <sl12/crc.h>
+#include <sl12/file.h>
+#include <cstdio>
+#include <cstring>
+
+
+namespace sl12
+{
+	namespace
+	{
+		// インデックスの1エントリのサイズ(key, offset, size, crc)
+		static const u32 kIndexEntrySize = 8 + 8 + 4 + 4;
+	}
+
+	const u32 PipelineBlobCache::kMagic;
+	const u32 PipelineBlobCache::kVersion;
+
+	//----
+	bool PipelineBlobCache::Load(const char* filename)
+	{
+		Clear();
+
+		File file;
+		if (!file.ReadFile(filename))
+		{
+			return false;
+		}
+
+		if (!LoadFromMemory(file.GetData(), file.GetSize()))
+		{
+			char text[256];
+			sprintf_s(text, "[sl12] PipelineBlobCache : %s is stale or corrupted, ignored.\n", filename);
+			OutputDebugStringA(text);
+			return false;
+		}
+		return true;
+	}
+
+	//----
+	bool PipelineBlobCache::LoadFromMemory(const void* pData, u64 size)
+	{
+		Clear();
+		if (!pData)
+		{
+			return false;
+		}
+
+		CacheReader reader(reinterpret_cast<const u8*>(pData), size);
+		u32 magic, version, count;
+		PipelineCacheIdentity identity;
+		if (!reader.Read32(magic) || !reader.Read32(version) || magic != kMagic || version != kVersion)
+		{
+			return false;
+		}
+		if (!reader.Read32(identity.vendorId) || !reader.Read32(identity.deviceId) || !reader.Read32(identity.subSysId)
+			|| !reader.Read32(identity.revision) || !reader.Read64(identity.driverVersion))
+		{
+			return false;
+		}
+		if (identity != identity_)
+		{
+			// ドライバが更新された場合などは全て破棄する
+			return false;
+		}
+		if (!reader.Read32(count) || !reader.CheckCount(count, kIndexEntrySize))
+		{
+			return false;
+		}
+
+		struct IndexEntry
+		{
+			u64		key;
+			u64		offset;
+			u32		size;
+			u32		crc;
+		};
+		std::vector<IndexEntry> index(count);
+		for (u32 i = 0; i < count; i++)
+		{
+			auto&& e = index[i];
+			reader.Read64(e.key);
+			reader.Read64(e.offset);
+			reader.Read32(e.size);
+			reader.Read32(e.crc);
+			if (i > 0 && index[i - 1].key >= e.key)
+			{
+				// インデックスはキー順でなければならない
+				return false;
+			}
+		}
+
+		const u8* pBlobs = reinterpret_cast<const u8*>(pData) + reader.GetOffset();
+		u64 blobsSize = size - reader.GetOffset();
+		for (auto&& e : index)
+		{
+			// 範囲外やCRCが一致しないエントリは破棄して、他のエントリは使用する
+			if (e.size == 0 || e.offset > blobsSize || e.size > blobsSize - e.offset
+				|| CalcCrc32(pBlobs + e.offset, e.size) != e.crc)
+			{
+				discardCount_++;
+				continue;
+			}
+
+			Item& item = entries_[e.key];
+			item.blob.assign(pBlobs + e.offset, pBlobs + e.offset + e.size);
+		}
+
+		return true;
+	}
+
+	//----
+	bool PipelineBlobCache::Save(const char* filename) const
+	{
+		std::vector<u8> data;
+		SaveToMemory(data);
+
+		std::ofstream fout(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!fout.is_open())
+		{
+			return false;
+		}
+		fout.write(reinterpret_cast<const char*>(data.data()), data.size());
+		return fout.good();
+	}
+
+	//----
+	void PipelineBlobCache::SaveToMemory(std::vector<u8>& outData) const
+	{
+		u32 count = 0;
+		for (auto&& v : entries_)
+		{
+			if (v.second.isUsed)
+				count++;
+		}
+
+		CacheWriter writer;
+		writer.Write32(kMagic);
+		writer.Write32(kVersion);
+		writer.Write32(identity_.vendorId);
+		writer.Write32(identity_.deviceId);
+		writer.Write32(identity_.subSysId);
+		writer.Write32(identity_.revision);
+		writer.Write64(identity_.driverVersion);
+		writer.Write32(count);
+
+		// std::mapはキー順なのでそのままインデックスにする
+		u64 offset = 0;
+		for (auto&& v : entries_)
+		{
+			if (v.second.isUsed)
+			{
+				auto&& blob = v.second.blob;
+				writer.Write64(v.first);
+				writer.Write64(offset);
+				writer.Write32(static_cast<u32>(blob.size()));
+				writer.Write32(CalcCrc32(blob.data(), blob.size()));
+				offset += blob.size();
+			}
+		}
+		for (auto&& v : entries_)
+		{
+			if (v.second.isUsed)
+			{
+				writer.WriteBytes(v.second.blob.data(), v.second.blob.size());
+			}
+		}
+
+		outData = writer.GetData();
+	}
+
+	//----
+	bool PipelineBlobCache::Find(u64 key, std::vector<u8>& outBlob)
+	{
+		auto it = entries_.find(key);
+		if (it == entries_.end())
+		{
+			missCount_++;
+			return false;
+		}
+
+		hitCount_++;
+		it->second.isUsed = true;
+		outBlob = it->second.blob;
+		return true;
+	}
+
+	//----
+	void PipelineBlobCache::Store(u64 key, const void* pData, size_t size)
+	{
+		if (!pData || !size)
+		{
+			return;
+		}
+
+		const u8* p = reinterpret_cast<const u8*>(pData);
+		Item& item = entries_[key];
+		item.blob.assign(p, p + size);
+		item.isUsed = true;
+	}
+
+	//----
+	void PipelineBlobCache::Remove(u64 key)
+	{
+		entries_.erase(key);
+	}
+
+	//----
+	void PipelineBlobCache::Clear()
+	{
+		entries_.clear();
+		hitCount_ = missCount_ = discardCount_ = 0;
+	}
+
+}	// namespace sl12
+
+//	EOF
@@ -0,0 +1,180 @@
+﻿#include <sl12/pipeline_compiler.h>
+
+#include <sl12/device.h>
+#include <cstdio>
+#include <string>
+
+
+namespace sl12
+{
+	//-------------------------------------------------
+	// 初期化
+	//-------------------------------------------------
+	bool PipelineCompiler::Initialize(Device* pDev, PipelineStateCache* pCache, u32 maxConcurrent)
+	{
+		if (!pDev || !pCache)
+		{
+			return false;
+		}
+		Destroy();
+
+		pDevice_ = pDev;
+		pCache_ = pCache;
+		isExit_ = false;
+		failedCount_ = 0;
+
+		if (maxConcurrent == 0)
+		{
+			maxConcurrent = std::thread::hardware_concurrency();
+			maxConcurrent = (maxConcurrent > 0) ? maxConcurrent : 1;
+		}
+		for (u32 i = 0; i < maxConcurrent; i++)
+		{
+			workers_.push_back(std::thread([this]() { WorkerMain(); }));
+		}
+		return true;
+	}
+
+	//-------------------------------------------------
+	// 破棄
+	//-------------------------------------------------
+	void PipelineCompiler::Destroy()
+	{
+		if (workers_.empty())
+		{
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			isExit_ = true;
+		}
+		taskCv_.notify_all();
+		for (auto&& t : workers_)
+		{
+			t.join();
+		}
+		workers_.clear();
+
+		pDevice_ = nullptr;
+		pCache_ = nullptr;
+	}
+
+	//-------------------------------------------------
+	// グラフィクスPSOのコンパイルを要求する
+	//-------------------------------------------------
+	std::shared_future<PipelineStateHandle> PipelineCompiler::CompileGraphics(const GraphicsPipelineStateDesc& desc)
+	{
+		// 入力レイアウトは呼び出し元のスタックにあることが多いのでコピーしておく
+		struct Request
+		{
+			GraphicsPipelineStateDesc				desc;
+			std::vector<D3D12_INPUT_ELEMENT_DESC>	elements;
+			std::vector<std::string>				semantics;
+		};
+		auto request = std::make_shared<Request>();
+		request->desc = desc;
+		if (desc.inputLayout.pElements && desc.inputLayout.numElements > 0)
+		{
+			request->elements.assign(desc.inputLayout.pElements, desc.inputLayout.pElements + desc.inputLayout.numElements);
+			request->semantics.reserve(request->elements.size());
+			for (auto&& e : request->elements)
+			{
+				request->semantics.push_back(e.SemanticName ? e.SemanticName : "");
+				e.SemanticName = request->semantics.back().c_str();
+			}
+			request->desc.inputLayout.pElements = request->elements.data();
+		}
+
+		PipelineStateCache* pCache = pCache_;
+		return Enqueue<PipelineStateHandle>([this, pCache, request]()
+		{
+			auto ret = pCache->CreateGraphics(request->desc);
+			if (!ret.IsValid())
+			{
+				failedCount_++;
+			}
+			return ret;
+		});
+	}
+
+	//-------------------------------------------------
+	// コンピュートPSOのコンパイルを要求する
+	//-------------------------------------------------
+	std::shared_future<PipelineStateHandle> PipelineCompiler::CompileCompute(const ComputePipelineStateDesc& desc)
+	{
+		PipelineStateCache* pCache = pCache_;
+		return Enqueue<PipelineStateHandle>([this, pCache, desc]()
+		{
+			auto ret = pCache->CreateCompute(desc);
+			if (!ret.IsValid())
+			{
+				failedCount_++;
+			}
+			return ret;
+		});
+	}
+
+	//-------------------------------------------------
+	// DXRステートオブジェクトの生成を要求する
+	//-------------------------------------------------
+	std::shared_future<bool> PipelineCompiler::CompileDxr(DxrPipelineState* pState, DxrPipelineStateDesc* pDesc)
+	{
+		Device* pDev = pDevice_;
+		return Enqueue<bool>([this, pDev, pState, pDesc]()
+		{
+			bool ret = pState->Initialize(pDev, *pDesc);
+			if (!ret)
+			{
+				failedCount_++;
+			}
+			return ret;
+		});
+	}
+
+	//-------------------------------------------------
+	// 全てのコンパイルの完了を待つ
+	//-------------------------------------------------
+	void PipelineCompiler::WaitAll()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		idleCv_.wait(lock, [this]() { return pendingCount_ == 0; });
+	}
+
+	//-------------------------------------------------
+	// ワーカースレッド
+	//-------------------------------------------------
+	void PipelineCompiler::WorkerMain()
+	{
+		for (;;)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				taskCv_.wait(lock, [this]() { return isExit_ || !tasks_.empty(); });
+				if (tasks_.empty())
+				{
+					// 終了要求があってもキューが空になるまでは処理を続ける
+					return;
+				}
+				task = std::move(tasks_.front());
+				tasks_.pop_front();
+			}
+
+			task();
+
+			bool isIdle;
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				isIdle = (--pendingCount_ == 0);
+			}
+			if (isIdle)
+			{
+				idleCv_.notify_all();
+			}
+		}
+	}
+
+}	// namespace sl12
+
+//	EOF
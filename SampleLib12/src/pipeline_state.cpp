@@ -4,6 +4,7 @@
 #include <sl12/root_signature.h>
 #include <sl12/shader.h>
 #include <sl12/texture_view.h>
+#include <cstdio>
 
 
 namespace sl12
@@ -72,23 +73,6 @@ namespace sl12
 			dst.BackFace = desc.depthStencil.stencilBackFace;
 		};
 
-		auto topoFunc = [&](D3D_PRIMITIVE_TOPOLOGY t)
-		{
-			D3D12_PRIMITIVE_TOPOLOGY_TYPE kTypes[] = {
-				D3D12_PRIMITIVE_TOPOLOGY_TYPE_UNDEFINED,		// D3D_PRIMITIVE_TOPOLOGY_UNDEFINED
-				D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT,			// D3D_PRIMITIVE_TOPOLOGY_POINTLIST
-				D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE,				// D3D_PRIMITIVE_TOPOLOGY_LINELIST
-				D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE,				// D3D_PRIMITIVE_TOPOLOGY_LINESTRIP
-				D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE,			// D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST
-				D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE,			// D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP
-				D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE,				// D3D_PRIMITIVE_TOPOLOGY_LINELIST_ADJ
-				D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE,				// D3D_PRIMITIVE_TOPOLOGY_LINESTRIP_ADJ
-				D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE,			// D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST_ADJ
-				D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE,			// D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP_ADJ
-			};
-			return (t < D3D_PRIMITIVE_TOPOLOGY_1_CONTROL_POINT_PATCHLIST) ? kTypes[t] : D3D12_PRIMITIVE_TOPOLOGY_TYPE_PATCH;
-		};
-
 		D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
 		psoDesc.InputLayout = { desc.inputLayout.pElements, desc.inputLayout.numElements };
 		psoDesc.pRootSignature = desc.pRootSignature->GetRootSignature();
@@ -116,7 +100,7 @@ namespace sl12
 		psoDesc.SampleMask = desc.blend.sampleMask;
 		rasterFunc(psoDesc.RasterizerState);
 		depthFunc(psoDesc.DepthStencilState);
-		psoDesc.PrimitiveTopologyType = topoFunc(desc.primTopology);
+		psoDesc.PrimitiveTopologyType = ToTopologyType(desc.primTopology);
 		psoDesc.NumRenderTargets = desc.numRTVs;
 		for (u32 i = 0; i < desc.numRTVs; i++)
 		{
@@ -124,6 +108,7 @@ namespace sl12
 		}
 		psoDesc.DSVFormat = desc.dsvFormat;
 		psoDesc.SampleDesc.Count = desc.multisampleCount;
+		psoDesc.CachedPSO = desc.cachedPSO;
 
 		auto hr = pDev->GetDeviceDep()->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&pPipelineState_));
 		if (FAILED(hr))
@@ -140,6 +125,24 @@ namespace sl12
 		SafeRelease(pPipelineState_);
 	}
 
+	//----
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE GraphicsPipelineState::ToTopologyType(D3D_PRIMITIVE_TOPOLOGY t)
+	{
+		const D3D12_PRIMITIVE_TOPOLOGY_TYPE kTypes[] = {
+			D3D12_PRIMITIVE_TOPOLOGY_TYPE_UNDEFINED,		// D3D_PRIMITIVE_TOPOLOGY_UNDEFINED
+			D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT,			// D3D_PRIMITIVE_TOPOLOGY_POINTLIST
+			D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE,				// D3D_PRIMITIVE_TOPOLOGY_LINELIST
+			D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE,				// D3D_PRIMITIVE_TOPOLOGY_LINESTRIP
+			D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE,			// D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST
+			D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE,			// D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP
+			D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE,				// D3D_PRIMITIVE_TOPOLOGY_LINELIST_ADJ
+			D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE,				// D3D_PRIMITIVE_TOPOLOGY_LINESTRIP_ADJ
+			D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE,			// D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST_ADJ
+			D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE,			// D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP_ADJ
+		};
+		return (t < D3D_PRIMITIVE_TOPOLOGY_1_CONTROL_POINT_PATCHLIST) ? kTypes[t] : D3D12_PRIMITIVE_TOPOLOGY_TYPE_PATCH;
+	}
+
 
 	//----
 	bool ComputePipelineState::Initialize(Device* pDev, const ComputePipelineStateDesc& desc)
@@ -156,6 +159,7 @@ namespace sl12
 		D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
 		psoDesc.pRootSignature = desc.pRootSignature->GetRootSignature();
 		psoDesc.CS = { reinterpret_cast<const UINT8*>(desc.pCS->GetData()), desc.pCS->GetSize() };
+		psoDesc.CachedPSO = desc.cachedPSO;
 
 		auto hr = pDev->GetDeviceDep()->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&pPipelineState_));
 		if (FAILED(hr))
@@ -173,9 +177,48 @@ namespace sl12
 	}
 
 
+	//----
+	bool DxrPipelineStateDesc::Validate() const
+	{
+		for (auto&& e : exportAssociationIndices_)
+		{
+			// 関連付けのインデックスはサブオブジェクト追加時のものなので、配列の伸長後も同じサブオブジェクトを指す
+			if (e <= 0 || e >= (int)subobjects_.size() || subobjects_[e].Type != D3D12_STATE_SUBOBJECT_TYPE_SUBOBJECT_TO_EXPORTS_ASSOCIATION)
+			{
+				char text[256];
+				sprintf_s(text, "[sl12] DxrPipelineStateDesc : export association index %d is out of range.\n", e);
+				OutputDebugStringA(text);
+				return false;
+			}
+
+			auto type = subobjects_[e - 1].Type;
+			bool isAssociable = (type == D3D12_STATE_SUBOBJECT_TYPE_LOCAL_ROOT_SIGNATURE)
+				|| (type == D3D12_STATE_SUBOBJECT_TYPE_GLOBAL_ROOT_SIGNATURE)
+				|| (type == D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_SHADER_CONFIG)
+				|| (type == D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_PIPELINE_CONFIG)
+				|| (type == D3D12_STATE_SUBOBJECT_TYPE_NODE_MASK)
+				|| (type == D3D12_STATE_SUBOBJECT_TYPE_STATE_OBJECT_CONFIG);
+			auto pAssociation = reinterpret_cast<const D3D12_SUBOBJECT_TO_EXPORTS_ASSOCIATION*>(subobjects_[e].pDesc);
+			if (!isAssociable || !pAssociation || (pAssociation->NumExports > 0 && !pAssociation->pExports))
+			{
+				char text[256];
+				sprintf_s(text, "[sl12] DxrPipelineStateDesc : export association %d does not follow an associable subobject.\n", e);
+				OutputDebugStringA(text);
+				return false;
+			}
+		}
+		return true;
+	}
+
+
 	//----
 	bool DxrPipelineState::Initialize(Device* pDev, DxrPipelineStateDesc& dxrDesc)
 	{
+		if (!dxrDesc.Validate())
+		{
+			return false;
+		}
+
 		D3D12_STATE_OBJECT_DESC psoDesc = dxrDesc.GetStateObjectDesc();
 
 		auto hr = pDev->GetDxrDeviceDep()->CreateStateObject(&psoDesc, IID_PPV_ARGS(&pDxrStateObject_));
@@ -0,0 +1,409 @@
+﻿#include <sl12/pipeline_state_cache.h>
+
+#include <sl12/crc.h>
+#include <sl12/device.h>
+#include <sl12/root_signature.h>
+#include <sl12/shader.h>
+#include <cstdio>
+#include <cstring>
+
+
+namespace sl12
+{
+	namespace
+	{
+		// 構造体のパディングを含めないように値を1つずつハッシュに加える
+		class KeyHasher
+		{
+		public:
+			template <typename T>
+			void Add(const T& v)
+			{
+				hash_ = CalcFnv1a64(&v, sizeof(v), hash_);
+			}
+			void AddString(const char* str)
+			{
+				if (str)
+				{
+					hash_ = CalcFnv1a64(str, strlen(str) + 1, hash_);
+				}
+				else
+				{
+					Add<u8>(0);
+				}
+			}
+			void AddShader(const Shader* pShader)
+			{
+				Add<u64>(pShader ? pShader->GetHash() : 0);
+			}
+			void AddRootSignature(const RootSignature* pRootSig)
+			{
+				Add<u64>(pRootSig ? pRootSig->GetHash() : 0);
+			}
+
+			u64 GetHash() const { return hash_; }
+
+		private:
+			u64		hash_ = 0xcbf29ce484222325ull;
+		};	// class KeyHasher
+
+		enum PipelineKind : u8
+		{
+			kPipelineGraphics,
+			kPipelineCompute,
+		};	// enum PipelineKind
+
+	}	// namespace
+
+
+	//-------------------------------------------------
+	// ハンドルを無効化する
+	//-------------------------------------------------
+	void PipelineStateHandle::Invalid()
+	{
+		if (pInstance_)
+		{
+			pCache_->ReleasePipelineState(key_, pInstance_);
+			pCache_ = nullptr;
+			pInstance_ = nullptr;
+		}
+	}
+
+
+	//-------------------------------------------------
+	// 初期化
+	//-------------------------------------------------
+	bool PipelineStateCache::Initialize(Device* pDev)
+	{
+		pDevice_ = pDev;
+		return (pDev != nullptr);
+	}
+
+	//-------------------------------------------------
+	// 破棄
+	//-------------------------------------------------
+	void PipelineStateCache::Destroy()
+	{
+		if (pDevice_)
+		{
+			char text[256];
+			sprintf_s(text, "[sl12] PipelineStateCache : %u PSOs (hit %u, miss %u)\n", instances_.GetCount(), instances_.GetHitCount(), instances_.GetMissCount());
+			OutputDebugStringA(text);
+
+			instances_.Clear();
+			blobCache_.Clear();
+			isBlobCacheEnabled_ = false;
+			pDevice_ = nullptr;
+		}
+	}
+
+	//-------------------------------------------------
+	// グラフィクスパイプラインステートを取得する
+	//-------------------------------------------------
+	PipelineStateHandle PipelineStateCache::CreateGraphics(const GraphicsPipelineStateDesc& desc)
+	{
+		if (!pDevice_ || !desc.pRootSignature)
+		{
+			return PipelineStateHandle();
+		}
+
+		u64 key = CalcGraphicsKey(desc);
+		auto pInstance = instances_.Acquire(key, [&]() -> PipelineStateInstance*
+		{
+			auto ret = new PipelineStateInstance();
+			ret->isGraphics_ = true;
+
+			GraphicsPipelineStateDesc d = desc;
+			std::vector<u8> blob;
+			if (FindBlob(key, blob))
+			{
+				d.cachedPSO.pCachedBlob = blob.data();
+				d.cachedPSO.CachedBlobSizeInBytes = blob.size();
+			}
+			if (!ret->graphics_.Initialize(pDevice_, d))
+			{
+				if (blob.empty())
+				{
+					delete ret;
+					return nullptr;
+				}
+
+				// ドライバ更新等でキャッシュが使用できない場合はキャッシュなしで生成し直す
+				DiscardBlob(key);
+				blob.clear();
+				d.cachedPSO = {};
+				if (!ret->graphics_.Initialize(pDevice_, d))
+				{
+					delete ret;
+					return nullptr;
+				}
+			}
+			if (blob.empty())
+			{
+				StoreBlob(key, ret->graphics_.GetPSO());
+			}
+			return ret;
+		});
+
+		return PipelineStateHandle(this, key, pInstance);
+	}
+
+	//-------------------------------------------------
+	// コンピュートパイプラインステートを取得する
+	//-------------------------------------------------
+	PipelineStateHandle PipelineStateCache::CreateCompute(const ComputePipelineStateDesc& desc)
+	{
+		if (!pDevice_ || !desc.pRootSignature || !desc.pCS)
+		{
+			return PipelineStateHandle();
+		}
+
+		u64 key = CalcComputeKey(desc);
+		auto pInstance = instances_.Acquire(key, [&]() -> PipelineStateInstance*
+		{
+			auto ret = new PipelineStateInstance();
+			ret->isGraphics_ = false;
+
+			ComputePipelineStateDesc d = desc;
+			std::vector<u8> blob;
+			if (FindBlob(key, blob))
+			{
+				d.cachedPSO.pCachedBlob = blob.data();
+				d.cachedPSO.CachedBlobSizeInBytes = blob.size();
+			}
+			if (!ret->compute_.Initialize(pDevice_, d))
+			{
+				if (blob.empty())
+				{
+					delete ret;
+					return nullptr;
+				}
+
+				// ドライバ更新等でキャッシュが使用できない場合はキャッシュなしで生成し直す
+				DiscardBlob(key);
+				blob.clear();
+				d.cachedPSO = {};
+				if (!ret->compute_.Initialize(pDevice_, d))
+				{
+					delete ret;
+					return nullptr;
+				}
+			}
+			if (blob.empty())
+			{
+				StoreBlob(key, ret->compute_.GetPSO());
+			}
+			return ret;
+		});
+
+		return PipelineStateHandle(this, key, pInstance);
+	}
+
+	//-------------------------------------------------
+	// パイプラインステートを解放する
+	//-------------------------------------------------
+	void PipelineStateCache::ReleasePipelineState(u64 key, PipelineStateInstance* pInst)
+	{
+		instances_.Release(key, pInst);
+	}
+
+	//-------------------------------------------------
+	// コンパイル済みPSOのファイルキャッシュを読み込む
+	//-------------------------------------------------
+	bool PipelineStateCache::LoadCache(const char* filename)
+	{
+		if (!pDevice_)
+		{
+			return false;
+		}
+
+		// アダプタとユーザーモードドライバのバージョンで識別する
+		PipelineCacheIdentity identity;
+		auto pAdapter = pDevice_->GetAdapterDep();
+		DXGI_ADAPTER_DESC1 adapterDesc{};
+		if (pAdapter && SUCCEEDED(pAdapter->GetDesc1(&adapterDesc)))
+		{
+			identity.vendorId = adapterDesc.VendorId;
+			identity.deviceId = adapterDesc.DeviceId;
+			identity.subSysId = adapterDesc.SubSysId;
+			identity.revision = adapterDesc.Revision;
+
+			LARGE_INTEGER driverVersion{};
+			if (SUCCEEDED(pAdapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &driverVersion)))
+			{
+				identity.driverVersion = static_cast<u64>(driverVersion.QuadPart);
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(blobMutex_);
+		isBlobCacheEnabled_ = true;
+		blobCache_.SetIdentity(identity);
+		return blobCache_.Load(filename);
+	}
+
+	//-------------------------------------------------
+	// コンパイル済みPSOのファイルキャッシュを保存する
+	//-------------------------------------------------
+	bool PipelineStateCache::SaveCache(const char* filename) const
+	{
+		std::lock_guard<std::mutex> lock(blobMutex_);
+		if (!isBlobCacheEnabled_)
+		{
+			return false;
+		}
+		return blobCache_.Save(filename);
+	}
+
+	//-------------------------------------------------
+	// コンパイル済みPSOを検索する
+	//-------------------------------------------------
+	bool PipelineStateCache::FindBlob(u64 key, std::vector<u8>& outBlob)
+	{
+		std::lock_guard<std::mutex> lock(blobMutex_);
+		return isBlobCacheEnabled_ && blobCache_.Find(key, outBlob);
+	}
+
+	//-------------------------------------------------
+	// コンパイル済みPSOを登録する
+	//-------------------------------------------------
+	void PipelineStateCache::StoreBlob(u64 key, ID3D12PipelineState* pPSO)
+	{
+		if (!isBlobCacheEnabled_ || !pPSO)
+		{
+			return;
+		}
+
+		ID3DBlob* pBlob = nullptr;
+		if (FAILED(pPSO->GetCachedBlob(&pBlob)))
+		{
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(blobMutex_);
+			blobCache_.Store(key, pBlob->GetBufferPointer(), pBlob->GetBufferSize());
+		}
+		SafeRelease(pBlob);
+	}
+
+	//-------------------------------------------------
+	// 使用できないコンパイル済みPSOを破棄する
+	//-------------------------------------------------
+	void PipelineStateCache::DiscardBlob(u64 key)
+	{
+		char text[256];
+		sprintf_s(text, "[sl12] PipelineStateCache : cached PSO %016llx rejected, recompiling.\n", key);
+		OutputDebugStringA(text);
+
+		std::lock_guard<std::mutex> lock(blobMutex_);
+		blobCache_.Remove(key);
+	}
+
+	//-------------------------------------------------
+	// グラフィクスパイプラインステートのキーを計算する
+	//-------------------------------------------------
+	u64 PipelineStateCache::CalcGraphicsKey(const GraphicsPipelineStateDesc& desc)
+	{
+		KeyHasher h;
+		h.Add<u8>(kPipelineGraphics);
+		h.AddRootSignature(desc.pRootSignature);
+		h.AddShader(desc.pVS);
+		h.AddShader(desc.pPS);
+		h.AddShader(desc.pGS);
+		h.AddShader(desc.pDS);
+		h.AddShader(desc.pHS);
+
+		// ブレンド
+		// 独立ブレンドが無効の場合は0番のみが使用される
+		h.Add(desc.blend.isAlphaToCoverageEnable);
+		h.Add(desc.blend.isIndependentBlend);
+		h.Add(desc.blend.sampleMask);
+		u32 numBlends = desc.blend.isIndependentBlend ? 8 : 1;
+		for (u32 i = 0; i < numBlends; i++)
+		{
+			auto&& rt = desc.blend.rtDesc[i];
+			h.Add(rt.isBlendEnable);
+			h.Add(rt.isLogicBlendEnable);
+			h.Add(rt.srcBlendColor);
+			h.Add(rt.dstBlendColor);
+			h.Add(rt.blendOpColor);
+			h.Add(rt.srcBlendAlpha);
+			h.Add(rt.dstBlendAlpha);
+			h.Add(rt.blendOpAlpha);
+			h.Add(rt.logicOp);
+			h.Add(rt.writeMask);
+		}
+
+		// ラスタライザ
+		h.Add(desc.rasterizer.fillMode);
+		h.Add(desc.rasterizer.cullMode);
+		h.Add(desc.rasterizer.isFrontCCW);
+		h.Add(desc.rasterizer.depthBias);
+		h.Add(desc.rasterizer.depthBiasClamp);
+		h.Add(desc.rasterizer.slopeScaledDepthBias);
+		h.Add(desc.rasterizer.isDepthClipEnable);
+		h.Add(desc.rasterizer.isMultisampleEnable);
+		h.Add(desc.rasterizer.isAntialiasedLineEnable);
+		h.Add(desc.rasterizer.isConservativeRasterEnable);
+
+		// 深度ステンシル
+		auto AddStencilOp = [&](const D3D12_DEPTH_STENCILOP_DESC& op)
+		{
+			h.Add(op.StencilFailOp);
+			h.Add(op.StencilDepthFailOp);
+			h.Add(op.StencilPassOp);
+			h.Add(op.StencilFunc);
+		};
+		h.Add(desc.depthStencil.isDepthEnable);
+		h.Add(desc.depthStencil.isDepthWriteEnable);
+		h.Add(desc.depthStencil.depthFunc);
+		h.Add(desc.depthStencil.isStencilEnable);
+		h.Add(desc.depthStencil.stencilReadMask);
+		h.Add(desc.depthStencil.stencilWriteMask);
+		AddStencilOp(desc.depthStencil.stencilFrontFace);
+		AddStencilOp(desc.depthStencil.stencilBackFace);
+
+		// 入力レイアウト
+		u32 numElements = desc.inputLayout.pElements ? desc.inputLayout.numElements : 0;
+		h.Add(numElements);
+		for (u32 i = 0; i < numElements; i++)
+		{
+			auto&& e = desc.inputLayout.pElements[i];
+			h.AddString(e.SemanticName);
+			h.Add(e.SemanticIndex);
+			h.Add(e.Format);
+			h.Add(e.InputSlot);
+			h.Add(e.AlignedByteOffset);
+			h.Add(e.InputSlotClass);
+			h.Add(e.InstanceDataStepRate);
+		}
+
+		// PSOにはトポロジタイプのみが設定される
+		h.Add(GraphicsPipelineState::ToTopologyType(desc.primTopology));
+
+		// 出力
+		h.Add(desc.numRTVs);
+		for (u32 i = 0; i < desc.numRTVs; i++)
+		{
+			h.Add(desc.rtvFormats[i]);
+		}
+		h.Add(desc.dsvFormat);
+		h.Add(desc.multisampleCount);
+
+		return h.GetHash();
+	}
+
+	//-------------------------------------------------
+	// コンピュートパイプラインステートのキーを計算する
+	//-------------------------------------------------
+	u64 PipelineStateCache::CalcComputeKey(const ComputePipelineStateDesc& desc)
+	{
+		KeyHasher h;
+		h.Add<u8>(kPipelineCompute);
+		h.AddRootSignature(desc.pRootSignature);
+		h.AddShader(desc.pCS);
+		return h.GetHash();
+	}
+
+}	// namespace sl12
+
+//	EOF
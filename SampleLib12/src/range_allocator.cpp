@@ -0,0 +1,334 @@
+﻿#include <sl12/range_allocator.h>
+
+#include <sl12/bit_ops.h>
+#include <cassert>
+
+
+namespace sl12
+{
+	const u32 RangeAllocator::kInvalidOffset;
+	const u32 RangeAllocator::kNull;
+
+	//----
+	bool RangeAllocator::Initialize(u32 capacity)
+	{
+		Destroy();
+
+		if (capacity == 0 || capacity == kInvalidOffset)
+		{
+			return false;
+		}
+
+		capacity_ = capacity;
+		offsetToBlock_.assign(capacity, kNull);
+		for (auto&& fl : freeHeads_)
+		{
+			for (auto&& head : fl)
+			{
+				head = kNull;
+			}
+		}
+
+		// 全領域をひとつの空きブロックとする
+		u32 block = NewBlock();
+		blocks_[block].offset = 0;
+		blocks_[block].size = capacity;
+		InsertFreeBlock(block);
+
+		return true;
+	}
+
+	//----
+	void RangeAllocator::Destroy()
+	{
+		blocks_.clear();
+		unusedBlocks_.clear();
+		offsetToBlock_.clear();
+		flBitmap_ = 0;
+		for (auto&& sl : slBitmap_)
+		{
+			sl = 0;
+		}
+		capacity_ = usedSize_ = allocCount_ = freeBlockCount_ = 0;
+	}
+
+	//----
+	u32 RangeAllocator::Allocate(u32 size)
+	{
+		if (size == 0 || size > GetFreeSize())
+		{
+			return kInvalidOffset;
+		}
+
+		u32 block = FindFreeBlock(size);
+		if (block == kNull)
+		{
+			return kInvalidOffset;
+		}
+		RemoveFreeBlock(block);
+
+		// 余剰分を分割して空きリストに戻す
+		if (blocks_[block].size > size)
+		{
+			u32 rest = NewBlock();
+			Block& b = blocks_[block];
+			Block& r = blocks_[rest];
+			r.offset = b.offset + size;
+			r.size = b.size - size;
+			r.prevPhys = block;
+			r.nextPhys = b.nextPhys;
+			if (b.nextPhys != kNull)
+			{
+				blocks_[b.nextPhys].prevPhys = rest;
+			}
+			b.nextPhys = rest;
+			b.size = size;
+			InsertFreeBlock(rest);
+		}
+
+		Block& b = blocks_[block];
+		b.isFree = false;
+		offsetToBlock_[b.offset] = block;
+		usedSize_ += size;
+		allocCount_++;
+
+		return b.offset;
+	}
+
+	//----
+	void RangeAllocator::Free(u32 offset)
+	{
+		assert(offset < capacity_);
+		u32 block = offsetToBlock_[offset];
+		assert(block != kNull);
+		assert(!blocks_[block].isFree);
+
+		offsetToBlock_[offset] = kNull;
+		usedSize_ -= blocks_[block].size;
+		allocCount_--;
+
+		// 前方の空きブロックと結合
+		u32 prev = blocks_[block].prevPhys;
+		if (prev != kNull && blocks_[prev].isFree)
+		{
+			RemoveFreeBlock(prev);
+			blocks_[prev].size += blocks_[block].size;
+			blocks_[prev].nextPhys = blocks_[block].nextPhys;
+			if (blocks_[block].nextPhys != kNull)
+			{
+				blocks_[blocks_[block].nextPhys].prevPhys = prev;
+			}
+			DeleteBlock(block);
+			block = prev;
+		}
+
+		// 後方の空きブロックと結合
+		u32 next = blocks_[block].nextPhys;
+		if (next != kNull && blocks_[next].isFree)
+		{
+			RemoveFreeBlock(next);
+			blocks_[block].size += blocks_[next].size;
+			blocks_[block].nextPhys = blocks_[next].nextPhys;
+			if (blocks_[next].nextPhys != kNull)
+			{
+				blocks_[blocks_[next].nextPhys].prevPhys = block;
+			}
+			DeleteBlock(next);
+		}
+
+		InsertFreeBlock(block);
+	}
+
+	//----
+	u32 RangeAllocator::GetAllocationSize(u32 offset) const
+	{
+		if (offset >= capacity_ || offsetToBlock_[offset] == kNull)
+		{
+			return 0;
+		}
+		return blocks_[offsetToBlock_[offset]].size;
+	}
+
+	//----
+	u32 RangeAllocator::GetLargestFreeSize() const
+	{
+		if (flBitmap_ == 0)
+		{
+			return 0;
+		}
+
+		// 最上位のリストにある最大のブロックが最大の空き領域
+		u32 fl = static_cast<u32>(FindLastBit32(flBitmap_));
+		u32 sl = static_cast<u32>(FindLastBit32(slBitmap_[fl]));
+		u32 ret = 0;
+		for (u32 block = freeHeads_[fl][sl]; block != kNull; block = blocks_[block].nextFree)
+		{
+			ret = (blocks_[block].size > ret) ? blocks_[block].size : ret;
+		}
+		return ret;
+	}
+
+	//----
+	float RangeAllocator::GetFragmentation() const
+	{
+		u32 freeSize = GetFreeSize();
+		if (freeSize == 0)
+		{
+			return 0.0f;
+		}
+		return 1.0f - static_cast<float>(GetLargestFreeSize()) / static_cast<float>(freeSize);
+	}
+
+	//----
+	void RangeAllocator::Mapping(u32 size, u32& fl, u32& sl)
+	{
+		if (size < kSLCount)
+		{
+			fl = 0;
+			sl = size;
+		}
+		else
+		{
+			u32 msb = static_cast<u32>(FindLastBit32(size));
+			sl = (size >> (msb - kSLCountLog2)) ^ kSLCount;
+			fl = msb - kSLCountLog2 + 1;
+		}
+	}
+
+	//----
+	bool RangeAllocator::MappingSearch(u32 size, u32& fl, u32& sl)
+	{
+		// 要求サイズ以上のブロックだけが入っているリストを指すよう切り上げる
+		if (size >= kSLCount)
+		{
+			u32 round = (1u << (FindLastBit32(size) - kSLCountLog2)) - 1;
+			if (size > ~0u - round)
+			{
+				return false;
+			}
+			size += round;
+		}
+		Mapping(size, fl, sl);
+		return true;
+	}
+
+	//----
+	u32 RangeAllocator::NewBlock()
+	{
+		u32 ret;
+		if (!unusedBlocks_.empty())
+		{
+			ret = unusedBlocks_.back();
+			unusedBlocks_.pop_back();
+		}
+		else
+		{
+			ret = static_cast<u32>(blocks_.size());
+			blocks_.push_back(Block());
+		}
+
+		Block& b = blocks_[ret];
+		b.offset = b.size = 0;
+		b.prevPhys = b.nextPhys = b.prevFree = b.nextFree = kNull;
+		b.isFree = false;
+		return ret;
+	}
+
+	//----
+	void RangeAllocator::DeleteBlock(u32 block)
+	{
+		unusedBlocks_.push_back(block);
+	}
+
+	//----
+	void RangeAllocator::InsertFreeBlock(u32 block)
+	{
+		u32 fl, sl;
+		Mapping(blocks_[block].size, fl, sl);
+
+		Block& b = blocks_[block];
+		b.isFree = true;
+		b.prevFree = kNull;
+		b.nextFree = freeHeads_[fl][sl];
+		if (b.nextFree != kNull)
+		{
+			blocks_[b.nextFree].prevFree = block;
+		}
+		freeHeads_[fl][sl] = block;
+		flBitmap_ |= (1u << fl);
+		slBitmap_[fl] |= (1u << sl);
+		freeBlockCount_++;
+	}
+
+	//----
+	void RangeAllocator::RemoveFreeBlock(u32 block)
+	{
+		u32 fl, sl;
+		Mapping(blocks_[block].size, fl, sl);
+
+		Block& b = blocks_[block];
+		if (b.prevFree != kNull)
+		{
+			blocks_[b.prevFree].nextFree = b.nextFree;
+		}
+		else
+		{
+			freeHeads_[fl][sl] = b.nextFree;
+			if (b.nextFree == kNull)
+			{
+				slBitmap_[fl] &= ~(1u << sl);
+				if (slBitmap_[fl] == 0)
+				{
+					flBitmap_ &= ~(1u << fl);
+				}
+			}
+		}
+		if (b.nextFree != kNull)
+		{
+			blocks_[b.nextFree].prevFree = b.prevFree;
+		}
+		b.isFree = false;
+		b.prevFree = b.nextFree = kNull;
+		freeBlockCount_--;
+	}
+
+	//----
+	u32 RangeAllocator::FindFreeBlock(u32 size)
+	{
+		u32 fl, sl;
+		if (MappingSearch(size, fl, sl) && fl < kFLCount)
+		{
+			// 同じFL内でsl以上のリストを探す
+			u32 slMap = slBitmap_[fl] & (~0u << sl);
+			if (slMap == 0 && fl + 1 < kFLCount)
+			{
+				// 上位のFLを探す
+				u32 flMap = flBitmap_ & (~0u << (fl + 1));
+				if (flMap != 0)
+				{
+					fl = static_cast<u32>(FindFirstBit32(flMap));
+					slMap = slBitmap_[fl];
+				}
+			}
+			if (slMap != 0)
+			{
+				sl = static_cast<u32>(FindFirstBit32(slMap));
+				return freeHeads_[fl][sl];
+			}
+		}
+
+		// 切り上げにより見つからなかった場合、要求サイズが属するリストを直接探す
+		Mapping(size, fl, sl);
+		for (u32 block = freeHeads_[fl][sl]; block != kNull; block = blocks_[block].nextFree)
+		{
+			if (blocks_[block].size >= size)
+			{
+				return block;
+			}
+		}
+		return kNull;
+	}
+
+}	// namespace sl12
+
+//	EOF
@@ -1,18 +1,20 @@
 ﻿#include <sl12/root_signature.h>
 
+#include <sl12/crc.h>
 #include <sl12/device.h>
+#include <sl12/bindless_descriptor_table.h>
+#include <algorithm>
+#include <cstdio>
 
 
 namespace sl12
 {
-	//----
-	bool RootSignature::Initialize(Device* pDev, const RootSignatureDesc& desc)
-	{
-		static const u32 kMaxParameters = 64;
-		D3D12_DESCRIPTOR_RANGE ranges[kMaxParameters];
-		D3D12_ROOT_PARAMETER rootParameters[kMaxParameters];
+	const u32 RootSignature::kMaxParameters;
+	const u32 RootSignature::kMaxDWords;
 
-		auto getRangeFunc = [&](u32 index)
+	namespace
+	{
+		D3D12_DESCRIPTOR_RANGE_TYPE GetRangeType(RootParameterType::Type type)
 		{
 			static const D3D12_DESCRIPTOR_RANGE_TYPE kType[] = {
 				D3D12_DESCRIPTOR_RANGE_TYPE_CBV,
@@ -20,11 +22,12 @@ namespace sl12
 				D3D12_DESCRIPTOR_RANGE_TYPE_UAV,
 				D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER,
 			};
-			return kType[desc.pParameters[index].type];
-		};
-		auto getShaderVisFunc = [&](u32 index)
+			return kType[type];
+		}
+
+		D3D12_SHADER_VISIBILITY GetShaderVisibility(u32 shaderVisibility)
 		{
-			switch (desc.pParameters[index].shaderVisibility)
+			switch (shaderVisibility)
 			{
 			case ShaderVisibility::Vertex: return D3D12_SHADER_VISIBILITY_VERTEX;
 			case ShaderVisibility::Pixel: return D3D12_SHADER_VISIBILITY_PIXEL;
@@ -33,47 +36,291 @@ namespace sl12
 			case ShaderVisibility::Hull: return D3D12_SHADER_VISIBILITY_HULL;
 			default: return D3D12_SHADER_VISIBILITY_ALL;
 			}
-		};
+		}
+
+		bool IsDirectParameter(RootParameterType::Type type)
+		{
+			return (type == RootParameterType::RootConstants) || (type == RootParameterType::RootConstantBuffer);
+		}
+	}
+
+	//----
+	u32 RootSignature::CalcParameterSlots(const RootSignatureDesc& desc, RootParameterSlot* pOutSlots, u32* pOutTableSizes)
+	{
+		assert(desc.numParameters <= kMaxParameters);
+
+		u32 tableSizes[kMaxParameters] = { 0 };
+		u32 numRootParams = 0;
+
+		// ルート定数、ルートCBVは先頭に配置する
+		for (u32 i = 0; i < desc.numParameters; ++i)
+		{
+			if (IsDirectParameter(desc.pParameters[i].type))
+			{
+				pOutSlots[i].rootIndex = numRootParams++;
+				pOutSlots[i].tableOffset = 0;
+			}
+		}
+
+		if (!desc.coalesceTables)
+		{
+			// まとめない場合は1パラメータ1テーブル
+			for (u32 i = 0; i < desc.numParameters; ++i)
+			{
+				if (!IsDirectParameter(desc.pParameters[i].type))
+				{
+					pOutSlots[i].rootIndex = numRootParams;
+					pOutSlots[i].tableOffset = 0;
+					tableSizes[numRootParams++] = 1;
+				}
+			}
+		}
+		else
+		{
+			// 可視性とヒープ種別でグループ分けする
+			D3D12_SHADER_VISIBILITY groupVis[kMaxParameters];
+			bool groupSampler[kMaxParameters];
+			u32 groupOfParam[kMaxParameters];
+			u32 order[kMaxParameters];
+			u32 numGroups = 0;
+			u32 numTableParams = 0;
+			for (u32 i = 0; i < desc.numParameters; ++i)
+			{
+				if (IsDirectParameter(desc.pParameters[i].type))
+				{
+					continue;
+				}
+
+				auto vis = GetShaderVisibility(desc.pParameters[i].shaderVisibility);
+				bool isSampler = desc.pParameters[i].type == RootParameterType::Sampler;
+				u32 g = 0;
+				for (; g < numGroups; ++g)
+				{
+					if (groupVis[g] == vis && groupSampler[g] == isSampler)
+					{
+						break;
+					}
+				}
+				if (g == numGroups)
+				{
+					groupVis[numGroups] = vis;
+					groupSampler[numGroups] = isSampler;
+					numGroups++;
+				}
+				groupOfParam[i] = g;
+				order[numTableParams++] = i;
+			}
+
+			// グループ内は種別、レジスタ番号の順に並べてオフセットを決める
+			std::sort(order, order + numTableParams, [&](u32 l, u32 r)
+			{
+				const RootParameter& pl = desc.pParameters[l];
+				const RootParameter& pr = desc.pParameters[r];
+				if (groupOfParam[l] != groupOfParam[r]) return groupOfParam[l] < groupOfParam[r];
+				if (pl.type != pr.type) return pl.type < pr.type;
+				if (pl.registerIndex != pr.registerIndex) return pl.registerIndex < pr.registerIndex;
+				return l < r;
+			});
+
+			for (u32 i = 0; i < numTableParams; ++i)
+			{
+				u32 index = order[i];
+				u32 rootIndex = numRootParams + groupOfParam[index];
+				pOutSlots[index].rootIndex = rootIndex;
+				pOutSlots[index].tableOffset = tableSizes[rootIndex]++;
+			}
+			numRootParams += numGroups;
+		}
+
+		if (pOutTableSizes)
+		{
+			memcpy(pOutTableSizes, tableSizes, sizeof(u32) * numRootParams);
+		}
+		return numRootParams;
+	}
+
+	//----
+	u32 RootSignature::CalcDWordCount(const RootSignatureDesc& desc)
+	{
+		RootParameterSlot slots[kMaxParameters];
+		u32 tableSizes[kMaxParameters];
+		u32 numRootParams = CalcParameterSlots(desc, slots, tableSizes);
+
+		u32 ret = desc.useBindless ? 2 : 0;
+		for (u32 i = 0; i < numRootParams; ++i)
+		{
+			ret += (tableSizes[i] > 0) ? 1 : 0;
+		}
+		for (u32 i = 0; i < desc.numParameters; ++i)
+		{
+			if (desc.pParameters[i].type == RootParameterType::RootConstants)
+				ret += desc.pParameters[i].num32BitValues;
+			else if (desc.pParameters[i].type == RootParameterType::RootConstantBuffer)
+				ret += 2;
+		}
+		return ret;
+	}
+
+	//----
+	D3D12_SHADER_VISIBILITY RootSignature::ToD3DShaderVisibility(u32 shaderVisibility)
+	{
+		return GetShaderVisibility(shaderVisibility);
+	}
+
+	//----
+	bool RootSignature::Serialize(const RootSignatureDesc& desc, ID3DBlob** ppOutBlob)
+	{
+		// レンジはパラメータ数を超えないが、バインドレステーブルの分を追加で確保しておく
+		D3D12_DESCRIPTOR_RANGE ranges[kMaxParameters + 2];
+		D3D12_ROOT_PARAMETER rootParameters[kMaxParameters];
+		RootParameterSlot slots[kMaxParameters];
+		u32 tableSizes[kMaxParameters];
 
+		if (desc.numParameters > kMaxParameters)
+		{
+			return false;
+		}
+		u32 numRootParams = CalcParameterSlots(desc, slots, tableSizes);
+		u32 numParameters = numRootParams + (desc.useBindless ? 2 : 0);
+		if (numParameters > kMaxParameters)
+		{
+			return false;
+		}
+
+		// サイズ上限をチェックする
+		u32 dwordCount = CalcDWordCount(desc);
+		if (dwordCount > kMaxDWords)
+		{
+			char text[256];
+			sprintf_s(text, "[sl12] RootSignature : size %u DWORDs exceeds the limit of %u DWORDs.\n", dwordCount, kMaxDWords);
+			OutputDebugStringA(text);
+			return false;
+		}
+
+		// テーブル内のオフセット順にパラメータを並べる
+		u32 tableStarts[kMaxParameters];
+		u32 sortedParams[kMaxParameters];
+		u32 directParams[kMaxParameters];
+		for (u32 t = 0, start = 0; t < numRootParams; ++t)
+		{
+			tableStarts[t] = start;
+			start += tableSizes[t];
+		}
 		for (u32 i = 0; i < desc.numParameters; ++i)
 		{
-			ranges[i].RangeType = getRangeFunc(i);
-			ranges[i].NumDescriptors = 1;
-			ranges[i].BaseShaderRegister = desc.pParameters[i].registerIndex;
-			ranges[i].RegisterSpace = 0;
-			ranges[i].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+			if (IsDirectParameter(desc.pParameters[i].type))
+			{
+				directParams[slots[i].rootIndex] = i;
+			}
+			else
+			{
+				sortedParams[tableStarts[slots[i].rootIndex] + slots[i].tableOffset] = i;
+			}
+		}
+
+		u32 numRanges = 0;
+		for (u32 t = 0; t < numRootParams; ++t)
+		{
+			const RootParameter& firstParam = desc.pParameters[(tableSizes[t] > 0) ? sortedParams[tableStarts[t]] : directParams[t]];
+			rootParameters[t].ShaderVisibility = GetShaderVisibility(firstParam.shaderVisibility);
 
-			rootParameters[i].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-			rootParameters[i].DescriptorTable.NumDescriptorRanges = 1;
-			rootParameters[i].DescriptorTable.pDescriptorRanges = &ranges[i];
-			rootParameters[i].ShaderVisibility = getShaderVisFunc(i);
+			if (firstParam.type == RootParameterType::RootConstants)
+			{
+				rootParameters[t].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+				rootParameters[t].Constants.ShaderRegister = firstParam.registerIndex;
+				rootParameters[t].Constants.RegisterSpace = 0;
+				rootParameters[t].Constants.Num32BitValues = firstParam.num32BitValues;
+				continue;
+			}
+			if (firstParam.type == RootParameterType::RootConstantBuffer)
+			{
+				rootParameters[t].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+				rootParameters[t].Descriptor.ShaderRegister = firstParam.registerIndex;
+				rootParameters[t].Descriptor.RegisterSpace = 0;
+				continue;
+			}
+
+			// 同一種別で連続するレジスタは1つのレンジにまとめる
+			D3D12_DESCRIPTOR_RANGE* pTableRanges = &ranges[numRanges];
+			u32 numTableRanges = 0;
+			for (u32 offset = 0; offset < tableSizes[t]; ++offset)
+			{
+				const RootParameter& param = desc.pParameters[sortedParams[tableStarts[t] + offset]];
+				auto rangeType = GetRangeType(param.type);
+				if (numTableRanges > 0)
+				{
+					D3D12_DESCRIPTOR_RANGE& last = pTableRanges[numTableRanges - 1];
+					if (last.RangeType == rangeType && last.BaseShaderRegister + last.NumDescriptors == param.registerIndex)
+					{
+						last.NumDescriptors++;
+						continue;
+					}
+				}
+
+				D3D12_DESCRIPTOR_RANGE& range = pTableRanges[numTableRanges++];
+				range.RangeType = rangeType;
+				range.NumDescriptors = 1;
+				range.BaseShaderRegister = param.registerIndex;
+				range.RegisterSpace = 0;
+				range.OffsetInDescriptorsFromTableStart = offset;
+			}
+			numRanges += numTableRanges;
+
+			rootParameters[t].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+			rootParameters[t].DescriptorTable.NumDescriptorRanges = numTableRanges;
+			rootParameters[t].DescriptorTable.pDescriptorRanges = pTableRanges;
+		}
+		if (desc.useBindless)
+		{
+			BindlessDescriptorTable::GetRootParameters(&ranges[numRanges], &rootParameters[numRootParams]);
 		}
 
 		D3D12_ROOT_SIGNATURE_DESC rd{};
-		rd.NumParameters = desc.numParameters;
+		rd.NumParameters = numParameters;
 		rd.pParameters = rootParameters;
-		rd.NumStaticSamplers = 0;
-		rd.pStaticSamplers = nullptr;
+		rd.NumStaticSamplers = desc.numStaticSamplers;
+		rd.pStaticSamplers = desc.pStaticSamplers;
 		rd.Flags = desc.flags;
 
 		ID3DBlob* pSignature{ nullptr };
 		ID3DBlob* pError{ nullptr };
 		auto hr = D3D12SerializeRootSignature(&rd, D3D_ROOT_SIGNATURE_VERSION_1, &pSignature, &pError);
+		sl12::SafeRelease(pError);
 		if (FAILED(hr))
 		{
 			sl12::SafeRelease(pSignature);
-			sl12::SafeRelease(pError);
 			return false;
 		}
 
-		hr = pDev->GetDeviceDep()->CreateRootSignature(0, pSignature->GetBufferPointer(), pSignature->GetBufferSize(), IID_PPV_ARGS(&pRootSignature_));
+		*ppOutBlob = pSignature;
+		return true;
+	}
+
+	//----
+	bool RootSignature::Initialize(Device* pDev, const RootSignatureDesc& desc)
+	{
+		ID3DBlob* pSignature{ nullptr };
+		if (!Serialize(desc, &pSignature))
+		{
+			return false;
+		}
+
+		bool ret = Initialize(pDev, desc, pSignature->GetBufferPointer(), pSignature->GetBufferSize());
 		sl12::SafeRelease(pSignature);
-		sl12::SafeRelease(pError);
+		return ret;
+	}
+
+	//----
+	bool RootSignature::Initialize(Device* pDev, const RootSignatureDesc& desc, const void* pSerialized, size_t serializedSize)
+	{
+		auto hr = pDev->GetDeviceDep()->CreateRootSignature(0, pSerialized, serializedSize, IID_PPV_ARGS(&pRootSignature_));
 		if (FAILED(hr))
 		{
 			return false;
 		}
 
+		dwordCount_ = CalcDWordCount(desc);
+		hash_ = CalcFnv1a64(pSerialized, serializedSize);
 		return true;
 	}
 
@@ -97,6 +344,22 @@ namespace sl12
 			ret = false;
 			goto D3D_ERROR;
 		}
+		hash_ = CalcFnv1a64(blob->GetBufferPointer(), blob->GetBufferSize());
+
+		// テーブルは1, ルートデスクリプタは2, ルート定数は定数の数だけ消費する
+		dwordCount_ = 0;
+		for (u32 i = 0; i < desc.NumParameters; ++i)
+		{
+			switch (desc.pParameters[i].ParameterType)
+			{
+			case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+				dwordCount_ += 1; break;
+			case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+				dwordCount_ += desc.pParameters[i].Constants.Num32BitValues; break;
+			default:
+				dwordCount_ += 2; break;
+			}
+		}
 
 	D3D_ERROR:
 		sl12::SafeRelease(blob);
@@ -108,6 +371,8 @@ namespace sl12
 	void RootSignature::Destroy()
 	{
 		SafeRelease(pRootSignature_);
+		dwordCount_ = 0;
+		hash_ = 0;
 	}
 
 }	// namespace sl12
@@ -0,0 +1,261 @@
+﻿#include <sl12/root_signature_cache.h>
+
+#include <sl12/cache_stream.h>
+#include <sl12/file.h>
+#include <cstdio>
+#include <cstring>
+
+
+namespace sl12
+{
+	namespace
+	{
+		bool ReadEntry(CacheReader& reader, RootSignatureCacheEntry& entry)
+		{
+			u32 isGraphics, count;
+			if (!reader.Read64(entry.contentHash) || !reader.Read32(isGraphics))
+				return false;
+			entry.isGraphics = isGraphics != 0;
+
+			if (!reader.Read32(count) || count > RootSignature::kMaxParameters || !reader.CheckCount(count, 16))
+				return false;
+			entry.params.resize(count);
+			for (auto&& param : entry.params)
+			{
+				u32 type;
+				reader.Read32(type);
+				reader.Read32(param.shaderVisibility);
+				reader.Read32(param.registerIndex);
+				reader.Read32(param.num32BitValues);
+				if (type >= RootParameterType::Max)
+					return false;
+				param.type = static_cast<RootParameterType::Type>(type);
+			}
+
+			if (!reader.Read32(count) || !reader.CheckCount(count, 12))
+				return false;
+			entry.bindings.resize(count);
+			for (auto&& binding : entry.bindings)
+			{
+				reader.Read32(binding.nameHash);
+				reader.Read32(binding.first);
+				reader.Read32(binding.count);
+			}
+
+			if (!reader.Read32(count) || !reader.CheckCount(count, 4))
+				return false;
+			entry.paramIndices.resize(count);
+			for (auto&& index : entry.paramIndices)
+			{
+				reader.Read32(index);
+				if (index >= entry.params.size())
+					return false;
+			}
+			for (auto&& binding : entry.bindings)
+			{
+				if (binding.first + static_cast<u64>(binding.count) > entry.paramIndices.size())
+					return false;
+			}
+
+			if (!reader.Read32(count) || !reader.CheckCount(count, 13 * 4))
+				return false;
+			entry.staticSamplers.resize(count);
+			for (auto&& sampler : entry.staticSamplers)
+			{
+				u32 v[13];
+				for (auto&& e : v)
+					reader.Read32(e);
+				sampler.Filter = static_cast<D3D12_FILTER>(v[0]);
+				sampler.AddressU = static_cast<D3D12_TEXTURE_ADDRESS_MODE>(v[1]);
+				sampler.AddressV = static_cast<D3D12_TEXTURE_ADDRESS_MODE>(v[2]);
+				sampler.AddressW = static_cast<D3D12_TEXTURE_ADDRESS_MODE>(v[3]);
+				memcpy(&sampler.MipLODBias, &v[4], sizeof(float));
+				sampler.MaxAnisotropy = v[5];
+				sampler.ComparisonFunc = static_cast<D3D12_COMPARISON_FUNC>(v[6]);
+				sampler.BorderColor = static_cast<D3D12_STATIC_BORDER_COLOR>(v[7]);
+				memcpy(&sampler.MinLOD, &v[8], sizeof(float));
+				memcpy(&sampler.MaxLOD, &v[9], sizeof(float));
+				sampler.ShaderRegister = v[10];
+				sampler.RegisterSpace = v[11];
+				sampler.ShaderVisibility = static_cast<D3D12_SHADER_VISIBILITY>(v[12]);
+			}
+
+			if (!reader.Read32(count) || count == 0 || !reader.CheckCount(count, 1))
+				return false;
+			entry.serialized.resize(count);
+			return reader.ReadBytes(entry.serialized.data(), count);
+		}
+
+		void WriteEntry(CacheWriter& writer, const RootSignatureCacheEntry& entry)
+		{
+			writer.Write64(entry.contentHash);
+			writer.Write32(entry.isGraphics ? 1 : 0);
+
+			writer.Write32(static_cast<u32>(entry.params.size()));
+			for (auto&& param : entry.params)
+			{
+				writer.Write32(static_cast<u32>(param.type));
+				writer.Write32(param.shaderVisibility);
+				writer.Write32(param.registerIndex);
+				writer.Write32(param.num32BitValues);
+			}
+
+			writer.Write32(static_cast<u32>(entry.bindings.size()));
+			for (auto&& binding : entry.bindings)
+			{
+				writer.Write32(binding.nameHash);
+				writer.Write32(binding.first);
+				writer.Write32(binding.count);
+			}
+
+			writer.Write32(static_cast<u32>(entry.paramIndices.size()));
+			for (auto&& index : entry.paramIndices)
+			{
+				writer.Write32(index);
+			}
+
+			writer.Write32(static_cast<u32>(entry.staticSamplers.size()));
+			for (auto&& sampler : entry.staticSamplers)
+			{
+				u32 v[13];
+				v[0] = static_cast<u32>(sampler.Filter);
+				v[1] = static_cast<u32>(sampler.AddressU);
+				v[2] = static_cast<u32>(sampler.AddressV);
+				v[3] = static_cast<u32>(sampler.AddressW);
+				memcpy(&v[4], &sampler.MipLODBias, sizeof(float));
+				v[5] = sampler.MaxAnisotropy;
+				v[6] = static_cast<u32>(sampler.ComparisonFunc);
+				v[7] = static_cast<u32>(sampler.BorderColor);
+				memcpy(&v[8], &sampler.MinLOD, sizeof(float));
+				memcpy(&v[9], &sampler.MaxLOD, sizeof(float));
+				v[10] = sampler.ShaderRegister;
+				v[11] = sampler.RegisterSpace;
+				v[12] = static_cast<u32>(sampler.ShaderVisibility);
+				for (auto e : v)
+					writer.Write32(e);
+			}
+
+			writer.Write32(static_cast<u32>(entry.serialized.size()));
+			writer.WriteBytes(entry.serialized.data(), entry.serialized.size());
+		}
+	}
+
+	const u32 RootSignatureCache::kMagic;
+	const u32 RootSignatureCache::kVersion;
+
+	//----
+	bool RootSignatureCache::Load(const char* filename)
+	{
+		Clear();
+
+		File file;
+		if (!file.ReadFile(filename))
+		{
+			return false;
+		}
+
+		CacheReader reader(reinterpret_cast<const u8*>(file.GetData()), file.GetSize());
+		u32 magic, version, count;
+		if (!reader.Read32(magic) || !reader.Read32(version) || !reader.Read32(count))
+		{
+			return false;
+		}
+		if (magic != kMagic || version != kVersion)
+		{
+			// 古いバージョンのキャッシュは使用しない
+			char text[256];
+			sprintf_s(text, "[sl12] RootSignatureCache : %s is version %u (expected %u), ignored.\n", filename, version, kVersion);
+			OutputDebugStringA(text);
+			return false;
+		}
+
+		for (u32 i = 0; i < count; i++)
+		{
+			u32 key;
+			Item item;
+			if (!reader.Read32(key) || !ReadEntry(reader, item.entry))
+			{
+				char text[256];
+				sprintf_s(text, "[sl12] RootSignatureCache : %s is corrupted, ignored.\n", filename);
+				OutputDebugStringA(text);
+				Clear();
+				return false;
+			}
+			entries_[key] = std::move(item);
+		}
+
+		return reader.IsEnd();
+	}
+
+	//----
+	bool RootSignatureCache::Save(const char* filename) const
+	{
+		u32 count = 0;
+		for (auto&& v : entries_)
+		{
+			if (v.second.isUsed)
+				count++;
+		}
+
+		CacheWriter writer;
+		writer.Write32(kMagic);
+		writer.Write32(kVersion);
+		writer.Write32(count);
+		for (auto&& v : entries_)
+		{
+			if (v.second.isUsed)
+			{
+				writer.Write32(v.first);
+				WriteEntry(writer, v.second.entry);
+			}
+		}
+
+		std::ofstream fout(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!fout.is_open())
+		{
+			return false;
+		}
+		auto&& data = writer.GetData();
+		fout.write(reinterpret_cast<const char*>(data.data()), data.size());
+		return fout.good();
+	}
+
+	//----
+	const RootSignatureCacheEntry* RootSignatureCache::Find(u32 key, u64 contentHash)
+	{
+		auto it = entries_.find(key);
+		if (it == entries_.end() || it->second.entry.contentHash != contentHash)
+		{
+			missCount_++;
+			return nullptr;
+		}
+
+		hitCount_++;
+		it->second.isUsed = true;
+		return &it->second.entry;
+	}
+
+	//----
+	void RootSignatureCache::Store(u32 key, const RootSignatureCacheEntry& entry)
+	{
+		Item& item = entries_[key];
+		item.entry = entry;
+		item.isUsed = true;
+	}
+
+	//----
+	void RootSignatureCache::Remove(u32 key)
+	{
+		entries_.erase(key);
+	}
+
+	//----
+	void RootSignatureCache::Clear()
+	{
+		entries_.clear();
+		hitCount_ = missCount_ = 0;
+	}
+
+}	// namespace sl12
+
+//	EOF
@@ -3,10 +3,30 @@
 #include <d3dcompiler.h>
 #include <sl12/crc.h>
 #include <sl12/descriptor.h>
+#include <sl12/descriptor_ring.h>
+#include <sl12/device.h>
+#include <sl12/shader_reflection.h>
+#include <algorithm>
+#include <cstdio>
 
 
 namespace sl12
 {
+	namespace
+	{
+		// パラメータ種別に対応するHLSLのレジスタ種別
+		char GetRegisterClass(RootParameterType::Type type)
+		{
+			switch (type)
+			{
+			case RootParameterType::ShaderResource: return 't';
+			case RootParameterType::UnorderedAccess: return 'u';
+			case RootParameterType::Sampler: return 's';
+			default: return 'b';
+			}
+		}
+	}
+
 	//-------------------------------------------------
 	// ハンドルを無効化する
 	//-------------------------------------------------
@@ -21,121 +41,267 @@ namespace sl12
 	}
 
 	//-------------------------------------------------
-	// CBVデスクリプタを設定する
+	// 名前のハッシュ値からバインドスロットを検索する
+	//-------------------------------------------------
+	BindingSlot RootSignatureInstance::FindSlot(u32 hash) const
+	{
+		BindingSlot ret;
+		auto it = std::lower_bound(names_.begin(), names_.end(), hash, [](const NameEntry& e, u32 h) { return e.hash < h; });
+		if (it != names_.end() && it->hash == hash)
+		{
+			ret.pOwner = this;
+			ret.first = it->first;
+			ret.count = it->count;
+		}
+		return ret;
+	}
+
+	//-------------------------------------------------
+	// バインドスロットを取得する
+	//-------------------------------------------------
+	BindingSlot RootSignatureHandle::GetBindingSlot(BindingName name) const
+	{
+		assert(IsValid());
+		return pInstance_->FindSlot(name.hash);
+	}
+
+	//-------------------------------------------------
+	// デスクリプタをテーブルに設定する
 	//-------------------------------------------------
-	bool RootSignatureHandle::SetDescriptor(CommandList& cmdList, const char* name, ConstantBufferView& cbv)
+	bool RootSignatureHandle::SetTableDescriptor(CommandList& cmdList, const BindingSlot& slot, Descriptor* pDesc, D3D12_GPU_VIRTUAL_ADDRESS address)
 	{
 		assert(IsValid());
+		assert(!slot.IsValid() || slot.pOwner == pInstance_);
+
+		if (!slot.IsValid())
+		{
+			return false;
+		}
 
-		auto it = pInstance_->slotMap_.find(name);
 		auto isGraphics = pInstance_->isGraphics_;
-		if (it != pInstance_->slotMap_.end())
+		for (u32 i = 0; i < slot.count; i++)
 		{
-			for (auto index : it->second)
+			auto&& s = pInstance_->slots_[slot.first + i];
+			auto&& param = pInstance_->params_[s.rootIndex];
+			if (param.type == RootParameterType::RootConstantBuffer)
 			{
+				// ルートCBVはアドレスを直接設定する
+				if (address == 0)
+				{
+					return false;
+				}
 				if (isGraphics)
-					cmdList.GetCommandList()->SetGraphicsRootDescriptorTable(index, cbv.GetDesc()->GetGpuHandle());
+					cmdList.SetGraphicsRootConstantBufferView(s.rootIndex, address);
 				else
-					cmdList.GetCommandList()->SetComputeRootDescriptorTable(index, cbv.GetDesc()->GetGpuHandle());
+					cmdList.SetComputeRootConstantBufferView(s.rootIndex, address);
+			}
+			else if (param.type == RootParameterType::RootConstants)
+			{
+				// ルート定数はSetConstants()で設定する
+				OutputDebugStringA("[sl12] RootSignatureHandle::SetDescriptor : root constants must be set with SetConstants().\n");
+				return false;
+			}
+			else if (param.count == 1)
+			{
+				// 1デスクリプタのテーブルはそのまま設定する
+				D3D12_GPU_DESCRIPTOR_HANDLE handle = pDesc->GetTableGpuHandle();
+				if (handle.ptr == 0)
+				{
+					return false;
+				}
+				if (isGraphics)
+					cmdList.SetGraphicsRootDescriptorTable(s.rootIndex, handle);
+				else
+					cmdList.SetComputeRootDescriptorTable(s.rootIndex, handle);
+			}
+			else
+			{
+				// まとめたテーブルはApplyDescriptors()でまとめてコピーする
+				tableHandles_[param.start + s.tableOffset] = pDesc->GetCpuHandle();
 			}
-			return true;
 		}
-		return false;
+		return true;
+	}
+
+	//-------------------------------------------------
+	// CBVデスクリプタを設定する
+	//-------------------------------------------------
+	bool RootSignatureHandle::SetDescriptor(CommandList& cmdList, const BindingSlot& slot, ConstantBufferView& cbv)
+	{
+		return SetTableDescriptor(cmdList, slot, cbv.GetDesc(), cbv.GetBufferLocation());
 	}
 
 	//-------------------------------------------------
 	// テクスチャSRVデスクリプタを設定する
 	//-------------------------------------------------
-	bool RootSignatureHandle::SetDescriptor(CommandList& cmdList, const char* name, TextureView& srv)
+	bool RootSignatureHandle::SetDescriptor(CommandList& cmdList, const BindingSlot& slot, TextureView& srv)
+	{
+		return SetTableDescriptor(cmdList, slot, srv.GetDesc());
+	}
+
+	//-------------------------------------------------
+	// バッファSRVデスクリプタを設定する
+	//-------------------------------------------------
+	bool RootSignatureHandle::SetDescriptor(CommandList& cmdList, const BindingSlot& slot, BufferView& srv)
+	{
+		return SetTableDescriptor(cmdList, slot, srv.GetDesc());
+	}
+
+	//-------------------------------------------------
+	// サンプラーデスクリプタを設定する
+	//-------------------------------------------------
+	bool RootSignatureHandle::SetDescriptor(CommandList& cmdList, const BindingSlot& slot, Sampler& sam)
+	{
+		return SetTableDescriptor(cmdList, slot, sam.GetDesc());
+	}
+
+	//-------------------------------------------------
+	// UAVデスクリプタを設定する
+	//-------------------------------------------------
+	bool RootSignatureHandle::SetDescriptor(CommandList& cmdList, const BindingSlot& slot, UnorderedAccessView& uav)
+	{
+		return SetTableDescriptor(cmdList, slot, uav.GetDesc());
+	}
+
+
+	//-------------------------------------------------
+	// バインドレステーブルを設定する
+	//-------------------------------------------------
+	bool RootSignatureHandle::SetBindlessTable(CommandList& cmdList, BindlessDescriptorTable& table)
 	{
 		assert(IsValid());
 
-		auto it = pInstance_->slotMap_.find(name);
-		auto isGraphics = pInstance_->isGraphics_;
-		if (it != pInstance_->slotMap_.end())
+		if (pInstance_->bindlessRootIndex_ < 0)
 		{
-			for (auto index : it->second)
-			{
-				if (isGraphics)
-					cmdList.GetCommandList()->SetGraphicsRootDescriptorTable(index, srv.GetDesc()->GetGpuHandle());
-				else
-					cmdList.GetCommandList()->SetComputeRootDescriptorTable(index, srv.GetDesc()->GetGpuHandle());
-			}
-			return true;
+			return false;
 		}
-		return false;
+
+		if (pInstance_->isGraphics_)
+			table.SetGraphicsRootTables(cmdList, pInstance_->bindlessRootIndex_);
+		else
+			table.SetComputeRootTables(cmdList, pInstance_->bindlessRootIndex_);
+		return true;
 	}
 
+
 	//-------------------------------------------------
-	// バッファSRVデスクリプタを設定する
+	// ルート定数を設定する
 	//-------------------------------------------------
-	bool RootSignatureHandle::SetDescriptor(CommandList& cmdList, const char* name, BufferView& srv)
+	bool RootSignatureHandle::SetConstants(CommandList& cmdList, const BindingSlot& slot, const void* pData, u32 num32BitValues, u32 offset)
 	{
 		assert(IsValid());
+		assert(!slot.IsValid() || slot.pOwner == pInstance_);
+
+		if (!slot.IsValid())
+		{
+			return false;
+		}
 
-		auto it = pInstance_->slotMap_.find(name);
 		auto isGraphics = pInstance_->isGraphics_;
-		if (it != pInstance_->slotMap_.end())
+		for (u32 i = 0; i < slot.count; i++)
 		{
-			for (auto index : it->second)
+			auto&& s = pInstance_->slots_[slot.first + i];
+			if (pInstance_->params_[s.rootIndex].type != RootParameterType::RootConstants)
 			{
-				if (isGraphics)
-					cmdList.GetCommandList()->SetGraphicsRootDescriptorTable(index, srv.GetDesc()->GetGpuHandle());
-				else
-					cmdList.GetCommandList()->SetComputeRootDescriptorTable(index, srv.GetDesc()->GetGpuHandle());
+				return false;
 			}
-			return true;
+
+			if (isGraphics)
+				cmdList.SetGraphicsRoot32BitConstants(s.rootIndex, num32BitValues, pData, offset);
+			else
+				cmdList.SetComputeRoot32BitConstants(s.rootIndex, num32BitValues, pData, offset);
 		}
-		return false;
+		return true;
 	}
 
 	//-------------------------------------------------
-	// サンプラーデスクリプタを設定する
+	// ルートCBVを設定する
 	//-------------------------------------------------
-	bool RootSignatureHandle::SetDescriptor(CommandList& cmdList, const char* name, Sampler& sam)
+	bool RootSignatureHandle::SetConstantBuffer(CommandList& cmdList, const BindingSlot& slot, D3D12_GPU_VIRTUAL_ADDRESS address)
 	{
 		assert(IsValid());
+		assert(!slot.IsValid() || slot.pOwner == pInstance_);
+
+		if (!slot.IsValid())
+		{
+			return false;
+		}
 
-		auto it = pInstance_->slotMap_.find(name);
 		auto isGraphics = pInstance_->isGraphics_;
-		if (it != pInstance_->slotMap_.end())
+		for (u32 i = 0; i < slot.count; i++)
 		{
-			for (auto index : it->second)
+			auto&& s = pInstance_->slots_[slot.first + i];
+			if (pInstance_->params_[s.rootIndex].type != RootParameterType::RootConstantBuffer)
 			{
-				if (isGraphics)
-					cmdList.GetCommandList()->SetGraphicsRootDescriptorTable(index, sam.GetDesc()->GetGpuHandle());
-				else
-					cmdList.GetCommandList()->SetComputeRootDescriptorTable(index, sam.GetDesc()->GetGpuHandle());
+				return false;
 			}
-			return true;
+
+			if (isGraphics)
+				cmdList.SetGraphicsRootConstantBufferView(s.rootIndex, address);
+			else
+				cmdList.SetComputeRootConstantBufferView(s.rootIndex, address);
 		}
-		return false;
+		return true;
 	}
 
 	//-------------------------------------------------
-	// UAVデスクリプタを設定する
+	// まとめたテーブルを設定する
 	//-------------------------------------------------
-	bool RootSignatureHandle::SetDescriptor(CommandList& cmdList, const char* name, UnorderedAccessView& uav)
+	void RootSignatureHandle::ApplyDescriptors(CommandList& cmdList)
 	{
 		assert(IsValid());
 
-		auto it = pInstance_->slotMap_.find(name);
+		// 別のルートシグネチャやコマンドリストで設定された可能性があるため、まとめたテーブルは毎回設定する
+		// 同じ並びのコピーはリングのテーブルキャッシュで、同じハンドルの再設定はステートキャッシュで除外される
+		Device* pDev = pManager_->GetDevice();
 		auto isGraphics = pInstance_->isGraphics_;
-		if (it != pInstance_->slotMap_.end())
+		for (u32 i = 0; i < (u32)pInstance_->params_.size(); i++)
 		{
-			for (auto index : it->second)
+			auto&& table = pInstance_->params_[i];
+			if (table.count <= 1)
 			{
-				if (isGraphics)
-					cmdList.GetCommandList()->SetGraphicsRootDescriptorTable(index, uav.GetDesc()->GetGpuHandle());
-				else
-					cmdList.GetCommandList()->SetComputeRootDescriptorTable(index, uav.GetDesc()->GetGpuHandle());
+				// 1デスクリプタのテーブルとルート定数、ルートCBVはSetDescriptor()で設定済み
+				continue;
 			}
-			return true;
+
+			const D3D12_CPU_DESCRIPTOR_HANDLE* pHandles = &tableHandles_[table.start];
+			u32 numSet = 0;
+			for (u32 j = 0; j < table.count; j++)
+			{
+				numSet += (pHandles[j].ptr != 0) ? 1 : 0;
+			}
+			if (numSet == 0)
+			{
+				// 一度も設定していないテーブルは使用しない
+				continue;
+			}
+			if (numSet != table.count)
+			{
+				// 未設定のデスクリプタがあるテーブルはコピーできない
+				OutputDebugStringA("[sl12] RootSignatureHandle::ApplyDescriptors : descriptor table has unset descriptors.\n");
+				continue;
+			}
+
+			auto heapType = (table.type == RootParameterType::Sampler) ? D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER : D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+			DescriptorRing* pRing = pDev->GetDescriptorHeap(heapType).GetTransientRing();
+			if (!pRing)
+			{
+				OutputDebugStringA("[sl12] RootSignatureHandle::ApplyDescriptors : shader visible heap has no transient ring.\n");
+				continue;
+			}
+			DescriptorRange range = pRing->CopyTable(pHandles, table.count);
+			if (!range.IsValid())
+			{
+				continue;
+			}
+
+			if (isGraphics)
+				cmdList.SetGraphicsRootDescriptorTable(i, range.gpuHandle);
+			else
+				cmdList.SetComputeRootDescriptorTable(i, range.gpuHandle);
 		}
-		return false;
 	}
 
-
 	//-------------------------------------------------
 	// 初期化
 	//-------------------------------------------------
@@ -152,8 +318,8 @@ namespace sl12
 	{
 		if (pDevice_)
 		{
-			for (auto&& v : instanceMap_) delete v.second;
-			instanceMap_.clear();
+			instances_.Clear();
+			cache_.Clear();
 			pDevice_ = nullptr;
 		}
 	}
@@ -180,42 +346,117 @@ namespace sl12
 			crc = desc.pDS != nullptr ? CalcCrc32(desc.pDS->GetData(), desc.pDS->GetSize(), crc) : CalcCrc32(&zero, sizeof(zero), crc);
 			crc = desc.pHS != nullptr ? CalcCrc32(desc.pHS->GetData(), desc.pHS->GetSize(), crc) : CalcCrc32(&zero, sizeof(zero), crc);
 		}
+		if (desc.useBindless)
+		{
+			u8 bindless = 1;
+			crc = CalcCrc32(&bindless, sizeof(bindless), crc);
+		}
+		if (desc.maxRootConstants > 0 || desc.useRootCbv)
+		{
+			u32 promote[] = { desc.maxRootConstants, desc.useRootCbv ? 1u : 0u };
+			crc = CalcCrc32(promote, sizeof(promote), crc);
+		}
+		if (desc.pStaticSamplers && desc.pStaticSamplers->GetCount() > 0)
+		{
+			u32 samplerHash = desc.pStaticSamplers->GetHash();
+			crc = CalcCrc32(&samplerHash, sizeof(samplerHash), crc);
+		}
 
-		// CRCから生成済みルートシグネチャを検索する
+		// CRCから生成済みルートシグネチャを検索し、なければ生成する
+		// 同じCRCの生成が他スレッドで進行中の場合は完了を待つ
 		// CRCの衝突は起きないことを祈る
-		auto it = instanceMap_.find(crc);
-		if (it != instanceMap_.end())
+		RootSignatureInstance* pInstance = instances_.Acquire(crc, [&]() { return CreateInstanceWithCache(desc, crc); });
+		if (!pInstance)
 		{
-			// 見つかった
-			return RootSignatureHandle(this, it->first, it->second);
+			return RootSignatureHandle(nullptr, 0, nullptr);
 		}
 
-		std::vector<RootParameter> rootParams;
-		std::map<std::string, std::vector<int>> paramMap;
-		auto ReflectShader = [&](Shader* pShader, u32 shaderVisibility)
+		return RootSignatureHandle(this, crc, pInstance);
+	}
+
+	//-------------------------------------------------
+	// ファイルキャッシュを参照してインスタンスを生成する
+	//-------------------------------------------------
+	RootSignatureInstance* RootSignatureManager::CreateInstanceWithCache(const RootSignatureCreateDesc& desc, u32 crc)
+	{
+		// ファイルキャッシュはCRCより衝突しにくい64bitハッシュでも照合する
+		u64 contentHash = CalcContentHash(desc);
+
+		// キャッシュにあればリフレクションとシリアライズを省略する
+		// 同じCRCのエントリを変更するのは生成中のスレッドのみなので、エントリの参照はロックの外で行う
+		RootSignatureInstance* pNewInstance = nullptr;
+		const RootSignatureCacheEntry* pCached = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(cacheMutex_);
+			pCached = cache_.Find(crc, contentHash);
+		}
+		if (pCached)
 		{
-			ID3D12ShaderReflection* pReflection = nullptr;
-			auto hr = D3DReflect(pShader->GetData(), pShader->GetSize(), IID_PPV_ARGS(&pReflection));
-			if (FAILED(hr))
+			pNewInstance = CreateInstance(desc, *pCached, nullptr);
+			if (!pNewInstance)
 			{
-				return false;
+				// 生成できなかったエントリは破棄してリフレクションからやり直す
+				OutputDebugStringA("[sl12] RootSignatureManager : failed to create root signature from cache, fall back to reflection.\n");
+				std::lock_guard<std::mutex> lock(cacheMutex_);
+				cache_.Remove(crc);
+			}
+		}
+		if (!pNewInstance)
+		{
+			RootSignatureCacheEntry entry;
+			if (!ReflectShaders(desc, entry))
+			{
+				return nullptr;
+			}
+			entry.contentHash = contentHash;
+
+			pNewInstance = CreateInstance(desc, entry, &entry.serialized);
+			if (!pNewInstance)
+			{
+				return nullptr;
 			}
+			std::lock_guard<std::mutex> lock(cacheMutex_);
+			cache_.Store(crc, entry);
+		}
+
+		return pNewInstance;
+	}
 
-			D3D12_SHADER_DESC sdesc;
-			hr = pReflection->GetDesc(&sdesc);
-			if (FAILED(hr))
+	//-------------------------------------------------
+	// シェーダをリフレクションしてパラメータを生成する
+	//-------------------------------------------------
+	bool RootSignatureManager::ReflectShaders(const RootSignatureCreateDesc& desc, RootSignatureCacheEntry& outEntry)
+	{
+		struct PromotedSampler
+		{
+			std::string					name;
+			D3D12_STATIC_SAMPLER_DESC	desc;
+			u32							shaderVisibility;
+		};	// struct PromotedSampler
+
+		std::vector<RootParameter> rootParams;
+		std::map<std::string, std::vector<int>> paramMap;
+		std::vector<PromotedSampler> promotedSamplers;
+		std::vector<ShaderBindingDesc> bindings;
+		auto ReflectShader = [&](Shader* pShader, u32 shaderVisibility)
+		{
+			// RDEFチャンクを直接解析し、ない場合のみD3DReflectを使用する
+			if (!ReflectShaderBindings(pShader->GetData(), pShader->GetSize(), bindings))
 			{
 				return false;
 			}
 
 			// バインドリソースを列挙する
-			for (u32 i = 0; i < sdesc.BoundResources; i++)
+			for (auto&& bd : bindings)
 			{
-				D3D12_SHADER_INPUT_BIND_DESC bd;
-				pReflection->GetResourceBindingDesc(i, &bd);
+				// バインドレステーブルのスペースにあるリソースは個別に設定しない
+				if (desc.useBindless && ((bd.space == BindlessDescriptorTable::kSrvSpace) || (bd.space == BindlessDescriptorTable::kUavSpace)))
+				{
+					continue;
+				}
 
 				RootParameterType::Type paramType = RootParameterType::ConstantBuffer;
-				switch (bd.Type)
+				switch (bd.inputType)
 				{
 				case D3D_SHADER_INPUT_TYPE::D3D_SIT_CBUFFER:
 					paramType = RootParameterType::ConstantBuffer; break;
@@ -236,7 +477,40 @@ namespace sl12
 					return false;
 				}
 
-				auto findIt = paramMap.find(bd.Name);
+				// 登録済みの名前のサンプラは静的サンプラにする
+				if (paramType == RootParameterType::Sampler && desc.pStaticSamplers)
+				{
+					const D3D12_STATIC_SAMPLER_DESC* pStatic = desc.pStaticSamplers->Find(CalcFnv1a32(bd.name.c_str()));
+					if (pStatic)
+					{
+						bool isStored = false;
+						for (auto&& sampler : promotedSamplers)
+						{
+							if (sampler.name == bd.name && sampler.desc.ShaderRegister == bd.bindPoint && sampler.desc.RegisterSpace == bd.space)
+							{
+								sampler.shaderVisibility |= shaderVisibility;
+								isStored = true;
+								break;
+							}
+						}
+						if (!isStored)
+						{
+							PromotedSampler sampler;
+							sampler.name = bd.name;
+							sampler.desc = *pStatic;
+							sampler.desc.ShaderRegister = bd.bindPoint;
+							sampler.desc.RegisterSpace = bd.space;
+							sampler.shaderVisibility = shaderVisibility;
+							promotedSamplers.push_back(sampler);
+						}
+						continue;
+					}
+				}
+
+				// 定数バッファはルート定数への昇格判定のためにサイズを使用する
+				u32 numValues = (paramType == RootParameterType::ConstantBuffer) ? bd.constantBufferSize / 4 : 0;
+
+				auto findIt = paramMap.find(bd.name);
 				if (findIt != paramMap.end())
 				{
 					// すでに存在している
@@ -249,9 +523,10 @@ namespace sl12
 							// 同名のリソースは同一タイプのみを許容
 							return false;
 						}
-						if (param.registerIndex == bd.BindPoint)
+						if (param.registerIndex == bd.bindPoint)
 						{
 							param.shaderVisibility |= shaderVisibility;
+							param.num32BitValues = std::max(param.num32BitValues, numValues);
 							isStored = true;
 							break;
 						}
@@ -261,7 +536,8 @@ namespace sl12
 						RootParameter param;
 						param.type = paramType;
 						param.shaderVisibility = shaderVisibility;
-						param.registerIndex = bd.BindPoint;
+						param.registerIndex = bd.bindPoint;
+						param.num32BitValues = numValues;
 						findIt->second.push_back((int)rootParams.size());
 						rootParams.push_back(param);
 					}
@@ -272,11 +548,12 @@ namespace sl12
 					RootParameter param;
 					param.type = paramType;
 					param.shaderVisibility = shaderVisibility;
-					param.registerIndex = bd.BindPoint;
+					param.registerIndex = bd.bindPoint;
+					param.num32BitValues = numValues;
 
 					std::vector<int> indices;
 					indices.push_back((int)rootParams.size());
-					paramMap[bd.Name] = indices;
+					paramMap[bd.name] = indices;
 					rootParams.push_back(param);
 				}
 			}
@@ -289,7 +566,7 @@ namespace sl12
 		{
 			if (!ReflectShader(desc.pCS, ShaderVisibility::Compute))
 			{
-				return RootSignatureHandle(nullptr, 0, nullptr);
+				return false;
 			}
 			isGraphics = false;
 		}
@@ -297,64 +574,305 @@ namespace sl12
 		{
 			if (desc.pVS && !ReflectShader(desc.pVS, ShaderVisibility::Vertex))
 			{
-				return RootSignatureHandle(nullptr, 0, nullptr);
+				return false;
 			}
 			if (desc.pPS && !ReflectShader(desc.pPS, ShaderVisibility::Pixel))
 			{
-				return RootSignatureHandle(nullptr, 0, nullptr);
+				return false;
 			}
 			if (desc.pGS && !ReflectShader(desc.pGS, ShaderVisibility::Geometry))
 			{
-				return RootSignatureHandle(nullptr, 0, nullptr);
+				return false;
 			}
 			if (desc.pDS && !ReflectShader(desc.pDS, ShaderVisibility::Domain))
 			{
-				return RootSignatureHandle(nullptr, 0, nullptr);
+				return false;
 			}
 			if (desc.pHS && !ReflectShader(desc.pHS, ShaderVisibility::Hull))
 			{
-				return RootSignatureHandle(nullptr, 0, nullptr);
+				return false;
 			}
 		}
 
-		// 新規ルートシグネチャを生成する
-		RootSignatureInstance* pNewInstance = new RootSignatureInstance();
-		pNewInstance->isGraphics_ = isGraphics;
-		pNewInstance->slotMap_ = paramMap;
+		// 静的サンプラ同士、またはテーブルのサンプラとレジスタが重なる場合は昇格せずテーブルに戻す
+		auto IsOverlapped = [](D3D12_SHADER_VISIBILITY a, D3D12_SHADER_VISIBILITY b)
+		{
+			return (a == D3D12_SHADER_VISIBILITY_ALL) || (b == D3D12_SHADER_VISIBILITY_ALL) || (a == b);
+		};
+		for (auto&& sampler : promotedSamplers)
+		{
+			sampler.desc.ShaderVisibility = RootSignature::ToD3DShaderVisibility(sampler.shaderVisibility);
+
+			bool isConflict = false;
+			for (auto&& other : outEntry.staticSamplers)
+			{
+				isConflict = isConflict || ((other.ShaderRegister == sampler.desc.ShaderRegister) && (other.RegisterSpace == sampler.desc.RegisterSpace) && IsOverlapped(other.ShaderVisibility, sampler.desc.ShaderVisibility));
+			}
+			for (auto&& param : rootParams)
+			{
+				isConflict = isConflict || ((param.type == RootParameterType::Sampler) && (param.registerIndex == sampler.desc.ShaderRegister) && (sampler.desc.RegisterSpace == 0)
+					&& IsOverlapped(RootSignature::ToD3DShaderVisibility(param.shaderVisibility), sampler.desc.ShaderVisibility));
+			}
+
+			char text[256];
+			if (isConflict)
+			{
+				sprintf_s(text, "[sl12] RootSignatureManager : sampler '%s' (s%u) conflicts with another sampler, kept in descriptor table.\n", sampler.name.c_str(), sampler.desc.ShaderRegister);
+				OutputDebugStringA(text);
+				paramMap[sampler.name].push_back((int)rootParams.size());
+				rootParams.push_back(RootParameter(RootParameterType::Sampler, sampler.shaderVisibility, sampler.desc.ShaderRegister));
+				continue;
+			}
+
+			sprintf_s(text, "[sl12] RootSignatureManager : sampler '%s' (s%u, space%u) promoted to static sampler.\n", sampler.name.c_str(), sampler.desc.ShaderRegister, sampler.desc.RegisterSpace);
+			OutputDebugStringA(text);
+			outEntry.staticSamplers.push_back(sampler.desc);
+		}
+
+		// 小さい定数バッファをルート定数に、それ以外をルートCBVに昇格する
+		for (auto&& param : rootParams)
+		{
+			if (param.type != RootParameterType::ConstantBuffer)
+			{
+				continue;
+			}
+			if (param.num32BitValues > 0 && param.num32BitValues <= desc.maxRootConstants)
+			{
+				param.type = RootParameterType::RootConstants;
+			}
+			else if (desc.useRootCbv)
+			{
+				param.type = RootParameterType::RootConstantBuffer;
+			}
+		}
 
 		RootSignatureDesc rsDesc;
 		rsDesc.numParameters = (u32)rootParams.size();
 		rsDesc.pParameters = rootParams.data();
-		if (!pNewInstance->rootSig_.Initialize(pDevice_, rsDesc))
+		rsDesc.useBindless = desc.useBindless;
+
+		rsDesc.coalesceTables = IsTableCoalesced();
+		if (rsDesc.numParameters > RootSignature::kMaxParameters)
+		{
+			return false;
+		}
+
+		// サイズ上限を超える場合は大きいものから降格する
+		DemoteRootParameters(rootParams, rsDesc, desc.useRootCbv);
+
+		// 名前ごとのパラメータを登録する
+		outEntry.isGraphics = isGraphics;
+		outEntry.params = rootParams;
+		for (auto&& v : paramMap)
+		{
+			RootSignatureCacheEntry::Binding binding;
+			binding.nameHash = CalcFnv1a32(v.first.c_str());
+			binding.first = (u32)outEntry.paramIndices.size();
+			binding.count = (u32)v.second.size();
+			for (auto index : v.second)
+			{
+				outEntry.paramIndices.push_back((u32)index);
+			}
+			outEntry.bindings.push_back(binding);
+		}
+
+		return true;
+	}
+
+	//-------------------------------------------------
+	// パラメータからルートシグネチャインスタンスを生成する
+	//-------------------------------------------------
+	RootSignatureInstance* RootSignatureManager::CreateInstance(const RootSignatureCreateDesc& desc, const RootSignatureCacheEntry& entry, std::vector<u8>* pOutSerialized)
+	{
+		RootSignatureDesc rsDesc;
+		rsDesc.numParameters = (u32)entry.params.size();
+		rsDesc.pParameters = entry.params.data();
+		rsDesc.useBindless = desc.useBindless;
+		rsDesc.coalesceTables = IsTableCoalesced();
+		rsDesc.numStaticSamplers = (u32)entry.staticSamplers.size();
+		rsDesc.pStaticSamplers = entry.staticSamplers.data();
+		if (rsDesc.numParameters > RootSignature::kMaxParameters)
+		{
+			return nullptr;
+		}
+
+		std::vector<RootParameterSlot> slots(entry.params.size());
+		std::vector<u32> tableSizes(entry.params.size());
+		u32 numRootParams = RootSignature::CalcParameterSlots(rsDesc, slots.data(), tableSizes.data());
+
+		// 新規ルートシグネチャを生成する
+		RootSignatureInstance* pNewInstance = new RootSignatureInstance();
+		pNewInstance->isGraphics_ = entry.isGraphics;
+
+		// 名前のハッシュ値でソートした配列にスロットを登録する
+		for (auto&& binding : entry.bindings)
+		{
+			RootSignatureInstance::NameEntry nameEntry;
+			nameEntry.hash = binding.nameHash;
+			nameEntry.first = (u32)pNewInstance->slots_.size();
+			nameEntry.count = binding.count;
+			for (u32 i = 0; i < binding.count; i++)
+			{
+				pNewInstance->slots_.push_back(slots[entry.paramIndices[binding.first + i]]);
+			}
+			pNewInstance->names_.push_back(nameEntry);
+		}
+		std::sort(pNewInstance->names_.begin(), pNewInstance->names_.end(), [](const RootSignatureInstance::NameEntry& l, const RootSignatureInstance::NameEntry& r) { return l.hash < r.hash; });
+		for (size_t i = 1; i < pNewInstance->names_.size(); i++)
+		{
+			if (pNewInstance->names_[i - 1].hash == pNewInstance->names_[i].hash)
+			{
+				// ハッシュ値が衝突した場合は名前で区別できないので生成しない
+				OutputDebugStringA("[sl12] RootSignatureManager : binding name hash collision.\n");
+				delete pNewInstance;
+				return nullptr;
+			}
+		}
+		pNewInstance->params_.resize(numRootParams);
+		for (u32 i = 0; i < numRootParams; i++)
+		{
+			pNewInstance->params_[i].start = pNewInstance->numTableDescriptors_;
+			pNewInstance->params_[i].count = tableSizes[i];
+			pNewInstance->numTableDescriptors_ += tableSizes[i];
+		}
+		for (u32 i = 0; i < rsDesc.numParameters; i++)
+		{
+			pNewInstance->params_[slots[i].rootIndex].type = entry.params[i].type;
+		}
+		pNewInstance->bindlessRootIndex_ = desc.useBindless ? (int)numRootParams : -1;
+
+		// キャッシュのシリアライズ結果を使用するか、新たにシリアライズする
+		bool isCreated = false;
+		if (pOutSerialized)
+		{
+			ID3DBlob* pSerialized = nullptr;
+			if (RootSignature::Serialize(rsDesc, &pSerialized))
+			{
+				const u8* p = reinterpret_cast<const u8*>(pSerialized->GetBufferPointer());
+				pOutSerialized->assign(p, p + pSerialized->GetBufferSize());
+				isCreated = pNewInstance->rootSig_.Initialize(pDevice_, rsDesc, pSerialized->GetBufferPointer(), pSerialized->GetBufferSize());
+				SafeRelease(pSerialized);
+			}
+		}
+		else
+		{
+			isCreated = pNewInstance->rootSig_.Initialize(pDevice_, rsDesc, entry.serialized.data(), entry.serialized.size());
+		}
+		if (!isCreated)
 		{
 			delete pNewInstance;
-			return RootSignatureHandle(nullptr, 0, nullptr);
+			return nullptr;
+		}
+
+		return pNewInstance;
+	}
+
+	//-------------------------------------------------
+	// シェーダと生成オプションのハッシュ値を計算する
+	//-------------------------------------------------
+	u64 RootSignatureManager::CalcContentHash(const RootSignatureCreateDesc& desc)
+	{
+		Shader* pShaders[] = { desc.pVS, desc.pPS, desc.pGS, desc.pDS, desc.pHS, desc.pCS };
+		u64 hash = CalcFnv1a64(nullptr, 0);
+		for (auto pShader : pShaders)
+		{
+			// ステージごとにサイズを含めて区切る
+			u64 size = pShader ? pShader->GetSize() : 0;
+			hash = CalcFnv1a64(&size, sizeof(size), hash);
+			if (pShader)
+			{
+				hash = CalcFnv1a64(pShader->GetData(), pShader->GetSize(), hash);
+			}
 		}
+		u32 samplerHash = desc.pStaticSamplers ? desc.pStaticSamplers->GetHash() : 0;
+		u32 options[] = { desc.useBindless ? 1u : 0u, desc.maxRootConstants, desc.useRootCbv ? 1u : 0u, IsTableCoalesced() ? 1u : 0u, samplerHash };
+		return CalcFnv1a64(options, sizeof(options), hash);
+	}
 
-		// マップに登録
-		instanceMap_[crc] = pNewInstance;
+	//-------------------------------------------------
+	// ファイルキャッシュを読み込む
+	//-------------------------------------------------
+	bool RootSignatureManager::LoadCache(const char* filename)
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex_);
+		return cache_.Load(filename);
+	}
 
-		return RootSignatureHandle(this, crc, pNewInstance);
+	//-------------------------------------------------
+	// ファイルキャッシュを保存する
+	//-------------------------------------------------
+	bool RootSignatureManager::SaveCache(const char* filename) const
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex_);
+		return cache_.Save(filename);
 	}
 
 	//-------------------------------------------------
-	// ルートシグネチャを解放する
+	// サイズが上限に収まるようにパラメータを降格する
 	//-------------------------------------------------
-	void RootSignatureManager::ReleaseRootSignature(u32 crc, RootSignatureInstance* pInst)
+	bool RootSignatureManager::DemoteRootParameters(std::vector<RootParameter>& params, RootSignatureDesc& rsDesc, bool useRootCbv)
 	{
-		auto findIt = instanceMap_.find(crc);
-		if (findIt != instanceMap_.end())
+		// ルートCBVは2DWORDを消費するので、2DWORD以下のルート定数をルートCBVにしてもサイズは減らない
+		static const u32 kRootCbvDWords = 2;
+
+		rsDesc.numParameters = (u32)params.size();
+		rsDesc.pParameters = params.data();
+		while (RootSignature::CalcDWordCount(rsDesc) > RootSignature::kMaxDWords)
 		{
-			if (findIt->second == pInst)
+			RootParameter* pDemote = nullptr;
+			for (auto&& param : params)
 			{
-				pInst->referenceCounter_--;
-				if (pInst->referenceCounter_ == 0)
+				if (param.type == RootParameterType::RootConstants && (!pDemote || param.num32BitValues > pDemote->num32BitValues))
 				{
-					delete pInst;
-					instanceMap_.erase(findIt);
+					pDemote = &param;
 				}
 			}
+			if (!pDemote)
+			{
+				for (auto&& param : params)
+				{
+					if (param.type == RootParameterType::RootConstantBuffer)
+					{
+						pDemote = &param;
+						break;
+					}
+				}
+			}
+			if (!pDemote)
+			{
+				return false;
+			}
+
+			char text[256];
+			sprintf_s(text, "[sl12] RootSignatureManager : root signature size %u DWORDs exceeds %u DWORDs, demote %c%u.\n",
+				RootSignature::CalcDWordCount(rsDesc), RootSignature::kMaxDWords, GetRegisterClass(pDemote->type), pDemote->registerIndex);
+			OutputDebugStringA(text);
+			if (pDemote->type == RootParameterType::RootConstants && useRootCbv && pDemote->num32BitValues > kRootCbvDWords)
+				pDemote->type = RootParameterType::RootConstantBuffer;
+			else
+				pDemote->type = RootParameterType::ConstantBuffer;
 		}
+		return true;
+	}
+
+	//-------------------------------------------------
+	// テーブルをまとめるかどうか
+	//-------------------------------------------------
+	bool RootSignatureManager::IsTableCoalesced()
+	{
+		// ビューをステージングしている場合は、可視性とヒープ種別ごとにパラメータを1つのテーブルにまとめる
+		// シェーダから参照するヒープのデスクリプタはコピー元にできないため、ステージングしていない場合はまとめない
+		return pDevice_->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).IsViewStaged()
+			&& pDevice_->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER).IsViewStaged();
+	}
+
+	//-------------------------------------------------
+	// ルートシグネチャを解放する
+	//-------------------------------------------------
+	void RootSignatureManager::ReleaseRootSignature(u32 crc, RootSignatureInstance* pInst)
+	{
+		// 参照カウントが0になった場合のみロックを取る
+		instances_.Release(crc, pInst);
 	}
 
 }	// namespace sl12
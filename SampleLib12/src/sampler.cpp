@@ -9,7 +9,7 @@ namespace sl12
 	//----
 	bool Sampler::Initialize(Device* pDev, const D3D12_SAMPLER_DESC& desc)
 	{
-		pDesc_ = pDev->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER).CreateDescriptor();
+		pDesc_ = pDev->GetViewDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER).CreateDescriptor();
 		if (!pDesc_)
 		{
 			return false;
@@ -1,5 +1,6 @@
 ﻿#include <sl12/shader.h>
 
+#include <sl12/crc.h>
 #include <sl12/device.h>
 #include <sl12/file.h>
 
@@ -16,8 +17,10 @@ namespace sl12
 			return false;
 		}
 
-		// 初期化
-		return Initialize(pDev, type, f.GetData(), f.GetSize());
+		// 読み込んだメモリをそのまま所有する
+		size_t size = static_cast<size_t>(f.GetSize());
+		std::shared_ptr<const void> storage(f.DetachData());
+		return InitializeCommon(type, storage, storage.get(), size);
 	}
 
 	//----
@@ -29,17 +32,48 @@ namespace sl12
 		}
 
 		// メモリを確保
-		pData_ = new u8[size];
-		if (!pData_)
+		std::shared_ptr<u8> storage(new u8[size], std::default_delete<u8[]>());
+		if (!storage)
 		{
 			return false;
 		}
 
 		// コピー
-		memcpy(pData_, pData, size);
+		memcpy(storage.get(), pData, size);
 
+		return InitializeCommon(type, storage, storage.get(), size);
+	}
+
+	//----
+	bool Shader::InitializeReference(Device* pDev, ShaderType::Type type, const void* pData, size_t size)
+	{
+		return InitializeCommon(type, nullptr, pData, size);
+	}
+
+	//----
+	bool Shader::InitializeShared(Device* pDev, ShaderType::Type type, std::shared_ptr<const void> storage, const void* pData, size_t size)
+	{
+		if (!storage)
+		{
+			return false;
+		}
+		return InitializeCommon(type, storage, pData, size);
+	}
+
+	//----
+	bool Shader::InitializeCommon(ShaderType::Type type, std::shared_ptr<const void> storage, const void* pData, size_t size)
+	{
+		if (!pData || !size)
+		{
+			return false;
+		}
+		Destroy();
+
+		storage_ = storage;
+		pData_ = reinterpret_cast<const u8*>(pData);
 		size_ = size;
 		shaderType_ = type;
+		hash_ = CalcFnv1a64(pData_, size_);
 
 		return true;
 	}
@@ -47,7 +81,10 @@ namespace sl12
 	//----
 	void Shader::Destroy()
 	{
-		sl12::SafeDeleteArray(pData_);
+		storage_.reset();
+		pData_ = nullptr;
+		size_ = 0;
+		hash_ = 0;
 	}
 
 }	// namespace sl12
@@ -0,0 +1,233 @@
+﻿#include <sl12/shader_dependency_graph.h>
+
+#include <algorithm>
+#include <cctype>
+
+
+namespace sl12
+{
+	const ShaderDependencyGraph::NodeId ShaderDependencyGraph::kInvalidNode;
+
+	//-------------------------------------------------
+	// ファイルノードを追加する
+	//-------------------------------------------------
+	ShaderDependencyGraph::NodeId ShaderDependencyGraph::AddFileNode(const char* filename, const NodeId* pIncludes, u32 numIncludes)
+	{
+		if (!filename || !*filename)
+		{
+			return kInvalidNode;
+		}
+
+		std::string path = NormalizePath(filename);
+		if (fileMap_.find(path) != fileMap_.end())
+		{
+			return kInvalidNode;
+		}
+
+		// インクルードファイルはファイルノードのみ
+		for (u32 i = 0; i < numIncludes; i++)
+		{
+			if (pIncludes[i] >= nodes_.size() || !IsFileNode(pIncludes[i]))
+			{
+				return kInvalidNode;
+			}
+		}
+
+		NodeId id = AddNodeCommon(path, pIncludes, numIncludes);
+		if (id != kInvalidNode)
+		{
+			fileMap_[path] = id;
+		}
+		return id;
+	}
+
+	//-------------------------------------------------
+	// ノードを追加する
+	//-------------------------------------------------
+	ShaderDependencyGraph::NodeId ShaderDependencyGraph::AddNode(const NodeId* pDependencies, u32 numDependencies)
+	{
+		return AddNodeCommon(std::string(), pDependencies, numDependencies);
+	}
+
+	//-------------------------------------------------
+	// ノードを追加する
+	//-------------------------------------------------
+	ShaderDependencyGraph::NodeId ShaderDependencyGraph::AddNodeCommon(const std::string& filename, const NodeId* pDependencies, u32 numDependencies)
+	{
+		NodeId id = static_cast<NodeId>(nodes_.size());
+		Node node;
+		node.filename = filename;
+		for (u32 i = 0; i < numDependencies; i++)
+		{
+			NodeId dep = pDependencies[i];
+			if (dep >= id || nodes_[dep].isRemoved)
+			{
+				return kInvalidNode;
+			}
+			if (std::find(node.dependencies.begin(), node.dependencies.end(), dep) == node.dependencies.end())
+			{
+				node.dependencies.push_back(dep);
+			}
+		}
+
+		for (auto dep : node.dependencies)
+		{
+			nodes_[dep].dependents.push_back(id);
+		}
+		nodes_.push_back(node);
+		return id;
+	}
+
+	//-------------------------------------------------
+	// ファイルノードを取り除く
+	//-------------------------------------------------
+	bool ShaderDependencyGraph::RemoveFile(const char* filename)
+	{
+		auto it = fileMap_.find(NormalizePath(filename));
+		if (it == fileMap_.end())
+		{
+			return false;
+		}
+		NodeId id = it->second;
+		fileMap_.erase(it);
+
+		auto&& node = nodes_[id];
+		for (auto dep : node.dependencies)
+		{
+			auto&& v = nodes_[dep].dependents;
+			v.erase(std::remove(v.begin(), v.end(), id), v.end());
+		}
+		for (auto dependent : node.dependents)
+		{
+			auto&& v = nodes_[dependent].dependencies;
+			v.erase(std::remove(v.begin(), v.end(), id), v.end());
+		}
+		node.dependencies.clear();
+		node.dependents.clear();
+		node.isRemoved = true;
+		return true;
+	}
+
+	//-------------------------------------------------
+	// クリア
+	//-------------------------------------------------
+	void ShaderDependencyGraph::Clear()
+	{
+		nodes_.clear();
+		fileMap_.clear();
+	}
+
+	//-------------------------------------------------
+	// ファイルノードを検索する
+	//-------------------------------------------------
+	ShaderDependencyGraph::NodeId ShaderDependencyGraph::FindFile(const char* filename) const
+	{
+		auto it = fileMap_.find(NormalizePath(filename));
+		return (it != fileMap_.end()) ? it->second : kInvalidNode;
+	}
+
+	//-------------------------------------------------
+	// 影響を受けるノードを列挙する
+	//-------------------------------------------------
+	void ShaderDependencyGraph::CollectAffected(const std::vector<NodeId>& roots, std::vector<NodeId>& outNodes) const
+	{
+		outNodes.clear();
+		std::vector<u8> visited(nodes_.size(), 0);
+		std::vector<NodeId> stack;
+		for (auto id : roots)
+		{
+			if (id < nodes_.size() && !nodes_[id].isRemoved && !visited[id])
+			{
+				visited[id] = 1;
+				stack.push_back(id);
+			}
+		}
+		while (!stack.empty())
+		{
+			NodeId id = stack.back();
+			stack.pop_back();
+			outNodes.push_back(id);
+			for (auto dependent : nodes_[id].dependents)
+			{
+				if (!visited[dependent])
+				{
+					visited[dependent] = 1;
+					stack.push_back(dependent);
+				}
+			}
+		}
+
+		// 依存先は必ず小さいIDを持つので、ID順がそのまま処理順になる
+		std::sort(outNodes.begin(), outNodes.end());
+	}
+
+	//-------------------------------------------------
+	// 依存関係を辿って再構築する
+	//-------------------------------------------------
+	bool ShaderDependencyGraph::Propagate(const std::vector<NodeId>& roots, const RebuildFunc& rebuild, std::vector<NodeId>* pRebuiltNodes) const
+	{
+		if (pRebuiltNodes)
+		{
+			pRebuiltNodes->clear();
+		}
+
+		std::vector<NodeId> affected;
+		CollectAffected(roots, affected);
+
+		std::vector<u8> isRoot(nodes_.size(), 0);
+		for (auto id : roots)
+		{
+			if (id < nodes_.size())
+			{
+				isRoot[id] = 1;
+			}
+		}
+
+		std::vector<u8> isChanged(nodes_.size(), 0);
+		for (auto id : affected)
+		{
+			bool isDirty = isRoot[id] != 0;
+			for (auto dep : nodes_[id].dependencies)
+			{
+				isDirty = isDirty || isChanged[dep];
+			}
+			if (!isDirty)
+			{
+				continue;
+			}
+
+			auto ret = rebuild(id);
+			if (ret == RebuildResult::Failed)
+			{
+				return false;
+			}
+			isChanged[id] = (ret == RebuildResult::Changed) ? 1 : 0;
+			if (pRebuiltNodes)
+			{
+				pRebuiltNodes->push_back(id);
+			}
+		}
+		return true;
+	}
+
+	//-------------------------------------------------
+	// ファイル名を正規化する
+	//-------------------------------------------------
+	std::string ShaderDependencyGraph::NormalizePath(const char* filename)
+	{
+		std::string path = filename ? filename : "";
+		for (auto&& c : path)
+		{
+			c = (c == '\\') ? '/' : static_cast<char>(tolower(static_cast<unsigned char>(c)));
+		}
+		// 先頭の"./"は取り除く
+		while (path.compare(0, 2, "./") == 0)
+		{
+			path.erase(0, 2);
+		}
+		return path;
+	}
+
+}	// namespace sl12
+
+//	EOF
@@ -0,0 +1,617 @@
+﻿#include <sl12/shader_package.h>
+
+#include <sl12/cache_stream.h>
+#include <sl12/crc.h>
+#include <sl12/shader_reflection.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#endif
+
+
+namespace sl12
+{
+	namespace
+	{
+		typedef ShaderPackageFormat Format;
+
+		static_assert(sizeof(Format::Header) == 16, "ShaderPackageFormat::Header size mismatch.");
+		static_assert(sizeof(Format::Entry) == 72, "ShaderPackageFormat::Entry size mismatch.");
+		static_assert(sizeof(Format::Binding) == 24, "ShaderPackageFormat::Binding size mismatch.");
+
+		u64 AlignOffset(u64 offset, u64 align)
+		{
+			return ((offset + align - 1) / align) * align;
+		}
+
+		u64 CalcNameHash(const char* name)
+		{
+			return CalcFnv1a64(name, strlen(name));
+		}
+	}
+
+	//-------------------------------------------------
+	// ファイルの識別情報を取得する
+	//-------------------------------------------------
+	bool GetShaderSourceStamp(const char* filename, ShaderSourceStamp& outStamp)
+	{
+		outStamp = ShaderSourceStamp();
+		if (!filename)
+		{
+			return false;
+		}
+
+#if defined(_WIN32)
+		WIN32_FILE_ATTRIBUTE_DATA data;
+		if (!GetFileAttributesExA(filename, GetFileExInfoStandard, &data))
+		{
+			return false;
+		}
+		outStamp.lastWriteTime = (static_cast<u64>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+		outStamp.size = (static_cast<u64>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+#else
+		struct stat st;
+		if (stat(filename, &st) != 0)
+		{
+			return false;
+		}
+		outStamp.lastWriteTime = static_cast<u64>(st.st_mtim.tv_sec) * 1000000000ull + static_cast<u64>(st.st_mtim.tv_nsec);
+		outStamp.size = static_cast<u64>(st.st_size);
+#endif
+		return true;
+	}
+
+	const u32 ShaderPackageFormat::kMagic;
+	const u32 ShaderPackageFormat::kVersion;
+	const u32 ShaderPackageFormat::kDataAlignment;
+	const u32 ShaderPackage::kInvalidIndex;
+
+	//-------------------------------------------------
+	// シェーダを追加する(リフレクションを行う)
+	//-------------------------------------------------
+	bool ShaderPackageBuilder::AddShader(const char* name, ShaderType::Type type, const void* pData, size_t size)
+	{
+		if (!AddEntry(name, type, pData, size))
+		{
+			return false;
+		}
+
+		auto&& entry = entries_.back();
+		std::vector<ShaderBindingDesc> bindings;
+		if (!ReflectShaderBindings(pData, size, bindings))
+		{
+			char text[256];
+			sprintf_s(text, "[sl12] ShaderPackageBuilder : %s could not be reflected, stored without bindings.\n", name);
+			OutputDebugStringA(text);
+			return true;
+		}
+
+		entry.bindings.reserve(bindings.size());
+		for (auto&& bd : bindings)
+		{
+			BindingSource b;
+			b.name = bd.name;
+			b.inputType = bd.inputType;
+			b.bindPoint = bd.bindPoint;
+			b.bindCount = bd.bindCount;
+			b.space = bd.space;
+			b.dimension = bd.dimension;
+			entry.bindings.push_back(b);
+		}
+		entry.hasReflection = true;
+		return true;
+	}
+
+	//-------------------------------------------------
+	// バインディングを指定してシェーダを追加する
+	//-------------------------------------------------
+	bool ShaderPackageBuilder::AddShader(const char* name, ShaderType::Type type, const void* pData, size_t size, const ShaderPackageBinding* pBindings, u32 numBindings)
+	{
+		if ((numBindings > 0 && !pBindings) || !AddEntry(name, type, pData, size))
+		{
+			return false;
+		}
+
+		auto&& entry = entries_.back();
+		entry.bindings.reserve(numBindings);
+		for (u32 i = 0; i < numBindings; i++)
+		{
+			BindingSource b;
+			b.name = pBindings[i].name ? pBindings[i].name : "";
+			b.inputType = pBindings[i].inputType;
+			b.bindPoint = pBindings[i].bindPoint;
+			b.bindCount = pBindings[i].bindCount;
+			b.space = pBindings[i].space;
+			b.dimension = pBindings[i].dimension;
+			entry.bindings.push_back(b);
+		}
+		entry.hasReflection = true;
+		return true;
+	}
+
+	//-------------------------------------------------
+	// エントリを追加する
+	//-------------------------------------------------
+	bool ShaderPackageBuilder::AddEntry(const char* name, ShaderType::Type type, const void* pData, size_t size)
+	{
+		if (!name || !pData || !size || type >= ShaderType::Max)
+		{
+			return false;
+		}
+		if (size > 0xffffffff)
+		{
+			return false;
+		}
+		for (auto&& e : entries_)
+		{
+			if (e.name == name)
+			{
+				char text[256];
+				sprintf_s(text, "[sl12] ShaderPackageBuilder : %s is already added.\n", name);
+				OutputDebugStringA(text);
+				return false;
+			}
+		}
+
+		EntrySource entry;
+		entry.name = name;
+		entry.nameHash = CalcNameHash(name);
+		entry.type = type;
+		entry.data.assign(reinterpret_cast<const u8*>(pData), reinterpret_cast<const u8*>(pData) + size);
+		entry.hasReflection = false;
+		entries_.push_back(std::move(entry));
+		return true;
+	}
+
+	//-------------------------------------------------
+	// ソースファイルの識別情報を記録する
+	//-------------------------------------------------
+	bool ShaderPackageBuilder::SetSourceStamp(const char* name, const ShaderSourceStamp& stamp)
+	{
+		if (!name)
+		{
+			return false;
+		}
+		for (auto&& e : entries_)
+		{
+			if (e.name == name)
+			{
+				e.stamp = stamp;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//-------------------------------------------------
+	// クリア
+	//-------------------------------------------------
+	void ShaderPackageBuilder::Clear()
+	{
+		entries_.clear();
+	}
+
+	//-------------------------------------------------
+	// ファイルに保存する
+	//-------------------------------------------------
+	bool ShaderPackageBuilder::Save(const char* filename) const
+	{
+		std::vector<u8> data;
+		if (!SaveToMemory(data))
+		{
+			return false;
+		}
+
+		std::ofstream fout(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!fout.is_open())
+		{
+			return false;
+		}
+		fout.write(reinterpret_cast<const char*>(data.data()), data.size());
+		return fout.good();
+	}
+
+	//-------------------------------------------------
+	// メモリに保存する
+	//-------------------------------------------------
+	bool ShaderPackageBuilder::SaveToMemory(std::vector<u8>& outData) const
+	{
+		outData.clear();
+
+		// インデックスは名前のハッシュ値、名前の順に並べる
+		std::vector<const EntrySource*> sorted;
+		sorted.reserve(entries_.size());
+		for (auto&& e : entries_)
+		{
+			sorted.push_back(&e);
+		}
+		std::sort(sorted.begin(), sorted.end(), [](const EntrySource* a, const EntrySource* b)
+		{
+			return (a->nameHash != b->nameHash) ? (a->nameHash < b->nameHash) : (a->name < b->name);
+		});
+
+		// レイアウトを決定する
+		u32 count = static_cast<u32>(sorted.size());
+		u64 offset = sizeof(Format::Header) + sizeof(Format::Entry) * static_cast<u64>(count);
+
+		std::vector<u32> nameOffsets(count);
+		std::vector<std::vector<u32>> bindingNameOffsets(count);
+		for (u32 i = 0; i < count; i++)
+		{
+			nameOffsets[i] = static_cast<u32>(offset);
+			offset += sorted[i]->name.size() + 1;
+			for (auto&& b : sorted[i]->bindings)
+			{
+				bindingNameOffsets[i].push_back(static_cast<u32>(offset));
+				offset += b.name.size() + 1;
+			}
+		}
+
+		offset = AlignOffset(offset, sizeof(u32));
+		std::vector<u32> bindingOffsets(count);
+		for (u32 i = 0; i < count; i++)
+		{
+			bindingOffsets[i] = static_cast<u32>(offset);
+			offset += sizeof(Format::Binding) * sorted[i]->bindings.size();
+		}
+
+		std::vector<u64> dataOffsets(count);
+		for (u32 i = 0; i < count; i++)
+		{
+			offset = AlignOffset(offset, Format::kDataAlignment);
+			dataOffsets[i] = offset;
+			offset += sorted[i]->data.size();
+		}
+		u64 totalSize = offset;
+
+		// 文字列とバインディングのオフセットは32bitで保持する
+		if (!dataOffsets.empty() && dataOffsets[0] > 0xffffffff)
+		{
+			OutputDebugStringA("[sl12] ShaderPackageBuilder : string and binding table is too large.\n");
+			return false;
+		}
+
+		// 書き出す
+		CacheWriter writer;
+		writer.Write32(Format::kMagic);
+		writer.Write32(Format::kVersion);
+		writer.Write32(count);
+		writer.Write32(Format::kDataAlignment);
+		for (u32 i = 0; i < count; i++)
+		{
+			auto&& e = *sorted[i];
+			writer.Write64(e.nameHash);
+			writer.Write64(CalcFnv1a64(e.data.data(), e.data.size()));
+			writer.Write64(dataOffsets[i]);
+			writer.Write32(static_cast<u32>(e.data.size()));
+			writer.Write32(nameOffsets[i]);
+			writer.Write32(static_cast<u32>(e.name.size()));
+			writer.Write32(static_cast<u32>(e.type));
+			writer.Write32(bindingOffsets[i]);
+			writer.Write32(static_cast<u32>(e.bindings.size()));
+			writer.Write32(e.hasReflection ? Format::HasReflection : 0);
+			writer.Write32(0);
+			writer.Write64(e.stamp.lastWriteTime);
+			writer.Write64(e.stamp.size);
+		}
+		for (u32 i = 0; i < count; i++)
+		{
+			writer.WriteBytes(sorted[i]->name.c_str(), sorted[i]->name.size() + 1);
+			for (auto&& b : sorted[i]->bindings)
+			{
+				writer.WriteBytes(b.name.c_str(), b.name.size() + 1);
+			}
+		}
+
+		auto Pad = [&](u64 target)
+		{
+			static const u8 kZero[Format::kDataAlignment] = {};
+			writer.WriteBytes(kZero, static_cast<size_t>(target - writer.GetData().size()));
+		};
+		if (count > 0)
+		{
+			Pad(bindingOffsets[0]);
+		}
+		for (u32 i = 0; i < count; i++)
+		{
+			auto&& bindings = sorted[i]->bindings;
+			for (size_t j = 0; j < bindings.size(); j++)
+			{
+				writer.Write32(bindingNameOffsets[i][j]);
+				writer.Write32(bindings[j].inputType);
+				writer.Write32(bindings[j].bindPoint);
+				writer.Write32(bindings[j].bindCount);
+				writer.Write32(bindings[j].space);
+				writer.Write32(bindings[j].dimension);
+			}
+		}
+		for (u32 i = 0; i < count; i++)
+		{
+			Pad(dataOffsets[i]);
+			writer.WriteBytes(sorted[i]->data.data(), sorted[i]->data.size());
+		}
+
+		outData = writer.GetData();
+		return outData.size() == totalSize;
+	}
+
+
+	//-------------------------------------------------
+	// パッケージファイルを開く
+	//-------------------------------------------------
+	bool ShaderPackage::Open(const char* filename)
+	{
+		Close();
+
+		HANDLE hFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (hFile == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart <= 0)
+		{
+			CloseHandle(hFile);
+			return false;
+		}
+
+		// マッピングとビューはそれぞれ参照を保持するので、ハンドルはすぐに閉じてよい
+		HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(hFile);
+		if (!hMapping)
+		{
+			return false;
+		}
+		void* pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(hMapping);
+		if (!pView)
+		{
+			return false;
+		}
+
+		std::shared_ptr<const void> storage(pView, [](const void* p) { UnmapViewOfFile(p); });
+		if (!OpenFromMemory(storage, pView, static_cast<u64>(fileSize.QuadPart)))
+		{
+			char text[256];
+			sprintf_s(text, "[sl12] ShaderPackage : %s is not a valid shader package.\n", filename);
+			OutputDebugStringA(text);
+			return false;
+		}
+		return true;
+	}
+
+	//-------------------------------------------------
+	// メモリ上のパッケージを開く
+	//-------------------------------------------------
+	bool ShaderPackage::OpenFromMemory(std::shared_ptr<const void> storage, const void* pData, u64 size)
+	{
+		Close();
+
+		// インデックスをそのまま参照するのでアラインメントが必要
+		if (!pData || (reinterpret_cast<uintptr_t>(pData) % alignof(Format::Entry)) != 0)
+		{
+			return false;
+		}
+
+		storage_ = storage;
+		pData_ = reinterpret_cast<const u8*>(pData);
+		size_ = size;
+		if (!Validate())
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	//-------------------------------------------------
+	// 閉じる
+	//-------------------------------------------------
+	void ShaderPackage::Close()
+	{
+		storage_.reset();
+		pData_ = nullptr;
+		size_ = 0;
+		pEntries_ = nullptr;
+		count_ = 0;
+	}
+
+	//-------------------------------------------------
+	// ヘッダとインデックスを検証する
+	//-------------------------------------------------
+	bool ShaderPackage::Validate()
+	{
+		// バイトコードには触れない
+		Format::Header header;
+		if (size_ < sizeof(header))
+		{
+			return false;
+		}
+		memcpy(&header, pData_, sizeof(header));
+		if (header.magic != Format::kMagic || header.version != Format::kVersion || header.dataAlignment != Format::kDataAlignment)
+		{
+			return false;
+		}
+		if (static_cast<u64>(header.count) * sizeof(Format::Entry) > size_ - sizeof(header))
+		{
+			return false;
+		}
+
+		auto IsValidString = [&](u64 offset, u64 length)
+		{
+			return (offset < size_) && (length < size_ - offset) && (pData_[offset + length] == '\0');
+		};
+
+		auto pEntries = reinterpret_cast<const Format::Entry*>(pData_ + sizeof(header));
+		for (u32 i = 0; i < header.count; i++)
+		{
+			auto&& e = pEntries[i];
+			if (e.shaderType >= ShaderType::Max || e.dataSize == 0)
+			{
+				return false;
+			}
+			if (e.dataOffset > size_ || e.dataSize > size_ - e.dataOffset || (e.dataOffset % Format::kDataAlignment) != 0)
+			{
+				return false;
+			}
+			if (!IsValidString(e.nameOffset, e.nameLength))
+			{
+				return false;
+			}
+			const char* name = reinterpret_cast<const char*>(pData_ + e.nameOffset);
+			if (strlen(name) != e.nameLength || CalcFnv1a64(name, e.nameLength) != e.nameHash)
+			{
+				return false;
+			}
+
+			// ハッシュ値、名前の順にソートされていること
+			if (i > 0)
+			{
+				auto&& prev = pEntries[i - 1];
+				if (prev.nameHash > e.nameHash)
+				{
+					return false;
+				}
+				if (prev.nameHash == e.nameHash && strcmp(reinterpret_cast<const char*>(pData_ + prev.nameOffset), name) >= 0)
+				{
+					return false;
+				}
+			}
+
+			if ((e.bindingOffset % sizeof(u32)) != 0 || e.bindingOffset > size_
+				|| static_cast<u64>(e.bindingCount) * sizeof(Format::Binding) > size_ - e.bindingOffset)
+			{
+				return false;
+			}
+			auto pBindings = reinterpret_cast<const Format::Binding*>(pData_ + e.bindingOffset);
+			for (u32 j = 0; j < e.bindingCount; j++)
+			{
+				u64 nameOffset = pBindings[j].nameOffset;
+				if (nameOffset >= size_ || !memchr(pData_ + nameOffset, '\0', static_cast<size_t>(size_ - nameOffset)))
+				{
+					return false;
+				}
+			}
+		}
+
+		pEntries_ = pEntries;
+		count_ = header.count;
+		return true;
+	}
+
+	//-------------------------------------------------
+	// 名前からシェーダを検索する
+	//-------------------------------------------------
+	u32 ShaderPackage::Find(const char* name) const
+	{
+		if (!pEntries_ || !name)
+		{
+			return kInvalidIndex;
+		}
+
+		u64 hash = CalcNameHash(name);
+		auto pEnd = pEntries_ + count_;
+		auto it = std::lower_bound(pEntries_, pEnd, hash, [](const Format::Entry& e, u64 h) { return e.nameHash < h; });
+		for (; it != pEnd && it->nameHash == hash; ++it)
+		{
+			if (strcmp(GetString(it->nameOffset), name) == 0)
+			{
+				return static_cast<u32>(it - pEntries_);
+			}
+		}
+		return kInvalidIndex;
+	}
+
+	//-------------------------------------------------
+	// Shaderを生成する
+	//-------------------------------------------------
+	bool ShaderPackage::CreateShader(Device* pDev, const char* name, Shader& outShader) const
+	{
+		u32 index = Find(name);
+		if (index == kInvalidIndex)
+		{
+			char text[256];
+			sprintf_s(text, "[sl12] ShaderPackage : %s is not found.\n", name ? name : "(null)");
+			OutputDebugStringA(text);
+			return false;
+		}
+		return CreateShader(pDev, index, outShader);
+	}
+	bool ShaderPackage::CreateShader(Device* pDev, u32 index, Shader& outShader) const
+	{
+		if (index >= count_)
+		{
+			return false;
+		}
+
+		auto&& e = pEntries_[index];
+		if (!outShader.InitializeShared(pDev, static_cast<ShaderType::Type>(e.shaderType), storage_, pData_ + e.dataOffset, e.dataSize))
+		{
+			return false;
+		}
+
+		// Shaderが計算したハッシュ値でバイトコードの破損を検出する
+		if (outShader.GetHash() != e.bytecodeHash)
+		{
+			char text[256];
+			sprintf_s(text, "[sl12] ShaderPackage : %s is corrupted.\n", GetString(e.nameOffset));
+			OutputDebugStringA(text);
+			outShader.Destroy();
+			return false;
+		}
+		return true;
+	}
+
+	//-------------------------------------------------
+	// リソースバインディングを取得する
+	//-------------------------------------------------
+	bool ShaderPackage::GetBinding(u32 index, u32 bindingIndex, ShaderPackageBinding& outBinding) const
+	{
+		if (index >= count_ || bindingIndex >= pEntries_[index].bindingCount)
+		{
+			return false;
+		}
+
+		auto&& b = reinterpret_cast<const Format::Binding*>(pData_ + pEntries_[index].bindingOffset)[bindingIndex];
+		outBinding.name = GetString(b.nameOffset);
+		outBinding.inputType = b.inputType;
+		outBinding.bindPoint = b.bindPoint;
+		outBinding.bindCount = b.bindCount;
+		outBinding.space = b.space;
+		outBinding.dimension = b.dimension;
+		return true;
+	}
+
+	//-------------------------------------------------
+	// ソースファイルが変更されていないか調べる
+	//-------------------------------------------------
+	bool ShaderPackage::IsSourceUpToDate(u32 index, const char* sourceFile) const
+	{
+		if (index >= count_)
+		{
+			return false;
+		}
+
+		ShaderSourceStamp current;
+		if (!GetShaderSourceStamp(sourceFile, current))
+		{
+			// パッケージのみを配布している
+			return true;
+		}
+		if (GetSourceStamp(index) != current)
+		{
+			char text[256];
+			sprintf_s(text, "[sl12] ShaderPackage : %s is newer than the package.\n", sourceFile);
+			OutputDebugStringA(text);
+			return false;
+		}
+		return true;
+	}
+
+}	// namespace sl12
+
+//	EOF
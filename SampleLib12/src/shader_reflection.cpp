@@ -0,0 +1,360 @@
+﻿#include <sl12/shader_reflection.h>
+
+#include <cstring>
+
+#if defined(_WIN32)
+#include <d3dcompiler.h>
+#endif
+
+
+namespace sl12
+{
+	namespace
+	{
+		static const u32 kContainerHeaderSize = 32;		// FourCC, ダイジェスト, バージョン, サイズ, チャンク数
+		static const u32 kChunkHeaderSize = 8;			// FourCC, サイズ
+		static const u32 kResourceDefHeaderSize = 28;
+		static const u32 kResourceDefCBSize = 24;
+		static const u32 kResourceDefBindSize = 32;
+		static const u32 kResourceDefBindSize51 = 40;	// SM5.1以降はスペースとIDが追加される
+		static const u32 kPsvBindSize = 16;				// PSVResourceBindInfo0
+		static const u32 kUnbounded = 0xffffffff;
+
+		// D3D_SHADER_INPUT_TYPE. D3DReflectを使用しない環境でも解析できるよう値を持つ
+		static const u32 kSitCBuffer = 0;
+		static const u32 kSitTexture = 2;
+		static const u32 kSitSampler = 3;
+		static const u32 kSitUavRWTyped = 4;
+		static const u32 kSitStructured = 5;
+		static const u32 kSitUavRWStructured = 6;
+		static const u32 kSitByteAddress = 7;
+		static const u32 kSitUavRWByteAddress = 8;
+		static const u32 kSitUavRWStructuredWithCounter = 11;
+
+		u32 ReadU32(const u8* p)
+		{
+			u32 v;
+			memcpy(&v, p, sizeof(v));
+			return v;
+		}
+
+		// 範囲内でNULL終端されている文字列のみを読み込む
+		bool ReadString(const u8* pChunk, u32 chunkSize, u32 offset, std::string& outString)
+		{
+			if (offset >= chunkSize)
+			{
+				return false;
+			}
+			auto p = reinterpret_cast<const char*>(pChunk + offset);
+			auto pEnd = static_cast<const char*>(memchr(p, '\0', chunkSize - offset));
+			if (!pEnd)
+			{
+				return false;
+			}
+			outString.assign(p, pEnd);
+			return true;
+		}
+
+		// PSVResourceTypeからD3D_SHADER_INPUT_TYPEに変換する
+		bool ConvertPsvResourceType(u32 psvType, u32& outType)
+		{
+			switch (psvType)
+			{
+			case 1: outType = kSitSampler; return true;
+			case 2: outType = kSitCBuffer; return true;
+			case 3: outType = kSitTexture; return true;
+			case 4: outType = kSitByteAddress; return true;
+			case 5: outType = kSitStructured; return true;
+			case 6: outType = kSitUavRWTyped; return true;
+			case 7: outType = kSitUavRWByteAddress; return true;
+			case 8: outType = kSitUavRWStructured; return true;
+			case 9: outType = kSitUavRWStructuredWithCounter; return true;
+			default: return false;
+			}
+		}
+	}
+
+	const u32 DxbcContainer::kFourCCContainer;
+	const u32 DxbcContainer::kFourCCResourceDef;
+	const u32 DxbcContainer::kFourCCPipelineState;
+	const u32 DxbcContainer::kFourCCDxil;
+
+	//-------------------------------------------------
+	// コンテナを解析する
+	//-------------------------------------------------
+	bool DxbcContainer::Initialize(const void* pData, size_t size)
+	{
+		Destroy();
+
+		auto p = static_cast<const u8*>(pData);
+		if (!p || size < kContainerHeaderSize || ReadU32(p) != kFourCCContainer)
+		{
+			return false;
+		}
+
+		// コンテナのサイズを超える部分は無視する
+		u32 totalSize = ReadU32(p + 24);
+		u32 chunkCount = ReadU32(p + 28);
+		if (totalSize < kContainerHeaderSize || totalSize > size)
+		{
+			return false;
+		}
+		if (static_cast<u64>(kContainerHeaderSize) + static_cast<u64>(chunkCount) * 4 > totalSize)
+		{
+			return false;
+		}
+
+		std::vector<Chunk> chunks(chunkCount);
+		for (u32 i = 0; i < chunkCount; i++)
+		{
+			u32 offset = ReadU32(p + kContainerHeaderSize + i * 4);
+			if (static_cast<u64>(offset) + kChunkHeaderSize > totalSize)
+			{
+				return false;
+			}
+			chunks[i].fourCC = ReadU32(p + offset);
+			chunks[i].size = ReadU32(p + offset + 4);
+			chunks[i].offset = offset + kChunkHeaderSize;
+			if (static_cast<u64>(chunks[i].offset) + chunks[i].size > totalSize)
+			{
+				return false;
+			}
+		}
+
+		pData_ = p;
+		size_ = totalSize;
+		chunks_.swap(chunks);
+		return true;
+	}
+
+	//-------------------------------------------------
+	// 破棄
+	//-------------------------------------------------
+	void DxbcContainer::Destroy()
+	{
+		pData_ = nullptr;
+		size_ = 0;
+		chunks_.clear();
+	}
+
+	//-------------------------------------------------
+	// チャンクを検索する
+	//-------------------------------------------------
+	const u8* DxbcContainer::FindChunk(u32 fourCC, u32* pSize) const
+	{
+		for (auto&& chunk : chunks_)
+		{
+			if (chunk.fourCC == fourCC)
+			{
+				if (pSize)
+				{
+					*pSize = chunk.size;
+				}
+				return pData_ + chunk.offset;
+			}
+		}
+		return nullptr;
+	}
+
+	//-------------------------------------------------
+	// RDEFチャンクからリソースバインドを取得する
+	//-------------------------------------------------
+	bool DxbcContainer::GetBindingsFromResourceDef(std::vector<ShaderBindingDesc>& outBindings) const
+	{
+		outBindings.clear();
+
+		u32 size = 0;
+		const u8* p = FindChunk(kFourCCResourceDef, &size);
+		if (!p || size < kResourceDefHeaderSize)
+		{
+			return false;
+		}
+
+		u32 cbCount = ReadU32(p + 0);
+		u32 cbOffset = ReadU32(p + 4);
+		u32 bindCount = ReadU32(p + 8);
+		u32 bindOffset = ReadU32(p + 12);
+		u32 minorVersion = p[16];
+		u32 majorVersion = p[17];
+		u32 bindSize = (majorVersion > 5 || (majorVersion == 5 && minorVersion >= 1)) ? kResourceDefBindSize51 : kResourceDefBindSize;
+		if (static_cast<u64>(cbOffset) + static_cast<u64>(cbCount) * kResourceDefCBSize > size
+			|| static_cast<u64>(bindOffset) + static_cast<u64>(bindCount) * bindSize > size)
+		{
+			return false;
+		}
+
+		std::vector<ShaderBindingDesc> bindings(bindCount);
+		for (u32 i = 0; i < bindCount; i++)
+		{
+			const u8* b = p + bindOffset + i * bindSize;
+			auto&& desc = bindings[i];
+			if (!ReadString(p, size, ReadU32(b + 0), desc.name))
+			{
+				return false;
+			}
+			desc.inputType = ReadU32(b + 4);
+			desc.dimension = ReadU32(b + 12);
+			desc.bindPoint = ReadU32(b + 20);
+			desc.bindCount = ReadU32(b + 24);
+			desc.space = (bindSize == kResourceDefBindSize51) ? ReadU32(b + 32) : 0;
+			if (desc.bindCount == kUnbounded)
+			{
+				desc.bindCount = 0;
+			}
+		}
+
+		// 定数バッファのサイズは同名の定数バッファ記述から取得する
+		std::string cbName;
+		for (u32 i = 0; i < cbCount; i++)
+		{
+			const u8* c = p + cbOffset + i * kResourceDefCBSize;
+			if (!ReadString(p, size, ReadU32(c + 0), cbName))
+			{
+				return false;
+			}
+			for (auto&& desc : bindings)
+			{
+				if (desc.inputType == kSitCBuffer && desc.constantBufferSize == 0 && desc.name == cbName)
+				{
+					desc.constantBufferSize = ReadU32(c + 12);
+					break;
+				}
+			}
+		}
+
+		outBindings.swap(bindings);
+		return true;
+	}
+
+	//-------------------------------------------------
+	// PSV0チャンクからリソースバインドを取得する
+	//-------------------------------------------------
+	bool DxbcContainer::GetBindingsFromPipelineState(std::vector<ShaderBindingDesc>& outBindings) const
+	{
+		outBindings.clear();
+
+		u32 size = 0;
+		const u8* p = FindChunk(kFourCCPipelineState, &size);
+		if (!p || size < 4)
+		{
+			return false;
+		}
+
+		// ランタイム情報は可変長なので読み飛ばす
+		u64 pos = 4 + static_cast<u64>(ReadU32(p));
+		if (pos + 4 > size)
+		{
+			return false;
+		}
+		u32 resourceCount = ReadU32(p + pos);
+		pos += 4;
+		if (resourceCount == 0)
+		{
+			return true;
+		}
+
+		if (pos + 4 > size)
+		{
+			return false;
+		}
+		u32 bindSize = ReadU32(p + pos);
+		pos += 4;
+		if (bindSize < kPsvBindSize || pos + static_cast<u64>(resourceCount) * bindSize > size)
+		{
+			return false;
+		}
+
+		std::vector<ShaderBindingDesc> bindings(resourceCount);
+		for (u32 i = 0; i < resourceCount; i++)
+		{
+			const u8* b = p + pos + static_cast<u64>(i) * bindSize;
+			auto&& desc = bindings[i];
+			u32 lowerBound = ReadU32(b + 8);
+			u32 upperBound = ReadU32(b + 12);
+			if (!ConvertPsvResourceType(ReadU32(b + 0), desc.inputType) || upperBound < lowerBound)
+			{
+				return false;
+			}
+			desc.space = ReadU32(b + 4);
+			desc.bindPoint = lowerBound;
+			desc.bindCount = (upperBound == kUnbounded) ? 0 : upperBound - lowerBound + 1;
+		}
+
+		outBindings.swap(bindings);
+		return true;
+	}
+
+	//-------------------------------------------------
+	// バイトコードからリソースバインドを取得する
+	//-------------------------------------------------
+	bool ReflectShaderBindings(const void* pData, size_t size, std::vector<ShaderBindingDesc>& outBindings, bool* pIsNative)
+	{
+		if (pIsNative)
+		{
+			*pIsNative = false;
+		}
+
+		DxbcContainer container;
+		if (container.Initialize(pData, size) && container.GetBindingsFromResourceDef(outBindings))
+		{
+			if (pIsNative)
+			{
+				*pIsNative = true;
+			}
+			return true;
+		}
+
+		// RDEFがない(DXIL)場合はD3DReflectを使用する
+		outBindings.clear();
+#if defined(_WIN32)
+		static_assert(kSitCBuffer == D3D_SIT_CBUFFER && kSitUavRWStructuredWithCounter == D3D_SIT_UAV_RWSTRUCTURED_WITH_COUNTER, "D3D_SHADER_INPUT_TYPE mismatch.");
+
+		ID3D12ShaderReflection* pReflection = nullptr;
+		auto hr = D3DReflect(pData, size, IID_PPV_ARGS(&pReflection));
+		if (FAILED(hr))
+		{
+			return false;
+		}
+
+		D3D12_SHADER_DESC sdesc;
+		hr = pReflection->GetDesc(&sdesc);
+		if (FAILED(hr))
+		{
+			pReflection->Release();
+			return false;
+		}
+
+		outBindings.resize(sdesc.BoundResources);
+		for (u32 i = 0; i < sdesc.BoundResources; i++)
+		{
+			D3D12_SHADER_INPUT_BIND_DESC bd;
+			pReflection->GetResourceBindingDesc(i, &bd);
+
+			auto&& desc = outBindings[i];
+			desc.name = bd.Name ? bd.Name : "";
+			desc.inputType = static_cast<u32>(bd.Type);
+			desc.bindPoint = bd.BindPoint;
+			desc.bindCount = (bd.BindCount == kUnbounded) ? 0 : bd.BindCount;
+			desc.space = bd.Space;
+			desc.dimension = static_cast<u32>(bd.Dimension);
+			if (bd.Type == D3D_SIT_CBUFFER)
+			{
+				D3D12_SHADER_BUFFER_DESC cbDesc;
+				auto pCB = pReflection->GetConstantBufferByName(bd.Name);
+				if (pCB && SUCCEEDED(pCB->GetDesc(&cbDesc)))
+				{
+					desc.constantBufferSize = cbDesc.Size;
+				}
+			}
+		}
+		pReflection->Release();
+		return true;
+#else
+		// D3DReflectはWindowsでのみ使用できる
+		return false;
+#endif
+	}
+
+}	// namespace sl12
+
+//	EOF
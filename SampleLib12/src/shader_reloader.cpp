@@ -0,0 +1,577 @@
+﻿#include <sl12/shader_reloader.h>
+
+#include <sl12/device.h>
+#include <sl12/shader_package.h>
+#include <cstdio>
+
+
+namespace sl12
+{
+	const u32 ShaderReloader::kDefaultSettleTimeMs;
+
+	//-------------------------------------------------
+	// 初期化
+	//-------------------------------------------------
+	bool ShaderReloader::Initialize(Device* pDev, RootSignatureManager* pRootSigMan, const char* watchDirectory, u32 settleTimeMs)
+	{
+		Destroy();
+
+		if (!pDev || !pRootSigMan || !watchDirectory)
+		{
+			return false;
+		}
+
+		pDevice_ = pDev;
+		pRootSigMan_ = pRootSigMan;
+		settleTime_ = std::chrono::milliseconds(settleTimeMs);
+		watchDirectory_ = watchDirectory;
+		while (!watchDirectory_.empty() && (watchDirectory_.back() == '/' || watchDirectory_.back() == '\\'))
+		{
+			watchDirectory_.pop_back();
+		}
+
+		// 監視を開始できなくてもRequestReload()による再構築は行える
+		if (!watcher_.Initialize(watchDirectory_.c_str()))
+		{
+			char text[512];
+			sprintf_s(text, "[sl12] ShaderReloader : cannot watch directory. (%s)\n", watchDirectory_.c_str());
+			OutputDebugStringA(text);
+		}
+		return true;
+	}
+
+	//-------------------------------------------------
+	// 破棄
+	//-------------------------------------------------
+	void ShaderReloader::Destroy()
+	{
+		Discard();
+		watcher_.Destroy();
+		graph_.Clear();
+		targets_.clear();
+		liveMap_.clear();
+		pendingFiles_.clear();
+		watchDirectory_.clear();
+		pDevice_ = nullptr;
+		pRootSigMan_ = nullptr;
+	}
+
+	//-------------------------------------------------
+	// シェーダを登録する
+	//-------------------------------------------------
+	bool ShaderReloader::RegisterShader(Shader* pShader, const char* filename, const std::vector<std::string>& includes)
+	{
+		if (!pShader || !filename || liveMap_.find(pShader) != liveMap_.end())
+		{
+			return false;
+		}
+		if (graph_.FindFile(filename) != ShaderDependencyGraph::kInvalidNode)
+		{
+			return false;
+		}
+
+		std::vector<NodeId> deps;
+		for (auto&& inc : includes)
+		{
+			NodeId incId = AddInclude(inc);
+			if (incId == ShaderDependencyGraph::kInvalidNode)
+			{
+				return false;
+			}
+			deps.push_back(incId);
+		}
+
+		NodeId id = graph_.AddFileNode(filename, deps);
+		if (id == ShaderDependencyGraph::kInvalidNode)
+		{
+			return false;
+		}
+
+		std::unique_ptr<Target> target(new Target());
+		target->type = TargetType::Shader;
+		target->pLive = pShader;
+		target->filename = filename;
+		targets_.push_back(std::move(target));
+		liveMap_[pShader] = id;
+		return true;
+	}
+
+	//-------------------------------------------------
+	// ルートシグネチャを登録する
+	//-------------------------------------------------
+	bool ShaderReloader::RegisterRootSignature(RootSignatureHandle* pHandle, const RootSignatureCreateDesc& desc)
+	{
+		if (!pHandle)
+		{
+			return false;
+		}
+
+		std::vector<NodeId> deps;
+		AddDependency(deps, desc.pVS);
+		AddDependency(deps, desc.pPS);
+		AddDependency(deps, desc.pGS);
+		AddDependency(deps, desc.pDS);
+		AddDependency(deps, desc.pHS);
+		AddDependency(deps, desc.pCS);
+
+		std::unique_ptr<Target> target(new Target());
+		target->type = TargetType::RootSignature;
+		target->pLive = pHandle;
+		target->rootSigDesc = desc;
+		return AddTarget(std::move(target), deps) != ShaderDependencyGraph::kInvalidNode;
+	}
+
+	//-------------------------------------------------
+	// パイプラインステートを登録する
+	//-------------------------------------------------
+	bool ShaderReloader::RegisterPipelineState(GraphicsPipelineState* pPSO, const GraphicsPipelineStateDesc& desc, RootSignatureHandle* pRootSig)
+	{
+		return pPSO && RegisterGraphics(TargetType::GraphicsPipeline, pPSO, nullptr, desc, pRootSig);
+	}
+
+	bool ShaderReloader::RegisterPipelineState(ComputePipelineState* pPSO, const ComputePipelineStateDesc& desc, RootSignatureHandle* pRootSig)
+	{
+		return pPSO && RegisterCompute(TargetType::ComputePipeline, pPSO, nullptr, desc, pRootSig);
+	}
+
+	bool ShaderReloader::RegisterPipelineState(PipelineStateHandle* pHandle, PipelineStateCache* pCache, const GraphicsPipelineStateDesc& desc, RootSignatureHandle* pRootSig)
+	{
+		return pHandle && pCache && RegisterGraphics(TargetType::GraphicsPipelineHandle, pHandle, pCache, desc, pRootSig);
+	}
+
+	bool ShaderReloader::RegisterPipelineState(PipelineStateHandle* pHandle, PipelineStateCache* pCache, const ComputePipelineStateDesc& desc, RootSignatureHandle* pRootSig)
+	{
+		return pHandle && pCache && RegisterCompute(TargetType::ComputePipelineHandle, pHandle, pCache, desc, pRootSig);
+	}
+
+	bool ShaderReloader::RegisterGraphics(TargetType::Type type, void* pLive, PipelineStateCache* pCache, const GraphicsPipelineStateDesc& desc, RootSignatureHandle* pRootSig)
+	{
+		std::vector<NodeId> deps;
+		AddDependency(deps, desc.pVS);
+		AddDependency(deps, desc.pPS);
+		AddDependency(deps, desc.pGS);
+		AddDependency(deps, desc.pDS);
+		AddDependency(deps, desc.pHS);
+		AddDependency(deps, pRootSig);
+
+		std::unique_ptr<Target> target(new Target());
+		target->type = type;
+		target->pLive = pLive;
+		target->pCache = pCache;
+		target->pRootSig = pRootSig;
+		target->graphicsDesc = desc;
+		target->graphicsDesc.cachedPSO = D3D12_CACHED_PIPELINE_STATE{};
+
+		// 入力レイアウトは呼び出し元のスタックを指していることがあるのでコピーする
+		target->elements.assign(desc.inputLayout.pElements, desc.inputLayout.pElements + desc.inputLayout.numElements);
+		target->semantics.reserve(target->elements.size());
+		for (auto&& e : target->elements)
+		{
+			target->semantics.push_back(e.SemanticName ? e.SemanticName : "");
+			e.SemanticName = target->semantics.back().c_str();
+		}
+		target->graphicsDesc.inputLayout.pElements = target->elements.data();
+		return AddTarget(std::move(target), deps) != ShaderDependencyGraph::kInvalidNode;
+	}
+
+	bool ShaderReloader::RegisterCompute(TargetType::Type type, void* pLive, PipelineStateCache* pCache, const ComputePipelineStateDesc& desc, RootSignatureHandle* pRootSig)
+	{
+		std::vector<NodeId> deps;
+		AddDependency(deps, desc.pCS);
+		AddDependency(deps, pRootSig);
+
+		std::unique_ptr<Target> target(new Target());
+		target->type = type;
+		target->pLive = pLive;
+		target->pCache = pCache;
+		target->pRootSig = pRootSig;
+		target->computeDesc = desc;
+		target->computeDesc.cachedPSO = D3D12_CACHED_PIPELINE_STATE{};
+		return AddTarget(std::move(target), deps) != ShaderDependencyGraph::kInvalidNode;
+	}
+
+	//-------------------------------------------------
+	// ファイルを変更されたものとして扱う
+	//-------------------------------------------------
+	void ShaderReloader::RequestReload(const char* filename)
+	{
+		if (graph_.FindFile(filename) != ShaderDependencyGraph::kInvalidNode)
+		{
+			// 待ち時間なしで次のUpdate()で処理する
+			pendingFiles_[ShaderDependencyGraph::NormalizePath(filename)] = Clock::now() - settleTime_;
+		}
+	}
+
+	//-------------------------------------------------
+	// 変更を監視し、依存するオブジェクトを再構築する
+	//-------------------------------------------------
+	bool ShaderReloader::Update()
+	{
+		auto now = Clock::now();
+
+		std::vector<std::string> files, removed;
+		watcher_.Poll(files, &removed);
+		if (watcher_.HasOverflowed())
+		{
+			// 取りこぼした変更があるので全てのシェーダを対象にする
+			for (NodeId id = 0; id < graph_.GetNodeCount(); id++)
+			{
+				if (graph_.IsFileNode(id))
+				{
+					pendingFiles_[graph_.GetFilename(id)] = now;
+				}
+			}
+		}
+		// 削除されたファイルも変更として扱い、待ち時間の経過後にファイルの有無で判断する
+		// 保存時に削除してから作り直すエディタがあるため
+		files.insert(files.end(), removed.begin(), removed.end());
+		for (auto&& file : files)
+		{
+			std::string path = watchDirectory_.empty() ? file : watchDirectory_ + "/" + file;
+			if (graph_.FindFile(path.c_str()) != ShaderDependencyGraph::kInvalidNode)
+			{
+				pendingFiles_[ShaderDependencyGraph::NormalizePath(path.c_str())] = now;
+			}
+		}
+
+		// 差し替え前の再構築結果があれば、Commit()かDiscard()されるまで次の再構築は行わない
+		if (HasPendingCommit())
+		{
+			return true;
+		}
+
+		// 書き込みが落ち着いたファイルのみ処理する
+		std::vector<NodeId> roots;
+		for (auto it = pendingFiles_.begin(); it != pendingFiles_.end(); )
+		{
+			if (now - it->second >= settleTime_)
+			{
+				ShaderSourceStamp stamp;
+				if (GetShaderSourceStamp(it->first.c_str(), stamp))
+				{
+					roots.push_back(graph_.FindFile(it->first.c_str()));
+				}
+				else
+				{
+					// 削除されたファイルは依存関係から外す. 依存していたオブジェクトは再構築しない
+					graph_.RemoveFile(it->first.c_str());
+
+					char text[512];
+					sprintf_s(text, "[sl12] ShaderReloader : file removed. stop tracking. (%s)\n", it->first.c_str());
+					OutputDebugStringA(text);
+				}
+				it = pendingFiles_.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+		if (roots.empty())
+		{
+			return false;
+		}
+
+		if (!graph_.Propagate(roots, [this](NodeId id) { return Rebuild(id); }))
+		{
+			// 1つでも失敗した場合は全て破棄して旧オブジェクトを使い続ける
+			Discard();
+			failedCount_++;
+			OutputDebugStringA("[sl12] ShaderReloader : rebuild failed. keep using the previous objects.\n");
+			return false;
+		}
+
+		if (HasPendingCommit())
+		{
+			char text[256];
+			sprintf_s(text, "[sl12] ShaderReloader : %u objects rebuilt.\n", static_cast<u32>(staged_.size()));
+			OutputDebugStringA(text);
+		}
+		return HasPendingCommit();
+	}
+
+	//-------------------------------------------------
+	// 再構築したオブジェクトに差し替える
+	//-------------------------------------------------
+	void ShaderReloader::Commit()
+	{
+		if (!HasPendingCommit())
+		{
+			return;
+		}
+
+		// 依存先から順に差し替える
+		for (auto id : staged_)
+		{
+			auto&& target = *targets_[id];
+			switch (target.type)
+			{
+			case TargetType::Shader:
+				*reinterpret_cast<sl12::Shader*>(target.pLive) = *target.stagedShader;
+				break;
+			case TargetType::RootSignature:
+				*reinterpret_cast<RootSignatureHandle*>(target.pLive) = target.stagedRootSig;
+				break;
+			case TargetType::GraphicsPipeline:
+				reinterpret_cast<GraphicsPipelineState*>(target.pLive)->Swap(*target.stagedGraphics);
+				break;
+			case TargetType::ComputePipeline:
+				reinterpret_cast<ComputePipelineState*>(target.pLive)->Swap(*target.stagedCompute);
+				break;
+			case TargetType::GraphicsPipelineHandle:
+			case TargetType::ComputePipelineHandle:
+				*reinterpret_cast<PipelineStateHandle*>(target.pLive) = target.stagedHandle;
+				break;
+			default:
+				break;
+			}
+		}
+
+		// 旧オブジェクトはここで解放される
+		Discard();
+		commitCount_++;
+	}
+
+	//-------------------------------------------------
+	// 再構築したオブジェクトを破棄する
+	//-------------------------------------------------
+	void ShaderReloader::Discard()
+	{
+		for (auto id : staged_)
+		{
+			ClearStaged(*targets_[id]);
+		}
+		staged_.clear();
+	}
+
+	//-------------------------------------------------
+	// ターゲットを追加する
+	//-------------------------------------------------
+	ShaderReloader::NodeId ShaderReloader::AddTarget(std::unique_ptr<Target>&& target, const std::vector<NodeId>& dependencies)
+	{
+		if (liveMap_.find(target->pLive) != liveMap_.end())
+		{
+			return ShaderDependencyGraph::kInvalidNode;
+		}
+
+		NodeId id = graph_.AddNode(dependencies);
+		if (id == ShaderDependencyGraph::kInvalidNode)
+		{
+			return id;
+		}
+		liveMap_[target->pLive] = id;
+		targets_.push_back(std::move(target));
+		return id;
+	}
+
+	//-------------------------------------------------
+	// インクルードファイルのノードを追加する
+	//-------------------------------------------------
+	ShaderReloader::NodeId ShaderReloader::AddInclude(const std::string& filename)
+	{
+		// 他のシェーダがインクルードしている、またはシェーダとして登録済みのファイルはそのノードを使う
+		NodeId id = graph_.FindFile(filename.c_str());
+		if (id != ShaderDependencyGraph::kInvalidNode)
+		{
+			return id;
+		}
+
+		id = graph_.AddFileNode(filename.c_str());
+		if (id == ShaderDependencyGraph::kInvalidNode)
+		{
+			return id;
+		}
+
+		std::unique_ptr<Target> target(new Target());
+		target->type = TargetType::Include;
+		target->filename = filename;
+		targets_.push_back(std::move(target));
+		return id;
+	}
+
+	//-------------------------------------------------
+	// 登録済みのオブジェクトであれば依存先に追加する
+	//-------------------------------------------------
+	void ShaderReloader::AddDependency(std::vector<NodeId>& deps, const void* pLive) const
+	{
+		if (!pLive)
+		{
+			return;
+		}
+		auto it = liveMap_.find(pLive);
+		if (it != liveMap_.end())
+		{
+			deps.push_back(it->second);
+		}
+	}
+
+	//-------------------------------------------------
+	// ノードを再構築する
+	//-------------------------------------------------
+	RebuildResult::Type ShaderReloader::Rebuild(NodeId id)
+	{
+		auto&& target = *targets_[id];
+		char text[512];
+
+		switch (target.type)
+		{
+		case TargetType::Shader:
+			{
+				auto pLive = reinterpret_cast<sl12::Shader*>(target.pLive);
+				std::unique_ptr<sl12::Shader> shader(new sl12::Shader());
+				if (!shader->Initialize(pDevice_, pLive->GetShaderType(), target.filename.c_str()))
+				{
+					sprintf_s(text, "[sl12] ShaderReloader : cannot load shader. (%s)\n", target.filename.c_str());
+					OutputDebugStringA(text);
+					return RebuildResult::Failed;
+				}
+				// タイムスタンプのみの変更等でバイトコードが同じなら依存先は作り直さない
+				if (shader->GetHash() == pLive->GetHash())
+				{
+					return RebuildResult::Unchanged;
+				}
+				target.stagedShader = std::move(shader);
+			}
+			break;
+		case TargetType::Include:
+			// インクルードファイル自体は読み込まないので、インクルードするシェーダを必ず再読み込みする
+			return RebuildResult::Changed;
+		case TargetType::RootSignature:
+			{
+				auto pLive = reinterpret_cast<RootSignatureHandle*>(target.pLive);
+				RootSignatureCreateDesc desc = target.rootSigDesc;
+				desc.pVS = ResolveShader(desc.pVS);
+				desc.pPS = ResolveShader(desc.pPS);
+				desc.pGS = ResolveShader(desc.pGS);
+				desc.pDS = ResolveShader(desc.pDS);
+				desc.pHS = ResolveShader(desc.pHS);
+				desc.pCS = ResolveShader(desc.pCS);
+				target.stagedRootSig = pRootSigMan_->CreateRootSignature(desc);
+				if (!target.stagedRootSig.IsValid())
+				{
+					OutputDebugStringA("[sl12] ShaderReloader : cannot create root signature.\n");
+					return RebuildResult::Failed;
+				}
+				// シリアライズ結果が同じならPSOは作り直さない
+				if (pLive->IsValid() && target.stagedRootSig.GetRootSignature()->GetHash() == pLive->GetRootSignature()->GetHash())
+				{
+					target.stagedRootSig.Invalid();
+					return RebuildResult::Unchanged;
+				}
+			}
+			break;
+		case TargetType::GraphicsPipeline:
+		case TargetType::GraphicsPipelineHandle:
+			{
+				GraphicsPipelineStateDesc desc = target.graphicsDesc;
+				desc.pRootSignature = ResolveRootSignature(target, desc.pRootSignature);
+				desc.pVS = ResolveShader(desc.pVS);
+				desc.pPS = ResolveShader(desc.pPS);
+				desc.pGS = ResolveShader(desc.pGS);
+				desc.pDS = ResolveShader(desc.pDS);
+				desc.pHS = ResolveShader(desc.pHS);
+				if (target.type == TargetType::GraphicsPipeline)
+				{
+					std::unique_ptr<GraphicsPipelineState> pso(new GraphicsPipelineState());
+					if (!pso->Initialize(pDevice_, desc))
+					{
+						OutputDebugStringA("[sl12] ShaderReloader : cannot create graphics pipeline state.\n");
+						return RebuildResult::Failed;
+					}
+					target.stagedGraphics = std::move(pso);
+				}
+				else
+				{
+					target.stagedHandle = target.pCache->CreateGraphics(desc);
+					if (!target.stagedHandle.IsValid())
+					{
+						OutputDebugStringA("[sl12] ShaderReloader : cannot create graphics pipeline state.\n");
+						return RebuildResult::Failed;
+					}
+				}
+			}
+			break;
+		case TargetType::ComputePipeline:
+		case TargetType::ComputePipelineHandle:
+			{
+				ComputePipelineStateDesc desc = target.computeDesc;
+				desc.pRootSignature = ResolveRootSignature(target, desc.pRootSignature);
+				desc.pCS = ResolveShader(desc.pCS);
+				if (target.type == TargetType::ComputePipeline)
+				{
+					std::unique_ptr<ComputePipelineState> pso(new ComputePipelineState());
+					if (!pso->Initialize(pDevice_, desc))
+					{
+						OutputDebugStringA("[sl12] ShaderReloader : cannot create compute pipeline state.\n");
+						return RebuildResult::Failed;
+					}
+					target.stagedCompute = std::move(pso);
+				}
+				else
+				{
+					target.stagedHandle = target.pCache->CreateCompute(desc);
+					if (!target.stagedHandle.IsValid())
+					{
+						OutputDebugStringA("[sl12] ShaderReloader : cannot create compute pipeline state.\n");
+						return RebuildResult::Failed;
+					}
+				}
+			}
+			break;
+		default:
+			return RebuildResult::Failed;
+		}
+
+		staged_.push_back(id);
+		return RebuildResult::Changed;
+	}
+
+	//-------------------------------------------------
+	// 再構築済みであれば再構築したシェーダを返す
+	//-------------------------------------------------
+	sl12::Shader* ShaderReloader::ResolveShader(sl12::Shader* pShader) const
+	{
+		if (!pShader)
+		{
+			return nullptr;
+		}
+		auto it = liveMap_.find(pShader);
+		if (it != liveMap_.end() && targets_[it->second]->stagedShader)
+		{
+			return targets_[it->second]->stagedShader.get();
+		}
+		return pShader;
+	}
+
+	//-------------------------------------------------
+	// PSOが使用するルートシグネチャを返す
+	//-------------------------------------------------
+	RootSignature* ShaderReloader::ResolveRootSignature(const Target& target, RootSignature* pDefault)
+	{
+		if (!target.pRootSig)
+		{
+			return pDefault;
+		}
+		auto it = liveMap_.find(target.pRootSig);
+		if (it != liveMap_.end() && targets_[it->second]->stagedRootSig.IsValid())
+		{
+			return targets_[it->second]->stagedRootSig.GetRootSignature();
+		}
+		return target.pRootSig->GetRootSignature();
+	}
+
+	//-------------------------------------------------
+	// 再構築したオブジェクトを解放する
+	//-------------------------------------------------
+	void ShaderReloader::ClearStaged(Target& target)
+	{
+		target.stagedShader.reset();
+		target.stagedRootSig.Invalid();
+		target.stagedGraphics.reset();
+		target.stagedCompute.reset();
+		target.stagedHandle.Invalid();
+	}
+
+}	// namespace sl12
+
+//	EOF
@@ -0,0 +1,375 @@
+﻿#include <sl12/shader_table.h>
+
+#include <sl12/device.h>
+#include <sl12/buffer.h>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+
+namespace sl12
+{
+	namespace
+	{
+		u64 AlignSize(u64 size, u64 align)
+		{
+			return ((size + align - 1) / align) * align;
+		}
+
+		const char* kKindNames[] = {
+			"RayGeneration",
+			"Miss",
+			"HitGroup",
+			"Callable",
+		};
+	}
+
+	const u32 ShaderTable::kInvalidIndex;
+
+	//-------------------------------------------------
+	// レコードを追加する
+	//-------------------------------------------------
+	u32 ShaderTable::AddRecord(ShaderTableKind::Type kind, u32 localArgSize)
+	{
+		if (isBuilt_ || kind >= ShaderTableKind::Max)
+		{
+			return kInvalidIndex;
+		}
+
+		auto&& table = tables_[kind];
+		table.localArgSizes.push_back(localArgSize);
+		return static_cast<u32>(table.localArgSizes.size() - 1);
+	}
+
+	//-------------------------------------------------
+	// レイアウトを確定する
+	//-------------------------------------------------
+	bool ShaderTable::Build()
+	{
+		if (isBuilt_)
+		{
+			return false;
+		}
+
+		u64 offset = 0;
+		for (int kind = 0; kind < ShaderTableKind::Max; kind++)
+		{
+			auto&& table = tables_[kind];
+
+			// シェーダIDの直後からローカルルート引数を配置する
+			// シェーダIDのサイズは8バイトの倍数なので、ディスクリプタハンドルやGPUアドレスもそのまま配置できる
+			u32 maxArgSize = 0;
+			for (auto size : table.localArgSizes)
+			{
+				maxArgSize = (maxArgSize > size) ? maxArgSize : size;
+			}
+			u64 recordAlign = (kind == ShaderTableKind::RayGeneration) ? D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT : D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT;
+			u64 stride = AlignSize(D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + maxArgSize, recordAlign);
+			if (stride > D3D12_RAYTRACING_MAX_SHADER_RECORD_STRIDE)
+			{
+				char str[256];
+				sprintf_s(str, "[sl12] ShaderTable : %s record is too large. (%u bytes)\n", kKindNames[kind], static_cast<u32>(stride));
+				OutputDebugStringA(str);
+				return false;
+			}
+
+			// 空のテーブルは使用しないので末尾にパディングを追加しない
+			if (!table.localArgSizes.empty())
+			{
+				offset = AlignSize(offset, D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT);
+			}
+			table.stride = static_cast<u32>(stride);
+			table.offset = offset;
+			table.size = stride * table.localArgSizes.size();
+			table.dirty.assign(table.localArgSizes.size(), 1);
+			offset += table.size;
+		}
+
+		image_.assign(static_cast<size_t>(offset), 0);
+		pWrittenDst_ = nullptr;
+		dirtyCount_ = 0;
+		for (auto&& table : tables_)
+		{
+			dirtyCount_ += static_cast<u32>(table.dirty.size());
+		}
+		isBuilt_ = true;
+		return true;
+	}
+
+	//-------------------------------------------------
+	// 破棄
+	//-------------------------------------------------
+	void ShaderTable::Destroy()
+	{
+		for (auto&& table : tables_)
+		{
+			table = Table();
+		}
+		image_.clear();
+		dirtyCount_ = 0;
+		pWrittenDst_ = nullptr;
+		isBuilt_ = false;
+	}
+
+	//-------------------------------------------------
+	// シェーダIDを設定する
+	//-------------------------------------------------
+	bool ShaderTable::SetShaderIdentifier(ShaderTableKind::Type kind, u32 index, const void* pIdentifier)
+	{
+		if (!IsValidRecord(kind, index) || !pIdentifier)
+		{
+			return false;
+		}
+
+		u8* p = image_.data() + GetRecordOffset(kind, index);
+		if (memcmp(p, pIdentifier, D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES) != 0)
+		{
+			memcpy(p, pIdentifier, D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES);
+			SetDirty(tables_[kind], index);
+		}
+		return true;
+	}
+
+	//-------------------------------------------------
+	// ローカルルート引数を設定する
+	//-------------------------------------------------
+	bool ShaderTable::SetLocalArguments(ShaderTableKind::Type kind, u32 index, const void* pData, u32 size, u32 offset)
+	{
+		if (!IsValidRecord(kind, index) || !pData)
+		{
+			return false;
+		}
+
+		auto&& table = tables_[kind];
+		if (static_cast<u64>(offset) + size > table.localArgSizes[index])
+		{
+			char str[256];
+			sprintf_s(str, "[sl12] ShaderTable : local arguments overflow. (%s[%u], offset %u, size %u, capacity %u)\n", kKindNames[kind], index, offset, size, table.localArgSizes[index]);
+			OutputDebugStringA(str);
+			return false;
+		}
+
+		u8* p = image_.data() + GetRecordOffset(kind, index) + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + offset;
+		if (memcmp(p, pData, size) != 0)
+		{
+			memcpy(p, pData, size);
+			SetDirty(table, index);
+		}
+		return true;
+	}
+
+	//-------------------------------------------------
+	// レコードをダーティにする
+	//-------------------------------------------------
+	void ShaderTable::MarkDirty(ShaderTableKind::Type kind, u32 index)
+	{
+		if (IsValidRecord(kind, index))
+		{
+			SetDirty(tables_[kind], index);
+		}
+	}
+	void ShaderTable::MarkAllDirty()
+	{
+		dirtyCount_ = 0;
+		for (auto&& table : tables_)
+		{
+			table.dirty.assign(table.dirty.size(), 1);
+			dirtyCount_ += static_cast<u32>(table.dirty.size());
+		}
+	}
+
+	//-------------------------------------------------
+	// 全体を書き込む
+	//-------------------------------------------------
+	void ShaderTable::WriteAll(void* pDst)
+	{
+		if (!isBuilt_ || !pDst)
+		{
+			return;
+		}
+
+		CopyAll(reinterpret_cast<u8*>(pDst));
+		pWrittenDst_ = pDst;
+	}
+
+	//-------------------------------------------------
+	// ダーティなレコードのみを書き込む
+	//-------------------------------------------------
+	u32 ShaderTable::WriteDirty(void* pDst)
+	{
+		if (!isBuilt_ || !pDst || dirtyCount_ == 0)
+		{
+			return 0;
+		}
+
+		// ダーティでないレコードは書き込み先に残っている内容を使うので、全体を書き込んだ書き込み先でなければならない
+		assert(pDst == pWrittenDst_);
+		return CopyDirty(reinterpret_cast<u8*>(pDst), pDst);
+	}
+
+	//-------------------------------------------------
+	// アップロードバッファを生成して全体を書き込む
+	//-------------------------------------------------
+	bool ShaderTable::CreateBuffer(Device* pDev, Buffer& buffer)
+	{
+		if (!isBuilt_ || image_.empty())
+		{
+			return false;
+		}
+
+		if (!buffer.Initialize(pDev, image_.size(), 0, BufferUsage::ShaderResource, D3D12_RESOURCE_STATE_GENERIC_READ, true, false))
+		{
+			return false;
+		}
+
+		void* p = buffer.Map(nullptr);
+		if (!p)
+		{
+			return false;
+		}
+		CopyAll(reinterpret_cast<u8*>(p));
+		pWrittenDst_ = &buffer;
+		buffer.Unmap();
+		return true;
+	}
+
+	//-------------------------------------------------
+	// ダーティなレコードのみをバッファに書き込む
+	//-------------------------------------------------
+	u32 ShaderTable::UploadDirty(Buffer& buffer)
+	{
+		if (!isBuilt_ || dirtyCount_ == 0 || buffer.GetSize() < image_.size())
+		{
+			return 0;
+		}
+
+		// マップしたアドレスは呼び出しごとに変わりうるので、バッファで書き込み先を識別する
+		assert(&buffer == pWrittenDst_);
+		void* p = buffer.Map(nullptr);
+		if (!p)
+		{
+			return 0;
+		}
+		u32 ret = CopyDirty(reinterpret_cast<u8*>(p), &buffer);
+		buffer.Unmap();
+		return ret;
+	}
+
+	//-------------------------------------------------
+	// DispatchRaysの記述子にテーブルを設定する
+	//-------------------------------------------------
+	void ShaderTable::FillDispatchRaysDesc(D3D12_GPU_VIRTUAL_ADDRESS baseAddress, D3D12_DISPATCH_RAYS_DESC& desc, u32 rayGenIndex) const
+	{
+		auto SetTable = [&](ShaderTableKind::Type kind, D3D12_GPU_VIRTUAL_ADDRESS_RANGE_AND_STRIDE& range)
+		{
+			auto&& table = tables_[kind];
+			range.StartAddress = (table.size > 0) ? baseAddress + table.offset : 0;
+			range.SizeInBytes = table.size;
+			range.StrideInBytes = table.stride;
+		};
+
+		auto&& rayGen = tables_[ShaderTableKind::RayGeneration];
+		if (rayGenIndex < rayGen.localArgSizes.size())
+		{
+			desc.RayGenerationShaderRecord.StartAddress = baseAddress + GetRecordOffset(ShaderTableKind::RayGeneration, rayGenIndex);
+			desc.RayGenerationShaderRecord.SizeInBytes = rayGen.stride;
+		}
+		else
+		{
+			desc.RayGenerationShaderRecord.StartAddress = 0;
+			desc.RayGenerationShaderRecord.SizeInBytes = 0;
+		}
+		SetTable(ShaderTableKind::Miss, desc.MissShaderTable);
+		SetTable(ShaderTableKind::HitGroup, desc.HitGroupTable);
+		SetTable(ShaderTableKind::Callable, desc.CallableShaderTable);
+	}
+
+	//-------------------------------------------------
+	// レコードが有効か調べる
+	//-------------------------------------------------
+	bool ShaderTable::IsValidRecord(ShaderTableKind::Type kind, u32 index) const
+	{
+		if (!isBuilt_ || kind >= ShaderTableKind::Max)
+		{
+			return false;
+		}
+		return index < tables_[kind].localArgSizes.size();
+	}
+
+	//-------------------------------------------------
+	// ダーティフラグを立てる
+	//-------------------------------------------------
+	void ShaderTable::SetDirty(Table& table, u32 index)
+	{
+		if (!table.dirty[index])
+		{
+			table.dirty[index] = 1;
+			dirtyCount_++;
+		}
+	}
+
+	//-------------------------------------------------
+	// 全体をコピーしてダーティフラグをクリアする
+	//-------------------------------------------------
+	void ShaderTable::CopyAll(u8* pDst)
+	{
+		memcpy(pDst, image_.data(), image_.size());
+		for (auto&& table : tables_)
+		{
+			table.dirty.assign(table.dirty.size(), 0);
+		}
+		dirtyCount_ = 0;
+	}
+
+	//-------------------------------------------------
+	// ダーティなレコードのみをコピーする
+	//-------------------------------------------------
+	u32 ShaderTable::CopyDirty(u8* pDst, const void* pDstKey)
+	{
+		if (pDstKey != pWrittenDst_)
+		{
+			// 全体を書き込んでいない書き込み先では、ダーティでないレコードの内容が不定になる
+			OutputDebugStringA("[sl12] ShaderTable : dirty-only write to a destination that does not hold the whole table, writing all records.\n");
+			u32 count = 0;
+			for (auto&& table : tables_)
+			{
+				count += static_cast<u32>(table.dirty.size());
+			}
+			CopyAll(pDst);
+			pWrittenDst_ = pDstKey;
+			return count;
+		}
+
+		// 連続したダーティなレコードはまとめて書き込む
+		u32 count = 0;
+		for (auto&& table : tables_)
+		{
+			u32 num = static_cast<u32>(table.dirty.size());
+			u32 i = 0;
+			while (i < num)
+			{
+				if (!table.dirty[i])
+				{
+					i++;
+					continue;
+				}
+
+				u32 first = i;
+				while (i < num && table.dirty[i])
+				{
+					table.dirty[i] = 0;
+					i++;
+				}
+				u64 offset = table.offset + static_cast<u64>(table.stride) * first;
+				u64 size = static_cast<u64>(table.stride) * (i - first);
+				memcpy(pDst + offset, image_.data() + offset, static_cast<size_t>(size));
+				count += i - first;
+			}
+		}
+		dirtyCount_ = 0;
+		return count;
+	}
+
+}	// namespace sl12
+
+//	EOF
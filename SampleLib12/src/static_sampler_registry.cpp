@@ -0,0 +1,84 @@
+﻿#include <sl12/static_sampler_registry.h>
+
+#include <sl12/crc.h>
+#include <algorithm>
+
+
+namespace sl12
+{
+	//----
+	bool StaticSamplerRegistry::Register(const char* name, const D3D12_SAMPLER_DESC& desc)
+	{
+		// 静的サンプラは境界色を列挙値でしか指定できない
+		const float* c = desc.BorderColor;
+		D3D12_STATIC_BORDER_COLOR borderColor;
+		if (c[0] == 0.0f && c[1] == 0.0f && c[2] == 0.0f && c[3] == 0.0f)
+			borderColor = D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK;
+		else if (c[0] == 0.0f && c[1] == 0.0f && c[2] == 0.0f && c[3] == 1.0f)
+			borderColor = D3D12_STATIC_BORDER_COLOR_OPAQUE_BLACK;
+		else if (c[0] == 1.0f && c[1] == 1.0f && c[2] == 1.0f && c[3] == 1.0f)
+			borderColor = D3D12_STATIC_BORDER_COLOR_OPAQUE_WHITE;
+		else
+			return false;
+
+		Entry entry{};
+		entry.nameHash = CalcFnv1a32(name);
+		entry.desc.Filter = desc.Filter;
+		entry.desc.AddressU = desc.AddressU;
+		entry.desc.AddressV = desc.AddressV;
+		entry.desc.AddressW = desc.AddressW;
+		entry.desc.MipLODBias = desc.MipLODBias;
+		entry.desc.MaxAnisotropy = desc.MaxAnisotropy;
+		entry.desc.ComparisonFunc = desc.ComparisonFunc;
+		entry.desc.BorderColor = borderColor;
+		entry.desc.MinLOD = desc.MinLOD;
+		entry.desc.MaxLOD = desc.MaxLOD;
+
+		auto it = std::lower_bound(entries_.begin(), entries_.end(), entry.nameHash, [](const Entry& e, u32 h) { return e.nameHash < h; });
+		if (it != entries_.end() && it->nameHash == entry.nameHash)
+			*it = entry;
+		else
+			entries_.insert(it, entry);
+
+		// 登録内容が変わればルートシグネチャも変わるので、全体のハッシュ値を更新する
+		hash_ = CalcCrc32(entries_.data(), sizeof(Entry) * entries_.size());
+		return true;
+	}
+
+	//----
+	void StaticSamplerRegistry::RegisterDefaults()
+	{
+		D3D12_SAMPLER_DESC desc{};
+		desc.Filter = D3D12_FILTER_MIN_MAG_MIP_POINT;
+		desc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+		desc.AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+		desc.AddressW = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+		Register("samPointWrap", desc);
+
+		desc.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+		Register("samLinearWrap", desc);
+
+		desc.Filter = D3D12_FILTER_MIN_MAG_MIP_POINT;
+		desc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+		desc.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+		desc.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+		Register("samPointClamp", desc);
+
+		desc.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+		Register("samLinearClamp", desc);
+	}
+
+	//----
+	const D3D12_STATIC_SAMPLER_DESC* StaticSamplerRegistry::Find(u32 nameHash) const
+	{
+		auto it = std::lower_bound(entries_.begin(), entries_.end(), nameHash, [](const Entry& e, u32 h) { return e.nameHash < h; });
+		if (it != entries_.end() && it->nameHash == nameHash)
+		{
+			return &it->desc;
+		}
+		return nullptr;
+	}
+
+}	// namespace sl12
+
+//	EOF
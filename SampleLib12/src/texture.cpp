@@ -2,8 +2,9 @@
 
 #include <sl12/device.h>
 #include <sl12/command_list.h>
-#include <sl12/fence.h>
+#include <sl12/upload_ring.h>
 #include <sl12/swapchain.h>
+#include <sl12/descriptor_view_cache.h>
 
 
 namespace sl12
@@ -89,6 +90,7 @@ namespace sl12
 		}
 
 		textureDesc_ = desc;
+		resourceId_ = IssueResourceId();
 
 		return true;
 	}
@@ -160,6 +162,7 @@ namespace sl12
 		}
 
 		// 情報を格納
+		resourceId_ = IssueResourceId();
 		resourceDesc_ = desc;
 		currentState_ = D3D12_RESOURCE_STATE_COPY_DEST;
 		memset(&textureDesc_, 0, sizeof(textureDesc_));
@@ -207,22 +210,18 @@ namespace sl12
 		}
 
 		// コピー命令発行
-		ID3D12Resource* pSrcImage = nullptr;
+		UploadRing& ring = pDev->GetUploadRing();
 		pCmdList->Reset();
-		if (!UpdateImage(pDev, pCmdList, image, &pSrcImage))
+		if (!UpdateImage(ring, pCmdList, image))
 		{
+			pCmdList->Close();
 			return false;
 		}
 		pCmdList->Close();
 		pCmdList->Execute();
 
-		Fence fence;
-		fence.Initialize(pDev);
-		fence.Signal(pCmdList->GetParentQueue());
-		fence.WaitSignal();
-
-		fence.Destroy();
-		SafeRelease(pSrcImage);
+		ring.Submit(pCmdList->GetParentQueue());
+		ring.WaitIdle();
 
 		return true;
 	}
@@ -246,22 +245,18 @@ namespace sl12
 		}
 
 		// コピー命令発行
-		ID3D12Resource* pSrcImage = nullptr;
+		UploadRing& ring = pDev->GetUploadRing();
 		pCmdList->Reset();
-		if (!UpdateImage(pDev, pCmdList, pImageBin, &pSrcImage))
+		if (!UpdateImage(ring, pCmdList, pImageBin))
 		{
+			pCmdList->Close();
 			return false;
 		}
 		pCmdList->Close();
 		pCmdList->Execute();
 
-		Fence fence;
-		fence.Initialize(pDev);
-		fence.Signal(pCmdList->GetParentQueue());
-		fence.WaitSignal();
-
-		fence.Destroy();
-		SafeRelease(pSrcImage);
+		ring.Submit(pCmdList->GetParentQueue());
+		ring.WaitIdle();
 
 		return true;
 	}
@@ -284,6 +279,7 @@ namespace sl12
 			return false;
 		}
 
+		resourceId_ = IssueResourceId();
 		resourceDesc_ = pResource_->GetDesc();
 
 		memset(&textureDesc_, 0, sizeof(textureDesc_));
@@ -302,185 +298,63 @@ namespace sl12
 	}
 
 	//----
-	bool Texture::UpdateImage(Device* pDev, CommandList* pCmdList, const DirectX::ScratchImage& image, ID3D12Resource** ppSrcImage)
+	bool Texture::UpdateImage(UploadRing& ring, CommandList* pCmdList, const DirectX::ScratchImage& image)
 	{
 		const DirectX::TexMetadata& meta = image.GetMetadata();
 
-		// リソースのサイズ等を取得
+		// サブリソースごとの元データを設定
 		u32 numSubresources = static_cast<u32>(meta.arraySize * meta.mipLevels);
-		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprint(numSubresources);
-		std::vector<u32> numRows(numSubresources);
-		std::vector<u64> rowSize(numSubresources);
-		u64 totalSize;
-		pDev->GetDeviceDep()->GetCopyableFootprints(&resourceDesc_, 0, numSubresources, 0, footprint.data(), numRows.data(), rowSize.data(), &totalSize);
-
-		// アップロード用のオブジェクトを作成
-		D3D12_HEAP_PROPERTIES heapProp = {};
-		heapProp.Type = D3D12_HEAP_TYPE_UPLOAD;
-		heapProp.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-		heapProp.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-		heapProp.CreationNodeMask = 1;
-		heapProp.VisibleNodeMask = 1;
-
-		D3D12_RESOURCE_DESC desc = {};
-		desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-		desc.Alignment = 0;
-		desc.Width = totalSize;
-		desc.Height = 1;
-		desc.DepthOrArraySize = 1;
-		desc.MipLevels = 1;
-		desc.Format = DXGI_FORMAT_UNKNOWN;
-		desc.SampleDesc.Count = 1;
-		desc.SampleDesc.Quality = 0;
-		desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-		desc.Flags = D3D12_RESOURCE_FLAG_NONE;
-
-		ID3D12Resource* pSrcImage{ nullptr };
-		auto hr = pDev->GetDeviceDep()->CreateCommittedResource(
-			&heapProp,
-			D3D12_HEAP_FLAG_NONE,
-			&desc,
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&pSrcImage));
-		if (FAILED(hr))
-		{
-			return false;
-		}
-
-		// リソースをマップしてイメージ情報をコピー
-		u8* pData{ nullptr };
-		hr = pSrcImage->Map(0, NULL, reinterpret_cast<void**>(&pData));
-		if (FAILED(hr))
-		{
-			SafeRelease(pSrcImage);
-			return false;
-		}
-
+		std::vector<D3D12_SUBRESOURCE_DATA> srcData(numSubresources);
 		for (u32 d = 0; d < meta.arraySize; d++)
 		{
 			for (u32 m = 0; m < meta.mipLevels; m++)
 			{
 				size_t i = d * meta.mipLevels + m;
-				if (rowSize[i] >(SIZE_T) -1)
+				const DirectX::Image* pImage = image.GetImage(m, 0, d);
+				if (!pImage)
 				{
-					SafeRelease(pSrcImage);
 					return false;
 				}
-				D3D12_MEMCPY_DEST dstData = { pData + footprint[i].Offset, footprint[i].Footprint.RowPitch, footprint[i].Footprint.RowPitch * numRows[i] };
-				const DirectX::Image* pImage = image.GetImage(m, 0, d);
-				memcpy(dstData.pData, pImage->pixels, pImage->rowPitch * pImage->height);
+				srcData[i].pData = pImage->pixels;
+				srcData[i].RowPitch = static_cast<LONG_PTR>(pImage->rowPitch);
+				srcData[i].SlicePitch = static_cast<LONG_PTR>(pImage->slicePitch);
 			}
 		}
 
-		pSrcImage->Unmap(0, nullptr);
-
-		// コピー命令を発行
-		for (u32 i = 0; i < numSubresources; i++)
-		{
-			D3D12_TEXTURE_COPY_LOCATION src, dst;
-			src.pResource = pSrcImage;
-			src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-			src.PlacedFootprint = footprint[i];
-			dst.pResource = pResource_;
-			dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-			dst.SubresourceIndex = i;
-			pCmdList->GetCommandList()->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
-		}
-
-		*ppSrcImage = pSrcImage;
-
-		return true;
+		return ring.CopyToTexture(pCmdList, pResource_, 0, numSubresources, srcData.data());
 	}
 
 	//----
-	bool Texture::UpdateImage(Device* pDev, CommandList* pCmdList, const void* pImageBin, ID3D12Resource** ppSrcImage)
+	bool Texture::UpdateImage(UploadRing& ring, CommandList* pCmdList, const void* pImageBin)
 	{
-		// リソースのサイズ等を取得
-		u32 numSubresources = resourceDesc_.DepthOrArraySize * resourceDesc_.MipLevels;
-		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprint(numSubresources);
-		std::vector<u32> numRows(numSubresources);
-		std::vector<u64> rowSize(numSubresources);
-		u64 totalSize;
-		pDev->GetDeviceDep()->GetCopyableFootprints(&resourceDesc_, 0, numSubresources, 0, footprint.data(), numRows.data(), rowSize.data(), &totalSize);
-
-		// アップロード用のオブジェクトを作成
-		D3D12_HEAP_PROPERTIES heapProp = {};
-		heapProp.Type = D3D12_HEAP_TYPE_UPLOAD;
-		heapProp.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-		heapProp.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-		heapProp.CreationNodeMask = 1;
-		heapProp.VisibleNodeMask = 1;
-
-		D3D12_RESOURCE_DESC desc = {};
-		desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-		desc.Alignment = 0;
-		desc.Width = totalSize;
-		desc.Height = 1;
-		desc.DepthOrArraySize = 1;
-		desc.MipLevels = 1;
-		desc.Format = DXGI_FORMAT_UNKNOWN;
-		desc.SampleDesc.Count = 1;
-		desc.SampleDesc.Quality = 0;
-		desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-		desc.Flags = D3D12_RESOURCE_FLAG_NONE;
-
-		ID3D12Resource* pSrcImage{ nullptr };
-		auto hr = pDev->GetDeviceDep()->CreateCommittedResource(
-			&heapProp,
-			D3D12_HEAP_FLAG_NONE,
-			&desc,
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&pSrcImage));
-		if (FAILED(hr))
+		if (!pImageBin)
 		{
 			return false;
 		}
 
-		// リソースをマップしてイメージ情報をコピー
-		u8* pData{ nullptr };
-		hr = pSrcImage->Map(0, NULL, reinterpret_cast<void**>(&pData));
-		if (FAILED(hr))
+		// 元データの行ピッチはフットプリントと同じ
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+		u32 numRows;
+		u64 rowSize, totalSize;
+		if (!ring.GetDevice())
 		{
-			SafeRelease(pSrcImage);
 			return false;
 		}
+		ring.GetDevice()->GetDeviceDep()->GetCopyableFootprints(&resourceDesc_, 0, 1, 0, &footprint, &numRows, &rowSize, &totalSize);
 
-		{
-			if (rowSize[0] >(SIZE_T) -1)
-			{
-				SafeRelease(pSrcImage);
-				return false;
-			}
-			D3D12_MEMCPY_DEST dstData = { pData + footprint[0].Offset, footprint[0].Footprint.RowPitch, footprint[0].Footprint.RowPitch * numRows[0] };
-			memcpy(dstData.pData, pImageBin, footprint[0].Footprint.RowPitch * footprint[0].Footprint.Height);
-		}
-
-		pSrcImage->Unmap(0, nullptr);
-
-		// コピー命令を発行
-		for (u32 i = 0; i < numSubresources; i++)
-		{
-			D3D12_TEXTURE_COPY_LOCATION src, dst;
-			src.pResource = pSrcImage;
-			src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-			src.PlacedFootprint = footprint[i];
-			dst.pResource = pResource_;
-			dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-			dst.SubresourceIndex = i;
-			pCmdList->GetCommandList()->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
-		}
-
-		*ppSrcImage = pSrcImage;
+		D3D12_SUBRESOURCE_DATA srcData;
+		srcData.pData = pImageBin;
+		srcData.RowPitch = footprint.Footprint.RowPitch;
+		srcData.SlicePitch = static_cast<LONG_PTR>(footprint.Footprint.RowPitch) * numRows;
 
-		return true;
+		return ring.CopyToTexture(pCmdList, pResource_, 0, 1, &srcData);
 	}
 
 	//----
 	void Texture::Destroy()
 	{
 		SafeRelease(pResource_);
+		resourceId_ = 0;
 	}
 
 }	// namespace sl12
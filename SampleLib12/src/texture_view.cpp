@@ -5,6 +5,8 @@
 #include <sl12/buffer.h>
 #include <sl12/descriptor.h>
 #include <sl12/descriptor_heap.h>
+#include <sl12/descriptor_view_cache.h>
+#include <sl12/bindless_descriptor_table.h>
 
 
 namespace sl12
@@ -110,13 +112,23 @@ namespace sl12
 			viewDesc.Texture3D.ResourceMinLODClamp = 0.0f;
 		}
 
-		pDesc_ = pDev->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).CreateDescriptor();
+		auto createFunc = [&](D3D12_CPU_DESCRIPTOR_HANDLE handle)
+		{
+			pDev->GetDeviceDep()->CreateShaderResourceView(pTex->GetResourceDep(), &viewDesc, handle);
+		};
+		DescriptorViewKey key(DescriptorViewKey::SRV, pTex->GetResourceId(), viewDesc);
+		pDesc_ = pDev->GetViewDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).CreateViewDescriptor(key, createFunc);
 		if (!pDesc_)
 		{
 			return false;
 		}
 
-		pDev->GetDeviceDep()->CreateShaderResourceView(pTex->GetResourceDep(), &viewDesc, pDesc_->GetCpuHandle());
+		// バインドレステーブルが有効なら固定インデックスを割り当てる
+		pBindlessTable_ = pDev->GetBindlessTable();
+		if (pBindlessTable_)
+		{
+			bindlessIndex_ = pDesc_->GetParentHeap()->RegisterBindlessView(pDesc_, createFunc);
+		}
 
 		return true;
 	}
@@ -124,6 +136,12 @@ namespace sl12
 	//----
 	void TextureView::Destroy()
 	{
+		if (pBindlessTable_)
+		{
+			pDesc_->GetParentHeap()->ReleaseBindlessView(pDesc_, bindlessIndex_);
+			pBindlessTable_ = nullptr;
+			bindlessIndex_ = BindlessDescriptorTable::kInvalidIndex;
+		}
 		SafeRelease(pDesc_);
 	}
 
@@ -193,13 +211,15 @@ namespace sl12
 			return false;
 		}
 
-		pDesc_ = pDev->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_RTV).CreateDescriptor();
+		DescriptorViewKey key(DescriptorViewKey::RTV, pTex->GetResourceId(), viewDesc);
+		pDesc_ = pDev->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_RTV).CreateViewDescriptor(key, [&](D3D12_CPU_DESCRIPTOR_HANDLE handle)
+		{
+			pDev->GetDeviceDep()->CreateRenderTargetView(pTex->GetResourceDep(), &viewDesc, handle);
+		});
 		if (!pDesc_)
 		{
 			return false;
 		}
-
-		pDev->GetDeviceDep()->CreateRenderTargetView(pTex->GetResourceDep(), &viewDesc, pDesc_->GetCpuHandle());
 		format_ = viewDesc.Format;
 
 		return true;
@@ -269,13 +289,15 @@ namespace sl12
 			return false;
 		}
 
-		pDesc_ = pDev->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_DSV).CreateDescriptor();
+		DescriptorViewKey key(DescriptorViewKey::DSV, pTex->GetResourceId(), viewDesc);
+		pDesc_ = pDev->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_DSV).CreateViewDescriptor(key, [&](D3D12_CPU_DESCRIPTOR_HANDLE handle)
+		{
+			pDev->GetDeviceDep()->CreateDepthStencilView(pTex->GetResourceDep(), &viewDesc, handle);
+		});
 		if (!pDesc_)
 		{
 			return false;
 		}
-
-		pDev->GetDeviceDep()->CreateDepthStencilView(pTex->GetResourceDep(), &viewDesc, pDesc_->GetCpuHandle());
 		format_ = viewDesc.Format;
 
 		return true;
@@ -344,13 +366,23 @@ namespace sl12
 			return false;
 		}
 
-		pDesc_ = pDev->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).CreateDescriptor();
+		auto createFunc = [&](D3D12_CPU_DESCRIPTOR_HANDLE handle)
+		{
+			pDev->GetDeviceDep()->CreateUnorderedAccessView(pTex->GetResourceDep(), nullptr, &viewDesc, handle);
+		};
+		DescriptorViewKey key(DescriptorViewKey::UAV, pTex->GetResourceId(), viewDesc);
+		pDesc_ = pDev->GetViewDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).CreateViewDescriptor(key, createFunc);
 		if (!pDesc_)
 		{
 			return false;
 		}
 
-		pDev->GetDeviceDep()->CreateUnorderedAccessView(pTex->GetResourceDep(), nullptr, &viewDesc, pDesc_->GetCpuHandle());
+		// バインドレステーブルが有効なら固定インデックスを割り当てる
+		pBindlessTable_ = pDev->GetBindlessTable();
+		if (pBindlessTable_)
+		{
+			bindlessIndex_ = pDesc_->GetParentHeap()->RegisterBindlessView(pDesc_, createFunc);
+		}
 
 		return true;
 	}
@@ -380,13 +412,23 @@ namespace sl12
 			viewDesc.Buffer.Flags = D3D12_BUFFER_UAV_FLAG_NONE;
 		}
 
-		pDesc_ = pDev->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).CreateDescriptor();
+		auto createFunc = [&](D3D12_CPU_DESCRIPTOR_HANDLE handle)
+		{
+			pDev->GetDeviceDep()->CreateUnorderedAccessView(pBuff->GetResourceDep(), nullptr, &viewDesc, handle);
+		};
+		DescriptorViewKey key(DescriptorViewKey::UAV, pBuff->GetResourceId(), viewDesc);
+		pDesc_ = pDev->GetViewDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).CreateViewDescriptor(key, createFunc);
 		if (!pDesc_)
 		{
 			return false;
 		}
 
-		pDev->GetDeviceDep()->CreateUnorderedAccessView(pBuff->GetResourceDep(), nullptr, &viewDesc, pDesc_->GetCpuHandle());
+		// バインドレステーブルが有効なら固定インデックスを割り当てる
+		pBindlessTable_ = pDev->GetBindlessTable();
+		if (pBindlessTable_)
+		{
+			bindlessIndex_ = pDesc_->GetParentHeap()->RegisterBindlessView(pDesc_, createFunc);
+		}
 
 		return true;
 	}
@@ -394,6 +436,12 @@ namespace sl12
 	//----
 	void UnorderedAccessView::Destroy()
 	{
+		if (pBindlessTable_)
+		{
+			pDesc_->GetParentHeap()->ReleaseBindlessView(pDesc_, bindlessIndex_);
+			pBindlessTable_ = nullptr;
+			bindlessIndex_ = BindlessDescriptorTable::kInvalidIndex;
+		}
 		SafeRelease(pDesc_);
 	}
 
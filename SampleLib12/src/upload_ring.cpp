@@ -0,0 +1,323 @@
+﻿#include <sl12/upload_ring.h>
+
+#include <sl12/device.h>
+#include <sl12/command_list.h>
+#include <sl12/command_queue.h>
+#include <cstdio>
+
+
+namespace sl12
+{
+	const u64 UploadRing::kDefaultSize;
+	const u64 UploadRing::kDefaultAlignment;
+
+	//-------------------------------------------------
+	// 初期化
+	//-------------------------------------------------
+	bool UploadRing::Initialize(Device* pDev, u64 size)
+	{
+		Destroy();
+
+		if (!pDev || size == 0)
+		{
+			return false;
+		}
+		pDevice_ = pDev;
+
+		// リングバッファは破棄するまでマップしたままにする
+		pResource_ = CreateUploadBuffer(size);
+		if (!pResource_)
+		{
+			return false;
+		}
+		auto hr = pResource_->Map(0, nullptr, reinterpret_cast<void**>(&pMappedData_));
+		if (FAILED(hr))
+		{
+			return false;
+		}
+
+		if (!fence_.Initialize(pDev))
+		{
+			return false;
+		}
+
+		ring_.Initialize(size);
+		return true;
+	}
+
+	//-------------------------------------------------
+	// 破棄
+	// GPUが領域を使用していない状態で呼び出すこと
+	//-------------------------------------------------
+	void UploadRing::Destroy()
+	{
+		for (auto&& p : unsubmittedBuffers_)
+		{
+			SafeRelease(p);
+		}
+		unsubmittedBuffers_.clear();
+		for (auto&& buffer : dedicatedBuffers_)
+		{
+			SafeRelease(buffer.pResource);
+		}
+		dedicatedBuffers_.clear();
+
+		if (pResource_ && pMappedData_)
+		{
+			pResource_->Unmap(0, nullptr);
+		}
+		pMappedData_ = nullptr;
+		SafeRelease(pResource_);
+
+		ring_.Destroy();
+		fence_.Destroy();
+		pDevice_ = nullptr;
+		highWaterMark_ = 0;
+		overflowCount_ = 0;
+	}
+
+	//-------------------------------------------------
+	// アップロード領域を確保する
+	//-------------------------------------------------
+	UploadAllocation UploadRing::Allocate(u64 size, u64 alignment)
+	{
+		UploadAllocation ret;
+		if (!pDevice_ || size == 0)
+		{
+			return ret;
+		}
+
+		u64 offset = ring_.Allocate(size, alignment);
+		if (offset != RingAllocator::kInvalidOffset)
+		{
+			ret.pResource = pResource_;
+			ret.offset = offset;
+			ret.pCpuAddress = pMappedData_ + offset;
+			ret.size = size;
+			if (highWaterMark_ < ring_.GetUsedSize())
+			{
+				highWaterMark_ = ring_.GetUsedSize();
+			}
+			return ret;
+		}
+
+		// リングに空きがない場合は専用のバッファを作成する
+		// リソースの先頭はD3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENTでアラインされている
+		ID3D12Resource* pResource = CreateUploadBuffer(size);
+		if (!pResource)
+		{
+			return ret;
+		}
+		u8* pData = nullptr;
+		auto hr = pResource->Map(0, nullptr, reinterpret_cast<void**>(&pData));
+		if (FAILED(hr))
+		{
+			SafeRelease(pResource);
+			return ret;
+		}
+		unsubmittedBuffers_.push_back(pResource);
+		overflowCount_++;
+
+		char text[256];
+		sprintf_s(text, "[sl12] UploadRing : ring is full (%llu / %llu bytes used). dedicated buffer is created (%llu bytes).\n",
+			ring_.GetUsedSize(), ring_.GetSize(), size);
+		OutputDebugStringA(text);
+
+		ret.pResource = pResource;
+		ret.offset = 0;
+		ret.pCpuAddress = pData;
+		ret.size = size;
+		return ret;
+	}
+
+	//-------------------------------------------------
+	// バッファへのコピー命令を積む
+	//-------------------------------------------------
+	bool UploadRing::CopyToBuffer(CommandList* pCmdList, ID3D12Resource* pDst, u64 dstOffset, const void* pData, u64 size)
+	{
+		if (!pCmdList || !pDst || !pData || size == 0)
+		{
+			return false;
+		}
+
+		UploadAllocation alloc = Allocate(size);
+		if (!alloc.IsValid())
+		{
+			return false;
+		}
+		memcpy(alloc.pCpuAddress, pData, size);
+
+		pCmdList->GetCommandList()->CopyBufferRegion(pDst, dstOffset, alloc.pResource, alloc.offset, size);
+		return true;
+	}
+
+	//-------------------------------------------------
+	// テクスチャへのコピー命令を積む
+	//-------------------------------------------------
+	bool UploadRing::CopyToTexture(CommandList* pCmdList, ID3D12Resource* pDst, u32 firstSubresource, u32 numSubresources, const D3D12_SUBRESOURCE_DATA* pSrcData)
+	{
+		if (!pDevice_ || !pCmdList || !pDst || !pSrcData || numSubresources == 0)
+		{
+			return false;
+		}
+
+		// リソースのサイズ等を取得
+		D3D12_RESOURCE_DESC desc = pDst->GetDesc();
+		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprint(numSubresources);
+		std::vector<u32> numRows(numSubresources);
+		std::vector<u64> rowSize(numSubresources);
+		u64 totalSize;
+		pDevice_->GetDeviceDep()->GetCopyableFootprints(&desc, firstSubresource, numSubresources, 0, footprint.data(), numRows.data(), rowSize.data(), &totalSize);
+		for (u32 i = 0; i < numSubresources; i++)
+		{
+			if (rowSize[i] > (SIZE_T)-1)
+			{
+				return false;
+			}
+		}
+
+		UploadAllocation alloc = Allocate(totalSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+		if (!alloc.IsValid())
+		{
+			return false;
+		}
+
+		// 元データの行ピッチはフットプリントと一致しないことがあるので、行ごとにコピーする
+		for (u32 i = 0; i < numSubresources; i++)
+		{
+			const D3D12_SUBRESOURCE_FOOTPRINT& fp = footprint[i].Footprint;
+			u64 dstSlicePitch = static_cast<u64>(fp.RowPitch) * numRows[i];
+			u8* pDstData = alloc.pCpuAddress + footprint[i].Offset;
+			const u8* pSrc = static_cast<const u8*>(pSrcData[i].pData);
+			for (u32 z = 0; z < fp.Depth; z++)
+			{
+				for (u32 y = 0; y < numRows[i]; y++)
+				{
+					memcpy(pDstData + dstSlicePitch * z + static_cast<u64>(fp.RowPitch) * y,
+						pSrc + pSrcData[i].SlicePitch * z + pSrcData[i].RowPitch * y,
+						static_cast<size_t>(rowSize[i]));
+				}
+			}
+		}
+
+		// コピー命令を発行
+		for (u32 i = 0; i < numSubresources; i++)
+		{
+			D3D12_TEXTURE_COPY_LOCATION src, dst;
+			src.pResource = alloc.pResource;
+			src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+			src.PlacedFootprint = footprint[i];
+			src.PlacedFootprint.Offset += alloc.offset;
+			dst.pResource = pDst;
+			dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+			dst.SubresourceIndex = firstSubresource + i;
+			pCmdList->GetCommandList()->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+		}
+
+		return true;
+	}
+
+	//-------------------------------------------------
+	// 確保済みの領域をフェンス値でタグ付けする
+	//-------------------------------------------------
+	u32 UploadRing::Submit(CommandQueue* pQueue)
+	{
+		if (!pDevice_ || !pQueue)
+		{
+			return 0;
+		}
+		if (ring_.GetFrameUsedSize() == 0 && unsubmittedBuffers_.empty())
+		{
+			return fence_.GetSignaledValue();
+		}
+
+		fence_.Signal(pQueue);
+		u32 value = fence_.GetSignaledValue();
+		ring_.EndFrame(value);
+		for (auto&& p : unsubmittedBuffers_)
+		{
+			DedicatedBuffer buffer;
+			buffer.pResource = p;
+			buffer.fenceValue = value;
+			dedicatedBuffers_.push_back(buffer);
+		}
+		unsubmittedBuffers_.clear();
+		return value;
+	}
+
+	//-------------------------------------------------
+	// GPUが完了した領域を回収する
+	//-------------------------------------------------
+	void UploadRing::Reclaim()
+	{
+		if (!pDevice_)
+		{
+			return;
+		}
+
+		u64 completedValue = fence_.GetCompletedValue();
+		ring_.Reclaim(completedValue);
+		while (!dedicatedBuffers_.empty() && dedicatedBuffers_.front().fenceValue <= completedValue)
+		{
+			SafeRelease(dedicatedBuffers_.front().pResource);
+			dedicatedBuffers_.pop_front();
+		}
+	}
+
+	//-------------------------------------------------
+	// Submit()した全ての領域の完了を待って回収する
+	//-------------------------------------------------
+	void UploadRing::WaitIdle()
+	{
+		if (!pDevice_)
+		{
+			return;
+		}
+
+		fence_.WaitSignal();
+		Reclaim();
+	}
+
+	//-------------------------------------------------
+	// アップロードバッファを作成する
+	//-------------------------------------------------
+	ID3D12Resource* UploadRing::CreateUploadBuffer(u64 size)
+	{
+		D3D12_HEAP_PROPERTIES heapProp = {};
+		heapProp.Type = D3D12_HEAP_TYPE_UPLOAD;
+		heapProp.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+		heapProp.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+		heapProp.CreationNodeMask = 1;
+		heapProp.VisibleNodeMask = 1;
+
+		D3D12_RESOURCE_DESC desc = {};
+		desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+		desc.Alignment = 0;
+		desc.Width = size;
+		desc.Height = 1;
+		desc.DepthOrArraySize = 1;
+		desc.MipLevels = 1;
+		desc.Format = DXGI_FORMAT_UNKNOWN;
+		desc.SampleDesc.Count = 1;
+		desc.SampleDesc.Quality = 0;
+		desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+		desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+		ID3D12Resource* pResource = nullptr;
+		auto hr = pDevice_->GetDeviceDep()->CreateCommittedResource(
+			&heapProp,
+			D3D12_HEAP_FLAG_NONE,
+			&desc,
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(&pResource));
+		if (FAILED(hr))
+		{
+			return nullptr;
+		}
+		return pResource;
+	}
+
+}	// namespace sl12
+
+//	EOF
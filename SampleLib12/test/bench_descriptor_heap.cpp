@@ -0,0 +1,127 @@
+﻿#include "test_util.h"
+#include "test_device.h"
+
+#include <sl12/descriptor_heap.h>
+#include <sl12/descriptor.h>
+#include <thread>
+
+
+namespace
+{
+	static const int kOpsPerThread = 400000;
+	static const int kHeldPerThread = 64;
+
+	// 比較用: 単一のミューテックスで保護したフリーリスト(マガジン導入前の構成)
+	class MutexFreeList
+	{
+	public:
+		MutexFreeList(sl12::u32 num)
+		{
+			for (sl12::u32 i = 0; i < num; i++)
+			{
+				free_.push_back(i);
+			}
+		}
+
+		bool Create(sl12::u32& out)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (free_.empty())
+			{
+				return false;
+			}
+			out = free_.back();
+			free_.pop_back();
+			return true;
+		}
+		void Release(sl12::u32 index)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			free_.push_back(index);
+		}
+
+	private:
+		std::mutex				mutex_;
+		std::vector<sl12::u32>	free_;
+	};
+
+	// 各スレッドがkHeldPerThread個を保持しながら確保と解放を繰り返す
+	template <typename CreateFunc, typename ReleaseFunc>
+	double Run(int numThreads, CreateFunc create, ReleaseFunc release)
+	{
+		std::vector<std::thread> threads;
+		std::atomic<int> ready(0);
+		std::atomic<bool> go(false);
+		for (int t = 0; t < numThreads; t++)
+		{
+			threads.emplace_back([&]
+			{
+				std::vector<typename std::result_of<CreateFunc()>::type> held;
+				held.reserve(kHeldPerThread);
+				ready++;
+				while (!go)
+				{
+					std::this_thread::yield();
+				}
+				for (int i = 0; i < kOpsPerThread; i++)
+				{
+					if (held.size() < kHeldPerThread)
+					{
+						held.push_back(create());
+					}
+					else
+					{
+						release(held[i % kHeldPerThread]);
+						held[i % kHeldPerThread] = create();
+					}
+				}
+				for (auto&& h : held)
+				{
+					release(h);
+				}
+			});
+		}
+		while (ready != numThreads)
+		{
+			std::this_thread::yield();
+		}
+		sl12test::Timer timer;
+		go = true;
+		for (auto&& th : threads)
+		{
+			th.join();
+		}
+		double ms = timer.GetMilliseconds();
+		return static_cast<double>(numThreads) * kOpsPerThread / (ms * 1000.0);	// Mops/s
+	}
+}
+
+int main()
+{
+	static const sl12::u32 kNumDescs = 65536;
+
+	sl12test::TestDevice td;
+	sl12::DescriptorHeap heap;
+	D3D12_DESCRIPTOR_HEAP_DESC desc{ D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, kNumDescs, D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE, 1 };
+	if (!heap.Initialize(&td.GetDevice(), desc))
+	{
+		return 1;
+	}
+	MutexFreeList baseline(kNumDescs);
+
+	printf("threads, DescriptorHeap (Mops/s), single mutex (Mops/s)\n");
+	unsigned maxThreads = std::max(8u, std::thread::hardware_concurrency());
+	for (unsigned n = 1; n <= maxThreads; n *= 2)
+	{
+		double heapRate = Run(n,
+			[&] { return heap.CreateDescriptor(); },
+			[&](sl12::Descriptor* p) { p->Release(); });
+		double mutexRate = Run(n,
+			[&] { sl12::u32 i = 0; baseline.Create(i); return i; },
+			[&](sl12::u32 i) { baseline.Release(i); });
+		printf("%u, %.2f, %.2f\n", n, heapRate, mutexRate);
+	}
+	return 0;
+}
+
+//	EOF
@@ -0,0 +1,139 @@
+﻿#include "test_util.h"
+#include "test_device.h"
+
+#include <sl12/hierarchical_bitset.h>
+#include <sl12/descriptor_heap.h>
+#include <sl12/descriptor.h>
+#include <algorithm>
+#include <random>
+
+
+namespace
+{
+	static const sl12::u32 kNumDescs = 65535;
+	static const int kNumRounds = 20;
+
+	// 比較用: ビットセット導入前のデスクリプタ. スロットごとに親、前後のリンク、ハンドル、インデックスを持つ
+	struct ListDescriptor
+	{
+		void*						pParentHeap;
+		ListDescriptor*				pPrev;
+		ListDescriptor*				pNext;
+		D3D12_CPU_DESCRIPTOR_HANDLE	cpuHandle;
+		D3D12_GPU_DESCRIPTOR_HANDLE	gpuHandle;
+		sl12::u32					index;
+	};
+
+	// 比較用: 未使用リストによる確保(導入前のDescriptorHeapと同じ)
+	class ListAllocator
+	{
+	public:
+		ListAllocator(sl12::u32 num)
+			: descs_(num + 1)
+		{
+			pUnused_ = &descs_[0];
+			pUnused_->pPrev = pUnused_->pNext = pUnused_;
+			for (sl12::u32 i = 0; i < num; i++)
+			{
+				ListDescriptor* p = &descs_[i + 1];
+				p->pParentHeap = this;
+				p->cpuHandle.ptr = i * 32;
+				p->gpuHandle.ptr = i * 32;
+				p->index = i;
+				Release(p);
+			}
+		}
+
+		ListDescriptor* Create()
+		{
+			ListDescriptor* ret = pUnused_->pNext;
+			if (ret == pUnused_)
+			{
+				return nullptr;
+			}
+			ret->pPrev->pNext = ret->pNext;
+			ret->pNext->pPrev = ret->pPrev;
+			ret->pNext = ret->pPrev = ret;
+			return ret;
+		}
+		void Release(ListDescriptor* p)
+		{
+			ListDescriptor* next = pUnused_->pNext;
+			pUnused_->pNext = next->pPrev = p;
+			p->pPrev = pUnused_;
+			p->pNext = next;
+		}
+
+		size_t GetMemorySize() const { return descs_.size() * sizeof(ListDescriptor); }
+
+	private:
+		std::vector<ListDescriptor>	descs_;
+		ListDescriptor*				pUnused_;
+	};
+
+	// 全数を確保し、ランダムな順で解放することを繰り返す. 解放順が乱れるほどリストの局所性は悪化する
+	template <typename T, typename CreateFunc, typename ReleaseFunc>
+	double Run(CreateFunc create, ReleaseFunc release)
+	{
+		std::vector<T> held;
+		held.reserve(kNumDescs);
+		std::mt19937 rng(1);
+		sl12test::Timer timer;
+		for (int round = 0; round < kNumRounds; round++)
+		{
+			while (held.size() < kNumDescs)
+			{
+				held.push_back(create());
+			}
+			std::shuffle(held.begin(), held.end(), rng);
+			for (auto&& h : held)
+			{
+				release(h);
+			}
+			held.clear();
+		}
+		double ms = timer.GetMilliseconds();
+		return ms * 1000000.0 / (2.0 * kNumDescs * kNumRounds);	// ns/op
+	}
+}
+
+int main()
+{
+	// シャッフルの時間を差し引くための計測
+	double shuffleNs = Run<sl12::u32>([] { return 0u; }, [](sl12::u32) {});
+
+	ListAllocator list(kNumDescs);
+	double listNs = Run<ListDescriptor*>(
+		[&] { return list.Create(); },
+		[&](ListDescriptor* p) { list.Release(p); });
+
+	sl12::HierarchicalBitset bits;
+	bits.Initialize(kNumDescs, true);
+	double bitsNs = Run<sl12::u32>(
+		[&] { sl12::u32 i = bits.FindFirstSet(); bits.Reset(i); return i; },
+		[&](sl12::u32 i) { bits.Set(i); });
+
+	// DescriptorHeapはマガジンを経由する(単一スレッド)
+	sl12test::TestDevice td;
+	sl12::DescriptorHeap heap;
+	D3D12_DESCRIPTOR_HEAP_DESC desc{ D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, kNumDescs, D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE, 1 };
+	if (!heap.Initialize(&td.GetDevice(), desc))
+	{
+		return 1;
+	}
+	double heapNs = Run<sl12::Descriptor*>(
+		[&] { return heap.CreateDescriptor(); },
+		[&](sl12::Descriptor* p) { p->Release(); });
+
+	size_t bitsBytes = bits.GetMemorySize();
+	size_t heapBytes = bitsBytes + kNumDescs * sizeof(sl12::Descriptor);
+
+	printf("%u descriptors, create + release in shuffled order (shuffle overhead %.2f ns/op subtracted)\n", kNumDescs, shuffleNs);
+	printf("allocator, ns/op, bookkeeping bytes\n");
+	printf("linked list, %.2f, %zu\n", listNs - shuffleNs, list.GetMemorySize());
+	printf("hierarchical bitset, %.2f, %zu\n", bitsNs - shuffleNs, bitsBytes);
+	printf("DescriptorHeap, %.2f, %zu\n", heapNs - shuffleNs, heapBytes);
+	return 0;
+}
+
+//	EOF
@@ -0,0 +1,101 @@
+﻿#include "test_util.h"
+
+#include <sl12/pipeline_blob_cache.h>
+#include <sl12/crc.h>
+#include <cstdio>
+#include <random>
+#include <string>
+
+
+namespace
+{
+	static const int kNumRounds = 20;
+
+	// PSOのコンパイル結果のサイズは数KBから数十KBなので、平均32KBのブロブを想定する
+	static const sl12::u32 kNumEntries[] = { 64, 256, 1024 };
+	static const size_t kAverageBlobSize = 32 * 1024;
+
+	std::vector<std::vector<sl12::u8>> MakeBlobs(sl12::u32 count)
+	{
+		std::mt19937 rng(count);
+		std::vector<std::vector<sl12::u8>> blobs(count);
+		for (auto&& blob : blobs)
+		{
+			blob.resize(kAverageBlobSize / 2 + rng() % kAverageBlobSize);
+			for (auto&& v : blob) v = static_cast<sl12::u8>(rng());
+		}
+		return blobs;
+	}
+
+	sl12::PipelineCacheIdentity MakeIdentity()
+	{
+		sl12::PipelineCacheIdentity id;
+		id.vendorId = 0x10de;
+		id.deviceId = 0x2684;
+		return id;
+	}
+}
+
+int main()
+{
+	std::string cacheFile = sl12test::GetTempFilePath("bench_pipeline.cache");
+
+	printf("%d rounds, ms per call\n", kNumRounds);
+	printf("entries, file MB, Store all, Save, Load, Find all, CRC32 of all blobs\n");
+	for (auto count : kNumEntries)
+	{
+		auto blobs = MakeBlobs(count);
+		size_t totalBytes = 0;
+		for (auto&& b : blobs) totalBytes += b.size();
+
+		double storeMs = 0.0, saveMs = 0.0, loadMs = 0.0, findMs = 0.0, crcMs = 0.0;
+		volatile sl12::u64 sink = 0;		// 計算が省略されないようにする
+		for (int round = 0; round < kNumRounds; round++)
+		{
+			// 1回目の起動: コンパイルした全てのPSOを登録して保存する
+			sl12test::Timer timer;
+			{
+				sl12::PipelineBlobCache cache;
+				cache.SetIdentity(MakeIdentity());
+				for (sl12::u32 i = 0; i < count; i++)
+				{
+					cache.Store(i + 1, blobs[i].data(), blobs[i].size());
+				}
+				storeMs += timer.GetMilliseconds();
+				timer.Reset();
+				cache.Save(cacheFile.c_str());
+				saveMs += timer.GetMilliseconds();
+			}
+
+			// 2回目の起動: 読み込んで全てのPSOを検索する
+			timer.Reset();
+			sl12::PipelineBlobCache cache;
+			cache.SetIdentity(MakeIdentity());
+			cache.Load(cacheFile.c_str());
+			loadMs += timer.GetMilliseconds();
+			timer.Reset();
+			std::vector<sl12::u8> blob;
+			for (sl12::u32 i = 0; i < count; i++)
+			{
+				cache.Find(i + 1, blob);
+				sink += blob.size();
+			}
+			findMs += timer.GetMilliseconds();
+
+			// 内訳: 読み込み時に行うCRCの検証
+			timer.Reset();
+			for (auto&& b : blobs)
+			{
+				sink += sl12::CalcCrc32(b.data(), b.size());
+			}
+			crcMs += timer.GetMilliseconds();
+		}
+
+		printf("%u, %.1f, %.2f, %.2f, %.2f, %.2f, %.2f\n", count, totalBytes / (1024.0 * 1024.0),
+			storeMs / kNumRounds, saveMs / kNumRounds, loadMs / kNumRounds, findMs / kNumRounds, crcMs / kNumRounds);
+	}
+	remove(cacheFile.c_str());
+	return 0;
+}
+
+//	EOF
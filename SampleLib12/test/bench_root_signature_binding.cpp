@@ -0,0 +1,118 @@
+﻿#include "test_util.h"
+#include "test_device.h"
+
+#include <sl12/root_signature_manager.h>
+#include <sl12/shader.h>
+#include <sl12/buffer.h>
+#include <sl12/buffer_view.h>
+#include <map>
+#include <string>
+
+
+namespace
+{
+	static const int kNumBinds = 2000000;
+
+	// cbWorld(b0)、rSrcVBuffer(t0)、rwDstVBuffer(u0)を持つコンピュートシェーダ
+	static const char* kComputeShaderFile = "../../Sample004/data/world_transform_fp32.cso";
+
+	// 1回の呼び出しで2つのバインドを行い、1秒あたりのバインド数を返す
+	template <typename BindFunc>
+	double Run(BindFunc bind)
+	{
+		sl12test::Timer timer;
+		for (int i = 0; i < kNumBinds / 2; i++)
+		{
+			bind();
+		}
+		double ms = timer.GetMilliseconds();
+		return kNumBinds / (ms * 1000.0);	// Mbinds/s
+	}
+}
+
+int main()
+{
+	sl12test::TestDevice td;
+	std::array<sl12::DescriptorHeapLayout, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> layouts;
+	layouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].numTransients = 256;
+	layouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].enableViewCache = true;
+	if (!td.InitializeHeaps({ 1024, 16, 16, 16 }, layouts))
+	{
+		return 1;
+	}
+
+	sl12::Shader cs;
+	if (!cs.Initialize(&td.GetDevice(), sl12::ShaderType::Compute, kComputeShaderFile))
+	{
+		printf("failed to load %s\n", kComputeShaderFile);
+		return 1;
+	}
+	sl12::RootSignatureManager manager;
+	manager.Initialize(&td.GetDevice());
+	sl12::RootSignatureCreateDesc desc;
+	desc.pCS = &cs;
+	auto handle = manager.CreateRootSignature(desc);
+
+	sl12::Buffer cb, vb;
+	sl12::ConstantBufferView cbv;
+	sl12::BufferView srv;
+	if (!handle.IsValid()
+		|| !cb.Initialize(&td.GetDevice(), 256, 0, sl12::BufferUsage::ConstantBuffer, true, false)
+		|| !vb.Initialize(&td.GetDevice(), 1024, 16, sl12::BufferUsage::ShaderResource, false, false)
+		|| !cbv.Initialize(&td.GetDevice(), &cb)
+		|| !srv.Initialize(&td.GetDevice(), &vb, 0, 16))
+	{
+		return 1;
+	}
+
+	// ステートキャッシュで同じテーブルの再設定は除外されるので、記録のコストは含まない
+	sl12test::TestCommandList tcl(&td.GetDevice().GetGraphicsQueue());
+	auto&& cmdList = tcl.Get();
+	cmdList.EnableStateCache(true);
+
+	// 比較用: 解決済みスロット導入前と同じ、std::stringをキーとするstd::mapの検索
+	std::map<std::string, std::vector<int>> slotMap;
+	slotMap["cbWorld"].push_back(0);
+	slotMap["rSrcVBuffer"].push_back(1);
+	slotMap["rwDstVBuffer"].push_back(2);
+	sl12::BindingSlot resolved[] = { handle.GetBindingSlot("cbWorld"), handle.GetBindingSlot("rSrcVBuffer") };
+	const char* volatile cbName = "cbWorld";		// 実行時の文字列として扱わせる
+	const char* volatile srvName = "rSrcVBuffer";
+
+	double mapRate = Run([&]
+	{
+		handle.SetDescriptor(cmdList, resolved[slotMap.find(cbName)->second[0]], cbv);
+		handle.SetDescriptor(cmdList, resolved[slotMap.find(srvName)->second[0]], srv);
+	});
+	double stringRate = Run([&]
+	{
+		handle.SetDescriptor(cmdList, cbName, cbv);
+		handle.SetDescriptor(cmdList, srvName, srv);
+	});
+	static constexpr sl12::BindingName kCbWorld("cbWorld");
+	static constexpr sl12::BindingName kSrcVBuffer("rSrcVBuffer");
+	double hashRate = Run([&]
+	{
+		handle.SetDescriptor(cmdList, kCbWorld, cbv);
+		handle.SetDescriptor(cmdList, kSrcVBuffer, srv);
+	});
+	double slotRate = Run([&]
+	{
+		handle.SetDescriptor(cmdList, resolved[0], cbv);
+		handle.SetDescriptor(cmdList, resolved[1], srv);
+	});
+
+	printf("%d binds, state cache enabled (issued %u, filtered %u)\n", kNumBinds * 4,
+		cmdList.GetStateCacheStats().issued, cmdList.GetStateCacheStats().filtered);
+	printf("lookup, Mbinds/s\n");
+	printf("std::map<std::string> (before), %.2f\n", mapRate);
+	printf("string name (runtime hash), %.2f\n", stringRate);
+	printf("constexpr BindingName, %.2f\n", hashRate);
+	printf("resolved BindingSlot, %.2f\n", slotRate);
+
+	handle.Invalid();
+	manager.Destroy();
+	return 0;
+}
+
+//	EOF
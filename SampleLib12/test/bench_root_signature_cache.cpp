@@ -0,0 +1,152 @@
+﻿#include "test_util.h"
+#include "test_device.h"
+
+#include <sl12/root_signature_manager.h>
+#include <sl12/shader.h>
+#include <sl12/shader_reflection.h>
+#include <sl12/crc.h>
+#include <memory>
+#include <string>
+
+
+namespace
+{
+	static const int kNumRounds = 200;
+
+	struct ShaderFile
+	{
+		const char*				path;
+		sl12::ShaderType::Type	type;
+	};	// struct ShaderFile
+
+	// Sample004, 005, 008のシェーダを1つずつルートシグネチャにする
+	static const ShaderFile kShaderFiles[] = {
+		{ "../../Sample004/data/VSSample.cso", sl12::ShaderType::Vertex },
+		{ "../../Sample004/data/PSDispDepth.cso", sl12::ShaderType::Pixel },
+		{ "../../Sample004/data/world_transform_fp16.cso", sl12::ShaderType::Compute },
+		{ "../../Sample004/data/world_transform_fp32.cso", sl12::ShaderType::Compute },
+		{ "../../Sample005/data/CSFFTx.cso", sl12::ShaderType::Compute },
+		{ "../../Sample005/data/CSFFTy.cso", sl12::ShaderType::Compute },
+		{ "../../Sample005/data/CSFFTFilter.cso", sl12::ShaderType::Compute },
+		{ "../../Sample005/data/PSFFTView.cso", sl12::ShaderType::Pixel },
+		{ "../../Sample008/data/base_pass.vv.cso", sl12::ShaderType::Vertex },
+		{ "../../Sample008/data/blur_x.p.cso", sl12::ShaderType::Pixel },
+		{ "../../Sample008/data/blur_y.p.cso", sl12::ShaderType::Pixel },
+		{ "../../Sample008/data/clear_hash.c.cso", sl12::ShaderType::Compute },
+		{ "../../Sample008/data/lighting.p.cso", sl12::ShaderType::Pixel },
+		{ "../../Sample008/data/linear_depth.p.cso", sl12::ShaderType::Pixel },
+		{ "../../Sample008/data/project_hash.c.cso", sl12::ShaderType::Compute },
+		{ "../../Sample008/data/reproject_reflection.p.cso", sl12::ShaderType::Pixel },
+		{ "../../Sample008/data/resolve_hash.p.cso", sl12::ShaderType::Pixel },
+		{ "../../Sample008/data/tile_lighting.c.cso", sl12::ShaderType::Compute },
+		{ "../../Sample008/data/water.p.cso", sl12::ShaderType::Pixel },
+		{ "../../Sample008/data/water.vv.cso", sl12::ShaderType::Vertex },
+	};
+
+	// 新しいマネージャで全てのルートシグネチャを生成する. cacheFileがあれば先に読み込む
+	double CreateAll(sl12::Device* pDev, const std::vector<std::unique_ptr<sl12::Shader>>& shaders, const char* cacheFile, const char* saveFile, sl12::u32* pHits)
+	{
+		sl12test::Timer timer;
+		sl12::RootSignatureManager manager;
+		manager.Initialize(pDev);
+		if (cacheFile)
+		{
+			manager.LoadCache(cacheFile);
+		}
+		std::vector<sl12::RootSignatureHandle> handles(shaders.size());
+		for (size_t i = 0; i < shaders.size(); i++)
+		{
+			sl12::RootSignatureCreateDesc desc;
+			switch (kShaderFiles[i].type)
+			{
+			case sl12::ShaderType::Vertex: desc.pVS = shaders[i].get(); break;
+			case sl12::ShaderType::Pixel: desc.pPS = shaders[i].get(); break;
+			default: desc.pCS = shaders[i].get(); break;
+			}
+			desc.maxRootConstants = 16;
+			handles[i] = manager.CreateRootSignature(desc);
+		}
+		double ms = timer.GetMilliseconds();
+
+		if (saveFile)
+		{
+			manager.SaveCache(saveFile);
+		}
+		*pHits = manager.GetCache().GetHitCount();
+		for (auto&& h : handles)
+		{
+			h.Invalid();
+		}
+		return ms;
+	}
+}
+
+int main()
+{
+	sl12test::TestDevice td;
+	if (!td.InitializeHeaps({ 256, 16, 16, 16 }))
+	{
+		return 1;
+	}
+
+	std::vector<std::unique_ptr<sl12::Shader>> shaders;
+	for (auto&& f : kShaderFiles)
+	{
+		shaders.emplace_back(new sl12::Shader());
+		if (!shaders.back()->Initialize(&td.GetDevice(), f.type, f.path))
+		{
+			printf("failed to load %s\n", f.path);
+			return 1;
+		}
+	}
+
+	std::string cacheFile = sl12test::GetTempFilePath("bench_root_signature.bin");
+	sl12::u32 hits = 0;
+	CreateAll(&td.GetDevice(), shaders, nullptr, cacheFile.c_str(), &hits);
+
+	double coldMs = 0.0, warmMs = 0.0;
+	sl12::u32 coldHits = 0, warmHits = 0;
+	for (int round = 0; round < kNumRounds; round++)
+	{
+		coldMs += CreateAll(&td.GetDevice(), shaders, nullptr, nullptr, &hits);
+		coldHits += hits;
+		warmMs += CreateAll(&td.GetDevice(), shaders, cacheFile.c_str(), nullptr, &hits);
+		warmHits += hits;
+	}
+	remove(cacheFile.c_str());
+
+	// 内訳: キャッシュの有無に関わらず行うバイトコードのハッシュ計算と、キャッシュで省略されるリフレクション
+	sl12test::Timer timer;
+	volatile sl12::u64 sink = 0;		// 計算が省略されないようにする
+	for (int round = 0; round < kNumRounds; round++)
+	{
+		for (auto&& sh : shaders)
+		{
+			sink += sl12::CalcCrc32(sh->GetData(), sh->GetSize());
+			sink += sl12::CalcFnv1a64(sh->GetData(), sh->GetSize());
+		}
+	}
+	double hashMs = timer.GetMilliseconds();
+	timer.Reset();
+	std::vector<sl12::ShaderBindingDesc> bindings;
+	for (int round = 0; round < kNumRounds; round++)
+	{
+		for (auto&& sh : shaders)
+		{
+			sl12::ReflectShaderBindings(sh->GetData(), sh->GetSize(), bindings);
+			sink += bindings.size();
+		}
+	}
+	double reflectMs = timer.GetMilliseconds();
+
+	size_t num = sizeof(kShaderFiles) / sizeof(kShaderFiles[0]);
+	printf("%zu root signatures, %d rounds\n", num, kNumRounds);
+	printf("cache, ms per start-up, us per root signature, cache hits per start-up\n");
+	printf("cold, %.3f, %.2f, %u\n", coldMs / kNumRounds, coldMs * 1000.0 / (kNumRounds * num), coldHits / kNumRounds);
+	printf("warm, %.3f, %.2f, %u\n", warmMs / kNumRounds, warmMs * 1000.0 / (kNumRounds * num), warmHits / kNumRounds);
+	printf("bytecode hashing only, %.3f, %.2f, -\n", hashMs / kNumRounds, hashMs * 1000.0 / (kNumRounds * num));
+	printf("reflection only, %.3f, %.2f, -\n", reflectMs / kNumRounds, reflectMs * 1000.0 / (kNumRounds * num));
+	return 0;
+}
+
+//	EOF
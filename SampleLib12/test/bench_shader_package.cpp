@@ -0,0 +1,148 @@
+﻿#include "test_util.h"
+#include "test_device.h"
+
+#include <sl12/shader_package.h>
+#include <sl12/shader.h>
+#include <cstdio>
+#include <string>
+
+
+namespace
+{
+	static const int kNumRounds = 200;
+
+	// Sample008のLoadShaders()と同じシェーダ(ベンチマークはSampleLib12/testで実行すること)
+	struct CsoFile
+	{
+		const char*				filename;
+		sl12::ShaderType::Type	type;
+	};
+	static const CsoFile kCsoFiles[] = {
+		{ "../../Sample008/data/base_pass.vv.cso", sl12::ShaderType::Vertex },
+		{ "../../Sample008/data/base_pass.p.cso", sl12::ShaderType::Pixel },
+		{ "../../Sample008/data/water.vv.cso", sl12::ShaderType::Vertex },
+		{ "../../Sample008/data/water.p.cso", sl12::ShaderType::Pixel },
+		{ "../../Sample008/data/post_process.vv.cso", sl12::ShaderType::Vertex },
+		{ "../../Sample008/data/linear_depth.p.cso", sl12::ShaderType::Pixel },
+		{ "../../Sample008/data/lighting.p.cso", sl12::ShaderType::Pixel },
+		{ "../../Sample008/data/blur_x.p.cso", sl12::ShaderType::Pixel },
+		{ "../../Sample008/data/blur_y.p.cso", sl12::ShaderType::Pixel },
+		{ "../../Sample008/data/clear_hash.c.cso", sl12::ShaderType::Compute },
+		{ "../../Sample008/data/project_hash.c.cso", sl12::ShaderType::Compute },
+		{ "../../Sample008/data/resolve_hash.p.cso", sl12::ShaderType::Pixel },
+		{ "../../Sample008/data/tile_lighting.c.cso", sl12::ShaderType::Compute },
+		{ "../../Sample008/data/reproject_reflection.vv.cso", sl12::ShaderType::Vertex },
+		{ "../../Sample008/data/reproject_reflection.p.cso", sl12::ShaderType::Pixel },
+	};
+	static const int kNumFiles = sizeof(kCsoFiles) / sizeof(kCsoFiles[0]);
+
+	// .csoを読み込み、識別情報付きのパッケージを作成する(パッケージが古い場合の処理)
+	bool LoadLooseAndBuild(sl12::Device* pDev, sl12::Shader* shaders, const char* packageFile)
+	{
+		sl12::ShaderPackageBuilder builder;
+		for (int i = 0; i < kNumFiles; i++)
+		{
+			sl12::ShaderSourceStamp stamp;
+			sl12::GetShaderSourceStamp(kCsoFiles[i].filename, stamp);
+			if (!shaders[i].Initialize(pDev, kCsoFiles[i].type, kCsoFiles[i].filename))
+			{
+				return false;
+			}
+			builder.AddShader(kCsoFiles[i].filename, kCsoFiles[i].type, shaders[i].GetData(), shaders[i].GetSize());
+			builder.SetSourceStamp(kCsoFiles[i].filename, stamp);
+		}
+		return builder.Save(packageFile);
+	}
+
+	// パッケージを開き、全てのシェーダを生成する
+	bool LoadPackage(sl12::Device* pDev, sl12::Shader* shaders, const char* packageFile, bool checkSource)
+	{
+		sl12::ShaderPackage package;
+		if (!package.Open(packageFile))
+		{
+			return false;
+		}
+		for (int i = 0; i < kNumFiles; i++)
+		{
+			sl12::u32 index = package.Find(kCsoFiles[i].filename);
+			if (index == sl12::ShaderPackage::kInvalidIndex
+				|| (checkSource && !package.IsSourceUpToDate(index, kCsoFiles[i].filename))
+				|| !package.CreateShader(pDev, index, shaders[i]))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main()
+{
+	sl12test::TestDevice td;
+	sl12::Device* pDev = &td.GetDevice();
+	std::string packageFile = sl12test::GetTempFilePath("bench_shaders.pack");
+
+	sl12::Shader shaders[kNumFiles];
+	if (!LoadLooseAndBuild(pDev, shaders, packageFile.c_str()))
+	{
+		fprintf(stderr, "failed to load Sample008 shaders. run in SampleLib12/test.\n");
+		return 1;
+	}
+	size_t totalBytes = 0;
+	for (auto&& s : shaders) totalBytes += s.GetSize();
+
+	double looseMs = 0.0, rebuildMs = 0.0, packageMs = 0.0, checkedMs = 0.0, stampMs = 0.0;
+	for (int round = 0; round < kNumRounds; round++)
+	{
+		// 同じラウンド内でファイルキャッシュの条件を揃えるため、各方式を交互に実行する
+		sl12test::Timer timer;
+		for (int i = 0; i < kNumFiles; i++)
+		{
+			if (!shaders[i].Initialize(pDev, kCsoFiles[i].type, kCsoFiles[i].filename))
+			{
+				return 1;
+			}
+		}
+		looseMs += timer.GetMilliseconds();
+
+		timer.Reset();
+		if (!LoadLooseAndBuild(pDev, shaders, packageFile.c_str()))
+		{
+			return 1;
+		}
+		rebuildMs += timer.GetMilliseconds();
+
+		timer.Reset();
+		if (!LoadPackage(pDev, shaders, packageFile.c_str(), false))
+		{
+			return 1;
+		}
+		packageMs += timer.GetMilliseconds();
+
+		timer.Reset();
+		if (!LoadPackage(pDev, shaders, packageFile.c_str(), true))
+		{
+			return 1;
+		}
+		checkedMs += timer.GetMilliseconds();
+
+		timer.Reset();
+		for (int i = 0; i < kNumFiles; i++)
+		{
+			sl12::ShaderSourceStamp stamp;
+			sl12::GetShaderSourceStamp(kCsoFiles[i].filename, stamp);
+		}
+		stampMs += timer.GetMilliseconds();
+	}
+	remove(packageFile.c_str());
+
+	printf("%d shaders, %.1f KB, %d rounds, ms per startup\n", kNumFiles, totalBytes / 1024.0, kNumRounds);
+	printf("loose files          : %.3f\n", looseMs / kNumRounds);
+	printf("loose files + rebuild: %.3f\n", rebuildMs / kNumRounds);
+	printf("package              : %.3f\n", packageMs / kNumRounds);
+	printf("package + stamp check: %.3f\n", checkedMs / kNumRounds);
+	printf("stamp check only     : %.3f\n", stampMs / kNumRounds);
+	return 0;
+}
+
+//	EOF
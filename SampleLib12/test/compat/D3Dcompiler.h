@@ -0,0 +1,16 @@
+﻿#pragma once
+
+// ヘッドレステスト用のシェーダリフレクション互換宣言. D3DReflect()は常に失敗する
+
+#include "d3d12.h"
+enum D3D_SHADER_INPUT_TYPE { D3D_SIT_CBUFFER, D3D_SIT_TBUFFER, D3D_SIT_TEXTURE, D3D_SIT_SAMPLER, D3D_SIT_UAV_RWTYPED, D3D_SIT_STRUCTURED, D3D_SIT_UAV_RWSTRUCTURED, D3D_SIT_BYTEADDRESS, D3D_SIT_UAV_RWBYTEADDRESS, D3D_SIT_UAV_APPEND_STRUCTURED, D3D_SIT_UAV_CONSUME_STRUCTURED, D3D_SIT_UAV_RWSTRUCTURED_WITH_COUNTER, D3D_SIT_RTACCELERATIONSTRUCTURE };
+enum D3D_SRV_DIMENSION { D3D_SRV_DIMENSION_UNKNOWN };
+enum D3D_RESOURCE_RETURN_TYPE { D3D_RETURN_TYPE_UNORM = 1 };
+struct D3D12_SHADER_DESC { UINT Version; LPCSTR Creator; UINT Flags; UINT ConstantBuffers; UINT BoundResources; UINT InputParameters; UINT OutputParameters; };
+struct D3D12_SHADER_INPUT_BIND_DESC { LPCSTR Name; D3D_SHADER_INPUT_TYPE Type; UINT BindPoint; UINT BindCount; UINT uFlags; D3D_RESOURCE_RETURN_TYPE ReturnType; D3D_SRV_DIMENSION Dimension; UINT NumSamples; UINT Space; UINT uID; };
+struct D3D12_SHADER_BUFFER_DESC { LPCSTR Name; UINT Type; UINT Variables; UINT Size; UINT uFlags; };
+struct ID3D12ShaderReflectionConstantBuffer { virtual HRESULT GetDesc(D3D12_SHADER_BUFFER_DESC*) { return {}; } };
+struct ID3D12ShaderReflection : IUnknown { virtual HRESULT GetDesc(D3D12_SHADER_DESC*) { return {}; } virtual HRESULT GetResourceBindingDesc(UINT, D3D12_SHADER_INPUT_BIND_DESC*) { return {}; } virtual ID3D12ShaderReflectionConstantBuffer* GetConstantBufferByName(LPCSTR) { return {}; } virtual ID3D12ShaderReflectionConstantBuffer* GetConstantBufferByIndex(UINT) { return {}; } };
+HRESULT D3DReflect(const void*, SIZE_T, REFIID, void**);
+
+//	EOF
@@ -0,0 +1,7 @@
+﻿#pragma once
+
+// ヘッドレステスト用のDirectXMath互換宣言
+
+namespace DirectX { struct XMFLOAT4X4 { float m[4][4]; }; struct XMFLOAT4 { float x,y,z,w; }; struct XMFLOAT3 { float x,y,z; }; struct XMFLOAT2 { float x,y; }; }
+
+//	EOF
@@ -0,0 +1,16 @@
+﻿#pragma once
+#include "dxgiformat.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// ヘッドレステスト用のDirectXTex互換宣言
+
+namespace DirectX {
+enum TEX_DIMENSION { TEX_DIMENSION_TEXTURE1D=2, TEX_DIMENSION_TEXTURE2D, TEX_DIMENSION_TEXTURE3D };
+struct TexMetadata { size_t width, height, depth, arraySize, mipLevels; DXGI_FORMAT format; TEX_DIMENSION dimension; };
+struct Image { size_t width, height; DXGI_FORMAT format; size_t rowPitch, slicePitch; uint8_t* pixels; };
+class ScratchImage { public: const TexMetadata& GetMetadata() const; const Image* GetImage(size_t mip, size_t item, size_t slice) const; };
+HRESULT LoadFromTGAMemory(const void*, size_t, TexMetadata*, ScratchImage&);
+}
+
+//	EOF
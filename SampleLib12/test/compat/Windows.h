@@ -0,0 +1,69 @@
+﻿#pragma once
+
+// ヘッドレステスト用のWin32互換宣言. 実装はcompat.cpp
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+typedef int BOOL; typedef unsigned int UINT; typedef uint8_t UINT8; typedef uint16_t UINT16; typedef uint32_t UINT32; typedef uint64_t UINT64;
+typedef long LONG; typedef unsigned long ULONG; typedef unsigned long DWORD; typedef int INT; typedef float FLOAT; typedef long HRESULT; typedef size_t SIZE_T;
+typedef void* HANDLE; typedef void* HWND; typedef void* HINSTANCE; typedef const wchar_t* LPCWSTR; typedef wchar_t* LPWSTR; typedef const char* LPCSTR; typedef char* LPSTR;
+typedef uintptr_t WPARAM; typedef intptr_t LPARAM; typedef intptr_t LRESULT; typedef unsigned char BYTE; typedef int64_t LONGLONG; typedef uint64_t ULONGLONG;
+typedef intptr_t LONG_PTR;
+typedef wchar_t WCHAR; typedef void* LPVOID; typedef const void* LPCVOID; typedef unsigned short WORD;
+union LARGE_INTEGER { struct { DWORD LowPart; LONG HighPart; } u; LONGLONG QuadPart; };
+struct LUID { DWORD LowPart; LONG HighPart; };
+struct RECT { LONG left, top, right, bottom; };
+struct GUID { uint32_t a; };
+typedef GUID IID; typedef const IID& REFIID;
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define S_OK 0
+#define E_FAIL ((HRESULT)0x80004005L)
+#define E_INVALIDARG ((HRESULT)0x80070057L)
+#define TRUE 1
+#define FALSE 0
+#define INFINITE 0xFFFFFFFF
+#define EVENT_ALL_ACCESS 0x1F0003
+#define WINAPI
+#define CALLBACK
+#define STDMETHODCALLTYPE
+#define ARRAYSIZE(a) (sizeof(a)/sizeof((a)[0]))
+#define _countof(a) (sizeof(a)/sizeof((a)[0]))
+#define __uuidof(x) GUID{0}
+#define IID_PPV_ARGS(pp) GUID{0}, reinterpret_cast<void**>(pp)
+#define INVALID_HANDLE_VALUE ((HANDLE)(intptr_t)-1)
+#define MAX_PATH 260
+// 偽オブジェクトはnewで生成し、参照カウントが0になった時点で破棄する
+struct IUnknown
+{
+	virtual ~IUnknown() {}
+	virtual ULONG AddRef() { return ++refCount_; }
+	virtual ULONG Release() { ULONG c = --refCount_; if (c == 0) delete this; return c; }
+	virtual HRESULT QueryInterface(REFIID, void**) { return E_FAIL; }
+	ULONG refCount_ = 1;
+};
+HANDLE CreateEventEx(void*, void*, DWORD, DWORD);
+DWORD WaitForSingleObject(HANDLE, DWORD);
+BOOL CloseHandle(HANDLE);
+void OutputDebugStringA(LPCSTR);
+void OutputDebugStringW(LPCWSTR);
+DWORD GetLastError();
+void Sleep(DWORD);
+#include <cstdio>
+template<size_t N, typename... A> inline int sprintf_s(char (&b)[N], const char* f, A... a){ return snprintf(b, N, f, a...); }
+#define GENERIC_READ 0x80000000
+#define FILE_SHARE_READ 1
+#define OPEN_EXISTING 3
+#define FILE_ATTRIBUTE_NORMAL 0x80
+#define PAGE_READONLY 2
+#define FILE_MAP_READ 4
+HANDLE CreateFileA(LPCSTR, DWORD, DWORD, void*, DWORD, DWORD, HANDLE);
+BOOL GetFileSizeEx(HANDLE, LARGE_INTEGER*);
+HANDLE CreateFileMappingA(HANDLE, void*, DWORD, DWORD, DWORD, LPCSTR);
+void* MapViewOfFile(HANDLE, DWORD, DWORD, DWORD, SIZE_T);
+BOOL UnmapViewOfFile(const void*);
+
+//	EOF
@@ -0,0 +1,199 @@
+﻿#include <Windows.h>
+#include <d3d12.h>
+#include <dxgi1_4.h>
+#include <D3Dcompiler.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace
+{
+	// Win32ハンドルの代わり. ファイルとファイルマッピングはファイルディスクリプタを保持する
+	struct CompatHandle
+	{
+		enum Kind { Event, File, Mapping };
+
+		Kind	kind;
+		int		fd;
+	};
+
+	CompatHandle	g_event = { CompatHandle::Event, -1 };
+
+	// UnmapViewOfFile()に渡すため、マップした領域のサイズを保持する
+	std::mutex							g_viewMutex;
+	std::unordered_map<const void*, size_t>	g_views;
+
+	// D3D12SerializeRootSignature(), D3DCreateBlob()用のメモリブロブ
+	struct CompatBlob : ID3DBlob
+	{
+		std::vector<BYTE>	data;
+
+		void* GetBufferPointer() override { return data.data(); }
+		SIZE_T GetBufferSize() override { return data.size(); }
+	};
+}
+
+//----
+// 同期オブジェクト
+// 偽のフェンスはSetEventOnCompletion()の中で完了させるので、待機は即座に戻る
+//----
+HANDLE CreateEventEx(void*, void*, DWORD, DWORD)
+{
+	return &g_event;
+}
+DWORD WaitForSingleObject(HANDLE, DWORD)
+{
+	return 0;
+}
+BOOL CloseHandle(HANDLE h)
+{
+	auto p = static_cast<CompatHandle*>(h);
+	if (!p || h == INVALID_HANDLE_VALUE || p->kind == CompatHandle::Event)
+	{
+		return TRUE;
+	}
+	close(p->fd);
+	delete p;
+	return TRUE;
+}
+void Sleep(DWORD ms)
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+DWORD GetLastError()
+{
+	return 0;
+}
+
+//----
+// デバッグ出力. 環境変数SL12_TEST_VERBOSEが設定されている場合のみ標準エラーに出力する
+//----
+void OutputDebugStringA(LPCSTR str)
+{
+	static const bool s_verbose = getenv("SL12_TEST_VERBOSE") != nullptr;
+	if (s_verbose)
+	{
+		fputs(str, stderr);
+	}
+}
+void OutputDebugStringW(LPCWSTR)
+{
+}
+
+//----
+// ファイルマッピング. 読み込み専用のみ対応する
+//----
+HANDLE CreateFileA(LPCSTR filename, DWORD, DWORD, void*, DWORD, DWORD, HANDLE)
+{
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+	{
+		return INVALID_HANDLE_VALUE;
+	}
+	return new CompatHandle{ CompatHandle::File, fd };
+}
+BOOL GetFileSizeEx(HANDLE h, LARGE_INTEGER* pSize)
+{
+	struct stat st;
+	if (fstat(static_cast<CompatHandle*>(h)->fd, &st) != 0)
+	{
+		return FALSE;
+	}
+	pSize->QuadPart = st.st_size;
+	return TRUE;
+}
+HANDLE CreateFileMappingA(HANDLE h, void*, DWORD, DWORD, DWORD, LPCSTR)
+{
+	int fd = dup(static_cast<CompatHandle*>(h)->fd);
+	if (fd < 0)
+	{
+		return nullptr;
+	}
+	return new CompatHandle{ CompatHandle::Mapping, fd };
+}
+void* MapViewOfFile(HANDLE h, DWORD, DWORD, DWORD, SIZE_T)
+{
+	int fd = static_cast<CompatHandle*>(h)->fd;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		return nullptr;
+	}
+	void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (p == MAP_FAILED)
+	{
+		return nullptr;
+	}
+	std::lock_guard<std::mutex> lock(g_viewMutex);
+	g_views[p] = static_cast<size_t>(st.st_size);
+	return p;
+}
+BOOL UnmapViewOfFile(const void* p)
+{
+	std::lock_guard<std::mutex> lock(g_viewMutex);
+	auto it = g_views.find(p);
+	if (it == g_views.end())
+	{
+		return FALSE;
+	}
+	munmap(const_cast<void*>(p), it->second);
+	g_views.erase(it);
+	return TRUE;
+}
+
+//----
+// D3D12, DXGI
+// デバイスとファクトリは生成できない. テストでは偽のデバイスを直接設定すること
+//----
+HRESULT D3D12GetDebugInterface(REFIID, void**)
+{
+	return E_FAIL;
+}
+HRESULT D3D12CreateDevice(IUnknown*, D3D_FEATURE_LEVEL, REFIID, void**)
+{
+	return E_FAIL;
+}
+HRESULT CreateDXGIFactory2(UINT, REFIID, void**)
+{
+	return E_FAIL;
+}
+HRESULT D3DReflect(const void*, SIZE_T, REFIID, void**)
+{
+	return E_FAIL;
+}
+HRESULT D3DCreateBlob(SIZE_T size, ID3DBlob** ppBlob)
+{
+	auto p = new CompatBlob();
+	p->data.resize(size);
+	*ppBlob = p;
+	return S_OK;
+}
+
+//----
+// ルートシグネチャのシリアライズ
+// 内容は検証しないので、パラメータ数とサンプラー数のみを書き込む
+//----
+HRESULT D3D12SerializeRootSignature(const D3D12_ROOT_SIGNATURE_DESC* pDesc, D3D_ROOT_SIGNATURE_VERSION, ID3DBlob** ppBlob, ID3DBlob** ppError)
+{
+	if (ppError)
+	{
+		*ppError = nullptr;
+	}
+	auto p = new CompatBlob();
+	p->data.resize(sizeof(UINT) * 2);
+	memcpy(p->data.data(), &pDesc->NumParameters, sizeof(UINT));
+	memcpy(p->data.data() + sizeof(UINT), &pDesc->NumStaticSamplers, sizeof(UINT));
+	*ppBlob = p;
+	return S_OK;
+}
+
+//	EOF
@@ -0,0 +1,223 @@
+﻿#pragma once
+
+// ヘッドレステスト用のD3D12互換宣言. 仮想関数は既定で何もしないので、偽オブジェクトは必要な関数のみをオーバーライドする
+
+#include "Windows.h"
+#include "dxgiformat.h"
+enum D3D12_DESCRIPTOR_HEAP_TYPE { D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, D3D12_DESCRIPTOR_HEAP_TYPE_DSV, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES };
+enum D3D12_DESCRIPTOR_HEAP_FLAGS { D3D12_DESCRIPTOR_HEAP_FLAG_NONE = 0, D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE = 1 };
+struct D3D12_DESCRIPTOR_HEAP_DESC { D3D12_DESCRIPTOR_HEAP_TYPE Type; UINT NumDescriptors; D3D12_DESCRIPTOR_HEAP_FLAGS Flags; UINT NodeMask; };
+struct D3D12_CPU_DESCRIPTOR_HANDLE { SIZE_T ptr; };
+struct D3D12_GPU_DESCRIPTOR_HANDLE { UINT64 ptr; };
+typedef UINT64 D3D12_GPU_VIRTUAL_ADDRESS;
+enum D3D12_COMMAND_LIST_TYPE { D3D12_COMMAND_LIST_TYPE_DIRECT, D3D12_COMMAND_LIST_TYPE_BUNDLE, D3D12_COMMAND_LIST_TYPE_COMPUTE, D3D12_COMMAND_LIST_TYPE_COPY };
+enum D3D12_COMMAND_QUEUE_PRIORITY { D3D12_COMMAND_QUEUE_PRIORITY_NORMAL = 0, D3D12_COMMAND_QUEUE_PRIORITY_HIGH = 100 };
+enum D3D12_FENCE_FLAGS { D3D12_FENCE_FLAG_NONE };
+enum D3D12_RESOURCE_STATES { D3D12_RESOURCE_STATE_COMMON = 0, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER = 1, D3D12_RESOURCE_STATE_INDEX_BUFFER = 2, D3D12_RESOURCE_STATE_RENDER_TARGET = 4, D3D12_RESOURCE_STATE_UNORDERED_ACCESS = 8, D3D12_RESOURCE_STATE_DEPTH_WRITE = 0x10, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE = 0x40, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE = 0x80, D3D12_RESOURCE_STATE_COPY_DEST = 0x400, D3D12_RESOURCE_STATE_COPY_SOURCE = 0x800, D3D12_RESOURCE_STATE_GENERIC_READ = 0xac3, D3D12_RESOURCE_STATE_PRESENT = 0, D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE = 0x400000 };
+inline D3D12_RESOURCE_STATES operator|(D3D12_RESOURCE_STATES a, D3D12_RESOURCE_STATES b) { return (D3D12_RESOURCE_STATES)((int)a | (int)b); }
+enum D3D12_HEAP_TYPE { D3D12_HEAP_TYPE_DEFAULT = 1, D3D12_HEAP_TYPE_UPLOAD, D3D12_HEAP_TYPE_READBACK };
+enum D3D12_CPU_PAGE_PROPERTY { D3D12_CPU_PAGE_PROPERTY_UNKNOWN };
+enum D3D12_MEMORY_POOL { D3D12_MEMORY_POOL_UNKNOWN };
+enum D3D12_HEAP_FLAGS { D3D12_HEAP_FLAG_NONE };
+struct D3D12_HEAP_PROPERTIES { D3D12_HEAP_TYPE Type; D3D12_CPU_PAGE_PROPERTY CPUPageProperty; D3D12_MEMORY_POOL MemoryPoolPreference; UINT CreationNodeMask; UINT VisibleNodeMask; };
+enum D3D12_RESOURCE_DIMENSION { D3D12_RESOURCE_DIMENSION_UNKNOWN, D3D12_RESOURCE_DIMENSION_BUFFER, D3D12_RESOURCE_DIMENSION_TEXTURE1D, D3D12_RESOURCE_DIMENSION_TEXTURE2D, D3D12_RESOURCE_DIMENSION_TEXTURE3D };
+enum D3D12_TEXTURE_LAYOUT { D3D12_TEXTURE_LAYOUT_UNKNOWN, D3D12_TEXTURE_LAYOUT_ROW_MAJOR };
+enum D3D12_RESOURCE_FLAGS { D3D12_RESOURCE_FLAG_NONE = 0, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET = 1, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL = 2, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS = 4 };
+struct DXGI_SAMPLE_DESC { UINT Count; UINT Quality; };
+struct D3D12_RESOURCE_DESC { D3D12_RESOURCE_DIMENSION Dimension; UINT64 Alignment; UINT64 Width; UINT Height; UINT16 DepthOrArraySize; UINT16 MipLevels; DXGI_FORMAT Format; DXGI_SAMPLE_DESC SampleDesc; D3D12_TEXTURE_LAYOUT Layout; D3D12_RESOURCE_FLAGS Flags; };
+struct D3D12_RANGE { SIZE_T Begin; SIZE_T End; };
+struct D3D12_CLEAR_VALUE { DXGI_FORMAT Format; FLOAT Color[4]; };
+struct D3D12_CONSTANT_BUFFER_VIEW_DESC { D3D12_GPU_VIRTUAL_ADDRESS BufferLocation; UINT SizeInBytes; };
+enum D3D12_SRV_DIMENSION { D3D12_SRV_DIMENSION_UNKNOWN, D3D12_SRV_DIMENSION_BUFFER, D3D12_SRV_DIMENSION_TEXTURE1D, D3D12_SRV_DIMENSION_TEXTURE1DARRAY, D3D12_SRV_DIMENSION_TEXTURE2D, D3D12_SRV_DIMENSION_TEXTURE2DARRAY, D3D12_SRV_DIMENSION_TEXTURE2DMS, D3D12_SRV_DIMENSION_TEXTURE2DMSARRAY, D3D12_SRV_DIMENSION_TEXTURE3D, D3D12_SRV_DIMENSION_TEXTURECUBE, D3D12_SRV_DIMENSION_TEXTURECUBEARRAY, D3D12_SRV_DIMENSION_RAYTRACING_ACCELERATION_STRUCTURE };
+enum D3D12_BUFFER_SRV_FLAGS { D3D12_BUFFER_SRV_FLAG_NONE, D3D12_BUFFER_SRV_FLAG_RAW };
+struct D3D12_BUFFER_SRV { UINT64 FirstElement; UINT NumElements; UINT StructureByteStride; D3D12_BUFFER_SRV_FLAGS Flags; };
+struct D3D12_TEX2D_SRV { UINT MostDetailedMip; UINT MipLevels; UINT PlaneSlice; FLOAT ResourceMinLODClamp; };
+struct D3D12_SHADER_RESOURCE_VIEW_DESC { DXGI_FORMAT Format; D3D12_SRV_DIMENSION ViewDimension; UINT Shader4ComponentMapping; union { D3D12_BUFFER_SRV Buffer; D3D12_TEX2D_SRV Texture2D; }; };
+#define D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING 0x1688
+enum D3D12_UAV_DIMENSION { D3D12_UAV_DIMENSION_UNKNOWN, D3D12_UAV_DIMENSION_BUFFER, D3D12_UAV_DIMENSION_TEXTURE1D, D3D12_UAV_DIMENSION_TEXTURE1DARRAY, D3D12_UAV_DIMENSION_TEXTURE2D, D3D12_UAV_DIMENSION_TEXTURE2DARRAY, D3D12_UAV_DIMENSION_TEXTURE3D = 8 };
+enum D3D12_BUFFER_UAV_FLAGS { D3D12_BUFFER_UAV_FLAG_NONE, D3D12_BUFFER_UAV_FLAG_RAW };
+struct D3D12_BUFFER_UAV { UINT64 FirstElement; UINT NumElements; UINT StructureByteStride; UINT64 CounterOffsetInBytes; D3D12_BUFFER_UAV_FLAGS Flags; };
+struct D3D12_TEX2D_UAV { UINT MipSlice; UINT PlaneSlice; };
+struct D3D12_UNORDERED_ACCESS_VIEW_DESC { DXGI_FORMAT Format; D3D12_UAV_DIMENSION ViewDimension; union { D3D12_BUFFER_UAV Buffer; D3D12_TEX2D_UAV Texture2D; }; };
+struct D3D12_TEX2D_RTV { UINT MipSlice; UINT PlaneSlice; };
+enum D3D12_RTV_DIMENSION { D3D12_RTV_DIMENSION_UNKNOWN, D3D12_RTV_DIMENSION_TEXTURE2D = 4 };
+struct D3D12_RENDER_TARGET_VIEW_DESC { DXGI_FORMAT Format; D3D12_RTV_DIMENSION ViewDimension; union { D3D12_TEX2D_RTV Texture2D; }; };
+enum D3D12_DSV_DIMENSION { D3D12_DSV_DIMENSION_UNKNOWN, D3D12_DSV_DIMENSION_TEXTURE2D = 3 };
+struct D3D12_TEX2D_DSV { UINT MipSlice; };
+struct D3D12_DEPTH_STENCIL_VIEW_DESC { DXGI_FORMAT Format; D3D12_DSV_DIMENSION ViewDimension; UINT Flags; union { D3D12_TEX2D_DSV Texture2D; }; };
+enum D3D12_FILTER { D3D12_FILTER_MIN_MAG_MIP_POINT = 0, D3D12_FILTER_MIN_MAG_MIP_LINEAR = 0x15, D3D12_FILTER_ANISOTROPIC = 0x55 };
+enum D3D12_TEXTURE_ADDRESS_MODE { D3D12_TEXTURE_ADDRESS_MODE_WRAP = 1, D3D12_TEXTURE_ADDRESS_MODE_MIRROR, D3D12_TEXTURE_ADDRESS_MODE_CLAMP, D3D12_TEXTURE_ADDRESS_MODE_BORDER };
+enum D3D12_COMPARISON_FUNC { D3D12_COMPARISON_FUNC_NEVER = 1, D3D12_COMPARISON_FUNC_LESS, D3D12_COMPARISON_FUNC_EQUAL, D3D12_COMPARISON_FUNC_LESS_EQUAL, D3D12_COMPARISON_FUNC_GREATER, D3D12_COMPARISON_FUNC_NOT_EQUAL, D3D12_COMPARISON_FUNC_GREATER_EQUAL, D3D12_COMPARISON_FUNC_ALWAYS };
+struct D3D12_SAMPLER_DESC { D3D12_FILTER Filter; D3D12_TEXTURE_ADDRESS_MODE AddressU, AddressV, AddressW; FLOAT MipLODBias; UINT MaxAnisotropy; D3D12_COMPARISON_FUNC ComparisonFunc; FLOAT BorderColor[4]; FLOAT MinLOD; FLOAT MaxLOD; };
+enum D3D12_STATIC_BORDER_COLOR { D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK, D3D12_STATIC_BORDER_COLOR_OPAQUE_BLACK, D3D12_STATIC_BORDER_COLOR_OPAQUE_WHITE };
+enum D3D12_SHADER_VISIBILITY { D3D12_SHADER_VISIBILITY_ALL, D3D12_SHADER_VISIBILITY_VERTEX, D3D12_SHADER_VISIBILITY_HULL, D3D12_SHADER_VISIBILITY_DOMAIN, D3D12_SHADER_VISIBILITY_GEOMETRY, D3D12_SHADER_VISIBILITY_PIXEL };
+struct D3D12_STATIC_SAMPLER_DESC { D3D12_FILTER Filter; D3D12_TEXTURE_ADDRESS_MODE AddressU, AddressV, AddressW; FLOAT MipLODBias; UINT MaxAnisotropy; D3D12_COMPARISON_FUNC ComparisonFunc; D3D12_STATIC_BORDER_COLOR BorderColor; FLOAT MinLOD; FLOAT MaxLOD; UINT ShaderRegister; UINT RegisterSpace; D3D12_SHADER_VISIBILITY ShaderVisibility; };
+#define D3D12_DEFAULT_DEPTH_BIAS 0
+#define D3D12_DEFAULT_DEPTH_BIAS_CLAMP 0.0f
+#define D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS 0.0f
+#define D3D12_FLOAT32_MAX 3.402823466e+38f
+enum D3D12_DESCRIPTOR_RANGE_TYPE { D3D12_DESCRIPTOR_RANGE_TYPE_SRV, D3D12_DESCRIPTOR_RANGE_TYPE_UAV, D3D12_DESCRIPTOR_RANGE_TYPE_CBV, D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER };
+#define D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND 0xffffffff
+struct D3D12_DESCRIPTOR_RANGE { D3D12_DESCRIPTOR_RANGE_TYPE RangeType; UINT NumDescriptors; UINT BaseShaderRegister; UINT RegisterSpace; UINT OffsetInDescriptorsFromTableStart; };
+struct D3D12_ROOT_DESCRIPTOR_TABLE { UINT NumDescriptorRanges; const D3D12_DESCRIPTOR_RANGE* pDescriptorRanges; };
+struct D3D12_ROOT_CONSTANTS { UINT ShaderRegister; UINT RegisterSpace; UINT Num32BitValues; };
+struct D3D12_ROOT_DESCRIPTOR { UINT ShaderRegister; UINT RegisterSpace; };
+enum D3D12_ROOT_PARAMETER_TYPE { D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE, D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS, D3D12_ROOT_PARAMETER_TYPE_CBV, D3D12_ROOT_PARAMETER_TYPE_SRV, D3D12_ROOT_PARAMETER_TYPE_UAV };
+struct D3D12_ROOT_PARAMETER { D3D12_ROOT_PARAMETER_TYPE ParameterType; union { D3D12_ROOT_DESCRIPTOR_TABLE DescriptorTable; D3D12_ROOT_CONSTANTS Constants; D3D12_ROOT_DESCRIPTOR Descriptor; }; D3D12_SHADER_VISIBILITY ShaderVisibility; };
+enum D3D12_ROOT_SIGNATURE_FLAGS { D3D12_ROOT_SIGNATURE_FLAG_NONE = 0, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT = 1, D3D12_ROOT_SIGNATURE_FLAG_LOCAL_ROOT_SIGNATURE = 0x80 };
+struct D3D12_ROOT_SIGNATURE_DESC { UINT NumParameters; const D3D12_ROOT_PARAMETER* pParameters; UINT NumStaticSamplers; const D3D12_STATIC_SAMPLER_DESC* pStaticSamplers; D3D12_ROOT_SIGNATURE_FLAGS Flags; };
+enum D3D_ROOT_SIGNATURE_VERSION { D3D_ROOT_SIGNATURE_VERSION_1 = 1 };
+enum D3D_FEATURE_LEVEL { D3D_FEATURE_LEVEL_11_0 = 0xb000 };
+enum D3D_PRIMITIVE_TOPOLOGY { D3D_PRIMITIVE_TOPOLOGY_UNDEFINED, D3D_PRIMITIVE_TOPOLOGY_POINTLIST, D3D_PRIMITIVE_TOPOLOGY_LINELIST, D3D_PRIMITIVE_TOPOLOGY_LINESTRIP, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST, D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP, D3D_PRIMITIVE_TOPOLOGY_LINELIST_ADJ = 10, D3D_PRIMITIVE_TOPOLOGY_LINESTRIP_ADJ, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST_ADJ, D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP_ADJ, D3D_PRIMITIVE_TOPOLOGY_1_CONTROL_POINT_PATCHLIST = 33 };
+typedef D3D_PRIMITIVE_TOPOLOGY D3D12_PRIMITIVE_TOPOLOGY;
+#define D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT ( 32 )
+#define D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE ( 16 )
+#define D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT ( 8 )
+enum D3D12_PRIMITIVE_TOPOLOGY_TYPE { D3D12_PRIMITIVE_TOPOLOGY_TYPE_UNDEFINED, D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT, D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE, D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE, D3D12_PRIMITIVE_TOPOLOGY_TYPE_PATCH };
+enum D3D12_BLEND { D3D12_BLEND_ZERO = 1, D3D12_BLEND_ONE, D3D12_BLEND_SRC_COLOR, D3D12_BLEND_INV_SRC_COLOR, D3D12_BLEND_SRC_ALPHA, D3D12_BLEND_INV_SRC_ALPHA, D3D12_BLEND_DEST_ALPHA, D3D12_BLEND_INV_DEST_ALPHA, D3D12_BLEND_DEST_COLOR };
+enum D3D12_BLEND_OP { D3D12_BLEND_OP_ADD = 1, D3D12_BLEND_OP_SUBTRACT };
+enum D3D12_LOGIC_OP { D3D12_LOGIC_OP_CLEAR, D3D12_LOGIC_OP_SET, D3D12_LOGIC_OP_COPY, D3D12_LOGIC_OP_COPY_INVERTED, D3D12_LOGIC_OP_NOOP };
+struct D3D12_RENDER_TARGET_BLEND_DESC { BOOL BlendEnable; BOOL LogicOpEnable; D3D12_BLEND SrcBlend; D3D12_BLEND DestBlend; D3D12_BLEND_OP BlendOp; D3D12_BLEND SrcBlendAlpha; D3D12_BLEND DestBlendAlpha; D3D12_BLEND_OP BlendOpAlpha; D3D12_LOGIC_OP LogicOp; UINT8 RenderTargetWriteMask; };
+struct D3D12_BLEND_DESC { BOOL AlphaToCoverageEnable; BOOL IndependentBlendEnable; D3D12_RENDER_TARGET_BLEND_DESC RenderTarget[8]; };
+enum D3D12_FILL_MODE { D3D12_FILL_MODE_WIREFRAME = 2, D3D12_FILL_MODE_SOLID = 3 };
+enum D3D12_CULL_MODE { D3D12_CULL_MODE_NONE = 1, D3D12_CULL_MODE_FRONT, D3D12_CULL_MODE_BACK };
+enum D3D12_CONSERVATIVE_RASTERIZATION_MODE { D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF, D3D12_CONSERVATIVE_RASTERIZATION_MODE_ON };
+struct D3D12_RASTERIZER_DESC { D3D12_FILL_MODE FillMode; D3D12_CULL_MODE CullMode; BOOL FrontCounterClockwise; INT DepthBias; FLOAT DepthBiasClamp; FLOAT SlopeScaledDepthBias; BOOL DepthClipEnable; BOOL MultisampleEnable; BOOL AntialiasedLineEnable; UINT ForcedSampleCount; D3D12_CONSERVATIVE_RASTERIZATION_MODE ConservativeRaster; };
+enum D3D12_STENCIL_OP { D3D12_STENCIL_OP_KEEP = 1, D3D12_STENCIL_OP_ZERO, D3D12_STENCIL_OP_REPLACE };
+struct D3D12_DEPTH_STENCILOP_DESC { D3D12_STENCIL_OP StencilFailOp; D3D12_STENCIL_OP StencilDepthFailOp; D3D12_STENCIL_OP StencilPassOp; D3D12_COMPARISON_FUNC StencilFunc; };
+enum D3D12_DEPTH_WRITE_MASK { D3D12_DEPTH_WRITE_MASK_ZERO, D3D12_DEPTH_WRITE_MASK_ALL };
+struct D3D12_DEPTH_STENCIL_DESC { BOOL DepthEnable; D3D12_DEPTH_WRITE_MASK DepthWriteMask; D3D12_COMPARISON_FUNC DepthFunc; BOOL StencilEnable; UINT8 StencilReadMask; UINT8 StencilWriteMask; D3D12_DEPTH_STENCILOP_DESC FrontFace; D3D12_DEPTH_STENCILOP_DESC BackFace; };
+enum D3D12_INPUT_CLASSIFICATION { D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA };
+struct D3D12_INPUT_ELEMENT_DESC { LPCSTR SemanticName; UINT SemanticIndex; DXGI_FORMAT Format; UINT InputSlot; UINT AlignedByteOffset; D3D12_INPUT_CLASSIFICATION InputSlotClass; UINT InstanceDataStepRate; };
+struct D3D12_INPUT_LAYOUT_DESC { const D3D12_INPUT_ELEMENT_DESC* pInputElementDescs; UINT NumElements; };
+struct D3D12_SHADER_BYTECODE { const void* pShaderBytecode; SIZE_T BytecodeLength; };
+struct D3D12_STREAM_OUTPUT_DESC { const void* p; UINT n; const UINT* s; UINT ns; UINT r; };
+struct D3D12_CACHED_PIPELINE_STATE { const void* pCachedBlob; SIZE_T CachedBlobSizeInBytes; };
+enum D3D12_PIPELINE_STATE_FLAGS { D3D12_PIPELINE_STATE_FLAG_NONE };
+enum D3D12_INDEX_BUFFER_STRIP_CUT_VALUE { D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED };
+struct D3D12_GRAPHICS_PIPELINE_STATE_DESC { struct ID3D12RootSignature* pRootSignature; D3D12_SHADER_BYTECODE VS, PS, DS, HS, GS; D3D12_STREAM_OUTPUT_DESC StreamOutput; D3D12_BLEND_DESC BlendState; UINT SampleMask; D3D12_RASTERIZER_DESC RasterizerState; D3D12_DEPTH_STENCIL_DESC DepthStencilState; D3D12_INPUT_LAYOUT_DESC InputLayout; D3D12_INDEX_BUFFER_STRIP_CUT_VALUE IBStripCutValue; D3D12_PRIMITIVE_TOPOLOGY_TYPE PrimitiveTopologyType; UINT NumRenderTargets; DXGI_FORMAT RTVFormats[8]; DXGI_FORMAT DSVFormat; DXGI_SAMPLE_DESC SampleDesc; UINT NodeMask; D3D12_CACHED_PIPELINE_STATE CachedPSO; D3D12_PIPELINE_STATE_FLAGS Flags; };
+struct D3D12_COMPUTE_PIPELINE_STATE_DESC { struct ID3D12RootSignature* pRootSignature; D3D12_SHADER_BYTECODE CS; UINT NodeMask; D3D12_CACHED_PIPELINE_STATE CachedPSO; D3D12_PIPELINE_STATE_FLAGS Flags; };
+#define D3D12_COLOR_WRITE_ENABLE_ALL 15
+struct D3D12_VERTEX_BUFFER_VIEW { D3D12_GPU_VIRTUAL_ADDRESS BufferLocation; UINT SizeInBytes; UINT StrideInBytes; };
+struct D3D12_INDEX_BUFFER_VIEW { D3D12_GPU_VIRTUAL_ADDRESS BufferLocation; UINT SizeInBytes; DXGI_FORMAT Format; };
+struct D3D12_VIEWPORT { FLOAT TopLeftX, TopLeftY, Width, Height, MinDepth, MaxDepth; };
+typedef RECT D3D12_RECT;
+enum D3D12_RESOURCE_BARRIER_TYPE { D3D12_RESOURCE_BARRIER_TYPE_TRANSITION, D3D12_RESOURCE_BARRIER_TYPE_ALIASING, D3D12_RESOURCE_BARRIER_TYPE_UAV };
+enum D3D12_RESOURCE_BARRIER_FLAGS { D3D12_RESOURCE_BARRIER_FLAG_NONE };
+struct D3D12_RESOURCE_TRANSITION_BARRIER { struct ID3D12Resource* pResource; UINT Subresource; D3D12_RESOURCE_STATES StateBefore; D3D12_RESOURCE_STATES StateAfter; };
+struct D3D12_RESOURCE_UAV_BARRIER { struct ID3D12Resource* pResource; };
+struct D3D12_RESOURCE_BARRIER { D3D12_RESOURCE_BARRIER_TYPE Type; D3D12_RESOURCE_BARRIER_FLAGS Flags; union { D3D12_RESOURCE_TRANSITION_BARRIER Transition; D3D12_RESOURCE_UAV_BARRIER UAV; }; };
+#define D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES 0xffffffff
+struct D3D12_SUBRESOURCE_FOOTPRINT { DXGI_FORMAT Format; UINT Width; UINT Height; UINT Depth; UINT RowPitch; };
+struct D3D12_PLACED_SUBRESOURCE_FOOTPRINT { UINT64 Offset; D3D12_SUBRESOURCE_FOOTPRINT Footprint; };
+struct D3D12_SUBRESOURCE_DATA { const void* pData; LONG_PTR RowPitch; LONG_PTR SlicePitch; };
+enum D3D12_TEXTURE_COPY_TYPE { D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX, D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT };
+struct D3D12_TEXTURE_COPY_LOCATION { struct ID3D12Resource* pResource; D3D12_TEXTURE_COPY_TYPE Type; union { D3D12_PLACED_SUBRESOURCE_FOOTPRINT PlacedFootprint; UINT SubresourceIndex; }; };
+struct D3D12_BOX { UINT left, top, front, right, bottom, back; };
+#define D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT 256
+#define D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT 512
+#define D3D12_TEXTURE_DATA_PITCH_ALIGNMENT 256
+#define D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT 32
+#define D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT 64
+#define D3D12_RAYTRACING_MAX_SHADER_RECORD_STRIDE 4096
+#define D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES 32
+#define D3D12_MAX_ROOT_COST 64
+enum D3D12_FEATURE { D3D12_FEATURE_D3D12_OPTIONS5 = 27 };
+enum D3D12_RAYTRACING_TIER { D3D12_RAYTRACING_TIER_NOT_SUPPORTED = 0, D3D12_RAYTRACING_TIER_1_0 = 10 };
+struct D3D12_FEATURE_DATA_D3D12_OPTIONS5 { BOOL SRVOnlyTiledResourceTier3; int RenderPassesTier; D3D12_RAYTRACING_TIER RaytracingTier; };
+enum D3D12_COMMAND_QUEUE_FLAGS { D3D12_COMMAND_QUEUE_FLAG_NONE = 0, D3D12_COMMAND_QUEUE_FLAG_DISABLE_GPU_TIMEOUT = 1 };
+struct D3D12_COMMAND_QUEUE_DESC { D3D12_COMMAND_LIST_TYPE Type; INT Priority; UINT Flags; UINT NodeMask; };
+enum D3D12_STATE_SUBOBJECT_TYPE { D3D12_STATE_SUBOBJECT_TYPE_STATE_OBJECT_CONFIG, D3D12_STATE_SUBOBJECT_TYPE_GLOBAL_ROOT_SIGNATURE, D3D12_STATE_SUBOBJECT_TYPE_LOCAL_ROOT_SIGNATURE, D3D12_STATE_SUBOBJECT_TYPE_NODE_MASK, D3D12_STATE_SUBOBJECT_TYPE_DXIL_LIBRARY = 5, D3D12_STATE_SUBOBJECT_TYPE_EXISTING_COLLECTION, D3D12_STATE_SUBOBJECT_TYPE_SUBOBJECT_TO_EXPORTS_ASSOCIATION, D3D12_STATE_SUBOBJECT_TYPE_DXIL_SUBOBJECT_TO_EXPORTS_ASSOCIATION, D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_SHADER_CONFIG, D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_PIPELINE_CONFIG, D3D12_STATE_SUBOBJECT_TYPE_HIT_GROUP };
+struct D3D12_STATE_SUBOBJECT { D3D12_STATE_SUBOBJECT_TYPE Type; const void* pDesc; };
+enum D3D12_EXPORT_FLAGS { D3D12_EXPORT_FLAG_NONE };
+struct D3D12_EXPORT_DESC { LPCWSTR Name; LPCWSTR ExportToRename; D3D12_EXPORT_FLAGS Flags; };
+struct D3D12_DXIL_LIBRARY_DESC { D3D12_SHADER_BYTECODE DXILLibrary; UINT NumExports; D3D12_EXPORT_DESC* pExports; };
+enum D3D12_HIT_GROUP_TYPE { D3D12_HIT_GROUP_TYPE_TRIANGLES, D3D12_HIT_GROUP_TYPE_PROCEDURAL_PRIMITIVE };
+struct D3D12_HIT_GROUP_DESC { LPCWSTR HitGroupExport; D3D12_HIT_GROUP_TYPE Type; LPCWSTR AnyHitShaderImport; LPCWSTR ClosestHitShaderImport; LPCWSTR IntersectionShaderImport; };
+struct D3D12_RAYTRACING_SHADER_CONFIG { UINT MaxPayloadSizeInBytes; UINT MaxAttributeSizeInBytes; };
+struct D3D12_RAYTRACING_PIPELINE_CONFIG { UINT MaxTraceRecursionDepth; };
+struct D3D12_SUBOBJECT_TO_EXPORTS_ASSOCIATION { const D3D12_STATE_SUBOBJECT* pSubobjectToAssociate; UINT NumExports; LPCWSTR* pExports; };
+enum D3D12_STATE_OBJECT_TYPE { D3D12_STATE_OBJECT_TYPE_COLLECTION, D3D12_STATE_OBJECT_TYPE_RAYTRACING_PIPELINE = 3 };
+struct D3D12_STATE_OBJECT_DESC { D3D12_STATE_OBJECT_TYPE Type; UINT NumSubobjects; const D3D12_STATE_SUBOBJECT* pSubobjects; };
+struct D3D12_GPU_VIRTUAL_ADDRESS_RANGE { D3D12_GPU_VIRTUAL_ADDRESS StartAddress; UINT64 SizeInBytes; };
+struct D3D12_GPU_VIRTUAL_ADDRESS_RANGE_AND_STRIDE { D3D12_GPU_VIRTUAL_ADDRESS StartAddress; UINT64 SizeInBytes; UINT64 StrideInBytes; };
+struct D3D12_DISPATCH_RAYS_DESC { D3D12_GPU_VIRTUAL_ADDRESS_RANGE RayGenerationShaderRecord; D3D12_GPU_VIRTUAL_ADDRESS_RANGE_AND_STRIDE MissShaderTable; D3D12_GPU_VIRTUAL_ADDRESS_RANGE_AND_STRIDE HitGroupTable; D3D12_GPU_VIRTUAL_ADDRESS_RANGE_AND_STRIDE CallableShaderTable; UINT Width; UINT Height; UINT Depth; };
+#define D3D12_ERROR_ADAPTER_NOT_FOUND ((HRESULT)0x887E0001L)
+#define D3D12_ERROR_DRIVER_VERSION_MISMATCH ((HRESULT)0x887E0002L)
+#define DXGI_ERROR_UNSUPPORTED ((HRESULT)0x887A0004L)
+struct ID3DBlob : IUnknown { virtual void* GetBufferPointer() { return {}; } virtual SIZE_T GetBufferSize() { return {}; } };
+typedef ID3DBlob ID3D10Blob;
+struct ID3D12Object : IUnknown { virtual HRESULT SetName(LPCWSTR) { return {}; } };
+struct ID3D12DeviceChild : ID3D12Object {};
+struct ID3D12Pageable : ID3D12DeviceChild {};
+struct ID3D12DescriptorHeap : ID3D12Pageable { virtual D3D12_DESCRIPTOR_HEAP_DESC GetDesc() { return {}; } virtual D3D12_CPU_DESCRIPTOR_HANDLE GetCPUDescriptorHandleForHeapStart() { return {}; } virtual D3D12_GPU_DESCRIPTOR_HANDLE GetGPUDescriptorHandleForHeapStart() { return {}; } };
+struct ID3D12Resource : ID3D12Pageable { virtual HRESULT Map(UINT, const D3D12_RANGE*, void**) { return {}; } virtual void Unmap(UINT, const D3D12_RANGE*) {} virtual D3D12_RESOURCE_DESC GetDesc() { return {}; } virtual D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() { return {}; } };
+struct ID3D12RootSignature : ID3D12DeviceChild {};
+struct ID3D12PipelineState : ID3D12Pageable { virtual HRESULT GetCachedBlob(ID3DBlob**) { return {}; } };
+struct ID3D12StateObject : ID3D12Pageable {};
+struct ID3D12StateObjectProperties : IUnknown { virtual void* GetShaderIdentifier(LPCWSTR) { return {}; } };
+struct ID3D12Fence : ID3D12Pageable { virtual UINT64 GetCompletedValue() { return {}; } virtual HRESULT SetEventOnCompletion(UINT64, HANDLE) { return {}; } virtual HRESULT Signal(UINT64) { return {}; } };
+struct ID3D12CommandAllocator : ID3D12Pageable { virtual HRESULT Reset() { return {}; } };
+struct ID3D12CommandList : ID3D12DeviceChild {};
+struct ID3D12GraphicsCommandList : ID3D12CommandList {
+ virtual HRESULT Close() { return {}; } virtual HRESULT Reset(ID3D12CommandAllocator*, ID3D12PipelineState*) { return {}; }
+ virtual void DrawInstanced(UINT, UINT, UINT, UINT) {} virtual void DrawIndexedInstanced(UINT, UINT, UINT, INT, UINT) {} virtual void Dispatch(UINT, UINT, UINT) {}
+ virtual void CopyBufferRegion(ID3D12Resource*, UINT64, ID3D12Resource*, UINT64, UINT64) {}
+ virtual void CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION*, UINT, UINT, UINT, const D3D12_TEXTURE_COPY_LOCATION*, const D3D12_BOX*) {}
+ virtual void CopyResource(ID3D12Resource*, ID3D12Resource*) {}
+ virtual void IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY) {} virtual void RSSetViewports(UINT, const D3D12_VIEWPORT*) {} virtual void RSSetScissorRects(UINT, const D3D12_RECT*) {}
+ virtual void OMSetBlendFactor(const FLOAT[4]) {} virtual void OMSetStencilRef(UINT) {}
+ virtual void SetPipelineState(ID3D12PipelineState*) {} virtual void ResourceBarrier(UINT, const D3D12_RESOURCE_BARRIER*) {}
+ virtual void SetDescriptorHeaps(UINT, ID3D12DescriptorHeap* const*) {}
+ virtual void SetComputeRootSignature(ID3D12RootSignature*) {} virtual void SetGraphicsRootSignature(ID3D12RootSignature*) {}
+ virtual void SetComputeRootDescriptorTable(UINT, D3D12_GPU_DESCRIPTOR_HANDLE) {} virtual void SetGraphicsRootDescriptorTable(UINT, D3D12_GPU_DESCRIPTOR_HANDLE) {}
+ virtual void SetComputeRoot32BitConstants(UINT, UINT, const void*, UINT) {} virtual void SetGraphicsRoot32BitConstants(UINT, UINT, const void*, UINT) {}
+ virtual void SetComputeRootConstantBufferView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) {} virtual void SetGraphicsRootConstantBufferView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) {}
+ virtual void SetComputeRootShaderResourceView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) {} virtual void SetGraphicsRootShaderResourceView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) {}
+ virtual void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW*) {} virtual void IASetVertexBuffers(UINT, UINT, const D3D12_VERTEX_BUFFER_VIEW*) {}
+ virtual void OMSetRenderTargets(UINT, const D3D12_CPU_DESCRIPTOR_HANDLE*, BOOL, const D3D12_CPU_DESCRIPTOR_HANDLE*) {}
+ virtual void ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE, UINT, FLOAT, UINT8, UINT, const D3D12_RECT*) {}
+ virtual void ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE, const FLOAT[4], UINT, const D3D12_RECT*) {}
+};
+struct ID3D12GraphicsCommandList1 : ID3D12GraphicsCommandList {};
+struct ID3D12GraphicsCommandList2 : ID3D12GraphicsCommandList1 {};
+struct ID3D12GraphicsCommandList3 : ID3D12GraphicsCommandList2 {};
+struct ID3D12GraphicsCommandList4 : ID3D12GraphicsCommandList3 { virtual void SetPipelineState1(ID3D12StateObject*) {} virtual void DispatchRays(const D3D12_DISPATCH_RAYS_DESC*) {} };
+struct ID3D12CommandQueue : ID3D12Pageable { virtual void ExecuteCommandLists(UINT, ID3D12CommandList* const*) {} virtual HRESULT Signal(ID3D12Fence*, UINT64) { return {}; } virtual HRESULT Wait(ID3D12Fence*, UINT64) { return {}; } virtual HRESULT GetTimestampFrequency(UINT64*) { return E_FAIL; } };
+struct ID3D12PipelineLibrary : ID3D12DeviceChild { virtual HRESULT StorePipeline(LPCWSTR, ID3D12PipelineState*) { return {}; } virtual HRESULT LoadGraphicsPipeline(LPCWSTR, const D3D12_GRAPHICS_PIPELINE_STATE_DESC*, REFIID, void**) { return {}; } virtual HRESULT LoadComputePipeline(LPCWSTR, const D3D12_COMPUTE_PIPELINE_STATE_DESC*, REFIID, void**) { return {}; } virtual SIZE_T GetSerializedSize() { return {}; } virtual HRESULT Serialize(void*, SIZE_T) { return {}; } };
+struct ID3D12Device : ID3D12Object {
+ virtual UINT GetNodeCount() { return {}; }
+ virtual HRESULT CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC*, REFIID, void**) { return {}; }
+ virtual HRESULT CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE, REFIID, void**) { return {}; }
+ virtual HRESULT CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC*, REFIID, void**) { return {}; }
+ virtual HRESULT CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC*, REFIID, void**) { return {}; }
+ virtual HRESULT CreateCommandList(UINT, D3D12_COMMAND_LIST_TYPE, ID3D12CommandAllocator*, ID3D12PipelineState*, REFIID, void**) { return {}; }
+ virtual HRESULT CheckFeatureSupport(D3D12_FEATURE, void*, UINT) { return {}; }
+ virtual HRESULT CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC*, REFIID, void**) { return {}; }
+ virtual UINT GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE) { return {}; }
+ virtual HRESULT CreateRootSignature(UINT, const void*, SIZE_T, REFIID, void**) { return {}; }
+ virtual void CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) {}
+ virtual void CreateShaderResourceView(ID3D12Resource*, const D3D12_SHADER_RESOURCE_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) {}
+ virtual void CreateUnorderedAccessView(ID3D12Resource*, ID3D12Resource*, const D3D12_UNORDERED_ACCESS_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) {}
+ virtual void CreateRenderTargetView(ID3D12Resource*, const D3D12_RENDER_TARGET_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) {}
+ virtual void CreateDepthStencilView(ID3D12Resource*, const D3D12_DEPTH_STENCIL_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) {}
+ virtual void CreateSampler(const D3D12_SAMPLER_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) {}
+ virtual void CopyDescriptors(UINT, const D3D12_CPU_DESCRIPTOR_HANDLE*, const UINT*, UINT, const D3D12_CPU_DESCRIPTOR_HANDLE*, const UINT*, D3D12_DESCRIPTOR_HEAP_TYPE) {}
+ virtual void CopyDescriptorsSimple(UINT, D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_DESCRIPTOR_HEAP_TYPE) {}
+ virtual HRESULT CreateCommittedResource(const D3D12_HEAP_PROPERTIES*, D3D12_HEAP_FLAGS, const D3D12_RESOURCE_DESC*, D3D12_RESOURCE_STATES, const D3D12_CLEAR_VALUE*, REFIID, void**) { return {}; }
+ virtual HRESULT CreateFence(UINT64, D3D12_FENCE_FLAGS, REFIID, void**) { return {}; }
+ virtual void GetCopyableFootprints(const D3D12_RESOURCE_DESC*, UINT, UINT, UINT64, D3D12_PLACED_SUBRESOURCE_FOOTPRINT*, UINT*, UINT64*, UINT64*) {}
+ virtual LUID GetAdapterLuid() { return {}; }
+};
+struct ID3D12Device1 : ID3D12Device { virtual HRESULT CreatePipelineLibrary(const void*, SIZE_T, REFIID, void**) { return {}; } };
+struct ID3D12Device2 : ID3D12Device1 {};
+struct ID3D12Device3 : ID3D12Device2 {};
+struct ID3D12Device4 : ID3D12Device3 {};
+struct ID3D12Device5 : ID3D12Device4 { virtual HRESULT CreateStateObject(const D3D12_STATE_OBJECT_DESC*, REFIID, void**) { return {}; } };
+struct ID3D12Debug : IUnknown { virtual void EnableDebugLayer() {} };
+HRESULT D3D12GetDebugInterface(REFIID, void**);
+HRESULT D3D12CreateDevice(IUnknown*, D3D_FEATURE_LEVEL, REFIID, void**);
+HRESULT D3D12SerializeRootSignature(const D3D12_ROOT_SIGNATURE_DESC*, D3D_ROOT_SIGNATURE_VERSION, ID3DBlob**, ID3DBlob**);
+HRESULT D3DCreateBlob(SIZE_T, ID3DBlob**);
+
+//	EOF
@@ -0,0 +1,18 @@
+﻿#pragma once
+
+// ヘッドレステスト用のDXGI互換宣言
+
+#include "Windows.h"
+#include "dxgiformat.h"
+struct DXGI_ADAPTER_DESC1 { WCHAR Description[128]; UINT VendorId; UINT DeviceId; UINT SubSysId; UINT Revision; SIZE_T DedicatedVideoMemory; SIZE_T DedicatedSystemMemory; SIZE_T SharedSystemMemory; LUID AdapterLuid; UINT Flags; };
+struct IDXGIObject : IUnknown {};
+struct IDXGIDevice : IDXGIObject {};
+struct IDXGIOutput : IDXGIObject {}; struct IDXGIOutput4 : IDXGIOutput {};
+struct IDXGIAdapter : IDXGIObject { virtual HRESULT EnumOutputs(UINT, IDXGIOutput**) { return {}; } virtual HRESULT CheckInterfaceSupport(REFIID, LARGE_INTEGER*) { return {}; } };
+struct IDXGIAdapter1 : IDXGIAdapter { virtual HRESULT GetDesc1(DXGI_ADAPTER_DESC1*) { return {}; } };
+struct IDXGIAdapter2 : IDXGIAdapter1 {}; struct IDXGIAdapter3 : IDXGIAdapter2 {};
+struct IDXGIFactory4 : IDXGIObject { virtual HRESULT EnumAdapters1(UINT, IDXGIAdapter1**) { return {}; } virtual HRESULT EnumWarpAdapter(REFIID, void**) { return {}; } };
+HRESULT CreateDXGIFactory2(UINT, REFIID, void**);
+struct IDXGISwapChain3;
+
+//	EOF
@@ -0,0 +1,346 @@
+﻿#pragma once
+
+#include <Windows.h>
+#include <d3d12.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+namespace sl12test
+{
+	/*************************************************//**
+	 * @brief 偽のGPU
+	 *
+	 * コピーコマンドとフェンスのシグナルは記録時に積まれ、RunGpu()で順に実行される.
+	 * CPUがフェンスを待機した場合(SetEventOnCompletion)も実行される.
+	*****************************************************/
+	inline std::vector<std::function<void()>>& GetPendingGpuWork()
+	{
+		static std::vector<std::function<void()>> s_work;
+		return s_work;
+	}
+
+	inline void RunGpu()
+	{
+		auto work = std::move(GetPendingGpuWork());
+		GetPendingGpuWork().clear();
+		for (auto&& w : work)
+		{
+			w();
+		}
+	}
+
+	// 生存しているリソースの数
+	inline std::atomic<int>& GetLiveResourceCount()
+	{
+		static std::atomic<int> s_count(0);
+		return s_count;
+	}
+
+	/*************************************************//**
+	 * @brief 偽のリソース. CPUメモリで内容を保持する
+	*****************************************************/
+	struct FakeResource : ID3D12Resource
+	{
+		D3D12_RESOURCE_DESC		desc;
+		std::vector<UINT8>		mem;
+
+		FakeResource(const D3D12_RESOURCE_DESC& d, size_t bytes)
+			: desc(d), mem(bytes, 0)
+		{
+			GetLiveResourceCount()++;
+		}
+		~FakeResource()
+		{
+			GetLiveResourceCount()--;
+		}
+
+		HRESULT Map(UINT, const D3D12_RANGE*, void** pp) override { *pp = mem.data(); return S_OK; }
+		D3D12_RESOURCE_DESC GetDesc() override { return desc; }
+		D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() override { return reinterpret_cast<D3D12_GPU_VIRTUAL_ADDRESS>(mem.data()); }
+	};	// struct FakeResource
+
+	/*************************************************//**
+	 * @brief 偽のデスクリプタヒープ
+	 *
+	 * デスクリプタはkDescriptorSizeバイトのCPUメモリで、GPUハンドルもCPUアドレスと同じ値を返す.
+	*****************************************************/
+	struct FakeDescriptorHeap : ID3D12DescriptorHeap
+	{
+		static const UINT kDescriptorSize = 32;
+
+		D3D12_DESCRIPTOR_HEAP_DESC	desc;
+		std::vector<UINT8>			mem;
+
+		FakeDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC& d)
+			: desc(d), mem(d.NumDescriptors * kDescriptorSize, 0)
+		{}
+
+		D3D12_DESCRIPTOR_HEAP_DESC GetDesc() override { return desc; }
+		D3D12_CPU_DESCRIPTOR_HANDLE GetCPUDescriptorHandleForHeapStart() override { return { reinterpret_cast<SIZE_T>(mem.data()) }; }
+		D3D12_GPU_DESCRIPTOR_HANDLE GetGPUDescriptorHandleForHeapStart() override { return { reinterpret_cast<UINT64>(mem.data()) }; }
+	};	// struct FakeDescriptorHeap
+
+	// デスクリプタの内容. 生成したビューの識別に使用する
+	inline UINT64 ReadDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE h)
+	{
+		UINT64 v;
+		memcpy(&v, reinterpret_cast<const void*>(h.ptr), sizeof(v));
+		return v;
+	}
+	inline void WriteDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE h, UINT64 v)
+	{
+		memcpy(reinterpret_cast<void*>(h.ptr), &v, sizeof(v));
+	}
+
+	/*************************************************//**
+	 * @brief 偽のフェンス
+	*****************************************************/
+	struct FakeFence : ID3D12Fence
+	{
+		std::atomic<UINT64>		completed;
+
+		FakeFence(UINT64 initial = 0)
+			: completed(initial)
+		{}
+
+		UINT64 GetCompletedValue() override { return completed; }
+		HRESULT SetEventOnCompletion(UINT64, HANDLE) override { RunGpu(); return S_OK; }
+		HRESULT Signal(UINT64 v) override { completed = v; return S_OK; }
+	};	// struct FakeFence
+
+	/*************************************************//**
+	 * @brief 偽のコマンドキュー. シグナルはGPUの実行時に反映される
+	*****************************************************/
+	struct FakeCommandQueue : ID3D12CommandQueue
+	{
+		int		numExecuted = 0;
+
+		void ExecuteCommandLists(UINT num, ID3D12CommandList* const*) override { numExecuted += num; }
+		HRESULT Signal(ID3D12Fence* pFence, UINT64 v) override
+		{
+			auto p = static_cast<FakeFence*>(pFence);
+			GetPendingGpuWork().push_back([p, v] { p->completed = v; });
+			return S_OK;
+		}
+	};	// struct FakeCommandQueue
+
+	/*************************************************//**
+	 * @brief 偽のコマンドリスト
+	 *
+	 * ステート設定系の呼び出しは名前と引数をログに記録する.
+	 * コピーは偽のGPUで実行される.
+	*****************************************************/
+	struct FakeCommandList : ID3D12GraphicsCommandList4
+	{
+		std::vector<std::string>	log;
+		int							numCopies = 0;
+
+		void Record(const char* format, ...) __attribute__((format(printf, 2, 3)))
+		{
+			char buf[256];
+			va_list args;
+			va_start(args, format);
+			vsnprintf(buf, sizeof(buf), format, args);
+			va_end(args);
+			log.push_back(buf);
+		}
+
+		HRESULT Close() override { Record("Close"); return S_OK; }
+		HRESULT Reset(ID3D12CommandAllocator*, ID3D12PipelineState*) override { Record("Reset"); return S_OK; }
+		void SetPipelineState(ID3D12PipelineState* p) override { Record("SetPipelineState %p", static_cast<void*>(p)); }
+		void SetDescriptorHeaps(UINT num, ID3D12DescriptorHeap* const*) override { Record("SetDescriptorHeaps %u", num); }
+		void SetGraphicsRootSignature(ID3D12RootSignature* p) override { Record("SetGraphicsRootSignature %p", static_cast<void*>(p)); }
+		void SetComputeRootSignature(ID3D12RootSignature* p) override { Record("SetComputeRootSignature %p", static_cast<void*>(p)); }
+		void SetGraphicsRootDescriptorTable(UINT i, D3D12_GPU_DESCRIPTOR_HANDLE h) override { Record("SetGraphicsRootDescriptorTable %u %llx", i, static_cast<unsigned long long>(h.ptr)); }
+		void SetComputeRootDescriptorTable(UINT i, D3D12_GPU_DESCRIPTOR_HANDLE h) override { Record("SetComputeRootDescriptorTable %u %llx", i, static_cast<unsigned long long>(h.ptr)); }
+		void SetGraphicsRoot32BitConstants(UINT i, UINT n, const void* p, UINT o) override { Record("SetGraphicsRoot32BitConstants %u %u %u %08x", i, n, o, *static_cast<const UINT*>(p)); }
+		void SetComputeRoot32BitConstants(UINT i, UINT n, const void* p, UINT o) override { Record("SetComputeRoot32BitConstants %u %u %u %08x", i, n, o, *static_cast<const UINT*>(p)); }
+		void SetGraphicsRootConstantBufferView(UINT i, D3D12_GPU_VIRTUAL_ADDRESS a) override { Record("SetGraphicsRootConstantBufferView %u %llx", i, static_cast<unsigned long long>(a)); }
+		void SetComputeRootConstantBufferView(UINT i, D3D12_GPU_VIRTUAL_ADDRESS a) override { Record("SetComputeRootConstantBufferView %u %llx", i, static_cast<unsigned long long>(a)); }
+		void SetGraphicsRootShaderResourceView(UINT i, D3D12_GPU_VIRTUAL_ADDRESS a) override { Record("SetGraphicsRootShaderResourceView %u %llx", i, static_cast<unsigned long long>(a)); }
+		void SetComputeRootShaderResourceView(UINT i, D3D12_GPU_VIRTUAL_ADDRESS a) override { Record("SetComputeRootShaderResourceView %u %llx", i, static_cast<unsigned long long>(a)); }
+		void IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY t) override { Record("IASetPrimitiveTopology %d", static_cast<int>(t)); }
+		void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* p) override { Record("IASetIndexBuffer %llx", p ? static_cast<unsigned long long>(p->BufferLocation) : 0ull); }
+		void IASetVertexBuffers(UINT s, UINT n, const D3D12_VERTEX_BUFFER_VIEW*) override { Record("IASetVertexBuffers %u %u", s, n); }
+		void RSSetViewports(UINT n, const D3D12_VIEWPORT*) override { Record("RSSetViewports %u", n); }
+		void RSSetScissorRects(UINT n, const D3D12_RECT*) override { Record("RSSetScissorRects %u", n); }
+		void OMSetStencilRef(UINT r) override { Record("OMSetStencilRef %u", r); }
+		void OMSetBlendFactor(const FLOAT f[4]) override { Record("OMSetBlendFactor %g %g %g %g", f[0], f[1], f[2], f[3]); }
+		void OMSetRenderTargets(UINT n, const D3D12_CPU_DESCRIPTOR_HANDLE* p, BOOL single, const D3D12_CPU_DESCRIPTOR_HANDLE* pDsv) override { Record("OMSetRenderTargets %u %llx %d %llx", n, (n > 0) ? static_cast<unsigned long long>(p[0].ptr) : 0ull, single, pDsv ? static_cast<unsigned long long>(pDsv->ptr) : 0ull); }
+		void DrawInstanced(UINT v, UINT i, UINT, UINT) override { Record("DrawInstanced %u %u", v, i); }
+		void DrawIndexedInstanced(UINT n, UINT i, UINT, INT, UINT) override { Record("DrawIndexedInstanced %u %u", n, i); }
+
+		void CopyBufferRegion(ID3D12Resource* pDst, UINT64 dstOffset, ID3D12Resource* pSrc, UINT64 srcOffset, UINT64 size) override
+		{
+			numCopies++;
+			auto d = static_cast<FakeResource*>(pDst);
+			auto s = static_cast<FakeResource*>(pSrc);
+			assert(srcOffset + size <= s->mem.size() && dstOffset + size <= d->mem.size());
+			GetPendingGpuWork().push_back([=] { memcpy(d->mem.data() + dstOffset, s->mem.data() + srcOffset, static_cast<size_t>(size)); });
+		}
+		void CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION* pDst, UINT, UINT, UINT, const D3D12_TEXTURE_COPY_LOCATION* pSrc, const D3D12_BOX*) override;
+	};	// struct FakeCommandList
+
+	/**
+	 * @brief 4バイト/ピクセルのテクスチャのコピー可能なフットプリントを計算する
+	*/
+	inline void CalcFootprints(const D3D12_RESOURCE_DESC* pDesc, UINT first, UINT num, UINT64 baseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pFootprints, UINT* pNumRows, UINT64* pRowSize, UINT64* pTotalBytes)
+	{
+		UINT64 offset = baseOffset;
+		for (UINT i = 0; i < num; i++)
+		{
+			UINT mip = (first + i) % pDesc->MipLevels;
+			UINT w = static_cast<UINT>(pDesc->Width >> mip); if (!w) w = 1;
+			UINT h = pDesc->Height >> mip; if (!h) h = 1;
+			offset = (offset + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) / D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT * D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+			auto&& fp = pFootprints[i];
+			fp.Offset = offset;
+			fp.Footprint.Format = pDesc->Format;
+			fp.Footprint.Width = w;
+			fp.Footprint.Height = h;
+			fp.Footprint.Depth = 1;
+			fp.Footprint.RowPitch = (w * 4 + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) / D3D12_TEXTURE_DATA_PITCH_ALIGNMENT * D3D12_TEXTURE_DATA_PITCH_ALIGNMENT;
+			if (pNumRows) pNumRows[i] = h;
+			if (pRowSize) pRowSize[i] = w * 4;
+			offset += static_cast<UINT64>(fp.Footprint.RowPitch) * (h - 1) + w * 4;
+		}
+		if (pTotalBytes) *pTotalBytes = offset - baseOffset;
+	}
+
+	inline void FakeCommandList::CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION* pDst, UINT, UINT, UINT, const D3D12_TEXTURE_COPY_LOCATION* pSrc, const D3D12_BOX*)
+	{
+		numCopies++;
+		assert(pSrc->Type == D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT && pDst->Type == D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX);
+		assert(pSrc->PlacedFootprint.Offset % D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT == 0);
+		assert(pSrc->PlacedFootprint.Footprint.RowPitch % D3D12_TEXTURE_DATA_PITCH_ALIGNMENT == 0);
+		auto d = static_cast<FakeResource*>(pDst->pResource);
+		auto s = static_cast<FakeResource*>(pSrc->pResource);
+		auto src = pSrc->PlacedFootprint;
+		UINT sub = pDst->SubresourceIndex;
+		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> fp(sub + 1);
+		CalcFootprints(&d->desc, 0, sub + 1, 0, fp.data(), nullptr, nullptr, nullptr);
+		auto dst = fp[sub];
+		GetPendingGpuWork().push_back([=]
+		{
+			for (UINT y = 0; y < src.Footprint.Height; y++)
+			{
+				memcpy(d->mem.data() + dst.Offset + static_cast<UINT64>(dst.Footprint.RowPitch) * y,
+					s->mem.data() + src.Offset + static_cast<UINT64>(src.Footprint.RowPitch) * y,
+					src.Footprint.Width * 4);
+			}
+		});
+	}
+
+	/*************************************************//**
+	 * @brief 偽のデバイス
+	 *
+	 * ビューの生成はデスクリプタの先頭8バイトにリソースのアドレス(定数バッファはBufferLocation)を書き込む.
+	*****************************************************/
+	struct FakeDevice : ID3D12Device5
+	{
+		std::atomic<int>	numHeapsCreated;
+		std::atomic<int>	numCopyDescriptors;
+		std::atomic<int>	numPipelinesCreated;
+		int					failNextResource = 0;
+		std::mutex			mutex;
+
+		FakeDevice()
+			: numHeapsCreated(0), numCopyDescriptors(0), numPipelinesCreated(0)
+		{}
+
+		HRESULT CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* pDesc, REFIID, void** pp) override
+		{
+			numHeapsCreated++;
+			*pp = static_cast<ID3D12DescriptorHeap*>(new FakeDescriptorHeap(*pDesc));
+			return S_OK;
+		}
+		UINT GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE) override { return FakeDescriptorHeap::kDescriptorSize; }
+
+		void CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC* pDesc, D3D12_CPU_DESCRIPTOR_HANDLE h) override { WriteDescriptor(h, pDesc->BufferLocation); }
+		void CreateShaderResourceView(ID3D12Resource* p, const D3D12_SHADER_RESOURCE_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE h) override { WriteDescriptor(h, reinterpret_cast<UINT64>(p)); }
+		void CreateUnorderedAccessView(ID3D12Resource* p, ID3D12Resource*, const D3D12_UNORDERED_ACCESS_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE h) override { WriteDescriptor(h, reinterpret_cast<UINT64>(p)); }
+		void CreateSampler(const D3D12_SAMPLER_DESC* pDesc, D3D12_CPU_DESCRIPTOR_HANDLE h) override { WriteDescriptor(h, static_cast<UINT64>(pDesc->Filter)); }
+
+		void CopyDescriptors(UINT numDst, const D3D12_CPU_DESCRIPTOR_HANDLE* pDstStarts, const UINT* pDstSizes, UINT numSrc, const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcStarts, const UINT* pSrcSizes, D3D12_DESCRIPTOR_HEAP_TYPE) override
+		{
+			numCopyDescriptors++;
+			UINT di = 0, doff = 0;
+			for (UINT si = 0; si < numSrc; si++)
+			{
+				UINT n = pSrcSizes ? pSrcSizes[si] : 1;
+				for (UINT k = 0; k < n; k++)
+				{
+					assert(di < numDst);
+					memcpy(reinterpret_cast<void*>(pDstStarts[di].ptr + doff * FakeDescriptorHeap::kDescriptorSize),
+						reinterpret_cast<const void*>(pSrcStarts[si].ptr + k * FakeDescriptorHeap::kDescriptorSize),
+						FakeDescriptorHeap::kDescriptorSize);
+					if (++doff == (pDstSizes ? pDstSizes[di] : 1))
+					{
+						di++;
+						doff = 0;
+					}
+				}
+			}
+		}
+		void CopyDescriptorsSimple(UINT num, D3D12_CPU_DESCRIPTOR_HANDLE dst, D3D12_CPU_DESCRIPTOR_HANDLE src, D3D12_DESCRIPTOR_HEAP_TYPE) override
+		{
+			numCopyDescriptors++;
+			memcpy(reinterpret_cast<void*>(dst.ptr), reinterpret_cast<const void*>(src.ptr), num * FakeDescriptorHeap::kDescriptorSize);
+		}
+
+		HRESULT CreateCommittedResource(const D3D12_HEAP_PROPERTIES*, D3D12_HEAP_FLAGS, const D3D12_RESOURCE_DESC* pDesc, D3D12_RESOURCE_STATES, const D3D12_CLEAR_VALUE*, REFIID, void** pp) override
+		{
+			if (failNextResource > 0)
+			{
+				failNextResource--;
+				return E_FAIL;
+			}
+			UINT64 bytes = pDesc->Width;
+			if (pDesc->Dimension != D3D12_RESOURCE_DIMENSION_BUFFER)
+			{
+				std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> fp(pDesc->MipLevels * pDesc->DepthOrArraySize);
+				CalcFootprints(pDesc, 0, static_cast<UINT>(fp.size()), 0, fp.data(), nullptr, nullptr, &bytes);
+			}
+			*pp = static_cast<ID3D12Resource*>(new FakeResource(*pDesc, static_cast<size_t>(bytes)));
+			return S_OK;
+		}
+		HRESULT CreateFence(UINT64 initial, D3D12_FENCE_FLAGS, REFIID, void** pp) override
+		{
+			*pp = static_cast<ID3D12Fence*>(new FakeFence(initial));
+			return S_OK;
+		}
+		void GetCopyableFootprints(const D3D12_RESOURCE_DESC* pDesc, UINT first, UINT num, UINT64 base, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pFootprints, UINT* pNumRows, UINT64* pRowSize, UINT64* pTotal) override
+		{
+			CalcFootprints(pDesc, first, num, base, pFootprints, pNumRows, pRowSize, pTotal);
+		}
+		HRESULT CreateRootSignature(UINT, const void*, SIZE_T, REFIID, void** pp) override
+		{
+			*pp = static_cast<ID3D12RootSignature*>(new ID3D12RootSignature());
+			return S_OK;
+		}
+		HRESULT CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC*, REFIID, void** pp) override
+		{
+			numPipelinesCreated++;
+			*pp = static_cast<ID3D12PipelineState*>(new ID3D12PipelineState());
+			return S_OK;
+		}
+		HRESULT CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC*, REFIID, void** pp) override
+		{
+			numPipelinesCreated++;
+			*pp = static_cast<ID3D12PipelineState*>(new ID3D12PipelineState());
+			return S_OK;
+		}
+	};	// struct FakeDevice
+
+}	// namespace sl12test
+
+//	EOF
@@ -0,0 +1,40 @@
+﻿#include <sl12/swapchain.h>
+#include <sl12/texture.h>
+#include <sl12/texture_view.h>
+
+
+// device.cppのリンクにのみ必要なクラス
+// スワップチェインとテクスチャはDXGIとDirectXTexに依存するので、ヘッドレスでは何もしない実装に置き換える
+namespace sl12
+{
+	//----
+	bool Swapchain::Initialize(Device*, CommandQueue*, HWND, uint32_t, uint32_t, DXGI_FORMAT)
+	{
+		return false;
+	}
+	//----
+	void Swapchain::Destroy()
+	{
+	}
+	//----
+	void Swapchain::Present(int)
+	{
+	}
+	//----
+	void Swapchain::WaitPresent()
+	{
+	}
+
+	//----
+	void Texture::Destroy()
+	{
+	}
+
+	//----
+	void RenderTargetView::Destroy()
+	{
+	}
+
+}	// namespace sl12
+
+//	EOF
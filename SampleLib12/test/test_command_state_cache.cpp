@@ -0,0 +1,202 @@
+﻿#include "test_util.h"
+#include "test_device.h"
+
+#include <sl12/command_state_cache.h>
+#include <string>
+
+
+namespace
+{
+	// ネイティブのコマンドリストには積まれないので、ポインタは識別値としてのみ使用する
+	template <typename T>
+	T* FakePtr(uintptr_t v)
+	{
+		return reinterpret_cast<T*>(v);
+	}
+
+	// サンプルの描画ループと同じく、サブメッシュごとに全ステートを設定して描画する
+	void DrawSubmeshes(sl12::CommandList& cmdList, int numSubmeshes)
+	{
+		D3D12_VIEWPORT vp{ 0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 1.0f };
+		D3D12_RECT rect{ 0, 0, 1280, 720 };
+		D3D12_CPU_DESCRIPTOR_HANDLE rtv{ 0x100 }, dsv{ 0x200 };
+		D3D12_VERTEX_BUFFER_VIEW vbs[2]{ { 0x1000, 256, 12 }, { 0x2000, 256, 8 } };
+		D3D12_INDEX_BUFFER_VIEW ib{ 0x3000, 128, DXGI_FORMAT_R16_UINT };
+		D3D12_GPU_DESCRIPTOR_HANDLE table{ 0x4000 };
+
+		for (int i = 0; i < numSubmeshes; i++)
+		{
+			cmdList.OMSetRenderTargets(1, &rtv, FALSE, &dsv);
+			cmdList.RSSetViewports(1, &vp);
+			cmdList.RSSetScissorRects(1, &rect);
+			cmdList.SetPipelineState(FakePtr<ID3D12PipelineState>(0x10));
+			cmdList.SetGraphicsRootSignature(FakePtr<ID3D12RootSignature>(0x20));
+			cmdList.SetGraphicsRootDescriptorTable(0, table);
+			cmdList.SetGraphicsRootConstantBufferView(1, 0x5000);
+			cmdList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+			cmdList.IASetVertexBuffers(0, 2, vbs);
+			cmdList.IASetIndexBuffer(&ib);
+			cmdList.GetCommandList()->DrawIndexedInstanced(36, 1, 0, 0, 0);
+		}
+	}
+
+	int Count(const sl12test::FakeCommandList& fake, const char* prefix)
+	{
+		int ret = 0;
+		for (auto&& s : fake.log)
+		{
+			ret += (s.compare(0, strlen(prefix), prefix) == 0) ? 1 : 0;
+		}
+		return ret;
+	}
+}
+
+//----
+// 同じステートの再設定は記録されず、描画は全て記録される
+//----
+SL12_TEST(FiltersRedundantSubmeshState)
+{
+	sl12test::TestDevice td;
+	sl12test::TestCommandList tcl(&td.GetDevice().GetGraphicsQueue());
+	auto&& cmdList = tcl.Get();
+	cmdList.EnableStateCache(true);
+
+	DrawSubmeshes(cmdList, 8);
+	auto&& log = tcl.GetFake().log;
+	SL12_REQUIRE(log.size() == 10 + 8);
+	SL12_CHECK(log[0] == "OMSetRenderTargets 1 100 0 200");
+	SL12_CHECK(log[5] == "SetGraphicsRootDescriptorTable 0 4000");
+	SL12_CHECK(log[6] == "SetGraphicsRootConstantBufferView 1 5000");
+	SL12_CHECK(log[8] == "IASetVertexBuffers 0 2");
+	SL12_CHECK(Count(tcl.GetFake(), "DrawIndexedInstanced") == 8);
+	SL12_CHECK(cmdList.GetStateCacheStats().issued == 10);
+	SL12_CHECK(cmdList.GetStateCacheStats().filtered == 10 * 7);
+}
+
+//----
+// キャッシュが無効の場合は全て記録される
+//----
+SL12_TEST(DisabledCacheIssuesEverything)
+{
+	sl12test::TestDevice td;
+	sl12test::TestCommandList tcl(&td.GetDevice().GetGraphicsQueue());
+	auto&& cmdList = tcl.Get();
+	SL12_CHECK(!cmdList.IsStateCacheEnabled());
+
+	DrawSubmeshes(cmdList, 4);
+	SL12_CHECK(tcl.GetFake().log.size() == 11 * 4);
+	SL12_CHECK(cmdList.GetStateCacheStats().issued == 10 * 4);
+	SL12_CHECK(cmdList.GetStateCacheStats().filtered == 0);
+}
+
+//----
+// ルートシグネチャやデスクリプタヒープが変わると、同じルート引数でも再設定される
+//----
+SL12_TEST(RootArgumentsResetOnSignatureAndHeapChange)
+{
+	sl12test::TestDevice td;
+	sl12test::TestCommandList tcl(&td.GetDevice().GetGraphicsQueue());
+	auto&& cmdList = tcl.Get();
+	cmdList.EnableStateCache(true);
+	auto&& fake = tcl.GetFake();
+
+	D3D12_GPU_DESCRIPTOR_HANDLE table{ 0x4000 };
+	ID3D12DescriptorHeap* heaps[2] = { FakePtr<ID3D12DescriptorHeap>(0x30), FakePtr<ID3D12DescriptorHeap>(0x40) };
+	cmdList.SetDescriptorHeaps(2, heaps);
+	cmdList.SetGraphicsRootSignature(FakePtr<ID3D12RootSignature>(0x20));
+	cmdList.SetGraphicsRootDescriptorTable(0, table);
+	cmdList.SetGraphicsRootDescriptorTable(0, table);
+	SL12_CHECK(Count(fake, "SetGraphicsRootDescriptorTable") == 1);
+
+	// 別のルートシグネチャ
+	cmdList.SetGraphicsRootSignature(FakePtr<ID3D12RootSignature>(0x21));
+	cmdList.SetGraphicsRootDescriptorTable(0, table);
+	SL12_CHECK(Count(fake, "SetGraphicsRootDescriptorTable") == 2);
+
+	// コンピュートのルート引数はグラフィクスと独立している
+	cmdList.SetComputeRootSignature(FakePtr<ID3D12RootSignature>(0x21));
+	cmdList.SetComputeRootDescriptorTable(0, table);
+	cmdList.SetGraphicsRootDescriptorTable(0, table);
+	SL12_CHECK(Count(fake, "SetComputeRootDescriptorTable") == 1);
+	SL12_CHECK(Count(fake, "SetGraphicsRootDescriptorTable") == 2);
+
+	// 同じヒープの再設定は除外され、異なるヒープでは全てのテーブルが無効になる
+	cmdList.SetDescriptorHeaps(2, heaps);
+	cmdList.SetGraphicsRootDescriptorTable(0, table);
+	SL12_CHECK(Count(fake, "SetDescriptorHeaps") == 1);
+	SL12_CHECK(Count(fake, "SetGraphicsRootDescriptorTable") == 2);
+	std::swap(heaps[0], heaps[1]);
+	cmdList.SetDescriptorHeaps(2, heaps);
+	cmdList.SetGraphicsRootDescriptorTable(0, table);
+	cmdList.SetComputeRootDescriptorTable(0, table);
+	SL12_CHECK(Count(fake, "SetDescriptorHeaps") == 2);
+	SL12_CHECK(Count(fake, "SetGraphicsRootDescriptorTable") == 3);
+	SL12_CHECK(Count(fake, "SetComputeRootDescriptorTable") == 2);
+}
+
+//----
+// 部分的なステートの変更は変更分のみを比較する
+//----
+SL12_TEST(PartialStateChanges)
+{
+	sl12test::TestDevice td;
+	sl12test::TestCommandList tcl(&td.GetDevice().GetGraphicsQueue());
+	auto&& cmdList = tcl.Get();
+	cmdList.EnableStateCache(true);
+	auto&& fake = tcl.GetFake();
+
+	// 頂点バッファは設定済みのスロットの範囲内なら除外される
+	D3D12_VERTEX_BUFFER_VIEW vbs[2]{ { 0x1000, 256, 12 }, { 0x2000, 256, 8 } };
+	cmdList.IASetVertexBuffers(0, 2, vbs);
+	cmdList.IASetVertexBuffers(1, 1, &vbs[1]);
+	cmdList.IASetVertexBuffers(2, 1, &vbs[1]);
+	vbs[1].SizeInBytes = 512;
+	cmdList.IASetVertexBuffers(1, 1, &vbs[1]);
+	SL12_CHECK(Count(fake, "IASetVertexBuffers") == 3);
+
+	// インデックスバッファの解除もステートとして扱う
+	D3D12_INDEX_BUFFER_VIEW ib{ 0x3000, 128, DXGI_FORMAT_R16_UINT };
+	cmdList.IASetIndexBuffer(&ib);
+	cmdList.IASetIndexBuffer(nullptr);
+	cmdList.IASetIndexBuffer(nullptr);
+	cmdList.IASetIndexBuffer(&ib);
+	SL12_CHECK(Count(fake, "IASetIndexBuffer") == 3);
+
+	// デプスバッファの有無と単一ハンドル指定も比較する
+	D3D12_CPU_DESCRIPTOR_HANDLE rtvs[2]{ { 0x100 }, { 0x101 } }, dsv{ 0x200 };
+	cmdList.OMSetRenderTargets(2, rtvs, FALSE, &dsv);
+	cmdList.OMSetRenderTargets(2, rtvs, FALSE, nullptr);
+	cmdList.OMSetRenderTargets(2, rtvs, TRUE, nullptr);
+	cmdList.OMSetRenderTargets(2, rtvs, TRUE, nullptr);
+	SL12_CHECK(Count(fake, "OMSetRenderTargets") == 3);
+
+	// ビューポートは数が異なれば再設定される
+	D3D12_VIEWPORT vps[2]{ { 0, 0, 64, 64, 0, 1 }, { 64, 0, 64, 64, 0, 1 } };
+	cmdList.RSSetViewports(2, vps);
+	cmdList.RSSetViewports(1, vps);
+	cmdList.RSSetViewports(1, vps);
+	SL12_CHECK(Count(fake, "RSSetViewports") == 2);
+}
+
+//----
+// InvalidateStateCache()の後は全て再設定される
+//----
+SL12_TEST(InvalidateReissuesState)
+{
+	sl12test::TestDevice td;
+	sl12test::TestCommandList tcl(&td.GetDevice().GetGraphicsQueue());
+	auto&& cmdList = tcl.Get();
+	cmdList.EnableStateCache(true);
+
+	DrawSubmeshes(cmdList, 2);
+	cmdList.InvalidateStateCache();
+	DrawSubmeshes(cmdList, 2);
+	SL12_CHECK(tcl.GetFake().log.size() == (10 + 2) * 2);
+
+	cmdList.ResetStateCacheStats();
+	DrawSubmeshes(cmdList, 1);
+	SL12_CHECK(cmdList.GetStateCacheStats().issued == 0);
+	SL12_CHECK(cmdList.GetStateCacheStats().filtered == 10);
+}
+
+//	EOF
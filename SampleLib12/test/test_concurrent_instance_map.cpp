@@ -0,0 +1,219 @@
+﻿#include "test_util.h"
+
+#include <sl12/concurrent_instance_map.h>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+
+namespace
+{
+	static const int kNumThreads = 8;
+
+	struct Item
+	{
+		int					key;
+		std::atomic<int>	referenceCounter_{ 0 };
+
+		Item(int k)
+			: key(k)
+		{
+			GetLiveCount()++;
+		}
+		~Item()
+		{
+			GetLiveCount()--;
+		}
+
+		static std::atomic<int>& GetLiveCount()
+		{
+			static std::atomic<int> s_count(0);
+			return s_count;
+		}
+	};	// struct Item
+
+	typedef sl12::ConcurrentInstanceMap<int, Item> ItemMap;
+
+	// 全スレッドを同時に開始する
+	template <typename Func>
+	void RunThreads(int numThreads, Func func)
+	{
+		std::vector<std::thread> threads;
+		std::atomic<int> ready(0);
+		for (int t = 0; t < numThreads; t++)
+		{
+			threads.emplace_back([&, t]
+			{
+				ready++;
+				while (ready != numThreads)
+				{
+					std::this_thread::yield();
+				}
+				func(t);
+			});
+		}
+		for (auto&& th : threads)
+		{
+			th.join();
+		}
+	}
+
+	// 生成中に他の全スレッドが待機に入るまで待つ. 一定時間で諦める
+	void WaitForWaiters(const ItemMap& map, sl12::u32 expected)
+	{
+		sl12test::Timer timer;
+		while (map.GetWaitCount() < expected && timer.GetMilliseconds() < 5000.0)
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+//----
+// 同じキーを同時に要求しても生成は1回だけ行われ、全スレッドが同じインスタンスを受け取る
+//----
+SL12_TEST(SingleFlightCreation)
+{
+	static const int kNumRounds = 200;
+	ItemMap map;
+	std::atomic<int> numCreated(0);
+	for (int round = 0; round < kNumRounds; round++)
+	{
+		Item* results[kNumThreads] = {};
+		RunThreads(kNumThreads, [&](int t)
+		{
+			results[t] = map.Acquire(round, [&]
+			{
+				numCreated++;
+				std::this_thread::yield();
+				return new Item(round);
+			});
+		});
+		for (int t = 0; t < kNumThreads; t++)
+		{
+			SL12_REQUIRE(results[t] == results[0]);
+		}
+		SL12_REQUIRE(results[0]->key == round);
+		SL12_REQUIRE(results[0]->referenceCounter_ == kNumThreads);
+		SL12_REQUIRE(numCreated == round + 1);
+		for (int t = 0; t < kNumThreads; t++)
+		{
+			map.Release(round, results[t]);
+		}
+		SL12_REQUIRE(map.GetCount() == 0);
+	}
+	SL12_CHECK(map.GetMissCount() == kNumRounds);
+	SL12_CHECK(map.GetHitCount() + map.GetWaitCount() >= kNumRounds * (kNumThreads - 1));
+	SL12_CHECK(Item::GetLiveCount() == 0);
+}
+
+//----
+// 少数のキーをランダムに取得、解放しても、キーごとのインスタンスは常に1つで、リークも二重解放もない
+//----
+SL12_TEST(RandomAcquireReleaseStress)
+{
+	static const int kNumKeys = 4;
+	static const int kOpsPerThread = 20000;
+	ItemMap map;
+	std::atomic<int> numErrors(0);
+	RunThreads(kNumThreads, [&](int t)
+	{
+		std::mt19937 rng(t + 1);
+		std::vector<std::pair<int, Item*>> held;
+		for (int i = 0; i < kOpsPerThread; i++)
+		{
+			if (held.size() < 8 && (held.empty() || (rng() % 2)))
+			{
+				int key = rng() % kNumKeys;
+				Item* p = map.Acquire(key, [&] { return new Item(key); });
+				if (!p || p->key != key || p->referenceCounter_ <= 0)
+				{
+					numErrors++;
+					continue;
+				}
+				// 同じキーを保持していれば同じインスタンスでなければならない
+				for (auto&& h : held)
+				{
+					if (h.first == key && h.second != p)
+					{
+						numErrors++;
+					}
+				}
+				held.push_back(std::make_pair(key, p));
+			}
+			else
+			{
+				size_t k = rng() % held.size();
+				map.Release(held[k].first, held[k].second);
+				held[k] = held.back();
+				held.pop_back();
+			}
+		}
+		for (auto&& h : held)
+		{
+			map.Release(h.first, h.second);
+		}
+	});
+	SL12_CHECK(numErrors == 0);
+	SL12_CHECK(map.GetCount() == 0);
+	SL12_CHECK(Item::GetLiveCount() == 0);
+}
+
+//----
+// 生成が例外を送出した場合、待機中のスレッドにも例外が渡り、次の要求で再び生成できる
+//----
+SL12_TEST(CreateExceptionPropagatesToWaiters)
+{
+	ItemMap map;
+	std::atomic<int> numThrown(0), numCreated(0);
+	RunThreads(kNumThreads, [&](int)
+	{
+		try
+		{
+			map.Acquire(1, [&]() -> Item*
+			{
+				numCreated++;
+				WaitForWaiters(map, kNumThreads - 1);
+				throw std::runtime_error("create failed");
+			});
+		}
+		catch (const std::runtime_error&)
+		{
+			numThrown++;
+		}
+	});
+	SL12_CHECK(numCreated == 1);
+	SL12_CHECK(numThrown == kNumThreads);
+	SL12_CHECK(map.GetCount() == 0);
+
+	// 生成中の登録は取り消されているので、再度生成される
+	Item* p = map.Acquire(1, [] { return new Item(1); });
+	SL12_REQUIRE(p != nullptr);
+	SL12_CHECK(p->referenceCounter_ == 1);
+	map.Release(1, p);
+	SL12_CHECK(Item::GetLiveCount() == 0);
+}
+
+//----
+// 生成がnullptrを返した場合、待機中のスレッドにもnullptrを返し、何も登録しない
+//----
+SL12_TEST(CreateFailureReturnsNullToWaiters)
+{
+	ItemMap map;
+	std::atomic<int> numNull(0), numCreated(0);
+	RunThreads(kNumThreads, [&](int)
+	{
+		Item* p = map.Acquire(2, [&]() -> Item*
+		{
+			numCreated++;
+			WaitForWaiters(map, kNumThreads - 1);
+			return nullptr;
+		});
+		numNull += (p == nullptr) ? 1 : 0;
+	});
+	SL12_CHECK(numCreated == 1);
+	SL12_CHECK(numNull == kNumThreads);
+	SL12_CHECK(map.GetCount() == 0);
+}
+
+//	EOF
@@ -0,0 +1,199 @@
+﻿#include "test_util.h"
+#include "test_device.h"
+
+#include <sl12/deferred_index_allocator.h>
+#include <sl12/bindless_descriptor_table.h>
+#include <algorithm>
+#include <random>
+
+
+//----
+// 解放したインデックスはタグ付けしたフェンス値に到達するまで再利用されない
+//----
+SL12_TEST(FreedIndexWaitsForFence)
+{
+	sl12::DeferredIndexAllocator alloc;
+	alloc.Initialize(4);
+
+	sl12::u32 idx[4];
+	for (auto&& i : idx)
+	{
+		i = alloc.Allocate();
+	}
+	SL12_CHECK(idx[0] == 0 && idx[3] == 3);
+	SL12_CHECK(alloc.Allocate() == sl12::DeferredIndexAllocator::kInvalidIndex);
+
+	alloc.Free(idx[1]);
+	SL12_CHECK(alloc.GetAllocatedCount() == 3);
+	SL12_CHECK(alloc.GetPendingCount() == 1);
+	// EndFrame()前はReclaim()しても回収されない
+	alloc.Reclaim(100);
+	SL12_CHECK(alloc.Allocate() == sl12::DeferredIndexAllocator::kInvalidIndex);
+
+	alloc.EndFrame(10);
+	alloc.Reclaim(9);
+	SL12_CHECK(alloc.Allocate() == sl12::DeferredIndexAllocator::kInvalidIndex);
+	alloc.Reclaim(10);
+	SL12_CHECK(alloc.GetPendingCount() == 0);
+	SL12_CHECK(alloc.Allocate() == idx[1]);
+	SL12_CHECK(alloc.GetAllocatedCount() == 4);
+}
+
+//----
+// 複数フレーム分の解放はフェンス値の順に回収される
+//----
+SL12_TEST(FramesReclaimInFenceOrder)
+{
+	sl12::DeferredIndexAllocator alloc;
+	alloc.Initialize(8);
+	for (int i = 0; i < 8; i++)
+	{
+		alloc.Allocate();
+	}
+
+	alloc.Free(0);
+	alloc.Free(1);
+	alloc.EndFrame(1);
+	alloc.Free(2);
+	alloc.EndFrame(2);
+	// 解放がないフレームはタグ付けされない
+	alloc.EndFrame(3);
+	alloc.Free(3);
+	alloc.EndFrame(4);
+	SL12_CHECK(alloc.GetPendingCount() == 4);
+
+	alloc.Reclaim(1);
+	SL12_CHECK(alloc.GetPendingCount() == 2);
+	std::vector<sl12::u32> got;
+	for (sl12::u32 i; (i = alloc.Allocate()) != sl12::DeferredIndexAllocator::kInvalidIndex; )
+	{
+		got.push_back(i);
+	}
+	std::sort(got.begin(), got.end());
+	SL12_CHECK((got == std::vector<sl12::u32>{ 0, 1 }));
+
+	alloc.Reclaim(3);
+	SL12_CHECK(alloc.Allocate() == 2);
+	SL12_CHECK(alloc.Allocate() == sl12::DeferredIndexAllocator::kInvalidIndex);
+	alloc.Reclaim(4);
+	SL12_CHECK(alloc.Allocate() == 3);
+	SL12_CHECK(alloc.GetPendingCount() == 0);
+}
+
+//----
+// ランダムな確保と解放で、GPUが使用中の可能性があるインデックスが返されないことを確認する
+//----
+SL12_TEST(RandomizedRecycling)
+{
+	static const sl12::u32 kCapacity = 256;
+	static const int kNumFrames = 2000;
+	static const sl12::u64 kLatency = 3;		// GPUはkLatencyフレーム遅れて完了する
+
+	sl12::DeferredIndexAllocator alloc;
+	alloc.Initialize(kCapacity);
+
+	std::mt19937 rng(7);
+	std::vector<sl12::u32> live;
+	std::vector<sl12::u64> freedFence(kCapacity, 0);	// 最後に解放したフレームのフェンス値(0は未解放)
+	std::vector<bool> isLive(kCapacity, false);
+	for (sl12::u64 fence = 1; fence <= kNumFrames; fence++)
+	{
+		sl12::u64 completed = (fence > kLatency) ? fence - kLatency : 0;
+		alloc.Reclaim(completed);
+
+		int numOps = rng() % 64;
+		for (int op = 0; op < numOps; op++)
+		{
+			if (live.empty() || (rng() % 2))
+			{
+				sl12::u32 i = alloc.Allocate();
+				if (i == sl12::DeferredIndexAllocator::kInvalidIndex)
+				{
+					// 確保済みと完了待ちで容量を使い切っている場合のみ失敗する
+					SL12_REQUIRE(live.size() + alloc.GetPendingCount() == kCapacity);
+					continue;
+				}
+				SL12_REQUIRE(i < kCapacity);
+				SL12_REQUIRE(!isLive[i]);
+				SL12_REQUIRE(freedFence[i] <= completed);
+				isLive[i] = true;
+				live.push_back(i);
+			}
+			else
+			{
+				size_t k = rng() % live.size();
+				sl12::u32 i = live[k];
+				live[k] = live.back();
+				live.pop_back();
+				isLive[i] = false;
+				freedFence[i] = fence;
+				alloc.Free(i);
+			}
+		}
+		SL12_REQUIRE(alloc.GetAllocatedCount() == live.size());
+		alloc.EndFrame(fence);
+	}
+
+	// 全て完了すれば容量全体を再び確保できる
+	for (auto i : live)
+	{
+		alloc.Free(i);
+	}
+	alloc.EndFrame(kNumFrames + 1);
+	alloc.Reclaim(kNumFrames + 1);
+	SL12_CHECK(alloc.GetPendingCount() == 0);
+	sl12::u32 count = 0;
+	while (alloc.Allocate() != sl12::DeferredIndexAllocator::kInvalidIndex)
+	{
+		count++;
+	}
+	SL12_CHECK(count == kCapacity);
+}
+
+//----
+// BindlessDescriptorTableは解放したインデックスを完了済みのフレームでのみ再利用する
+//----
+SL12_TEST(BindlessTableRecycling)
+{
+	sl12test::TestDevice td;
+	std::array<sl12::u32, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> nums{ 256, 16, 16, 16 };
+	std::array<sl12::DescriptorHeapLayout, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> layouts;
+	layouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].numRanges = 128;
+	layouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].numBindless = 4;
+	SL12_REQUIRE(td.InitializeHeaps(nums, layouts));
+	auto pTable = td.GetDevice().GetBindlessTable();
+	SL12_REQUIRE(pTable != nullptr);
+	SL12_CHECK(pTable->GetCapacity() == 4);
+
+	std::vector<sl12::u32> idx;
+	for (sl12::u64 v = 0; v < 4; v++)
+	{
+		sl12::u32 i = pTable->Register([&](D3D12_CPU_DESCRIPTOR_HANDLE h) { sl12test::WriteDescriptor(h, 0x100 + v); });
+		SL12_REQUIRE(i != sl12::BindlessDescriptorTable::kInvalidIndex);
+		idx.push_back(i);
+	}
+	auto noop = [](D3D12_CPU_DESCRIPTOR_HANDLE) {};
+	SL12_CHECK(pTable->Register(noop) == sl12::BindlessDescriptorTable::kInvalidIndex);
+
+	// フレーム1で解放し、GPUがフレーム1を完了するまでは再利用されない
+	pTable->Release(idx[2]);
+	pTable->EndFrame(0, 1);
+	SL12_CHECK(pTable->Register(noop) == sl12::BindlessDescriptorTable::kInvalidIndex);
+	pTable->EndFrame(1, 2);
+	sl12::u32 reused = pTable->Register([](D3D12_CPU_DESCRIPTOR_HANDLE h) { sl12test::WriteDescriptor(h, 0x200); });
+	SL12_CHECK(reused == idx[2]);
+	SL12_CHECK(pTable->GetRegisteredCount() == 4);
+
+	// 登録したビューはテーブル先頭からインデックスの位置に書き込まれる(偽のヒープのGPUハンドルはCPUアドレスと同じ)
+	auto ReadSlot = [&](sl12::u32 index)
+	{
+		D3D12_CPU_DESCRIPTOR_HANDLE h;
+		h.ptr = static_cast<SIZE_T>(pTable->GetGpuHandle().ptr) + index * sl12test::FakeDescriptorHeap::kDescriptorSize;
+		return sl12test::ReadDescriptor(h);
+	};
+	SL12_CHECK(ReadSlot(reused) == 0x200);
+	SL12_CHECK(ReadSlot(idx[0]) == 0x100);
+	SL12_CHECK(ReadSlot(idx[3]) == 0x103);
+}
+
+//	EOF
@@ -0,0 +1,266 @@
+﻿#include "test_util.h"
+#include "test_device.h"
+
+#include <sl12/descriptor_heap.h>
+#include <sl12/descriptor.h>
+#include <memory>
+#include <set>
+#include <thread>
+
+
+namespace
+{
+	static const int kNumThreads = 8;
+
+	D3D12_DESCRIPTOR_HEAP_DESC MakeHeapDesc(sl12::u32 num, bool isShaderVisible)
+	{
+		return D3D12_DESCRIPTOR_HEAP_DESC{
+			D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
+			num,
+			isShaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE,
+			1
+		};
+	}
+
+	// 同じインデックスが同時に2回確保されていないことを確認する
+	class OwnershipTracker
+	{
+	public:
+		OwnershipTracker(sl12::u32 capacity)
+			: owned_(new std::atomic<int>[capacity]), capacity_(capacity)
+		{
+			for (sl12::u32 i = 0; i < capacity; i++)
+			{
+				owned_[i] = 0;
+			}
+		}
+
+		bool Acquire(sl12::u32 index)
+		{
+			return index < capacity_ && owned_[index].exchange(1) == 0;
+		}
+		bool Release(sl12::u32 index)
+		{
+			return index < capacity_ && owned_[index].exchange(0) == 1;
+		}
+
+	private:
+		std::unique_ptr<std::atomic<int>[]>	owned_;
+		sl12::u32							capacity_;
+	};
+}
+
+//----
+// 複数スレッドから確保と解放を繰り返しても、同じデスクリプタが重複して確保されない
+//----
+SL12_TEST(ConcurrentCreateRelease)
+{
+	static const sl12::u32 kNumDescs = 4096;
+	sl12test::TestDevice td;
+	sl12::DescriptorHeap heap;
+	SL12_REQUIRE(heap.Initialize(&td.GetDevice(), MakeHeapDesc(kNumDescs, true)));
+
+	OwnershipTracker tracker(kNumDescs);
+	std::atomic<int> numErrors(0);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < kNumThreads; t++)
+	{
+		threads.emplace_back([&, t]
+		{
+			std::vector<sl12::Descriptor*> mine;
+			for (int i = 0; i < 100000; i++)
+			{
+				// 確保を多めにして、マガジンの補充と返却の両方を発生させる
+				if (mine.size() < 256 && ((i + t) % 3 != 0))
+				{
+					auto p = heap.CreateDescriptor();
+					if (!p || !tracker.Acquire(p->GetIndex()))
+					{
+						numErrors++;
+						continue;
+					}
+					mine.push_back(p);
+				}
+				else if (!mine.empty())
+				{
+					auto p = mine.back();
+					mine.pop_back();
+					if (!tracker.Release(p->GetIndex()))
+					{
+						numErrors++;
+					}
+					p->Release();
+				}
+			}
+			for (auto p : mine)
+			{
+				tracker.Release(p->GetIndex());
+				p->Release();
+			}
+		});
+	}
+	for (auto&& th : threads)
+	{
+		th.join();
+	}
+	SL12_CHECK(numErrors == 0);
+	SL12_CHECK(heap.GetTakeNum() == 0);
+
+	// 他スレッドのマガジンに残った分も含めて、全数を重複なく確保できる
+	std::set<sl12::u32> indices;
+	std::vector<sl12::Descriptor*> all;
+	while (auto p = heap.CreateDescriptor())
+	{
+		indices.insert(p->GetIndex());
+		all.push_back(p);
+	}
+	SL12_CHECK(all.size() == kNumDescs);
+	SL12_CHECK(indices.size() == kNumDescs);
+	for (auto p : all)
+	{
+		p->Release();
+	}
+}
+
+//----
+// 確保したスレッドと別のスレッドで解放できる(ローダースレッドで作成し、メインスレッドで破棄する)
+//----
+SL12_TEST(CrossThreadRelease)
+{
+	static const sl12::u32 kNumDescs = 1024;
+	sl12test::TestDevice td;
+	sl12::DescriptorHeap heap;
+	SL12_REQUIRE(heap.Initialize(&td.GetDevice(), MakeHeapDesc(kNumDescs, true)));
+
+	for (int round = 0; round < 20; round++)
+	{
+		std::vector<sl12::Descriptor*> created[kNumThreads];
+		std::vector<std::thread> threads;
+		for (int t = 0; t < kNumThreads; t++)
+		{
+			threads.emplace_back([&, t]
+			{
+				for (sl12::u32 i = 0; i < kNumDescs / kNumThreads; i++)
+				{
+					if (auto p = heap.CreateDescriptor())
+					{
+						created[t].push_back(p);
+					}
+				}
+			});
+		}
+		for (auto&& th : threads)
+		{
+			th.join();
+		}
+
+		size_t total = 0;
+		for (auto&& v : created)
+		{
+			total += v.size();
+			for (auto p : v)
+			{
+				p->Release();
+			}
+		}
+		SL12_CHECK(total == kNumDescs);
+		SL12_CHECK(heap.GetTakeNum() == 0);
+	}
+}
+
+//----
+// シェーダから参照するヒープは拡張しないので、枯渇時はnullptrを返す
+//----
+SL12_TEST(ExhaustionReturnsNull)
+{
+	static const sl12::u32 kNumDescs = 256;
+	sl12test::TestDevice td;
+	sl12::DescriptorHeap heap;
+	SL12_REQUIRE(heap.Initialize(&td.GetDevice(), MakeHeapDesc(kNumDescs, true)));
+	SL12_CHECK(!heap.IsGrowable());
+
+	// 他スレッドのマガジンに保持されていても枯渇と判定しない
+	std::thread([&]
+	{
+		auto p = heap.CreateDescriptor();
+		p->Release();
+	}).join();
+
+	std::vector<sl12::Descriptor*> all;
+	while (auto p = heap.CreateDescriptor())
+	{
+		all.push_back(p);
+	}
+	SL12_CHECK(all.size() == kNumDescs);
+	SL12_CHECK(heap.CreateDescriptor() == nullptr);
+	SL12_CHECK(heap.GetHighWaterMark() == kNumDescs);
+
+	all.back()->Release();
+	all.pop_back();
+	auto p = heap.CreateDescriptor();
+	SL12_CHECK(p != nullptr);
+	all.push_back(p);
+	for (auto d : all)
+	{
+		d->Release();
+	}
+}
+
+//----
+// CPUのみのヒープは枯渇時にページを追加する. 複数スレッドから同時に拡張しても重複しない
+//----
+SL12_TEST(ConcurrentGrowth)
+{
+	static const sl12::u32 kNumDescs = 128;
+	static const sl12::u32 kPerThread = 200;
+	sl12test::TestDevice td;
+	sl12::DescriptorHeap heap;
+	SL12_REQUIRE(heap.Initialize(&td.GetDevice(), MakeHeapDesc(kNumDescs, false)));
+	SL12_CHECK(heap.IsGrowable());
+
+	std::vector<sl12::Descriptor*> created[kNumThreads];
+	std::vector<std::thread> threads;
+	for (int t = 0; t < kNumThreads; t++)
+	{
+		threads.emplace_back([&, t]
+		{
+			for (sl12::u32 i = 0; i < kPerThread; i++)
+			{
+				if (auto p = heap.CreateDescriptor())
+				{
+					created[t].push_back(p);
+				}
+			}
+		});
+	}
+	for (auto&& th : threads)
+	{
+		th.join();
+	}
+
+	std::set<SIZE_T> handles;
+	size_t total = 0;
+	for (auto&& v : created)
+	{
+		total += v.size();
+		for (auto p : v)
+		{
+			handles.insert(p->GetCpuHandle().ptr);
+		}
+	}
+	SL12_CHECK(total == kNumThreads * kPerThread);
+	SL12_CHECK(handles.size() == total);
+	SL12_CHECK(heap.GetPageCount() > 1);
+	SL12_CHECK(heap.GetCapacity() >= total);
+
+	for (auto&& v : created)
+	{
+		for (auto p : v)
+		{
+			p->Release();
+		}
+	}
+	SL12_CHECK(heap.GetTakeNum() == 0);
+}
+
+//	EOF
@@ -0,0 +1,187 @@
+﻿#include "test_util.h"
+#include "test_device.h"
+
+#include <sl12/descriptor_ring.h>
+#include <sl12/descriptor_table_cache.h>
+#include <sl12/descriptor.h>
+
+
+namespace
+{
+	static const sl12::u32 kNumDescs = 1024;
+	static const sl12::u32 kNumTransients = 256;
+
+	// シェーダから参照するヒープの末尾にリングを持つデバイス
+	bool InitializeRingDevice(sl12test::TestDevice& td)
+	{
+		std::array<sl12::u32, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> nums{ kNumDescs, 64, 64, 64 };
+		std::array<sl12::DescriptorHeapLayout, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> layouts;
+		layouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].numTransients = kNumTransients;
+		return td.InitializeHeaps(nums, layouts);
+	}
+
+	// ステージング用ヒープに識別値を書き込んだデスクリプタを作成する
+	std::vector<sl12::Descriptor*> CreateStaging(sl12test::TestDevice& td, sl12::u32 count)
+	{
+		std::vector<sl12::Descriptor*> ret;
+		auto&& heap = td.GetDevice().GetStagingDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+		for (sl12::u32 i = 0; i < count; i++)
+		{
+			auto p = heap.CreateDescriptor();
+			sl12test::WriteDescriptor(p->GetCpuHandle(), 0x1000 + i);
+			ret.push_back(p);
+		}
+		return ret;
+	}
+
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> GetHandles(const std::vector<sl12::Descriptor*>& descs)
+	{
+		std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> ret;
+		for (auto p : descs)
+		{
+			ret.push_back(p->GetCpuHandle());
+		}
+		return ret;
+	}
+}
+
+//----
+// 同じ並びはヒットし、並び順や長さが異なればミスする. Clear()で全て破棄される
+//----
+SL12_TEST(TableCacheFindInsert)
+{
+	sl12::DescriptorTableCache cache;
+	const sl12::u64 a[] = { 10, 20, 30 };
+	const sl12::u64 b[] = { 30, 20, 10 };
+
+	SL12_CHECK(cache.Find(a, 3) == sl12::DescriptorTableCache::kInvalidIndex);
+	cache.Insert(a, 3, 100);
+	cache.Insert(b, 3, 200);
+	SL12_CHECK(cache.Find(a, 3) == 100);
+	SL12_CHECK(cache.Find(b, 3) == 200);
+	SL12_CHECK(cache.Find(a, 2) == sl12::DescriptorTableCache::kInvalidIndex);
+	SL12_CHECK(cache.GetEntryCount() == 2);
+	SL12_CHECK(cache.GetLookupCount() == 4);
+	SL12_CHECK(cache.GetHitCount() == 2);
+
+	cache.Clear();
+	SL12_CHECK(cache.GetEntryCount() == 0);
+	SL12_CHECK(cache.Find(a, 3) == sl12::DescriptorTableCache::kInvalidIndex);
+}
+
+//----
+// 同一フレーム内の同じテーブルはコピーを省略し、フレームをまたぐとコピーし直す
+//----
+SL12_TEST(CopyTableCachesWithinFrame)
+{
+	sl12test::TestDevice td;
+	SL12_REQUIRE(InitializeRingDevice(td));
+	auto pRing = td.GetDevice().GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).GetTransientRing();
+	SL12_REQUIRE(pRing != nullptr);
+
+	auto descs = CreateStaging(td, 4);
+	auto handles = GetHandles(descs);
+	auto r0 = pRing->CopyTable(handles.data(), 4);
+	auto r1 = pRing->CopyTable(handles.data(), 4);
+	SL12_REQUIRE(r0.IsValid() && r1.IsValid());
+	SL12_CHECK(r0.index == r1.index);
+	for (sl12::u32 i = 0; i < 4; i++)
+	{
+		SL12_CHECK(sl12test::ReadDescriptor(r0.GetCpuHandle(i)) == 0x1000 + i);
+	}
+
+	// 部分的に異なる並びは別のテーブルになる
+	std::swap(handles[0], handles[1]);
+	auto r2 = pRing->CopyTable(handles.data(), 4);
+	SL12_REQUIRE(r2.IsValid());
+	SL12_CHECK(r2.index != r0.index);
+	SL12_CHECK(sl12test::ReadDescriptor(r2.GetCpuHandle(0)) == 0x1001);
+
+	auto&& stats = pRing->GetFrameCopyStats();
+	SL12_CHECK(stats.tableRequests == 3);
+	SL12_CHECK(stats.tableCacheHits == 1);
+	SL12_CHECK(stats.copyCalls == 2);
+	SL12_CHECK(stats.copiedDescriptors == 8);
+
+	pRing->EndFrame(1);
+	SL12_CHECK(pRing->GetLastFrameCopyStats().tableCacheHits == 1);
+	SL12_CHECK(pRing->GetFrameCopyStats().tableRequests == 0);
+	auto r3 = pRing->CopyTable(handles.data(), 4);
+	SL12_CHECK(r3.IsValid() && r3.index != r2.index);
+	SL12_CHECK(pRing->GetFrameCopyStats().tableCacheHits == 0);
+
+	for (auto p : descs)
+	{
+		p->Release();
+	}
+}
+
+//----
+// キャッシュの上限を超えるテーブルはキャッシュせずにコピーする
+//----
+SL12_TEST(CopyTableBypassesCacheForLargeTables)
+{
+	sl12test::TestDevice td;
+	SL12_REQUIRE(InitializeRingDevice(td));
+	auto pRing = td.GetDevice().GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).GetTransientRing();
+	SL12_REQUIRE(pRing != nullptr);
+
+	const sl12::u32 kCount = sl12::DescriptorRing::kMaxCachedTableSize + 1;
+	auto descs = CreateStaging(td, kCount);
+	auto handles = GetHandles(descs);
+	auto r0 = pRing->CopyTable(handles.data(), kCount);
+	auto r1 = pRing->CopyTable(handles.data(), kCount);
+	SL12_REQUIRE(r0.IsValid() && r1.IsValid());
+	SL12_CHECK(r0.index != r1.index);
+	SL12_CHECK(sl12test::ReadDescriptor(r1.GetCpuHandle(kCount - 1)) == 0x1000 + kCount - 1);
+
+	auto&& stats = pRing->GetFrameCopyStats();
+	SL12_CHECK(stats.tableRequests == 2);
+	SL12_CHECK(stats.tableCacheBypasses == 2);
+	SL12_CHECK(stats.tableCacheHits == 0);
+
+	// リングに収まらなくなると無効な領域を返す
+	sl12::u32 numValid = 2;
+	while (pRing->CopyTable(handles.data(), kCount).IsValid())
+	{
+		numValid++;
+	}
+	SL12_CHECK(numValid == kNumTransients / kCount);
+	SL12_CHECK(pRing->GetOverflowCount() == 1);
+
+	for (auto p : descs)
+	{
+		p->Release();
+	}
+}
+
+//----
+// リングが溢れた場合、GetTableGpuHandle()とCreateDescriptorTable()はptrが0のハンドルを返す
+//----
+SL12_TEST(TableHandleOnOverflow)
+{
+	sl12test::TestDevice td;
+	SL12_REQUIRE(InitializeRingDevice(td));
+	auto pRing = td.GetDevice().GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).GetTransientRing();
+	SL12_REQUIRE(pRing != nullptr);
+
+	auto descs = CreateStaging(td, 2);
+	SL12_CHECK(descs[0]->GetTableGpuHandle().ptr != 0);
+	SL12_CHECK(sl12::CreateDescriptorTable(descs.data(), 2).ptr != 0);
+
+	SL12_REQUIRE(pRing->Allocate(pRing->GetCount() - pRing->GetUsedCount()).IsValid());
+	SL12_CHECK(descs[1]->GetTableGpuHandle().ptr == 0);
+	SL12_CHECK(sl12::CreateDescriptorTable(descs.data() + 1, 1).ptr == 0);
+	SL12_CHECK(sl12::CreateDescriptorTable(descs.data(), 0).ptr == 0);
+	SL12_CHECK(pRing->GetOverflowCount() == 2);
+
+	// 同一フレーム内でキャッシュ済みのテーブルは溢れていても取得できる
+	SL12_CHECK(descs[0]->GetTableGpuHandle().ptr != 0);
+
+	for (auto p : descs)
+	{
+		p->Release();
+	}
+}
+
+//	EOF
@@ -0,0 +1,155 @@
+﻿#include "test_util.h"
+#include "test_device.h"
+
+#include <sl12/buffer.h>
+#include <sl12/buffer_view.h>
+#include <sl12/descriptor.h>
+#include <sl12/descriptor_view_cache.h>
+
+
+namespace
+{
+	// ビューキャッシュを有効にしたデバイス
+	bool InitializeViewCacheDevice(sl12test::TestDevice& td, sl12::u32 numBindless = 0)
+	{
+		std::array<sl12::DescriptorHeapLayout, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> layouts;
+		layouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].enableViewCache = true;
+		layouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].numRanges = numBindless;
+		layouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].numBindless = numBindless;
+		return td.InitializeHeaps({ 256, 16, 16, 16 }, layouts);
+	}
+
+	bool InitializeBuffer(sl12test::TestDevice& td, sl12::Buffer& buffer)
+	{
+		return buffer.Initialize(&td.GetDevice(), 256, 16, sl12::BufferUsage::ShaderResource, false, false);
+	}
+}
+
+//----
+// 同じリソースの同じビューはデスクリプタを共有し、最後の参照で解放される
+//----
+SL12_TEST(SameViewShared)
+{
+	sl12test::TestDevice td;
+	SL12_REQUIRE(InitializeViewCacheDevice(td));
+	auto pCache = td.GetDevice().GetViewDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).GetViewCache();
+	SL12_REQUIRE(pCache != nullptr);
+
+	sl12::Buffer buffer;
+	SL12_REQUIRE(InitializeBuffer(td, buffer));
+
+	sl12::BufferView v0, v1, v2;
+	SL12_REQUIRE(v0.Initialize(&td.GetDevice(), &buffer, 0, 16));
+	SL12_REQUIRE(v1.Initialize(&td.GetDevice(), &buffer, 0, 16));
+	SL12_REQUIRE(v2.Initialize(&td.GetDevice(), &buffer, 1, 16));
+	SL12_CHECK(v0.GetDesc() == v1.GetDesc());
+	SL12_CHECK(v0.GetDesc() != v2.GetDesc());
+	SL12_CHECK(pCache->GetDescriptorCount() == 2);
+	SL12_CHECK(pCache->GetReferenceCount() == 3);
+
+	v0.Destroy();
+	SL12_CHECK(pCache->GetDescriptorCount() == 2);
+	v1.Destroy();
+	v2.Destroy();
+	SL12_CHECK(pCache->GetDescriptorCount() == 0);
+	SL12_CHECK(pCache->GetReferenceCount() == 0);
+}
+
+//----
+// 作り直したリソースは同じアドレスでも別のIDを持ち、古いビューのデスクリプタを再利用しない
+//----
+SL12_TEST(RecreatedResourceMisses)
+{
+	sl12test::TestDevice td;
+	SL12_REQUIRE(InitializeViewCacheDevice(td));
+	auto pCache = td.GetDevice().GetViewDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).GetViewCache();
+
+	sl12::Buffer buffer;
+	SL12_REQUIRE(InitializeBuffer(td, buffer));
+	sl12::u64 oldId = buffer.GetResourceId();
+	SL12_CHECK(oldId != 0);
+
+	// 古いビューを保持したままリソースを作り直す
+	sl12::BufferView oldView;
+	SL12_REQUIRE(oldView.Initialize(&td.GetDevice(), &buffer, 0, 16));
+	buffer.Destroy();
+	SL12_CHECK(buffer.GetResourceId() == 0);
+	SL12_REQUIRE(InitializeBuffer(td, buffer));
+	SL12_CHECK(buffer.GetResourceId() != oldId);
+
+	sl12::BufferView newView;
+	SL12_REQUIRE(newView.Initialize(&td.GetDevice(), &buffer, 0, 16));
+	SL12_CHECK(newView.GetDesc() != oldView.GetDesc());
+	SL12_CHECK(pCache->GetDescriptorCount() == 2);
+	SL12_CHECK(pCache->GetHitCount() == 0);
+	SL12_CHECK(sl12test::ReadDescriptor(newView.GetDesc()->GetCpuHandle()) == reinterpret_cast<sl12::u64>(buffer.GetResourceDep()));
+}
+
+//----
+// 共有したビューはバインドレスインデックスも共有し、最後の参照でテーブルに返す
+//----
+SL12_TEST(SharedViewSharesBindlessIndex)
+{
+	sl12test::TestDevice td;
+	SL12_REQUIRE(InitializeViewCacheDevice(td, 4));
+	auto pTable = td.GetDevice().GetBindlessTable();
+	SL12_REQUIRE(pTable != nullptr);
+
+	sl12::Buffer buffer;
+	SL12_REQUIRE(InitializeBuffer(td, buffer));
+
+	sl12::BufferView v0, v1, v2;
+	SL12_REQUIRE(v0.Initialize(&td.GetDevice(), &buffer, 0, 16));
+	SL12_REQUIRE(v1.Initialize(&td.GetDevice(), &buffer, 0, 16));
+	SL12_REQUIRE(v2.Initialize(&td.GetDevice(), &buffer, 1, 16));
+	SL12_CHECK(v0.GetBindlessIndex() != sl12::BindlessDescriptorTable::kInvalidIndex);
+	SL12_CHECK(v0.GetBindlessIndex() == v1.GetBindlessIndex());
+	SL12_CHECK(v0.GetBindlessIndex() != v2.GetBindlessIndex());
+	SL12_CHECK(pTable->GetRegisteredCount() == 2);
+
+	// 容量内であれば同じビューを何度作成してもスロットを消費しない
+	std::vector<sl12::BufferView> views(8);
+	for (auto&& v : views)
+	{
+		SL12_REQUIRE(v.Initialize(&td.GetDevice(), &buffer, 0, 16));
+		SL12_CHECK(v.GetBindlessIndex() == v0.GetBindlessIndex());
+	}
+	SL12_CHECK(pTable->GetRegisteredCount() == 2);
+	views.clear();
+
+	v0.Destroy();
+	SL12_CHECK(pTable->GetRegisteredCount() == 2);
+	v1.Destroy();
+	SL12_CHECK(pTable->GetRegisteredCount() == 1);
+	v2.Destroy();
+	SL12_CHECK(pTable->GetRegisteredCount() == 0);
+}
+
+//----
+// ビューキャッシュが無効な場合はビューごとにスロットを割り当てる
+//----
+SL12_TEST(UncachedViewOwnsBindlessIndex)
+{
+	sl12test::TestDevice td;
+	std::array<sl12::DescriptorHeapLayout, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> layouts;
+	layouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].numRanges = 4;
+	layouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].numBindless = 4;
+	SL12_REQUIRE(td.InitializeHeaps({ 256, 16, 16, 16 }, layouts));
+	auto pTable = td.GetDevice().GetBindlessTable();
+
+	sl12::Buffer buffer;
+	SL12_REQUIRE(InitializeBuffer(td, buffer));
+
+	sl12::BufferView v0, v1;
+	SL12_REQUIRE(v0.Initialize(&td.GetDevice(), &buffer, 0, 16));
+	SL12_REQUIRE(v1.Initialize(&td.GetDevice(), &buffer, 0, 16));
+	SL12_CHECK(v0.GetBindlessIndex() != v1.GetBindlessIndex());
+	SL12_CHECK(pTable->GetRegisteredCount() == 2);
+
+	v0.Destroy();
+	SL12_CHECK(pTable->GetRegisteredCount() == 1);
+	v1.Destroy();
+	SL12_CHECK(pTable->GetRegisteredCount() == 0);
+}
+
+//	EOF
@@ -0,0 +1,136 @@
+﻿#pragma once
+
+#include "fake_d3d12.h"
+
+#include <sl12/util.h>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Initialize()を経由せずに偽オブジェクトを設定するため、非公開メンバを参照する
+#define private public
+#include <sl12/device.h>
+#include <sl12/command_queue.h>
+#include <sl12/command_list.h>
+#undef private
+#include <sl12/descriptor_heap.h>
+#include <sl12/bindless_descriptor_table.h>
+
+
+namespace sl12test
+{
+	/*************************************************//**
+	 * @brief 偽のD3D12デバイスを使用するsl12::Device
+	 *
+	 * スワップチェインは作成しない. キューのフェンスは偽のGPUの実行時に進む.
+	*****************************************************/
+	class TestDevice
+	{
+	public:
+		TestDevice()
+		{
+			pFake_ = new FakeDevice();
+			device_.pDevice_ = pFake_;
+
+			device_.pGraphicsQueue_ = CreateQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
+			device_.pComputeQueue_ = CreateQueue(D3D12_COMMAND_LIST_TYPE_COMPUTE);
+			device_.pCopyQueue_ = CreateQueue(D3D12_COMMAND_LIST_TYPE_COPY);
+
+			device_.pFence_ = new FakeFence();
+			device_.fenceValue_ = 1;
+			device_.fenceEvent_ = CreateEventEx(nullptr, FALSE, FALSE, EVENT_ALL_ACCESS);
+		}
+		~TestDevice()
+		{
+			RunGpu();
+			device_.Destroy();
+		}
+
+		/**
+		 * @brief Device::Initialize()と同じ構成でデスクリプタヒープを作成する
+		*/
+		bool InitializeHeaps(const std::array<sl12::u32, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES>& numDescs, const std::array<sl12::DescriptorHeapLayout, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES>& layouts = std::array<sl12::DescriptorHeapLayout, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES>())
+		{
+			device_.pDescHeaps_ = new sl12::DescriptorHeap[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+			device_.pStagingDescHeaps_ = new sl12::DescriptorHeap[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+			for (sl12::u32 i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; i++)
+			{
+				bool isShaderVisible = (i == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV) || (i == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+				D3D12_DESCRIPTOR_HEAP_DESC desc{
+					(D3D12_DESCRIPTOR_HEAP_TYPE)i,
+					numDescs[i],
+					isShaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE,
+					1
+				};
+				if (!device_.pDescHeaps_[i].Initialize(&device_, desc, layouts[i]))
+				{
+					return false;
+				}
+				if (isShaderVisible)
+				{
+					desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+					sl12::DescriptorHeapLayout layout;
+					layout.enableViewCache = layouts[i].enableViewCache;
+					if (!device_.pStagingDescHeaps_[i].Initialize(&device_, desc, layout))
+					{
+						return false;
+					}
+				}
+			}
+			if (layouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].numBindless > 0)
+			{
+				device_.pBindlessTable_ = new sl12::BindlessDescriptorTable();
+				if (!device_.pBindlessTable_->Initialize(&device_, layouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].numBindless))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// getter
+		sl12::Device& GetDevice() { return device_; }
+		FakeDevice& GetFake() { return *pFake_; }
+		FakeFence& GetFence() { return *static_cast<FakeFence*>(device_.pFence_); }
+
+	private:
+		sl12::CommandQueue* CreateQueue(D3D12_COMMAND_LIST_TYPE type)
+		{
+			auto ret = new sl12::CommandQueue();
+			ret->pQueue_ = new FakeCommandQueue();
+			ret->listType_ = type;
+			return ret;
+		}
+
+	private:
+		sl12::Device	device_;
+		FakeDevice*		pFake_;		// device_が所有する
+	};	// class TestDevice
+
+	/*************************************************//**
+	 * @brief 偽のコマンドリストを記録先とするsl12::CommandList
+	*****************************************************/
+	class TestCommandList
+	{
+	public:
+		TestCommandList(sl12::CommandQueue* pQueue)
+		{
+			pFake_ = new FakeCommandList();
+			cmdList_.pParentQueue_ = pQueue;
+			cmdList_.pCmdList_ = pFake_;
+		}
+
+		// getter
+		sl12::CommandList& Get() { return cmdList_; }
+		FakeCommandList& GetFake() { return *pFake_; }
+
+	private:
+		sl12::CommandList	cmdList_;
+		FakeCommandList*	pFake_;		// cmdList_が所有する
+	};	// class TestCommandList
+
+}	// namespace sl12test
+
+//	EOF
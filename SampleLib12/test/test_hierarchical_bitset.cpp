@@ -0,0 +1,98 @@
+﻿#include "test_util.h"
+
+#include <sl12/hierarchical_bitset.h>
+#include <sl12/bit_ops.h>
+#include <random>
+
+
+//----
+// ビットスキャンの境界値
+//----
+SL12_TEST(BitScan)
+{
+	SL12_CHECK(sl12::FindFirstBit32(0) == -1);
+	SL12_CHECK(sl12::FindFirstBit32(1) == 0);
+	SL12_CHECK(sl12::FindFirstBit32(0x80000000u) == 31);
+	SL12_CHECK(sl12::FindLastBit32(0x80000001u) == 31);
+	SL12_CHECK(sl12::FindLastBit32(1) == 0);
+	SL12_CHECK(sl12::FindFirstBit64(0) == -1);
+	SL12_CHECK(sl12::FindFirstBit64(1ull << 63) == 63);
+	SL12_CHECK(sl12::FindFirstBit64(0x0000010000000100ull) == 8);
+}
+
+//----
+// ランダムな操作の結果をstd::vector<bool>と比較する
+//----
+SL12_TEST(MatchesReference)
+{
+	// 1層, 2層, 3層になる要素数と、ワード境界に揃わない要素数
+	for (sl12::u32 count : { 1u, 63u, 64u, 65u, 4096u, 4097u, 65535u, 262145u })
+	{
+		for (bool initial : { false, true })
+		{
+			sl12::HierarchicalBitset bits;
+			bits.Initialize(count, initial);
+			std::vector<bool> ref(count, initial);
+			sl12::u32 setCount = initial ? count : 0;
+			SL12_REQUIRE(bits.GetCount() == count);
+			SL12_REQUIRE(bits.GetSetCount() == setCount);
+
+			std::mt19937 rng(count);
+			for (int step = 0; step < 20000; step++)
+			{
+				sl12::u32 index = rng() % count;
+				if (rng() % 2)
+				{
+					setCount += ref[index] ? 0 : 1;
+					ref[index] = true;
+					bits.Set(index);
+				}
+				else
+				{
+					setCount -= ref[index] ? 1 : 0;
+					ref[index] = false;
+					bits.Reset(index);
+				}
+				SL12_REQUIRE(bits.Test(index) == ref[index]);
+				SL12_REQUIRE(bits.GetSetCount() == setCount);
+
+				if ((step % 16) == 0)
+				{
+					sl12::u32 expected = sl12::HierarchicalBitset::kInvalidIndex;
+					for (sl12::u32 i = 0; i < count; i++)
+					{
+						if (ref[i])
+						{
+							expected = i;
+							break;
+						}
+					}
+					SL12_REQUIRE(bits.FindFirstSet() == expected);
+				}
+			}
+		}
+	}
+}
+
+//----
+// 先頭から順に取り出すと、インデックスの昇順になり、最後は無効値を返す
+//----
+SL12_TEST(DrainInOrder)
+{
+	static const sl12::u32 kCount = 10000;
+	sl12::HierarchicalBitset bits;
+	bits.Initialize(kCount, true);
+	for (sl12::u32 i = 0; i < kCount; i++)
+	{
+		sl12::u32 index = bits.FindFirstSet();
+		SL12_REQUIRE(index == i);
+		bits.Reset(index);
+	}
+	SL12_CHECK(bits.FindFirstSet() == sl12::HierarchicalBitset::kInvalidIndex);
+	SL12_CHECK(bits.GetSetCount() == 0);
+
+	bits.Set(kCount - 1);
+	SL12_CHECK(bits.FindFirstSet() == kCount - 1);
+}
+
+//	EOF
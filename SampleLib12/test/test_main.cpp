@@ -0,0 +1,9 @@
+﻿#include "test_util.h"
+
+
+int main(int argc, char* argv[])
+{
+	return sl12test::RunAllTests(argc, argv);
+}
+
+//	EOF
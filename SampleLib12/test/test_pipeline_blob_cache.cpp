@@ -0,0 +1,333 @@
+﻿#include "test_util.h"
+
+#include <sl12/pipeline_blob_cache.h>
+#include <sl12/crc.h>
+#include <cstdio>
+#include <map>
+#include <random>
+
+
+namespace
+{
+	// ヘッダ(magic, version, 識別情報, エントリ数)とインデックス1エントリ(key, offset, size, crc)のサイズ
+	static const size_t kHeaderSize = 4 + 4 + 4 * 4 + 8 + 4;
+	static const size_t kIndexEntrySize = 8 + 8 + 4 + 4;
+
+	sl12::PipelineCacheIdentity MakeIdentity()
+	{
+		sl12::PipelineCacheIdentity id;
+		id.vendorId = 0x10de;
+		id.deviceId = 0x2684;
+		id.subSysId = 0x889a1043;
+		id.revision = 0xa1;
+		id.driverVersion = 0x001f000e000f1234ull;
+		return id;
+	}
+
+	// キーごとに長さと内容の異なるブロブ
+	std::vector<sl12::u8> MakeBlob(sl12::u64 key, size_t size)
+	{
+		std::vector<sl12::u8> blob(size);
+		std::mt19937 rng(static_cast<unsigned>(key));
+		for (auto&& v : blob) v = static_cast<sl12::u8>(rng());
+		return blob;
+	}
+
+	std::map<sl12::u64, std::vector<sl12::u8>> MakeBlobs(sl12::u32 count)
+	{
+		std::map<sl12::u64, std::vector<sl12::u8>> blobs;
+		for (sl12::u32 i = 0; i < count; i++)
+		{
+			sl12::u64 key = 0x9e3779b97f4a7c15ull * (i + 1);
+			blobs[key] = MakeBlob(key, 64 + i * 37);
+		}
+		return blobs;
+	}
+
+	std::vector<sl12::u8> SaveBlobs(const std::map<sl12::u64, std::vector<sl12::u8>>& blobs)
+	{
+		sl12::PipelineBlobCache cache;
+		cache.SetIdentity(MakeIdentity());
+		for (auto&& v : blobs)
+		{
+			cache.Store(v.first, v.second.data(), v.second.size());
+		}
+		std::vector<sl12::u8> data;
+		cache.SaveToMemory(data);
+		return data;
+	}
+
+	// 読み込めたエントリが全て元の内容と一致するか
+	bool IsConsistent(sl12::PipelineBlobCache& cache, const std::map<sl12::u64, std::vector<sl12::u8>>& blobs, sl12::u32* pNumFound = nullptr)
+	{
+		sl12::u32 numFound = 0;
+		for (auto&& v : blobs)
+		{
+			std::vector<sl12::u8> blob;
+			if (cache.Find(v.first, blob))
+			{
+				if (blob != v.second)
+				{
+					return false;
+				}
+				numFound++;
+			}
+		}
+		if (pNumFound)
+		{
+			*pNumFound = numFound;
+		}
+		return true;
+	}
+
+	template <typename T>
+	void Poke(std::vector<sl12::u8>& data, size_t offset, T value)
+	{
+		memcpy(data.data() + offset, &value, sizeof(value));
+	}
+}
+
+//----
+// 保存したキャッシュを読み込むと同じ内容が得られ、参照されたエントリのみが再保存される
+//----
+SL12_TEST(RoundTrip)
+{
+	auto blobs = MakeBlobs(16);
+	auto data = SaveBlobs(blobs);
+
+	size_t blobBytes = 0;
+	for (auto&& v : blobs) blobBytes += v.second.size();
+	SL12_CHECK(data.size() == kHeaderSize + kIndexEntrySize * blobs.size() + blobBytes);
+
+	sl12::PipelineBlobCache cache;
+	cache.SetIdentity(MakeIdentity());
+	SL12_REQUIRE(cache.LoadFromMemory(data.data(), data.size()));
+	SL12_CHECK(cache.GetEntryCount() == 16);
+	SL12_CHECK(cache.GetDiscardCount() == 0);
+
+	// 読み込んだだけのエントリは保存されない
+	std::vector<sl12::u8> resaved;
+	cache.SaveToMemory(resaved);
+	SL12_CHECK(resaved.size() == kHeaderSize);
+
+	// 参照したエントリと新規に登録したエントリのみ保存される
+	std::vector<sl12::u8> blob;
+	std::vector<sl12::u64> usedKeys;
+	for (auto&& v : blobs)
+	{
+		if (usedKeys.size() < 5)
+		{
+			SL12_CHECK(cache.Find(v.first, blob));
+			SL12_CHECK(blob == v.second);
+			usedKeys.push_back(v.first);
+		}
+	}
+	SL12_CHECK(!cache.Find(1, blob));
+	SL12_CHECK(cache.GetHitCount() == 5);
+	SL12_CHECK(cache.GetMissCount() == 1);
+	auto extra = MakeBlob(1, 100);
+	cache.Store(1, extra.data(), extra.size());
+	cache.Remove(usedKeys[0]);
+	cache.SaveToMemory(resaved);
+
+	sl12::PipelineBlobCache reloaded;
+	reloaded.SetIdentity(MakeIdentity());
+	SL12_REQUIRE(reloaded.LoadFromMemory(resaved.data(), resaved.size()));
+	SL12_CHECK(reloaded.GetEntryCount() == 5);
+	SL12_CHECK(!reloaded.Find(usedKeys[0], blob));
+	SL12_CHECK(reloaded.Find(usedKeys[4], blob) && blob == blobs[usedKeys[4]]);
+	SL12_CHECK(reloaded.Find(1, blob) && blob == extra);
+
+	// 空のブロブは登録しない
+	reloaded.Store(2, extra.data(), 0);
+	reloaded.Store(3, nullptr, 16);
+	SL12_CHECK(reloaded.GetEntryCount() == 5);
+}
+
+//----
+// ファイル経由の保存と読み込み
+//----
+SL12_TEST(FileRoundTrip)
+{
+	auto path = sl12test::GetTempFilePath("pipeline.cache");
+	auto blobs = MakeBlobs(8);
+	{
+		sl12::PipelineBlobCache cache;
+		cache.SetIdentity(MakeIdentity());
+		for (auto&& v : blobs) cache.Store(v.first, v.second.data(), v.second.size());
+		SL12_REQUIRE(cache.Save(path.c_str()));
+	}
+
+	sl12::PipelineBlobCache cache;
+	cache.SetIdentity(MakeIdentity());
+	SL12_CHECK(cache.Load(path.c_str()));
+	sl12::u32 numFound = 0;
+	SL12_CHECK(IsConsistent(cache, blobs, &numFound));
+	SL12_CHECK(numFound == 8);
+	remove(path.c_str());
+
+	// ファイルがない場合は空のキャッシュになる
+	SL12_CHECK(!cache.Load(path.c_str()));
+	SL12_CHECK(cache.GetEntryCount() == 0);
+	SL12_CHECK(!cache.LoadFromMemory(nullptr, 0));
+}
+
+//----
+// アダプタやドライバが異なるファイルは全体を破棄する
+//----
+SL12_TEST(IdentityMismatchDiscardsAll)
+{
+	auto data = SaveBlobs(MakeBlobs(4));
+
+	typedef void (*IdentityMutation)(sl12::PipelineCacheIdentity&);
+	const IdentityMutation kMutations[] = {
+		[](sl12::PipelineCacheIdentity& id) { id.vendorId = 0x1002; },
+		[](sl12::PipelineCacheIdentity& id) { id.deviceId++; },
+		[](sl12::PipelineCacheIdentity& id) { id.subSysId++; },
+		[](sl12::PipelineCacheIdentity& id) { id.revision++; },
+		[](sl12::PipelineCacheIdentity& id) { id.driverVersion++; },
+	};
+	for (auto&& m : kMutations)
+	{
+		auto id = MakeIdentity();
+		m(id);
+		sl12::PipelineBlobCache cache;
+		cache.SetIdentity(id);
+		SL12_CHECK(!cache.LoadFromMemory(data.data(), data.size()));
+		SL12_CHECK(cache.GetEntryCount() == 0);
+	}
+}
+
+//----
+// ヘッダやインデックスが壊れている場合は全体を破棄する
+//----
+SL12_TEST(CorruptHeaderDiscardsAll)
+{
+	auto blobs = MakeBlobs(4);
+	auto data = SaveBlobs(blobs);
+
+	auto CheckRejected = [&](const std::vector<sl12::u8>& d)
+	{
+		sl12::PipelineBlobCache cache;
+		cache.SetIdentity(MakeIdentity());
+		return !cache.LoadFromMemory(d.data(), d.size()) && cache.GetEntryCount() == 0;
+	};
+
+	// magic, version
+	auto d = data;
+	Poke<sl12::u32>(d, 0, 0);
+	SL12_CHECK(CheckRejected(d));
+	d = data;
+	Poke<sl12::u32>(d, 4, sl12::PipelineBlobCache::kVersion + 1);
+	SL12_CHECK(CheckRejected(d));
+
+	// インデックスがファイルに収まらないエントリ数
+	d = data;
+	Poke<sl12::u32>(d, kHeaderSize - 4, 0x10000000);
+	SL12_CHECK(CheckRejected(d));
+
+	// キー順でないインデックス
+	d = data;
+	sl12::u64 key0, key1;
+	memcpy(&key0, d.data() + kHeaderSize, sizeof(key0));
+	memcpy(&key1, d.data() + kHeaderSize + kIndexEntrySize, sizeof(key1));
+	Poke(d, kHeaderSize, key1);
+	Poke(d, kHeaderSize + kIndexEntrySize, key0);
+	SL12_CHECK(CheckRejected(d));
+
+	// インデックスの途中までの切り詰め
+	for (size_t size = 0; size < kHeaderSize + kIndexEntrySize * blobs.size(); size++)
+	{
+		d.assign(data.begin(), data.begin() + size);
+		SL12_CHECK(CheckRejected(d));
+	}
+}
+
+//----
+// データ領域が壊れているエントリのみを破棄し、他のエントリは使用する
+//----
+SL12_TEST(CorruptEntryDiscardsOnlyThatEntry)
+{
+	auto blobs = MakeBlobs(4);
+	auto data = SaveBlobs(blobs);
+	size_t indexEnd = kHeaderSize + kIndexEntrySize * blobs.size();
+
+	auto LoadAndCount = [&](const std::vector<sl12::u8>& d, sl12::u32& numFound, sl12::u32& numDiscarded)
+	{
+		sl12::PipelineBlobCache cache;
+		cache.SetIdentity(MakeIdentity());
+		bool ret = cache.LoadFromMemory(d.data(), d.size()) && IsConsistent(cache, blobs, &numFound);
+		numDiscarded = cache.GetDiscardCount();
+		return ret;
+	};
+	sl12::u32 numFound, numDiscarded;
+
+	// 先頭エントリのデータ
+	auto d = data;
+	d[indexEnd] ^= 0x01;
+	SL12_CHECK(LoadAndCount(d, numFound, numDiscarded));
+	SL12_CHECK(numFound == 3 && numDiscarded == 1);
+
+	// 2番目のエントリのCRC
+	d = data;
+	d[kHeaderSize + kIndexEntrySize + 20] ^= 0x80;
+	SL12_CHECK(LoadAndCount(d, numFound, numDiscarded));
+	SL12_CHECK(numFound == 3 && numDiscarded == 1);
+
+	// 範囲外のオフセットとサイズ、サイズ0
+	d = data;
+	Poke<sl12::u64>(d, kHeaderSize + 8, 0xffffffffffffff00ull);
+	Poke<sl12::u32>(d, kHeaderSize + kIndexEntrySize + 16, 0xffffffff);
+	Poke<sl12::u32>(d, kHeaderSize + kIndexEntrySize * 2 + 16, 0);
+	SL12_CHECK(LoadAndCount(d, numFound, numDiscarded));
+	SL12_CHECK(numFound == 1 && numDiscarded == 3);
+
+	// データ領域の切り詰めでは末尾のエントリから破棄される
+	sl12::u32 prevFound = 4;
+	for (size_t size = data.size(); size >= indexEnd; size--)
+	{
+		d.assign(data.begin(), data.begin() + size);
+		SL12_CHECK(LoadAndCount(d, numFound, numDiscarded));
+		SL12_CHECK(numFound + numDiscarded == 4);
+		SL12_CHECK(numFound <= prevFound);
+		prevFound = numFound;
+	}
+	SL12_CHECK(prevFound == 0);
+}
+
+//----
+// ランダムなバイトを書き換えても、元と異なる内容のエントリは読み込まれない
+//----
+SL12_TEST(RandomCorruption)
+{
+	auto blobs = MakeBlobs(8);
+	auto data = SaveBlobs(blobs);
+
+	std::mt19937 rng(1234);
+	int numLoaded = 0;
+	for (int i = 0; i < 2000; i++)
+	{
+		auto d = data;
+		int numFlips = 1 + static_cast<int>(rng() % 4);
+		for (int f = 0; f < numFlips; f++)
+		{
+			d[rng() % d.size()] ^= static_cast<sl12::u8>(1 + rng() % 255);
+		}
+		if (rng() % 4 == 0)
+		{
+			d.resize(rng() % d.size());
+		}
+
+		sl12::PipelineBlobCache cache;
+		cache.SetIdentity(MakeIdentity());
+		if (cache.LoadFromMemory(d.data(), d.size()))
+		{
+			numLoaded++;
+		}
+		SL12_CHECK(IsConsistent(cache, blobs));
+	}
+	// 破損がデータ領域のみの場合は読み込みに成功する
+	SL12_CHECK(numLoaded > 0);
+}
+
+//	EOF
@@ -0,0 +1,129 @@
+﻿#include "test_util.h"
+#include "test_device.h"
+
+#include <sl12/pipeline_compiler.h>
+#include <sl12/pipeline_state_cache.h>
+#include <sl12/root_signature.h>
+#include <sl12/shader.h>
+#include <chrono>
+#include <vector>
+
+
+namespace
+{
+	bool IsReady(const std::shared_future<sl12::PipelineStateHandle>& f)
+	{
+		return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+
+	// 偽のデバイスはバイトコードを参照しないので、中身は任意のバイト列でよい
+	struct ComputeSources
+	{
+		sl12test::TestDevice	td;
+		sl12::Shader			shaders[4];
+		sl12::RootSignature		rootSig;
+
+		bool Initialize()
+		{
+			for (sl12::u32 i = 0; i < 4; i++)
+			{
+				sl12::u8 code[16] = { 'D', 'X', 'B', 'C', static_cast<sl12::u8>(i) };
+				if (!shaders[i].Initialize(&td.GetDevice(), sl12::ShaderType::Compute, code, sizeof(code)))
+				{
+					return false;
+				}
+			}
+			sl12::u32 serialized[2] = { 1, 0 };
+			return rootSig.Initialize(&td.GetDevice(), sl12::RootSignatureDesc(), serialized, sizeof(serialized));
+		}
+
+		sl12::ComputePipelineStateDesc MakeDesc(sl12::u32 index)
+		{
+			sl12::ComputePipelineStateDesc desc;
+			desc.pRootSignature = &rootSig;
+			desc.pCS = &shaders[index];
+			return desc;
+		}
+	};	// struct ComputeSources
+}
+
+//----
+// 初期化前の要求はデバイスに触れず、失敗した結果がすぐに返る
+//----
+SL12_TEST(UninitializedReturnsFailure)
+{
+	ComputeSources src;
+	SL12_REQUIRE(src.Initialize());
+
+	sl12::PipelineCompiler compiler;
+	auto compute = compiler.CompileCompute(src.MakeDesc(0));
+	SL12_CHECK(IsReady(compute));
+	SL12_CHECK(!compute.get().IsValid());
+
+	sl12::GraphicsPipelineStateDesc graphics;
+	auto gfx = compiler.CompileGraphics(graphics);
+	SL12_CHECK(IsReady(gfx));
+	SL12_CHECK(!gfx.get().IsValid());
+
+	auto dxr = compiler.CompileDxr(nullptr, nullptr);
+	SL12_CHECK(dxr.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+	SL12_CHECK(!dxr.get());
+
+	SL12_CHECK(compiler.GetFailedCount() == 3);
+	SL12_CHECK(compiler.IsAllReady());
+	SL12_CHECK(src.td.GetFake().numPipelinesCreated == 0);
+
+	// 破棄後も同様
+	sl12::PipelineStateCache cache;
+	SL12_REQUIRE(cache.Initialize(&src.td.GetDevice()));
+	SL12_REQUIRE(compiler.Initialize(&src.td.GetDevice(), &cache, 1));
+	compiler.Destroy();
+	SL12_CHECK(!compiler.CompileCompute(src.MakeDesc(0)).get().IsValid());
+	SL12_CHECK(src.td.GetFake().numPipelinesCreated == 0);
+	cache.Destroy();
+}
+
+//----
+// ワーカーでコンパイルし、同じ記述子はキャッシュで1回だけ生成される
+//----
+SL12_TEST(CompileComputeOnWorkers)
+{
+	ComputeSources src;
+	SL12_REQUIRE(src.Initialize());
+	sl12::PipelineStateCache cache;
+	SL12_REQUIRE(cache.Initialize(&src.td.GetDevice()));
+
+	sl12::PipelineCompiler compiler;
+	SL12_REQUIRE(compiler.Initialize(&src.td.GetDevice(), &cache, 2));
+	SL12_CHECK(compiler.GetWorkerCount() == 2);
+
+	std::vector<std::shared_future<sl12::PipelineStateHandle>> futures;
+	for (sl12::u32 i = 0; i < 16; i++)
+	{
+		futures.push_back(compiler.CompileCompute(src.MakeDesc(i % 4)));
+	}
+	compiler.WaitAll();
+	SL12_CHECK(compiler.IsAllReady());
+	SL12_CHECK(compiler.GetFailedCount() == 0);
+	for (sl12::u32 i = 0; i < 16; i++)
+	{
+		SL12_REQUIRE(IsReady(futures[i]));
+		auto h = futures[i].get();
+		SL12_CHECK(h.IsValid());
+		SL12_CHECK(h.GetPSO() != nullptr);
+		SL12_CHECK(h.GetKey() == futures[i % 4].get().GetKey());
+	}
+	SL12_CHECK(src.td.GetFake().numPipelinesCreated == 4);
+	SL12_CHECK(cache.GetInstanceCount() == 4);
+
+	// 記述子が不正な場合は無効なハンドルが返り、失敗として数える
+	sl12::ComputePipelineStateDesc invalid;
+	SL12_CHECK(!compiler.CompileCompute(invalid).get().IsValid());
+	SL12_CHECK(compiler.GetFailedCount() == 1);
+
+	futures.clear();
+	compiler.Destroy();
+	cache.Destroy();
+}
+
+//	EOF
@@ -0,0 +1,375 @@
+﻿#include "test_util.h"
+#include "test_device.h"
+
+#include <sl12/pipeline_state_cache.h>
+#include <sl12/root_signature.h>
+#include <sl12/shader.h>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+	// キーはバイトコードとシリアライズ結果のハッシュ値のみを参照するので、中身は任意のバイト列でよい
+	struct KeySources
+	{
+		sl12test::TestDevice	td;
+		sl12::Shader			shaders[3];
+		sl12::RootSignature		rootSigs[2];
+
+		bool Initialize()
+		{
+			for (sl12::u32 i = 0; i < 3; i++)
+			{
+				sl12::u8 code[16] = { 'D', 'X', 'B', 'C', static_cast<sl12::u8>(i) };
+				if (!shaders[i].Initialize(&td.GetDevice(), sl12::ShaderType::Vertex, code, sizeof(code)))
+				{
+					return false;
+				}
+			}
+			for (sl12::u32 i = 0; i < 2; i++)
+			{
+				sl12::u32 serialized[2] = { i, 0 };
+				if (!rootSigs[i].Initialize(&td.GetDevice(), sl12::RootSignatureDesc(), serialized, sizeof(serialized)))
+				{
+					return false;
+				}
+			}
+			return shaders[0].GetHash() != shaders[1].GetHash() && rootSigs[0].GetHash() != rootSigs[1].GetHash();
+		}
+	};	// struct KeySources
+
+	// 全フィールドが既定値以外の記述子
+	// 入力レイアウトは呼び出し側の配列を参照する
+	sl12::GraphicsPipelineStateDesc MakeGraphicsDesc(KeySources& src, const D3D12_INPUT_ELEMENT_DESC* pElements, sl12::u32 numElements)
+	{
+		sl12::GraphicsPipelineStateDesc desc;
+		desc.pRootSignature = &src.rootSigs[0];
+		desc.pVS = &src.shaders[0];
+		desc.pPS = &src.shaders[1];
+
+		desc.blend.sampleMask = 0xffffffff;
+		for (auto&& rt : desc.blend.rtDesc)
+		{
+			rt.srcBlendColor = D3D12_BLEND_ONE;
+			rt.dstBlendColor = D3D12_BLEND_ZERO;
+			rt.blendOpColor = D3D12_BLEND_OP_ADD;
+			rt.srcBlendAlpha = D3D12_BLEND_ONE;
+			rt.dstBlendAlpha = D3D12_BLEND_ZERO;
+			rt.blendOpAlpha = D3D12_BLEND_OP_ADD;
+			rt.logicOp = D3D12_LOGIC_OP_NOOP;
+			rt.writeMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+		}
+
+		desc.rasterizer.fillMode = D3D12_FILL_MODE_SOLID;
+		desc.rasterizer.cullMode = D3D12_CULL_MODE_BACK;
+		desc.rasterizer.isDepthClipEnable = true;
+
+		desc.depthStencil.isDepthEnable = true;
+		desc.depthStencil.isDepthWriteEnable = true;
+		desc.depthStencil.depthFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL;
+		desc.depthStencil.stencilReadMask = 0xff;
+		desc.depthStencil.stencilWriteMask = 0xff;
+		desc.depthStencil.stencilFrontFace = { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS };
+		desc.depthStencil.stencilBackFace = desc.depthStencil.stencilFrontFace;
+
+		desc.inputLayout.pElements = pElements;
+		desc.inputLayout.numElements = numElements;
+
+		desc.primTopology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+		desc.numRTVs = 2;
+		desc.rtvFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+		desc.rtvFormats[1] = DXGI_FORMAT_R16G16B16A16_FLOAT;
+		desc.dsvFormat = DXGI_FORMAT_D32_FLOAT;
+		return desc;
+	}
+
+	struct Mutation
+	{
+		const char*													name;
+		std::function<void(sl12::GraphicsPipelineStateDesc&)>		func;
+	};	// struct Mutation
+
+	// 要素は呼び出しごとに別の配列にコピーされるので、配列を変更しても元の記述子には影響しない
+	struct InputLayoutStorage
+	{
+		std::vector<D3D12_INPUT_ELEMENT_DESC>	elements;
+		std::vector<std::string>				names;
+
+		void Set(const D3D12_INPUT_ELEMENT_DESC* pElements, sl12::u32 numElements)
+		{
+			elements.assign(pElements, pElements + numElements);
+			names.resize(numElements);
+			for (sl12::u32 i = 0; i < numElements; i++)
+			{
+				// セマンティクス名はポインタではなく文字列の内容で比較されること
+				names[i] = pElements[i].SemanticName;
+				elements[i].SemanticName = names[i].c_str();
+			}
+		}
+	};	// struct InputLayoutStorage
+
+	const D3D12_INPUT_ELEMENT_DESC kInputElements[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 1, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 2, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	};
+	const sl12::u32 kNumInputElements = ARRAYSIZE(kInputElements);
+}
+
+//----
+// 別々に構築した同じ内容の記述子は同じキーになる
+//----
+SL12_TEST(EqualGraphicsDescsGiveEqualKeys)
+{
+	KeySources src;
+	SL12_REQUIRE(src.Initialize());
+
+	InputLayoutStorage layoutA, layoutB;
+	layoutA.Set(kInputElements, kNumInputElements);
+	layoutB.Set(kInputElements, kNumInputElements);
+	auto a = MakeGraphicsDesc(src, layoutA.elements.data(), kNumInputElements);
+	auto b = MakeGraphicsDesc(src, layoutB.elements.data(), kNumInputElements);
+	SL12_CHECK(layoutA.elements[0].SemanticName != layoutB.elements[0].SemanticName);
+	SL12_CHECK(sl12::PipelineStateCache::CalcGraphicsKey(a) == sl12::PipelineStateCache::CalcGraphicsKey(b));
+
+	// 同じ内容のシェーダ、ルートシグネチャは別オブジェクトでも同じキーになる
+	sl12::Shader vsCopy;
+	sl12::u8 code[16] = { 'D', 'X', 'B', 'C', 0 };
+	SL12_REQUIRE(vsCopy.Initialize(&src.td.GetDevice(), sl12::ShaderType::Vertex, code, sizeof(code)));
+	sl12::RootSignature rootSigCopy;
+	sl12::u32 serialized[2] = { 0, 0 };
+	SL12_REQUIRE(rootSigCopy.Initialize(&src.td.GetDevice(), sl12::RootSignatureDesc(), serialized, sizeof(serialized)));
+	b.pVS = &vsCopy;
+	b.pRootSignature = &rootSigCopy;
+	SL12_CHECK(sl12::PipelineStateCache::CalcGraphicsKey(a) == sl12::PipelineStateCache::CalcGraphicsKey(b));
+
+	// 既定値のみの記述子も安定している
+	sl12::GraphicsPipelineStateDesc d0, d1;
+	SL12_CHECK(sl12::PipelineStateCache::CalcGraphicsKey(d0) == sl12::PipelineStateCache::CalcGraphicsKey(d1));
+}
+
+//----
+// PSOに反映される全てのフィールドは、1つ変更するだけでキーが変わる
+// 変更後のキーは互いにも重複しない
+//----
+SL12_TEST(EachGraphicsFieldChangesKey)
+{
+	KeySources src;
+	SL12_REQUIRE(src.Initialize());
+
+	const Mutation kMutations[] = {
+		{ "pRootSignature", [&](sl12::GraphicsPipelineStateDesc& d) { d.pRootSignature = &src.rootSigs[1]; } },
+		{ "pRootSignature null", [&](sl12::GraphicsPipelineStateDesc& d) { d.pRootSignature = nullptr; } },
+		{ "pVS", [&](sl12::GraphicsPipelineStateDesc& d) { d.pVS = &src.shaders[2]; } },
+		{ "pPS", [&](sl12::GraphicsPipelineStateDesc& d) { d.pPS = &src.shaders[2]; } },
+		{ "pGS", [&](sl12::GraphicsPipelineStateDesc& d) { d.pGS = &src.shaders[2]; } },
+		{ "pDS", [&](sl12::GraphicsPipelineStateDesc& d) { d.pDS = &src.shaders[2]; } },
+		{ "pHS", [&](sl12::GraphicsPipelineStateDesc& d) { d.pHS = &src.shaders[2]; } },
+		{ "VS/PS swapped", [&](sl12::GraphicsPipelineStateDesc& d) { std::swap(d.pVS, d.pPS); } },
+
+		{ "isAlphaToCoverageEnable", [](sl12::GraphicsPipelineStateDesc& d) { d.blend.isAlphaToCoverageEnable = true; } },
+		{ "isIndependentBlend", [](sl12::GraphicsPipelineStateDesc& d) { d.blend.isIndependentBlend = true; } },
+		{ "sampleMask", [](sl12::GraphicsPipelineStateDesc& d) { d.blend.sampleMask = 0x0f; } },
+		{ "isBlendEnable", [](sl12::GraphicsPipelineStateDesc& d) { d.blend.rtDesc[0].isBlendEnable = true; } },
+		{ "isLogicBlendEnable", [](sl12::GraphicsPipelineStateDesc& d) { d.blend.rtDesc[0].isLogicBlendEnable = true; } },
+		{ "srcBlendColor", [](sl12::GraphicsPipelineStateDesc& d) { d.blend.rtDesc[0].srcBlendColor = D3D12_BLEND_SRC_ALPHA; } },
+		{ "dstBlendColor", [](sl12::GraphicsPipelineStateDesc& d) { d.blend.rtDesc[0].dstBlendColor = D3D12_BLEND_INV_SRC_ALPHA; } },
+		{ "blendOpColor", [](sl12::GraphicsPipelineStateDesc& d) { d.blend.rtDesc[0].blendOpColor = D3D12_BLEND_OP_SUBTRACT; } },
+		{ "srcBlendAlpha", [](sl12::GraphicsPipelineStateDesc& d) { d.blend.rtDesc[0].srcBlendAlpha = D3D12_BLEND_SRC_ALPHA; } },
+		{ "dstBlendAlpha", [](sl12::GraphicsPipelineStateDesc& d) { d.blend.rtDesc[0].dstBlendAlpha = D3D12_BLEND_INV_SRC_ALPHA; } },
+		{ "blendOpAlpha", [](sl12::GraphicsPipelineStateDesc& d) { d.blend.rtDesc[0].blendOpAlpha = D3D12_BLEND_OP_SUBTRACT; } },
+		{ "logicOp", [](sl12::GraphicsPipelineStateDesc& d) { d.blend.rtDesc[0].logicOp = D3D12_LOGIC_OP_COPY; } },
+		{ "writeMask", [](sl12::GraphicsPipelineStateDesc& d) { d.blend.rtDesc[0].writeMask = 0x01; } },
+
+		{ "fillMode", [](sl12::GraphicsPipelineStateDesc& d) { d.rasterizer.fillMode = D3D12_FILL_MODE_WIREFRAME; } },
+		{ "cullMode", [](sl12::GraphicsPipelineStateDesc& d) { d.rasterizer.cullMode = D3D12_CULL_MODE_NONE; } },
+		{ "isFrontCCW", [](sl12::GraphicsPipelineStateDesc& d) { d.rasterizer.isFrontCCW = true; } },
+		{ "depthBias", [](sl12::GraphicsPipelineStateDesc& d) { d.rasterizer.depthBias = 1; } },
+		{ "depthBiasClamp", [](sl12::GraphicsPipelineStateDesc& d) { d.rasterizer.depthBiasClamp = 0.5f; } },
+		{ "slopeScaledDepthBias", [](sl12::GraphicsPipelineStateDesc& d) { d.rasterizer.slopeScaledDepthBias = 1.0f; } },
+		{ "isDepthClipEnable", [](sl12::GraphicsPipelineStateDesc& d) { d.rasterizer.isDepthClipEnable = false; } },
+		{ "isMultisampleEnable", [](sl12::GraphicsPipelineStateDesc& d) { d.rasterizer.isMultisampleEnable = true; } },
+		{ "isAntialiasedLineEnable", [](sl12::GraphicsPipelineStateDesc& d) { d.rasterizer.isAntialiasedLineEnable = true; } },
+		{ "isConservativeRasterEnable", [](sl12::GraphicsPipelineStateDesc& d) { d.rasterizer.isConservativeRasterEnable = true; } },
+
+		{ "isDepthEnable", [](sl12::GraphicsPipelineStateDesc& d) { d.depthStencil.isDepthEnable = false; } },
+		{ "isDepthWriteEnable", [](sl12::GraphicsPipelineStateDesc& d) { d.depthStencil.isDepthWriteEnable = false; } },
+		{ "depthFunc", [](sl12::GraphicsPipelineStateDesc& d) { d.depthStencil.depthFunc = D3D12_COMPARISON_FUNC_GREATER; } },
+		{ "isStencilEnable", [](sl12::GraphicsPipelineStateDesc& d) { d.depthStencil.isStencilEnable = true; } },
+		{ "stencilReadMask", [](sl12::GraphicsPipelineStateDesc& d) { d.depthStencil.stencilReadMask = 0x0f; } },
+		{ "stencilWriteMask", [](sl12::GraphicsPipelineStateDesc& d) { d.depthStencil.stencilWriteMask = 0x0f; } },
+		{ "front StencilFailOp", [](sl12::GraphicsPipelineStateDesc& d) { d.depthStencil.stencilFrontFace.StencilFailOp = D3D12_STENCIL_OP_ZERO; } },
+		{ "front StencilDepthFailOp", [](sl12::GraphicsPipelineStateDesc& d) { d.depthStencil.stencilFrontFace.StencilDepthFailOp = D3D12_STENCIL_OP_ZERO; } },
+		{ "front StencilPassOp", [](sl12::GraphicsPipelineStateDesc& d) { d.depthStencil.stencilFrontFace.StencilPassOp = D3D12_STENCIL_OP_ZERO; } },
+		{ "front StencilFunc", [](sl12::GraphicsPipelineStateDesc& d) { d.depthStencil.stencilFrontFace.StencilFunc = D3D12_COMPARISON_FUNC_NEVER; } },
+		{ "back StencilFailOp", [](sl12::GraphicsPipelineStateDesc& d) { d.depthStencil.stencilBackFace.StencilFailOp = D3D12_STENCIL_OP_ZERO; } },
+		{ "back StencilDepthFailOp", [](sl12::GraphicsPipelineStateDesc& d) { d.depthStencil.stencilBackFace.StencilDepthFailOp = D3D12_STENCIL_OP_ZERO; } },
+		{ "back StencilPassOp", [](sl12::GraphicsPipelineStateDesc& d) { d.depthStencil.stencilBackFace.StencilPassOp = D3D12_STENCIL_OP_ZERO; } },
+		{ "back StencilFunc", [](sl12::GraphicsPipelineStateDesc& d) { d.depthStencil.stencilBackFace.StencilFunc = D3D12_COMPARISON_FUNC_NEVER; } },
+
+		{ "numElements", [](sl12::GraphicsPipelineStateDesc& d) { d.inputLayout.numElements--; } },
+		{ "pElements null", [](sl12::GraphicsPipelineStateDesc& d) { d.inputLayout.pElements = nullptr; } },
+
+		{ "primTopology type", [](sl12::GraphicsPipelineStateDesc& d) { d.primTopology = D3D_PRIMITIVE_TOPOLOGY_LINELIST; } },
+		{ "numRTVs", [](sl12::GraphicsPipelineStateDesc& d) { d.numRTVs = 1; } },
+		{ "rtvFormats[0]", [](sl12::GraphicsPipelineStateDesc& d) { d.rtvFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB; } },
+		{ "rtvFormats[1]", [](sl12::GraphicsPipelineStateDesc& d) { d.rtvFormats[1] = DXGI_FORMAT_R32_FLOAT; } },
+		{ "dsvFormat", [](sl12::GraphicsPipelineStateDesc& d) { d.dsvFormat = DXGI_FORMAT_D24_UNORM_S8_UINT; } },
+		{ "multisampleCount", [](sl12::GraphicsPipelineStateDesc& d) { d.multisampleCount = 4; } },
+	};
+
+	InputLayoutStorage baseLayout;
+	baseLayout.Set(kInputElements, kNumInputElements);
+	auto base = MakeGraphicsDesc(src, baseLayout.elements.data(), kNumInputElements);
+
+	std::set<sl12::u64> keys;
+	keys.insert(sl12::PipelineStateCache::CalcGraphicsKey(base));
+	for (auto&& m : kMutations)
+	{
+		InputLayoutStorage layout;
+		layout.Set(kInputElements, kNumInputElements);
+		auto desc = MakeGraphicsDesc(src, layout.elements.data(), kNumInputElements);
+		m.func(desc);
+		bool isUnique = keys.insert(sl12::PipelineStateCache::CalcGraphicsKey(desc)).second;
+		if (!isUnique)
+		{
+			fprintf(stderr, "  key not unique after changing %s\n", m.name);
+		}
+		SL12_CHECK(isUnique);
+	}
+}
+
+//----
+// 入力要素の各フィールドを1つ変更するだけでキーが変わる
+//----
+SL12_TEST(EachInputElementFieldChangesKey)
+{
+	KeySources src;
+	SL12_REQUIRE(src.Initialize());
+
+	typedef void (*ElementMutation)(D3D12_INPUT_ELEMENT_DESC&);
+	const ElementMutation kMutations[] = {
+		[](D3D12_INPUT_ELEMENT_DESC& e) { e.SemanticName = "TANGENT"; },
+		[](D3D12_INPUT_ELEMENT_DESC& e) { e.SemanticIndex = 1; },
+		[](D3D12_INPUT_ELEMENT_DESC& e) { e.Format = DXGI_FORMAT_R16G16B16A16_FLOAT; },
+		[](D3D12_INPUT_ELEMENT_DESC& e) { e.InputSlot = 3; },
+		[](D3D12_INPUT_ELEMENT_DESC& e) { e.AlignedByteOffset = 12; },
+		[](D3D12_INPUT_ELEMENT_DESC& e) { e.InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA; },
+		[](D3D12_INPUT_ELEMENT_DESC& e) { e.InstanceDataStepRate = 1; },
+	};
+
+	std::set<sl12::u64> keys;
+	{
+		auto base = MakeGraphicsDesc(src, kInputElements, kNumInputElements);
+		keys.insert(sl12::PipelineStateCache::CalcGraphicsKey(base));
+	}
+	for (sl12::u32 e = 0; e < kNumInputElements; e++)
+	{
+		for (auto&& m : kMutations)
+		{
+			D3D12_INPUT_ELEMENT_DESC elements[kNumInputElements];
+			memcpy(elements, kInputElements, sizeof(elements));
+			m(elements[e]);
+			auto desc = MakeGraphicsDesc(src, elements, kNumInputElements);
+			SL12_CHECK(keys.insert(sl12::PipelineStateCache::CalcGraphicsKey(desc)).second);
+		}
+	}
+	SL12_CHECK(keys.size() == 1 + kNumInputElements * ARRAYSIZE(kMutations));
+}
+
+//----
+// PSOに反映されないフィールドはキーに影響しない
+//----
+SL12_TEST(UnusedGraphicsFieldsDoNotChangeKey)
+{
+	KeySources src;
+	SL12_REQUIRE(src.Initialize());
+
+	auto base = MakeGraphicsDesc(src, kInputElements, kNumInputElements);
+	auto baseKey = sl12::PipelineStateCache::CalcGraphicsKey(base);
+
+	// 独立ブレンドが無効の場合、1番以降のブレンド設定は使用されない
+	auto desc = base;
+	desc.blend.rtDesc[1].isBlendEnable = true;
+	desc.blend.rtDesc[7].writeMask = 0;
+	SL12_CHECK(sl12::PipelineStateCache::CalcGraphicsKey(desc) == baseKey);
+	desc.blend.isIndependentBlend = true;
+	auto independentKey = sl12::PipelineStateCache::CalcGraphicsKey(desc);
+	SL12_CHECK(independentKey != baseKey);
+	desc.blend.rtDesc[7].writeMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+	SL12_CHECK(sl12::PipelineStateCache::CalcGraphicsKey(desc) != independentKey);
+
+	// 使用しないRTのフォーマット
+	desc = base;
+	desc.rtvFormats[2] = DXGI_FORMAT_R16_UNORM;
+	SL12_CHECK(sl12::PipelineStateCache::CalcGraphicsKey(desc) == baseKey);
+
+	// トポロジはタイプのみがPSOに設定される
+	desc = base;
+	desc.primTopology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP;
+	SL12_CHECK(sl12::PipelineStateCache::CalcGraphicsKey(desc) == baseKey);
+
+	// 要素数を超える入力要素
+	D3D12_INPUT_ELEMENT_DESC elements[kNumInputElements + 1];
+	memcpy(elements, kInputElements, sizeof(kInputElements));
+	elements[kNumInputElements] = { "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 3, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 };
+	desc = MakeGraphicsDesc(src, elements, kNumInputElements);
+	SL12_CHECK(sl12::PipelineStateCache::CalcGraphicsKey(desc) == baseKey);
+
+	// コンパイル済みPSOはキャッシュから設定されるので、キーに含めない
+	desc = base;
+	sl12::u8 blob[8] = {};
+	desc.cachedPSO.pCachedBlob = blob;
+	desc.cachedPSO.CachedBlobSizeInBytes = sizeof(blob);
+	SL12_CHECK(sl12::PipelineStateCache::CalcGraphicsKey(desc) == baseKey);
+}
+
+//----
+// コンピュートのキーはルートシグネチャとシェーダで決まり、グラフィクスのキーとは重複しない
+//----
+SL12_TEST(ComputeKeys)
+{
+	KeySources src;
+	SL12_REQUIRE(src.Initialize());
+
+	sl12::ComputePipelineStateDesc base;
+	base.pRootSignature = &src.rootSigs[0];
+	base.pCS = &src.shaders[0];
+	auto baseKey = sl12::PipelineStateCache::CalcComputeKey(base);
+
+	auto same = base;
+	sl12::u8 blob[8] = {};
+	same.cachedPSO.pCachedBlob = blob;
+	same.cachedPSO.CachedBlobSizeInBytes = sizeof(blob);
+	SL12_CHECK(sl12::PipelineStateCache::CalcComputeKey(same) == baseKey);
+
+	std::set<sl12::u64> keys;
+	keys.insert(baseKey);
+	auto desc = base;
+	desc.pRootSignature = &src.rootSigs[1];
+	SL12_CHECK(keys.insert(sl12::PipelineStateCache::CalcComputeKey(desc)).second);
+	desc = base;
+	desc.pRootSignature = nullptr;
+	SL12_CHECK(keys.insert(sl12::PipelineStateCache::CalcComputeKey(desc)).second);
+	desc = base;
+	desc.pCS = &src.shaders[1];
+	SL12_CHECK(keys.insert(sl12::PipelineStateCache::CalcComputeKey(desc)).second);
+	desc = base;
+	desc.pCS = nullptr;
+	SL12_CHECK(keys.insert(sl12::PipelineStateCache::CalcComputeKey(desc)).second);
+
+	// 同じルートシグネチャとシェーダを持つグラフィクスの記述子
+	sl12::GraphicsPipelineStateDesc graphics;
+	graphics.pRootSignature = &src.rootSigs[0];
+	graphics.pVS = &src.shaders[0];
+	SL12_CHECK(keys.insert(sl12::PipelineStateCache::CalcGraphicsKey(graphics)).second);
+
+	sl12::ComputePipelineStateDesc empty;
+	sl12::GraphicsPipelineStateDesc emptyGraphics;
+	SL12_CHECK(sl12::PipelineStateCache::CalcComputeKey(empty) != sl12::PipelineStateCache::CalcGraphicsKey(emptyGraphics));
+}
+
+//	EOF
@@ -0,0 +1,217 @@
+﻿#include "test_util.h"
+#include "test_device.h"
+
+#include <sl12/range_allocator.h>
+#include <sl12/descriptor_heap.h>
+#include <sl12/descriptor.h>
+#include <random>
+
+
+namespace
+{
+	struct Span
+	{
+		sl12::u32	offset;
+		sl12::u32	size;
+	};
+
+	// 確保済み領域の所有状況. 重複と範囲外を検出する
+	class Occupancy
+	{
+	public:
+		Occupancy(sl12::u32 capacity)
+			: owner_(capacity, 0)
+		{}
+
+		bool Mark(const Span& s, char v)
+		{
+			if (s.offset + s.size > owner_.size())
+			{
+				return false;
+			}
+			for (sl12::u32 i = s.offset; i < s.offset + s.size; i++)
+			{
+				if (owner_[i] == v)
+				{
+					return false;
+				}
+				owner_[i] = v;
+			}
+			return true;
+		}
+
+		// 空き領域のうち最大の連続長
+		sl12::u32 LargestHole() const
+		{
+			sl12::u32 best = 0, run = 0;
+			for (char c : owner_)
+			{
+				run = c ? 0 : run + 1;
+				best = (run > best) ? run : best;
+			}
+			return best;
+		}
+
+	private:
+		std::vector<char>	owner_;
+	};
+
+	// 確保と解放をランダムに繰り返し、不変条件を確認する
+	void RunStress(sl12::u32 capacity, sl12::u32 maxSize, int numSteps, unsigned seed)
+	{
+		sl12::RangeAllocator alloc;
+		SL12_REQUIRE(alloc.Initialize(capacity));
+
+		std::mt19937 rng(seed);
+		std::vector<Span> live;
+		Occupancy occupancy(capacity);
+		sl12::u32 used = 0;
+		int numFailures = 0;
+		for (int step = 0; step < numSteps; step++)
+		{
+			if (live.empty() || (rng() % 2))
+			{
+				sl12::u32 size = 1 + rng() % maxSize;
+				sl12::u32 offset = alloc.Allocate(size);
+				if (offset == sl12::RangeAllocator::kInvalidOffset)
+				{
+					// TLSFはクラス単位で検索するので、最大の空き領域より少し小さい要求でも失敗しうる.
+					// ただし空き領域が要求の2倍以上あれば必ず確保できる
+					SL12_REQUIRE(occupancy.LargestHole() < size * 2);
+					numFailures++;
+					continue;
+				}
+				Span s{ offset, size };
+				SL12_REQUIRE(occupancy.Mark(s, 1));
+				live.push_back(s);
+				used += size;
+			}
+			else
+			{
+				size_t k = rng() % live.size();
+				Span s = live[k];
+				live[k] = live.back();
+				live.pop_back();
+				SL12_REQUIRE(alloc.GetAllocationSize(s.offset) == s.size);
+				SL12_REQUIRE(occupancy.Mark(s, 0));
+				alloc.Free(s.offset);
+				used -= s.size;
+			}
+
+			SL12_REQUIRE(alloc.GetUsedSize() == used);
+			SL12_REQUIRE(alloc.GetAllocationCount() == live.size());
+			if ((step % 64) == 0)
+			{
+				// 空きブロックは常に結合されているので、最大長は実際の穴の最大長と一致する
+				SL12_REQUIRE(alloc.GetLargestFreeSize() == occupancy.LargestHole());
+				float frag = alloc.GetFragmentation();
+				SL12_REQUIRE(frag >= 0.0f && frag <= 1.0f);
+			}
+		}
+		SL12_CHECK(numFailures < numSteps / 2);
+
+		// 全て解放すると1つの空きブロックに戻る
+		for (auto&& s : live)
+		{
+			alloc.Free(s.offset);
+		}
+		SL12_CHECK(alloc.GetUsedSize() == 0);
+		SL12_CHECK(alloc.GetFreeBlockCount() == 1);
+		SL12_CHECK(alloc.GetLargestFreeSize() == capacity);
+		SL12_CHECK(alloc.GetFragmentation() == 0.0f);
+		SL12_CHECK(alloc.Allocate(capacity) == 0);
+	}
+}
+
+//----
+// ランダムな確保と解放で重複、サイズ、結合を確認する
+//----
+SL12_TEST(RandomizedFragmentationStress)
+{
+	RunStress(100, 32, 200000, 1);
+	RunStress(1000, 32, 200000, 2);
+	RunStress(16384, 64, 200000, 3);
+	RunStress(65535, 512, 100000, 4);
+}
+
+//----
+// 1スロットおきに解放すると断片化率が上がり、隣接を解放すると結合されて0に戻る
+//----
+SL12_TEST(FragmentationReportAndCoalesce)
+{
+	static const sl12::u32 kCount = 64;
+	sl12::RangeAllocator alloc;
+	SL12_REQUIRE(alloc.Initialize(kCount));
+
+	std::vector<sl12::u32> offsets;
+	for (sl12::u32 i = 0; i < kCount; i++)
+	{
+		offsets.push_back(alloc.Allocate(1));
+	}
+	SL12_CHECK(alloc.Allocate(1) == sl12::RangeAllocator::kInvalidOffset);
+	SL12_CHECK(alloc.GetFragmentation() == 0.0f);
+
+	for (sl12::u32 i = 0; i < kCount; i += 2)
+	{
+		alloc.Free(offsets[i]);
+	}
+	SL12_CHECK(alloc.GetFreeBlockCount() == kCount / 2);
+	SL12_CHECK(alloc.GetLargestFreeSize() == 1);
+	SL12_CHECK(alloc.GetFragmentation() > 0.9f);
+	SL12_CHECK(alloc.Allocate(2) == sl12::RangeAllocator::kInvalidOffset);
+
+	for (sl12::u32 i = 1; i < kCount; i += 2)
+	{
+		alloc.Free(offsets[i]);
+	}
+	SL12_CHECK(alloc.GetFreeBlockCount() == 1);
+	SL12_CHECK(alloc.GetFragmentation() == 0.0f);
+	SL12_CHECK(alloc.Allocate(kCount) == 0);
+}
+
+//----
+// DescriptorHeap::AllocateRange()は連続したハンドルを返し、単体確保の領域と重ならない
+//----
+SL12_TEST(DescriptorHeapRanges)
+{
+	sl12test::TestDevice td;
+	sl12::DescriptorHeap heap;
+	D3D12_DESCRIPTOR_HEAP_DESC desc{ D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1024, D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE, 1 };
+	sl12::DescriptorHeapLayout layout;
+	layout.numRanges = 512;
+	SL12_REQUIRE(heap.Initialize(&td.GetDevice(), desc, layout));
+	SL12_CHECK(heap.GetRangeCapacity() == 512);
+
+	auto r8 = heap.AllocateRange(8);
+	auto r3 = heap.AllocateRange(3);
+	SL12_REQUIRE(r8.IsValid() && r3.IsValid());
+	SL12_CHECK(r8.count == 8 && r3.count == 3);
+	SL12_CHECK(r8.index >= heap.GetRangeBaseIndex() && r3.index >= heap.GetRangeBaseIndex());
+	SL12_CHECK(r8.index + 8 <= r3.index || r3.index + 3 <= r8.index);
+	for (sl12::u32 i = 0; i < 8; i++)
+	{
+		SL12_CHECK(r8.GetCpuHandle(i).ptr == heap.GetCpuHandle(r8.index + i).ptr);
+		SL12_CHECK(r8.GetGpuHandle(i).ptr == heap.GetGpuHandle(r8.index + i).ptr);
+	}
+
+	// 単体確保は連続領域の外から行われる
+	std::vector<sl12::Descriptor*> singles;
+	while (auto p = heap.CreateDescriptor())
+	{
+		SL12_CHECK(p->GetIndex() < heap.GetRangeBaseIndex());
+		singles.push_back(p);
+	}
+	SL12_CHECK(singles.size() == 1024 - 512);
+	for (auto p : singles)
+	{
+		p->Release();
+	}
+
+	SL12_CHECK(!heap.AllocateRange(1024).IsValid());
+	heap.FreeRange(r8);
+	heap.FreeRange(r3);
+	SL12_CHECK(heap.GetRangeUsedCount() == 0);
+	SL12_CHECK(heap.AllocateRange(512).IsValid());
+}
+
+//	EOF
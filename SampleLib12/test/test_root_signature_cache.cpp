@@ -0,0 +1,219 @@
+﻿#include "test_util.h"
+#include "test_device.h"
+
+#include <sl12/root_signature_cache.h>
+#include <sl12/root_signature_manager.h>
+#include <sl12/shader.h>
+#include <fstream>
+#include <iterator>
+
+
+namespace
+{
+	static const char* kVertexShaderFile = "../../Sample008/data/base_pass.vv.cso";
+	static const char* kPixelShaderFile = "../../Sample008/data/blur_x.p.cso";
+	static const char* kComputeShaderFile = "../../Sample004/data/world_transform_fp32.cso";
+
+	std::vector<char> ReadBytes(const std::string& path)
+	{
+		std::ifstream fin(path, std::ios::binary);
+		return std::vector<char>(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+	}
+
+	void WriteBytes(const std::string& path, const std::vector<char>& data)
+	{
+		std::ofstream fout(path, std::ios::binary | std::ios::trunc);
+		fout.write(data.data(), data.size());
+	}
+
+	sl12::RootSignatureCacheEntry MakeEntry(sl12::u64 contentHash)
+	{
+		sl12::RootSignatureCacheEntry entry;
+		entry.contentHash = contentHash;
+		entry.isGraphics = false;
+		entry.params.push_back(sl12::RootParameter(sl12::RootParameterType::RootConstants, sl12::ShaderVisibility::All, 0, 20));
+		entry.params.push_back(sl12::RootParameter(sl12::RootParameterType::ShaderResource, sl12::ShaderVisibility::All, 3));
+		entry.bindings.push_back({ 0x1111, 0, 1 });
+		entry.bindings.push_back({ 0x2222, 1, 1 });
+		entry.paramIndices = { 0, 1 };
+		D3D12_STATIC_SAMPLER_DESC sampler{};
+		sampler.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+		sampler.MipLODBias = -0.5f;
+		sampler.MaxLOD = 1000.0f;
+		sampler.ShaderRegister = 2;
+		entry.staticSamplers.push_back(sampler);
+		entry.serialized = { 1, 2, 3, 4, 5 };
+		return entry;
+	}
+
+	// 同じバイトコードから生成したルートシグネチャを作成するためのシェーダ一式
+	struct ShaderSet
+	{
+		sl12::Shader	vs, ps, cs;
+
+		bool Initialize(sl12::Device* pDev)
+		{
+			return vs.Initialize(pDev, sl12::ShaderType::Vertex, kVertexShaderFile)
+				&& ps.Initialize(pDev, sl12::ShaderType::Pixel, kPixelShaderFile)
+				&& cs.Initialize(pDev, sl12::ShaderType::Compute, kComputeShaderFile);
+		}
+	};	// struct ShaderSet
+
+	bool InitializeTestHeaps(sl12test::TestDevice& td)
+	{
+		return td.InitializeHeaps({ 256, 16, 16, 16 });
+	}
+}
+
+//----
+// 保存したエントリは読み込み後に同じ内容で取得でき、ハッシュ値が異なれば取得できない
+//----
+SL12_TEST(SaveLoadRoundTrip)
+{
+	std::string path = sl12test::GetTempFilePath("rs_round_trip.bin");
+	{
+		sl12::RootSignatureCache cache;
+		cache.Store(10, MakeEntry(0xabcdef0123456789ull));
+		cache.Store(20, MakeEntry(0x42));
+		SL12_REQUIRE(cache.Save(path.c_str()));
+	}
+
+	sl12::RootSignatureCache cache;
+	SL12_REQUIRE(cache.Load(path.c_str()));
+	SL12_CHECK(cache.GetEntryCount() == 2);
+	auto pEntry = cache.Find(10, 0xabcdef0123456789ull);
+	SL12_REQUIRE(pEntry != nullptr);
+	auto expected = MakeEntry(0xabcdef0123456789ull);
+	SL12_CHECK(!pEntry->isGraphics);
+	SL12_REQUIRE(pEntry->params.size() == 2);
+	SL12_CHECK(pEntry->params[0].type == sl12::RootParameterType::RootConstants && pEntry->params[0].num32BitValues == 20);
+	SL12_CHECK(pEntry->params[1].type == sl12::RootParameterType::ShaderResource && pEntry->params[1].registerIndex == 3);
+	SL12_REQUIRE(pEntry->bindings.size() == 2);
+	SL12_CHECK(pEntry->bindings[1].nameHash == 0x2222 && pEntry->bindings[1].first == 1);
+	SL12_CHECK(pEntry->paramIndices == expected.paramIndices);
+	SL12_REQUIRE(pEntry->staticSamplers.size() == 1);
+	SL12_CHECK(memcmp(&pEntry->staticSamplers[0], &expected.staticSamplers[0], sizeof(D3D12_STATIC_SAMPLER_DESC)) == 0);
+	SL12_CHECK(pEntry->serialized == expected.serialized);
+
+	// バイトコードが変わるとハッシュ値が一致しない
+	SL12_CHECK(cache.Find(20, 0x43) == nullptr);
+	SL12_CHECK(cache.Find(30, 0x42) == nullptr);
+	SL12_CHECK(cache.GetHitCount() == 1);
+	SL12_CHECK(cache.GetMissCount() == 2);
+
+	// 参照されたエントリのみ保存される
+	SL12_REQUIRE(cache.Save(path.c_str()));
+	sl12::RootSignatureCache reloaded;
+	SL12_REQUIRE(reloaded.Load(path.c_str()));
+	SL12_CHECK(reloaded.GetEntryCount() == 1);
+	SL12_CHECK(reloaded.Find(10, 0xabcdef0123456789ull) != nullptr);
+	remove(path.c_str());
+}
+
+//----
+// バージョンが異なるか、途中で切れたファイルは読み込まない
+//----
+SL12_TEST(RejectsStaleAndCorruptFiles)
+{
+	std::string path = sl12test::GetTempFilePath("rs_corrupt.bin");
+	{
+		sl12::RootSignatureCache cache;
+		cache.Store(10, MakeEntry(1));
+		SL12_REQUIRE(cache.Save(path.c_str()));
+	}
+	auto original = ReadBytes(path);
+	SL12_REQUIRE(original.size() > 12);
+
+	sl12::RootSignatureCache cache;
+	SL12_CHECK(!cache.Load(sl12test::GetTempFilePath("rs_missing.bin").c_str()));
+	SL12_CHECK(cache.GetEntryCount() == 0);
+
+	// バージョン違い
+	auto data = original;
+	data[4] ^= 0xff;
+	WriteBytes(path, data);
+	SL12_CHECK(!cache.Load(path.c_str()));
+	SL12_CHECK(cache.GetEntryCount() == 0);
+
+	// 全ての長さで途中で切れたファイル
+	for (size_t size = 0; size < original.size(); size++)
+	{
+		WriteBytes(path, std::vector<char>(original.begin(), original.begin() + size));
+		SL12_CHECK(!cache.Load(path.c_str()));
+		SL12_CHECK(cache.GetEntryCount() == 0);
+	}
+
+	// 範囲外のパラメータ種別
+	data = original;
+	data[12 + 4 + 8 + 4 + 4] = static_cast<char>(sl12::RootParameterType::Max);
+	WriteBytes(path, data);
+	SL12_CHECK(!cache.Load(path.c_str()));
+	SL12_CHECK(cache.GetEntryCount() == 0);
+
+	WriteBytes(path, original);
+	SL12_CHECK(cache.Load(path.c_str()));
+	SL12_CHECK(cache.GetEntryCount() == 1);
+	remove(path.c_str());
+}
+
+//----
+// 保存したキャッシュを読み込むと、同じシェーダのルートシグネチャはキャッシュから生成される
+//----
+SL12_TEST(ManagerWarmStartUsesCache)
+{
+	std::string path = sl12test::GetTempFilePath("rs_manager.bin");
+	sl12test::TestDevice td;
+	SL12_REQUIRE(InitializeTestHeaps(td));
+	ShaderSet shaders;
+	SL12_REQUIRE(shaders.Initialize(&td.GetDevice()));
+
+	sl12::RootSignatureCreateDesc gfxDesc;
+	gfxDesc.pVS = &shaders.vs;
+	gfxDesc.pPS = &shaders.ps;
+	sl12::RootSignatureCreateDesc csDesc;
+	csDesc.pCS = &shaders.cs;
+	csDesc.maxRootConstants = 32;
+
+	{
+		sl12::RootSignatureManager cold;
+		SL12_REQUIRE(cold.Initialize(&td.GetDevice()));
+		auto gfx = cold.CreateRootSignature(gfxDesc);
+		auto cs = cold.CreateRootSignature(csDesc);
+		SL12_REQUIRE(gfx.IsValid() && cs.IsValid());
+		SL12_CHECK(cold.GetCache().GetHitCount() == 0);
+		SL12_CHECK(cold.GetCache().GetEntryCount() == 2);
+		SL12_REQUIRE(cold.SaveCache(path.c_str()));
+	}
+
+	sl12::RootSignatureManager warm;
+	SL12_REQUIRE(warm.Initialize(&td.GetDevice()));
+	SL12_REQUIRE(warm.LoadCache(path.c_str()));
+	auto gfx = warm.CreateRootSignature(gfxDesc);
+	auto cs = warm.CreateRootSignature(csDesc);
+	SL12_REQUIRE(gfx.IsValid() && cs.IsValid());
+	SL12_CHECK(warm.GetCache().GetHitCount() == 2);
+	SL12_CHECK(warm.GetCache().GetMissCount() == 0);
+
+	// キャッシュから復元したバインド情報で名前を解決できる
+	SL12_CHECK(gfx.GetBindingSlot("CbScene").IsValid());
+	SL12_CHECK(gfx.GetBindingSlot("texSource").IsValid());
+	SL12_CHECK(gfx.GetBindingSlot("samLinearClamp").IsValid());
+	SL12_CHECK(cs.GetBindingSlot("rwDstVBuffer").IsValid());
+	sl12::u32 values[4] = {};
+	sl12test::TestCommandList tcl(&td.GetDevice().GetGraphicsQueue());
+	SL12_CHECK(cs.SetConstants(tcl.Get(), "cbWorld", values, 4));
+
+	// 生成オプションが変わるとキャッシュは使用されない
+	csDesc.maxRootConstants = 0;
+	auto cs2 = warm.CreateRootSignature(csDesc);
+	SL12_REQUIRE(cs2.IsValid());
+	SL12_CHECK(warm.GetCache().GetHitCount() == 2);
+	SL12_CHECK(!cs2.SetConstants(tcl.Get(), "cbWorld", values, 4));
+
+	gfx.Invalid();
+	cs.Invalid();
+	cs2.Invalid();
+	remove(path.c_str());
+}
+
+//	EOF
@@ -0,0 +1,304 @@
+﻿#include "test_util.h"
+#include "test_device.h"
+
+#include <sl12/root_signature_manager.h>
+#include <sl12/shader.h>
+#include <sl12/buffer.h>
+#include <sl12/buffer_view.h>
+#include <algorithm>
+#include <string>
+
+
+namespace
+{
+	// cbWorld(80バイト)、rSrcVBuffer(t0)、rwDstVBuffer(u0)を持つコンピュートシェーダ
+	static const char* kComputeShaderFile = "../../Sample004/data/world_transform_fp32.cso";
+	// texSSPR(t0)、texNormal(t1)、CbScene(b0)、CbWaterInfo(b1)、samLinear(s0)を持つピクセルシェーダ
+	static const char* kTableShaderFile = "../../Sample008/data/water.p.cso";
+
+	int CountCommands(const sl12test::FakeCommandList& cmdList, const char* prefix)
+	{
+		return static_cast<int>(std::count_if(cmdList.log.begin(), cmdList.log.end(),
+			[&](const std::string& s) { return s.compare(0, strlen(prefix), prefix) == 0; }));
+	}
+
+	int CountParams(const std::vector<sl12::RootParameter>& params, sl12::RootParameterType::Type type)
+	{
+		return static_cast<int>(std::count_if(params.begin(), params.end(),
+			[&](const sl12::RootParameter& p) { return p.type == type; }));
+	}
+}
+
+//----
+// SetConstants()はCommandListのラッパーを経由し、ステートキャッシュの統計に計上される
+//----
+SL12_TEST(SetConstantsGoesThroughCommandList)
+{
+	sl12test::TestDevice td;
+	SL12_REQUIRE(td.InitializeHeaps({ 256, 16, 16, 16 }));
+	sl12::Shader cs;
+	SL12_REQUIRE(cs.Initialize(&td.GetDevice(), sl12::ShaderType::Compute, kComputeShaderFile));
+
+	sl12::RootSignatureManager manager;
+	SL12_REQUIRE(manager.Initialize(&td.GetDevice()));
+	sl12::RootSignatureCreateDesc desc;
+	desc.pCS = &cs;
+	desc.maxRootConstants = 32;
+	auto handle = manager.CreateRootSignature(desc);
+	SL12_REQUIRE(handle.IsValid());
+
+	sl12test::TestCommandList tcl(&td.GetDevice().GetGraphicsQueue());
+	auto&& cmdList = tcl.Get();
+	cmdList.EnableStateCache(true);
+
+	auto slot = handle.GetBindingSlot("cbWorld");
+	SL12_REQUIRE(slot.IsValid());
+	sl12::u32 values[20] = { 0x12345678 };
+	SL12_CHECK(handle.SetConstants(cmdList, slot, values, 20));
+	values[0] = 0x9abcdef0;
+	SL12_CHECK(handle.SetConstants(cmdList, slot, values, 4));
+
+	// 定数の内容は比較しないので、同じ値でも毎回発行する
+	SL12_CHECK(handle.SetConstants(cmdList, slot, values, 4));
+	SL12_CHECK(CountCommands(tcl.GetFake(), "SetComputeRoot32BitConstants") == 3);
+	SL12_CHECK(CountCommands(tcl.GetFake(), "SetGraphicsRoot32BitConstants") == 0);
+	SL12_CHECK(tcl.GetFake().log.back().find("9abcdef0") != std::string::npos);
+	SL12_CHECK(cmdList.GetStateCacheStats().issued == 3);
+	SL12_CHECK(cmdList.GetStateCacheStats().filtered == 0);
+
+	// ルート定数でないパラメータには設定できない
+	SL12_CHECK(!handle.SetConstants(cmdList, handle.GetBindingSlot("rSrcVBuffer"), values, 1));
+	SL12_CHECK(!handle.SetConstants(cmdList, handle.GetBindingSlot("unknown"), values, 1));
+	SL12_CHECK(CountCommands(tcl.GetFake(), "SetComputeRoot32BitConstants") == 3);
+
+	handle.Invalid();
+	manager.Destroy();
+}
+
+//----
+// ルート定数を設定したルート引数は不明状態になり、次のルート引数の設定は除外されない
+//----
+SL12_TEST(RootConstantsInvalidateCachedArgument)
+{
+	sl12::CommandStateCache cache;
+	cache.SetEnable(true);
+
+	SL12_CHECK(cache.SetComputeRootArgument(2, 0x1000));
+	SL12_CHECK(!cache.SetComputeRootArgument(2, 0x1000));
+	SL12_CHECK(cache.SetComputeRootConstants(2));
+	SL12_CHECK(cache.SetComputeRootConstants(2));
+	SL12_CHECK(cache.SetComputeRootArgument(2, 0x1000));
+
+	// グラフィクス側のルート引数には影響しない
+	SL12_CHECK(cache.SetGraphicsRootArgument(2, 0x1000));
+	SL12_CHECK(cache.SetComputeRootConstants(2));
+	SL12_CHECK(!cache.SetGraphicsRootArgument(2, 0x1000));
+
+	SL12_CHECK(cache.GetStats().issued == 6);
+	SL12_CHECK(cache.GetStats().filtered == 2);
+}
+
+//----
+// まとめたテーブルは別のルートシグネチャを設定した後や別のコマンドリストでも再設定される
+//----
+SL12_TEST(MergedTableReappliedAfterRebind)
+{
+	// テーブルはビューをステージングしている場合のみまとめられる
+	sl12test::TestDevice td;
+	std::array<sl12::DescriptorHeapLayout, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> layouts;
+	layouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].numTransients = 64;
+	layouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].stageViews = true;
+	layouts[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER].numTransients = 8;
+	layouts[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER].stageViews = true;
+	SL12_REQUIRE(td.InitializeHeaps({ 256, 16, 16, 16 }, layouts));
+	sl12::Shader ps, cs;
+	SL12_REQUIRE(ps.Initialize(&td.GetDevice(), sl12::ShaderType::Pixel, kTableShaderFile));
+	SL12_REQUIRE(cs.Initialize(&td.GetDevice(), sl12::ShaderType::Compute, kComputeShaderFile));
+
+	sl12::RootSignatureManager manager;
+	SL12_REQUIRE(manager.Initialize(&td.GetDevice()));
+	sl12::RootSignatureCreateDesc desc;
+	desc.pPS = &ps;
+	auto handle = manager.CreateRootSignature(desc);
+	desc.pPS = nullptr;
+	desc.pCS = &cs;
+	auto other = manager.CreateRootSignature(desc);
+	SL12_REQUIRE(handle.IsValid() && other.IsValid());
+
+	// SRVとCBVは1つのテーブルにまとめられる. サンプラのテーブルは設定しないので使用されない
+	sl12::Buffer cb, sb;
+	SL12_REQUIRE(cb.Initialize(&td.GetDevice(), 512, 0, sl12::BufferUsage::ConstantBuffer, false, false));
+	SL12_REQUIRE(sb.Initialize(&td.GetDevice(), 256, 16, sl12::BufferUsage::ShaderResource, false, false));
+	sl12::ConstantBufferView cbv;
+	sl12::BufferView srv0, srv1;
+	SL12_REQUIRE(cbv.Initialize(&td.GetDevice(), &cb));
+	SL12_REQUIRE(srv0.Initialize(&td.GetDevice(), &sb, 0, 16));
+	SL12_REQUIRE(srv1.Initialize(&td.GetDevice(), &sb, 1, 16));
+
+	auto Bind = [&](sl12::CommandList& cmdList, sl12::RootSignatureHandle& h)
+	{
+		cmdList.SetGraphicsRootSignature(h.GetRootSignature()->GetRootSignature());
+	};
+	auto Count = [&](sl12test::TestCommandList& tcl)
+	{
+		return CountCommands(tcl.GetFake(), "SetGraphicsRootDescriptorTable");
+	};
+
+	sl12test::TestCommandList tcl(&td.GetDevice().GetGraphicsQueue());
+	auto&& cmdList = tcl.Get();
+	cmdList.EnableStateCache(true);
+	Bind(cmdList, handle);
+	SL12_CHECK(handle.SetDescriptor(cmdList, "texSSPR", srv0));
+	SL12_CHECK(handle.SetDescriptor(cmdList, "texNormal", srv1));
+	SL12_CHECK(handle.SetDescriptor(cmdList, "CbScene", cbv));
+	SL12_CHECK(handle.SetDescriptor(cmdList, "CbWaterInfo", cbv));
+	SL12_CHECK(Count(tcl) == 0);
+	handle.ApplyDescriptors(cmdList);
+	SL12_CHECK(Count(tcl) == 1);
+	std::string tableCmd = tcl.GetFake().log.back();
+
+	// 変更がなければ同じテーブルとなり、ステートキャッシュで除外される
+	handle.ApplyDescriptors(cmdList);
+	SL12_CHECK(Count(tcl) == 1);
+
+	// 別のルートシグネチャを設定して戻した場合は再設定する
+	cmdList.SetGraphicsRootSignature(other.GetRootSignature()->GetRootSignature());
+	Bind(cmdList, handle);
+	handle.ApplyDescriptors(cmdList);
+	SL12_CHECK(Count(tcl) == 2);
+	SL12_CHECK(tcl.GetFake().log.back() == tableCmd);
+
+	// 別のコマンドリストでも設定する
+	sl12test::TestCommandList tcl2(&td.GetDevice().GetGraphicsQueue());
+	Bind(tcl2.Get(), handle);
+	handle.ApplyDescriptors(tcl2.Get());
+	SL12_CHECK(Count(tcl2) == 1);
+	SL12_CHECK(tcl2.GetFake().log.back() == tableCmd);
+
+	// デスクリプタヒープの再設定などでステートキャッシュを破棄した後も設定する
+	cmdList.InvalidateStateCache();
+	handle.ApplyDescriptors(cmdList);
+	SL12_CHECK(Count(tcl) == 3);
+
+	handle.Invalid();
+	other.Invalid();
+	manager.Destroy();
+}
+
+//----
+// ルートCBV以下の大きさのルート定数はルートCBVにせず、テーブルに戻す
+//----
+SL12_TEST(SmallRootConstantsDemoteToTable)
+{
+	// 2DWORDのルート定数30個と1DWORDのルート定数1個、SRVテーブル4個で65DWORD
+	std::vector<sl12::RootParameter> params;
+	for (sl12::u32 i = 0; i < 30; i++)
+	{
+		params.push_back(sl12::RootParameter(sl12::RootParameterType::RootConstants, sl12::ShaderVisibility::Pixel, i, 2));
+	}
+	params.push_back(sl12::RootParameter(sl12::RootParameterType::RootConstants, sl12::ShaderVisibility::Pixel, 30, 1));
+	for (sl12::u32 i = 0; i < 4; i++)
+	{
+		params.push_back(sl12::RootParameter(sl12::RootParameterType::ShaderResource, sl12::ShaderVisibility::Pixel, i));
+	}
+	sl12::RootSignatureDesc rsDesc;
+	rsDesc.numParameters = (sl12::u32)params.size();
+	rsDesc.pParameters = params.data();
+	SL12_REQUIRE(sl12::RootSignature::CalcDWordCount(rsDesc) == 65);
+
+	// 1つをテーブルに戻すだけで上限に収まり、ルートCBVは使用しない
+	SL12_CHECK(sl12::RootSignatureManager::DemoteRootParameters(params, rsDesc, true));
+	SL12_CHECK(sl12::RootSignature::CalcDWordCount(rsDesc) == 64);
+	SL12_CHECK(CountParams(params, sl12::RootParameterType::RootConstants) == 30);
+	SL12_CHECK(CountParams(params, sl12::RootParameterType::ConstantBuffer) == 1);
+	SL12_CHECK(CountParams(params, sl12::RootParameterType::RootConstantBuffer) == 0);
+	SL12_CHECK(params[0].type == sl12::RootParameterType::ConstantBuffer);
+}
+
+//----
+// ルートCBVより大きいルート定数はルートCBVに降格する
+//----
+SL12_TEST(LargeRootConstantsDemoteToRootCbv)
+{
+	// 20DWORDのルート定数1個と2DWORDのルート定数22個、SRVテーブル1個で65DWORD
+	std::vector<sl12::RootParameter> params;
+	params.push_back(sl12::RootParameter(sl12::RootParameterType::RootConstants, sl12::ShaderVisibility::Pixel, 0, 20));
+	for (sl12::u32 i = 1; i <= 22; i++)
+	{
+		params.push_back(sl12::RootParameter(sl12::RootParameterType::RootConstants, sl12::ShaderVisibility::Pixel, i, 2));
+	}
+	params.push_back(sl12::RootParameter(sl12::RootParameterType::ShaderResource, sl12::ShaderVisibility::Pixel, 0));
+	sl12::RootSignatureDesc rsDesc;
+
+	auto withCbv = params;
+	SL12_CHECK(sl12::RootSignatureManager::DemoteRootParameters(withCbv, rsDesc, true));
+	SL12_CHECK(sl12::RootSignature::CalcDWordCount(rsDesc) == 47);
+	SL12_CHECK(withCbv[0].type == sl12::RootParameterType::RootConstantBuffer);
+	SL12_CHECK(CountParams(withCbv, sl12::RootParameterType::RootConstants) == 22);
+
+	// ルートCBVを使用しない場合はテーブルに戻す
+	auto withoutCbv = params;
+	SL12_CHECK(sl12::RootSignatureManager::DemoteRootParameters(withoutCbv, rsDesc, false));
+	SL12_CHECK(sl12::RootSignature::CalcDWordCount(rsDesc) == 46);
+	SL12_CHECK(withoutCbv[0].type == sl12::RootParameterType::ConstantBuffer);
+
+	// ルート定数、ルートCBVがなく収まらない場合は失敗する(テーブル63個とバインドレステーブル2個で65DWORD)
+	std::vector<sl12::RootParameter> tables;
+	for (sl12::u32 i = 0; i < 63; i++)
+	{
+		tables.push_back(sl12::RootParameter(sl12::RootParameterType::ShaderResource, sl12::ShaderVisibility::Pixel, i));
+	}
+	rsDesc.useBindless = true;
+	SL12_CHECK(!sl12::RootSignatureManager::DemoteRootParameters(tables, rsDesc, true));
+}
+
+//----
+// D3D12の記述子から生成した場合もサイズを計算し、破棄でリセットする
+//----
+SL12_TEST(DWordCountFromD3DDesc)
+{
+	sl12test::TestDevice td;
+
+	D3D12_DESCRIPTOR_RANGE range{};
+	range.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+	range.NumDescriptors = 4;
+	D3D12_ROOT_PARAMETER params[3]{};
+	params[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+	params[0].DescriptorTable.NumDescriptorRanges = 1;
+	params[0].DescriptorTable.pDescriptorRanges = &range;
+	params[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+	params[1].Constants.Num32BitValues = 4;
+	params[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+	D3D12_ROOT_SIGNATURE_DESC desc{};
+	desc.NumParameters = 3;
+	desc.pParameters = params;
+
+	sl12::RootSignature rs;
+	SL12_REQUIRE(rs.Initialize(&td.GetDevice(), desc));
+	SL12_CHECK(rs.GetDWordCount() == 7);
+	SL12_CHECK(rs.GetHash() != 0);
+	rs.Destroy();
+	SL12_CHECK(rs.GetDWordCount() == 0);
+	SL12_CHECK(rs.GetHash() == 0);
+}
+
+//----
+// ビューのステージングにはリングが必要
+//----
+SL12_TEST(StageViewsRequiresTransients)
+{
+	std::array<sl12::DescriptorHeapLayout, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> layouts;
+	layouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].stageViews = true;
+	{
+		sl12test::TestDevice td;
+		SL12_CHECK(!td.InitializeHeaps({ 256, 16, 16, 16 }, layouts));
+	}
+	layouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].numTransients = 64;
+	{
+		sl12test::TestDevice td;
+		SL12_CHECK(td.InitializeHeaps({ 256, 16, 16, 16 }, layouts));
+		SL12_CHECK(td.GetDevice().GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).IsViewStaged());
+	}
+}
+
+//	EOF
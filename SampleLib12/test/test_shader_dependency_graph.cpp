@@ -0,0 +1,253 @@
+﻿#include "test_util.h"
+
+#include <sl12/shader_dependency_graph.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+
+namespace
+{
+	typedef sl12::ShaderDependencyGraph Graph;
+	typedef Graph::NodeId NodeId;
+
+	// ノードごとの再構築結果を指定して伝搬し、再構築したノードを返す
+	struct Propagator
+	{
+		std::map<NodeId, sl12::RebuildResult::Type>	results;		// 指定がなければChanged
+		std::vector<NodeId>							rebuilt;
+
+		bool Run(const Graph& graph, const std::vector<NodeId>& roots)
+		{
+			std::vector<NodeId> called;
+			bool ret = graph.Propagate(roots,
+				[&](NodeId id)
+				{
+					called.push_back(id);
+					auto it = results.find(id);
+					return (it != results.end()) ? it->second : sl12::RebuildResult::Changed;
+				},
+				&rebuilt);
+			// 再構築したノードは全てコールバックが呼ばれている
+			return ret && called == rebuilt;
+		}
+	};
+
+	bool IsBefore(const std::vector<NodeId>& order, NodeId a, NodeId b)
+	{
+		auto ia = std::find(order.begin(), order.end(), a);
+		auto ib = std::find(order.begin(), order.end(), b);
+		return ia != order.end() && ib != order.end() && ia < ib;
+	}
+
+	// common.hlsli <- lighting.hlsli <- water.p.hlsl <- ルートシグネチャ <- PSO
+	// sky.p.hlsl <- ルートシグネチャ <- PSO (無関係)
+	struct IncludeChain
+	{
+		Graph	graph;
+		NodeId	common, lighting, water, waterRs, waterPso;
+		NodeId	sky, skyRs, skyPso;
+
+		IncludeChain()
+		{
+			common = graph.AddFileNode("shader/common.hlsli");
+			lighting = graph.AddFileNode("shader/lighting.hlsli", { common });
+			water = graph.AddFileNode("shader/water.p.hlsl", { lighting });
+			sky = graph.AddFileNode("shader/sky.p.hlsl");
+			waterRs = graph.AddNode({ water });
+			skyRs = graph.AddNode({ sky });
+			waterPso = graph.AddNode({ water, waterRs });
+			skyPso = graph.AddNode({ sky, skyRs });
+		}
+	};
+
+	// common.hlsli <- a.hlsli, b.hlsli <- shader.p.hlsl <- PSO
+	struct Diamond
+	{
+		Graph	graph;
+		NodeId	common, a, b, shader, pso;
+
+		Diamond()
+		{
+			common = graph.AddFileNode("common.hlsli");
+			a = graph.AddFileNode("a.hlsli", { common });
+			b = graph.AddFileNode("b.hlsli", { common });
+			shader = graph.AddFileNode("shader.p.hlsl", { a, b });
+			pso = graph.AddNode({ shader });
+		}
+	};
+}
+
+SL12_TEST(IncludeChainInvalidatesShader)
+{
+	IncludeChain c;
+	SL12_REQUIRE(c.skyPso != Graph::kInvalidNode);
+	SL12_CHECK(c.graph.IsFileNode(c.lighting));
+	SL12_CHECK(c.graph.FindFile(".\\Shader\\Common.hlsli") == c.common);
+
+	// 最下層のインクルードファイルの変更がPSOまで伝わる
+	Propagator p;
+	SL12_REQUIRE(p.Run(c.graph, { c.common }));
+	std::vector<NodeId> expected = { c.common, c.lighting, c.water, c.waterRs, c.waterPso };
+	SL12_CHECK(p.rebuilt == expected);
+
+	// 途中のインクルードファイルから
+	SL12_REQUIRE(p.Run(c.graph, { c.lighting }));
+	expected = { c.lighting, c.water, c.waterRs, c.waterPso };
+	SL12_CHECK(p.rebuilt == expected);
+
+	std::vector<NodeId> affected;
+	c.graph.CollectAffected({ c.common, c.sky }, affected);
+	SL12_CHECK(affected.size() == c.graph.GetNodeCount());
+}
+
+SL12_TEST(IncludeChainStopsAtUnchanged)
+{
+	IncludeChain c;
+
+	// インクルードファイルを保存し直しただけでシェーダの結果が変わらない場合
+	Propagator p;
+	p.results[c.water] = sl12::RebuildResult::Unchanged;
+	SL12_REQUIRE(p.Run(c.graph, { c.common }));
+	std::vector<NodeId> expected = { c.common, c.lighting, c.water };
+	SL12_CHECK(p.rebuilt == expected);
+
+	// 途中で失敗した場合は中断する
+	Propagator failed;
+	failed.results[c.lighting] = sl12::RebuildResult::Failed;
+	SL12_CHECK(!failed.Run(c.graph, { c.common }));
+	expected = { c.common };
+	SL12_CHECK(failed.rebuilt == expected);
+}
+
+SL12_TEST(DiamondIncludeRebuildsOnce)
+{
+	Diamond d;
+	SL12_REQUIRE(d.pso != Graph::kInvalidNode);
+	SL12_CHECK(d.graph.GetDependents(d.common).size() == 2);
+
+	Propagator p;
+	SL12_REQUIRE(p.Run(d.graph, { d.common }));
+	SL12_CHECK(p.rebuilt.size() == 5);
+	for (auto id : { d.common, d.a, d.b, d.shader, d.pso })
+	{
+		SL12_CHECK(std::count(p.rebuilt.begin(), p.rebuilt.end(), id) == 1);
+	}
+	// シェーダは両方のインクルードファイルの後に処理する
+	SL12_CHECK(IsBefore(p.rebuilt, d.a, d.shader));
+	SL12_CHECK(IsBefore(p.rebuilt, d.b, d.shader));
+	SL12_CHECK(IsBefore(p.rebuilt, d.shader, d.pso));
+
+	// 同じ変更が両方の経路から届いても1回のみ
+	SL12_REQUIRE(p.Run(d.graph, { d.a, d.b }));
+	std::vector<NodeId> expected = { d.a, d.b, d.shader, d.pso };
+	SL12_CHECK(p.rebuilt == expected);
+}
+
+SL12_TEST(DiamondIncludeOneSideChanged)
+{
+	Diamond d;
+
+	// 片方の経路のみ変化した場合もシェーダは再構築する
+	Propagator p;
+	p.results[d.a] = sl12::RebuildResult::Unchanged;
+	SL12_REQUIRE(p.Run(d.graph, { d.common }));
+	std::vector<NodeId> expected = { d.common, d.a, d.b, d.shader, d.pso };
+	SL12_CHECK(p.rebuilt == expected);
+
+	// 両方とも変化しなければシェーダは再構築しない
+	p.results[d.b] = sl12::RebuildResult::Unchanged;
+	SL12_REQUIRE(p.Run(d.graph, { d.common }));
+	expected = { d.common, d.a, d.b };
+	SL12_CHECK(p.rebuilt == expected);
+}
+
+SL12_TEST(InvalidInclude)
+{
+	Graph graph;
+	NodeId file = graph.AddFileNode("a.hlsl");
+	NodeId node = graph.AddNode({ file });
+	SL12_REQUIRE(node != Graph::kInvalidNode);
+
+	// ファイルノード以外や未追加のノードはインクルードできない
+	SL12_CHECK(graph.AddFileNode("b.hlsl", { node }) == Graph::kInvalidNode);
+	SL12_CHECK(graph.AddFileNode("c.hlsl", { 100 }) == Graph::kInvalidNode);
+	SL12_CHECK(graph.AddFileNode("A.HLSL") == Graph::kInvalidNode);
+	SL12_CHECK(graph.FindFile("b.hlsl") == Graph::kInvalidNode);
+	SL12_CHECK(graph.GetNodeCount() == 2);
+}
+
+SL12_TEST(RemoveIncludeFromChain)
+{
+	IncludeChain c;
+	SL12_CHECK(!c.graph.RemoveFile("shader/missing.hlsli"));
+	SL12_REQUIRE(c.graph.RemoveFile("Shader\\Lighting.hlsli"));
+	SL12_CHECK(!c.graph.RemoveFile("shader/lighting.hlsli"));
+
+	// IDは変わらず、依存関係のみ切り離される
+	SL12_CHECK(c.graph.FindFile("shader/lighting.hlsli") == Graph::kInvalidNode);
+	SL12_CHECK(c.graph.IsRemoved(c.lighting));
+	SL12_CHECK(!c.graph.IsFileNode(c.lighting));
+	SL12_CHECK(c.graph.GetDependents(c.common).empty());
+	SL12_CHECK(c.graph.GetDependencies(c.water).empty());
+	SL12_CHECK(c.graph.FindFile("shader/water.p.hlsl") == c.water);
+
+	// インクルードされなくなったファイルの変更はシェーダに伝わらない
+	Propagator p;
+	SL12_REQUIRE(p.Run(c.graph, { c.common }));
+	std::vector<NodeId> expected = { c.common };
+	SL12_CHECK(p.rebuilt == expected);
+
+	// 取り除いたノードを指定しても再構築しない
+	SL12_REQUIRE(p.Run(c.graph, { c.lighting }));
+	SL12_CHECK(p.rebuilt.empty());
+
+	// シェーダ自体の変更は従来どおり伝わる
+	SL12_REQUIRE(p.Run(c.graph, { c.water }));
+	expected = { c.water, c.waterRs, c.waterPso };
+	SL12_CHECK(p.rebuilt == expected);
+}
+
+SL12_TEST(RemoveAndReAddFile)
+{
+	IncludeChain c;
+	SL12_REQUIRE(c.graph.RemoveFile("shader/lighting.hlsli"));
+
+	// 取り除いたノードには依存できない
+	SL12_CHECK(c.graph.AddNode({ c.lighting }) == Graph::kInvalidNode);
+	SL12_CHECK(c.graph.AddFileNode("shader/other.hlsl", { c.lighting }) == Graph::kInvalidNode);
+
+	// 同じファイルは新しいノードとして追加できる
+	NodeId lighting = c.graph.AddFileNode("shader/lighting.hlsli", { c.common });
+	SL12_REQUIRE(lighting != Graph::kInvalidNode);
+	SL12_CHECK(lighting != c.lighting);
+	SL12_CHECK(c.graph.FindFile("shader/lighting.hlsli") == lighting);
+	NodeId water = c.graph.AddFileNode("shader/water2.p.hlsl", { lighting });
+	NodeId pso = c.graph.AddNode({ water });
+
+	Propagator p;
+	SL12_REQUIRE(p.Run(c.graph, { c.common }));
+	std::vector<NodeId> expected = { c.common, lighting, water, pso };
+	SL12_CHECK(p.rebuilt == expected);
+}
+
+SL12_TEST(RemoveOneSideOfDiamond)
+{
+	Diamond d;
+	SL12_REQUIRE(d.graph.RemoveFile("a.hlsli"));
+
+	// 残った経路から変更が伝わる
+	Propagator p;
+	SL12_REQUIRE(p.Run(d.graph, { d.common }));
+	std::vector<NodeId> expected = { d.common, d.b, d.shader, d.pso };
+	SL12_CHECK(p.rebuilt == expected);
+
+	// シェーダ自体を削除すると、インクルードファイルの変更はPSOに伝わらない
+	SL12_REQUIRE(d.graph.RemoveFile("shader.p.hlsl"));
+	SL12_CHECK(d.graph.GetDependencies(d.pso).empty());
+	SL12_REQUIRE(p.Run(d.graph, { d.common }));
+	expected = { d.common, d.b };
+	SL12_CHECK(p.rebuilt == expected);
+}
+
+//	EOF
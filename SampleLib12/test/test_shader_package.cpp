@@ -0,0 +1,240 @@
+﻿#include "test_util.h"
+#include "test_device.h"
+
+#include <sl12/shader_package.h>
+#include <sl12/shader.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/time.h>
+
+
+namespace
+{
+	// Sample008のシェーダ(テストはSampleLib12/testで実行される)
+	struct CsoFile
+	{
+		const char*				filename;
+		sl12::ShaderType::Type	type;
+	};
+	static const CsoFile kCsoFiles[] = {
+		{ "../../Sample008/data/base_pass.vv.cso", sl12::ShaderType::Vertex },
+		{ "../../Sample008/data/base_pass.p.cso", sl12::ShaderType::Pixel },
+		{ "../../Sample008/data/water.p.cso", sl12::ShaderType::Pixel },
+		{ "../../Sample008/data/tile_lighting.c.cso", sl12::ShaderType::Compute },
+	};
+
+	bool WriteFile(const std::string& filename, const std::vector<sl12::u8>& data)
+	{
+		std::ofstream ofs(filename, std::ios::binary | std::ios::trunc);
+		ofs.write(reinterpret_cast<const char*>(data.data()), data.size());
+		return ofs.good();
+	}
+
+	std::vector<sl12::u8> ReadFile(const std::string& filename)
+	{
+		std::ifstream ifs(filename, std::ios::binary);
+		return std::vector<sl12::u8>(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+	}
+
+	// 更新時刻のみを変更する
+	bool SetWriteTime(const std::string& filename, long seconds)
+	{
+		struct timeval times[2] = {};
+		times[0].tv_sec = seconds;
+		times[1].tv_sec = seconds;
+		return utimes(filename.c_str(), times) == 0;
+	}
+
+	bool OpenPackage(sl12::ShaderPackage& package, const std::vector<sl12::u8>& data)
+	{
+		std::shared_ptr<std::vector<sl12::u8>> storage = std::make_shared<std::vector<sl12::u8>>(data);
+		return package.OpenFromMemory(storage, storage->data(), storage->size());
+	}
+
+	// 現在のソースファイルの識別情報を記録したパッケージを作る
+	bool BuildWithStamp(const std::string& sourceFile, const std::vector<sl12::u8>& code, std::vector<sl12::u8>& outPackage)
+	{
+		sl12::ShaderSourceStamp stamp;
+		if (!sl12::GetShaderSourceStamp(sourceFile.c_str(), stamp))
+		{
+			return false;
+		}
+		sl12::ShaderPackageBuilder builder;
+		return builder.AddShader(sourceFile.c_str(), sl12::ShaderType::Pixel, code.data(), code.size(), nullptr, 0)
+			&& builder.SetSourceStamp(sourceFile.c_str(), stamp)
+			&& builder.SaveToMemory(outPackage);
+	}
+}
+
+SL12_TEST(SourceStampOfMissingFile)
+{
+	sl12::ShaderSourceStamp stamp;
+	stamp.size = 1;
+	SL12_CHECK(!sl12::GetShaderSourceStamp(sl12test::GetTempFilePath("missing.cso").c_str(), stamp));
+	SL12_CHECK(!stamp.IsValid());
+	SL12_CHECK(!sl12::GetShaderSourceStamp(nullptr, stamp));
+}
+
+SL12_TEST(SourceStampRoundTrip)
+{
+	std::string sourceFile = sl12test::GetTempFilePath("stamp_round_trip.cso");
+	std::vector<sl12::u8> code = { 'D', 'X', 'B', 'C', 1, 2, 3, 4 };
+	std::vector<sl12::u8> data;
+	SL12_REQUIRE(WriteFile(sourceFile, code));
+	SL12_REQUIRE(BuildWithStamp(sourceFile, code, data));
+
+	sl12::ShaderSourceStamp stamp;
+	SL12_REQUIRE(sl12::GetShaderSourceStamp(sourceFile.c_str(), stamp));
+	SL12_CHECK(stamp.size == code.size());
+
+	sl12::ShaderPackage package;
+	SL12_REQUIRE(OpenPackage(package, data));
+	sl12::u32 index = package.Find(sourceFile.c_str());
+	SL12_REQUIRE(index != sl12::ShaderPackage::kInvalidIndex);
+	SL12_CHECK(package.GetSourceStamp(index) == stamp);
+	SL12_CHECK(package.IsSourceUpToDate(index, sourceFile.c_str()));
+	SL12_CHECK(!package.IsSourceUpToDate(package.GetCount(), sourceFile.c_str()));
+
+	remove(sourceFile.c_str());
+}
+
+SL12_TEST(SizeChangeIsStale)
+{
+	std::string sourceFile = sl12test::GetTempFilePath("stamp_size.cso");
+	std::vector<sl12::u8> code = { 'D', 'X', 'B', 'C', 1, 2, 3, 4 };
+	std::vector<sl12::u8> data;
+	SL12_REQUIRE(WriteFile(sourceFile, code));
+	SL12_REQUIRE(SetWriteTime(sourceFile, 1000000));
+	SL12_REQUIRE(BuildWithStamp(sourceFile, code, data));
+
+	// 更新時刻を戻しても、サイズが変われば古いと判定する
+	code.push_back(5);
+	SL12_REQUIRE(WriteFile(sourceFile, code));
+	SL12_REQUIRE(SetWriteTime(sourceFile, 1000000));
+
+	sl12::ShaderPackage package;
+	SL12_REQUIRE(OpenPackage(package, data));
+	SL12_CHECK(!package.IsSourceUpToDate(0, sourceFile.c_str()));
+
+	remove(sourceFile.c_str());
+}
+
+SL12_TEST(WriteTimeChangeIsStale)
+{
+	std::string sourceFile = sl12test::GetTempFilePath("stamp_time.cso");
+	std::vector<sl12::u8> code = { 'D', 'X', 'B', 'C', 1, 2, 3, 4 };
+	std::vector<sl12::u8> data;
+	SL12_REQUIRE(WriteFile(sourceFile, code));
+	SL12_REQUIRE(SetWriteTime(sourceFile, 1000000));
+	SL12_REQUIRE(BuildWithStamp(sourceFile, code, data));
+
+	sl12::ShaderPackage package;
+	SL12_REQUIRE(OpenPackage(package, data));
+	SL12_CHECK(package.IsSourceUpToDate(0, sourceFile.c_str()));
+
+	// 同じサイズで書き換えた場合
+	code[4] = 9;
+	SL12_REQUIRE(WriteFile(sourceFile, code));
+	SL12_REQUIRE(SetWriteTime(sourceFile, 1000001));
+	SL12_CHECK(!package.IsSourceUpToDate(0, sourceFile.c_str()));
+
+	remove(sourceFile.c_str());
+}
+
+SL12_TEST(MissingSourceIsUpToDate)
+{
+	// パッケージのみを配布する場合はソースファイルがない
+	std::string sourceFile = sl12test::GetTempFilePath("stamp_missing.cso");
+	std::vector<sl12::u8> code = { 'D', 'X', 'B', 'C', 1, 2, 3, 4 };
+	std::vector<sl12::u8> data;
+	SL12_REQUIRE(WriteFile(sourceFile, code));
+	SL12_REQUIRE(BuildWithStamp(sourceFile, code, data));
+	remove(sourceFile.c_str());
+
+	sl12::ShaderPackage package;
+	SL12_REQUIRE(OpenPackage(package, data));
+	SL12_CHECK(package.IsSourceUpToDate(0, sourceFile.c_str()));
+}
+
+SL12_TEST(NoStampIsStale)
+{
+	std::string sourceFile = sl12test::GetTempFilePath("stamp_none.cso");
+	std::vector<sl12::u8> code = { 'D', 'X', 'B', 'C', 1, 2, 3, 4 };
+	SL12_REQUIRE(WriteFile(sourceFile, code));
+
+	// 識別情報を記録していない場合はソースファイルがあれば作り直す
+	sl12::ShaderPackageBuilder builder;
+	SL12_REQUIRE(builder.AddShader(sourceFile.c_str(), sl12::ShaderType::Pixel, code.data(), code.size(), nullptr, 0));
+	SL12_CHECK(!builder.SetSourceStamp("unknown", sl12::ShaderSourceStamp()));
+	std::vector<sl12::u8> data;
+	SL12_REQUIRE(builder.SaveToMemory(data));
+
+	sl12::ShaderPackage package;
+	SL12_REQUIRE(OpenPackage(package, data));
+	SL12_CHECK(!package.GetSourceStamp(0).IsValid());
+	SL12_CHECK(!package.IsSourceUpToDate(0, sourceFile.c_str()));
+
+	remove(sourceFile.c_str());
+}
+
+SL12_TEST(OldVersionIsRejected)
+{
+	std::vector<sl12::u8> code = { 'D', 'X', 'B', 'C', 1, 2, 3, 4 };
+	sl12::ShaderPackageBuilder builder;
+	SL12_REQUIRE(builder.AddShader("a", sl12::ShaderType::Pixel, code.data(), code.size(), nullptr, 0));
+	std::vector<sl12::u8> data;
+	SL12_REQUIRE(builder.SaveToMemory(data));
+
+	sl12::ShaderPackage package;
+	SL12_CHECK(OpenPackage(package, data));
+	package.Close();
+
+	// 識別情報を持たない以前のフォーマットは開かずに作り直させる
+	sl12::ShaderPackageFormat::Header header;
+	memcpy(&header, data.data(), sizeof(header));
+	header.version = sl12::ShaderPackageFormat::kVersion - 1;
+	memcpy(data.data(), &header, sizeof(header));
+	SL12_CHECK(!OpenPackage(package, data));
+}
+
+SL12_TEST(FileRoundTripWithCso)
+{
+	// Sample008と同じ手順で作成し、開き直す
+	sl12test::TestDevice td;
+	sl12::ShaderPackageBuilder builder;
+	for (auto&& f : kCsoFiles)
+	{
+		sl12::ShaderSourceStamp stamp;
+		SL12_REQUIRE(sl12::GetShaderSourceStamp(f.filename, stamp));
+		sl12::Shader shader;
+		SL12_REQUIRE(shader.Initialize(&td.GetDevice(), f.type, f.filename));
+		SL12_REQUIRE(builder.AddShader(f.filename, f.type, shader.GetData(), shader.GetSize()));
+		SL12_REQUIRE(builder.SetSourceStamp(f.filename, stamp));
+	}
+	std::string packageFile = sl12test::GetTempFilePath("shaders.pack");
+	SL12_REQUIRE(builder.Save(packageFile.c_str()));
+
+	sl12::ShaderPackage package;
+	SL12_REQUIRE(package.Open(packageFile.c_str()));
+	SL12_CHECK(package.GetCount() == sizeof(kCsoFiles) / sizeof(kCsoFiles[0]));
+	for (auto&& f : kCsoFiles)
+	{
+		sl12::u32 index = package.Find(f.filename);
+		SL12_REQUIRE(index != sl12::ShaderPackage::kInvalidIndex);
+		SL12_CHECK(package.IsSourceUpToDate(index, f.filename));
+
+		sl12::Shader shader;
+		SL12_REQUIRE(package.CreateShader(&td.GetDevice(), index, shader));
+		SL12_CHECK(shader.GetShaderType() == f.type);
+		auto code = ReadFile(f.filename);
+		SL12_CHECK(shader.GetSize() == code.size() && memcmp(shader.GetData(), code.data(), code.size()) == 0);
+	}
+	package.Close();
+	remove(packageFile.c_str());
+}
+
+//	EOF
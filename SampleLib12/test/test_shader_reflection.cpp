@@ -0,0 +1,285 @@
+﻿#include "test_util.h"
+
+#include <sl12/shader_reflection.h>
+#include <dirent.h>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+	// D3D_SHADER_INPUT_TYPE, D3D_SRV_DIMENSION
+	static const sl12::u32 kCBuffer = 0;
+	static const sl12::u32 kTexture = 2;
+	static const sl12::u32 kSampler = 3;
+	static const sl12::u32 kUavRWTyped = 4;
+	static const sl12::u32 kStructured = 5;
+	static const sl12::u32 kByteAddress = 7;
+	static const sl12::u32 kUavRWByteAddress = 8;
+	static const sl12::u32 kMaxInputType = 11;
+	static const sl12::u32 kDimBuffer = 1;
+	static const sl12::u32 kDimTexture2D = 4;
+
+	// リポジトリ内のサンプルのシェーダ(テストはSampleLib12/testで実行される)
+	static const char* kDataDirectories[] = {
+		"../../Sample001/data",
+		"../../Sample002/data",
+		"../../Sample003/data",
+		"../../Sample004/data",
+		"../../Sample005/data",
+		"../../Sample006/data",
+		"../../Sample007/data",
+		"../../Sample008/data",
+	};
+
+	std::vector<sl12::u8> ReadFile(const std::string& filename)
+	{
+		std::ifstream ifs(filename, std::ios::binary);
+		return std::vector<sl12::u8>(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+	}
+
+	std::vector<std::string> ListCsoFiles()
+	{
+		std::vector<std::string> files;
+		for (auto dir : kDataDirectories)
+		{
+			DIR* d = opendir(dir);
+			if (!d)
+			{
+				continue;
+			}
+			while (auto entry = readdir(d))
+			{
+				std::string name = entry->d_name;
+				if (name.size() > 4 && name.compare(name.size() - 4, 4, ".cso") == 0)
+				{
+					files.push_back(std::string(dir) + "/" + name);
+				}
+			}
+			closedir(d);
+		}
+		return files;
+	}
+
+	struct Expected
+	{
+		const char*		name;
+		sl12::u32		inputType;
+		sl12::u32		bindPoint;
+		sl12::u32		dimension;
+		sl12::u32		constantBufferSize;
+	};
+
+	// 並び順を含めて一致するか(全て配列ではなく、スペース0)
+	bool IsSameBindings(const std::vector<sl12::ShaderBindingDesc>& bindings, const Expected* pExpected, size_t count)
+	{
+		if (bindings.size() != count)
+		{
+			return false;
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			auto&& b = bindings[i];
+			auto&& e = pExpected[i];
+			if (b.name != e.name || b.inputType != e.inputType || b.bindPoint != e.bindPoint || b.bindCount != 1
+				|| b.space != 0 || b.dimension != e.dimension || b.constantBufferSize != e.constantBufferSize)
+			{
+				fprintf(stderr, "  binding %zu mismatch: %s\n", i, b.name.c_str());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool ReflectFile(const char* filename, std::vector<sl12::ShaderBindingDesc>& outBindings)
+	{
+		auto data = ReadFile(filename);
+		bool isNative = false;
+		return sl12::ReflectShaderBindings(data.data(), data.size(), outBindings, &isNative) && isNative;
+	}
+
+	// RDEFチャンクの先頭のファイル内オフセット
+	size_t FindResourceDefOffset(const std::vector<sl12::u8>& data)
+	{
+		sl12::DxbcContainer container;
+		if (!container.Initialize(data.data(), data.size()))
+		{
+			return 0;
+		}
+		auto p = container.FindChunk(sl12::DxbcContainer::kFourCCResourceDef);
+		return p ? static_cast<size_t>(p - data.data()) : 0;
+	}
+}
+
+SL12_TEST(AllRepoShadersParse)
+{
+	auto files = ListCsoFiles();
+	SL12_REQUIRE(files.size() >= 50);
+
+	for (auto&& file : files)
+	{
+		auto data = ReadFile(file);
+		sl12::DxbcContainer container;
+		bool isValid = container.Initialize(data.data(), data.size())
+			&& !container.IsDxil()
+			&& container.HasChunk(sl12::DxbcContainer::kFourCCResourceDef);
+		if (!isValid)
+		{
+			fprintf(stderr, "  invalid container: %s\n", file.c_str());
+			SL12_CHECK(isValid);
+			continue;
+		}
+
+		// fxcの出力はD3DReflectを使わずに解析できる
+		std::vector<sl12::ShaderBindingDesc> bindings;
+		bool isNative = false;
+		SL12_CHECK(sl12::ReflectShaderBindings(data.data(), data.size(), bindings, &isNative));
+		SL12_CHECK(isNative);
+		for (auto&& b : bindings)
+		{
+			SL12_CHECK(!b.name.empty());
+			SL12_CHECK(b.inputType <= kMaxInputType);
+			SL12_CHECK(b.bindCount >= 1);
+			if (b.inputType == kCBuffer)
+			{
+				SL12_CHECK(b.constantBufferSize > 0 && (b.constantBufferSize % 16) == 0);
+			}
+			else
+			{
+				SL12_CHECK(b.constantBufferSize == 0);
+			}
+		}
+	}
+}
+
+SL12_TEST(KnownBindings)
+{
+	// 期待値は各シェーダのHLSLの宣言から
+	std::vector<sl12::ShaderBindingDesc> bindings;
+	{
+		static const Expected kWater[] = {
+			{ "samLinear", kSampler, 0, 0, 0 },
+			{ "texSSPR", kTexture, 0, kDimTexture2D, 0 },
+			{ "texNormal", kTexture, 1, kDimTexture2D, 0 },
+			{ "CbScene", kCBuffer, 0, 0, 288 },
+			{ "CbWaterInfo", kCBuffer, 1, 0, 32 },
+		};
+		SL12_REQUIRE(ReflectFile("../../Sample008/data/water.p.cso", bindings));
+		SL12_CHECK(IsSameBindings(bindings, kWater, sizeof(kWater) / sizeof(kWater[0])));
+	}
+	{
+		static const Expected kTileLighting[] = {
+			{ "rLightPosBuffer", kStructured, 0, kDimBuffer, 0 },
+			{ "rLightColorBuffer", kStructured, 1, kDimBuffer, 0 },
+			{ "texGBuffer0", kTexture, 2, kDimTexture2D, 0 },
+			{ "texGBuffer1", kTexture, 3, kDimTexture2D, 0 },
+			{ "texGBuffer2", kTexture, 4, kDimTexture2D, 0 },
+			{ "texLinearDepth", kTexture, 5, kDimTexture2D, 0 },
+			{ "rwFinal", kUavRWTyped, 0, kDimTexture2D, 0 },
+			{ "CbScene", kCBuffer, 0, 0, 288 },
+			{ "CbLightInfo", kCBuffer, 1, 0, 16 },
+		};
+		SL12_REQUIRE(ReflectFile("../../Sample008/data/tile_lighting.c.cso", bindings));
+		SL12_CHECK(IsSameBindings(bindings, kTileLighting, sizeof(kTileLighting) / sizeof(kTileLighting[0])));
+	}
+	{
+		// float4x4 + uintは16バイト境界に切り上げて80バイト
+		static const Expected kWorldTransform[] = {
+			{ "rSrcVBuffer", kByteAddress, 0, kDimBuffer, 0 },
+			{ "rwDstVBuffer", kUavRWByteAddress, 0, kDimBuffer, 0 },
+			{ "cbWorld", kCBuffer, 0, 0, 80 },
+		};
+		SL12_REQUIRE(ReflectFile("../../Sample004/data/world_transform_fp32.cso", bindings));
+		SL12_CHECK(IsSameBindings(bindings, kWorldTransform, sizeof(kWorldTransform) / sizeof(kWorldTransform[0])));
+	}
+}
+
+SL12_TEST(UnboundedArrayIsZero)
+{
+	auto data = ReadFile("../../Sample008/data/water.p.cso");
+	size_t rdef = FindResourceDefOffset(data);
+	SL12_REQUIRE(rdef != 0);
+
+	// 先頭のバインドの個数を上限なし(0xffffffff)に書き換える
+	sl12::u32 bindOffset;
+	memcpy(&bindOffset, data.data() + rdef + 12, sizeof(bindOffset));
+	sl12::u32 unbounded = 0xffffffff;
+	memcpy(data.data() + rdef + bindOffset + 24, &unbounded, sizeof(unbounded));
+
+	std::vector<sl12::ShaderBindingDesc> bindings;
+	SL12_REQUIRE(sl12::ReflectShaderBindings(data.data(), data.size(), bindings));
+	SL12_REQUIRE(!bindings.empty());
+	SL12_CHECK(bindings[0].bindCount == 0);
+}
+
+SL12_TEST(MissingResourceDef)
+{
+	auto data = ReadFile("../../Sample008/data/water.p.cso");
+	size_t rdef = FindResourceDefOffset(data);
+	SL12_REQUIRE(rdef >= 8);
+
+	// チャンクのFourCCを書き換えてRDEFがないコンテナにする
+	memcpy(data.data() + rdef - 8, "XXXX", 4);
+	sl12::DxbcContainer container;
+	SL12_REQUIRE(container.Initialize(data.data(), data.size()));
+	SL12_CHECK(!container.HasChunk(sl12::DxbcContainer::kFourCCResourceDef));
+
+	// D3DReflectはWindowsでのみ使用する
+	std::vector<sl12::ShaderBindingDesc> bindings(1);
+	bool isNative = true;
+	SL12_CHECK(!sl12::ReflectShaderBindings(data.data(), data.size(), bindings, &isNative));
+	SL12_CHECK(!isNative);
+	SL12_CHECK(bindings.empty());
+}
+
+SL12_TEST(TruncatedContainer)
+{
+	auto data = ReadFile("../../Sample008/data/tile_lighting.c.cso");
+	SL12_REQUIRE(data.size() > 64);
+
+	// コンテナのサイズに満たないデータは解析しない
+	std::vector<sl12::ShaderBindingDesc> bindings;
+	for (size_t size = 0; size < data.size(); size += 61)
+	{
+		std::vector<sl12::u8> truncated(data.begin(), data.begin() + size);
+		sl12::DxbcContainer container;
+		SL12_CHECK(!container.Initialize(truncated.data(), truncated.size()));
+		SL12_CHECK(!sl12::ReflectShaderBindings(truncated.data(), truncated.size(), bindings));
+	}
+}
+
+SL12_TEST(CorruptResourceDef)
+{
+	auto data = ReadFile("../../Sample008/data/tile_lighting.c.cso");
+	size_t rdef = FindResourceDefOffset(data);
+	SL12_REQUIRE(rdef != 0);
+	sl12::u32 rdefSize;
+	memcpy(&rdefSize, data.data() + rdef - 4, sizeof(rdefSize));
+
+	// RDEFの任意の位置を壊しても範囲外を読まない(AddressSanitizerで確認する)
+	std::mt19937 rng(12345);
+	std::vector<sl12::ShaderBindingDesc> bindings;
+	int numFailed = 0;
+	for (int i = 0; i < 2000; i++)
+	{
+		auto corrupt = data;
+		for (int j = 0; j < 4; j++)
+		{
+			corrupt[rdef + rng() % rdefSize] = static_cast<sl12::u8>(rng());
+		}
+		sl12::DxbcContainer container;
+		SL12_REQUIRE(container.Initialize(corrupt.data(), corrupt.size()));
+		if (!container.GetBindingsFromResourceDef(bindings))
+		{
+			SL12_CHECK(bindings.empty());
+			numFailed++;
+		}
+	}
+	SL12_CHECK(numFailed > 0);
+}
+
+//	EOF
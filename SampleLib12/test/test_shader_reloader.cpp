@@ -0,0 +1,166 @@
+﻿#include "test_util.h"
+#include "test_device.h"
+
+#include <sl12/root_signature_manager.h>
+#include <sl12/shader.h>
+#include <sl12/shader_reloader.h>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace
+{
+	typedef sl12::ShaderDependencyGraph Graph;
+
+	bool WriteFile(const std::string& filename, const std::string& data)
+	{
+		std::ofstream ofs(filename, std::ios::binary | std::ios::trunc);
+		ofs.write(data.data(), data.size());
+		return ofs.good();
+	}
+
+	// 監視するディレクトリとファイル. 偽のデバイスはバイトコードを参照しないので、中身は任意のバイト列でよい
+	struct ShaderFiles
+	{
+		std::string		dir;
+		std::string		shaderA;
+		std::string		shaderB;
+		std::string		include;
+
+		explicit ShaderFiles(const char* name)
+			: dir(sl12test::GetTempFilePath(name))
+			, shaderA(dir + "/a.cso")
+			, shaderB(dir + "/b.cso")
+			, include(dir + "/common.hlsli")
+		{}
+		~ShaderFiles()
+		{
+			remove(shaderA.c_str());
+			remove(shaderB.c_str());
+			remove(include.c_str());
+			rmdir(dir.c_str());
+		}
+
+		bool Create()
+		{
+			mkdir(dir.c_str(), 0755);
+			return WriteFile(shaderA, "DXBC_A") && WriteFile(shaderB, "DXBC_B") && WriteFile(include, "float4 g;");
+		}
+	};	// struct ShaderFiles
+
+	bool DependsOn(const Graph& graph, const std::string& dependent, const std::string& dependency)
+	{
+		auto id = graph.FindFile(dependent.c_str());
+		auto dep = graph.FindFile(dependency.c_str());
+		if (id == Graph::kInvalidNode || dep == Graph::kInvalidNode)
+		{
+			return false;
+		}
+		auto&& deps = graph.GetDependencies(id);
+		return std::find(deps.begin(), deps.end(), dep) != deps.end();
+	}
+}
+
+//----
+// インクルードファイルの変更でインクルードする全てのシェーダを再読み込みする
+//----
+SL12_TEST(IncludeChangeReloadsShaders)
+{
+	ShaderFiles files("reloader_include");
+	SL12_REQUIRE(files.Create());
+
+	sl12test::TestDevice td;
+	sl12::RootSignatureManager rootSigMan;
+	sl12::Shader shaderA, shaderB;
+	SL12_REQUIRE(shaderA.Initialize(&td.GetDevice(), sl12::ShaderType::Pixel, files.shaderA.c_str()));
+	SL12_REQUIRE(shaderB.Initialize(&td.GetDevice(), sl12::ShaderType::Pixel, files.shaderB.c_str()));
+
+	// 監視できないディレクトリを指定し、RequestReload()のみで再構築する
+	sl12::ShaderReloader reloader;
+	SL12_REQUIRE(reloader.Initialize(&td.GetDevice(), &rootSigMan, (files.dir + "/none").c_str(), 0));
+	SL12_REQUIRE(reloader.RegisterShader(&shaderA, files.shaderA.c_str(), { files.include }));
+	SL12_REQUIRE(reloader.RegisterShader(&shaderB, files.shaderB.c_str(), { files.include }));
+	SL12_CHECK(!reloader.RegisterShader(&shaderB, files.shaderB.c_str()));
+
+	// 同じインクルードファイルは1つのノードを共有する
+	auto&& graph = reloader.GetGraph();
+	SL12_CHECK(graph.GetNodeCount() == 3);
+	SL12_CHECK(DependsOn(graph, files.shaderA, files.include));
+	SL12_CHECK(DependsOn(graph, files.shaderB, files.include));
+
+	// シェーダファイル自体は変更を通知しない
+	SL12_REQUIRE(WriteFile(files.shaderA, "DXBC_A2"));
+	SL12_REQUIRE(WriteFile(files.shaderB, "DXBC_B2"));
+	sl12::Shader expectA, expectB;
+	SL12_REQUIRE(expectA.Initialize(&td.GetDevice(), sl12::ShaderType::Pixel, files.shaderA.c_str()));
+	SL12_REQUIRE(expectB.Initialize(&td.GetDevice(), sl12::ShaderType::Pixel, files.shaderB.c_str()));
+
+	reloader.RequestReload(files.include.c_str());
+	SL12_REQUIRE(reloader.Update());
+	reloader.Commit();
+	SL12_CHECK(reloader.GetCommitCount() == 1);
+	SL12_CHECK(reloader.GetFailedCount() == 0);
+	SL12_CHECK(shaderA.GetHash() == expectA.GetHash());
+	SL12_CHECK(shaderB.GetHash() == expectB.GetHash());
+
+	// バイトコードが変わらなければ差し替えない
+	reloader.RequestReload(files.include.c_str());
+	SL12_CHECK(!reloader.Update());
+	SL12_CHECK(reloader.GetCommitCount() == 1);
+
+	reloader.Destroy();
+}
+
+//----
+// 削除されたファイルは待ち時間の経過後も存在しなければ監視対象から外す
+//----
+SL12_TEST(RemovedFileStopsTracking)
+{
+	ShaderFiles files("reloader_remove");
+	SL12_REQUIRE(files.Create());
+
+	sl12test::TestDevice td;
+	sl12::RootSignatureManager rootSigMan;
+	sl12::Shader shader;
+	SL12_REQUIRE(shader.Initialize(&td.GetDevice(), sl12::ShaderType::Pixel, files.shaderA.c_str()));
+
+	sl12::ShaderReloader reloader;
+	SL12_REQUIRE(reloader.Initialize(&td.GetDevice(), &rootSigMan, files.dir.c_str(), 0));
+	SL12_REQUIRE(reloader.RegisterShader(&shader, files.shaderA.c_str(), { files.include }));
+	auto&& graph = reloader.GetGraph();
+
+	// 削除してすぐに作り直した場合は変更として扱う
+	remove(files.include.c_str());
+	SL12_REQUIRE(WriteFile(files.include, "float4 g2;"));
+	SL12_CHECK(!reloader.Update());
+	SL12_CHECK(DependsOn(graph, files.shaderA, files.include));
+	SL12_CHECK(reloader.GetFailedCount() == 0);
+
+	// 削除されたままであれば依存関係から外し、シェーダは旧オブジェクトを使い続ける
+	sl12::u64 hash = shader.GetHash();
+	remove(files.include.c_str());
+	SL12_CHECK(!reloader.Update());
+	SL12_CHECK(graph.FindFile(files.include.c_str()) == Graph::kInvalidNode);
+	SL12_CHECK(graph.GetDependencies(graph.FindFile(files.shaderA.c_str())).empty());
+	SL12_CHECK(reloader.GetFailedCount() == 0);
+	SL12_CHECK(shader.GetHash() == hash);
+
+	// 外したファイルは再構築の対象にならない
+	reloader.RequestReload(files.include.c_str());
+	SL12_CHECK(!reloader.Update());
+
+	// シェーダ自体は引き続き監視する
+	SL12_REQUIRE(WriteFile(files.shaderA, "DXBC_A2"));
+	SL12_CHECK(reloader.Update());
+	reloader.Commit();
+	SL12_CHECK(reloader.GetCommitCount() == 1);
+	SL12_CHECK(shader.GetHash() != hash);
+
+	reloader.Destroy();
+}
+
+//	EOF
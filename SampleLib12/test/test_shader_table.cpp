@@ -0,0 +1,347 @@
+﻿#include "test_util.h"
+#include "test_device.h"
+
+#include <sl12/shader_table.h>
+#include <sl12/buffer.h>
+#include <algorithm>
+#include <random>
+
+
+namespace
+{
+	static const sl12::u32 kIdSize = D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES;
+	static const sl12::u32 kRecordAlign = D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT;
+	static const sl12::u32 kTableAlign = D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT;
+
+	const sl12::ShaderTableKind::Type kKinds[] = {
+		sl12::ShaderTableKind::RayGeneration,
+		sl12::ShaderTableKind::Miss,
+		sl12::ShaderTableKind::HitGroup,
+		sl12::ShaderTableKind::Callable,
+	};
+
+	// レコードごとに異なるシェーダID
+	struct ShaderId
+	{
+		sl12::u8	bytes[kIdSize];
+
+		explicit ShaderId(sl12::u8 v)
+		{
+			for (auto&& b : bytes) b = v;
+		}
+	};	// struct ShaderId
+
+	// レイアウトの不変条件を確認する
+	bool CheckLayout(const sl12::ShaderTable& table, const std::vector<sl12::u32> (&argSizes)[sl12::ShaderTableKind::Max])
+	{
+		sl12::u64 end = 0;
+		for (auto kind : kKinds)
+		{
+			sl12::u32 num = table.GetRecordCount(kind);
+			if (num != argSizes[kind].size())
+				return false;
+			if (num == 0)
+			{
+				if (table.GetTableSize(kind) != 0)
+					return false;
+				continue;
+			}
+
+			sl12::u32 maxArg = 0;
+			for (auto size : argSizes[kind]) maxArg = std::max(maxArg, size);
+			sl12::u32 stride = table.GetRecordStride(kind);
+			sl12::u32 align = (kind == sl12::ShaderTableKind::RayGeneration) ? kTableAlign : kRecordAlign;
+
+			// ストライドは最大のレコードを収める最小のアラインメントの倍数
+			if (stride % align != 0 || stride < kIdSize + maxArg || stride >= kIdSize + maxArg + align)
+				return false;
+			// テーブルの先頭はテーブルアラインメントに揃い、前のテーブルと重ならない
+			if (table.GetTableOffset(kind) % kTableAlign != 0 || table.GetTableOffset(kind) < end)
+				return false;
+			if (table.GetTableSize(kind) != static_cast<sl12::u64>(stride) * num)
+				return false;
+			for (sl12::u32 i = 0; i < num; i++)
+			{
+				if (table.GetRecordOffset(kind, i) != table.GetTableOffset(kind) + static_cast<sl12::u64>(stride) * i)
+					return false;
+			}
+			end = table.GetTableOffset(kind) + table.GetTableSize(kind);
+		}
+		return table.GetSize() == end;
+	}
+}
+
+//----
+// レコードサイズからストライドとテーブル位置が決まる
+//----
+SL12_TEST(LayoutAlignmentAndStrides)
+{
+	sl12::ShaderTable table;
+	SL12_CHECK(table.AddRecord(sl12::ShaderTableKind::RayGeneration, 8) == 0);
+	SL12_CHECK(table.AddRecord(sl12::ShaderTableKind::RayGeneration, 40) == 1);
+	SL12_CHECK(table.AddRecord(sl12::ShaderTableKind::Miss, 0) == 0);
+	SL12_CHECK(table.AddRecord(sl12::ShaderTableKind::Miss, 16) == 1);
+	SL12_CHECK(table.AddRecord(sl12::ShaderTableKind::Miss, 8) == 2);
+	SL12_CHECK(table.AddRecord(sl12::ShaderTableKind::HitGroup, 24) == 0);
+	SL12_CHECK(table.AddRecord(sl12::ShaderTableKind::HitGroup, 100) == 1);
+	SL12_REQUIRE(table.Build());
+
+	// レイ生成: 32+40 -> 128 (テーブルアラインメント)
+	SL12_CHECK(table.GetRecordStride(sl12::ShaderTableKind::RayGeneration) == 128);
+	SL12_CHECK(table.GetTableOffset(sl12::ShaderTableKind::RayGeneration) == 0);
+	SL12_CHECK(table.GetTableSize(sl12::ShaderTableKind::RayGeneration) == 256);
+	// ミス: 32+16 -> 64、256から開始
+	SL12_CHECK(table.GetRecordStride(sl12::ShaderTableKind::Miss) == 64);
+	SL12_CHECK(table.GetTableOffset(sl12::ShaderTableKind::Miss) == 256);
+	SL12_CHECK(table.GetTableSize(sl12::ShaderTableKind::Miss) == 192);
+	// ヒットグループ: 32+100 -> 160、448から開始(64の倍数)
+	SL12_CHECK(table.GetRecordStride(sl12::ShaderTableKind::HitGroup) == 160);
+	SL12_CHECK(table.GetTableOffset(sl12::ShaderTableKind::HitGroup) == 448);
+	SL12_CHECK(table.GetRecordOffset(sl12::ShaderTableKind::HitGroup, 1) == 608);
+	// 空のコーラブルテーブルはパディングを追加しない
+	SL12_CHECK(table.GetTableSize(sl12::ShaderTableKind::Callable) == 0);
+	SL12_CHECK(table.GetSize() == 768);
+
+	// ヒットグループの先頭がテーブルアラインメントに揃うようパディングされる
+	sl12::ShaderTable padded;
+	padded.AddRecord(sl12::ShaderTableKind::Miss, 0);
+	padded.AddRecord(sl12::ShaderTableKind::HitGroup, 0);
+	SL12_REQUIRE(padded.Build());
+	SL12_CHECK(padded.GetRecordStride(sl12::ShaderTableKind::Miss) == 32);
+	SL12_CHECK(padded.GetTableOffset(sl12::ShaderTableKind::Miss) == 0);
+	SL12_CHECK(padded.GetTableOffset(sl12::ShaderTableKind::HitGroup) == 64);
+	SL12_CHECK(padded.GetSize() == 96);
+
+	// Build()後はレコードを追加できない
+	SL12_CHECK(table.AddRecord(sl12::ShaderTableKind::Miss, 0) == sl12::ShaderTable::kInvalidIndex);
+	SL12_CHECK(!table.Build());
+}
+
+//----
+// ランダムな構成でもレイアウトの不変条件を満たす
+//----
+SL12_TEST(RandomLayouts)
+{
+	std::mt19937 rng(45);
+	for (int round = 0; round < 500; round++)
+	{
+		std::vector<sl12::u32> argSizes[sl12::ShaderTableKind::Max];
+		sl12::ShaderTable table;
+		for (auto kind : kKinds)
+		{
+			sl12::u32 num = rng() % 5;
+			for (sl12::u32 i = 0; i < num; i++)
+			{
+				// ローカルルート引数は4バイト単位
+				sl12::u32 size = (rng() % 65) * 4;
+				argSizes[kind].push_back(size);
+				SL12_CHECK(table.AddRecord(kind, size) == i);
+			}
+		}
+		SL12_REQUIRE(table.Build());
+		SL12_CHECK(CheckLayout(table, argSizes));
+	}
+}
+
+//----
+// 最大ストライドを超えるレコードはBuild()に失敗する
+//----
+SL12_TEST(RecordTooLarge)
+{
+	sl12::ShaderTable ok;
+	ok.AddRecord(sl12::ShaderTableKind::HitGroup, D3D12_RAYTRACING_MAX_SHADER_RECORD_STRIDE - kIdSize);
+	SL12_CHECK(ok.Build());
+	SL12_CHECK(ok.GetRecordStride(sl12::ShaderTableKind::HitGroup) == D3D12_RAYTRACING_MAX_SHADER_RECORD_STRIDE);
+
+	sl12::ShaderTable ng;
+	ng.AddRecord(sl12::ShaderTableKind::HitGroup, D3D12_RAYTRACING_MAX_SHADER_RECORD_STRIDE - kIdSize + 4);
+	SL12_CHECK(!ng.Build());
+	SL12_CHECK(!ng.IsBuilt());
+}
+
+//----
+// シェーダIDとローカルルート引数はレコード内の決まった位置に書き込まれる
+//----
+SL12_TEST(RecordPacking)
+{
+	sl12::ShaderTable table;
+	table.AddRecord(sl12::ShaderTableKind::RayGeneration, 16);
+	table.AddRecord(sl12::ShaderTableKind::HitGroup, 8);
+	table.AddRecord(sl12::ShaderTableKind::HitGroup, 32);
+	SL12_REQUIRE(table.Build());
+
+	ShaderId id(0xa5);
+	SL12_CHECK(table.SetShaderIdentifier(sl12::ShaderTableKind::HitGroup, 1, id.bytes));
+	D3D12_GPU_DESCRIPTOR_HANDLE handles[] = { { 0x1111 }, { 0x2222 } };
+	SL12_CHECK(table.SetDescriptorHandle(sl12::ShaderTableKind::HitGroup, 1, 0, handles[0]));
+	SL12_CHECK(table.SetDescriptorHandle(sl12::ShaderTableKind::HitGroup, 1, 3, handles[1]));
+
+	const sl12::u8* p = table.GetImage() + table.GetRecordOffset(sl12::ShaderTableKind::HitGroup, 1);
+	SL12_CHECK(memcmp(p, id.bytes, kIdSize) == 0);
+	D3D12_GPU_DESCRIPTOR_HANDLE read;
+	memcpy(&read, p + kIdSize, sizeof(read));
+	SL12_CHECK(read.ptr == 0x1111);
+	memcpy(&read, p + kIdSize + 24, sizeof(read));
+	SL12_CHECK(read.ptr == 0x2222);
+	// ローカルルート引数の先頭は8バイトに揃う
+	SL12_CHECK((table.GetRecordOffset(sl12::ShaderTableKind::HitGroup, 1) + kIdSize) % 8 == 0);
+
+	// 隣のレコードには書き込まれない
+	const sl12::u8* p0 = table.GetImage() + table.GetRecordOffset(sl12::ShaderTableKind::HitGroup, 0);
+	for (sl12::u32 i = 0; i < table.GetRecordStride(sl12::ShaderTableKind::HitGroup); i++)
+	{
+		SL12_CHECK(p0[i] == 0);
+	}
+
+	// 登録したサイズを超えるローカルルート引数、存在しないレコード
+	SL12_CHECK(!table.SetDescriptorHandle(sl12::ShaderTableKind::HitGroup, 0, 1, handles[0]));
+	SL12_CHECK(!table.SetLocalArguments(sl12::ShaderTableKind::RayGeneration, 0, handles, 8, 12));
+	SL12_CHECK(!table.SetShaderIdentifier(sl12::ShaderTableKind::HitGroup, 2, id.bytes));
+	SL12_CHECK(!table.SetShaderIdentifier(sl12::ShaderTableKind::Miss, 0, id.bytes));
+	SL12_CHECK(!table.SetShaderIdentifier(sl12::ShaderTableKind::HitGroup, 0, nullptr));
+}
+
+//----
+// DispatchRaysの記述子
+//----
+SL12_TEST(FillDispatchRaysDesc)
+{
+	sl12::ShaderTable table;
+	table.AddRecord(sl12::ShaderTableKind::RayGeneration, 8);
+	table.AddRecord(sl12::ShaderTableKind::RayGeneration, 8);
+	table.AddRecord(sl12::ShaderTableKind::Miss, 8);
+	table.AddRecord(sl12::ShaderTableKind::HitGroup, 40);
+	table.AddRecord(sl12::ShaderTableKind::HitGroup, 8);
+	SL12_REQUIRE(table.Build());
+
+	const D3D12_GPU_VIRTUAL_ADDRESS kBase = 0x10000;
+	D3D12_DISPATCH_RAYS_DESC desc{};
+	desc.Width = 1280;
+	table.FillDispatchRaysDesc(kBase, desc, 1);
+	SL12_CHECK(desc.RayGenerationShaderRecord.StartAddress == kBase + 64);
+	SL12_CHECK(desc.RayGenerationShaderRecord.SizeInBytes == 64);
+	SL12_CHECK(desc.RayGenerationShaderRecord.StartAddress % kTableAlign == 0);
+	SL12_CHECK(desc.MissShaderTable.StartAddress == kBase + 128);
+	SL12_CHECK(desc.MissShaderTable.SizeInBytes == 64);
+	SL12_CHECK(desc.MissShaderTable.StrideInBytes == 64);
+	SL12_CHECK(desc.HitGroupTable.StartAddress == kBase + 192);
+	SL12_CHECK(desc.HitGroupTable.SizeInBytes == 192);
+	SL12_CHECK(desc.HitGroupTable.StrideInBytes == 96);
+	SL12_CHECK(desc.CallableShaderTable.StartAddress == 0);
+	SL12_CHECK(desc.CallableShaderTable.SizeInBytes == 0);
+	SL12_CHECK(desc.Width == 1280);
+
+	// 範囲外のレイ生成レコード
+	table.FillDispatchRaysDesc(kBase, desc, 2);
+	SL12_CHECK(desc.RayGenerationShaderRecord.StartAddress == 0);
+	SL12_CHECK(desc.RayGenerationShaderRecord.SizeInBytes == 0);
+}
+
+//----
+// 同じ書き込み先にはダーティなレコードのみが書き込まれる
+//----
+SL12_TEST(DirtyWritesToPersistentDestination)
+{
+	sl12::ShaderTable table;
+	for (int i = 0; i < 4; i++) table.AddRecord(sl12::ShaderTableKind::HitGroup, 8);
+	table.AddRecord(sl12::ShaderTableKind::Miss, 8);
+	SL12_REQUIRE(table.Build());
+	SL12_CHECK(table.GetDirtyCount() == 5);
+
+	std::vector<sl12::u8> dst(static_cast<size_t>(table.GetSize()), 0xcd);
+	table.WriteAll(dst.data());
+	SL12_CHECK(table.GetDirtyCount() == 0);
+	SL12_CHECK(memcmp(dst.data(), table.GetImage(), dst.size()) == 0);
+	SL12_CHECK(table.WriteDirty(dst.data()) == 0);
+
+	// 同じ内容の設定はダーティにならない
+	ShaderId zero(0);
+	SL12_CHECK(table.SetShaderIdentifier(sl12::ShaderTableKind::HitGroup, 0, zero.bytes));
+	SL12_CHECK(table.GetDirtyCount() == 0);
+
+	ShaderId id(0x3c);
+	table.SetShaderIdentifier(sl12::ShaderTableKind::HitGroup, 1, id.bytes);
+	table.SetShaderIdentifier(sl12::ShaderTableKind::HitGroup, 2, id.bytes);
+	table.SetShaderIdentifier(sl12::ShaderTableKind::Miss, 0, id.bytes);
+	SL12_CHECK(table.GetDirtyCount() == 3);
+	SL12_CHECK(table.IsDirty(sl12::ShaderTableKind::HitGroup, 1));
+	SL12_CHECK(!table.IsDirty(sl12::ShaderTableKind::HitGroup, 3));
+
+	// ダーティでないレコードが書き込まれないことを、書き込み先の目印で確認する
+	sl12::u64 cleanOffset = table.GetRecordOffset(sl12::ShaderTableKind::HitGroup, 3);
+	dst[static_cast<size_t>(cleanOffset)] = 0xee;
+	SL12_CHECK(table.WriteDirty(dst.data()) == 3);
+	SL12_CHECK(table.GetDirtyCount() == 0);
+	SL12_CHECK(dst[static_cast<size_t>(cleanOffset)] == 0xee);
+	dst[static_cast<size_t>(cleanOffset)] = 0;
+	SL12_CHECK(memcmp(dst.data(), table.GetImage(), dst.size()) == 0);
+
+	// MarkAllDirty()後は全レコードが書き込まれる
+	table.MarkAllDirty();
+	SL12_CHECK(table.WriteDirty(dst.data()) == 5);
+}
+
+//----
+// リングバッファから毎フレーム確保した領域にはWriteAll()で全体を書き込む
+//----
+SL12_TEST(RingAllocationsUseWriteAll)
+{
+	sl12::ShaderTable table;
+	table.AddRecord(sl12::ShaderTableKind::RayGeneration, 8);
+	table.AddRecord(sl12::ShaderTableKind::HitGroup, 8);
+	table.AddRecord(sl12::ShaderTableKind::HitGroup, 8);
+	SL12_REQUIRE(table.Build());
+
+	// フレームごとに別の領域が割り当てられ、前回の内容は残っていない
+	std::vector<sl12::u8> ring(static_cast<size_t>(table.GetSize()) * 3);
+	for (sl12::u32 frame = 0; frame < 6; frame++)
+	{
+		sl12::u8* pAlloc = ring.data() + (frame % 3) * table.GetSize();
+		memset(pAlloc, 0xcd, static_cast<size_t>(table.GetSize()));
+
+		ShaderId id(static_cast<sl12::u8>(frame + 1));
+		table.SetShaderIdentifier(sl12::ShaderTableKind::HitGroup, frame % 2, id.bytes);
+		table.WriteAll(pAlloc);
+		SL12_CHECK(memcmp(pAlloc, table.GetImage(), static_cast<size_t>(table.GetSize())) == 0);
+		SL12_CHECK(table.GetDirtyCount() == 0);
+	}
+}
+
+//----
+// CreateBuffer()で生成したバッファはUploadDirty()で更新できる
+//----
+SL12_TEST(UploadDirtyToCreatedBuffer)
+{
+	sl12test::TestDevice td;
+	sl12::ShaderTable table;
+	table.AddRecord(sl12::ShaderTableKind::RayGeneration, 16);
+	table.AddRecord(sl12::ShaderTableKind::Miss, 16);
+	table.AddRecord(sl12::ShaderTableKind::HitGroup, 16);
+	SL12_REQUIRE(table.Build());
+
+	ShaderId id(0x11);
+	table.SetShaderIdentifier(sl12::ShaderTableKind::Miss, 0, id.bytes);
+	sl12::Buffer buffer;
+	SL12_REQUIRE(table.CreateBuffer(&td.GetDevice(), buffer));
+	SL12_CHECK(buffer.GetSize() == table.GetSize());
+	SL12_CHECK(table.GetDirtyCount() == 0);
+
+	auto Matches = [&]()
+	{
+		auto p = buffer.Map(nullptr);
+		bool ret = memcmp(p, table.GetImage(), static_cast<size_t>(table.GetSize())) == 0;
+		buffer.Unmap();
+		return ret;
+	};
+	SL12_CHECK(Matches());
+
+	ShaderId id2(0x22);
+	table.SetShaderIdentifier(sl12::ShaderTableKind::HitGroup, 0, id2.bytes);
+	SL12_CHECK(table.UploadDirty(buffer) == 1);
+	SL12_CHECK(Matches());
+	SL12_CHECK(table.UploadDirty(buffer) == 0);
+
+	buffer.Destroy();
+}
+
+//	EOF
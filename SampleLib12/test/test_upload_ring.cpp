@@ -0,0 +1,412 @@
+﻿#include "test_util.h"
+#include "test_device.h"
+
+#include <sl12/ring_allocator.h>
+#include <sl12/upload_ring.h>
+#include <deque>
+#include <random>
+#include <vector>
+
+
+namespace
+{
+	struct Region
+	{
+		sl12::u64	offset;
+		sl12::u64	size;
+		sl12::u64	fenceValue;		// 0はEndFrame()前
+	};
+
+	bool IsOverlapped(const Region& a, const Region& b)
+	{
+		return a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+	}
+
+	// 偽のGPUからコピー先として参照するバッファ
+	struct DstBuffer
+	{
+		sl12test::FakeResource*		pResource;
+
+		DstBuffer(sl12::u64 size)
+		{
+			D3D12_RESOURCE_DESC desc{};
+			desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+			desc.Width = size;
+			pResource = new sl12test::FakeResource(desc, static_cast<size_t>(size));
+		}
+		~DstBuffer()
+		{
+			pResource->Release();
+		}
+	};
+
+	std::vector<sl12::u8> MakeData(sl12::u32 seed, size_t size)
+	{
+		std::vector<sl12::u8> data(size);
+		for (size_t i = 0; i < size; i++)
+		{
+			data[i] = static_cast<sl12::u8>(seed * 31 + i);
+		}
+		return data;
+	}
+}
+
+//----
+// 確保位置はアラインメントに揃い、サイズ0やリングより大きい確保は失敗する
+//----
+SL12_TEST(RingAllocateAlignment)
+{
+	sl12::RingAllocator ring;
+	ring.Initialize(256);
+
+	SL12_CHECK(ring.Allocate(10) == 0);
+	SL12_CHECK(ring.Allocate(8, 16) == 16);
+	SL12_CHECK(ring.Allocate(1, 64) == 64);
+	SL12_CHECK(ring.GetUsedSize() == 65);
+	SL12_CHECK(ring.GetFrameUsedSize() == 65);
+	SL12_CHECK(ring.Allocate(0) == sl12::RingAllocator::kInvalidOffset);
+	SL12_CHECK(ring.Allocate(257) == sl12::RingAllocator::kInvalidOffset);
+	SL12_CHECK(ring.GetUsedSize() == 65);
+}
+
+//----
+// 終端をまたぐ確保は終端までを詰め物にして先頭から確保する. 詰め物は前のフレームと一緒に解放される
+//----
+SL12_TEST(RingWrap)
+{
+	sl12::RingAllocator ring;
+	ring.Initialize(256);
+
+	SL12_CHECK(ring.Allocate(100) == 0);
+	ring.EndFrame(1);
+	SL12_CHECK(ring.Allocate(100) == 100);
+	ring.EndFrame(2);
+	ring.Reclaim(1);
+	SL12_CHECK(ring.GetUsedSize() == 100);
+
+	// [200, 256)は詰め物になる
+	SL12_CHECK(ring.Allocate(100) == 0);
+	SL12_CHECK(ring.GetUsedSize() == 256);
+	SL12_CHECK(ring.GetFrameUsedSize() == 156);
+	SL12_CHECK(ring.Allocate(1) == sl12::RingAllocator::kInvalidOffset);
+	ring.EndFrame(3);
+
+	ring.Reclaim(2);
+	SL12_CHECK(ring.GetUsedSize() == 156);
+	SL12_CHECK(ring.Allocate(100) == 100);
+	ring.EndFrame(4);
+
+	// 空になった後の確保は詰め物を使用中として扱わない
+	ring.Reclaim(4);
+	SL12_CHECK(ring.GetUsedSize() == 0);
+	SL12_CHECK(ring.Allocate(100) == 0);
+	SL12_CHECK(ring.GetUsedSize() == 100);
+}
+
+//----
+// フェンス値に到達したフレームのみ、古い順に解放される
+//----
+SL12_TEST(RingFenceRetire)
+{
+	sl12::RingAllocator ring;
+	ring.Initialize(1024);
+
+	for (sl12::u64 fence = 1; fence <= 4; fence++)
+	{
+		SL12_CHECK(ring.Allocate(100) != sl12::RingAllocator::kInvalidOffset);
+		ring.EndFrame(fence);
+	}
+	// 確保のないフレームは記録しない
+	ring.EndFrame(5);
+	SL12_CHECK(ring.GetPendingFrameCount() == 4);
+
+	ring.Reclaim(0);
+	SL12_CHECK(ring.GetUsedSize() == 400);
+	ring.Reclaim(1);
+	SL12_CHECK(ring.GetUsedSize() == 300);
+	SL12_CHECK(ring.GetPendingFrameCount() == 3);
+	ring.Reclaim(1);
+	SL12_CHECK(ring.GetUsedSize() == 300);
+
+	// 複数フレームをまとめて解放する
+	ring.Reclaim(3);
+	SL12_CHECK(ring.GetUsedSize() == 100);
+	SL12_CHECK(ring.GetPendingFrameCount() == 1);
+
+	// EndFrame()前の確保は解放されない
+	SL12_CHECK(ring.Allocate(50) != sl12::RingAllocator::kInvalidOffset);
+	ring.Reclaim(100);
+	SL12_CHECK(ring.GetUsedSize() == 50);
+	SL12_CHECK(ring.GetPendingFrameCount() == 0);
+}
+
+//----
+// 満杯のリングはフェンスが進むまで確保に失敗し、進んだ後は確保できる
+//----
+SL12_TEST(RingFullStall)
+{
+	sl12::RingAllocator ring;
+	ring.Initialize(1024);
+
+	sl12::u32 count = 0;
+	while (ring.Allocate(64) != sl12::RingAllocator::kInvalidOffset)
+	{
+		count++;
+	}
+	SL12_CHECK(count == 16);
+	ring.EndFrame(1);
+
+	// GPUが完了するまでは何度試しても失敗する
+	for (int i = 0; i < 4; i++)
+	{
+		ring.Reclaim(0);
+		SL12_CHECK(ring.Allocate(1) == sl12::RingAllocator::kInvalidOffset);
+	}
+	ring.Reclaim(1);
+	SL12_CHECK(ring.GetUsedSize() == 0);
+	SL12_CHECK(ring.Allocate(1024) == 0);
+}
+
+//----
+// GPUが数フレーム遅れる状況で、使用中の領域が重ならないことを乱数で確認する
+//----
+SL12_TEST(RingRandomFrames)
+{
+	static const sl12::u64 kRingSize = 4096;
+	static const sl12::u64 kGpuLag = 2;
+
+	sl12::RingAllocator ring;
+	ring.Initialize(kRingSize);
+	std::mt19937 rng(1);
+	std::deque<Region> live;
+	sl12::u64 completed = 0;
+	sl12::u32 numFailed = 0;
+
+	for (sl12::u64 fence = 1; fence <= 2000; fence++)
+	{
+		sl12::u32 numAllocs = rng() % 8;
+		for (sl12::u32 i = 0; i < numAllocs; i++)
+		{
+			sl12::u64 size = 1 + rng() % 600;
+			sl12::u64 alignment = 1ull << (rng() % 9);
+			sl12::u64 offset = ring.Allocate(size, alignment);
+			if (offset == sl12::RingAllocator::kInvalidOffset)
+			{
+				numFailed++;
+				continue;
+			}
+			Region r{ offset, size, 0 };
+			SL12_CHECK(offset % alignment == 0);
+			SL12_CHECK(offset + size <= kRingSize);
+			for (auto&& other : live)
+			{
+				SL12_CHECK(!IsOverlapped(r, other));
+			}
+			live.push_back(r);
+		}
+		ring.EndFrame(fence);
+		for (auto&& r : live)
+		{
+			if (r.fenceValue == 0) r.fenceValue = fence;
+		}
+
+		// GPUはkGpuLagフレーム遅れて完了する
+		if (fence > kGpuLag)
+		{
+			completed = fence - kGpuLag;
+			ring.Reclaim(completed);
+			while (!live.empty() && live.front().fenceValue <= completed)
+			{
+				live.pop_front();
+			}
+		}
+		sl12::u64 liveSize = 0;
+		for (auto&& r : live) liveSize += r.size;
+		SL12_CHECK(liveSize <= ring.GetUsedSize());
+		SL12_CHECK(ring.GetUsedSize() <= kRingSize);
+	}
+	// 容量が足りない確保も発生している
+	SL12_CHECK(numFailed > 0);
+}
+
+//----
+// コピー元は永続的にマップしたリングから切り出され、GPUの実行時にコピーされる
+//----
+SL12_TEST(UploadCopyToBuffer)
+{
+	sl12test::TestDevice td;
+	sl12test::TestCommandList cmdList(&td.GetDevice().GetGraphicsQueue());
+	sl12::UploadRing ring;
+	SL12_REQUIRE(ring.Initialize(&td.GetDevice(), 4096));
+	SL12_CHECK(ring.GetSize() == 4096);
+
+	DstBuffer dst(256);
+	auto data = MakeData(1, 100);
+	SL12_REQUIRE(ring.CopyToBuffer(&cmdList.Get(), dst.pResource, 16, data.data(), data.size()));
+	SL12_CHECK(cmdList.GetFake().numCopies == 1);
+	SL12_CHECK(ring.GetUsedSize() == 100);
+
+	auto alloc = ring.Allocate(32, 256);
+	SL12_REQUIRE(alloc.IsValid());
+	SL12_CHECK(alloc.offset == 256);
+	SL12_CHECK(alloc.pCpuAddress == static_cast<sl12test::FakeResource*>(alloc.pResource)->mem.data() + 256);
+
+	sl12test::RunGpu();
+	SL12_CHECK(memcmp(dst.pResource->mem.data() + 16, data.data(), data.size()) == 0);
+	SL12_CHECK(ring.GetOverflowCount() == 0);
+}
+
+//----
+// Submit()したフレームはフェンスが到達するまで回収されない
+//----
+SL12_TEST(UploadFenceRetire)
+{
+	sl12test::TestDevice td;
+	auto&& queue = td.GetDevice().GetGraphicsQueue();
+	sl12::UploadRing ring;
+	SL12_REQUIRE(ring.Initialize(&td.GetDevice(), 4096));
+
+	SL12_REQUIRE(ring.Allocate(1024).IsValid());
+	sl12::u32 f1 = ring.Submit(&queue);
+	SL12_REQUIRE(ring.Allocate(1024).IsValid());
+	sl12::u32 f2 = ring.Submit(&queue);
+	SL12_CHECK(f2 == f1 + 1);
+
+	// 確保がなければシグナルせずに最後の値を返す
+	SL12_CHECK(ring.Submit(&queue) == f2);
+
+	ring.Reclaim();
+	SL12_CHECK(ring.GetUsedSize() == 2048);
+
+	sl12test::RunGpu();
+	ring.Reclaim();
+	SL12_CHECK(ring.GetUsedSize() == 0);
+	SL12_CHECK(ring.GetHighWaterMark() == 2048);
+
+	// Submit()前の確保は回収されない
+	SL12_REQUIRE(ring.Allocate(500).IsValid());
+	sl12test::RunGpu();
+	ring.Reclaim();
+	SL12_CHECK(ring.GetUsedSize() == 500);
+	ring.Submit(&queue);
+	ring.WaitIdle();
+	SL12_CHECK(ring.GetUsedSize() == 0);
+}
+
+//----
+// GPUが遅れていても、終端をまたいで再利用した領域が実行前のコピー元を上書きしない.
+// 未完了のフレームがリングに収まらない場合は専用バッファを使用する
+//----
+SL12_TEST(UploadWrapWithLaggingGpu)
+{
+	// リングは未完了の2フレーム分ちょうどの大きさ
+	static const sl12::u64 kCopySize = 192;
+	static const sl12::u32 kCopiesPerFrame = 2;
+	static const sl12::u64 kRingSize = kCopySize * kCopiesPerFrame * 2;
+	static const sl12::u32 kNumFrames = 42;
+
+	// GPUはgpuIntervalフレームに1回まとめて実行する
+	for (sl12::u32 gpuInterval = 2; gpuInterval <= 3; gpuInterval++)
+	{
+		sl12test::TestDevice td;
+		auto&& queue = td.GetDevice().GetGraphicsQueue();
+		sl12test::TestCommandList cmdList(&queue);
+		sl12::UploadRing ring;
+		SL12_REQUIRE(ring.Initialize(&td.GetDevice(), kRingSize));
+
+		DstBuffer dst(kCopySize * kCopiesPerFrame * kNumFrames);
+		bool hasWrapped = false;
+		sl12::u64 lastOffset = 0;
+		for (sl12::u32 frame = 0; frame < kNumFrames; frame++)
+		{
+			ring.Reclaim();
+			for (sl12::u32 i = 0; i < kCopiesPerFrame; i++)
+			{
+				sl12::u32 index = frame * kCopiesPerFrame + i;
+				auto data = MakeData(index, kCopySize);
+				auto alloc = ring.Allocate(kCopySize);
+				SL12_REQUIRE(alloc.IsValid());
+				if (alloc.offset < lastOffset)
+				{
+					hasWrapped = true;
+				}
+				lastOffset = alloc.offset;
+				memcpy(alloc.pCpuAddress, data.data(), kCopySize);
+				cmdList.Get().GetCommandList()->CopyBufferRegion(dst.pResource, index * kCopySize, alloc.pResource, alloc.offset, kCopySize);
+			}
+			ring.Submit(&queue);
+
+			if (frame % gpuInterval == gpuInterval - 1)
+			{
+				sl12test::RunGpu();
+			}
+		}
+		ring.WaitIdle();
+
+		// 3フレームに1回の場合は、3フレーム目がリングに収まらない
+		sl12::u32 expectedOverflow = (gpuInterval == 2) ? 0 : (kNumFrames / 3) * kCopiesPerFrame;
+		SL12_CHECK(hasWrapped);
+		SL12_CHECK(ring.GetOverflowCount() == expectedOverflow);
+		SL12_CHECK(ring.GetHighWaterMark() == kRingSize);
+		for (sl12::u32 index = 0; index < kNumFrames * kCopiesPerFrame; index++)
+		{
+			auto data = MakeData(index, kCopySize);
+			SL12_CHECK(memcmp(dst.pResource->mem.data() + index * kCopySize, data.data(), kCopySize) == 0);
+		}
+	}
+}
+
+//----
+// リングが満杯の場合は専用バッファで処理を続け、フェンス到達後に解放する
+//----
+SL12_TEST(UploadFullRingUsesDedicatedBuffer)
+{
+	sl12test::TestDevice td;
+	auto&& queue = td.GetDevice().GetGraphicsQueue();
+	sl12test::TestCommandList cmdList(&queue);
+	sl12::UploadRing ring;
+	SL12_REQUIRE(ring.Initialize(&td.GetDevice(), 1024));
+	int baseResources = sl12test::GetLiveResourceCount();
+
+	auto first = ring.Allocate(1024);
+	SL12_REQUIRE(first.IsValid());
+	ring.Submit(&queue);
+
+	// GPUが完了していないので、リングは空かない
+	DstBuffer dst(512);
+	auto data = MakeData(7, 512);
+	SL12_REQUIRE(ring.CopyToBuffer(&cmdList.Get(), dst.pResource, 0, data.data(), data.size()));
+	SL12_CHECK(ring.GetOverflowCount() == 1);
+	SL12_CHECK(ring.GetUsedSize() == 1024);
+	SL12_CHECK(sl12test::GetLiveResourceCount() == baseResources + 2);
+
+	// リングより大きい確保も専用バッファになる
+	auto large = ring.Allocate(4096);
+	SL12_REQUIRE(large.IsValid());
+	SL12_CHECK(large.pResource != first.pResource && large.offset == 0);
+	SL12_CHECK(ring.GetOverflowCount() == 2);
+
+	// 専用バッファはSubmit()前には解放されない
+	sl12test::RunGpu();
+	ring.Reclaim();
+	SL12_CHECK(ring.GetUsedSize() == 0);
+	SL12_CHECK(sl12test::GetLiveResourceCount() == baseResources + 3);
+	SL12_CHECK(memcmp(dst.pResource->mem.data(), data.data(), data.size()) == 0);
+
+	ring.Submit(&queue);
+	ring.Reclaim();
+	SL12_CHECK(sl12test::GetLiveResourceCount() == baseResources + 3);
+	sl12test::RunGpu();
+	ring.Reclaim();
+	SL12_CHECK(sl12test::GetLiveResourceCount() == baseResources + 1);
+
+	// 回収後はリングに戻る
+	SL12_CHECK(ring.Allocate(1024).pResource == first.pResource);
+	SL12_CHECK(ring.GetOverflowCount() == 2);
+
+	// 作成に失敗した場合は無効な領域を返す
+	td.GetFake().failNextResource = 1;
+	SL12_CHECK(!ring.Allocate(16).IsValid());
+}
+
+//	EOF
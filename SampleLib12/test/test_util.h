@@ -0,0 +1,124 @@
+﻿#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+namespace sl12test
+{
+	/*************************************************//**
+	 * @brief テストケース
+	 *
+	 * SL12_TESTで定義したケースは静的初期化時に登録され、RunAllTests()で順に実行される.
+	*****************************************************/
+	struct TestCase
+	{
+		const char*		name;
+		void			(*func)();
+	};	// struct TestCase
+
+	inline std::vector<TestCase>& GetTestCases()
+	{
+		static std::vector<TestCase> s_cases;
+		return s_cases;
+	}
+
+	inline std::atomic<int>& GetFailCount()
+	{
+		static std::atomic<int> s_count(0);
+		return s_count;
+	}
+
+	struct TestRegistrar
+	{
+		TestRegistrar(const char* name, void (*func)())
+		{
+			GetTestCases().push_back({ name, func });
+		}
+	};	// struct TestRegistrar
+
+	inline void ReportFailure(const char* file, int line, const char* expr)
+	{
+		fprintf(stderr, "%s(%d): check failed: %s\n", file, line, expr);
+		GetFailCount()++;
+	}
+
+	/**
+	 * @brief 登録されたテストを実行する
+	 *
+	 * 引数にケース名を指定した場合は、そのケースのみを実行する.
+	 * @return 失敗したチェックがあれば1
+	*/
+	inline int RunAllTests(int argc, char* argv[])
+	{
+		int numRun = 0;
+		for (auto&& tc : GetTestCases())
+		{
+			if (argc > 1 && strcmp(argv[1], tc.name) != 0)
+			{
+				continue;
+			}
+			int before = GetFailCount();
+			tc.func();
+			printf("[%s] %s\n", (GetFailCount() == before) ? "  OK  " : " FAIL ", tc.name);
+			numRun++;
+		}
+		printf("%d cases, %d failures\n", numRun, GetFailCount().load());
+		return (GetFailCount() == 0 && numRun > 0) ? 0 : 1;
+	}
+
+	/**
+	 * @brief 一時ファイルのパスを取得する
+	 *
+	 * テストはソースディレクトリで実行されるので、書き出すファイルはTMPDIR(未設定の場合は/tmp)に置く.
+	*/
+	inline std::string GetTempFilePath(const char* name)
+	{
+		const char* dir = getenv("TMPDIR");
+		return std::string((dir && *dir) ? dir : "/tmp") + "/sl12test_" + name;
+	}
+
+	/*************************************************//**
+	 * @brief ベンチマーク用の計測タイマー
+	*****************************************************/
+	class Timer
+	{
+	public:
+		Timer()
+			: start_(std::chrono::steady_clock::now())
+		{}
+
+		void Reset()
+		{
+			start_ = std::chrono::steady_clock::now();
+		}
+
+		double GetMilliseconds() const
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+		}
+
+	private:
+		std::chrono::steady_clock::time_point	start_;
+	};	// class Timer
+
+}	// namespace sl12test
+
+#define SL12_TEST(name) \
+	static void name(); \
+	static sl12test::TestRegistrar name##_registrar(#name, name); \
+	static void name()
+
+#define SL12_CHECK(expr) \
+	do { if (!(expr)) { sl12test::ReportFailure(__FILE__, __LINE__, #expr); } } while (0)
+
+// 失敗した場合はケースを中断する
+#define SL12_REQUIRE(expr) \
+	do { if (!(expr)) { sl12test::ReportFailure(__FILE__, __LINE__, #expr); return; } } while (0)
+
+//	EOF